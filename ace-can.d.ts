@@ -10,8 +10,9 @@
 /**
  * @class CANBus
  * @param {number} channel
- * @param {string} bustype - 'busmust' | 'pcan'
+ * @param {string} bustype - 'busmust' | 'pcan' | 'udp' | 'tcp'
  * @param {number} bitrate
+ * @param {Object} [options] - 'udp' / 'tcp' only: { port, host = '0.0.0.0' }; channel is the tunnel channel (0-255)
  * @example
  *   const { CANBus } = require('ace-can');
  *   const can = new CANBus(0, 'busmust', 500000);
@@ -35,9 +36,316 @@
  * @returns {void}
  */
 
+/**
+ * @method setLogging
+ * @param {Object} options - on-device logging (busmust) or driver trace (pcan) configuration
+ * @returns {void}
+ */
+
+/**
+ * @method getLogging
+ * @returns {Object}
+ */
+
+/**
+ * @method startWatcher
+ * @param {Object} [options] - { intervalMs = 100, autoReattach = true }; emits 'detach' / 'attach'
+ * @returns {void}
+ */
+
+/**
+ * @method stopWatcher
+ * @returns {void}
+ */
+
+/**
+ * @method sendAt
+ * @param {Object} message - { id, data }
+ * @param {number} timestamp - microseconds on the device clock, or the host clock with { clock: 'host' }
+ * @param {Object} [options] - { clock: 'device' | 'host' }
+ * @returns {Promise<Object>} { scheduled, achieved, lateUs }
+ */
+
+/**
+ * @method now
+ * @param {string} [clock] - 'host' (default) or 'device'
+ * @returns {number} microseconds
+ */
+
+/**
+ * @method readInto
+ * @param {ArrayBuffer|ArrayBufferView} buffer - receives 80-byte frame records; must be 8-byte aligned
+ * @param {number} [maxFrames]
+ * @param {number} [timeoutMs] - wait for the first frame (0 = do not wait)
+ * @returns {number} records written
+ */
+
+/**
+ * @method setFilters
+ * @param {Array|string|null} filters - [{ id, mask = 0x1FFFFFFF, extended }], or a filter expression
+ *   such as 'id in 0x100..0x1FF && data[2] & 0x08'; null passes every frame
+ * @returns {void}
+ */
+
+/**
+ * @method setReceiveMode
+ * @param {string} mode - 'thread' (default) or 'poll' (PCAN on Linux; reads on the JS thread)
+ * @returns {void}
+ */
+
+/**
+ * @method tunnelStats
+ * @returns {Object} { packets, frames, lost, late, dropped, sent, connected }; 'udp' / 'tcp' buses only
+ */
+
+/**
+ * @method setTxShaping
+ * @param {Object|null} options - { busLoad, bitsPerSecond, burstBits, classes: [{ id, mask, bitsPerSecond }] };
+ *   applies to send() and to native senders on the bus, but not to sendAt() or LatencyProbe; the PCAN
+ *   hardware interframe gap (at most 1023 us) spaces every frame
+ * @returns {void}
+ */
+
+/**
+ * @class LogReader
+ * @param {string} path - .asc, .log (candump), .trc or .pcap file
+ * @param {string} [format] - 'asc' | 'log' | 'trc' | 'pcap'
+ */
+
+/**
+ * @method read
+ * @param {number} [maxFrames]
+ * @returns {Buffer|null} frame batch, or null at end of file
+ */
+
 /**
  * @static
  * @method isAvailable
  * @param {string} bustype
  * @returns {boolean}
  */
+
+/**
+ * @class LatencyProbe
+ * @param {CANBus} txBus - bus the requests are sent on
+ * @param {CANBus} rxBus - bus the responses are received on (may be txBus)
+ * @param {Object} options - { requestId, responseId, rateHz = 100, count = 1000, timeoutMs = 1000, payloadLength = 8 }
+ */
+
+/**
+ * @method run
+ * @returns {Promise<Object>} { sent, received, lost, errors, components: { tx, driver, addon, js, total } }
+ */
+
+/**
+ * @class RedundantBus
+ * @param {CANBus} primary
+ * @param {CANBus} secondary - second adapter on the same physical bus
+ * @param {Object} [options] - { dedupWindowUs = 2000, failoverMs = 10 }; emits 'message' and 'failover'
+ */
+
+/**
+ * @class IsoTp
+ * @param {CANBus} bus
+ * @param {Object} [options] - { blockSize = 0, stMin = 0, padding = 0xCC, timeoutMs = 1000 }
+ */
+
+/**
+ * @method request
+ * @param {number} txId
+ * @param {number} rxId
+ * @param {Buffer} data - 1 to 4095 bytes
+ * @param {Object} [options] - { timeoutMs }
+ * @returns {Promise<Buffer>} reassembled response
+ */
+
+/**
+ * @class DiagnosticRunner
+ * @param {CANBus} bus
+ * @param {Object} [options] - IsoTp options plus { p2Ms = 50, p2StarMs = 5000, concurrency = 0 (all) }
+ */
+
+/**
+ * @method run
+ * @param {Array} ecus - [{ name, txId, rxId, p2Ms, p2StarMs, requests }]
+ * @param {Buffer[]} [requests] - UDS requests for ECUs without their own
+ * @param {Object} [options] - { stopOnError = true, concurrency }
+ * @returns {Promise<Array>} per ECU { name, txId, rxId, ok, elapsedMs, responses: [{ data, nrc, error, pending, elapsedMs }] }
+ */
+
+/**
+ * @class Flasher
+ * @param {Object} [options] - IsoTp options plus { p2Ms = 50, p2StarMs = 5000, maxBlockLength = 4095, progressIntervalMs = 250 }; emits 'progress'
+ */
+
+/**
+ * @method flash
+ * @param {Array} targets - [{ name, bus, txId, rxId, image, address = 0, offset = 0, length, dataFormat = 0, prepare, finish }]
+ * @returns {Promise<Array>} per target { name, txId, rxId, ok, error, step, bytes, elapsedMs }
+ */
+
+/**
+ * @class DiagnosticScanner
+ * @param {CANBus} bus
+ * @param {Object} [options] - { ranges = [{ from: 0, to: 0x7FF }], probe = <3E 00>, padding = 0xCC, busLoad = 0.3, intervalMs, responseWindowMs = 50, listenMs = 200 }
+ */
+
+/**
+ * @method scan
+ * @returns {Promise<Object>} { pairs: [{ txId, rxId, extended, rxExtended, response }], probes, responses, unconfirmed, sendErrors, elapsedMs }
+ */
+
+/**
+ * @class CanTunnel
+ * @param {CANBus} bus - frames it receives are forwarded; frames coming back are transmitted on it
+ * @param {Object} options - { host, port, protocol = 'udp', channel = 0, batchUs = 1000, maxPacketBytes = 1400 }
+ */
+
+/**
+ * @method stats
+ * @returns {Object} { framesSent, packetsSent, bytesSent, dropped, sendErrors, packetsReceived, framesReceived, lost, late, transmitErrors, connected }
+ */
+
+/**
+ * @class FrameStreamServer
+ * @param {CANBus} bus - receive batches are streamed to WebSocket clients as binary messages
+ * @param {Object} [options] - { port = 0, host = '127.0.0.1', maxQueuedBytes = 1 MiB, maxClients = 64 }
+ */
+
+/**
+ * @method port
+ * @returns {number} listening port
+ */
+
+/**
+ * @method stats
+ * @returns {Object} { clients, batches, frames, messages, bytes, queuedBytes, droppedClients, rejected }
+ */
+
+/**
+ * @function decodeStreamMessage
+ * @param {ArrayBuffer|Uint8Array} message - binary FrameStreamServer message
+ * @returns {Array} frames { id, data, timestamp, flags, channel }
+ */
+
+/**
+ * @class DoipGateway
+ * @param {Array} routes - [{ address, bus, txId, rxId, blockSize?, stMin?, padding?, timeoutMs?, p2Ms?, p2StarMs? }]
+ * @param {Object} [options] - { port = 13400, host = '0.0.0.0', logicalAddress = 0x1000, maxTesters = 8, testers, plus route defaults }
+ */
+
+/**
+ * @method port
+ * @returns {number} listening port
+ */
+
+/**
+ * @method stats
+ * @returns {Object} { testers, activeTesters, activations, requests, queued, responses, unanswered, nacks, transportErrors, rejected }
+ */
+
+/**
+ * @class SignalDatabase
+ * @param {string} path - .dbc or .arxml file
+ * @param {string} [format] - 'dbc' | 'arxml'; defaults to the file extension
+ * @param {Object} [options] - { cache }: compiled cache file, used while the source content hash matches
+ */
+
+/**
+ * @method decode
+ * @param {Object} message - { id, data, flags? }
+ * @returns {Object|null} { name, signals: { [name]: value } }, or null for unknown IDs
+ */
+
+/**
+ * @method generateDecoder
+ * @returns {string} C++ source of a decoder plugin (src/ace_can_decoder.h) for the database
+ */
+
+/**
+ * @class SignalDecoder
+ * @param {SignalDatabase|string} source - database, or path of a compiled decoder plugin
+ * @param {CANBus} [bus] - decode its frames on the receive thread
+ */
+
+/**
+ * @method latest
+ * @returns {Object} { "Message.Signal": value } for signals received so far
+ */
+
+/**
+ * @method measure
+ * @param {Buffer} batch - frame batch
+ * @param {number} [rounds]
+ * @returns {Object} { frames, signals, nsPerFrame }
+ */
+
+/**
+ * @class BatchEncoder
+ * @param {string} [format] - 'msgpack' (default) | 'cbor'
+ * @param {SignalDecoder} [decoder] - required for encodeSignals
+ */
+
+/**
+ * @method encodeFrames
+ * @param {ArrayBuffer|ArrayBufferView} batch - frame records
+ * @param {number} [count] - records to encode; defaults to all
+ * @returns {Buffer} array of { timestamp, id, flags, channel, data }
+ */
+
+/**
+ * @method encodeSignals
+ * @param {ArrayBuffer|ArrayBufferView} batch - frame records
+ * @param {number} [count]
+ * @returns {Buffer} array of { timestamp, id, name, signals: { [signal]: value } } for frames in the database
+ */
+
+/**
+ * @class SignalHistory
+ * @param {SignalDecoder} decoder - records the values it decodes from its bus
+ * @param {Object} [options] - { signals = all, durationMs = 600000, maxSamples = 1048576 }
+ */
+
+/**
+ * @method query
+ * @param {string} signal - "Message.Signal"
+ * @param {Object} [options] - { from, to, points = 1000, method = 'lttb' | 'minmax' }
+ * @returns {Object} { timestamps: Float64Array, values: Float64Array }
+ */
+
+/**
+ * @method stats
+ * @returns {Object} { signals, samples, appended, bytes }
+ */
+
+/**
+ * @class ReceivePlugin
+ * @param {CANBus} bus
+ * @param {string} path - shared library implementing src/ace_can_stage.h
+ * @param {string} [config] - passed to the plugin's create()
+ */
+
+/**
+ * @method on
+ * @param {'result'} event
+ * @param {Function} callback - receives { tag, data }
+ * @returns {ReceivePlugin}
+ */
+
+/**
+ * @class Nmea2000Receiver
+ * @param {CANBus} bus
+ * @param {Object} [options] - { timeoutMs = 750, fastPacketPgns, pgns }
+ */
+
+/**
+ * @method on
+ * @param {'pgn'} event
+ * @param {Function} callback - receives { pgn, source, destination, priority, timestamp, data }
+ * @returns {Nmea2000Receiver}
+ */
+
+/**
+ * @method stats
+ * @returns {Object} { frames, pgns, fastPackets, timeouts, errors, inFlight, dropped }
+ */
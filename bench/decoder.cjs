@@ -0,0 +1,84 @@
+// Compares the generic table-driven decoder with a compiled decoder plugin on the same frames.
+//
+//   node bench/decoder.cjs <database.dbc|.arxml> [log file] [rounds]
+//
+// Generates the plugin source with SignalDatabase.generateDecoder(), builds it with $CXX (default
+// c++), checks that both decoders agree, then times them with SignalDecoder.measure(). Without a
+// log file, every message in the database is decoded with random payloads.
+'use strict';
+
+const { execFileSync } = require('child_process');
+const crypto = require('crypto');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { SignalDatabase, SignalDecoder, LogReader, FRAME_RECORD_SIZE, FrameFlags } = require('..');
+
+function syntheticBatch(messages, count) {
+  const batch = Buffer.alloc(count * FRAME_RECORD_SIZE);
+  for (let i = 0; i < count; i++) {
+    const message = messages[i % messages.length];
+    const offset = i * FRAME_RECORD_SIZE;
+    batch.writeUInt32LE(message.id, offset + 8);
+    batch.writeUInt8((message.extended ? FrameFlags.EXTENDED : 0) | (message.fd ? FrameFlags.FD : 0), offset + 12);
+    batch.writeUInt8(message.length, offset + 13);
+    crypto.randomFillSync(batch, offset + 16, message.length);
+  }
+  return batch;
+}
+
+function logBatch(file) {
+  const batches = [];
+  for (const batch of new LogReader(file)) {
+    batches.push(batch);
+  }
+  return Buffer.concat(batches);
+}
+
+function main() {
+  const [source, log, roundsArg] = process.argv.slice(2);
+  if (!source) {
+    console.error('usage: node bench/decoder.cjs <database> [log file] [rounds]');
+    process.exit(2);
+  }
+  const rounds = Number(roundsArg ?? 100);
+  const db = new SignalDatabase(source);
+  const messages = db.messages().filter((message) => message.signals.length > 0);
+  const batch = log ? logBatch(log) : syntheticBatch(messages, 4096);
+
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'ace-can-decoder-'));
+  const cpp = path.join(dir, 'decoder.cpp');
+  const plugin = path.join(dir, process.platform === 'win32' ? 'decoder.dll' : 'decoder.so');
+  fs.writeFileSync(cpp, db.generateDecoder());
+  const started = Date.now();
+  execFileSync(process.env.CXX || 'c++',
+    ['-O2', '-std=c++17', '-shared', '-fPIC', '-I', path.join(__dirname, '..', 'src'), '-o', plugin, cpp],
+    { stdio: 'inherit' });
+  console.log(`built ${path.basename(plugin)} for ${messages.length} messages in ${Date.now() - started} ms`);
+
+  const generic = new SignalDecoder(db);
+  const compiled = new SignalDecoder(plugin);
+  for (let offset = 0; offset < batch.length; offset += FRAME_RECORD_SIZE) {
+    const frame = {
+      id: batch.readUInt32LE(offset + 8),
+      flags: batch.readUInt8(offset + 12),
+      data: batch.subarray(offset + 16, offset + 16 + batch.readUInt8(offset + 13)),
+    };
+    const expected = JSON.stringify(generic.decode(frame));
+    const actual = JSON.stringify(compiled.decode(frame));
+    if (expected !== actual) {
+      throw new Error(`decoders disagree on 0x${frame.id.toString(16)}: ${expected} vs ${actual}`);
+    }
+  }
+
+  const frames = batch.length / FRAME_RECORD_SIZE;
+  const results = { generic: generic.measure(batch, rounds), compiled: compiled.measure(batch, rounds) };
+  for (const [name, result] of Object.entries(results)) {
+    console.log(`${name.padEnd(9)} ${result.nsPerFrame.toFixed(1).padStart(8)} ns/frame  ` +
+      `${(result.signals / result.frames).toFixed(1)} signals/frame  (${frames} frames x ${rounds})`);
+  }
+  console.log(`speedup   ${(results.generic.nsPerFrame / results.compiled.nsPerFrame).toFixed(1)}x`);
+  fs.rmSync(dir, { recursive: true, force: true });
+}
+
+main();
@@ -2,7 +2,7 @@
   "targets": [
     {
       "target_name": "ace_can",
-      "sources": [ "src/ace_can.cpp" ],
+      "sources": [ "src/ace_can.cpp", "src/device_watcher.cpp", "src/receive_poller.cpp", "src/log_reader.cpp", "src/log_file.cpp", "src/latency_probe.cpp", "src/redundant_bus.cpp", "src/frame_dedup.cpp", "src/session_scheduler.cpp", "src/isotp.cpp", "src/isotp_session.cpp", "src/decode_tables.cpp", "src/arxml_import.cpp", "src/signal_database.cpp", "src/compiled_db.cpp", "src/mapped_file.cpp", "src/decoder_codegen.cpp", "src/shared_library.cpp", "src/signal_decoder.cpp", "src/stage_plugin.cpp", "src/receive_plugin.cpp", "src/filter_program.cpp", "src/fast_packet.cpp", "src/nmea2000_receiver.cpp", "src/uds_session.cpp", "src/uds.cpp", "src/diagnostic_runner.cpp", "src/flash_session.cpp", "src/flasher.cpp", "src/id_scanner.cpp", "src/diagnostic_scanner.cpp", "src/tunnel.cpp", "src/can_tunnel.cpp", "src/websocket.cpp", "src/frame_stream_server.cpp", "src/doip.cpp", "src/doip_gateway.cpp", "src/batch_encoder.cpp", "src/downsample.cpp", "src/signal_history.cpp" ],
       "include_dirs": [
         "<!@(node -p \"require('node-addon-api').include\")",
         "deps/busmust/include",
@@ -13,18 +13,20 @@
         "<(module_root_dir)/deps/pcan/lib/x64/PCANBasic.lib"
       ],
       "cflags!": [ "-fno-exceptions" ],
-      "cflags_cc!": [ "-fno-exceptions" ],
+      "cflags_cc!": [ "-fno-exceptions", "-std=gnu++17" ],
+      "cflags_cc": [ "-std=gnu++20" ],
       "defines": [ "NAPI_DISABLE_CPP_EXCEPTIONS" ],
       "dependencies": [ "<!(node -p \"require('node-addon-api').gyp\")" ],
       "conditions": [
         ['OS=="win"',
           {
             'msvs_settings': {
-              'VCCLCompilerTool': { 'ExceptionHandling': 1 },
+              'VCCLCompilerTool': { 'ExceptionHandling': 1, 'AdditionalOptions': [ '/std:c++20' ] },
               'VCLinkerTool':{
                 'DelayLoadDLLs':['BMAPI64.dll','PCANBasic.dll']
               }
-            }
+            },
+            'libraries': [ 'ws2_32.lib' ]
           }
         ]
       ]
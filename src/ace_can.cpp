@@ -1,14 +1,19 @@
 #include "ace_can.h"
 #include <napi.h>
+#include <uv.h>
 
 #include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cctype>
+#include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <cerrno>
+#include <condition_variable>
 #include <iomanip>
+#include <mutex>
+#include <shared_mutex>
 #include <sstream>
 #include <thread>
 #include <vector>
@@ -47,12 +52,43 @@ using LPSTR = char*;
 #endif
 
 #include "PCANBasic.h"
+#include "diagnostic_runner.h"
+#include "diagnostic_scanner.h"
+#include "flasher.h"
+#include "isotp.h"
+#include "latency_probe.h"
+#include "log_reader.h"
+#include "napi_options.h"
+#include "nmea2000_receiver.h"
+#include "receive_plugin.h"
+#include "redundant_bus.h"
+#include "signal_database.h"
+#include "signal_decoder.h"
+#include "can_tunnel.h"
+#include "frame_stream_server.h"
+#include "doip_gateway.h"
+#include "batch_encoder.h"
+#include "signal_history.h"
 
 namespace {
 
 constexpr uint16_t kBusmustLanguageEnglish = 0x09;
 constexpr WORD kPcanLanguageEnglish = 0x09;
 
+constexpr size_t kReceiveBatchSize = 256;
+constexpr size_t kPcanPathLength = 260;
+constexpr DWORD kPcanTraceSizeUnit = 1024 * 1024;
+constexpr DWORD kPcanTraceMaxSizeMb = 100;
+constexpr uint32_t kWatcherDefaultIntervalMs = 100;
+constexpr uint32_t kWatcherMinIntervalMs = 10;
+constexpr size_t kTxQueueCapacity = 4096;
+constexpr uint32_t kPcanMaxInterframeDelayUs = 1023; // PCAN_INTERFRAME_DELAY range
+#ifdef _WIN32
+constexpr int64_t kTimedSpinWindowUs = 2000; // default timer resolution is far coarser than on POSIX
+#else
+constexpr int64_t kTimedSpinWindowUs = 200;
+#endif
+
 std::atomic<int> g_busmust_instance_count{0};
 
 TPCANBaudrate MapPcanBaudrate(int bitrate) {
@@ -111,6 +147,57 @@ bool BusmustSupportsCan(const BM_ChannelInfoTypeDef& info) {
     return (info.cap & (BM_CAN_CAP | BM_CAN_FD_CAP)) != 0;
 }
 
+std::string EnumerateBusmustChannels(std::vector<BM_ChannelInfoTypeDef>& channels) {
+    int capacity = 16;
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        channels.assign(capacity, {});
+        int enumerated = capacity;
+        BM_StatusTypeDef status = BM_Enumerate(channels.data(), &enumerated);
+        if (status != BM_ERROR_OK) {
+            channels.clear();
+            return "BM_Enumerate failed: " + BusmustStatusToString(status);
+        }
+        if (enumerated <= capacity) {
+            channels.resize(enumerated);
+            return std::string();
+        }
+        capacity *= 2;
+    }
+    channels.clear();
+    return "BM_Enumerate ran out of buffer space";
+}
+
+std::string BusmustSerialToString(const BM_ChannelInfoTypeDef& info) {
+    size_t length = 0;
+    bool printable = true;
+    while (length < sizeof(info.sn) && info.sn[length] != 0) {
+        printable = printable && std::isprint(info.sn[length]);
+        ++length;
+    }
+    if (printable && length > 0) {
+        return std::string(reinterpret_cast<const char*>(info.sn), length);
+    }
+    std::ostringstream oss;
+    oss << std::hex << std::uppercase << std::setfill('0');
+    for (uint8_t byte : info.sn) {
+        oss << std::setw(2) << static_cast<int>(byte);
+    }
+    return oss.str();
+}
+
+std::vector<TPCANChannelInformation> GetAttachedPcanChannels() {
+    DWORD count = 0;
+    if (CAN_GetValue(PCAN_NONEBUS, PCAN_ATTACHED_CHANNELS_COUNT, &count, static_cast<DWORD>(sizeof(count))) != PCAN_ERROR_OK || count == 0) {
+        return {};
+    }
+    std::vector<TPCANChannelInformation> channels(count);
+    DWORD nbytes = static_cast<DWORD>(channels.size() * sizeof(TPCANChannelInformation));
+    if (CAN_GetValue(PCAN_NONEBUS, PCAN_ATTACHED_CHANNELS, channels.data(), nbytes) != PCAN_ERROR_OK) {
+        return {};
+    }
+    return channels;
+}
+
 std::string PcanStatusToString(TPCANStatus status) {
     char buffer[256] = {0};
     if (CAN_GetErrorText(status, kPcanLanguageEnglish, buffer) == PCAN_ERROR_OK) {
@@ -121,19 +208,299 @@ std::string PcanStatusToString(TPCANStatus status) {
     return oss.str();
 }
 
+
+uint64_t PcanTimestampToMicros(const TPCANTimestamp& ts) {
+    return static_cast<uint64_t>(ts.micros) + 1000ULL * ts.millis + 0x100000000ULL * 1000ULL * ts.millis_overflow;
+}
+
+void BusmustMessageToFrame(const BM_CanMessageTypeDef& msg, uint32_t channel, uint64_t timestamp, CanFrame& frame) {
+    bool extended = msg.ctrl.rx.IDE != 0;
+    bool fd = msg.ctrl.rx.FDF != 0;
+    frame.timestamp = timestamp;
+    frame.id = extended ? BM_GET_EXT_MSG_ID(msg.id) : BM_GET_STD_MSG_ID(msg.id);
+    frame.flags = 0;
+    if (extended) frame.flags |= kFrameFlagExtended;
+    if (msg.ctrl.rx.RTR) frame.flags |= kFrameFlagRemote;
+    if (fd) frame.flags |= kFrameFlagFd;
+    if (msg.ctrl.rx.BRS) frame.flags |= kFrameFlagBrs;
+    if (msg.ctrl.rx.ESI) frame.flags |= kFrameFlagEsi;
+    frame.length = fd ? CanFdDlcToLength(static_cast<uint8_t>(msg.ctrl.rx.DLC))
+                      : static_cast<uint8_t>(std::min<uint32_t>(msg.ctrl.rx.DLC, 8));
+    frame.channel = static_cast<uint16_t>(channel);
+    std::memcpy(frame.data, msg.payload, frame.length);
+}
+
+void PcanMessageToFrame(const TPCANMsg& msg, uint64_t timestamp, CanFrame& frame) {
+    bool extended = (msg.MSGTYPE & PCAN_MESSAGE_EXTENDED) != 0;
+    frame.timestamp = timestamp;
+    frame.id = extended ? msg.ID : (msg.ID & 0x7FF);
+    frame.flags = 0;
+    if (extended) frame.flags |= kFrameFlagExtended;
+    if (msg.MSGTYPE & PCAN_MESSAGE_RTR) frame.flags |= kFrameFlagRemote;
+    frame.length = static_cast<uint8_t>(std::min<size_t>(msg.LEN, 8));
+    frame.channel = 0;
+    std::memcpy(frame.data, msg.DATA, frame.length);
+}
+
+// Message ids in Busmust filters/triggers use the BM_MessageIdTypeDef bit layout.
+uint32_t PackBusmustId(uint32_t id, bool extended) {
+    if (!extended) {
+        return id & 0x7FFu;
+    }
+    return ((id >> 18) & 0x7FFu) | ((id & 0x3FFFFu) << 11);
+}
+
+uint32_t UnpackBusmustId(uint32_t packed) {
+    return ((packed & 0x7FFu) << 18) | ((packed >> 11) & 0x3FFFFu);
+}
+
+struct NamedValue {
+    const char* name;
+    uint8_t value;
+};
+
+const NamedValue kStorageModes[] = {
+    {"disabled", BM_STORAGE_DISABLED},
+    {"always", BM_STORAGE_ALWAYS_ON},
+    {"triggered", BM_STORAGE_TRIGGERED},
+};
+
+const NamedValue kStorageFormats[] = {
+    {"bbd", BM_STORAGE_BBD_FORMAT},
+    {"pcap", BM_STORAGE_PCAP_FORMAT},
+    {"log", BM_STORAGE_LOG_FORMAT},
+    {"asc", BM_STORAGE_ASC_FORMAT},
+    {"blf", BM_STORAGE_BLF_FORMAT},
+};
+
+const NamedValue kStorageDirections[] = {
+    {"none", BM_STORAGE_DIRECTION_NONE},
+    {"rx", BM_STORAGE_DIRECTION_RX},
+    {"tx", BM_STORAGE_DIRECTION_TX},
+    {"all", BM_STORAGE_DIRECTION_ALL},
+};
+
+const NamedValue kStoragePathModes[] = {
+    {"fixed", BM_STORAGE_FIXED_PATH},
+    {"index", BM_STORAGE_INDEX_PATH},
+    {"time", BM_STORAGE_TIME_PATH},
+};
+
+template <size_t N>
+bool LookupNamedValue(const NamedValue (&table)[N], const std::string& name, uint8_t& out) {
+    for (const NamedValue& entry : table) {
+        if (name == entry.name) {
+            out = entry.value;
+            return true;
+        }
+    }
+    return false;
+}
+
+template <size_t N>
+const char* NameOfValue(const NamedValue (&table)[N], uint8_t value) {
+    for (const NamedValue& entry : table) {
+        if (entry.value == value) {
+            return entry.name;
+        }
+    }
+    return "unknown";
+}
+
+bool ParseBusmustTrigger(const Napi::Object& options, const char* key, uint16_t defaultChannels, BM_EventTriggerTypeDef& out) {
+    std::memset(&out, 0, sizeof(out));
+    if (!options.Has(key) || options.Get(key).IsUndefined()) {
+        return true;
+    }
+    if (!options.Get(key).IsObject()) {
+        return false;
+    }
+    Napi::Object trigger = options.Get(key).As<Napi::Object>();
+    uint32_t id = 0;
+    uint32_t mask = 0xFFFFFFFFu;
+    uint32_t channels = defaultChannels;
+    bool extended = false;
+    if (!GetOptionalUint32(trigger, "id", id) || !GetOptionalUint32(trigger, "mask", mask) ||
+        !GetOptionalUint32(trigger, "channels", channels) || !GetOptionalBool(trigger, "extended", extended)) {
+        return false;
+    }
+    extended = extended || id > 0x7FF;
+    out.channels = static_cast<uint16_t>(channels);
+    out.id_value = PackBusmustId(id, extended);
+    out.id_mask = PackBusmustId(mask, extended);
+    return true;
+}
+
+Napi::Object BusmustTriggerToJs(Napi::Env env, const BM_EventTriggerTypeDef& trigger) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("channels", Napi::Number::New(env, trigger.channels));
+    obj.Set("id", Napi::Number::New(env, UnpackBusmustId(trigger.id_value)));
+    obj.Set("mask", Napi::Number::New(env, UnpackBusmustId(trigger.id_mask)));
+    return obj;
+}
+
 } // namespace
 
+std::string JsToFrame(const Napi::Value& value, size_t maxLength, CanFrame& frame) {
+    if (!value.IsObject()) {
+        return "Expected message object";
+    }
+    Napi::Object msgObj = value.As<Napi::Object>();
+    if (!msgObj.Has("id") || !msgObj.Get("id").IsNumber()) {
+        return "Message.id must be a number";
+    }
+    if (!msgObj.Has("data") || !msgObj.Get("data").IsBuffer()) {
+        return "Message.data must be a Buffer";
+    }
+
+    uint32_t id = msgObj.Get("id").As<Napi::Number>().Uint32Value();
+    Napi::Buffer<uint8_t> dataBuf = msgObj.Get("data").As<Napi::Buffer<uint8_t>>();
+    frame.id = id;
+    frame.flags = (id > 0x7FF) ? kFrameFlagExtended : 0;
+    frame.length = static_cast<uint8_t>(std::min<size_t>(dataBuf.Length(), maxLength));
+    std::memcpy(frame.data, dataBuf.Data(), frame.length);
+    return std::string();
+}
+
+Napi::Object FrameToJs(Napi::Env env, const CanFrame& frame) {
+    Napi::Object jsMsg = Napi::Object::New(env);
+    jsMsg.Set("id", Napi::Number::New(env, frame.id));
+    jsMsg.Set("data", Napi::Buffer<uint8_t>::Copy(env, frame.data, frame.length));
+    jsMsg.Set("timestamp", Napi::Number::New(env, static_cast<double>(frame.timestamp)));
+    return jsMsg;
+}
+
 Napi::Object CANBus::Init(Napi::Env env, Napi::Object exports) {
     Napi::Function func = DefineClass(env, "CANBus", {
         InstanceMethod("send", &CANBus::Send),
         InstanceMethod("on", &CANBus::On),
         InstanceMethod("close", &CANBus::Close),
+        InstanceMethod("setLogging", &CANBus::SetLogging),
+        InstanceMethod("getLogging", &CANBus::GetLogging),
+        InstanceMethod("startWatcher", &CANBus::StartWatcher),
+        InstanceMethod("stopWatcher", &CANBus::StopWatcher),
+        InstanceMethod("setTxShaping", &CANBus::SetTxShaping),
+        InstanceMethod("sendAt", &CANBus::SendAt),
+        InstanceMethod("now", &CANBus::Now),
+        InstanceMethod("readInto", &CANBus::ReadInto),
+        InstanceMethod("setReceiveMode", &CANBus::SetReceiveMode),
+        InstanceMethod("setFilters", &CANBus::SetFilters),
+        InstanceMethod("tunnelStats", &CANBus::TunnelStats),
         StaticMethod("isAvailable", &CANBus::IsAvailable)
     });
+    AddonData* data = new AddonData();
+    data->can_bus = Napi::Persistent(func);
+    env.SetInstanceData(data);
     exports.Set("CANBus", func);
     return exports;
 }
 
+CANBus* CANBus::FromValue(Napi::Env env, const Napi::Value& value) {
+    AddonData* data = env.GetInstanceData<AddonData>();
+    if (data == nullptr || !value.IsObject() || !value.As<Napi::Object>().InstanceOf(data->can_bus.Value())) {
+        return nullptr;
+    }
+    return CANBus::Unwrap(value.As<Napi::Object>());
+}
+
+// Registers a native observer and makes sure the receive thread (or event loop poll) runs to feed it.
+void CANBus::AddTap(std::shared_ptr<FrameTap> tap) {
+    pipeline_.Update([&tap](ReceivePipeline& pipeline) { pipeline.taps.push_back(std::move(tap)); });
+    StartReceiveThread();
+}
+
+// Returns once the receive path can no longer call the tap.
+void CANBus::RemoveTap(const FrameTap* tap) {
+    pipeline_.Update([tap](ReceivePipeline& pipeline) {
+        pipeline.taps.erase(std::remove_if(pipeline.taps.begin(), pipeline.taps.end(),
+                                           [tap](const std::shared_ptr<FrameTap>& entry) { return entry.get() == tap; }),
+                            pipeline.taps.end());
+    });
+}
+
+// Registers a batch processing stage after the existing ones and makes sure frames are received.
+void CANBus::AddStage(std::shared_ptr<FrameStage> stage) {
+    pipeline_.Update([&stage](ReceivePipeline& pipeline) { pipeline.stages.push_back(std::move(stage)); });
+    StartReceiveThread();
+}
+
+// Returns once the receive path can no longer call the stage.
+void CANBus::RemoveStage(const FrameStage* stage) {
+    pipeline_.Update([stage](ReceivePipeline& pipeline) {
+        pipeline.stages.erase(std::remove_if(pipeline.stages.begin(), pipeline.stages.end(),
+                                             [stage](const std::shared_ptr<FrameStage>& entry) { return entry.get() == stage; }),
+                              pipeline.stages.end());
+    });
+}
+
+// Runs the stages over a batch that passed the filters. `annotations` is left empty when there
+// are no stages, so the common path allocates nothing.
+void CANBus::RunStages(std::vector<CanFrame>& batch, std::vector<uint32_t>& annotations) {
+    annotations.clear();
+    if (batch.empty()) {
+        return;
+    }
+    RcuPtr<ReceivePipeline>::ReadGuard pipeline(pipeline_);
+    if (pipeline->stages.empty()) {
+        return;
+    }
+    annotations.resize(batch.size(), 0);
+    for (const std::shared_ptr<FrameStage>& stage : pipeline->stages) {
+        stage->Process(batch, annotations);
+        annotations.resize(batch.size(), 0);
+    }
+}
+
+// Feeds a freshly read frame to the device clock estimate and the taps; returns whether it passes
+// the filters and should be handed on.
+bool CANBus::IngestFrame(const ReceivePipeline& pipeline, const CanFrame& frame) {
+    int64_t readUs = HostMicros();
+    device_clock_.Sample(frame.timestamp, readUs);
+    for (const std::shared_ptr<FrameTap>& tap : pipeline.taps) {
+        tap->OnFrame(frame, readUs);
+    }
+    return pipeline.Accepts(frame);
+}
+
+// Writes a frame from a native sender thread, such as a protocol session. While TX shaping is on
+// the frame joins the writer thread's queue behind JS sends, like send(), and write failures are
+// reported as 'error' events. Returns an empty string on success.
+std::string CANBus::Transmit(const CanFrame& frame) {
+    if (!is_open_) {
+        return "CANBus not open";
+    }
+    if (!attached_) {
+        return "CANBus device detached";
+    }
+    std::string error;
+    if (QueueShaped(frame, error)) {
+        return error;
+    }
+    return TransmitRaw(frame);
+}
+
+// Writes a frame from a native thread, bypassing TX shaping; for the latency probe, which times
+// the write itself. Returns an empty string on success.
+std::string CANBus::TransmitRaw(const CanFrame& frame) {
+    if (!is_open_) {
+        return "CANBus not open";
+    }
+    std::shared_lock<std::shared_mutex> deviceLock(device_mutex_);
+    if (!attached_) {
+        return "CANBus device detached";
+    }
+    int code = 0;
+    return WriteFrame(frame, code);
+}
+
+bool CANBus::DeviceToHost(uint64_t deviceUs, int64_t& hostUs) const {
+    if (!device_clock_.Known()) {
+        return false;
+    }
+    hostUs = device_clock_.ToHost(static_cast<int64_t>(deviceUs));
+    return true;
+}
+
 CANBus::CANBus(const Napi::CallbackInfo& info) : Napi::ObjectWrap<CANBus>(info) {
     Napi::Env env = info.Env();
     if (info.Length() < 3) {
@@ -161,22 +528,6 @@ CANBus::CANBus(const Napi::CallbackInfo& info) : Napi::ObjectWrap<CANBus>(info)
             return;
         }
 
-        auto cleanup_and_throw = [&](const std::string& message) {
-            if (handle_) {
-                BM_Close(static_cast<BM_ChannelHandle>(handle_));
-                handle_ = nullptr;
-            }
-            if (busmust_registered_) {
-                if (g_busmust_instance_count.fetch_sub(1) == 1) {
-                    BM_UnInit();
-                }
-                busmust_registered_ = false;
-            }
-            if (!message.empty()) {
-                Napi::Error::New(env, message).ThrowAsJavaScriptException();
-            }
-        };
-
         if (g_busmust_instance_count.fetch_add(1) == 0) {
             BM_StatusTypeDef initStatus = BM_Init();
             if (initStatus != BM_ERROR_OK) {
@@ -186,233 +537,802 @@ CANBus::CANBus(const Napi::CallbackInfo& info) : Napi::ObjectWrap<CANBus>(info)
             }
         }
         busmust_registered_ = true;
-
-        BM_BitrateTypeDef bitrateConfig{};
-        if (!BuildBusmustBitrate(bitrate_, bitrateConfig)) {
-            cleanup_and_throw("Unsupported Busmust bitrate (must be multiple of 1 kbps)");
+    } else if (bustype_ == "pcan") {
+        if (ResolvePcanChannelHandle(channel_) == PCAN_NONEBUS) {
+            Napi::Error::New(env, "Invalid PCAN channel").ThrowAsJavaScriptException();
             return;
         }
-
-        std::vector<BM_ChannelInfoTypeDef> channels;
-        channels.reserve(16);
-        BM_StatusTypeDef status = BM_ERROR_OK;
-        int enumerated = 0;
-        bool enumeration_success = false;
-        for (int attempt = 0; attempt < 4; ++attempt) {
-            int capacity = static_cast<int>(channels.capacity());
-            if (capacity == 0) {
-                capacity = 16;
-                channels.reserve(capacity);
-            }
-            channels.assign(capacity, {});
-            enumerated = capacity;
-            status = BM_Enumerate(channels.data(), &enumerated);
-            if (status != BM_ERROR_OK) {
-                break;
-            }
-            if (enumerated <= capacity) {
-                channels.resize(enumerated);
-                enumeration_success = true;
-                break;
+        if (MapPcanBaudrate(bitrate_) == 0) {
+            Napi::Error::New(env, "Unsupported PCAN bitrate").ThrowAsJavaScriptException();
+            return;
+        }
+    } else if (IsTunnel()) {
+        // The receiving end of a tunnel: { port, host = '0.0.0.0' } as the fourth argument.
+        uint32_t port = 0;
+        if (info.Length() > 3 && info[3].IsObject()) {
+            Napi::Object options = info[3].As<Napi::Object>();
+            if (!GetOptionalUint32(options, "port", port) || !GetOptionalString(options, "host", tunnel_host_)) {
+                Napi::TypeError::New(env, "Invalid tunnel option type").ThrowAsJavaScriptException();
+                return;
             }
-            channels.reserve(capacity * 2);
         }
-
-        if (status != BM_ERROR_OK) {
-            cleanup_and_throw("BM_Enumerate failed: " + BusmustStatusToString(status));
+        if (port == 0 || port > 65535) {
+            Napi::TypeError::New(env, "Tunnel bustypes require a port option").ThrowAsJavaScriptException();
             return;
         }
-
-        if (!enumeration_success) {
-            cleanup_and_throw("BM_Enumerate ran out of buffer space");
+        if (channel_ < 0 || channel_ > 255) {
+            Napi::RangeError::New(env, "Tunnel channel must be 0-255").ThrowAsJavaScriptException();
             return;
         }
+        tunnel_port_ = static_cast<uint16_t>(port);
+    } else {
+        Napi::Error::New(env, "Unsupported bustype: " + bustype_).ThrowAsJavaScriptException();
+        return;
+    }
 
-        if (channels.empty()) {
-            cleanup_and_throw("No Busmust channels detected");
-            return;
-        }
+    std::string error = OpenDevice();
+    if (!error.empty()) {
+        ReleaseBusmust();
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return;
+    }
+    is_open_ = true;
+    attached_ = true;
+}
+
+CANBus::~CANBus() {
+    ShutdownWatcher();
+    StopWriterThread();
+    StopTimedThread();
+    StopReceiveThread();
+    CloseDevice();
+    ReleaseBusmust();
+    is_open_ = false;
+    attached_ = false;
+}
+
+std::string CANBus::OpenDevice() {
+    if (bustype_ == "busmust") {
+        return OpenBusmust();
+    } else if (bustype_ == "pcan") {
+        return OpenPcan();
+    } else if (IsTunnel()) {
+        return OpenTunnel();
+    }
+    return "Unsupported bustype: " + bustype_;
+}
+
+// Opens the channel by index the first time; afterwards the device is found again by serial and port,
+// because a re-enumerated adapter may come back at a different index.
+std::string CANBus::OpenBusmust() {
+    BM_BitrateTypeDef bitrateConfig{};
+    if (!BuildBusmustBitrate(bitrate_, bitrateConfig)) {
+        return "Unsupported Busmust bitrate (must be multiple of 1 kbps)";
+    }
+
+    std::vector<BM_ChannelInfoTypeDef> channels;
+    std::string error = EnumerateBusmustChannels(channels);
+    if (!error.empty()) {
+        return error;
+    }
+    if (channels.empty()) {
+        return "No Busmust channels detected";
+    }
 
+    const BM_ChannelInfoTypeDef* selected = nullptr;
+    if (busmust_serial_.empty()) {
         if (channel_ >= static_cast<int>(channels.size())) {
-            cleanup_and_throw("Busmust channel index out of range");
-            return;
+            return "Busmust channel index out of range";
         }
-
-        BM_ChannelInfoTypeDef channelInfo = channels[channel_];
-        if (!BusmustSupportsCan(channelInfo)) {
-            cleanup_and_throw("Selected Busmust channel does not support CAN");
-            return;
+        selected = &channels[channel_];
+    } else {
+        for (const BM_ChannelInfoTypeDef& candidate : channels) {
+            if (candidate.port == busmust_port_ && BusmustSerialToString(candidate) == busmust_serial_) {
+                selected = &candidate;
+                break;
+            }
         }
-
-        BM_ChannelHandle openedHandle = nullptr;
-        status = BM_OpenEx(
-            &openedHandle,
-            &channelInfo,
-            BM_CAN_NORMAL_MODE,
-            BM_TRESISTOR_120,
-            &bitrateConfig,
-            nullptr,
-            0);
-        if (status != BM_ERROR_OK || openedHandle == nullptr) {
-            cleanup_and_throw("BM_OpenEx failed: " + BusmustStatusToString(status));
-            return;
+        if (selected == nullptr) {
+            return "Busmust device " + busmust_serial_ + " not attached";
         }
+    }
 
-        handle_ = openedHandle;
+    BM_ChannelInfoTypeDef channelInfo = *selected;
+    if (!BusmustSupportsCan(channelInfo)) {
+        return "Selected Busmust channel does not support CAN";
+    }
 
-        BM_NotificationHandle notification = nullptr;
-        status = BM_GetNotification(openedHandle, &notification);
-        if (status != BM_ERROR_OK || notification == nullptr) {
-            cleanup_and_throw("BM_GetNotification failed: " + BusmustStatusToString(status));
-            return;
-        }
-        notification_handle_ = notification;
+    BM_ChannelHandle openedHandle = nullptr;
+    BM_StatusTypeDef status = BM_OpenEx(
+        &openedHandle,
+        &channelInfo,
+        BM_CAN_NORMAL_MODE,
+        BM_TRESISTOR_120,
+        &bitrateConfig,
+        nullptr,
+        0);
+    if (status != BM_ERROR_OK || openedHandle == nullptr) {
+        return "BM_OpenEx failed: " + BusmustStatusToString(status);
+    }
 
-        is_open_ = true;
-    } else if (bustype_ == "pcan") {
-        TPCANHandle resolved = ResolvePcanChannelHandle(channel_);
-        if (resolved == PCAN_NONEBUS) {
-            Napi::Error::New(env, "Invalid PCAN channel").ThrowAsJavaScriptException();
-            return;
-        }
-        TPCANBaudrate baud = MapPcanBaudrate(bitrate_);
-        if (baud == 0) {
-            Napi::Error::New(env, "Unsupported PCAN bitrate").ThrowAsJavaScriptException();
-            return;
+    BM_NotificationHandle notification = nullptr;
+    status = BM_GetNotification(openedHandle, &notification);
+    if (status != BM_ERROR_OK || notification == nullptr) {
+        BM_Close(openedHandle);
+        return "BM_GetNotification failed: " + BusmustStatusToString(status);
+    }
+
+    handle_ = openedHandle;
+    notification_handle_ = notification;
+    busmust_timestamps_.Reset();
+    busmust_port_ = channelInfo.port;
+    busmust_serial_ = BusmustSerialToString(channelInfo);
+    return std::string();
+}
+
+// PCAN channel handles follow plug order, so on re-attachment the channel is looked up by the
+// device type, device id and controller number recorded when it was first opened.
+std::string CANBus::OpenPcan() {
+    TPCANHandle resolved = ResolvePcanChannelHandle(channel_);
+    if (pcan_identity_known_) {
+        resolved = PCAN_NONEBUS;
+        for (const TPCANChannelInformation& candidate : GetAttachedPcanChannels()) {
+            if (candidate.device_type != pcan_device_type_ || candidate.device_id != pcan_device_id_ ||
+                candidate.controller_number != pcan_controller_ ||
+                (candidate.channel_condition & PCAN_CHANNEL_AVAILABLE) == 0) {
+                continue;
+            }
+            if (resolved == PCAN_NONEBUS || candidate.channel_handle == ResolvePcanChannelHandle(channel_)) {
+                resolved = candidate.channel_handle;
+            }
         }
-        TPCANStatus status = CAN_Initialize(resolved, baud, 0, 0, 0);
-        if (status != PCAN_ERROR_OK) {
-            Napi::Error::New(env, "CAN_Initialize failed: " + PcanStatusToString(status)).ThrowAsJavaScriptException();
-            return;
+        if (resolved == PCAN_NONEBUS) {
+            return "PCAN device " + DeviceSerial() + " not attached";
         }
-        pcan_handle_ = resolved;
-#ifdef _WIN32
-        HANDLE eventHandle = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-        if (eventHandle != nullptr) {
-            HANDLE value = eventHandle;
-            TPCANStatus eventStatus = CAN_SetValue(pcan_handle_, PCAN_RECEIVE_EVENT, &value, static_cast<DWORD>(sizeof(value)));
-            if (eventStatus == PCAN_ERROR_OK) {
-                pcan_event_handle_ = eventHandle;
-            } else {
-                CloseHandle(eventHandle);
+    }
+
+    TPCANStatus status = CAN_Initialize(resolved, MapPcanBaudrate(bitrate_), 0, 0, 0);
+    if (status != PCAN_ERROR_OK) {
+        return "CAN_Initialize failed: " + PcanStatusToString(status);
+    }
+    pcan_handle_ = resolved;
+    AttachPcanEvent();
+
+    if (!pcan_identity_known_) {
+        for (const TPCANChannelInformation& candidate : GetAttachedPcanChannels()) {
+            if (candidate.channel_handle == resolved) {
+                pcan_device_type_ = candidate.device_type;
+                pcan_device_id_ = candidate.device_id;
+                pcan_controller_ = candidate.controller_number;
+                pcan_identity_known_ = true;
+                break;
             }
         }
-#else
-        int eventFd = -1;
-        TPCANStatus eventStatus = CAN_GetValue(pcan_handle_, PCAN_RECEIVE_EVENT, &eventFd, static_cast<DWORD>(sizeof(eventFd)));
-        if (eventStatus == PCAN_ERROR_OK && eventFd >= 0) {
-            pcan_event_fd_ = eventFd;
-        }
-#endif
-        is_open_ = true;
-    } else {
-        Napi::Error::New(env, "Unsupported bustype: " + bustype_).ThrowAsJavaScriptException();
     }
+    return std::string();
 }
 
-CANBus::~CANBus() {
-    StopReceiveThread();
+// Joins the tunnel link on the port, opening it if this is its first channel.
+std::string CANBus::OpenTunnel() {
+    std::string error;
+    std::shared_ptr<TunnelLink> link = TunnelLink::Acquire(bustype_ == "tcp", tunnel_host_, tunnel_port_, error);
+    if (!link) {
+        return error;
+    }
+    error = link->Attach(static_cast<uint8_t>(channel_));
+    if (!error.empty()) {
+        return error;
+    }
+    tunnel_ = link;
+    return std::string();
+}
 
+void CANBus::CloseDevice() {
     if (bustype_ == "busmust") {
         if (handle_) {
             BM_Close(static_cast<BM_ChannelHandle>(handle_));
             handle_ = nullptr;
         }
         notification_handle_ = nullptr;
-        if (busmust_registered_) {
-            if (g_busmust_instance_count.fetch_sub(1) == 1) {
-                BM_UnInit();
-            }
-            busmust_registered_ = false;
-        }
     } else if (bustype_ == "pcan") {
         DetachPcanEvent();
         if (pcan_handle_ != PCAN_NONEBUS) {
             CAN_Uninitialize(pcan_handle_);
             pcan_handle_ = PCAN_NONEBUS;
         }
+    } else if (tunnel_) {
+        tunnel_->Detach(static_cast<uint8_t>(channel_));
+        tunnel_.reset();
     }
+}
 
-    is_open_ = false;
+void CANBus::ReleaseBusmust() {
+    if (busmust_registered_) {
+        if (g_busmust_instance_count.fetch_sub(1) == 1) {
+            BM_UnInit();
+        }
+        busmust_registered_ = false;
+    }
 }
 
-Napi::Value CANBus::Send(const Napi::CallbackInfo& info) {
+// Re-applies channel settings that do not survive a device re-enumeration.
+std::string CANBus::ApplyChannelSettings() {
+    if (bustype_ == "busmust" && handle_ && busmust_logging_config_.size() == sizeof(BM_LoggingConfigTypeDef)) {
+        BM_LoggingConfigTypeDef config = {};
+        std::memcpy(&config, busmust_logging_config_.data(), sizeof(config));
+        BM_StatusTypeDef status = BM_SetLogging(static_cast<BM_ChannelHandle>(handle_), &config);
+        if (status != BM_ERROR_OK) {
+            return "BM_SetLogging failed: " + BusmustStatusToString(status);
+        }
+    } else if (bustype_ == "pcan") {
+        std::string error = pcan_interframe_delay_us_ > 0 ? ApplyPcanInterframeDelay() : std::string();
+        if (error.empty() && pcan_trace_.enabled) {
+            error = ApplyPcanTrace(pcan_trace_);
+        }
+        return error;
+    }
+    return std::string();
+}
+
+std::string CANBus::DeviceSerial() const {
+    if (bustype_ == "busmust") {
+        return busmust_serial_;
+    }
+    if (IsTunnel()) {
+        return bustype_ + ":" + std::to_string(tunnel_port_) + "/" + std::to_string(channel_);
+    }
+    if (!pcan_identity_known_) {
+        return std::string();
+    }
+    std::ostringstream oss;
+    oss << static_cast<int>(pcan_device_type_) << ":" << pcan_device_id_ << ":" << static_cast<int>(pcan_controller_);
+    return oss.str();
+}
+
+Napi::Value CANBus::StartWatcher(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     if (!is_open_) {
         Napi::Error::New(env, "CANBus not open").ThrowAsJavaScriptException();
         return env.Undefined();
     }
-    if (info.Length() < 1 || !info[0].IsObject()) {
-        Napi::TypeError::New(env, "Expected message object").ThrowAsJavaScriptException();
+    uint32_t intervalMs = kWatcherDefaultIntervalMs;
+    bool autoReattach = true;
+    if (info.Length() > 0 && !info[0].IsUndefined()) {
+        if (!info[0].IsObject()) {
+            Napi::TypeError::New(env, "Expected watcher options object").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Object options = info[0].As<Napi::Object>();
+        if (!GetOptionalUint32(options, "intervalMs", intervalMs) || !GetOptionalBool(options, "autoReattach", autoReattach)) {
+            Napi::TypeError::New(env, "Invalid watcher option type").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+    }
+    if (!watcher_) {
+        DeviceWatcher::Hooks hooks;
+        hooks.probe = [this]() {
+            std::shared_lock<std::shared_mutex> deviceLock(device_mutex_);
+            return ProbeDevice();
+        };
+        hooks.detach = [this]() { DetachDevice(); };
+        hooks.reattach = [this](int64_t downMs) { return ReattachDevice(downMs); };
+        watcher_ = std::make_unique<DeviceWatcher>(std::move(hooks));
+    }
+    if (!watcher_->Start(std::max<uint32_t>(intervalMs, kWatcherMinIntervalMs), autoReattach, attached_)) {
+        Napi::Error::New(env, "Watcher already running").ThrowAsJavaScriptException();
         return env.Undefined();
     }
+    return env.Undefined();
+}
 
-    Napi::Object msgObj = info[0].As<Napi::Object>();
-    if (!msgObj.Has("id") || !msgObj.Get("id").IsNumber()) {
-        Napi::TypeError::New(env, "Message.id must be a number").ThrowAsJavaScriptException();
-        return env.Undefined();
+Napi::Value CANBus::StopWatcher(const Napi::CallbackInfo& info) {
+    ShutdownWatcher();
+    return info.Env().Undefined();
+}
+
+void CANBus::ShutdownWatcher() {
+    if (watcher_) {
+        watcher_->Stop();
     }
-    if (!msgObj.Has("data") || !msgObj.Get("data").IsBuffer()) {
-        Napi::TypeError::New(env, "Message.data must be a Buffer").ThrowAsJavaScriptException();
-        return env.Undefined();
+}
+
+// Watcher hook: releases a channel whose device went away and reports the detach.
+void CANBus::DetachDevice() {
+    {
+        std::unique_lock<std::shared_mutex> deviceLock(device_mutex_);
+        attached_ = false;
+        CloseDevice();
     }
+    poller_.Rearm();
+    EmitDeviceEvent(tsfn_detach_, -1);
+}
 
-    uint32_t id = msgObj.Get("id").As<Napi::Number>().Uint32Value();
-    Napi::Buffer<uint8_t> dataBuf = msgObj.Get("data").As<Napi::Buffer<uint8_t>>();
+// Watcher hook: tries to reopen the channel on the same device and restore its settings; reports
+// the attach with the time the device was gone. Returns whether the channel is open again.
+bool CANBus::ReattachDevice(int64_t downMs) {
+    std::string error;
+    {
+        std::unique_lock<std::shared_mutex> deviceLock(device_mutex_);
+        error = OpenDevice();
+        if (!error.empty()) {
+            return false;
+        }
+        device_clock_.Reset();
+        error = ApplyChannelSettings();
+        attached_ = true;
+    }
+    poller_.Rearm();
+    EmitDeviceEvent(tsfn_attach_, downMs);
+    if (!error.empty()) {
+        EmitError(-1, "Failed to restore channel settings: " + error);
+    }
+    return true;
+}
 
+// Checks whether the opened channel is still backed by hardware. Called with the device lock held.
+bool CANBus::ProbeDevice() {
     if (bustype_ == "busmust") {
-        if (!handle_) {
-            Napi::Error::New(env, "Busmust handle not open").ThrowAsJavaScriptException();
-            return env.Undefined();
+        std::vector<BM_ChannelInfoTypeDef> channels;
+        if (!EnumerateBusmustChannels(channels).empty()) {
+            // Enumeration itself failing says nothing about this device; try again next round.
+            return true;
         }
-        size_t dlc = std::min<size_t>(dataBuf.Length(), 64);
-        BM_CanMessageTypeDef msg = {};
-        if (id <= 0x7FF) {
-            BM_SET_STD_MSG_ID(msg.id, id);
-            msg.ctrl.tx.IDE = 0;
-        } else {
-            BM_SET_EXT_MSG_ID(msg.id, id);
-            msg.ctrl.tx.IDE = 1;
+        for (const BM_ChannelInfoTypeDef& candidate : channels) {
+            if (candidate.port == busmust_port_ && BusmustSerialToString(candidate) == busmust_serial_) {
+                return true;
+            }
         }
-        msg.ctrl.tx.DLC = dlc;
-        msg.ctrl.tx.RTR = 0;
-        msg.ctrl.tx.FDF = 0;
-        msg.ctrl.tx.BRS = 0;
+        return false;
+    } else if (bustype_ == "pcan") {
+        if (pcan_handle_ == PCAN_NONEBUS) {
+            return false;
+        }
+        DWORD condition = 0;
+        TPCANStatus result = CAN_GetValue(pcan_handle_, PCAN_CHANNEL_CONDITION, &condition, static_cast<DWORD>(sizeof(condition)));
+        if (result == PCAN_ERROR_OK && (condition & (PCAN_CHANNEL_AVAILABLE | PCAN_CHANNEL_OCCUPIED)) == 0) {
+            return false;
+        }
+        TPCANStatus status = CAN_GetStatus(pcan_handle_);
+        return status != PCAN_ERROR_ILLHW && status != PCAN_ERROR_NODRIVER && status != PCAN_ERROR_INITIALIZE;
+    }
+    return true;
+}
+
+// Emits an 'attach' or 'detach' event; recoveryMs < 0 leaves the field out.
+void CANBus::EmitDeviceEvent(Napi::ThreadSafeFunction& tsfn, int64_t recoveryMs) {
+    if (!tsfn) {
+        return;
+    }
+    auto callback = [serial = DeviceSerial(), recoveryMs](Napi::Env env, Napi::Function jsCallback) {
+        Napi::Object event = Napi::Object::New(env);
+        event.Set("serial", Napi::String::New(env, serial));
+        if (recoveryMs >= 0) {
+            event.Set("recoveryMs", Napi::Number::New(env, static_cast<double>(recoveryMs)));
+        }
+        jsCallback.Call({event});
+    };
+    tsfn.NonBlockingCall(callback);
+}
+
+Napi::Value CANBus::Send(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!is_open_) {
+        Napi::Error::New(env, "CANBus not open").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::shared_lock<std::shared_mutex> deviceLock(device_mutex_);
+    if (!attached_) {
+        Napi::Error::New(env, "CANBus device detached").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    CanFrame frame = {};
+    std::string typeError = JsToFrame(info.Length() > 0 ? info[0] : env.Undefined(), MaxDataLength(), frame);
+    if (!typeError.empty()) {
+        Napi::TypeError::New(env, typeError).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::string queueError;
+    if (QueueShaped(frame, queueError)) {
+        if (!queueError.empty()) {
+            Napi::Error::New(env, queueError).ThrowAsJavaScriptException();
+        }
+        return env.Undefined();
+    }
+
+    int code = 0;
+    std::string error = WriteFrame(frame, code);
+    if (!error.empty()) {
+        EmitError(code, error);
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+    }
+    return env.Undefined();
+}
+
+// Schedules a frame for transmission at an absolute time and returns a promise for the achieved
+// time. Timestamps are microseconds on the device clock (the clock of received message timestamps)
+// or, with { clock: 'host' }, on the host monotonic clock returned by now('host').
+Napi::Value CANBus::SendAt(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!is_open_) {
+        Napi::Error::New(env, "CANBus not open").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    CanFrame frame = {};
+    std::string typeError = JsToFrame(info.Length() > 0 ? info[0] : env.Undefined(), MaxDataLength(), frame);
+    if (!typeError.empty()) {
+        Napi::TypeError::New(env, typeError).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (info.Length() < 2 || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Expected timestamp in microseconds").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::string clock = "device";
+    if (info.Length() > 2 && info[2].IsObject() && !GetOptionalString(info[2].As<Napi::Object>(), "clock", clock)) {
+        Napi::TypeError::New(env, "clock must be a string").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (clock != "device" && clock != "host") {
+        Napi::TypeError::New(env, "clock must be 'device' or 'host'").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    int64_t timestamp = info[1].As<Napi::Number>().Int64Value();
+    bool deviceClock = (clock == "device");
+    if (deviceClock && !device_clock_.Known()) {
+        Napi::Error::New(env, "Device clock not known yet; listen for messages first or use clock: 'host'")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    StartTimedThread(env);
+    auto deferred = std::make_shared<Napi::Promise::Deferred>(Napi::Promise::Deferred::New(env));
+    {
+        std::lock_guard<std::mutex> lock(timed_mutex_);
+        TimedFrame item{deviceClock ? device_clock_.ToHost(timestamp) : timestamp, timed_sequence_++, deviceClock, frame, deferred};
+        timed_queue_.push(std::move(item));
+    }
+    timed_cv_.notify_one();
+    return deferred->Promise();
+}
+
+// Current time in microseconds on the host monotonic clock, or on the device clock with 'device'.
+Napi::Value CANBus::Now(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    int64_t host = HostMicros();
+    if (info.Length() > 0 && info[0].IsString() && info[0].As<Napi::String>().Utf8Value() == "device") {
+        if (!device_clock_.Known()) {
+            Napi::Error::New(env, "Device clock not known yet").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return Napi::Number::New(env, static_cast<double>(device_clock_.ToDevice(host)));
+    }
+    return Napi::Number::New(env, static_cast<double>(host));
+}
+
+void CANBus::StartTimedThread(Napi::Env env) {
+    std::lock_guard<std::mutex> lock(timed_mutex_);
+    if (timed_running_) {
+        return;
+    }
+    // Results are delivered by resolving each frame's promise on the JS thread; the function
+    // itself is never called.
+    tsfn_timed_ = Napi::ThreadSafeFunction::New(env, Napi::Function::New(env, [](const Napi::CallbackInfo&) {}),
+                                                "CANBusTimedSend", 0, 1);
+    timed_running_ = true;
+    timed_thread_ = std::thread([this]() { TimedLoop(); });
+}
+
+// Frames still queued are rejected rather than dropped, so no sendAt() promise is left pending when the
+// bus is closed or collected.
+void CANBus::StopTimedThread() {
+    {
+        std::lock_guard<std::mutex> lock(timed_mutex_);
+        timed_running_ = false;
+    }
+    timed_cv_.notify_all();
+    if (timed_thread_.joinable()) {
+        timed_thread_.join();
+    }
+    if (tsfn_timed_) {
+        tsfn_timed_.Release();
+        tsfn_timed_ = nullptr;
+    }
+    while (!timed_queue_.empty()) {
+        const TimedFrame& item = timed_queue_.top();
+        item.deferred->Reject(Napi::Error::New(item.deferred->Env(), "CANBus closed").Value());
+        timed_queue_.pop();
+    }
+}
+
+// Sleeps until shortly before the earliest deadline, then spins the rest of the way so the write
+// is issued within a few microseconds of it. Timed frames bypass TX shaping.
+void CANBus::TimedLoop() {
+    std::unique_lock<std::mutex> lock(timed_mutex_);
+    while (timed_running_) {
+        if (timed_queue_.empty()) {
+            timed_cv_.wait(lock);
+            continue;
+        }
+        int64_t remaining = timed_queue_.top().due_us - HostMicros();
+        if (remaining > kTimedSpinWindowUs) {
+            timed_cv_.wait_for(lock, std::chrono::microseconds(remaining - kTimedSpinWindowUs));
+            continue;
+        }
+        TimedFrame item = timed_queue_.top();
+        timed_queue_.pop();
+        lock.unlock();
+
+        SpinUntil(item.due_us);
+        int code = 0;
+        std::string error;
+        int64_t achieved = 0;
+        {
+            std::shared_lock<std::shared_mutex> deviceLock(device_mutex_);
+            achieved = HostMicros();
+            error = attached_ ? WriteFrame(item.frame, code) : std::string("CANBus device detached");
+        }
+        int64_t scheduled = item.device_clock ? device_clock_.ToDevice(item.due_us) : item.due_us;
+        if (item.device_clock) {
+            achieved = device_clock_.ToDevice(achieved);
+        }
+
+        auto deferred = item.deferred;
+        tsfn_timed_.BlockingCall([deferred, scheduled, achieved, error](Napi::Env env, Napi::Function) {
+            if (!error.empty()) {
+                deferred->Reject(Napi::Error::New(env, error).Value());
+                return;
+            }
+            Napi::Object result = Napi::Object::New(env);
+            result.Set("scheduled", Napi::Number::New(env, static_cast<double>(scheduled)));
+            result.Set("achieved", Napi::Number::New(env, static_cast<double>(achieved)));
+            result.Set("lateUs", Napi::Number::New(env, static_cast<double>(achieved - scheduled)));
+            deferred->Resolve(result);
+        });
+        lock.lock();
+    }
+}
+
+// Writes one frame to the device. Called with the device lock held; returns an empty string on success.
+std::string CANBus::WriteFrame(const CanFrame& frame, int& code) {
+    if (bustype_ == "busmust") {
+        if (!handle_) {
+            return "Busmust handle not open";
+        }
+        BM_CanMessageTypeDef msg = {};
+        if ((frame.flags & kFrameFlagExtended) == 0) {
+            BM_SET_STD_MSG_ID(msg.id, frame.id);
+            msg.ctrl.tx.IDE = 0;
+        } else {
+            BM_SET_EXT_MSG_ID(msg.id, frame.id);
+            msg.ctrl.tx.IDE = 1;
+        }
+        msg.ctrl.tx.DLC = CanFdLengthToDlc(frame.length);
+        msg.ctrl.tx.RTR = 0;
+        msg.ctrl.tx.FDF = 0;
+        msg.ctrl.tx.BRS = 0;
         msg.ctrl.tx.ESI = 0;
-        std::memcpy(msg.payload, dataBuf.Data(), dlc);
+        std::memcpy(msg.payload, frame.data, frame.length);
 
         uint32_t timestamp = 0;
         BM_StatusTypeDef status = BM_WriteCanMessage(static_cast<BM_ChannelHandle>(handle_), &msg, 0, 100, &timestamp);
         if (status != BM_ERROR_OK) {
-            std::string reason = BusmustStatusToString(status);
-            EmitError(static_cast<int>(status), reason);
-            Napi::Error::New(env, "BM_WriteCanMessage failed: " + reason).ThrowAsJavaScriptException();
+            code = static_cast<int>(status);
+            return "BM_WriteCanMessage failed: " + BusmustStatusToString(status);
         }
     } else if (bustype_ == "pcan") {
         if (pcan_handle_ == PCAN_NONEBUS) {
-            Napi::Error::New(env, "PCAN channel not open").ThrowAsJavaScriptException();
-            return env.Undefined();
+            return "PCAN channel not open";
         }
-        size_t dlc = std::min<size_t>(dataBuf.Length(), 8);
         TPCANMsg msg = {};
-        msg.ID = id;
-        msg.MSGTYPE = (id > 0x7FF) ? PCAN_MESSAGE_EXTENDED : PCAN_MESSAGE_STANDARD;
-        msg.LEN = static_cast<BYTE>(dlc);
-        std::memcpy(msg.DATA, dataBuf.Data(), dlc);
+        msg.ID = frame.id;
+        msg.MSGTYPE = (frame.flags & kFrameFlagExtended) ? PCAN_MESSAGE_EXTENDED : PCAN_MESSAGE_STANDARD;
+        msg.LEN = static_cast<BYTE>(std::min<uint8_t>(frame.length, 8));
+        std::memcpy(msg.DATA, frame.data, msg.LEN);
 
         TPCANStatus status = CAN_Write(pcan_handle_, &msg);
         if (status != PCAN_ERROR_OK) {
-            std::string reason = PcanStatusToString(status);
-            EmitError(static_cast<int>(status), reason);
-            Napi::Error::New(env, "CAN_Write failed: " + reason).ThrowAsJavaScriptException();
+            code = static_cast<int>(status);
+            return "CAN_Write failed: " + PcanStatusToString(status);
         }
+    } else if (IsTunnel()) {
+        if (!tunnel_) {
+            return "Tunnel not open";
+        }
+        return tunnel_->Send(static_cast<uint8_t>(channel_), frame);
     } else {
-        Napi::Error::New(env, "Unsupported bustype: " + bustype_).ThrowAsJavaScriptException();
+        return "Unsupported bustype: " + bustype_;
+    }
+    return std::string();
+}
+
+// Configures transmit shaping: a bus-wide budget (`busLoad` as a fraction of the bitrate, or
+// `bitsPerSecond`) and optional per-id-class budgets. Passing null turns shaping off.
+Napi::Value CANBus::SetTxShaping(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!is_open_) {
+        Napi::Error::New(env, "CANBus not open").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    TokenBucket busBucket;
+    std::vector<TxShaper::IdClass> classes;
+    double busRate = 0;
+    if (info.Length() > 0 && info[0].IsObject()) {
+        Napi::Object options = info[0].As<Napi::Object>();
+        double busLoad = 0;
+        uint32_t bitsPerSecond = 0;
+        uint32_t burstBits = 0;
+        if (!GetOptionalDouble(options, "busLoad", busLoad) || !GetOptionalUint32(options, "bitsPerSecond", bitsPerSecond) ||
+            !GetOptionalUint32(options, "burstBits", burstBits)) {
+            Napi::TypeError::New(env, "Invalid TX shaping option type").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        if (busLoad < 0 || busLoad > 1) {
+            Napi::RangeError::New(env, "busLoad must be between 0 and 1").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        busRate = bitsPerSecond;
+        if (busLoad > 0) {
+            busRate = busRate > 0 ? std::min(busRate, busLoad * bitrate_) : busLoad * bitrate_;
+        }
+        if (busRate > 0) {
+            busBucket = TokenBucket(busRate, DefaultBurstBits(busRate, burstBits));
+        }
+
+        if (options.Has("classes") && !options.Get("classes").IsUndefined()) {
+            if (!options.Get("classes").IsArray()) {
+                Napi::TypeError::New(env, "classes must be an array").ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            Napi::Array list = options.Get("classes").As<Napi::Array>();
+            for (uint32_t i = 0; i < list.Length(); ++i) {
+                Napi::Value entry = list.Get(i);
+                TxShaper::IdClass idClass;
+                uint32_t classRate = 0;
+                uint32_t classBurst = 0;
+                idClass.mask = 0xFFFFFFFFu;
+                if (!entry.IsObject() || !GetOptionalUint32(entry.As<Napi::Object>(), "id", idClass.match) ||
+                    !GetOptionalUint32(entry.As<Napi::Object>(), "mask", idClass.mask) ||
+                    !GetOptionalUint32(entry.As<Napi::Object>(), "bitsPerSecond", classRate) ||
+                    !GetOptionalUint32(entry.As<Napi::Object>(), "burstBits", classBurst) || classRate == 0) {
+                    Napi::TypeError::New(env, "Each class needs numeric id, mask and bitsPerSecond").ThrowAsJavaScriptException();
+                    return env.Undefined();
+                }
+                idClass.bucket = TokenBucket(classRate, DefaultBurstBits(classRate, classBurst));
+                classes.push_back(idClass);
+            }
+        }
+    } else if (info.Length() > 0 && !info[0].IsNull() && !info[0].IsUndefined()) {
+        Napi::TypeError::New(env, "Expected TX shaping options object or null").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    // The hardware gap goes first, so a driver failure leaves the previous shaping in place.
+    if (bustype_ == "pcan") {
+        // The bus bucket is sized for an average frame; a hardware gap sized for the shortest
+        // frame additionally keeps the adapter from bursting queued frames back to back. Low loads
+        // need more than the driver allows, and the software buckets pace the rest.
+        uint32_t delayUs = 0;
+        if (busRate > 0 && busRate < bitrate_) {
+            CanFrame shortest = {};
+            double bits = FrameBitLength(shortest);
+            double gapUs = std::ceil(bits * 1e6 / busRate - bits * 1e6 / bitrate_);
+            delayUs = static_cast<uint32_t>(std::min<double>(gapUs, kPcanMaxInterframeDelayUs));
+        }
+        std::shared_lock<std::shared_mutex> deviceLock(device_mutex_);
+        uint32_t previousUs = pcan_interframe_delay_us_;
+        pcan_interframe_delay_us_ = delayUs;
+        std::string error = attached_ ? ApplyPcanInterframeDelay() : std::string();
+        if (!error.empty()) {
+            pcan_interframe_delay_us_ = previousUs;
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
     }
 
+    TxShaper shaper(busBucket, std::move(classes));
+    bool shaping = shaper.Enabled();
+    {
+        std::lock_guard<std::mutex> txLock(tx_mutex_);
+        tx_shaper_ = std::move(shaper);
+    }
+    tx_cv_.notify_one();
+    if (shaping) {
+        StartWriterThread();
+    }
     return env.Undefined();
 }
 
+// Sets PCAN_INTERFRAME_DELAY on adapters that support it; others rely on software pacing only.
+std::string CANBus::ApplyPcanInterframeDelay() {
+    DWORD features = 0;
+    if (CAN_GetValue(pcan_handle_, PCAN_CHANNEL_FEATURES, &features, static_cast<DWORD>(sizeof(features))) != PCAN_ERROR_OK ||
+        (features & FEATURE_DELAY_CAPABLE) == 0) {
+        return std::string();
+    }
+    DWORD delay = pcan_interframe_delay_us_;
+    TPCANStatus result = CAN_SetValue(pcan_handle_, PCAN_INTERFRAME_DELAY, &delay, static_cast<DWORD>(sizeof(delay)));
+    if (result != PCAN_ERROR_OK) {
+        return "PCAN_INTERFRAME_DELAY failed: " + PcanStatusToString(result);
+    }
+    return std::string();
+}
+
+// Queues a frame for the writer thread while shaping is on, and while earlier frames still wait so
+// ordering is kept. Returns false if the caller should write the frame itself; `error` is set when
+// the queue is full.
+bool CANBus::QueueShaped(const CanFrame& frame, std::string& error) {
+    std::lock_guard<std::mutex> txLock(tx_mutex_);
+    if (!tx_shaper_.Enabled() && tx_queue_.empty()) {
+        return false;
+    }
+    if (tx_queue_.size() >= kTxQueueCapacity) {
+        error = "TX queue full";
+        return true;
+    }
+    tx_queue_.push_back(frame);
+    tx_cv_.notify_one();
+    return true;
+}
+
+void CANBus::StartWriterThread() {
+    std::lock_guard<std::mutex> txLock(tx_mutex_);
+    if (tx_running_) {
+        return;
+    }
+    tx_running_ = true;
+    tx_thread_ = std::thread([this]() { WriteLoop(); });
+}
+
+void CANBus::StopWriterThread() {
+    {
+        std::lock_guard<std::mutex> txLock(tx_mutex_);
+        tx_running_ = false;
+        tx_queue_.clear();
+    }
+    tx_cv_.notify_all();
+    if (tx_thread_.joinable()) {
+        tx_thread_.join();
+    }
+}
+
+// Drains the TX queue in order, holding each frame until the shaper admits it. Waiting on the
+// condition variable rather than sleeping lets close() and reconfiguration interrupt a long wait.
+void CANBus::WriteLoop() {
+    std::unique_lock<std::mutex> txLock(tx_mutex_);
+    while (tx_running_) {
+        if (tx_queue_.empty()) {
+            tx_cv_.wait(txLock);
+            continue;
+        }
+        if (!attached_) {
+            tx_cv_.wait_for(txLock, std::chrono::milliseconds(20));
+            continue;
+        }
+        auto delay = tx_shaper_.Admit(tx_queue_.front(), TokenBucket::Clock::now());
+        if (delay > TokenBucket::Clock::duration::zero()) {
+            tx_cv_.wait_for(txLock, delay);
+            continue;
+        }
+        CanFrame frame = tx_queue_.front();
+        tx_queue_.pop_front();
+        txLock.unlock();
+
+        int code = 0;
+        std::string error;
+        {
+            std::shared_lock<std::shared_mutex> deviceLock(device_mutex_);
+            error = WriteFrame(frame, code);
+        }
+        if (!error.empty()) {
+            EmitError(code, error);
+        }
+        txLock.lock();
+    }
+}
+
 Napi::Value CANBus::On(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     if (info.Length() < 2 || !info[0].IsString() || !info[1].IsFunction()) {
@@ -423,11 +1343,15 @@ Napi::Value CANBus::On(const Napi::CallbackInfo& info) {
     Napi::Function cb = info[1].As<Napi::Function>();
 
     if (event == "message") {
-        if (tsfn_message_) {
+        if (tsfn_message_ || !poll_message_cb_.IsEmpty()) {
             Napi::Error::New(env, "Already listening for messages").ThrowAsJavaScriptException();
             return env.Undefined();
         }
-        tsfn_message_ = Napi::ThreadSafeFunction::New(env, cb, "CANBusOnMessage", 0, 1);
+        if (poll_mode_) {
+            poll_message_cb_ = Napi::Persistent(cb);
+        } else {
+            tsfn_message_ = Napi::ThreadSafeFunction::New(env, cb, "CANBusOnMessage", 0, 1);
+        }
         StartReceiveThread();
     } else if (event == "error") {
         if (tsfn_error_) {
@@ -441,153 +1365,310 @@ Napi::Value CANBus::On(const Napi::CallbackInfo& info) {
             return env.Undefined();
         }
         tsfn_close_ = Napi::ThreadSafeFunction::New(env, cb, "CANBusOnClose", 0, 1);
+    } else if (event == "attach") {
+        if (tsfn_attach_) {
+            Napi::Error::New(env, "Already listening for attach").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        tsfn_attach_ = Napi::ThreadSafeFunction::New(env, cb, "CANBusOnAttach", 0, 1);
+    } else if (event == "detach") {
+        if (tsfn_detach_) {
+            Napi::Error::New(env, "Already listening for detach").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        tsfn_detach_ = Napi::ThreadSafeFunction::New(env, cb, "CANBusOnDetach", 0, 1);
     } else {
-        Napi::Error::New(env, "Only 'message', 'error', 'close' events supported").ThrowAsJavaScriptException();
+        Napi::Error::New(env, "Only 'message', 'error', 'close', 'attach', 'detach' events supported").ThrowAsJavaScriptException();
         return env.Undefined();
     }
     return env.Undefined();
 }
 
 void CANBus::StartReceiveThread() {
+    if (poll_mode_) {
+        StartReceivePoll();
+        return;
+    }
     if (recv_running_ || !is_open_) {
         return;
     }
     recv_running_ = true;
     recv_thread_ = std::thread([this]() {
+        std::vector<CanFrame> batch;
+        std::vector<uint32_t> annotations;
+        batch.reserve(kReceiveBatchSize);
+        bool backlog = false;
         while (recv_running_) {
-            if (!is_open_) {
+            if (!is_open_ || !attached_) {
                 std::this_thread::sleep_for(std::chrono::milliseconds(20));
                 continue;
             }
 
-            if (bustype_ == "busmust") {
-                auto channelHandle = static_cast<BM_ChannelHandle>(handle_);
-                if (!channelHandle) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
-                    continue;
-                }
-
-                if (notification_handle_) {
-                    BM_NotificationHandle handles[1] = { static_cast<BM_NotificationHandle>(notification_handle_) };
-                    int waitResult = BM_WaitForNotifications(handles, 1, 50);
-                    if (waitResult < 0) {
-                        continue;
-                    }
-                } else {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
-                }
-
-                while (recv_running_) {
-                    BM_CanMessageTypeDef msg = {};
-                    uint32_t channel = 0;
-                    uint32_t timestamp = 0;
-                    BM_StatusTypeDef status = BM_ReadCanMessage(channelHandle, &msg, &channel, &timestamp);
-                    if (status == BM_ERROR_OK) {
-                        if (tsfn_message_) {
-                            auto callback = [msg](Napi::Env env, Napi::Function jsCallback) {
-                                Napi::Object jsMsg = Napi::Object::New(env);
-                                bool extended = msg.ctrl.rx.IDE != 0;
-                                uint32_t canid = extended ? BM_GET_EXT_MSG_ID(msg.id) : BM_GET_STD_MSG_ID(msg.id);
-                                size_t dlc = std::min<size_t>(msg.ctrl.rx.DLC, 64);
-                                jsMsg.Set("id", Napi::Number::New(env, canid));
-                                jsMsg.Set("data", Napi::Buffer<uint8_t>::Copy(env, msg.payload, dlc));
-                                jsCallback.Call({jsMsg});
-                            };
-                            if (tsfn_message_.BlockingCall(callback) != napi_ok) {
-                                recv_running_ = false;
-                                break;
-                            }
-                        }
-                    } else if (status == BM_ERROR_QRCVEMPTY) {
-                        break;
-                    } else {
-                        EmitError(static_cast<int>(status), BusmustStatusToString(status));
+            // Frames are only read under the device lock; they are dispatched after it is released so a
+            // JS listener calling send() never waits on the watcher while the watcher waits on this thread.
+            int code = 0;
+            std::string error;
+            {
+                std::shared_lock<std::shared_mutex> deviceLock(device_mutex_);
+                if (!backlog && !WaitForFrames(50, code, error)) {
+                    deviceLock.unlock();
+                    if (!error.empty()) {
+                        EmitError(code, error);
                         std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                        break;
                     }
-                }
-            } else if (bustype_ == "pcan") {
-                if (pcan_handle_ == PCAN_NONEBUS) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
                     continue;
                 }
-                bool ready = (pcan_event_handle_ == nullptr && pcan_event_fd_ < 0);
+                batch.resize(kReceiveBatchSize);
+                size_t count = ReadFrames(batch.data(), batch.size(), code, error);
+                batch.resize(count);
+                backlog = (count == kReceiveBatchSize);
+            }
+            if (!error.empty()) {
+                EmitError(code, error);
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            RunStages(batch, annotations);
+            if (!DispatchFrames(batch, annotations)) {
+                recv_running_ = false;
+            }
+            if (bustype_ == "pcan" && !backlog) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        }
+    });
+}
+
+// Waits up to timeoutMs for the driver to signal received frames. Without a notification handle it
+// sleeps briefly and reports ready, which turns the caller into a poller. Called with the device lock held.
+bool CANBus::WaitForFrames(int timeoutMs, int& code, std::string& error) {
+    if (bustype_ == "busmust") {
+        if (!notification_handle_) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::min(timeoutMs, 5)));
+            return true;
+        }
+        BM_NotificationHandle handles[1] = { static_cast<BM_NotificationHandle>(notification_handle_) };
+        return BM_WaitForNotifications(handles, 1, timeoutMs) >= 0;
+    } else if (bustype_ == "pcan") {
+        if (pcan_event_handle_ == nullptr && pcan_event_fd_ < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::min(timeoutMs, 2)));
+            return true;
+        }
 #ifdef _WIN32
-                if (pcan_event_handle_) {
-                    HANDLE waitHandle = static_cast<HANDLE>(pcan_event_handle_);
-                    DWORD waitResult = WaitForSingleObject(waitHandle, 50);
-                    if (waitResult == WAIT_OBJECT_0) {
-                        ready = true;
-                    } else if (waitResult == WAIT_TIMEOUT) {
-                        ready = false;
-                    } else {
-                        DWORD lastError = (waitResult == WAIT_FAILED) ? GetLastError() : waitResult;
-                        EmitError(static_cast<int>(lastError), "PCAN receive event wait failed");
-                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                        ready = false;
-                    }
-                }
+        DWORD waitResult = WaitForSingleObject(static_cast<HANDLE>(pcan_event_handle_), static_cast<DWORD>(timeoutMs));
+        if (waitResult == WAIT_OBJECT_0) {
+            return true;
+        } else if (waitResult != WAIT_TIMEOUT) {
+            code = static_cast<int>((waitResult == WAIT_FAILED) ? GetLastError() : waitResult);
+            error = "PCAN receive event wait failed";
+        }
+        return false;
 #else
-                if (pcan_event_fd_ >= 0) {
-                    struct pollfd pfd;
-                    std::memset(&pfd, 0, sizeof(pfd));
-                    pfd.fd = pcan_event_fd_;
-                    pfd.events = POLLIN;
-                    int pollResult = poll(&pfd, 1, 50);
-                    if (pollResult > 0 && (pfd.revents & POLLIN) != 0) {
-                        ready = true;
-                    } else if (pollResult == 0 || (pollResult < 0 && errno == EINTR)) {
-                        ready = false;
-                    } else if (pollResult < 0) {
-                        EmitError(errno, "PCAN receive event poll failed");
-                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                        ready = false;
-                    }
-                }
+        struct pollfd pfd;
+        std::memset(&pfd, 0, sizeof(pfd));
+        pfd.fd = pcan_event_fd_;
+        pfd.events = POLLIN;
+        int pollResult = poll(&pfd, 1, timeoutMs);
+        if (pollResult > 0 && (pfd.revents & POLLIN) != 0) {
+            return true;
+        } else if (pollResult < 0 && errno != EINTR) {
+            code = errno;
+            error = "PCAN receive event poll failed";
+        }
+        return false;
 #endif
-                if (!ready) {
-                    continue;
-                }
+    } else if (tunnel_) {
+        return tunnel_->Wait(static_cast<uint8_t>(channel_), timeoutMs);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+    return false;
+}
 
-                while (recv_running_) {
-                    TPCANMsg msg = {};
-                    TPCANStatus status = CAN_Read(pcan_handle_, &msg, nullptr);
-                    if (status == PCAN_ERROR_OK) {
-                        if (tsfn_message_) {
-                            auto callback = [msg](Napi::Env env, Napi::Function jsCallback) {
-                                Napi::Object jsMsg = Napi::Object::New(env);
-                                bool extended = (msg.MSGTYPE & PCAN_MESSAGE_EXTENDED) != 0;
-                                uint32_t canid = msg.ID;
-                                if (!extended) {
-                                    canid &= 0x7FF;
-                                }
-                                size_t dlc = std::min<size_t>(msg.LEN, 8);
-                                jsMsg.Set("id", Napi::Number::New(env, canid));
-                                jsMsg.Set("data", Napi::Buffer<uint8_t>::Copy(env, msg.DATA, dlc));
-                                jsCallback.Call({jsMsg});
-                            };
-                            if (tsfn_message_.BlockingCall(callback) != napi_ok) {
-                                recv_running_ = false;
-                                break;
-                            }
-                        }
-                    } else if (status == PCAN_ERROR_QRCVEMPTY) {
-                        std::this_thread::sleep_for(std::chrono::milliseconds(2));
-                        break;
-                    } else {
-                        EmitError(static_cast<int>(status), PcanStatusToString(status));
-                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                        break;
-                    }
-                }
-            } else {
-                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+// Drains the driver queue without waiting until `max` frames that pass the filters are in `out`,
+// feeding every frame to the device clock estimate and the taps. Stops early and sets `error` on
+// anything but an empty queue. Called with the device lock held.
+size_t CANBus::ReadFrames(CanFrame* out, size_t max, int& code, std::string& error) {
+    RcuPtr<ReceivePipeline>::ReadGuard pipeline(pipeline_);
+    size_t count = 0;
+    if (bustype_ == "busmust") {
+        auto channelHandle = static_cast<BM_ChannelHandle>(handle_);
+        if (!channelHandle) {
+            return 0;
+        }
+        while (count < max) {
+            BM_CanMessageTypeDef msg = {};
+            uint32_t channel = 0;
+            uint32_t timestamp = 0;
+            BM_StatusTypeDef status = BM_ReadCanMessage(channelHandle, &msg, &channel, &timestamp);
+            if (status == BM_ERROR_QRCVEMPTY) {
+                break;
+            } else if (status != BM_ERROR_OK) {
+                code = static_cast<int>(status);
+                error = BusmustStatusToString(status);
+                break;
+            }
+            BusmustMessageToFrame(msg, channel, busmust_timestamps_.Extend(timestamp), out[count]);
+            if (IngestFrame(*pipeline, out[count])) {
+                ++count;
             }
         }
-    });
+    } else if (bustype_ == "pcan") {
+        if (pcan_handle_ == PCAN_NONEBUS) {
+            return 0;
+        }
+        while (count < max) {
+            TPCANMsg msg = {};
+            TPCANTimestamp timestamp = {};
+            TPCANStatus status = CAN_Read(pcan_handle_, &msg, &timestamp);
+            if (status == PCAN_ERROR_QRCVEMPTY) {
+                break;
+            } else if (status != PCAN_ERROR_OK) {
+                code = static_cast<int>(status);
+                error = PcanStatusToString(status);
+                break;
+            }
+            PcanMessageToFrame(msg, PcanTimestampToMicros(timestamp), out[count]);
+            if (IngestFrame(*pipeline, out[count])) {
+                ++count;
+            }
+        }
+    } else if (tunnel_) {
+        // Frames arrive already decoded, with the sender's timestamps; filtered ones are compacted out.
+        size_t read = tunnel_->Read(static_cast<uint8_t>(channel_), out, max);
+        for (size_t i = 0; i < read; ++i) {
+            if (IngestFrame(*pipeline, out[i])) {
+                out[count++] = out[i];
+            }
+        }
+    }
+    return count;
+}
+
+// Pull-mode receive for callers running their own loop: drains the driver queue straight into the
+// caller's buffer as frame records (see can_frame.h) on the calling thread, optionally waiting up to
+// timeoutMs for the first frame. Returns the number of records written.
+Napi::Value CANBus::ReadInto(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!is_open_) {
+        Napi::Error::New(env, "CANBus not open").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (recv_running_ || poller_.Running()) {
+        Napi::Error::New(env, "readInto cannot be used while message listeners, taps or stages are active").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    uint8_t* data = nullptr;
+    size_t byteLength = 0;
+    if (info.Length() > 0 && info[0].IsArrayBuffer()) {
+        Napi::ArrayBuffer buffer = info[0].As<Napi::ArrayBuffer>();
+        data = static_cast<uint8_t*>(buffer.Data());
+        byteLength = buffer.ByteLength();
+    } else if (info.Length() > 0 && info[0].IsTypedArray()) {
+        Napi::TypedArray view = info[0].As<Napi::TypedArray>();
+        data = static_cast<uint8_t*>(view.ArrayBuffer().Data()) + view.ByteOffset();
+        byteLength = view.ByteLength();
+    } else {
+        Napi::TypeError::New(env, "Expected ArrayBuffer or typed array").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (reinterpret_cast<uintptr_t>(data) % alignof(CanFrame) != 0) {
+        Napi::RangeError::New(env, "Buffer must be 8-byte aligned").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    size_t maxFrames = byteLength / kFrameRecordSize;
+    if (info.Length() > 1 && info[1].IsNumber()) {
+        maxFrames = std::min<size_t>(maxFrames, info[1].As<Napi::Number>().Uint32Value());
+    }
+    int timeoutMs = 0;
+    if (info.Length() > 2 && info[2].IsNumber()) {
+        timeoutMs = std::max(0, info[2].As<Napi::Number>().Int32Value());
+    }
+    if (maxFrames == 0) {
+        return Napi::Number::New(env, 0);
+    }
+
+    CanFrame* out = reinterpret_cast<CanFrame*>(data);
+    int code = 0;
+    std::string error;
+    size_t count = 0;
+    {
+        std::shared_lock<std::shared_mutex> deviceLock(device_mutex_);
+        if (!attached_) {
+            Napi::Error::New(env, "CANBus device detached").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        count = ReadFrames(out, maxFrames, code, error);
+        if (count == 0 && error.empty() && timeoutMs > 0 && WaitForFrames(timeoutMs, code, error)) {
+            count = ReadFrames(out, maxFrames, code, error);
+        }
+    }
+    if (count == 0 && !error.empty()) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    return Napi::Number::New(env, static_cast<double>(count));
+}
+
+// Tells the taps a batch is being queued for the JS thread. Returns the taps to tell about each
+// delivery; copied, as a listener may remove a tap while the batch is delivered.
+std::vector<std::shared_ptr<FrameTap>> CANBus::QueuedToTaps(const std::vector<CanFrame>& batch) {
+    RcuPtr<ReceivePipeline>::ReadGuard pipeline(pipeline_);
+    if (pipeline->taps.empty()) {
+        return {};
+    }
+    int64_t queuedUs = HostMicros();
+    for (const std::shared_ptr<FrameTap>& tap : pipeline->taps) {
+        for (const CanFrame& frame : batch) {
+            tap->OnQueued(frame, queuedUs);
+        }
+    }
+    return pipeline->taps;
+}
+
+void CANBus::DeliveredToTaps(const std::vector<std::shared_ptr<FrameTap>>& taps, const CanFrame& frame) {
+    if (taps.empty()) {
+        return;
+    }
+    int64_t deliveredUs = HostMicros();
+    for (const std::shared_ptr<FrameTap>& tap : taps) {
+        tap->OnDelivered(frame, deliveredUs);
+    }
+}
+
+// Hands a batch of received frames to the JS thread in a single call. Returns false once the
+// message listener is gone.
+bool CANBus::DispatchFrames(std::vector<CanFrame>& batch, std::vector<uint32_t>& annotations) {
+    if (batch.empty()) {
+        return true;
+    }
+    if (!tsfn_message_) {
+        batch.clear();
+        return true;
+    }
+    std::vector<std::shared_ptr<FrameTap>> taps = QueuedToTaps(batch);
+    auto callback = [frames = std::move(batch), annotations = std::move(annotations),
+                     taps = std::move(taps)](Napi::Env env, Napi::Function jsCallback) {
+        for (size_t i = 0; i < frames.size(); ++i) {
+            Napi::Object message = FrameToJs(env, frames[i]);
+            if (i < annotations.size() && annotations[i] != 0) {
+                message.Set("annotation", Napi::Number::New(env, annotations[i]));
+            }
+            DeliveredToTaps(taps, frames[i]);
+            jsCallback.Call({message});
+            if (env.IsExceptionPending()) {
+                break;
+            }
+        }
+    };
+    batch.clear();
+    annotations.clear();
+    batch.reserve(kReceiveBatchSize);
+    return tsfn_message_.BlockingCall(callback) == napi_ok;
 }
 
 void CANBus::StopReceiveThread() {
+    StopReceivePoll();
     recv_running_ = false;
 #ifdef _WIN32
     if (bustype_ == "pcan" && pcan_event_handle_) {
@@ -605,8 +1686,16 @@ void CANBus::StopReceiveThread() {
         tsfn_error_.Release();
         tsfn_error_ = nullptr;
     }
+    if (tsfn_attach_) {
+        tsfn_attach_.Release();
+        tsfn_attach_ = nullptr;
+    }
+    if (tsfn_detach_) {
+        tsfn_detach_.Release();
+        tsfn_detach_ = nullptr;
+    }
     if (tsfn_close_) {
-        tsfn_close_.BlockingCall([](Napi::Env env, Napi::Function jsCallback) {
+        tsfn_close_.BlockingCall([](Napi::Env, Napi::Function jsCallback) {
             jsCallback.Call({});
         });
         tsfn_close_.Release();
@@ -614,6 +1703,163 @@ void CANBus::StopReceiveThread() {
     }
 }
 
+// Replaces the acceptance filters for frames handed to JS ('message', readInto): an array of id/mask
+// filters, a filter expression string (see filter_program.h), or null / [] to pass everything.
+// Takes effect from the next batch the receive path reads, without pausing it.
+Napi::Value CANBus::SetFilters(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    std::vector<IdFilter> filters;
+    std::shared_ptr<const FilterProgram> expression;
+    if (info.Length() > 0 && info[0].IsString()) {
+        auto program = std::make_shared<FilterProgram>();
+        std::string error = FilterProgram::Compile(info[0].As<Napi::String>().Utf8Value(), *program);
+        if (!error.empty()) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        expression = std::move(program);
+    } else if (info.Length() > 0 && info[0].IsArray()) {
+        Napi::Array list = info[0].As<Napi::Array>();
+        for (uint32_t i = 0; i < list.Length(); ++i) {
+            Napi::Value entry = list.Get(i);
+            if (!entry.IsObject() || !entry.As<Napi::Object>().Get("id").IsNumber()) {
+                Napi::TypeError::New(env, "Each filter needs a numeric id").ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            Napi::Object options = entry.As<Napi::Object>();
+            IdFilter filter;
+            filter.id = options.Get("id").As<Napi::Number>().Uint32Value();
+            bool extended = false;
+            bool hasExtended = options.Has("extended") && !options.Get("extended").IsUndefined();
+            if (!GetOptionalUint32(options, "mask", filter.mask) || !GetOptionalBool(options, "extended", extended)) {
+                Napi::TypeError::New(env, "Invalid filter option type").ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            filter.extended = hasExtended ? (extended ? 1 : 0) : -1;
+            filters.push_back(filter);
+        }
+    } else if (info.Length() > 0 && !info[0].IsNull() && !info[0].IsUndefined()) {
+        Napi::TypeError::New(env, "Expected an array of filters, a filter expression or null")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    pipeline_.Update([&filters, &expression](ReceivePipeline& pipeline) {
+        pipeline.filters = std::move(filters);
+        pipeline.expression = std::move(expression);
+    });
+    return env.Undefined();
+}
+
+// Chooses how frames are received: 'thread' (default) reads on a native receive thread and hands
+// batches to JS through a thread-safe function; 'poll' registers the PCAN receive event fd with the
+// Node event loop and reads on the JS thread whenever it is readable, saving the thread and the
+// cross-thread hop per wake-up. Poll mode needs the POSIX PCAN event fd.
+Napi::Value CANBus::SetReceiveMode(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected 'thread' or 'poll'").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::string mode = info[0].As<Napi::String>();
+    if (mode != "thread" && mode != "poll") {
+        Napi::TypeError::New(env, "Expected 'thread' or 'poll'").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (recv_running_ || poller_.Running()) {
+        Napi::Error::New(env, "Receive mode cannot change while receiving").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (mode == "poll") {
+        std::shared_lock<std::shared_mutex> deviceLock(device_mutex_);
+        if (bustype_ != "pcan" || pcan_event_fd_ < 0) {
+            Napi::Error::New(env, "Poll receive mode requires a PCAN receive event fd").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+    }
+    poll_mode_ = (mode == "poll");
+    return env.Undefined();
+}
+
+// Poll receive runs entirely on the JS thread. The watcher swaps the device (and its fd) on its own
+// thread, so it only rearms poller_ and the fd is watched again here.
+void CANBus::StartReceivePoll() {
+    if (poller_.Running() || !is_open_) {
+        return;
+    }
+    Napi::Env env = Env();
+    uv_loop_t* loop = nullptr;
+    if (napi_get_uv_event_loop(env, &loop) != napi_ok || loop == nullptr) {
+        EmitError(-1, "Failed to get the event loop for poll receive");
+        return;
+    }
+    poll_context_ = std::make_unique<Napi::AsyncContext>(env, "CANBusReceivePoll");
+    poll_batch_.reserve(kReceiveBatchSize);
+    poller_.Start(loop);
+}
+
+void CANBus::StopReceivePoll() {
+    if (!poller_.Running()) {
+        return;
+    }
+    poller_.Stop();
+    poll_message_cb_.Reset();
+    poll_context_.reset();
+}
+
+// Poller hook: the receive event fd while the device is attached, -1 while it is not.
+int CANBus::PollFd() {
+    std::shared_lock<std::shared_mutex> deviceLock(device_mutex_);
+    return attached_ ? pcan_event_fd_ : -1;
+}
+
+// Reads at most one batch per wake-up; the fd stays readable while frames remain, so a busy bus
+// cannot starve the rest of the event loop.
+void CANBus::OnPollReadable(int status) {
+    if (status < 0) {
+        EmitError(status, std::string("PCAN receive event poll failed: ") + uv_strerror(status));
+        return;
+    }
+    int code = 0;
+    std::string error;
+    {
+        std::shared_lock<std::shared_mutex> deviceLock(device_mutex_);
+        if (!attached_) {
+            return;
+        }
+        poll_batch_.resize(kReceiveBatchSize);
+        poll_batch_.resize(ReadFrames(poll_batch_.data(), poll_batch_.size(), code, error));
+    }
+    if (!error.empty()) {
+        EmitError(code, error);
+    }
+    RunStages(poll_batch_, poll_annotations_);
+
+    std::vector<std::shared_ptr<FrameTap>> taps;
+    if (!poll_batch_.empty()) {
+        RcuPtr<ReceivePipeline>::ReadGuard pipeline(pipeline_);
+        taps = pipeline->taps;
+    }
+
+    Napi::Env env = Env();
+    Napi::HandleScope scope(env);
+    for (size_t i = 0; i < poll_batch_.size(); ++i) {
+        // A listener may close the bus, which releases the callback.
+        if (poll_message_cb_.IsEmpty()) {
+            break;
+        }
+        Napi::Object message = FrameToJs(env, poll_batch_[i]);
+        if (i < poll_annotations_.size() && poll_annotations_[i] != 0) {
+            message.Set("annotation", Napi::Number::New(env, poll_annotations_[i]));
+        }
+        DeliveredToTaps(taps, poll_batch_[i]);
+        poll_message_cb_.MakeCallback(env.Global(), {message}, *poll_context_);
+        if (env.IsExceptionPending()) {
+            napi_fatal_exception(env, env.GetAndClearPendingException().Value());
+            break;
+        }
+    }
+}
+
 void CANBus::EmitError(int code, const std::string& message) {
     if (!tsfn_error_) {
         return;
@@ -627,6 +1873,27 @@ void CANBus::EmitError(int code, const std::string& message) {
     tsfn_error_.BlockingCall(callback);
 }
 
+void CANBus::AttachPcanEvent() {
+#ifdef _WIN32
+    HANDLE eventHandle = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (eventHandle != nullptr) {
+        HANDLE value = eventHandle;
+        TPCANStatus eventStatus = CAN_SetValue(pcan_handle_, PCAN_RECEIVE_EVENT, &value, static_cast<DWORD>(sizeof(value)));
+        if (eventStatus == PCAN_ERROR_OK) {
+            pcan_event_handle_ = eventHandle;
+        } else {
+            CloseHandle(eventHandle);
+        }
+    }
+#else
+    int eventFd = -1;
+    TPCANStatus eventStatus = CAN_GetValue(pcan_handle_, PCAN_RECEIVE_EVENT, &eventFd, static_cast<DWORD>(sizeof(eventFd)));
+    if (eventStatus == PCAN_ERROR_OK && eventFd >= 0) {
+        pcan_event_fd_ = eventFd;
+    }
+#endif
+}
+
 void CANBus::DetachPcanEvent() {
 #ifdef _WIN32
     if (pcan_event_handle_) {
@@ -646,34 +1913,347 @@ void CANBus::DetachPcanEvent() {
 
 Napi::Value CANBus::Close(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
+    ShutdownWatcher();
+    StopWriterThread();
+    StopTimedThread();
     StopReceiveThread();
     if (!is_open_) {
         return env.Undefined();
     }
 
+    CloseDevice();
+    ReleaseBusmust();
+    is_open_ = false;
+    attached_ = false;
+    return env.Undefined();
+}
+
+Napi::Value CANBus::SetLogging(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!is_open_) {
+        Napi::Error::New(env, "CANBus not open").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::shared_lock<std::shared_mutex> deviceLock(device_mutex_);
+    if (!attached_) {
+        Napi::Error::New(env, "CANBus device detached").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected logging options object").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Napi::Object options = info[0].As<Napi::Object>();
+
     if (bustype_ == "busmust") {
-        if (handle_) {
-            BM_Close(static_cast<BM_ChannelHandle>(handle_));
-            handle_ = nullptr;
-        }
-        notification_handle_ = nullptr;
-        if (busmust_registered_) {
-            if (g_busmust_instance_count.fetch_sub(1) == 1) {
-                BM_UnInit();
-            }
-            busmust_registered_ = false;
-        }
+        return SetBusmustLogging(env, options);
     } else if (bustype_ == "pcan") {
-        DetachPcanEvent();
-        if (pcan_handle_ != PCAN_NONEBUS) {
-            CAN_Uninitialize(pcan_handle_);
-            pcan_handle_ = PCAN_NONEBUS;
+        return SetPcanLogging(env, options);
+    }
+    Napi::Error::New(env, "setLogging is not supported on bustype: " + bustype_).ThrowAsJavaScriptException();
+    return env.Undefined();
+}
+
+Napi::Value CANBus::SetBusmustLogging(Napi::Env env, const Napi::Object& options) {
+    if (!handle_) {
+        Napi::Error::New(env, "Busmust handle not open").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::string mode = "always";
+    std::string format = "pcap";
+    std::string direction = "all";
+    std::string pathMode = "index";
+    std::string path;
+    uint32_t channels = 1u << busmust_port_;
+    uint32_t maxFiles = 0;
+    uint32_t maxBytesPerFile = 0;
+    uint32_t maxSecondsPerFile = 0;
+    bool createNewFileOnStart = true;
+    bool overwriteOldFileOnFull = false;
+    bool persist = false;
+    if (!GetOptionalString(options, "mode", mode) || !GetOptionalString(options, "format", format) ||
+        !GetOptionalString(options, "direction", direction) || !GetOptionalString(options, "pathMode", pathMode) ||
+        !GetOptionalString(options, "path", path) || !GetOptionalUint32(options, "channels", channels) ||
+        !GetOptionalUint32(options, "maxFiles", maxFiles) || !GetOptionalUint32(options, "maxBytesPerFile", maxBytesPerFile) ||
+        !GetOptionalUint32(options, "maxSecondsPerFile", maxSecondsPerFile) ||
+        !GetOptionalBool(options, "createNewFileOnStart", createNewFileOnStart) ||
+        !GetOptionalBool(options, "overwriteOldFileOnFull", overwriteOldFileOnFull) ||
+        !GetOptionalBool(options, "persist", persist)) {
+        Napi::TypeError::New(env, "Invalid logging option type").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    BM_LoggingConfigTypeDef config = {};
+    config.version = 0x01;
+    if (!LookupNamedValue(kStorageModes, mode, config.mode)) {
+        Napi::TypeError::New(env, "Unsupported logging mode: " + mode).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (!LookupNamedValue(kStorageFormats, format, config.format)) {
+        Napi::TypeError::New(env, "Unsupported logging format: " + format).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (!LookupNamedValue(kStorageDirections, direction, config.direction)) {
+        Napi::TypeError::New(env, "Unsupported logging direction: " + direction).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (!LookupNamedValue(kStoragePathModes, pathMode, config.path.mode)) {
+        Napi::TypeError::New(env, "Unsupported logging pathMode: " + pathMode).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (path.size() >= sizeof(config.path.format)) {
+        Napi::RangeError::New(env, "Logging path pattern is too long").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::memcpy(config.path.format, path.data(), path.size());
+    config.channels = static_cast<uint16_t>(channels);
+    if (!ParseBusmustTrigger(options, "startTrigger", config.channels, config.starttrigger) ||
+        !ParseBusmustTrigger(options, "stopTrigger", config.channels, config.stoptrigger)) {
+        Napi::TypeError::New(env, "Invalid logging trigger").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    config.segmentation.createNewFileOnStart = createNewFileOnStart ? 1 : 0;
+    config.segmentation.overwriteOldFileOnFull = overwriteOldFileOnFull ? 1 : 0;
+    config.segmentation.nfiles = static_cast<uint16_t>(std::min<uint32_t>(maxFiles, 0xFFFF));
+    config.segmentation.nbytesPerFile = maxBytesPerFile;
+    config.segmentation.nsecondsPerFile = maxSecondsPerFile;
+
+    auto channelHandle = static_cast<BM_ChannelHandle>(handle_);
+    BM_StatusTypeDef status = BM_SetLogging(channelHandle, &config);
+    if (status != BM_ERROR_OK) {
+        Napi::Error::New(env, "BM_SetLogging failed: " + BusmustStatusToString(status)).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    const uint8_t* configBytes = reinterpret_cast<const uint8_t*>(&config);
+    busmust_logging_config_.assign(configBytes, configBytes + sizeof(config));
+    if (persist) {
+        status = BM_SaveConfig(channelHandle, channels);
+        if (status != BM_ERROR_OK) {
+            Napi::Error::New(env, "BM_SaveConfig failed: " + BusmustStatusToString(status)).ThrowAsJavaScriptException();
+            return env.Undefined();
         }
     }
-    is_open_ = false;
     return env.Undefined();
 }
 
+Napi::Value CANBus::GetLogging(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!is_open_) {
+        Napi::Error::New(env, "CANBus not open").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::shared_lock<std::shared_mutex> deviceLock(device_mutex_);
+    if (!attached_) {
+        Napi::Error::New(env, "CANBus device detached").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (bustype_ == "busmust") {
+        return GetBusmustLogging(env);
+    } else if (bustype_ == "pcan") {
+        return GetPcanLogging(env);
+    }
+    Napi::Error::New(env, "getLogging is not supported on bustype: " + bustype_).ThrowAsJavaScriptException();
+    return env.Undefined();
+}
+
+Napi::Value CANBus::GetBusmustLogging(Napi::Env env) {
+    if (!handle_) {
+        Napi::Error::New(env, "Busmust handle not open").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    BM_LoggingConfigTypeDef config = {};
+    BM_StatusTypeDef status = BM_GetLogging(static_cast<BM_ChannelHandle>(handle_), &config);
+    if (status != BM_ERROR_OK) {
+        Napi::Error::New(env, "BM_GetLogging failed: " + BusmustStatusToString(status)).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("mode", Napi::String::New(env, NameOfValue(kStorageModes, config.mode)));
+    result.Set("format", Napi::String::New(env, NameOfValue(kStorageFormats, config.format)));
+    result.Set("direction", Napi::String::New(env, NameOfValue(kStorageDirections, config.direction)));
+    result.Set("pathMode", Napi::String::New(env, NameOfValue(kStoragePathModes, config.path.mode)));
+    result.Set("path", Napi::String::New(env, std::string(config.path.format, strnlen(config.path.format, sizeof(config.path.format)))));
+    result.Set("channels", Napi::Number::New(env, config.channels));
+    result.Set("maxFiles", Napi::Number::New(env, config.segmentation.nfiles));
+    result.Set("maxBytesPerFile", Napi::Number::New(env, config.segmentation.nbytesPerFile));
+    result.Set("maxSecondsPerFile", Napi::Number::New(env, config.segmentation.nsecondsPerFile));
+    result.Set("createNewFileOnStart", Napi::Boolean::New(env, config.segmentation.createNewFileOnStart != 0));
+    result.Set("overwriteOldFileOnFull", Napi::Boolean::New(env, config.segmentation.overwriteOldFileOnFull != 0));
+    if (config.mode == BM_STORAGE_TRIGGERED) {
+        result.Set("startTrigger", BusmustTriggerToJs(env, config.starttrigger));
+        result.Set("stopTrigger", BusmustTriggerToJs(env, config.stoptrigger));
+    }
+    return result;
+}
+
+// PCAN-Basic writes .trc trace files itself; the configuration can only change while tracing is off.
+Napi::Value CANBus::SetPcanLogging(Napi::Env env, const Napi::Object& options) {
+    if (pcan_handle_ == PCAN_NONEBUS) {
+        Napi::Error::New(env, "PCAN channel not open").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::string mode = "always";
+    std::string format = "trc";
+    std::string pathMode = "index";
+    std::string path;
+    uint32_t maxBytesPerFile = 0;
+    bool overwriteOldFileOnFull = false;
+    if (!GetOptionalString(options, "mode", mode) || !GetOptionalString(options, "format", format) ||
+        !GetOptionalString(options, "pathMode", pathMode) || !GetOptionalString(options, "path", path) ||
+        !GetOptionalUint32(options, "maxBytesPerFile", maxBytesPerFile) ||
+        !GetOptionalBool(options, "overwriteOldFileOnFull", overwriteOldFileOnFull)) {
+        Napi::TypeError::New(env, "Invalid logging option type").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (mode != "always" && mode != "disabled") {
+        Napi::TypeError::New(env, "Unsupported PCAN logging mode: " + mode).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (format != "trc") {
+        Napi::TypeError::New(env, "PCAN tracing only writes the trc format").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    DWORD configure = 0;
+    if (pathMode == "fixed") {
+        configure = TRACE_FILE_SINGLE;
+    } else if (pathMode == "index") {
+        configure = TRACE_FILE_SEGMENTED;
+    } else if (pathMode == "time") {
+        configure = TRACE_FILE_SEGMENTED | TRACE_FILE_DATE | TRACE_FILE_TIME;
+    } else {
+        Napi::TypeError::New(env, "Unsupported logging pathMode: " + pathMode).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (overwriteOldFileOnFull) {
+        configure |= TRACE_FILE_OVERWRITE;
+    }
+    if (path.size() >= kPcanPathLength) {
+        Napi::RangeError::New(env, "Trace directory path is too long").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    PcanTraceSettings settings;
+    settings.enabled = (mode != "disabled");
+    settings.configure = configure;
+    settings.path = path;
+    if (maxBytesPerFile > 0) {
+        DWORD megabytes = (maxBytesPerFile + kPcanTraceSizeUnit - 1) / kPcanTraceSizeUnit;
+        settings.megabytes = std::min<DWORD>(std::max<DWORD>(megabytes, 1), kPcanTraceMaxSizeMb);
+    }
+    std::string error = ApplyPcanTrace(settings);
+    if (!error.empty()) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    pcan_trace_ = settings;
+    return env.Undefined();
+}
+
+std::string CANBus::ApplyPcanTrace(const PcanTraceSettings& settings) {
+    DWORD status = PCAN_PARAMETER_OFF;
+    TPCANStatus result = CAN_SetValue(pcan_handle_, PCAN_TRACE_STATUS, &status, static_cast<DWORD>(sizeof(status)));
+    if (result != PCAN_ERROR_OK) {
+        return "PCAN_TRACE_STATUS failed: " + PcanStatusToString(result);
+    }
+    if (!settings.enabled) {
+        return std::string();
+    }
+
+    if (!settings.path.empty()) {
+        char location[kPcanPathLength] = {0};
+        std::memcpy(location, settings.path.data(), std::min(settings.path.size(), kPcanPathLength - 1));
+        result = CAN_SetValue(pcan_handle_, PCAN_TRACE_LOCATION, location, static_cast<DWORD>(sizeof(location)));
+        if (result != PCAN_ERROR_OK) {
+            return "PCAN_TRACE_LOCATION failed: " + PcanStatusToString(result);
+        }
+    }
+    if (settings.megabytes > 0) {
+        DWORD megabytes = settings.megabytes;
+        result = CAN_SetValue(pcan_handle_, PCAN_TRACE_SIZE, &megabytes, static_cast<DWORD>(sizeof(megabytes)));
+        if (result != PCAN_ERROR_OK) {
+            return "PCAN_TRACE_SIZE failed: " + PcanStatusToString(result);
+        }
+    }
+    DWORD configure = settings.configure;
+    result = CAN_SetValue(pcan_handle_, PCAN_TRACE_CONFIGURE, &configure, static_cast<DWORD>(sizeof(configure)));
+    if (result != PCAN_ERROR_OK) {
+        return "PCAN_TRACE_CONFIGURE failed: " + PcanStatusToString(result);
+    }
+    status = PCAN_PARAMETER_ON;
+    result = CAN_SetValue(pcan_handle_, PCAN_TRACE_STATUS, &status, static_cast<DWORD>(sizeof(status)));
+    if (result != PCAN_ERROR_OK) {
+        return "PCAN_TRACE_STATUS failed: " + PcanStatusToString(result);
+    }
+    return std::string();
+}
+
+Napi::Value CANBus::GetPcanLogging(Napi::Env env) {
+    if (pcan_handle_ == PCAN_NONEBUS) {
+        Napi::Error::New(env, "PCAN channel not open").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    DWORD status = PCAN_PARAMETER_OFF;
+    DWORD megabytes = 0;
+    DWORD configure = 0;
+    char location[kPcanPathLength] = {0};
+    TPCANStatus result = CAN_GetValue(pcan_handle_, PCAN_TRACE_STATUS, &status, static_cast<DWORD>(sizeof(status)));
+    if (result == PCAN_ERROR_OK) {
+        result = CAN_GetValue(pcan_handle_, PCAN_TRACE_SIZE, &megabytes, static_cast<DWORD>(sizeof(megabytes)));
+    }
+    if (result == PCAN_ERROR_OK) {
+        result = CAN_GetValue(pcan_handle_, PCAN_TRACE_CONFIGURE, &configure, static_cast<DWORD>(sizeof(configure)));
+    }
+    if (result == PCAN_ERROR_OK) {
+        result = CAN_GetValue(pcan_handle_, PCAN_TRACE_LOCATION, location, static_cast<DWORD>(sizeof(location) - 1));
+    }
+    if (result != PCAN_ERROR_OK) {
+        Napi::Error::New(env, "CAN_GetValue failed: " + PcanStatusToString(result)).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    const char* pathMode = "fixed";
+    if ((configure & TRACE_FILE_SEGMENTED) != 0) {
+        pathMode = (configure & (TRACE_FILE_DATE | TRACE_FILE_TIME)) != 0 ? "time" : "index";
+    }
+    Napi::Object config = Napi::Object::New(env);
+    config.Set("mode", Napi::String::New(env, status == PCAN_PARAMETER_ON ? "always" : "disabled"));
+    config.Set("format", Napi::String::New(env, "trc"));
+    config.Set("pathMode", Napi::String::New(env, pathMode));
+    config.Set("path", Napi::String::New(env, location));
+    config.Set("maxBytesPerFile", Napi::Number::New(env, static_cast<double>(megabytes) * kPcanTraceSizeUnit));
+    config.Set("overwriteOldFileOnFull", Napi::Boolean::New(env, (configure & TRACE_FILE_OVERWRITE) != 0));
+    return config;
+}
+
+// Packet and loss counters of a 'udp' / 'tcp' bus's tunnel channel.
+Napi::Value CANBus::TunnelStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!IsTunnel()) {
+        Napi::Error::New(env, "tunnelStats is not supported on bustype: " + bustype_).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::shared_lock<std::shared_mutex> deviceLock(device_mutex_);
+    if (!tunnel_) {
+        Napi::Error::New(env, "CANBus not open").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    TunnelLink::Stats stats = tunnel_->GetStats(static_cast<uint8_t>(channel_));
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("packets", Napi::Number::New(env, static_cast<double>(stats.packets)));
+    result.Set("frames", Napi::Number::New(env, static_cast<double>(stats.frames)));
+    result.Set("lost", Napi::Number::New(env, static_cast<double>(stats.lost)));
+    result.Set("late", Napi::Number::New(env, static_cast<double>(stats.late)));
+    result.Set("dropped", Napi::Number::New(env, static_cast<double>(stats.dropped)));
+    result.Set("sent", Napi::Number::New(env, static_cast<double>(stats.sent)));
+    result.Set("connected", Napi::Boolean::New(env, stats.connected));
+    return result;
+}
+
 Napi::Value CANBus::IsAvailable(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     if (info.Length() < 1) {
@@ -687,12 +2267,28 @@ Napi::Value CANBus::IsAvailable(const Napi::CallbackInfo& info) {
     if (bustype == "busust") {
         bustype = "busmust";
     }
-    bool available = (bustype == "busmust" || bustype == "pcan");
+    bool available = (bustype == "busmust" || bustype == "pcan" || bustype == "udp" || bustype == "tcp");
     return Napi::Boolean::New(env, available);
 }
 
 Napi::Object InitAll(Napi::Env env, Napi::Object exports) {
-    return CANBus::Init(env, exports);
+    CANBus::Init(env, exports);
+    LatencyProbe::Init(env, exports);
+    RedundantBus::Init(env, exports);
+    IsoTp::Init(env, exports);
+    SignalDatabase::Init(env, exports);
+    SignalDecoder::Init(env, exports);
+    ReceivePlugin::Init(env, exports);
+    Nmea2000Receiver::Init(env, exports);
+    DiagnosticRunner::Init(env, exports);
+    Flasher::Init(env, exports);
+    DiagnosticScanner::Init(env, exports);
+    CanTunnel::Init(env, exports);
+    FrameStreamServer::Init(env, exports);
+    DoipGateway::Init(env, exports);
+    BatchEncoder::Init(env, exports);
+    SignalHistory::Init(env, exports);
+    return LogReader::Init(env, exports);
 }
 
 NODE_API_MODULE(ace_can, InitAll)
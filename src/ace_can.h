@@ -5,9 +5,42 @@
 #include <string>
 #include <thread>
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <shared_mutex>
+#include <vector>
 
-class CANBus : public Napi::ObjectWrap<CANBus> {
+#include "can_frame.h"
+#include "device_watcher.h"
+#include "frame_stage.h"
+#include "frame_tap.h"
+#include "rcu.h"
+#include "receive_pipeline.h"
+#include "receive_poller.h"
+#include "session_bus.h"
+#include "timed_tx.h"
+#include "tunnel.h"
+#include "tx_shaper.h"
+
+// Per-environment addon state, so worker threads each get their own constructor references. Set up
+// by CANBus::Init; other classes add the constructors they check instances against.
+struct AddonData {
+    Napi::FunctionReference can_bus;
+    Napi::FunctionReference signal_database;
+    Napi::FunctionReference signal_decoder;
+};
+
+// Converts a frame to the {id, data, timestamp} message object handed to 'message' listeners.
+Napi::Object FrameToJs(Napi::Env env, const CanFrame& frame);
+// Reads a {id, data} message object, keeping at most maxLength data bytes; returns a TypeError message on failure.
+std::string JsToFrame(const Napi::Value& value, size_t maxLength, CanFrame& frame);
+
+class CANBus : public Napi::ObjectWrap<CANBus>, public SessionBus {
 public:
     static Napi::Object Init(Napi::Env env, Napi::Object exports);
     CANBus(const Napi::CallbackInfo& info);
@@ -16,9 +49,32 @@ public:
     Napi::Value Send(const Napi::CallbackInfo& info);
     Napi::Value On(const Napi::CallbackInfo& info);
     Napi::Value Close(const Napi::CallbackInfo& info);
+    Napi::Value SetLogging(const Napi::CallbackInfo& info);
+    Napi::Value GetLogging(const Napi::CallbackInfo& info);
+    Napi::Value StartWatcher(const Napi::CallbackInfo& info);
+    Napi::Value StopWatcher(const Napi::CallbackInfo& info);
+    Napi::Value SetTxShaping(const Napi::CallbackInfo& info);
+    Napi::Value SendAt(const Napi::CallbackInfo& info);
+    Napi::Value Now(const Napi::CallbackInfo& info);
+    Napi::Value ReadInto(const Napi::CallbackInfo& info);
+    Napi::Value SetReceiveMode(const Napi::CallbackInfo& info);
+    Napi::Value SetFilters(const Napi::CallbackInfo& info);
+    Napi::Value TunnelStats(const Napi::CallbackInfo& info);
 
     static Napi::Value IsAvailable(const Napi::CallbackInfo& info);
 
+    // Native access for other addon classes, from the JS thread. FromValue returns nullptr for anything but a CANBus.
+    static CANBus* FromValue(Napi::Env env, const Napi::Value& value);
+    void AddTap(std::shared_ptr<FrameTap> tap) override;
+    void RemoveTap(const FrameTap* tap) override;
+    void AddStage(std::shared_ptr<FrameStage> stage);
+    void RemoveStage(const FrameStage* stage);
+    std::string Transmit(const CanFrame& frame) override;
+    std::string TransmitRaw(const CanFrame& frame);
+    bool DeviceToHost(uint64_t deviceUs, int64_t& hostUs) const;
+    int Bitrate() const { return bitrate_; }
+    size_t MaxDataLength() const { return bustype_ == "pcan" ? 8 : 64; }
+
 private:
     std::string bustype_;
     int channel_;
@@ -30,18 +86,129 @@ private:
     int pcan_event_fd_ = -1; // File descriptor for PCAN receive event (POSIX)
     bool is_open_ = false;
     bool busmust_registered_ = false;
+    uint16_t busmust_port_ = 0; // Port of the opened channel on its Busmust device
+    TimestampUnwrapper busmust_timestamps_; // Busmust timestamps are 32-bit
+    std::string busmust_serial_; // Serial of the opened Busmust device, used to find it again
+    bool pcan_identity_known_ = false;
+    uint8_t pcan_device_type_ = 0;
+    uint32_t pcan_device_id_ = 0;
+    uint8_t pcan_controller_ = 0;
+    std::shared_ptr<TunnelLink> tunnel_; // bustype 'udp' / 'tcp'; channel_ is the tunnel channel
+    std::string tunnel_host_ = "0.0.0.0";
+    uint16_t tunnel_port_ = 0;
+    bool IsTunnel() const { return bustype_ == "udp" || bustype_ == "tcp"; }
+
+    // Settings re-applied when the device comes back after a detach.
+    struct PcanTraceSettings {
+        bool enabled = false;
+        uint32_t configure = 0;
+        uint32_t megabytes = 0;
+        std::string path;
+    };
+    std::vector<uint8_t> busmust_logging_config_; // Last BM_LoggingConfigTypeDef applied
+    PcanTraceSettings pcan_trace_;
+    uint32_t pcan_interframe_delay_us_ = 0;
+
+    // --- 设备热插拔 ---
+    std::string OpenDevice();
+    std::string OpenBusmust();
+    std::string OpenPcan();
+    std::string OpenTunnel();
+    void CloseDevice();
+    void ReleaseBusmust();
+    std::string ApplyChannelSettings();
+    std::string ApplyPcanTrace(const PcanTraceSettings& settings);
+    std::string DeviceSerial() const;
+    void ShutdownWatcher();
+    bool ProbeDevice();
+    void DetachDevice();
+    bool ReattachDevice(int64_t downMs);
+    void EmitDeviceEvent(Napi::ThreadSafeFunction& tsfn, int64_t recoveryMs);
+
+    // --- 发送整形 ---
+    std::string WriteFrame(const CanFrame& frame, int& code);
+    std::string ApplyPcanInterframeDelay();
+    bool QueueShaped(const CanFrame& frame, std::string& error);
+    void StartWriterThread();
+    void StopWriterThread();
+    void WriteLoop();
+
+    std::shared_mutex device_mutex_; // Shared for I/O on the channel, exclusive while the watcher swaps it
+    std::atomic<bool> attached_{false};
+    std::unique_ptr<DeviceWatcher> watcher_; // Created by the first startWatcher()
+
+    TxShaper tx_shaper_;
+    std::deque<CanFrame> tx_queue_; // Frames waiting for the writer thread, guarded by tx_mutex_
+    std::thread tx_thread_;
+    std::mutex tx_mutex_;
+    std::condition_variable tx_cv_;
+    bool tx_running_ = false;
+
+    // --- 定时发送 ---
+    struct TimedFrame {
+        int64_t due_us; // host clock
+        uint64_t sequence;
+        bool device_clock;
+        CanFrame frame;
+        std::shared_ptr<Napi::Promise::Deferred> deferred;
+        bool operator>(const TimedFrame& other) const {
+            return due_us != other.due_us ? due_us > other.due_us : sequence > other.sequence;
+        }
+    };
+    void StartTimedThread(Napi::Env env);
+    void StopTimedThread();
+    void TimedLoop();
+
+    DeviceClock device_clock_;
+    std::priority_queue<TimedFrame, std::vector<TimedFrame>, std::greater<TimedFrame>> timed_queue_;
+    uint64_t timed_sequence_ = 0;
+    std::thread timed_thread_;
+    std::mutex timed_mutex_;
+    std::condition_variable timed_cv_;
+    bool timed_running_ = false;
+    Napi::ThreadSafeFunction tsfn_timed_;
 
     // --- 事件接收相关 ---
     void StartReceiveThread();
     void StopReceiveThread();
+    bool WaitForFrames(int timeoutMs, int& code, std::string& error);
+    size_t ReadFrames(CanFrame* out, size_t max, int& code, std::string& error);
+    void RunStages(std::vector<CanFrame>& batch, std::vector<uint32_t>& annotations);
+    bool DispatchFrames(std::vector<CanFrame>& batch, std::vector<uint32_t>& annotations);
+    std::vector<std::shared_ptr<FrameTap>> QueuedToTaps(const std::vector<CanFrame>& batch);
+    static void DeliveredToTaps(const std::vector<std::shared_ptr<FrameTap>>& taps, const CanFrame& frame);
     void EmitError(int code, const std::string& message);
+    void AttachPcanEvent();
     void DetachPcanEvent();
+    Napi::Value SetBusmustLogging(Napi::Env env, const Napi::Object& options);
+    Napi::Value GetBusmustLogging(Napi::Env env);
+    Napi::Value SetPcanLogging(Napi::Env env, const Napi::Object& options);
+    Napi::Value GetPcanLogging(Napi::Env env);
+
+    bool IngestFrame(const ReceivePipeline& pipeline, const CanFrame& frame);
+
+    // --- 事件循环轮询接收 ---
+    void StartReceivePoll();
+    void StopReceivePoll();
+    int PollFd();
+    void OnPollReadable(int status);
+
+    RcuPtr<ReceivePipeline> pipeline_; // Filters, taps and stages, swapped without stopping the receive path
 
     std::thread recv_thread_;
     std::atomic<bool> recv_running_{false};
     Napi::ThreadSafeFunction tsfn_message_;
+    bool poll_mode_ = false; // Receive on the JS thread through the event loop instead of recv_thread_
+    // Watches pcan_event_fd_ while poll receive is active; rearmed by the watcher.
+    ReceivePoller poller_{{[this]() { return PollFd(); }, [this](int status) { OnPollReadable(status); }}};
+    std::unique_ptr<Napi::AsyncContext> poll_context_;
+    Napi::FunctionReference poll_message_cb_;
+    std::vector<CanFrame> poll_batch_;
+    std::vector<uint32_t> poll_annotations_;
     Napi::ThreadSafeFunction tsfn_error_;
     Napi::ThreadSafeFunction tsfn_close_;
+    Napi::ThreadSafeFunction tsfn_attach_;
+    Napi::ThreadSafeFunction tsfn_detach_;
 };
 
 #endif // ACE_CAN_H
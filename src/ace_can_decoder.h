@@ -0,0 +1,67 @@
+#ifndef ACE_CAN_DECODER_H
+#define ACE_CAN_DECODER_H
+
+/*
+ * C ABI of compiled signal decoder plugins. SignalDatabase.generateDecoder() emits a C++ source
+ * file implementing it for one database; built as a shared library, SignalDecoder loads it and
+ * calls decode() on the receive thread for every frame.
+ *
+ * Signals are numbered globally, in message order: message i owns signals
+ * [first_signal, first_signal + signal_count).
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ACE_CAN_DECODER_ABI_VERSION 1
+#define ACE_CAN_DECODER_ENTRY "ace_can_decoder_v1"
+
+#if defined(_WIN32)
+#define ACE_CAN_DECODER_EXPORT __declspec(dllexport)
+#else
+#define ACE_CAN_DECODER_EXPORT __attribute__((visibility("default")))
+#endif
+
+/* Receives one physical value; `signal` is the global signal index. */
+typedef void (*ace_can_signal_sink)(void* context, uint32_t signal, double value);
+
+typedef struct ace_can_decoder_message {
+    const char* name;
+    uint32_t id;
+    uint8_t extended;
+    uint8_t fd;
+    uint16_t length;
+    uint32_t first_signal;
+    uint32_t signal_count;
+} ace_can_decoder_message;
+
+typedef struct ace_can_decoder {
+    uint32_t abi_version; /* ACE_CAN_DECODER_ABI_VERSION */
+    uint32_t message_count;
+    const ace_can_decoder_message* messages;
+    uint32_t signal_count;
+    const char* const* signal_names; /* by global index, without the message name */
+
+    /* Calls sink for every signal present in the payload (multiplexed signals only when selected).
+     * Returns the number of values emitted, or -1 if the ID is not in the database. Must be
+     * thread-safe and must not block. */
+    int32_t (*decode)(uint32_t id, uint8_t extended, const uint8_t* data, uint32_t length, ace_can_signal_sink sink,
+                      void* context);
+
+    /* Encodes message `message` (index into messages) from values[0..signal_count) of that
+     * message; NaN leaves a signal's bits zero. Returns the payload length, or -1 if `message` is
+     * out of range or capacity is too small. */
+    int32_t (*encode)(uint32_t message, const double* values, uint8_t* data, uint32_t capacity);
+} ace_can_decoder;
+
+/* Exported as ACE_CAN_DECODER_ENTRY. */
+typedef const ace_can_decoder* (*ace_can_decoder_entry)(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ACE_CAN_DECODER_H */
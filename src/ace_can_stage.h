@@ -0,0 +1,86 @@
+#ifndef ACE_CAN_STAGE_H
+#define ACE_CAN_STAGE_H
+
+/*
+ * C ABI of receive-stage plugins. A stage is a shared library loaded by ReceivePlugin; it is handed
+ * every batch of received frames that passed the CANBus filters, on the receive thread (the JS
+ * thread in poll receive mode) and before the batch is handed to JS. It may rewrite and drop
+ * frames, annotate them, append derived frames and emit results to its JS listeners.
+ *
+ * Stages run one after another in the order they were added; each sees the previous one's output.
+ * process() must not block: the receive path, and every other stage on the bus, waits for it.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ACE_CAN_STAGE_ABI_VERSION 1
+#define ACE_CAN_STAGE_ENTRY "ace_can_stage_v1"
+
+#if defined(_WIN32)
+#define ACE_CAN_STAGE_EXPORT __declspec(dllexport)
+#else
+#define ACE_CAN_STAGE_EXPORT __attribute__((visibility("default")))
+#endif
+
+/* ace_can_frame.flags */
+#define ACE_CAN_FLAG_EXTENDED 0x01
+#define ACE_CAN_FLAG_REMOTE 0x02
+#define ACE_CAN_FLAG_FD 0x04
+#define ACE_CAN_FLAG_BRS 0x08
+#define ACE_CAN_FLAG_ESI 0x10
+#define ACE_CAN_FLAG_TX 0x20
+#define ACE_CAN_FLAG_ERROR 0x40
+
+/* Same layout as the 80-byte frame batch record. */
+typedef struct ace_can_frame {
+    uint64_t timestamp; /* microseconds, device clock */
+    uint32_t id;
+    uint8_t flags;
+    uint8_t length; /* bytes of data */
+    uint16_t channel;
+    uint8_t data[64];
+} ace_can_frame;
+
+/*
+ * frames[0..count) is the batch, annotations[i] belongs to frames[i] (0 = none; anything else is
+ * delivered to JS as message.annotation). To drop frames, compact both arrays and lower count; to
+ * add derived frames, write them (and their annotations) after the last one and raise count, up to
+ * capacity.
+ */
+typedef struct ace_can_batch {
+    ace_can_frame* frames;
+    uint32_t* annotations;
+    uint32_t count;
+    uint32_t capacity;
+} ace_can_batch;
+
+typedef struct ace_can_stage_host {
+    void* context;
+    /* Queues a result for the stage's 'result' listeners as { tag, data }; data is copied. Only
+     * valid during process(); results are delivered to JS once process() returns. */
+    void (*emit)(void* context, uint32_t tag, const void* data, uint32_t length);
+} ace_can_stage_host;
+
+typedef struct ace_can_stage {
+    uint32_t abi_version; /* ACE_CAN_STAGE_ABI_VERSION */
+    const char* name;
+
+    /* Creates one instance; `config` is the string given to ReceivePlugin (empty if none). `host`
+     * stays valid until destroy(). Returns NULL on failure, with a message in error[error_size]. */
+    void* (*create)(const char* config, const ace_can_stage_host* host, char* error, uint32_t error_size);
+    void (*process)(void* instance, ace_can_batch* batch);
+    void (*destroy)(void* instance);
+} ace_can_stage;
+
+/* Exported as ACE_CAN_STAGE_ENTRY. */
+typedef const ace_can_stage* (*ace_can_stage_entry)(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ACE_CAN_STAGE_H */
@@ -0,0 +1,1043 @@
+#include "decode_tables.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+namespace {
+
+constexpr size_t kReadBufferSize = 1 << 20;
+
+bool IsSpace(int c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+void AppendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+// Pull tokenizer for the XML subset ARXML uses: elements, attributes (skipped), text, entity and
+// character references, CDATA, comments, processing instructions and a DOCTYPE without an
+// internal subset. Reads the file through one fixed buffer.
+class XmlReader {
+public:
+    enum class Event { StartElement, EndElement, Text, End, Error };
+
+    explicit XmlReader(std::FILE* file) : file_(file), buffer_(kReadBufferSize) {}
+
+    Event Next();
+    // Element name for StartElement/EndElement, character data for Text.
+    const std::string& Name() const { return name_; }
+    const std::string& Text() const { return text_; }
+    const std::string& Error() const { return error_; }
+
+private:
+    int Peek() {
+        if (pos_ == len_ && !Fill()) {
+            return -1;
+        }
+        return static_cast<unsigned char>(buffer_[pos_]);
+    }
+    int Get() {
+        int c = Peek();
+        if (c >= 0) {
+            ++pos_;
+        }
+        return c;
+    }
+    bool Fill() {
+        pos_ = 0;
+        len_ = std::fread(buffer_.data(), 1, buffer_.size(), file_);
+        return len_ > 0;
+    }
+    // Consumes characters up to (not including) the first one matching `stop`, appending them to
+    // `out` when given. Scans whole runs of the buffer at a time; false at end of file.
+    template <typename Stop>
+    bool ReadUntil(std::string* out, Stop stop) {
+        while (pos_ < len_ || Fill()) {
+            const char* begin = buffer_.data() + pos_;
+            const char* end = buffer_.data() + len_;
+            const char* p = begin;
+            while (p < end && !stop(*p)) {
+                ++p;
+            }
+            if (out != nullptr) {
+                out->append(begin, p);
+            }
+            if (p > begin) {
+                last_ = static_cast<unsigned char>(p[-1]);
+            }
+            pos_ += static_cast<size_t>(p - begin);
+            if (p < end) {
+                return true;
+            }
+        }
+        return false;
+    }
+    bool SkipPast(const char* terminator);
+    bool ReadCdata();
+    bool AppendReference(std::string& out);
+    Event Fail(const char* message) {
+        error_ = message;
+        return Event::Error;
+    }
+
+    std::FILE* file_;
+    std::vector<char> buffer_;
+    size_t pos_ = 0;
+    size_t len_ = 0;
+    std::string name_;
+    std::string text_;
+    std::string error_;
+    bool pending_end_ = false;
+    int last_ = 0; // last character consumed by ReadUntil
+};
+
+XmlReader::Event XmlReader::Next() {
+    if (pending_end_) {
+        // Second half of a self-closing tag; name_ still holds the element name.
+        pending_end_ = false;
+        return Event::EndElement;
+    }
+    for (;;) {
+        int c = Peek();
+        if (c < 0) {
+            return Event::End;
+        }
+        if (c != '<') {
+            text_.clear();
+            bool blank = true;
+            while ((c = Peek()) >= 0 && c != '<') {
+                if (c == '&') {
+                    ++pos_;
+                    if (!AppendReference(text_)) {
+                        return Fail("Invalid entity reference");
+                    }
+                    blank = false;
+                    continue;
+                }
+                size_t start = text_.size();
+                ReadUntil(&text_, [](char ch) { return ch == '<' || ch == '&'; });
+                for (size_t i = start; blank && i < text_.size(); ++i) {
+                    blank = IsSpace(text_[i]);
+                }
+            }
+            if (!blank) {
+                return Event::Text;
+            }
+            continue;
+        }
+
+        ++pos_;
+        c = Get();
+        if (c == '?') {
+            if (!SkipPast("?>")) {
+                return Fail("Unterminated processing instruction");
+            }
+            continue;
+        }
+        if (c == '!') {
+            if (Peek() == '-') {
+                if (!SkipPast("-->")) {
+                    return Fail("Unterminated comment");
+                }
+                continue;
+            }
+            if (Peek() == '[') {
+                if (!ReadCdata()) {
+                    return Fail("Unterminated CDATA section");
+                }
+                return Event::Text;
+            }
+            if (!SkipPast(">")) {
+                return Fail("Unterminated declaration");
+            }
+            continue;
+        }
+        if (c == '/') {
+            name_.clear();
+            if (!ReadUntil(&name_, [](char ch) { return ch == '>' || IsSpace(ch); }) ||
+                !ReadUntil(nullptr, [](char ch) { return ch == '>'; })) {
+                return Fail("Unterminated end tag");
+            }
+            ++pos_;
+            return Event::EndElement;
+        }
+        if (c < 0) {
+            return Fail("Unexpected end of file");
+        }
+
+        name_.assign(1, static_cast<char>(c));
+        if (!ReadUntil(&name_, [](char ch) { return ch == '>' || ch == '/' || IsSpace(ch); })) {
+            return Fail("Unterminated start tag");
+        }
+        // Attributes are skipped; only a '/' right before the closing '>' matters.
+        last_ = 0;
+        for (;;) {
+            if (!ReadUntil(nullptr, [](char ch) { return ch == '>' || ch == '"' || ch == '\''; })) {
+                return Fail("Unterminated start tag");
+            }
+            int quote = Get();
+            if (quote == '>') {
+                break;
+            }
+            if (!ReadUntil(nullptr, [quote](char ch) { return ch == quote; })) {
+                return Fail("Unterminated attribute value");
+            }
+            last_ = Get();
+        }
+        pending_end_ = last_ == '/';
+        return Event::StartElement;
+    }
+}
+
+bool XmlReader::SkipPast(const char* terminator) {
+    size_t length = std::strlen(terminator); // at most 3
+    char window[3] = {};
+    size_t seen = 0;
+    int c = 0;
+    while ((c = Get()) >= 0) {
+        std::memmove(window, window + 1, length - 1);
+        window[length - 1] = static_cast<char>(c);
+        if (++seen >= length && std::memcmp(window, terminator, length) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// After "<!": reads "[CDATA[...]]>" into text_.
+bool XmlReader::ReadCdata() {
+    static const char kOpen[] = "[CDATA[";
+    for (const char* p = kOpen; *p != '\0'; ++p) {
+        if (Get() != *p) {
+            return false;
+        }
+    }
+    text_.clear();
+    int c = 0;
+    while ((c = Get()) >= 0) {
+        text_.push_back(static_cast<char>(c));
+        size_t n = text_.size();
+        if (n >= 3 && text_[n - 1] == '>' && text_[n - 2] == ']' && text_[n - 3] == ']') {
+            text_.resize(n - 3);
+            return true;
+        }
+    }
+    return false;
+}
+
+// After '&': appends the referenced character.
+bool XmlReader::AppendReference(std::string& out) {
+    char name[12] = {};
+    size_t length = 0;
+    int c = 0;
+    while ((c = Get()) >= 0 && c != ';') {
+        if (length + 1 >= sizeof(name)) {
+            return false;
+        }
+        name[length++] = static_cast<char>(c);
+    }
+    if (c < 0 || length == 0) {
+        return false;
+    }
+    if (name[0] == '#') {
+        bool hex = name[1] == 'x' || name[1] == 'X';
+        char* end = nullptr;
+        unsigned long cp = std::strtoul(name + (hex ? 2 : 1), &end, hex ? 16 : 10);
+        if (*end != '\0' || cp > 0x10FFFF) {
+            return false;
+        }
+        AppendUtf8(out, static_cast<uint32_t>(cp));
+        return true;
+    }
+    static const struct {
+        const char* name;
+        char value;
+    } kEntities[] = {{"lt", '<'}, {"gt", '>'}, {"amp", '&'}, {"quot", '"'}, {"apos", '\''}};
+    for (const auto& entity : kEntities) {
+        if (std::strcmp(name, entity.name) == 0) {
+            out.push_back(entity.value);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Elements the importer looks at. Entities (up to kLastEntity) are the elements whose leaves are
+// collected into a record; the rest are leaves.
+enum class Tag : uint8_t {
+    Other,
+    CanFrameTriggering,
+    CanFrame,
+    PduToFrameMapping,
+    ISignalIPdu,
+    SecuredIPdu,
+    ISignalToIPduMapping,
+    ISignal,
+    SystemSignal,
+    CompuMethod,
+    CompuScale,
+    CompuNumerator,
+    CompuDenominator,
+    Unit,
+    SwBaseType,
+    PduTriggering,
+    EndToEndProtection,
+    AuthenticationProps,
+    FreshnessProps,
+    SecureCommunicationProps,
+    kLastEntity = SecureCommunicationProps,
+    ShortName,
+    CompuInternalToPhys,
+    Identifier,
+    CanAddressingMode,
+    CanFrameRxBehavior,
+    CanFrameTxBehavior,
+    FrameRef,
+    FrameLength,
+    PduRef,
+    PackingByteOrder,
+    StartPosition,
+    Length,
+    ISignalRef,
+    SystemSignalRef,
+    CompuMethodRef,
+    BaseTypeRef,
+    UnitRef,
+    Category,
+    V,
+    LowerLimit,
+    UpperLimit,
+    BaseTypeEncoding,
+    DisplayName,
+    DataId,
+    DataLength,
+    CrcOffset,
+    CounterOffset,
+    ISignalIPduRef,
+    IPduRef,
+    PayloadRef,
+    AuthenticationPropsRef,
+    FreshnessPropsRef,
+    AuthInfoTxLength,
+    FreshnessValueTxLength,
+    AuthAlgorithm,
+};
+
+Tag LookupTag(const std::string& name) {
+    static const std::unordered_map<std::string_view, Tag> kTags = {
+        {"CAN-FRAME-TRIGGERING", Tag::CanFrameTriggering},
+        {"CAN-FRAME", Tag::CanFrame},
+        {"PDU-TO-FRAME-MAPPING", Tag::PduToFrameMapping},
+        {"I-SIGNAL-I-PDU", Tag::ISignalIPdu},
+        {"SECURED-I-PDU", Tag::SecuredIPdu},
+        {"I-SIGNAL-TO-I-PDU-MAPPING", Tag::ISignalToIPduMapping},
+        {"I-SIGNAL", Tag::ISignal},
+        {"SYSTEM-SIGNAL", Tag::SystemSignal},
+        {"COMPU-METHOD", Tag::CompuMethod},
+        {"COMPU-SCALE", Tag::CompuScale},
+        {"COMPU-NUMERATOR", Tag::CompuNumerator},
+        {"COMPU-DENOMINATOR", Tag::CompuDenominator},
+        {"UNIT", Tag::Unit},
+        {"SW-BASE-TYPE", Tag::SwBaseType},
+        {"PDU-TRIGGERING", Tag::PduTriggering},
+        {"END-TO-END-PROTECTION", Tag::EndToEndProtection},
+        {"SECURE-COMMUNICATION-AUTHENTICATION-PROPS", Tag::AuthenticationProps},
+        {"SECURE-COMMUNICATION-FRESHNESS-PROPS", Tag::FreshnessProps},
+        {"SECURE-COMMUNICATION-PROPS", Tag::SecureCommunicationProps},
+        {"SHORT-NAME", Tag::ShortName},
+        {"COMPU-INTERNAL-TO-PHYS", Tag::CompuInternalToPhys},
+        {"IDENTIFIER", Tag::Identifier},
+        {"CAN-ADDRESSING-MODE", Tag::CanAddressingMode},
+        {"CAN-FRAME-RX-BEHAVIOR", Tag::CanFrameRxBehavior},
+        {"CAN-FRAME-TX-BEHAVIOR", Tag::CanFrameTxBehavior},
+        {"FRAME-REF", Tag::FrameRef},
+        {"FRAME-LENGTH", Tag::FrameLength},
+        {"PDU-REF", Tag::PduRef},
+        {"PACKING-BYTE-ORDER", Tag::PackingByteOrder},
+        {"START-POSITION", Tag::StartPosition},
+        {"LENGTH", Tag::Length},
+        {"I-SIGNAL-REF", Tag::ISignalRef},
+        {"SYSTEM-SIGNAL-REF", Tag::SystemSignalRef},
+        {"COMPU-METHOD-REF", Tag::CompuMethodRef},
+        {"BASE-TYPE-REF", Tag::BaseTypeRef},
+        {"UNIT-REF", Tag::UnitRef},
+        {"CATEGORY", Tag::Category},
+        {"V", Tag::V},
+        {"LOWER-LIMIT", Tag::LowerLimit},
+        {"UPPER-LIMIT", Tag::UpperLimit},
+        {"BASE-TYPE-ENCODING", Tag::BaseTypeEncoding},
+        {"DISPLAY-NAME", Tag::DisplayName},
+        {"DATA-ID", Tag::DataId},
+        {"DATA-LENGTH", Tag::DataLength},
+        {"CRC-OFFSET", Tag::CrcOffset},
+        {"COUNTER-OFFSET", Tag::CounterOffset},
+        {"I-SIGNAL-I-PDU-REF", Tag::ISignalIPduRef},
+        {"I-PDU-REF", Tag::IPduRef},
+        {"PAYLOAD-REF", Tag::PayloadRef},
+        {"AUTHENTICATION-PROPS-REF", Tag::AuthenticationPropsRef},
+        {"FRESHNESS-PROPS-REF", Tag::FreshnessPropsRef},
+        {"AUTH-INFO-TX-LENGTH", Tag::AuthInfoTxLength},
+        {"FRESHNESS-VALUE-TX-LENGTH", Tag::FreshnessValueTxLength},
+        {"AUTH-ALGORITHM", Tag::AuthAlgorithm},
+    };
+    auto it = kTags.find(name);
+    return it == kTags.end() ? Tag::Other : it->second;
+}
+
+bool IsEntity(Tag tag) {
+    return tag != Tag::Other && tag <= Tag::kLastEntity;
+}
+
+void Trim(std::string& text) {
+    size_t end = text.size();
+    while (end > 0 && IsSpace(text[end - 1])) {
+        --end;
+    }
+    size_t start = 0;
+    while (start < end && IsSpace(text[start])) {
+        ++start;
+    }
+    text.erase(end);
+    text.erase(0, start);
+}
+
+uint32_t ParseUint(const std::string& text) {
+    const char* start = text.c_str();
+    while (IsSpace(*start)) {
+        ++start;
+    }
+    bool hex = start[0] == '0' && (start[1] == 'x' || start[1] == 'X');
+    return static_cast<uint32_t>(std::strtoul(start, nullptr, hex ? 16 : 10));
+}
+
+double ParseDouble(const std::string& text) {
+    return std::strtod(text.c_str(), nullptr);
+}
+
+std::string_view LastComponent(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? std::string_view(path) : std::string_view(path).substr(slash + 1);
+}
+
+// Records collected while streaming, keyed by the AUTOSAR path of the element (the SHORT-NAMEs
+// from the root down), which is what the *-REF elements point at.
+struct PduMapping {
+    std::string pdu;
+    uint32_t start = 0;
+};
+
+struct FrameRecord {
+    uint32_t length = 0;
+    std::vector<PduMapping> pdus;
+};
+
+struct TriggeringRecord {
+    std::string frame;
+    uint32_t id = 0;
+    bool has_id = false;
+    bool extended = false;
+    bool fd = false;
+};
+
+struct SignalMapping {
+    std::string signal;
+    uint32_t start = 0;
+    bool big_endian = false;
+};
+
+struct PduRecord {
+    uint32_t length = 0;
+    std::vector<SignalMapping> signals;
+    bool secured = false;
+    std::string payload;
+    std::string authentication_props;
+    std::string freshness_props;
+    uint32_t data_id = 0;
+    uint32_t mac_tx_bits = 0;
+    uint32_t freshness_tx_bits = 0;
+};
+
+struct ISignalRecord {
+    uint32_t length = 0;
+    std::string system_signal;
+    std::string compu_method;
+    std::string base_type;
+};
+
+struct SystemSignalRecord {
+    std::string compu_method;
+    std::string unit;
+};
+
+struct CompuRecord {
+    bool linear = false;
+    bool limited = false;
+    double factor = 1.0;
+    double offset = 0.0;
+    double minimum = 0.0;
+    double maximum = 0.0;
+    std::string unit;
+};
+
+struct CompuScaleState {
+    std::vector<double> numerator;
+    std::vector<double> denominator;
+    bool has_lower = false;
+    bool has_upper = false;
+    double lower = 0.0;
+    double upper = 0.0;
+};
+
+struct BaseTypeRecord {
+    std::string encoding;
+};
+
+struct E2ERecord {
+    E2EProtection props;
+    std::vector<std::string> pdus;
+};
+
+struct AuthenticationRecord {
+    uint32_t mac_tx_bits = 0;
+    std::string algorithm;
+};
+
+class ArxmlImporter {
+public:
+    std::string Load(const std::string& path, DecodeTables& tables);
+
+private:
+    struct Node {
+        Tag tag = Tag::Other;
+        std::string short_name;
+    };
+
+    void OnStart(Tag tag);
+    void OnEnd(Tag tag);
+    void OnLeaf(Tag tag, Tag entity, Tag parent);
+    Tag Enclosing() const;
+    bool Inside(Tag tag) const;
+    const std::string& CurrentPath();
+    void Resolve(DecodeTables& tables) const;
+    void AddSignals(const PduRecord& pdu, uint32_t offset, MessageDef& message) const;
+    bool BuildSignal(const SignalMapping& mapping, uint32_t offset, SignalDef& out) const;
+
+    // Element stack; nodes are reused across siblings so their strings keep their capacity.
+    std::vector<Node> stack_;
+    size_t depth_ = 0;
+    std::string text_;
+    std::string path_;
+
+    TriggeringRecord triggering_;
+    FrameRecord frame_;
+    PduMapping pdu_mapping_;
+    PduRecord pdu_;
+    SignalMapping signal_mapping_;
+    ISignalRecord isignal_;
+    SystemSignalRecord system_signal_;
+    CompuRecord compu_;
+    CompuScaleState scale_;
+    std::string unit_;
+    BaseTypeRecord base_type_;
+    std::string pdu_triggering_;
+    E2ERecord e2e_;
+    AuthenticationRecord authentication_;
+    uint32_t freshness_tx_bits_ = 0;
+
+    std::vector<TriggeringRecord> triggerings_;
+    std::unordered_map<std::string, FrameRecord> frames_;
+    std::unordered_map<std::string, PduRecord> pdus_;
+    std::unordered_map<std::string, ISignalRecord> isignals_;
+    std::unordered_map<std::string, SystemSignalRecord> system_signals_;
+    std::unordered_map<std::string, CompuRecord> compu_methods_;
+    std::unordered_map<std::string, std::string> units_;
+    std::unordered_map<std::string, BaseTypeRecord> base_types_;
+    std::unordered_map<std::string, std::string> pdu_triggerings_;
+    std::unordered_map<std::string, E2EProtection> e2e_by_pdu_;
+    std::unordered_map<std::string, AuthenticationRecord> authentication_props_;
+    std::unordered_map<std::string, uint32_t> freshness_props_;
+};
+
+std::string ArxmlImporter::Load(const std::string& path, DecodeTables& tables) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return "Failed to open database: " + path;
+    }
+    XmlReader reader(file);
+    std::string error;
+    bool done = false;
+    while (!done) {
+        switch (reader.Next()) {
+            case XmlReader::Event::StartElement: {
+                if (depth_ == stack_.size()) {
+                    stack_.emplace_back();
+                }
+                Node& node = stack_[depth_++];
+                node.tag = LookupTag(reader.Name());
+                node.short_name.clear();
+                text_.clear();
+                OnStart(node.tag);
+                break;
+            }
+            case XmlReader::Event::EndElement:
+                if (depth_ == 0) {
+                    error = "Unbalanced end tag </" + reader.Name() + "> in " + path;
+                    done = true;
+                    break;
+                }
+                OnEnd(stack_[depth_ - 1].tag);
+                --depth_;
+                text_.clear();
+                break;
+            case XmlReader::Event::Text:
+                text_ += reader.Text();
+                break;
+            case XmlReader::Event::Error:
+                error = reader.Error() + " in " + path;
+                done = true;
+                break;
+            case XmlReader::Event::End:
+                done = true;
+                break;
+        }
+    }
+    std::fclose(file);
+    if (!error.empty()) {
+        return error;
+    }
+    if (triggerings_.empty()) {
+        return "No CAN frame triggerings found in " + path;
+    }
+    Resolve(tables);
+    return std::string();
+}
+
+void ArxmlImporter::OnStart(Tag tag) {
+    switch (tag) {
+        case Tag::CanFrameTriggering: triggering_ = TriggeringRecord(); break;
+        case Tag::CanFrame: frame_ = FrameRecord(); break;
+        case Tag::PduToFrameMapping: pdu_mapping_ = PduMapping(); break;
+        case Tag::ISignalIPdu: pdu_ = PduRecord(); break;
+        case Tag::SecuredIPdu:
+            pdu_ = PduRecord();
+            pdu_.secured = true;
+            break;
+        case Tag::ISignalToIPduMapping: signal_mapping_ = SignalMapping(); break;
+        case Tag::ISignal: isignal_ = ISignalRecord(); break;
+        case Tag::SystemSignal: system_signal_ = SystemSignalRecord(); break;
+        case Tag::CompuMethod: compu_ = CompuRecord(); break;
+        case Tag::CompuScale: scale_ = CompuScaleState(); break;
+        case Tag::Unit: unit_.clear(); break;
+        case Tag::SwBaseType: base_type_ = BaseTypeRecord(); break;
+        case Tag::PduTriggering: pdu_triggering_.clear(); break;
+        case Tag::EndToEndProtection: e2e_ = E2ERecord(); break;
+        case Tag::AuthenticationProps: authentication_ = AuthenticationRecord(); break;
+        case Tag::FreshnessProps: freshness_tx_bits_ = 0; break;
+        default: break;
+    }
+}
+
+void ArxmlImporter::OnEnd(Tag tag) {
+    if (tag != Tag::Other && !text_.empty()) {
+        Trim(text_);
+    }
+    if (tag == Tag::ShortName) {
+        if (depth_ >= 2) {
+            stack_[depth_ - 2].short_name = text_;
+        }
+        return;
+    }
+    if (!IsEntity(tag)) {
+        if (tag != Tag::Other && !text_.empty()) {
+            OnLeaf(tag, Enclosing(), depth_ >= 2 ? stack_[depth_ - 2].tag : Tag::Other);
+        }
+        return;
+    }
+
+    switch (tag) {
+        case Tag::CanFrameTriggering:
+            if (triggering_.has_id && !triggering_.frame.empty()) {
+                triggerings_.push_back(std::move(triggering_));
+            }
+            break;
+        case Tag::CanFrame: frames_[CurrentPath()] = std::move(frame_); break;
+        case Tag::PduToFrameMapping: frame_.pdus.push_back(std::move(pdu_mapping_)); break;
+        case Tag::ISignalIPdu:
+        case Tag::SecuredIPdu: pdus_[CurrentPath()] = std::move(pdu_); break;
+        case Tag::ISignalToIPduMapping:
+            // Signal group mappings carry no I-SIGNAL-REF; their member signals are mapped individually.
+            if (!signal_mapping_.signal.empty()) {
+                pdu_.signals.push_back(std::move(signal_mapping_));
+            }
+            break;
+        case Tag::ISignal: isignals_[CurrentPath()] = std::move(isignal_); break;
+        case Tag::SystemSignal: system_signals_[CurrentPath()] = std::move(system_signal_); break;
+        case Tag::CompuMethod: compu_methods_[CurrentPath()] = std::move(compu_); break;
+        case Tag::CompuScale:
+            // The first rational scale converting internal to physical values is the linear part
+            // (also for SCALE_LINEAR_AND_TEXTTABLE); text-table scales have no coefficients.
+            if (!compu_.linear && Inside(Tag::CompuInternalToPhys) && scale_.numerator.size() >= 2) {
+                double denominator =
+                    (scale_.denominator.empty() || scale_.denominator[0] == 0.0) ? 1.0 : scale_.denominator[0];
+                compu_.linear = true;
+                compu_.factor = scale_.numerator[1] / denominator;
+                compu_.offset = scale_.numerator[0] / denominator;
+                if (scale_.has_lower && scale_.has_upper) {
+                    compu_.limited = true;
+                    compu_.minimum = scale_.lower * compu_.factor + compu_.offset;
+                    compu_.maximum = scale_.upper * compu_.factor + compu_.offset;
+                    if (compu_.minimum > compu_.maximum) {
+                        std::swap(compu_.minimum, compu_.maximum);
+                    }
+                }
+            }
+            break;
+        case Tag::Unit: units_[CurrentPath()] = std::move(unit_); break;
+        case Tag::SwBaseType: base_types_[CurrentPath()] = std::move(base_type_); break;
+        case Tag::PduTriggering: pdu_triggerings_[CurrentPath()] = std::move(pdu_triggering_); break;
+        case Tag::EndToEndProtection:
+            for (const std::string& pdu : e2e_.pdus) {
+                e2e_by_pdu_[pdu] = e2e_.props;
+            }
+            break;
+        case Tag::AuthenticationProps: authentication_props_[CurrentPath()] = std::move(authentication_); break;
+        case Tag::FreshnessProps: freshness_props_[CurrentPath()] = freshness_tx_bits_; break;
+        default: break;
+    }
+}
+
+void ArxmlImporter::OnLeaf(Tag tag, Tag entity, Tag parent) {
+    switch (entity) {
+        case Tag::CanFrameTriggering:
+            if (tag == Tag::Identifier) {
+                triggering_.id = ParseUint(text_);
+                triggering_.has_id = true;
+            } else if (tag == Tag::CanAddressingMode) {
+                triggering_.extended = text_ == "EXTENDED";
+            } else if (tag == Tag::CanFrameRxBehavior || tag == Tag::CanFrameTxBehavior) {
+                triggering_.fd = triggering_.fd || text_ == "CAN-FD";
+            } else if (tag == Tag::FrameRef) {
+                triggering_.frame = text_;
+            }
+            break;
+        case Tag::CanFrame:
+            if (tag == Tag::FrameLength) {
+                frame_.length = ParseUint(text_);
+            }
+            break;
+        case Tag::PduToFrameMapping:
+            if (tag == Tag::PduRef) {
+                pdu_mapping_.pdu = text_;
+            } else if (tag == Tag::StartPosition) {
+                pdu_mapping_.start = ParseUint(text_);
+            }
+            break;
+        case Tag::ISignalIPdu:
+        case Tag::SecuredIPdu:
+            if (tag == Tag::Length && parent == entity) {
+                pdu_.length = ParseUint(text_);
+            } else if (tag == Tag::PayloadRef) {
+                pdu_.payload = text_;
+            } else if (tag == Tag::AuthenticationPropsRef) {
+                pdu_.authentication_props = text_;
+            } else if (tag == Tag::FreshnessPropsRef) {
+                pdu_.freshness_props = text_;
+            }
+            break;
+        case Tag::SecureCommunicationProps:
+            if (tag == Tag::DataId) {
+                pdu_.data_id = ParseUint(text_);
+            } else if (tag == Tag::AuthInfoTxLength) {
+                pdu_.mac_tx_bits = ParseUint(text_);
+            } else if (tag == Tag::FreshnessValueTxLength) {
+                pdu_.freshness_tx_bits = ParseUint(text_);
+            }
+            break;
+        case Tag::ISignalToIPduMapping:
+            if (tag == Tag::ISignalRef) {
+                signal_mapping_.signal = text_;
+            } else if (tag == Tag::StartPosition) {
+                signal_mapping_.start = ParseUint(text_);
+            } else if (tag == Tag::PackingByteOrder) {
+                signal_mapping_.big_endian = text_ == "MOST-SIGNIFICANT-BYTE-FIRST";
+            }
+            break;
+        case Tag::ISignal:
+            if (tag == Tag::Length && parent == entity) {
+                isignal_.length = ParseUint(text_);
+            } else if (tag == Tag::SystemSignalRef) {
+                isignal_.system_signal = text_;
+            } else if (tag == Tag::CompuMethodRef) {
+                isignal_.compu_method = text_;
+            } else if (tag == Tag::BaseTypeRef) {
+                isignal_.base_type = text_;
+            }
+            break;
+        case Tag::SystemSignal:
+            if (tag == Tag::CompuMethodRef) {
+                system_signal_.compu_method = text_;
+            } else if (tag == Tag::UnitRef) {
+                system_signal_.unit = text_;
+            }
+            break;
+        case Tag::CompuMethod:
+            if (tag == Tag::UnitRef) {
+                compu_.unit = text_;
+            }
+            break;
+        case Tag::CompuScale:
+            if (tag == Tag::LowerLimit) {
+                scale_.lower = ParseDouble(text_);
+                scale_.has_lower = true;
+            } else if (tag == Tag::UpperLimit) {
+                scale_.upper = ParseDouble(text_);
+                scale_.has_upper = true;
+            }
+            break;
+        case Tag::CompuNumerator:
+            if (tag == Tag::V) {
+                scale_.numerator.push_back(ParseDouble(text_));
+            }
+            break;
+        case Tag::CompuDenominator:
+            if (tag == Tag::V) {
+                scale_.denominator.push_back(ParseDouble(text_));
+            }
+            break;
+        case Tag::Unit:
+            if (tag == Tag::DisplayName) {
+                unit_ = text_;
+            }
+            break;
+        case Tag::SwBaseType:
+            if (tag == Tag::BaseTypeEncoding) {
+                base_type_.encoding = text_;
+            }
+            break;
+        case Tag::PduTriggering:
+            if (tag == Tag::IPduRef) {
+                pdu_triggering_ = text_;
+            }
+            break;
+        case Tag::EndToEndProtection:
+            if (tag == Tag::Category) {
+                e2e_.props.profile = text_;
+            } else if (tag == Tag::DataId) {
+                // Profiles with a data ID list use the first entry.
+                if (e2e_.props.data_id == 0) {
+                    e2e_.props.data_id = ParseUint(text_);
+                }
+            } else if (tag == Tag::DataLength) {
+                e2e_.props.data_length = ParseUint(text_);
+            } else if (tag == Tag::CrcOffset) {
+                e2e_.props.crc_offset = ParseUint(text_);
+            } else if (tag == Tag::CounterOffset) {
+                e2e_.props.counter_offset = ParseUint(text_);
+            } else if (tag == Tag::ISignalIPduRef) {
+                e2e_.pdus.push_back(text_);
+            }
+            break;
+        case Tag::AuthenticationProps:
+            if (tag == Tag::AuthInfoTxLength) {
+                authentication_.mac_tx_bits = ParseUint(text_);
+            } else if (tag == Tag::AuthAlgorithm) {
+                authentication_.algorithm = text_;
+            }
+            break;
+        case Tag::FreshnessProps:
+            if (tag == Tag::FreshnessValueTxLength) {
+                freshness_tx_bits_ = ParseUint(text_);
+            }
+            break;
+        default: break;
+    }
+}
+
+// Innermost entity enclosing the element being closed.
+Tag ArxmlImporter::Enclosing() const {
+    for (size_t i = depth_ - 1; i-- > 0;) {
+        if (IsEntity(stack_[i].tag)) {
+            return stack_[i].tag;
+        }
+    }
+    return Tag::Other;
+}
+
+bool ArxmlImporter::Inside(Tag tag) const {
+    for (size_t i = 0; i < depth_; ++i) {
+        if (stack_[i].tag == tag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Path of the element being closed.
+const std::string& ArxmlImporter::CurrentPath() {
+    path_.clear();
+    for (size_t i = 0; i < depth_; ++i) {
+        if (!stack_[i].short_name.empty()) {
+            path_ += '/';
+            path_ += stack_[i].short_name;
+        }
+    }
+    return path_;
+}
+
+void ArxmlImporter::Resolve(DecodeTables& tables) const {
+    for (const TriggeringRecord& triggering : triggerings_) {
+        auto frame = frames_.find(triggering.frame);
+        if (frame == frames_.end()) {
+            continue;
+        }
+        MessageDef message;
+        message.name = std::string(LastComponent(triggering.frame));
+        message.id = triggering.id & (triggering.extended ? 0x1FFFFFFFu : 0x7FFu);
+        message.extended = triggering.extended;
+        message.fd = triggering.fd || frame->second.length > 8;
+        message.length = static_cast<uint16_t>(frame->second.length);
+
+        for (const PduMapping& mapping : frame->second.pdus) {
+            auto pdu = pdus_.find(mapping.pdu);
+            if (pdu == pdus_.end()) {
+                continue;
+            }
+            const PduRecord* payload = &pdu->second;
+            std::string payloadPath = mapping.pdu;
+            if (pdu->second.secured) {
+                // The secured PDU's payload is a PDU triggering of the authentic I-PDU.
+                auto triggered = pdu_triggerings_.find(pdu->second.payload);
+                payloadPath = triggered != pdu_triggerings_.end() ? triggered->second : pdu->second.payload;
+                auto authentic = pdus_.find(payloadPath);
+                payload = authentic != pdus_.end() ? &authentic->second : nullptr;
+
+                SecOcProps secoc;
+                secoc.data_id = pdu->second.data_id;
+                secoc.payload_length = payload != nullptr ? payload->length : 0;
+                secoc.mac_tx_bits = pdu->second.mac_tx_bits;
+                secoc.freshness_tx_bits = pdu->second.freshness_tx_bits;
+                auto authentication = authentication_props_.find(pdu->second.authentication_props);
+                if (authentication != authentication_props_.end()) {
+                    secoc.algorithm = authentication->second.algorithm;
+                    if (secoc.mac_tx_bits == 0) {
+                        secoc.mac_tx_bits = authentication->second.mac_tx_bits;
+                    }
+                }
+                auto freshness = freshness_props_.find(pdu->second.freshness_props);
+                if (freshness != freshness_props_.end() && secoc.freshness_tx_bits == 0) {
+                    secoc.freshness_tx_bits = freshness->second;
+                }
+                message.secoc = std::move(secoc);
+            }
+            auto e2e = e2e_by_pdu_.find(payloadPath);
+            if (e2e == e2e_by_pdu_.end()) {
+                e2e = e2e_by_pdu_.find(mapping.pdu);
+            }
+            if (e2e != e2e_by_pdu_.end()) {
+                message.e2e = e2e->second;
+            }
+            if (payload != nullptr) {
+                AddSignals(*payload, mapping.start, message);
+            }
+        }
+        tables.Add(std::move(message));
+    }
+}
+
+void ArxmlImporter::AddSignals(const PduRecord& pdu, uint32_t offset, MessageDef& message) const {
+    for (const SignalMapping& mapping : pdu.signals) {
+        SignalDef signal;
+        if (BuildSignal(mapping, offset, signal)) {
+            message.signals.push_back(std::move(signal));
+        }
+    }
+}
+
+bool ArxmlImporter::BuildSignal(const SignalMapping& mapping, uint32_t offset, SignalDef& out) const {
+    auto isignal = isignals_.find(mapping.signal);
+    if (isignal == isignals_.end() || isignal->second.length == 0 || isignal->second.length > 64) {
+        return false;
+    }
+    const ISignalRecord& record = isignal->second;
+    out.name = std::string(LastComponent(mapping.signal));
+    out.length = static_cast<uint16_t>(record.length);
+    out.little_endian = !mapping.big_endian;
+
+    // ARXML gives the LSB position for both byte orders; DBC tables want the MSB for big endian.
+    int64_t bit = static_cast<int64_t>(offset) + mapping.start;
+    if (mapping.big_endian) {
+        for (uint32_t i = 1; i < record.length; ++i) {
+            bit = (bit % 8 == 7) ? bit - 15 : bit + 1;
+        }
+    }
+    if (bit < 0 || bit > 511) {
+        return false;
+    }
+    out.start_bit = static_cast<uint16_t>(bit);
+
+    const SystemSignalRecord* system = nullptr;
+    auto systemIt = system_signals_.find(record.system_signal);
+    if (systemIt != system_signals_.end()) {
+        system = &systemIt->second;
+    }
+    const std::string* compuRef = !record.compu_method.empty() ? &record.compu_method
+                                : system != nullptr           ? &system->compu_method
+                                                              : nullptr;
+    std::string unitRef = system != nullptr ? system->unit : std::string();
+    if (compuRef != nullptr) {
+        auto compu = compu_methods_.find(*compuRef);
+        if (compu != compu_methods_.end()) {
+            if (compu->second.linear) {
+                out.factor = compu->second.factor;
+                out.offset = compu->second.offset;
+            }
+            if (compu->second.limited) {
+                out.minimum = compu->second.minimum;
+                out.maximum = compu->second.maximum;
+            }
+            if (!compu->second.unit.empty()) {
+                unitRef = compu->second.unit;
+            }
+        }
+    }
+    if (!unitRef.empty()) {
+        auto unit = units_.find(unitRef);
+        out.unit = (unit != units_.end() && !unit->second.empty()) ? unit->second : std::string(LastComponent(unitRef));
+    }
+
+    auto baseType = base_types_.find(record.base_type);
+    if (baseType != base_types_.end()) {
+        const std::string& encoding = baseType->second.encoding;
+        if (encoding == "IEEE754" && (record.length == 32 || record.length == 64)) {
+            out.value_type = record.length == 32 ? SignalDef::ValueType::Float32 : SignalDef::ValueType::Float64;
+        } else {
+            out.is_signed = encoding == "2C" || encoding == "1C" || encoding == "SM";
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+std::string LoadArxml(const std::string& path, DecodeTables& tables) {
+    ArxmlImporter importer;
+    return importer.Load(path, tables);
+}
@@ -0,0 +1,256 @@
+#include "batch_encoder.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "can_frame.h"
+#include "signal_decoder.h"
+#include "wire_writers.h"
+
+namespace {
+
+uint8_t* PutBlob(uint8_t* p, const std::string& blob) {
+    std::memcpy(p, blob.data(), blob.size());
+    return p + blob.size();
+}
+
+template <typename Writer>
+std::string EncodedText(const std::string& text) {
+    std::string out(kWireMaxHead + text.size(), '\0');
+    uint8_t* begin = reinterpret_cast<uint8_t*>(&out[0]);
+    out.resize(static_cast<size_t>(Writer::Text(begin, text) - begin));
+    return out;
+}
+
+template <typename Writer>
+std::string EncodedUint(uint64_t value) {
+    uint8_t bytes[kWireMaxHead];
+    return std::string(reinterpret_cast<const char*>(bytes), static_cast<size_t>(Writer::Uint(bytes, value) - bytes));
+}
+
+template <typename Writer>
+std::string EncodedMap(uint64_t entries) {
+    uint8_t bytes[kWireMaxHead];
+    return std::string(reinterpret_cast<const char*>(bytes), static_cast<size_t>(Writer::Map(bytes, entries) - bytes));
+}
+
+// batch (ArrayBuffer or typed array of frame records) and optional record count.
+bool ReadRecords(const Napi::CallbackInfo& info, const uint8_t*& records, size_t& count) {
+    size_t byteLength = 0;
+    if (info.Length() > 0 && info[0].IsArrayBuffer()) {
+        Napi::ArrayBuffer buffer = info[0].As<Napi::ArrayBuffer>();
+        records = static_cast<const uint8_t*>(buffer.Data());
+        byteLength = buffer.ByteLength();
+    } else if (info.Length() > 0 && info[0].IsTypedArray()) {
+        Napi::TypedArray view = info[0].As<Napi::TypedArray>();
+        records = static_cast<const uint8_t*>(view.ArrayBuffer().Data()) + view.ByteOffset();
+        byteLength = view.ByteLength();
+    } else {
+        return false;
+    }
+    count = byteLength / kFrameRecordSize;
+    if (info.Length() > 1 && info[1].IsNumber()) {
+        count = std::min<size_t>(count, info[1].As<Napi::Number>().Uint32Value());
+    }
+    return true;
+}
+
+// Record header fields; records in a typed array need not be aligned.
+const uint8_t* ReadFrame(const uint8_t* record, CanFrame& frame) {
+    std::memcpy(&frame, record, offsetof(CanFrame, data));
+    frame.length = std::min<uint8_t>(frame.length, sizeof(frame.data));
+    return record + offsetof(CanFrame, data);
+}
+
+} // namespace
+
+Napi::Object BatchEncoder::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "BatchEncoder", {
+        InstanceMethod("encodeFrames", &BatchEncoder::EncodeFrames),
+        InstanceMethod("encodeSignals", &BatchEncoder::EncodeSignals),
+    });
+    exports.Set("BatchEncoder", func);
+    return exports;
+}
+
+// new BatchEncoder(format = 'msgpack', decoder?): format is 'msgpack' or 'cbor'; the SignalDecoder
+// is needed for encodeSignals().
+BatchEncoder::BatchEncoder(const Napi::CallbackInfo& info) : Napi::ObjectWrap<BatchEncoder>(info) {
+    Napi::Env env = info.Env();
+    if (info.Length() > 0 && !info[0].IsUndefined()) {
+        std::string format = info[0].IsString() ? info[0].As<Napi::String>().Utf8Value() : std::string();
+        if (format == "cbor") {
+            format_ = Format::Cbor;
+        } else if (format != "msgpack") {
+            Napi::RangeError::New(env, "format must be 'msgpack' or 'cbor'").ThrowAsJavaScriptException();
+            return;
+        }
+    }
+    if (info.Length() > 1 && !info[1].IsUndefined() && !info[1].IsNull()) {
+        decoder_ = SignalDecoder::FromValue(env, info[1]);
+        if (decoder_ == nullptr) {
+            Napi::TypeError::New(env, "decoder must be a SignalDecoder").ThrowAsJavaScriptException();
+            return;
+        }
+        decoder_ref_ = Napi::Persistent(info[1].As<Napi::Object>());
+    }
+    if (format_ == Format::Cbor) {
+        BuildSchemas<CborWriter>();
+    } else {
+        BuildSchemas<MsgPackWriter>();
+    }
+}
+
+template <typename Writer>
+void BatchEncoder::BuildSchemas() {
+    frame_prefix_ = EncodedMap<Writer>(5) + EncodedText<Writer>("timestamp");
+    key_id_ = EncodedText<Writer>("id");
+    key_flags_ = EncodedText<Writer>("flags");
+    key_channel_ = EncodedText<Writer>("channel");
+    key_data_ = EncodedText<Writer>("data");
+    if (decoder_ == nullptr) {
+        return;
+    }
+
+    const std::vector<std::string>& names = decoder_->SignalNames();
+    for (const SignalDecoder::Message& message : decoder_->Messages()) {
+        MessageSchema schema;
+        schema.prefix = EncodedMap<Writer>(4) + EncodedText<Writer>("timestamp");
+        schema.middle = key_id_ + EncodedUint<Writer>(message.id) + EncodedText<Writer>("name") +
+                        EncodedText<Writer>(message.name) + EncodedText<Writer>("signals");
+        schema.max_bytes = schema.prefix.size() + kWireMaxHead + schema.middle.size() + kWireMaxHead;
+        messages_.push_back(std::move(schema));
+    }
+    signal_keys_.resize(names.size());
+    for (const SignalDecoder::Message& message : decoder_->Messages()) {
+        MessageSchema& schema = messages_[static_cast<size_t>(&message - decoder_->Messages().data())];
+        for (uint32_t i = 0; i < message.signal_count; ++i) {
+            uint32_t signal = message.first_signal + i;
+            signal_keys_[signal] = EncodedText<Writer>(names[signal].substr(message.name.size() + 1));
+            schema.max_bytes += signal_keys_[signal].size() + kWireMaxHead;
+        }
+    }
+}
+
+// encodeFrames(batch, count?) -> Buffer
+Napi::Value BatchEncoder::EncodeFrames(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    const uint8_t* records = nullptr;
+    size_t count = 0;
+    if (!ReadRecords(info, records, count)) {
+        Napi::TypeError::New(env, "Expected frame batch (ArrayBuffer or typed array)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    size_t encoded = format_ == Format::Cbor ? WriteFrames<CborWriter>(records, count)
+                                             : WriteFrames<MsgPackWriter>(records, count);
+    return Finish(env, encoded);
+}
+
+// encodeSignals(batch, count?) -> Buffer
+Napi::Value BatchEncoder::EncodeSignals(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (decoder_ == nullptr) {
+        Napi::Error::New(env, "encodeSignals needs a BatchEncoder created with a SignalDecoder").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    const uint8_t* records = nullptr;
+    size_t count = 0;
+    if (!ReadRecords(info, records, count)) {
+        Napi::TypeError::New(env, "Expected frame batch (ArrayBuffer or typed array)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    size_t encoded = format_ == Format::Cbor ? WriteSignals<CborWriter>(records, count)
+                                             : WriteSignals<MsgPackWriter>(records, count);
+    return Finish(env, encoded);
+}
+
+template <typename Writer>
+size_t BatchEncoder::WriteFrames(const uint8_t* records, size_t count) {
+    size_t maxFrame = frame_prefix_.size() + key_id_.size() + key_flags_.size() + key_channel_.size() +
+                      key_data_.size() + 5 * kWireMaxHead + sizeof(CanFrame::data);
+    used_ = kHeaderRoom;
+    for (size_t i = 0; i < count; ++i) {
+        CanFrame frame;
+        const uint8_t* data = ReadFrame(records + i * kFrameRecordSize, frame);
+        uint8_t* p = Reserve(maxFrame);
+        p = PutBlob(p, frame_prefix_);
+        p = Writer::Uint(p, frame.timestamp);
+        p = PutBlob(p, key_id_);
+        p = Writer::Uint(p, frame.id);
+        p = PutBlob(p, key_flags_);
+        p = Writer::Uint(p, frame.flags);
+        p = PutBlob(p, key_channel_);
+        p = Writer::Uint(p, frame.channel);
+        p = PutBlob(p, key_data_);
+        p = Writer::Bytes(p, data, frame.length);
+        used_ = static_cast<size_t>(p - buffer_.data());
+    }
+    return count;
+}
+
+template <typename Writer>
+size_t BatchEncoder::WriteSignals(const uint8_t* records, size_t count) {
+    const SignalDecoder::Message* first = decoder_->Messages().data();
+    size_t encoded = 0;
+    used_ = kHeaderRoom;
+    for (size_t i = 0; i < count; ++i) {
+        CanFrame frame;
+        const uint8_t* data = ReadFrame(records + i * kFrameRecordSize, frame);
+        if ((frame.flags & (kFrameFlagRemote | kFrameFlagError)) != 0) {
+            continue;
+        }
+        bool extended = (frame.flags & kFrameFlagExtended) != 0;
+        const SignalDecoder::Message* message = decoder_->FindMessage(frame.id, extended);
+        values_.clear();
+        if (message == nullptr || decoder_->DecodeFrame(frame.id, extended, data, frame.length, &CollectValue, this) < 0) {
+            continue;
+        }
+        // Multiplexed messages decode a subset of their signals.
+        uint32_t end = message->first_signal + message->signal_count;
+        auto outside = [message, end](const std::pair<uint32_t, double>& value) {
+            return value.first < message->first_signal || value.first >= end;
+        };
+        values_.erase(std::remove_if(values_.begin(), values_.end(), outside), values_.end());
+        if (values_.size() > message->signal_count) {
+            values_.resize(message->signal_count);
+        }
+
+        const MessageSchema& schema = messages_[static_cast<size_t>(message - first)];
+        uint8_t* p = Reserve(schema.max_bytes);
+        p = PutBlob(p, schema.prefix);
+        p = Writer::Uint(p, frame.timestamp);
+        p = PutBlob(p, schema.middle);
+        p = Writer::Map(p, values_.size());
+        for (const auto& [signal, value] : values_) {
+            p = PutBlob(p, signal_keys_[signal]);
+            p = PutWireNumber<Writer>(p, value);
+        }
+        used_ = static_cast<size_t>(p - buffer_.data());
+        encoded++;
+    }
+    return encoded;
+}
+
+void BatchEncoder::CollectValue(void* context, uint32_t signal, double value) {
+    static_cast<BatchEncoder*>(context)->values_.emplace_back(signal, value);
+}
+
+// Room for `bytes` more at used_.
+uint8_t* BatchEncoder::Reserve(size_t bytes) {
+    if (used_ + bytes > buffer_.size()) {
+        buffer_.resize(std::max(buffer_.size() * 2, used_ + bytes));
+    }
+    return buffer_.data() + used_;
+}
+
+// Puts the array header in front of the body and copies the result out.
+Napi::Value BatchEncoder::Finish(Napi::Env env, size_t count) {
+    Reserve(0);
+    uint8_t header[kHeaderRoom];
+    size_t size = static_cast<size_t>((format_ == Format::Cbor ? CborWriter::Array(header, count)
+                                                               : MsgPackWriter::Array(header, count)) - header);
+    size_t start = kHeaderRoom - size;
+    std::memcpy(buffer_.data() + start, header, size);
+    return Napi::Buffer<uint8_t>::Copy(env, buffer_.data() + start, used_ - start);
+}
@@ -0,0 +1,69 @@
+#ifndef ACE_CAN_BATCH_ENCODER_H
+#define ACE_CAN_BATCH_ENCODER_H
+
+#include <napi.h>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+class SignalDecoder;
+
+// Serializes frame batches (FRAME_RECORD_SIZE records) into MessagePack or CBOR in one call, for
+// forwarding to other services without building JS objects or JSON. Everything that does not
+// depend on the frame (map headers, keys, and per message its id, name and signal names) is
+// encoded once up front, so a batch only costs the values.
+//
+//   encodeFrames:  [{ timestamp, id, flags, channel, data }, ...]
+//   encodeSignals: [{ timestamp, id, name, signals: { [signal]: value } }, ...] for frames the
+//                  decoder knows; others are left out
+//
+// Integral values are written as integers, others as float64; data as a byte string.
+class BatchEncoder : public Napi::ObjectWrap<BatchEncoder> {
+public:
+    enum class Format { MsgPack, Cbor };
+
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    BatchEncoder(const Napi::CallbackInfo& info);
+
+    Napi::Value EncodeFrames(const Napi::CallbackInfo& info);
+    Napi::Value EncodeSignals(const Napi::CallbackInfo& info);
+
+private:
+    struct MessageSchema {
+        std::string prefix; // map header and "timestamp" key
+        std::string middle; // id and name with their keys, then the "signals" key
+        size_t max_bytes = 0; // encoded size with every signal present
+    };
+
+    template <typename Writer>
+    void BuildSchemas();
+    template <typename Writer>
+    size_t WriteFrames(const uint8_t* records, size_t count);
+    template <typename Writer>
+    size_t WriteSignals(const uint8_t* records, size_t count);
+    static void CollectValue(void* context, uint32_t signal, double value);
+    uint8_t* Reserve(size_t bytes);
+    Napi::Value Finish(Napi::Env env, size_t count);
+
+    Format format_ = Format::MsgPack;
+    SignalDecoder* decoder_ = nullptr;
+    Napi::ObjectReference decoder_ref_;
+
+    std::string frame_prefix_; // map header and "timestamp" key
+    std::string key_id_;
+    std::string key_flags_;
+    std::string key_channel_;
+    std::string key_data_;
+    std::vector<MessageSchema> messages_; // by decoder message index
+    std::vector<std::string> signal_keys_; // by decoder signal index, short names
+
+    // Scratch, reused across calls. The body starts at kHeaderRoom so the array header, whose
+    // size depends on the element count, can be written in front of it afterwards.
+    static constexpr size_t kHeaderRoom = 5;
+    std::vector<uint8_t> buffer_;
+    size_t used_ = 0;
+    std::vector<std::pair<uint32_t, double>> values_;
+};
+
+#endif // ACE_CAN_BATCH_ENCODER_H
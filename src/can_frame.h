@@ -0,0 +1,52 @@
+#ifndef ACE_CAN_FRAME_H
+#define ACE_CAN_FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Flags stored in CanFrame::flags.
+constexpr uint8_t kFrameFlagExtended = 0x01;
+constexpr uint8_t kFrameFlagRemote = 0x02;
+constexpr uint8_t kFrameFlagFd = 0x04;
+constexpr uint8_t kFrameFlagBrs = 0x08;
+constexpr uint8_t kFrameFlagEsi = 0x10;
+constexpr uint8_t kFrameFlagTx = 0x20;
+constexpr uint8_t kFrameFlagError = 0x40;
+
+// One record of a frame batch. The in-memory layout is the batch record
+// layout exposed to JS (little-endian, 80 bytes):
+//   0  uint64 timestamp (microseconds)
+//   8  uint32 id
+//   12 uint8  flags
+//   13 uint8  length (bytes of data)
+//   14 uint16 channel
+//   16 uint8  data[64]
+struct CanFrame {
+    uint64_t timestamp;
+    uint32_t id;
+    uint8_t flags;
+    uint8_t length;
+    uint16_t channel;
+    uint8_t data[64];
+};
+
+constexpr size_t kFrameRecordSize = 80;
+static_assert(sizeof(CanFrame) == kFrameRecordSize, "CanFrame must match the batch record layout");
+
+inline uint8_t CanFdDlcToLength(uint8_t dlc) {
+    static const uint8_t kLengths[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64};
+    return kLengths[dlc & 0x0F];
+}
+
+inline uint8_t CanFdLengthToDlc(size_t length) {
+    if (length <= 8) return static_cast<uint8_t>(length);
+    if (length <= 12) return 9;
+    if (length <= 16) return 10;
+    if (length <= 20) return 11;
+    if (length <= 24) return 12;
+    if (length <= 32) return 13;
+    if (length <= 48) return 14;
+    return 15;
+}
+
+#endif // ACE_CAN_FRAME_H
@@ -0,0 +1,319 @@
+#include "can_tunnel.h"
+
+#include <chrono>
+#include <cstring>
+
+#include "ace_can.h"
+#include "napi_options.h"
+#include "timed_tx.h"
+
+namespace {
+
+constexpr size_t kMaxSpare = 64;
+
+// Frame count from a queued, length-prefixed packet.
+uint16_t QueuedFrameCount(const std::vector<uint8_t>& packet) {
+    return static_cast<uint16_t>((packet[4] << 8) | packet[5]);
+}
+
+} // namespace
+
+Napi::Object CanTunnel::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "CanTunnel", {
+        InstanceMethod("stats", &CanTunnel::Stats),
+        InstanceMethod("close", &CanTunnel::Close),
+    });
+    exports.Set("CanTunnel", func);
+    return exports;
+}
+
+// new CanTunnel(bus, { host, port, protocol = 'udp', channel = 0, batchUs = 1000, maxPacketBytes = 1400 })
+CanTunnel::CanTunnel(const Napi::CallbackInfo& info) : Napi::ObjectWrap<CanTunnel>(info) {
+    Napi::Env env = info.Env();
+    bus_ = info.Length() > 0 ? CANBus::FromValue(env, info[0]) : nullptr;
+    if (bus_ == nullptr) {
+        Napi::TypeError::New(env, "bus must be a CANBus instance").ThrowAsJavaScriptException();
+        return;
+    }
+    if (info.Length() < 2 || !info[1].IsObject()) {
+        Napi::TypeError::New(env, "Expected (bus, options)").ThrowAsJavaScriptException();
+        return;
+    }
+    Napi::Object options = info[1].As<Napi::Object>();
+    std::string host;
+    std::string protocol = "udp";
+    uint32_t port = 0;
+    uint32_t channel = 0;
+    uint32_t batchUs = 1000;
+    uint32_t maxPacket = 1400;
+    if (!GetOptionalString(options, "host", host) || !GetOptionalString(options, "protocol", protocol) ||
+        !GetOptionalUint32(options, "port", port) || !GetOptionalUint32(options, "channel", channel) ||
+        !GetOptionalUint32(options, "batchUs", batchUs) || !GetOptionalUint32(options, "maxPacketBytes", maxPacket)) {
+        Napi::TypeError::New(env, "Invalid tunnel option type").ThrowAsJavaScriptException();
+        return;
+    }
+    if (host.empty() || port == 0 || port > 65535) {
+        Napi::TypeError::New(env, "host and port are required").ThrowAsJavaScriptException();
+        return;
+    }
+    if (protocol != "udp" && protocol != "tcp") {
+        Napi::TypeError::New(env, "protocol must be 'udp' or 'tcp'").ThrowAsJavaScriptException();
+        return;
+    }
+    if (channel > 255) {
+        Napi::RangeError::New(env, "channel must be 0-255").ThrowAsJavaScriptException();
+        return;
+    }
+    if (batchUs > 1000000) {
+        Napi::RangeError::New(env, "batchUs must be at most 1000000").ThrowAsJavaScriptException();
+        return;
+    }
+    if (maxPacket < 128 || maxPacket > kTunnelMaxPacket) {
+        Napi::RangeError::New(env, "maxPacketBytes must be 128-65507").ThrowAsJavaScriptException();
+        return;
+    }
+    tcp_ = protocol == "tcp";
+    channel_ = static_cast<uint8_t>(channel);
+    batch_us_ = batchUs;
+    max_packet_ = maxPacket;
+
+    std::string error = TunnelSocket::Resolve(host, static_cast<uint16_t>(port), remote_);
+    if (error.empty() && !tcp_) {
+        socket_ = std::make_shared<TunnelSocket>();
+        error = socket_->OpenUdpFor(remote_);
+        connected_ = error.empty();
+    }
+    if (!error.empty()) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return;
+    }
+
+    bus_ref_ = Napi::Persistent(info[0].As<Napi::Object>());
+    running_ = true;
+    send_thread_ = std::thread([this]() { SendLoop(); });
+    receive_thread_ = std::thread([this]() { ReceiveLoop(); });
+    tap_ = std::make_shared<Tap>(this);
+    bus_->AddTap(tap_);
+}
+
+CanTunnel::~CanTunnel() {
+    Shutdown();
+}
+
+void CanTunnel::Shutdown() {
+    if (!running_) {
+        return;
+    }
+    // RemoveTap waits for a tap call in progress, so no OnFrame runs after this.
+    bus_->RemoveTap(tap_.get());
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    send_thread_.join();
+    receive_thread_.join();
+    std::lock_guard<std::mutex> lock(socket_mutex_);
+    socket_.reset();
+    connected_ = false;
+}
+
+Napi::Value CanTunnel::Stats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object result = Napi::Object::New(env);
+    std::lock_guard<std::mutex> lock(mutex_);
+    result.Set("framesSent", Napi::Number::New(env, static_cast<double>(frames_)));
+    result.Set("packetsSent", Napi::Number::New(env, static_cast<double>(packets_)));
+    result.Set("bytesSent", Napi::Number::New(env, static_cast<double>(bytes_)));
+    result.Set("dropped", Napi::Number::New(env, static_cast<double>(dropped_)));
+    result.Set("sendErrors", Napi::Number::New(env, static_cast<double>(send_errors_)));
+    result.Set("packetsReceived", Napi::Number::New(env, static_cast<double>(rx_packets_)));
+    result.Set("framesReceived", Napi::Number::New(env, static_cast<double>(rx_frames_)));
+    result.Set("lost", Napi::Number::New(env, static_cast<double>(rx_sequence_.lost)));
+    result.Set("late", Napi::Number::New(env, static_cast<double>(rx_sequence_.late)));
+    result.Set("transmitErrors", Napi::Number::New(env, static_cast<double>(transmit_errors_)));
+    result.Set("connected", Napi::Boolean::New(env, connected_));
+    return result;
+}
+
+// Stops tunnelling; the CANBus stays open. Frames in the open packet are not sent.
+Napi::Value CanTunnel::Close(const Napi::CallbackInfo& info) {
+    Shutdown();
+    bus_ref_.Reset();
+    return info.Env().Undefined();
+}
+
+// Runs on the receive thread: appends to the open packet and leaves the socket to SendLoop.
+void CanTunnel::OnFrame(const CanFrame& frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!packet_open_) {
+        writer_.Begin(channel_, sequence_, max_packet_);
+        batch_start_us_ = HostMicros();
+        packet_open_ = true;
+        cv_.notify_one();
+    }
+    if (!writer_.Add(frame)) {
+        QueuePacket();
+        writer_.Begin(channel_, sequence_, max_packet_);
+        batch_start_us_ = HostMicros();
+        packet_open_ = true;
+        writer_.Add(frame);
+    }
+    frames_++;
+    if (batch_us_ == 0) {
+        QueuePacket();
+    }
+}
+
+// Closes the open packet and queues it for SendLoop; mutex_ held. A full queue drops the packet,
+// which the peer then counts as lost.
+void CanTunnel::QueuePacket() {
+    const std::vector<uint8_t>& packet = writer_.Finish();
+    packet_open_ = false;
+    sequence_++;
+    if (queue_.size() >= kMaxQueued) {
+        dropped_ += writer_.Count();
+        return;
+    }
+    std::vector<uint8_t> queued;
+    if (!spare_.empty()) {
+        queued.swap(spare_.back());
+        spare_.pop_back();
+    }
+    // Stored with the TCP length prefix; UDP skips it.
+    queued.resize(2 + packet.size());
+    queued[0] = static_cast<uint8_t>(packet.size() >> 8);
+    queued[1] = static_cast<uint8_t>(packet.size());
+    std::memcpy(queued.data() + 2, packet.data(), packet.size());
+    queue_.push_back(std::move(queued));
+    cv_.notify_one();
+}
+
+std::shared_ptr<TunnelSocket> CanTunnel::CurrentSocket() {
+    std::lock_guard<std::mutex> lock(socket_mutex_);
+    return socket_;
+}
+
+// Ships finished packets, closes the open one when its batch time is up and, over TCP, keeps the
+// connection up. Packets queued while TCP is down are dropped rather than held.
+void CanTunnel::SendLoop() {
+    auto nextConnect = std::chrono::steady_clock::now();
+    std::vector<uint8_t> packet;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        if (tcp_ && !connected_ && std::chrono::steady_clock::now() >= nextConnect) {
+            lock.unlock();
+            auto socket = std::make_shared<TunnelSocket>();
+            bool connected = socket->Connect(remote_, kReconnectMs).empty();
+            if (connected) {
+                std::lock_guard<std::mutex> socketLock(socket_mutex_);
+                socket_ = socket;
+                connected_ = true;
+            }
+            lock.lock();
+            nextConnect = std::chrono::steady_clock::now() + std::chrono::milliseconds(kReconnectMs);
+            continue;
+        }
+        if (queue_.empty()) {
+            auto due = std::chrono::steady_clock::now() + std::chrono::milliseconds(kReconnectMs);
+            if (packet_open_) {
+                int64_t wait = batch_start_us_ + batch_us_ - HostMicros();
+                if (wait <= 0) {
+                    QueuePacket();
+                    continue;
+                }
+                due = std::chrono::steady_clock::now() + std::chrono::microseconds(wait);
+            }
+            cv_.wait_until(lock, due);
+            continue;
+        }
+
+        packet.swap(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+        std::shared_ptr<TunnelSocket> socket = CurrentSocket();
+        bool sent = false;
+        if (connected_ && socket) {
+            sent = tcp_ ? socket->SendAll(packet.data(), packet.size())
+                        : socket->SendTo(packet.data() + 2, packet.size() - 2, remote_);
+            if (!sent && tcp_) {
+                connected_ = false;
+            }
+        }
+        lock.lock();
+        if (sent) {
+            packets_++;
+            bytes_ += packet.size() - 2;
+        } else {
+            send_errors_++;
+            dropped_ += QueuedFrameCount(packet);
+        }
+        if (spare_.size() < kMaxSpare) {
+            spare_.push_back(std::move(packet));
+        }
+        packet.clear();
+    }
+}
+
+// Reads packets coming back from the peer and transmits the frames for this channel on the bus.
+void CanTunnel::ReceiveLoop() {
+    std::vector<uint8_t> buffer(kTunnelMaxPacket);
+    std::vector<uint8_t> packet;
+    TunnelStream stream;
+    std::shared_ptr<TunnelSocket> current;
+    while (running_) {
+        std::shared_ptr<TunnelSocket> socket = CurrentSocket();
+        if (!socket || !connected_) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+        if (!tcp_) {
+            TunnelAddress from;
+            int received = socket->ReceiveFrom(buffer.data(), buffer.size(), from, 100);
+            if (received > 0) {
+                Receive(buffer.data(), static_cast<size_t>(received));
+            }
+            continue;
+        }
+        if (socket != current) {
+            stream = TunnelStream();
+            current = socket;
+        }
+        int received = socket->Receive(buffer.data(), buffer.size(), 100);
+        if (received < 0) {
+            // Only the connection still in use; SendLoop may have replaced it already.
+            if (socket == CurrentSocket()) {
+                connected_ = false;
+                cv_.notify_all();
+            }
+            current.reset();
+            continue;
+        }
+        stream.Append(buffer.data(), static_cast<size_t>(received));
+        while (stream.Next(packet)) {
+            Receive(packet.data(), packet.size());
+        }
+    }
+}
+
+void CanTunnel::Receive(const uint8_t* data, size_t size) {
+    TunnelPacketInfo info;
+    decoded_.clear();
+    if (!DecodeTunnelPacket(data, size, info, decoded_).empty() || info.channel != channel_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!rx_sequence_.Accept(info.sequence)) {
+            return;
+        }
+        rx_packets_++;
+        rx_frames_ += decoded_.size();
+    }
+    for (const CanFrame& frame : decoded_) {
+        if (!bus_->Transmit(frame).empty()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            transmit_errors_++;
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef ACE_CAN_CAN_TUNNEL_H
+#define ACE_CAN_CAN_TUNNEL_H
+
+#include <napi.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "frame_tap.h"
+#include "tunnel.h"
+
+class CANBus;
+
+// Sending end of a tunnel: forwards every frame received on a CANBus to a remote TunnelLink (a
+// CANBus of bustype 'udp' / 'tcp' there). The receive tap only appends to the open packet; a send
+// thread ships it when it is full or batchUs after its first frame, so one datagram carries a
+// burst of frames. Frames the remote side sends back on the channel are transmitted on the bus.
+class CanTunnel : public Napi::ObjectWrap<CanTunnel> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    CanTunnel(const Napi::CallbackInfo& info);
+    ~CanTunnel();
+
+    Napi::Value Stats(const Napi::CallbackInfo& info);
+    Napi::Value Close(const Napi::CallbackInfo& info);
+
+private:
+    class Tap : public FrameTap {
+    public:
+        explicit Tap(CanTunnel* owner) : owner_(owner) {}
+        void OnFrame(const CanFrame& frame, int64_t) override { owner_->OnFrame(frame); }
+
+    private:
+        CanTunnel* owner_;
+    };
+
+    static constexpr size_t kMaxQueued = 1024; // finished packets waiting for the socket
+    static constexpr int kReconnectMs = 1000;
+
+    void OnFrame(const CanFrame& frame);
+    void QueuePacket();
+    void SendLoop();
+    void ReceiveLoop();
+    void Receive(const uint8_t* data, size_t size);
+    std::shared_ptr<TunnelSocket> CurrentSocket();
+    void Shutdown();
+
+    CANBus* bus_ = nullptr;
+    Napi::ObjectReference bus_ref_;
+    bool tcp_ = false;
+    TunnelAddress remote_;
+    uint8_t channel_ = 0;
+    int64_t batch_us_ = 1000;
+    size_t max_packet_ = 1400;
+
+    std::shared_ptr<Tap> tap_;
+    std::thread send_thread_;
+    std::thread receive_thread_;
+    std::atomic<bool> running_{false};
+
+    std::mutex socket_mutex_; // guards socket_; TCP reconnects replace it
+    std::shared_ptr<TunnelSocket> socket_;
+    std::atomic<bool> connected_{false};
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    TunnelPacketWriter writer_;
+    bool packet_open_ = false;
+    int64_t batch_start_us_ = 0; // HostMicros() of the open packet's first frame
+    uint32_t sequence_ = 0;
+    std::deque<std::vector<uint8_t>> queue_; // finished packets, 16-bit length prefixed
+    std::vector<std::vector<uint8_t>> spare_; // sent packet buffers, reused
+    uint64_t frames_ = 0;
+    uint64_t packets_ = 0;
+    uint64_t bytes_ = 0;
+    uint64_t dropped_ = 0;
+    uint64_t send_errors_ = 0;
+
+    // Receive thread; read under mutex_ by stats().
+    TunnelSequence rx_sequence_;
+    uint64_t rx_packets_ = 0;
+    uint64_t rx_frames_ = 0;
+    uint64_t transmit_errors_ = 0;
+    std::vector<CanFrame> decoded_;
+};
+
+#endif // ACE_CAN_CAN_TUNNEL_H
@@ -0,0 +1,408 @@
+#include "compiled_db.h"
+
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "mapped_file.h"
+
+namespace {
+
+constexpr char kImageMagic[8] = {'A', 'C', 'E', 'D', 'B', '\r', '\n', '\x1a'};
+constexpr uint32_t kImageVersion = 1;
+constexpr uint32_t kNoString = 0xFFFFFFFFu;
+constexpr size_t kHashChunkSize = 1 << 20;
+
+// On-disk records. Every section starts 8-byte aligned, so a mapped image can be read in place.
+struct ImageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t source_hash;
+    uint64_t source_size;
+    uint64_t body_hash; // XXH64 of everything after the header
+    uint32_t message_count;
+    uint32_t signal_count;
+    uint64_t messages_offset;
+    uint64_t signals_offset;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+};
+
+struct ImageMessage {
+    uint32_t id;
+    uint32_t name;
+    uint32_t first_signal;
+    uint32_t signal_count;
+    uint16_t length;
+    uint8_t extended;
+    uint8_t fd;
+    uint8_t has_e2e;
+    uint8_t has_secoc;
+    uint16_t reserved;
+    uint32_t e2e_profile;
+    uint32_t e2e_data_id;
+    uint32_t e2e_data_length;
+    uint32_t e2e_crc_offset;
+    uint32_t e2e_counter_offset;
+    uint32_t secoc_data_id;
+    uint32_t secoc_payload_length;
+    uint32_t secoc_freshness_bits;
+    uint32_t secoc_mac_bits;
+    uint32_t secoc_algorithm;
+};
+
+struct ImageSignal {
+    double factor;
+    double offset;
+    double minimum;
+    double maximum;
+    uint32_t name;
+    uint32_t unit;
+    int32_t mux;
+    uint16_t start_bit;
+    uint16_t length;
+    uint8_t little_endian;
+    uint8_t is_signed;
+    uint8_t value_type;
+    uint8_t reserved[5];
+};
+
+static_assert(sizeof(ImageHeader) == 80, "ImageHeader layout");
+static_assert(sizeof(ImageMessage) == 64, "ImageMessage layout");
+static_assert(sizeof(ImageSignal) == 56, "ImageSignal layout");
+
+// XXH64 (seed 0), fed incrementally.
+class Xxh64 {
+public:
+    void Update(const uint8_t* data, size_t length) {
+        total_ += length;
+        if (buffered_ + length < sizeof(buffer_)) {
+            std::memcpy(buffer_ + buffered_, data, length);
+            buffered_ += length;
+            return;
+        }
+        if (buffered_ > 0) {
+            size_t fill = sizeof(buffer_) - buffered_;
+            std::memcpy(buffer_ + buffered_, data, fill);
+            Stripe(buffer_);
+            data += fill;
+            length -= fill;
+            buffered_ = 0;
+        }
+        while (length >= sizeof(buffer_)) {
+            Stripe(data);
+            data += sizeof(buffer_);
+            length -= sizeof(buffer_);
+        }
+        std::memcpy(buffer_, data, length);
+        buffered_ = length;
+    }
+
+    uint64_t Digest() const {
+        uint64_t h = 0;
+        if (total_ >= sizeof(buffer_)) {
+            h = Rotl(v_[0], 1) + Rotl(v_[1], 7) + Rotl(v_[2], 12) + Rotl(v_[3], 18);
+            for (uint64_t v : v_) {
+                h ^= Round(0, v);
+                h = h * kPrime1 + kPrime4;
+            }
+        } else {
+            h = kPrime5;
+        }
+        h += total_;
+        const uint8_t* p = buffer_;
+        size_t left = buffered_;
+        for (; left >= 8; p += 8, left -= 8) {
+            h ^= Round(0, Read64(p));
+            h = Rotl(h, 27) * kPrime1 + kPrime4;
+        }
+        if (left >= 4) {
+            uint32_t word = 0;
+            std::memcpy(&word, p, sizeof(word));
+            h ^= word * kPrime1;
+            h = Rotl(h, 23) * kPrime2 + kPrime3;
+            p += 4;
+            left -= 4;
+        }
+        for (; left > 0; ++p, --left) {
+            h ^= *p * kPrime5;
+            h = Rotl(h, 11) * kPrime1;
+        }
+        h ^= h >> 33;
+        h *= kPrime2;
+        h ^= h >> 29;
+        h *= kPrime3;
+        h ^= h >> 32;
+        return h;
+    }
+
+private:
+    static constexpr uint64_t kPrime1 = 11400714785074694791ULL;
+    static constexpr uint64_t kPrime2 = 14029467366897019727ULL;
+    static constexpr uint64_t kPrime3 = 1609587929392839161ULL;
+    static constexpr uint64_t kPrime4 = 9650029242287828579ULL;
+    static constexpr uint64_t kPrime5 = 2870177450012600261ULL;
+
+    static uint64_t Rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+    static uint64_t Read64(const uint8_t* p) {
+        uint64_t v = 0;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    static uint64_t Round(uint64_t acc, uint64_t input) {
+        acc += input * kPrime2;
+        return Rotl(acc, 31) * kPrime1;
+    }
+    void Stripe(const uint8_t* p) {
+        for (int i = 0; i < 4; ++i) {
+            v_[i] = Round(v_[i], Read64(p + 8 * i));
+        }
+    }
+
+    uint64_t v_[4] = {kPrime1 + kPrime2, kPrime2, 0, 0 - kPrime1};
+    uint8_t buffer_[32] = {};
+    size_t buffered_ = 0;
+    uint64_t total_ = 0;
+};
+
+size_t Align8(size_t n) {
+    return (n + 7) & ~size_t{7};
+}
+
+class StringPool {
+public:
+    uint32_t Add(const std::string& value) {
+        auto it = offsets_.find(value);
+        if (it != offsets_.end()) {
+            return it->second;
+        }
+        uint32_t offset = static_cast<uint32_t>(data_.size());
+        data_.insert(data_.end(), value.begin(), value.end());
+        data_.push_back('\0');
+        offsets_.emplace(value, offset);
+        return offset;
+    }
+    const std::vector<char>& Data() const { return data_; }
+
+private:
+    std::vector<char> data_;
+    std::unordered_map<std::string, uint32_t> offsets_;
+};
+
+} // namespace
+
+std::string FingerprintFile(const std::string& path, SourceFingerprint& out) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return "Failed to open database: " + path;
+    }
+    std::vector<uint8_t> chunk(kHashChunkSize);
+    Xxh64 hash;
+    uint64_t size = 0;
+    size_t n = 0;
+    while ((n = std::fread(chunk.data(), 1, chunk.size(), file)) > 0) {
+        hash.Update(chunk.data(), n);
+        size += n;
+    }
+    bool failed = std::ferror(file) != 0;
+    std::fclose(file);
+    if (failed) {
+        return "Failed to read database: " + path;
+    }
+    out.hash = hash.Digest();
+    out.size = size;
+    return std::string();
+}
+
+std::string SaveCompiledTables(const std::string& path, const DecodeTables& tables, const SourceFingerprint& source) {
+    StringPool strings;
+    std::vector<ImageMessage> messages;
+    std::vector<ImageSignal> signals;
+    messages.reserve(tables.messages.size());
+    for (const MessageDef& message : tables.messages) {
+        ImageMessage record = {};
+        record.id = message.id;
+        record.name = strings.Add(message.name);
+        record.first_signal = static_cast<uint32_t>(signals.size());
+        record.signal_count = static_cast<uint32_t>(message.signals.size());
+        record.length = message.length;
+        record.extended = message.extended ? 1 : 0;
+        record.fd = message.fd ? 1 : 0;
+        record.e2e_profile = kNoString;
+        record.secoc_algorithm = kNoString;
+        if (message.e2e) {
+            record.has_e2e = 1;
+            record.e2e_profile = strings.Add(message.e2e->profile);
+            record.e2e_data_id = message.e2e->data_id;
+            record.e2e_data_length = message.e2e->data_length;
+            record.e2e_crc_offset = message.e2e->crc_offset;
+            record.e2e_counter_offset = message.e2e->counter_offset;
+        }
+        if (message.secoc) {
+            record.has_secoc = 1;
+            record.secoc_data_id = message.secoc->data_id;
+            record.secoc_payload_length = message.secoc->payload_length;
+            record.secoc_freshness_bits = message.secoc->freshness_tx_bits;
+            record.secoc_mac_bits = message.secoc->mac_tx_bits;
+            record.secoc_algorithm = strings.Add(message.secoc->algorithm);
+        }
+        messages.push_back(record);
+
+        for (const SignalDef& signal : message.signals) {
+            ImageSignal entry = {};
+            entry.factor = signal.factor;
+            entry.offset = signal.offset;
+            entry.minimum = signal.minimum;
+            entry.maximum = signal.maximum;
+            entry.name = strings.Add(signal.name);
+            entry.unit = strings.Add(signal.unit);
+            entry.mux = signal.mux;
+            entry.start_bit = signal.start_bit;
+            entry.length = signal.length;
+            entry.little_endian = signal.little_endian ? 1 : 0;
+            entry.is_signed = signal.is_signed ? 1 : 0;
+            entry.value_type = static_cast<uint8_t>(signal.value_type);
+            signals.push_back(entry);
+        }
+    }
+
+    ImageHeader header = {};
+    std::memcpy(header.magic, kImageMagic, sizeof(kImageMagic));
+    header.version = kImageVersion;
+    header.header_size = sizeof(ImageHeader);
+    header.source_hash = source.hash;
+    header.source_size = source.size;
+    header.message_count = static_cast<uint32_t>(messages.size());
+    header.signal_count = static_cast<uint32_t>(signals.size());
+    header.messages_offset = sizeof(ImageHeader);
+    header.signals_offset = header.messages_offset + messages.size() * sizeof(ImageMessage);
+    header.strings_offset = header.signals_offset + signals.size() * sizeof(ImageSignal);
+    header.strings_size = strings.Data().size();
+
+    std::vector<uint8_t> body(Align8(header.strings_offset + header.strings_size) - sizeof(ImageHeader), 0);
+    uint8_t* cursor = body.data();
+    std::memcpy(cursor, messages.data(), messages.size() * sizeof(ImageMessage));
+    cursor += messages.size() * sizeof(ImageMessage);
+    std::memcpy(cursor, signals.data(), signals.size() * sizeof(ImageSignal));
+    cursor += signals.size() * sizeof(ImageSignal);
+    std::memcpy(cursor, strings.Data().data(), strings.Data().size());
+    Xxh64 bodyHash;
+    bodyHash.Update(body.data(), body.size());
+    header.body_hash = bodyHash.Digest();
+
+    // Write next to the target and rename, so a concurrent reader never maps a partial image.
+    std::string tmpPath = path + ".tmp";
+    std::FILE* file = std::fopen(tmpPath.c_str(), "wb");
+    if (file == nullptr) {
+        return "Failed to create compiled database: " + tmpPath;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              (body.empty() || std::fwrite(body.data(), body.size(), 1, file) == 1);
+    ok = std::fclose(file) == 0 && ok;
+    if (ok) {
+#ifdef _WIN32
+        std::remove(path.c_str());
+#endif
+        ok = std::rename(tmpPath.c_str(), path.c_str()) == 0;
+    }
+    if (!ok) {
+        std::remove(tmpPath.c_str());
+        return "Failed to write compiled database: " + path;
+    }
+    return std::string();
+}
+
+std::string LoadCompiledTables(const std::string& path, const SourceFingerprint& source, DecodeTables& tables) {
+    MappedFile file;
+    std::string error = file.Open(path);
+    if (!error.empty()) {
+        return error;
+    }
+    const uint8_t* base = file.Data();
+    size_t size = file.Size();
+    if (size < sizeof(ImageHeader)) {
+        return "Compiled database is truncated";
+    }
+    const ImageHeader& header = *reinterpret_cast<const ImageHeader*>(base);
+    if (std::memcmp(header.magic, kImageMagic, sizeof(kImageMagic)) != 0 || header.version != kImageVersion ||
+        header.header_size != sizeof(ImageHeader)) {
+        return "Unsupported compiled database format";
+    }
+    if (header.source_hash != source.hash || header.source_size != source.size) {
+        return "Compiled database is out of date";
+    }
+    if (header.messages_offset != sizeof(ImageHeader) ||
+        header.signals_offset != header.messages_offset + uint64_t{header.message_count} * sizeof(ImageMessage) ||
+        header.strings_offset != header.signals_offset + uint64_t{header.signal_count} * sizeof(ImageSignal) ||
+        header.strings_offset + header.strings_size > size) {
+        return "Compiled database is truncated";
+    }
+    Xxh64 bodyHash;
+    bodyHash.Update(base + sizeof(ImageHeader), size - sizeof(ImageHeader));
+    if (bodyHash.Digest() != header.body_hash) {
+        return "Compiled database is corrupt";
+    }
+
+    const ImageMessage* messages = reinterpret_cast<const ImageMessage*>(base + header.messages_offset);
+    const ImageSignal* signals = reinterpret_cast<const ImageSignal*>(base + header.signals_offset);
+    const char* strings = reinterpret_cast<const char*>(base + header.strings_offset);
+    // The body hash matched, so offsets are as written; the pool ends in a NUL whenever it is
+    // non-empty.
+    auto str = [&](uint32_t offset) {
+        return offset < header.strings_size ? std::string(strings + offset) : std::string();
+    };
+
+    tables.messages.reserve(tables.messages.size() + header.message_count);
+    tables.index.reserve(tables.index.size() + header.message_count);
+    for (uint32_t i = 0; i < header.message_count; ++i) {
+        const ImageMessage& record = messages[i];
+        if (uint64_t{record.first_signal} + record.signal_count > header.signal_count) {
+            return "Compiled database is corrupt";
+        }
+        MessageDef message;
+        message.name = str(record.name);
+        message.id = record.id;
+        message.extended = record.extended != 0;
+        message.fd = record.fd != 0;
+        message.length = record.length;
+        if (record.has_e2e != 0) {
+            E2EProtection e2e;
+            e2e.profile = str(record.e2e_profile);
+            e2e.data_id = record.e2e_data_id;
+            e2e.data_length = record.e2e_data_length;
+            e2e.crc_offset = record.e2e_crc_offset;
+            e2e.counter_offset = record.e2e_counter_offset;
+            message.e2e = std::move(e2e);
+        }
+        if (record.has_secoc != 0) {
+            SecOcProps secoc;
+            secoc.data_id = record.secoc_data_id;
+            secoc.payload_length = record.secoc_payload_length;
+            secoc.freshness_tx_bits = record.secoc_freshness_bits;
+            secoc.mac_tx_bits = record.secoc_mac_bits;
+            secoc.algorithm = str(record.secoc_algorithm);
+            message.secoc = std::move(secoc);
+        }
+        message.signals.resize(record.signal_count);
+        for (uint32_t j = 0; j < record.signal_count; ++j) {
+            const ImageSignal& entry = signals[record.first_signal + j];
+            SignalDef& signal = message.signals[j];
+            signal.name = str(entry.name);
+            signal.unit = str(entry.unit);
+            signal.factor = entry.factor;
+            signal.offset = entry.offset;
+            signal.minimum = entry.minimum;
+            signal.maximum = entry.maximum;
+            signal.mux = entry.mux;
+            signal.start_bit = entry.start_bit;
+            signal.length = entry.length;
+            signal.little_endian = entry.little_endian != 0;
+            signal.is_signed = entry.is_signed != 0;
+            signal.value_type = static_cast<SignalDef::ValueType>(entry.value_type);
+        }
+        tables.Add(std::move(message));
+    }
+    return std::string();
+}
@@ -0,0 +1,26 @@
+#ifndef ACE_CAN_COMPILED_DB_H
+#define ACE_CAN_COMPILED_DB_H
+
+#include <cstdint>
+#include <string>
+
+#include "decode_tables.h"
+
+// Identity of a database source file: XXH64 of its content plus its size.
+struct SourceFingerprint {
+    uint64_t hash = 0;
+    uint64_t size = 0;
+};
+
+std::string FingerprintFile(const std::string& path, SourceFingerprint& out);
+
+// Compiled image of DecodeTables: a header, fixed-size message and signal records and one string
+// pool, all addressed by offsets, so the file is memory-mapped and turned back into tables without
+// any parsing. The header records the source fingerprint; an image built from different source
+// content is rejected. Images are written in the host's (little-endian) byte order.
+std::string SaveCompiledTables(const std::string& path, const DecodeTables& tables, const SourceFingerprint& source);
+// Appends the image's messages to `tables`; returns why the image cannot be used, or an empty
+// string on success.
+std::string LoadCompiledTables(const std::string& path, const SourceFingerprint& source, DecodeTables& tables);
+
+#endif // ACE_CAN_COMPILED_DB_H
@@ -0,0 +1,277 @@
+#include "decode_tables.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+constexpr uint32_t kDbcExtendedFlag = 0x80000000u;
+constexpr int kDbcFrameFormatFd = 14; // VFrameFormat StandardCAN_FD; 15 = ExtendedCAN_FD
+
+uint64_t MessageKey(uint32_t id, bool extended) {
+    return (extended ? (uint64_t{1} << 32) : 0) | id;
+}
+
+const char* SkipSpaces(const char* text) {
+    while (*text == ' ' || *text == '\t') {
+        ++text;
+    }
+    return text;
+}
+
+bool StartsWith(const char* text, const char* prefix) {
+    return std::strncmp(text, prefix, std::strlen(prefix)) == 0;
+}
+
+//  SG_ <name> [M|m<n>] : <start>|<length>@<1|0><+|-> (<factor>,<offset>) [<min>|<max>] "<unit>" <receivers>
+bool ParseDbcSignal(const char* text, SignalDef& signal) {
+    char name[256] = {};
+    int consumed = 0;
+    if (std::sscanf(text, " %255s %n", name, &consumed) != 1) {
+        return false;
+    }
+    text += consumed;
+    size_t nameLength = std::strlen(name);
+    bool colon = nameLength > 1 && name[nameLength - 1] == ':';
+    if (colon) {
+        name[nameLength - 1] = '\0';
+    }
+    signal.name = name;
+
+    if (!colon && *text != ':') {
+        char mux[32] = {};
+        if (std::sscanf(text, "%31s %n", mux, &consumed) != 1) {
+            return false;
+        }
+        text += consumed;
+        if (mux[0] == 'M') {
+            signal.mux = SignalDef::kMultiplexor;
+        } else if (mux[0] == 'm') {
+            // "m<n>M" (extended multiplexing) is read as a plain multiplexed signal.
+            signal.mux = static_cast<int32_t>(std::strtol(mux + 1, nullptr, 10));
+        } else {
+            return false;
+        }
+    }
+    if (!colon) {
+        if (*text != ':') {
+            return false;
+        }
+        ++text;
+    }
+
+    unsigned start = 0;
+    unsigned length = 0;
+    char order = 0;
+    char sign = 0;
+    if (std::sscanf(text, " %u|%u@%c%c (%lf,%lf) [%lf|%lf] %n", &start, &length, &order, &sign, &signal.factor,
+                    &signal.offset, &signal.minimum, &signal.maximum, &consumed) != 8) {
+        return false;
+    }
+    if (length == 0 || length > 64 || start > 511 || (order != '0' && order != '1') || (sign != '+' && sign != '-')) {
+        return false;
+    }
+    signal.start_bit = static_cast<uint16_t>(start);
+    signal.length = static_cast<uint16_t>(length);
+    signal.little_endian = order == '1';
+    signal.is_signed = sign == '-';
+
+    text += consumed;
+    if (*text == '"') {
+        const char* end = std::strchr(text + 1, '"');
+        if (end != nullptr) {
+            signal.unit.assign(text + 1, end);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+void DecodeTables::Add(MessageDef message) {
+    uint64_t key = MessageKey(message.id, message.extended);
+    auto it = index.find(key);
+    if (it != index.end()) {
+        messages[it->second] = std::move(message);
+        return;
+    }
+    index.emplace(key, messages.size());
+    messages.push_back(std::move(message));
+}
+
+const MessageDef* DecodeTables::Find(uint32_t id, bool extended) const {
+    auto it = index.find(MessageKey(id, extended));
+    return it == index.end() ? nullptr : &messages[it->second];
+}
+
+bool ExtractRaw(const SignalDef& signal, const uint8_t* data, size_t length, uint64_t& raw) {
+    raw = 0;
+    if (signal.little_endian) {
+        if ((static_cast<size_t>(signal.start_bit) + signal.length + 7) / 8 > length) {
+            return false;
+        }
+        for (uint32_t i = 0; i < signal.length; ++i) {
+            uint32_t bit = signal.start_bit + i;
+            raw |= static_cast<uint64_t>((data[bit / 8] >> (bit % 8)) & 1) << i;
+        }
+        return true;
+    }
+    // Walk from the MSB down: within a byte towards bit 0, then on to bit 7 of the next byte.
+    uint32_t bit = signal.start_bit;
+    for (uint32_t i = 0; i < signal.length; ++i) {
+        if (bit / 8 >= length) {
+            return false;
+        }
+        raw = (raw << 1) | ((data[bit / 8] >> (bit % 8)) & 1);
+        bit = (bit % 8 == 0) ? bit + 15 : bit - 1;
+    }
+    return true;
+}
+
+double PhysicalValue(const SignalDef& signal, uint64_t raw) {
+    double value = 0.0;
+    if (signal.value_type == SignalDef::ValueType::Float32) {
+        uint32_t bits = static_cast<uint32_t>(raw);
+        float f = 0.0f;
+        std::memcpy(&f, &bits, sizeof(f));
+        value = f;
+    } else if (signal.value_type == SignalDef::ValueType::Float64) {
+        std::memcpy(&value, &raw, sizeof(value));
+    } else if (signal.is_signed && signal.length < 64 && ((raw >> (signal.length - 1)) & 1) != 0) {
+        value = static_cast<double>(static_cast<int64_t>(raw | (~uint64_t{0} << signal.length)));
+    } else if (signal.is_signed) {
+        value = static_cast<double>(static_cast<int64_t>(raw));
+    } else {
+        value = static_cast<double>(raw);
+    }
+    return value * signal.factor + signal.offset;
+}
+
+uint64_t RawValue(const SignalDef& signal, double physical) {
+    double scaled = (physical - signal.offset) / signal.factor;
+    uint64_t raw = 0;
+    if (signal.value_type == SignalDef::ValueType::Float32) {
+        float f = static_cast<float>(scaled);
+        uint32_t bits = 0;
+        std::memcpy(&bits, &f, sizeof(bits));
+        raw = bits;
+    } else if (signal.value_type == SignalDef::ValueType::Float64) {
+        std::memcpy(&raw, &scaled, sizeof(raw));
+    } else {
+        raw = static_cast<uint64_t>(std::llround(scaled));
+    }
+    if (signal.length < 64) {
+        raw &= (uint64_t{1} << signal.length) - 1;
+    }
+    return raw;
+}
+
+bool InsertRaw(const SignalDef& signal, uint64_t raw, uint8_t* data, size_t length) {
+    if (signal.little_endian) {
+        if ((static_cast<size_t>(signal.start_bit) + signal.length + 7) / 8 > length) {
+            return false;
+        }
+        for (uint32_t i = 0; i < signal.length; ++i) {
+            uint32_t bit = signal.start_bit + i;
+            uint8_t mask = static_cast<uint8_t>(1u << (bit % 8));
+            data[bit / 8] = ((raw >> i) & 1) != 0 ? (data[bit / 8] | mask) : (data[bit / 8] & ~mask);
+        }
+        return true;
+    }
+    // Same walk as ExtractRaw; check the whole span first so a short payload is left unchanged.
+    uint32_t bit = signal.start_bit;
+    for (uint32_t i = 0; i < signal.length; ++i) {
+        if (bit / 8 >= length) {
+            return false;
+        }
+        bit = (bit % 8 == 0) ? bit + 15 : bit - 1;
+    }
+    bit = signal.start_bit;
+    for (uint32_t i = signal.length; i-- > 0;) {
+        uint8_t mask = static_cast<uint8_t>(1u << (bit % 8));
+        data[bit / 8] = ((raw >> i) & 1) != 0 ? (data[bit / 8] | mask) : (data[bit / 8] & ~mask);
+        bit = (bit % 8 == 0) ? bit + 15 : bit - 1;
+    }
+    return true;
+}
+
+std::string LoadDbc(const std::string& path, DecodeTables& tables) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return "Failed to open database: " + path;
+    }
+
+    std::vector<MessageDef> messages;
+    std::unordered_map<uint32_t, size_t> byDbcId;
+    MessageDef* current = nullptr;
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        const char* text = SkipSpaces(line.c_str());
+
+        if (StartsWith(text, "BO_ ")) {
+            unsigned long dbcId = 0;
+            char name[256] = {};
+            unsigned length = 0;
+            if (std::sscanf(text, "BO_ %lu %255[^: ] : %u", &dbcId, name, &length) != 3) {
+                return "Invalid message definition at line " + std::to_string(lineNumber);
+            }
+            MessageDef message;
+            message.name = name;
+            message.extended = (dbcId & kDbcExtendedFlag) != 0;
+            message.id = static_cast<uint32_t>(dbcId) & 0x1FFFFFFFu;
+            message.length = static_cast<uint16_t>(length);
+            message.fd = length > 8;
+            byDbcId[static_cast<uint32_t>(dbcId)] = messages.size();
+            messages.push_back(std::move(message));
+            current = &messages.back();
+        } else if (StartsWith(text, "SG_ ")) {
+            if (current == nullptr) {
+                continue;
+            }
+            SignalDef signal;
+            if (!ParseDbcSignal(text + 4, signal)) {
+                return "Invalid signal definition at line " + std::to_string(lineNumber);
+            }
+            current->signals.push_back(std::move(signal));
+        } else {
+            current = nullptr;
+            unsigned long dbcId = 0;
+            char name[256] = {};
+            int value = 0;
+            if (std::sscanf(text, "BA_ \"VFrameFormat\" BO_ %lu %d", &dbcId, &value) == 2) {
+                auto it = byDbcId.find(static_cast<uint32_t>(dbcId));
+                if (it != byDbcId.end() && value >= kDbcFrameFormatFd) {
+                    messages[it->second].fd = true;
+                }
+            } else if (std::sscanf(text, "SIG_VALTYPE_ %lu %255s : %d", &dbcId, name, &value) == 3) {
+                auto it = byDbcId.find(static_cast<uint32_t>(dbcId));
+                if (it == byDbcId.end()) {
+                    continue;
+                }
+                for (SignalDef& signal : messages[it->second].signals) {
+                    if (signal.name == name) {
+                        signal.value_type = value == 1 ? SignalDef::ValueType::Float32
+                                          : value == 2 ? SignalDef::ValueType::Float64
+                                                       : SignalDef::ValueType::Integer;
+                    }
+                }
+            }
+        }
+    }
+
+    for (MessageDef& message : messages) {
+        if (message.name == "VECTOR__INDEPENDENT_SIG_MSG") { // holder for signals not sent by any node
+            continue;
+        }
+        tables.Add(std::move(message));
+    }
+    return std::string();
+}
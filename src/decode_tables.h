@@ -0,0 +1,109 @@
+#ifndef ACE_CAN_DECODE_TABLES_H
+#define ACE_CAN_DECODE_TABLES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Signal and message definitions shared by every database importer (DBC, ARXML). Bit positions
+// follow the DBC convention whatever the source: the LSB for little-endian signals and the MSB,
+// in Motorola "sawtooth" numbering, for big-endian ones.
+struct SignalDef {
+    static constexpr int32_t kNotMultiplexed = -1;
+    static constexpr int32_t kMultiplexor = -2;
+
+    enum class ValueType : uint8_t { Integer, Float32, Float64 };
+
+    std::string name;
+    uint16_t start_bit = 0;
+    uint16_t length = 0;
+    bool little_endian = true;
+    bool is_signed = false;
+    ValueType value_type = ValueType::Integer;
+    int32_t mux = kNotMultiplexed; // kMultiplexor, or the multiplexor value the signal appears under
+    double factor = 1.0;
+    double offset = 0.0;
+    double minimum = 0.0;
+    double maximum = 0.0;
+    std::string unit;
+};
+
+// AUTOSAR E2E protection of the message's PDU; offsets are in bits from the start of the PDU.
+struct E2EProtection {
+    std::string profile;
+    uint32_t data_id = 0;
+    uint32_t data_length = 0;
+    uint32_t crc_offset = 0;
+    uint32_t counter_offset = 0;
+};
+
+// AUTOSAR SecOC: the authentic PDU is followed by the truncated freshness value and MAC.
+struct SecOcProps {
+    uint32_t data_id = 0;
+    uint32_t payload_length = 0; // bytes of the authentic PDU
+    uint32_t freshness_tx_bits = 0;
+    uint32_t mac_tx_bits = 0;
+    std::string algorithm;
+};
+
+struct MessageDef {
+    std::string name;
+    uint32_t id = 0;
+    bool extended = false;
+    bool fd = false;
+    uint16_t length = 0;
+    std::vector<SignalDef> signals;
+    std::optional<E2EProtection> e2e;
+    std::optional<SecOcProps> secoc;
+};
+
+struct DecodeTables {
+    std::vector<MessageDef> messages;
+    std::unordered_map<uint64_t, size_t> index; // (extended << 32 | id) -> messages
+
+    // Adds a message, replacing an earlier one with the same ID.
+    void Add(MessageDef message);
+    const MessageDef* Find(uint32_t id, bool extended) const;
+};
+
+// Raw bits of one signal; false if the signal does not fit in `length` bytes of data.
+bool ExtractRaw(const SignalDef& signal, const uint8_t* data, size_t length, uint64_t& raw);
+double PhysicalValue(const SignalDef& signal, uint64_t raw);
+// Inverse of PhysicalValue, rounded to the nearest raw value and truncated to the signal's length.
+uint64_t RawValue(const SignalDef& signal, double physical);
+// Writes the signal's bits, leaving the rest of the payload untouched; false if it does not fit.
+bool InsertRaw(const SignalDef& signal, uint64_t raw, uint8_t* data, size_t length);
+
+// Calls sink(signal, value) for every signal present in the payload. Multiplexed signals are
+// skipped unless the multiplexor currently selects them.
+template <typename Sink>
+void DecodeMessage(const MessageDef& message, const uint8_t* data, size_t length, Sink&& sink) {
+    int64_t selector = -1;
+    for (const SignalDef& signal : message.signals) {
+        uint64_t raw = 0;
+        if (signal.mux == SignalDef::kMultiplexor && ExtractRaw(signal, data, length, raw)) {
+            selector = static_cast<int64_t>(raw);
+            break;
+        }
+    }
+    for (const SignalDef& signal : message.signals) {
+        if (signal.mux >= 0 && signal.mux != selector) {
+            continue;
+        }
+        uint64_t raw = 0;
+        if (ExtractRaw(signal, data, length, raw)) {
+            sink(signal, PhysicalValue(signal, raw));
+        }
+    }
+}
+
+// Loaders append to `tables`; they return an error message, or an empty string on success.
+std::string LoadDbc(const std::string& path, DecodeTables& tables);
+// AUTOSAR 4.x system description (arxml_import.cpp). Streams the file through a pull parser, so
+// memory grows with the number of frames and signals, not with the size of the XML.
+std::string LoadArxml(const std::string& path, DecodeTables& tables);
+
+#endif // ACE_CAN_DECODE_TABLES_H
@@ -0,0 +1,315 @@
+#include "decoder_codegen.h"
+
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
+namespace {
+
+// Extraction and insertion helpers of the generated file. Signal bits are numbered linearly:
+// little-endian signals start at their LSB (bit b = byte b / 8, bit b % 8); big-endian ones at
+// their MSB in MSB-first order (bit p = byte p / 8, bit 7 - p % 8). Each payload byte the signal
+// touches becomes one masked shift, unrolled by a fold expression over the byte range.
+constexpr const char* kPrelude = R"(namespace {
+
+template <unsigned A, unsigned B>
+constexpr unsigned kMax = A > B ? A : B;
+template <unsigned A, unsigned B>
+constexpr unsigned kMin = A < B ? A : B;
+
+template <bool Le, unsigned First, unsigned Length, unsigned Byte>
+inline uint64_t ExtractChunk(const uint8_t* data) {
+    constexpr unsigned kFrom = kMax<First, Byte * 8>;
+    constexpr unsigned kTo = kMin<First + Length, Byte * 8 + 8>;
+    constexpr unsigned kBits = (1u << (kTo - kFrom)) - 1;
+    if constexpr (Le) {
+        return static_cast<uint64_t>((data[Byte] >> (kFrom - Byte * 8)) & kBits) << (kFrom - First);
+    } else {
+        return static_cast<uint64_t>((data[Byte] >> (Byte * 8 + 8 - kTo)) & kBits) << (First + Length - kTo);
+    }
+}
+
+template <bool Le, unsigned First, unsigned Length, unsigned Byte>
+inline void InsertChunk(uint8_t* data, uint64_t raw) {
+    constexpr unsigned kFrom = kMax<First, Byte * 8>;
+    constexpr unsigned kTo = kMin<First + Length, Byte * 8 + 8>;
+    constexpr unsigned kShift = Le ? kFrom - Byte * 8 : Byte * 8 + 8 - kTo;
+    constexpr unsigned kMask = ((1u << (kTo - kFrom)) - 1) << kShift;
+    unsigned bits = static_cast<unsigned>(raw >> (Le ? kFrom - First : First + Length - kTo));
+    data[Byte] = static_cast<uint8_t>((data[Byte] & ~kMask) | ((bits << kShift) & kMask));
+}
+
+template <bool Le, unsigned First, unsigned Length, std::size_t... I>
+inline uint64_t ExtractBytes(const uint8_t* data, std::index_sequence<I...>) {
+    return (ExtractChunk<Le, First, Length, First / 8 + I>(data) | ...);
+}
+
+template <bool Le, unsigned First, unsigned Length, std::size_t... I>
+inline void InsertBytes(uint8_t* data, uint64_t raw, std::index_sequence<I...>) {
+    (InsertChunk<Le, First, Length, First / 8 + I>(data, raw), ...);
+}
+
+template <bool Le, unsigned First, unsigned Length>
+inline uint64_t Extract(const uint8_t* data) {
+    return ExtractBytes<Le, First, Length>(data, std::make_index_sequence<(First + Length - 1) / 8 - First / 8 + 1>());
+}
+
+template <bool Le, unsigned First, unsigned Length>
+inline void Insert(uint8_t* data, uint64_t raw) {
+    InsertBytes<Le, First, Length>(data, raw, std::make_index_sequence<(First + Length - 1) / 8 - First / 8 + 1>());
+}
+
+template <unsigned Length>
+inline double Signed(uint64_t raw) {
+    if constexpr (Length < 64) {
+        constexpr uint64_t kSign = uint64_t{1} << (Length - 1);
+        return static_cast<double>(static_cast<int64_t>((raw ^ kSign) - kSign));
+    } else {
+        return static_cast<double>(static_cast<int64_t>(raw));
+    }
+}
+
+inline double Float32(uint64_t raw) {
+    uint32_t bits = static_cast<uint32_t>(raw);
+    float value = 0.0f;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline double Float64(uint64_t raw) {
+    double value = 0.0;
+    std::memcpy(&value, &raw, sizeof(value));
+    return value;
+}
+
+template <unsigned Length>
+inline uint64_t ToRaw(double scaled) {
+    uint64_t raw = static_cast<uint64_t>(std::llround(scaled));
+    if constexpr (Length < 64) {
+        raw &= (uint64_t{1} << Length) - 1;
+    }
+    return raw;
+}
+
+inline uint64_t FromFloat32(double scaled) {
+    float value = static_cast<float>(scaled);
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline uint64_t FromFloat64(double scaled) {
+    uint64_t raw = 0;
+    std::memcpy(&raw, &scaled, sizeof(raw));
+    return raw;
+}
+)";
+
+std::string Literal(double value) {
+    if (std::isnan(value)) {
+        return "NAN";
+    }
+    if (std::isinf(value)) {
+        return value < 0 ? "(-HUGE_VAL)" : "HUGE_VAL";
+    }
+    char text[40];
+    std::snprintf(text, sizeof(text), "%.17g", value);
+    std::string result = text;
+    if (result.find_first_of(".eE") == std::string::npos) {
+        result += ".0";
+    }
+    return value < 0 ? "(" + result + ")" : result;
+}
+
+std::string Quoted(const std::string& text) {
+    std::string result = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += static_cast<char>(c);
+        } else if (c < 0x20 || c >= 0x7F) {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\%03o", c);
+            result += escape;
+        } else {
+            result += static_cast<char>(c);
+        }
+    }
+    return result + "\"";
+}
+
+std::string Hex(uint32_t value) {
+    char text[16];
+    std::snprintf(text, sizeof(text), "0x%Xu", value);
+    return text;
+}
+
+// Position of the signal in the generated helpers' linear numbering, and the payload bytes it needs.
+struct Placement {
+    unsigned first = 0;
+    unsigned need = 0;
+};
+
+Placement Place(const SignalDef& signal) {
+    Placement placement;
+    placement.first = signal.little_endian ? signal.start_bit : (signal.start_bit / 8) * 8 + 7 - signal.start_bit % 8;
+    placement.need = (placement.first + signal.length - 1) / 8 + 1;
+    return placement;
+}
+
+std::string ExtractCall(const SignalDef& signal, const Placement& placement) {
+    return "Extract<" + std::string(signal.little_endian ? "true" : "false") + ", " + std::to_string(placement.first) +
+           ", " + std::to_string(signal.length) + ">(data)";
+}
+
+std::string ValueExpression(const SignalDef& signal, const Placement& placement) {
+    std::string raw = ExtractCall(signal, placement);
+    std::string value;
+    if (signal.value_type == SignalDef::ValueType::Float32) {
+        value = "Float32(" + raw + ")";
+    } else if (signal.value_type == SignalDef::ValueType::Float64) {
+        value = "Float64(" + raw + ")";
+    } else if (signal.is_signed) {
+        value = "Signed<" + std::to_string(signal.length) + ">(" + raw + ")";
+    } else {
+        value = "static_cast<double>(" + raw + ")";
+    }
+    return value + " * " + Literal(signal.factor) + " + " + Literal(signal.offset);
+}
+
+std::string RawExpression(const SignalDef& signal, const std::string& value) {
+    std::string scaled = "(" + value + " - " + Literal(signal.offset) + ") / " + Literal(signal.factor);
+    if (signal.value_type == SignalDef::ValueType::Float32) {
+        return "FromFloat32(" + scaled + ")";
+    }
+    if (signal.value_type == SignalDef::ValueType::Float64) {
+        return "FromFloat64(" + scaled + ")";
+    }
+    return "ToRaw<" + std::to_string(signal.length) + ">(" + scaled + ")";
+}
+
+void EmitDecode(std::ostringstream& out, const MessageDef& message, size_t index, size_t firstSignal) {
+    out << "int32_t Decode" << index << "(const uint8_t* data, uint32_t length, ace_can_signal_sink sink, void* context) {\n";
+    out << "    int32_t count = 0;\n";
+    bool multiplexed = false;
+    for (const SignalDef& signal : message.signals) {
+        if (signal.mux != SignalDef::kMultiplexor) {
+            continue;
+        }
+        Placement placement = Place(signal);
+        out << (multiplexed ? "    else if" : "    [[maybe_unused]] int64_t mux = -1;\n    if") << " (length >= " << placement.need
+            << ") mux = static_cast<int64_t>(" << ExtractCall(signal, placement) << ");\n";
+        multiplexed = true;
+    }
+    for (size_t i = 0; i < message.signals.size(); ++i) {
+        const SignalDef& signal = message.signals[i];
+        Placement placement = Place(signal);
+        out << "    if (";
+        if (signal.mux >= 0) {
+            if (!multiplexed) {
+                continue; // no multiplexor: never selected
+            }
+            out << "mux == " << signal.mux << " && ";
+        }
+        out << "length >= " << placement.need << ") {\n";
+        out << "        sink(context, " << firstSignal + i << ", " << ValueExpression(signal, placement) << ");\n";
+        out << "        ++count;\n";
+        out << "    }\n";
+    }
+    out << "    return count;\n}\n\n";
+}
+
+void EmitEncode(std::ostringstream& out, const MessageDef& message, size_t index) {
+    out << "int32_t Encode" << index << "([[maybe_unused]] const double* values, uint8_t* data, uint32_t capacity) {\n";
+    out << "    if (capacity < " << message.length << ") return -1;\n";
+    out << "    std::memset(data, 0, " << message.length << ");\n";
+    for (size_t i = 0; i < message.signals.size(); ++i) {
+        const SignalDef& signal = message.signals[i];
+        Placement placement = Place(signal);
+        if (placement.need > message.length) {
+            continue;
+        }
+        std::string value = "values[" + std::to_string(i) + "]";
+        out << "    if (!std::isnan(" << value << ")) Insert<" << (signal.little_endian ? "true" : "false") << ", "
+            << placement.first << ", " << signal.length << ">(data, " << RawExpression(signal, value) << ");\n";
+    }
+    out << "    return " << message.length << ";\n}\n\n";
+}
+
+void EmitSwitch(std::ostringstream& out, const DecodeTables& tables, bool extended) {
+    out << "    switch (id) {\n";
+    for (size_t i = 0; i < tables.messages.size(); ++i) {
+        if (tables.messages[i].extended == extended) {
+            out << "    case " << Hex(tables.messages[i].id) << ": return Decode" << i << "(data, length, sink, context);\n";
+        }
+    }
+    out << "    default: return -1;\n    }\n";
+}
+
+} // namespace
+
+std::string GenerateDecoderSource(const DecodeTables& tables, const std::string& sourceName) {
+    std::ostringstream out;
+    out << "// Generated by ace-can SignalDatabase.generateDecoder() from " << sourceName << ". Do not edit.\n";
+    out << "// Build: c++ -O2 -std=c++17 -shared -fPIC -I <ace-can>/src -o decoder.so decoder.cpp\n\n";
+    out << "#include <cmath>\n#include <cstddef>\n#include <cstdint>\n#include <cstring>\n#include <utility>\n\n";
+    out << "#include \"ace_can_decoder.h\"\n\n";
+    out << kPrelude << "\n";
+
+    size_t signalCount = 0;
+    for (size_t i = 0; i < tables.messages.size(); ++i) {
+        const MessageDef& message = tables.messages[i];
+        out << "// " << message.name << " (" << Hex(message.id) << (message.extended ? ", extended" : "") << ")\n";
+        EmitDecode(out, message, i, signalCount);
+        EmitEncode(out, message, i);
+        signalCount += message.signals.size();
+    }
+
+    out << "int32_t Decode(uint32_t id, uint8_t extended, const uint8_t* data, uint32_t length, ace_can_signal_sink sink,\n"
+           "               void* context) {\n";
+    out << "    if (extended != 0) {\n";
+    std::ostringstream extendedSwitch;
+    EmitSwitch(extendedSwitch, tables, true);
+    std::istringstream lines(extendedSwitch.str());
+    for (std::string line; std::getline(lines, line);) {
+        out << "    " << line << "\n";
+    }
+    out << "    }\n";
+    EmitSwitch(out, tables, false);
+    out << "}\n\n";
+
+    out << "int32_t Encode(uint32_t message, const double* values, uint8_t* data, uint32_t capacity) {\n";
+    out << "    switch (message) {\n";
+    for (size_t i = 0; i < tables.messages.size(); ++i) {
+        out << "    case " << i << ": return Encode" << i << "(values, data, capacity);\n";
+    }
+    out << "    default: return -1;\n    }\n}\n\n";
+
+    if (!tables.messages.empty()) {
+        out << "const ace_can_decoder_message kMessages[] = {\n";
+        size_t first = 0;
+        for (const MessageDef& message : tables.messages) {
+            out << "    {" << Quoted(message.name) << ", " << Hex(message.id) << ", " << (message.extended ? 1 : 0) << ", "
+                << (message.fd ? 1 : 0) << ", " << message.length << ", " << first << ", " << message.signals.size()
+                << "},\n";
+            first += message.signals.size();
+        }
+        out << "};\n\n";
+    }
+    if (signalCount > 0) {
+        out << "const char* const kSignalNames[] = {\n";
+        for (const MessageDef& message : tables.messages) {
+            for (const SignalDef& signal : message.signals) {
+                out << "    " << Quoted(signal.name) << ",\n";
+            }
+        }
+        out << "};\n\n";
+    }
+    out << "const ace_can_decoder kDecoder = {ACE_CAN_DECODER_ABI_VERSION, " << tables.messages.size() << ", "
+        << (tables.messages.empty() ? "nullptr" : "kMessages") << ", " << signalCount << ", "
+        << (signalCount == 0 ? "nullptr" : "kSignalNames") << ", Decode, Encode};\n\n";
+    out << "} // namespace\n\n";
+    out << "extern \"C\" ACE_CAN_DECODER_EXPORT const ace_can_decoder* ace_can_decoder_v1(void) {\n"
+           "    return &kDecoder;\n}\n";
+    return out.str();
+}
@@ -0,0 +1,14 @@
+#ifndef ACE_CAN_DECODER_CODEGEN_H
+#define ACE_CAN_DECODER_CODEGEN_H
+
+#include <string>
+
+#include "decode_tables.h"
+
+// C++ source of a decoder plugin (ace_can_decoder.h) for `tables`: one decode and one encode
+// function per message, with every bit position, length, scale and multiplexor value baked in as
+// template arguments and literals, behind a switch on the frame ID. The result decodes exactly
+// like DecodeMessage.
+std::string GenerateDecoderSource(const DecodeTables& tables, const std::string& sourceName);
+
+#endif // ACE_CAN_DECODER_CODEGEN_H
@@ -0,0 +1,61 @@
+#include "device_watcher.h"
+
+#include <chrono>
+
+DeviceWatcher::~DeviceWatcher() {
+    Stop();
+}
+
+bool DeviceWatcher::Start(uint32_t intervalMs, bool autoReattach, bool attached) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_) {
+            return false;
+        }
+        running_ = true;
+        interval_ms_ = intervalMs;
+        auto_reattach_ = autoReattach;
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    thread_ = std::thread([this, attached]() { Loop(attached); });
+    return true;
+}
+
+void DeviceWatcher::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void DeviceWatcher::Loop(bool attached) {
+    // A watch started on a detached device counts its downtime from the start.
+    auto detachedAt = std::chrono::steady_clock::now();
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait_for(lock, std::chrono::milliseconds(interval_ms_), [this]() { return !running_; });
+            if (!running_) {
+                break;
+            }
+        }
+
+        if (attached) {
+            if (hooks_.probe()) {
+                continue;
+            }
+            attached = false;
+            detachedAt = std::chrono::steady_clock::now();
+            hooks_.detach();
+        } else if (auto_reattach_) {
+            auto down = std::chrono::steady_clock::now() - detachedAt;
+            attached = hooks_.reattach(std::chrono::duration_cast<std::chrono::milliseconds>(down).count());
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef ACE_CAN_DEVICE_WATCHER_H
+#define ACE_CAN_DEVICE_WATCHER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Hot-plug supervision of one opened channel, on a thread of its own. While the device is attached
+// it is probed once per interval; when a probe finds it gone it is detached and, with auto-reattach
+// on, an attempt to reopen it is made once per interval until one succeeds. The owner supplies the
+// device operations as hooks, which run on the watcher thread and do their own locking.
+class DeviceWatcher {
+public:
+    struct Hooks {
+        std::function<bool()> probe; // whether the attached device is still there
+        std::function<void()> detach; // releases the device that went away
+        // Tries to open the device again, `downMs` after it went away; true once it is back.
+        std::function<bool(int64_t downMs)> reattach;
+    };
+
+    explicit DeviceWatcher(Hooks hooks) : hooks_(std::move(hooks)) {}
+    ~DeviceWatcher();
+    DeviceWatcher(const DeviceWatcher&) = delete;
+    DeviceWatcher& operator=(const DeviceWatcher&) = delete;
+
+    // Starts watching a device that is currently `attached` or not. Returns false if already running.
+    bool Start(uint32_t intervalMs, bool autoReattach, bool attached);
+    // Ends the watch and waits for the thread; the next probe or reopen attempt is not awaited.
+    void Stop();
+
+private:
+    void Loop(bool attached);
+
+    Hooks hooks_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_ = false;
+    uint32_t interval_ms_ = 0;
+    bool auto_reattach_ = true;
+};
+
+#endif // ACE_CAN_DEVICE_WATCHER_H
@@ -0,0 +1,287 @@
+#include "diagnostic_runner.h"
+
+#include <algorithm>
+
+#include "ace_can.h"
+#include "napi_options.h"
+#include "timed_tx.h"
+
+namespace {
+
+// Responses are routed by CAN ID; standard and extended IDs with the same number are distinct.
+uint64_t RxKey(uint32_t rxId) {
+    return (rxId > 0x7FF ? uint64_t{1} << 32 : 0) | rxId;
+}
+
+} // namespace
+
+Napi::Object DiagnosticRunner::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "DiagnosticRunner", {
+        InstanceMethod("run", &DiagnosticRunner::Run),
+        InstanceMethod("stats", &DiagnosticRunner::Stats),
+        InstanceMethod("close", &DiagnosticRunner::Close),
+    });
+    exports.Set("DiagnosticRunner", func);
+    return exports;
+}
+
+// new DiagnosticRunner(bus, { blockSize, stMin, padding, timeoutMs, p2Ms, p2StarMs, concurrency }?)
+DiagnosticRunner::DiagnosticRunner(const Napi::CallbackInfo& info) : Napi::ObjectWrap<DiagnosticRunner>(info) {
+    Napi::Env env = info.Env();
+    bus_ = info.Length() > 0 ? CANBus::FromValue(env, info[0]) : nullptr;
+    if (bus_ == nullptr) {
+        Napi::TypeError::New(env, "bus must be a CANBus instance").ThrowAsJavaScriptException();
+        return;
+    }
+    if (info.Length() > 1 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (!ReadIsoTpOptions(env, options, config_)) {
+            return;
+        }
+        if (!ReadUdsTiming(options, timing_) || !GetOptionalUint32(options, "concurrency", concurrency_)) {
+            Napi::TypeError::New(env, "p2Ms, p2StarMs must be positive numbers, concurrency a number")
+                .ThrowAsJavaScriptException();
+            return;
+        }
+    }
+
+    bus_ref_ = Napi::Persistent(info[0].As<Napi::Object>());
+    // Only holds the event loop open while runs are pending.
+    tsfn_ = Napi::ThreadSafeFunction::New(env, Napi::Function::New(env, [](const Napi::CallbackInfo&) {}),
+                                          "DiagnosticRunner", 0, 1);
+    tsfn_.Unref(env);
+    scheduler_ = std::make_unique<SessionScheduler>(bus_);
+    scheduler_->Start();
+}
+
+DiagnosticRunner::~DiagnosticRunner() {
+    Shutdown();
+}
+
+// run(ecus, requests?, { stopOnError = true, concurrency }?) sends each ECU its requests in order
+// and resolves with one result per ECU, in the order given.
+Napi::Value DiagnosticRunner::Run(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (closed_ || !scheduler_) {
+        Napi::Error::New(env, "DiagnosticRunner closed").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected (ecus, requests?, options?)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::vector<std::vector<uint8_t>> shared;
+    if (info.Length() > 1 && !info[1].IsUndefined() && !info[1].IsNull() && !ReadUdsRequests(info[1], shared)) {
+        Napi::TypeError::New(env, "requests must be an array of 1 to 4095 byte Buffers").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto batch = std::make_shared<Batch>();
+    uint32_t concurrency = concurrency_;
+    if (info.Length() > 2 && info[2].IsObject()) {
+        Napi::Object options = info[2].As<Napi::Object>();
+        if (!GetOptionalBool(options, "stopOnError", batch->stop_on_error) ||
+            !GetOptionalUint32(options, "concurrency", concurrency)) {
+            Napi::TypeError::New(env, "Invalid run option type").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+    }
+
+    Napi::Array list = info[0].As<Napi::Array>();
+    std::unordered_set<uint64_t> rxIds;
+    for (uint32_t i = 0; i < list.Length(); ++i) {
+        Napi::Value entry = list.Get(i);
+        if (!entry.IsObject() || !entry.As<Napi::Object>().Get("txId").IsNumber() ||
+            !entry.As<Napi::Object>().Get("rxId").IsNumber()) {
+            Napi::TypeError::New(env, "Each ECU needs numeric txId and rxId").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Object options = entry.As<Napi::Object>();
+        Ecu ecu;
+        ecu.tx_id = options.Get("txId").As<Napi::Number>().Uint32Value();
+        ecu.rx_id = options.Get("rxId").As<Napi::Number>().Uint32Value();
+        ecu.timing = timing_;
+        if (!GetOptionalString(options, "name", ecu.name) || !ReadUdsTiming(options, ecu.timing)) {
+            Napi::TypeError::New(env, "Invalid ECU option type").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        if (options.Has("requests") && !options.Get("requests").IsUndefined()) {
+            if (!ReadUdsRequests(options.Get("requests"), ecu.requests)) {
+                Napi::TypeError::New(env, "requests must be an array of 1 to 4095 byte Buffers")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+        } else {
+            ecu.requests = shared;
+        }
+        // Responses are routed by CAN ID, so two ECUs answering on one ID cannot be told apart, in
+        // this run or in another one still using the scheduler.
+        if (!rxIds.insert(RxKey(ecu.rx_id)).second) {
+            Napi::RangeError::New(env, "Two ECUs share rxId " + std::to_string(ecu.rx_id)).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        if (active_rx_ids_.count(RxKey(ecu.rx_id)) != 0) {
+            Napi::RangeError::New(env, "rxId " + std::to_string(ecu.rx_id) + " is in use by another run")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        batch->ecus.push_back(std::move(ecu));
+    }
+
+    uint64_t id = next_id_++;
+    batch->id = id;
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    if (batch->ecus.empty()) {
+        deferred.Resolve(BatchToJs(env, *batch));
+        return deferred.Promise();
+    }
+    pending_.emplace(id, deferred);
+    active_rx_ids_.insert(rxIds.begin(), rxIds.end());
+    if (pending_.size() == 1) {
+        tsfn_.Ref(env);
+        Ref();
+    }
+    size_t workers = concurrency == 0 ? batch->ecus.size() : std::min<size_t>(concurrency, batch->ecus.size());
+    batch->workers = workers;
+    for (size_t i = 0; i < workers; ++i) {
+        scheduler_->Spawn([this, batch]() { return Work(batch); });
+    }
+    return deferred.Promise();
+}
+
+// One of the run's sessions: takes ECUs until none are left. The last session to finish
+// completes the run.
+SessionTask DiagnosticRunner::Work(std::shared_ptr<Batch> batch) {
+    while (batch->next < batch->ecus.size()) {
+        Ecu& ecu = batch->ecus[batch->next++];
+        ecu.ok = co_await RunEcu(ecu, batch->stop_on_error);
+    }
+    if (--batch->workers == 0) {
+        Complete(std::move(batch));
+    }
+}
+
+// True if every request got an answer, positive or negative.
+Async<bool> DiagnosticRunner::RunEcu(Ecu& ecu, bool stopOnError) {
+    int64_t startUs = HostMicros();
+    bool ok = true;
+    for (std::vector<uint8_t>& request : ecu.requests) {
+        int64_t sentUs = HostMicros();
+        Exchange exchange;
+        exchange.response = co_await UdsRequest(*scheduler_, config_, ecu.timing, ecu.tx_id, ecu.rx_id, request);
+        exchange.elapsed_us = HostMicros() - sentUs;
+        bool failed = !exchange.response.error.empty();
+        ecu.exchanges.push_back(std::move(exchange));
+        ok = ok && !failed;
+        if (failed && stopOnError) {
+            break;
+        }
+    }
+    ecu.elapsed_us = HostMicros() - startUs;
+    co_return ok;
+}
+
+// Runs on the scheduler thread. Pending runs keep this object referenced; after close() the
+// thread-safe function is aborted and drops the callback.
+void DiagnosticRunner::Complete(std::shared_ptr<Batch> batch) {
+    tsfn_.NonBlockingCall([this, batch](Napi::Env env, Napi::Function) {
+        auto it = pending_.find(batch->id);
+        if (it == pending_.end()) {
+            return;
+        }
+        Napi::Promise::Deferred deferred = it->second;
+        pending_.erase(it);
+        runs_++;
+        for (const Ecu& ecu : batch->ecus) {
+            active_rx_ids_.erase(RxKey(ecu.rx_id));
+            for (const Exchange& exchange : ecu.exchanges) {
+                requests_++;
+                negative_ += exchange.response.nrc != 0 ? 1 : 0;
+                errors_ += exchange.response.error.empty() ? 0 : 1;
+            }
+        }
+        deferred.Resolve(BatchToJs(env, *batch));
+        if (pending_.empty()) {
+            tsfn_.Unref(env);
+            Unref();
+        }
+    });
+}
+
+Napi::Value DiagnosticRunner::BatchToJs(Napi::Env env, const Batch& batch) {
+    Napi::Array results = Napi::Array::New(env, batch.ecus.size());
+    for (size_t i = 0; i < batch.ecus.size(); ++i) {
+        const Ecu& ecu = batch.ecus[i];
+        Napi::Object result = Napi::Object::New(env);
+        if (!ecu.name.empty()) {
+            result.Set("name", Napi::String::New(env, ecu.name));
+        }
+        result.Set("txId", Napi::Number::New(env, ecu.tx_id));
+        result.Set("rxId", Napi::Number::New(env, ecu.rx_id));
+        result.Set("elapsedMs", Napi::Number::New(env, static_cast<double>(ecu.elapsed_us) / 1000.0));
+        Napi::Array responses = Napi::Array::New(env, ecu.exchanges.size());
+        for (size_t j = 0; j < ecu.exchanges.size(); ++j) {
+            const UdsResponse& response = ecu.exchanges[j].response;
+            Napi::Object entry = Napi::Object::New(env);
+            if (!response.error.empty()) {
+                entry.Set("error", Napi::String::New(env, response.error));
+            } else if (!response.data.empty()) {
+                entry.Set("data", Napi::Buffer<uint8_t>::Copy(env, response.data.data(), response.data.size()));
+            }
+            if (response.nrc != 0) {
+                entry.Set("nrc", Napi::Number::New(env, response.nrc));
+            }
+            if (response.pending != 0) {
+                entry.Set("pending", Napi::Number::New(env, response.pending));
+            }
+            entry.Set("elapsedMs", Napi::Number::New(env, static_cast<double>(ecu.exchanges[j].elapsed_us) / 1000.0));
+            responses.Set(static_cast<uint32_t>(j), entry);
+        }
+        result.Set("ok", Napi::Boolean::New(env, ecu.ok));
+        result.Set("responses", responses);
+        results.Set(static_cast<uint32_t>(i), result);
+    }
+    return results;
+}
+
+Napi::Value DiagnosticRunner::Stats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object stats = Napi::Object::New(env);
+    stats.Set("active", Napi::Number::New(env, static_cast<double>(scheduler_ ? scheduler_->ActiveSessions() : 0)));
+    stats.Set("pending", Napi::Number::New(env, static_cast<double>(pending_.size())));
+    stats.Set("runs", Napi::Number::New(env, static_cast<double>(runs_)));
+    stats.Set("requests", Napi::Number::New(env, static_cast<double>(requests_)));
+    stats.Set("negative", Napi::Number::New(env, static_cast<double>(negative_)));
+    stats.Set("errors", Napi::Number::New(env, static_cast<double>(errors_)));
+    return stats;
+}
+
+Napi::Value DiagnosticRunner::Close(const Napi::CallbackInfo& info) {
+    Shutdown();
+    bus_ref_.Reset();
+    return info.Env().Undefined();
+}
+
+void DiagnosticRunner::Shutdown() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+    if (scheduler_) {
+        scheduler_->Stop();
+    }
+    if (tsfn_) {
+        tsfn_.Abort();
+        tsfn_ = nullptr;
+    }
+    if (pending_.empty()) {
+        return;
+    }
+    Napi::Env env = Env();
+    for (auto& entry : pending_) {
+        entry.second.Reject(Napi::Error::New(env, "DiagnosticRunner closed").Value());
+    }
+    pending_.clear();
+    active_rx_ids_.clear();
+    Unref();
+}
@@ -0,0 +1,84 @@
+#ifndef ACE_CAN_DIAGNOSTIC_RUNNER_H
+#define ACE_CAN_DIAGNOSTIC_RUNNER_H
+
+#include <napi.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "isotp.h"
+#include "session_scheduler.h"
+#include "uds.h"
+
+class CANBus;
+
+// Runs UDS request sequences against many ECUs on one bus at once, e.g. reading DTCs and
+// identifiers from every ECU at end of line. Each ECU is a session on a shared SessionScheduler;
+// ISO-TP flow control for all of them is multiplexed by CAN ID on the scheduler thread, and each
+// ECU keeps its own P2/P2* timing. run() resolves once with the results of every ECU.
+class DiagnosticRunner : public Napi::ObjectWrap<DiagnosticRunner> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    DiagnosticRunner(const Napi::CallbackInfo& info);
+    ~DiagnosticRunner();
+
+    Napi::Value Run(const Napi::CallbackInfo& info);
+    Napi::Value Stats(const Napi::CallbackInfo& info);
+    Napi::Value Close(const Napi::CallbackInfo& info);
+
+private:
+    struct Exchange {
+        UdsResponse response;
+        int64_t elapsed_us = 0;
+    };
+
+    struct Ecu {
+        std::string name;
+        uint32_t tx_id = 0;
+        uint32_t rx_id = 0;
+        UdsTiming timing;
+        std::vector<std::vector<uint8_t>> requests;
+        std::vector<Exchange> exchanges; // one per request actually sent
+        bool ok = false; // every request answered
+        int64_t elapsed_us = 0;
+    };
+
+    // One run() call. Touched only by the scheduler thread while sessions are active, and only by
+    // the JS thread once it completes.
+    struct Batch {
+        uint64_t id = 0;
+        std::vector<Ecu> ecus;
+        size_t next = 0; // next ECU to start
+        size_t workers = 0; // sessions still running
+        bool stop_on_error = true;
+    };
+
+    SessionTask Work(std::shared_ptr<Batch> batch);
+    Async<bool> RunEcu(Ecu& ecu, bool stopOnError);
+    void Complete(std::shared_ptr<Batch> batch);
+    static Napi::Value BatchToJs(Napi::Env env, const Batch& batch);
+    void Shutdown();
+
+    CANBus* bus_ = nullptr;
+    Napi::ObjectReference bus_ref_;
+    IsoTpConfig config_;
+    UdsTiming timing_;
+    uint32_t concurrency_ = 0; // 0 = every ECU at once
+    std::unique_ptr<SessionScheduler> scheduler_;
+    Napi::ThreadSafeFunction tsfn_;
+    bool closed_ = false;
+
+    // JS thread only.
+    uint64_t next_id_ = 1;
+    std::unordered_map<uint64_t, Napi::Promise::Deferred> pending_;
+    std::unordered_set<uint64_t> active_rx_ids_; // of pending runs, by RxKey
+    uint64_t runs_ = 0;
+    uint64_t requests_ = 0;
+    uint64_t negative_ = 0;
+    uint64_t errors_ = 0;
+};
+
+#endif // ACE_CAN_DIAGNOSTIC_RUNNER_H
@@ -0,0 +1,186 @@
+#include "diagnostic_scanner.h"
+
+#include <algorithm>
+
+#include "ace_can.h"
+#include "napi_options.h"
+#include "tx_shaper.h"
+
+Napi::Object DiagnosticScanner::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "DiagnosticScanner", {
+        InstanceMethod("scan", &DiagnosticScanner::Scan),
+        InstanceMethod("stop", &DiagnosticScanner::Stop),
+        InstanceMethod("stats", &DiagnosticScanner::Stats),
+    });
+    exports.Set("DiagnosticScanner", func);
+    return exports;
+}
+
+// new DiagnosticScanner(bus, { ranges, probe, padding, busLoad, intervalMs, responseWindowMs, listenMs }?)
+DiagnosticScanner::DiagnosticScanner(const Napi::CallbackInfo& info) : Napi::ObjectWrap<DiagnosticScanner>(info) {
+    Napi::Env env = info.Env();
+    bus_ = info.Length() > 0 ? CANBus::FromValue(env, info[0]) : nullptr;
+    if (bus_ == nullptr) {
+        Napi::TypeError::New(env, "bus must be a CANBus instance").ThrowAsJavaScriptException();
+        return;
+    }
+    IdScanner::Config config;
+    double busLoad = 0.3;
+    double intervalMs = 0;
+    uint32_t windowMs = static_cast<uint32_t>(config.window_us / 1000);
+    uint32_t listenMs = static_cast<uint32_t>(config.listen_us / 1000);
+    uint32_t padding = config.padding;
+    if (info.Length() > 1 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (!GetOptionalDouble(options, "busLoad", busLoad) || !GetOptionalDouble(options, "intervalMs", intervalMs) ||
+            !GetOptionalUint32(options, "responseWindowMs", windowMs) ||
+            !GetOptionalUint32(options, "listenMs", listenMs) || !GetOptionalUint32(options, "padding", padding) ||
+            padding > 0xFF) {
+            Napi::TypeError::New(env, "Invalid scanner option type").ThrowAsJavaScriptException();
+            return;
+        }
+        if (options.Has("probe") && !options.Get("probe").IsUndefined()) {
+            Napi::Value probe = options.Get("probe");
+            if (!probe.IsBuffer() || probe.As<Napi::Buffer<uint8_t>>().Length() == 0 ||
+                probe.As<Napi::Buffer<uint8_t>>().Length() > 7) {
+                Napi::TypeError::New(env, "probe must be a 1 to 7 byte Buffer").ThrowAsJavaScriptException();
+                return;
+            }
+            Napi::Buffer<uint8_t> buffer = probe.As<Napi::Buffer<uint8_t>>();
+            config.probe.assign(buffer.Data(), buffer.Data() + buffer.Length());
+        }
+        if (options.Has("ranges") && !options.Get("ranges").IsUndefined()) {
+            if (!options.Get("ranges").IsArray()) {
+                Napi::TypeError::New(env, "ranges must be an array").ThrowAsJavaScriptException();
+                return;
+            }
+            Napi::Array list = options.Get("ranges").As<Napi::Array>();
+            for (uint32_t i = 0; i < list.Length(); ++i) {
+                Napi::Value entry = list.Get(i);
+                IdScanner::Range range;
+                if (!entry.IsObject() || !entry.As<Napi::Object>().Get("from").IsNumber() ||
+                    !entry.As<Napi::Object>().Get("to").IsNumber()) {
+                    Napi::TypeError::New(env, "Each range needs numeric from and to").ThrowAsJavaScriptException();
+                    return;
+                }
+                Napi::Object object = entry.As<Napi::Object>();
+                range.from = object.Get("from").As<Napi::Number>().Uint32Value();
+                range.to = object.Get("to").As<Napi::Number>().Uint32Value();
+                range.extended = range.to > 0x7FF;
+                if (!GetOptionalUint32(object, "step", range.step) || !GetOptionalBool(object, "extended", range.extended)) {
+                    Napi::TypeError::New(env, "Invalid range option type").ThrowAsJavaScriptException();
+                    return;
+                }
+                if (range.from > range.to || range.step == 0 || range.to > (range.extended ? 0x1FFFFFFFu : 0x7FFu)) {
+                    Napi::RangeError::New(env, "Each range needs from <= to within the ID space and step >= 1")
+                        .ThrowAsJavaScriptException();
+                    return;
+                }
+                config.ranges.push_back(range);
+            }
+        }
+    }
+    if (config.ranges.empty()) {
+        config.ranges.push_back(IdScanner::Range());
+    }
+    if (IdScanner::ProbeCount(config.ranges) > IdScanner::kMaxProbes) {
+        Napi::RangeError::New(env, "ranges cover more than 1048576 IDs").ThrowAsJavaScriptException();
+        return;
+    }
+    if (busLoad <= 0 || busLoad > 1 || intervalMs < 0 || windowMs == 0) {
+        Napi::RangeError::New(env, "busLoad must be in (0, 1], intervalMs non-negative and responseWindowMs positive")
+            .ThrowAsJavaScriptException();
+        return;
+    }
+    // Budgeted at the worst-case frame, so extended probes and stuffing stay within busLoad too.
+    config.interval_ns = intervalMs > 0 ? std::max<int64_t>(1, static_cast<int64_t>(intervalMs * 1e6))
+                                        : FrameIntervalNs(busLoad, bus_->Bitrate());
+    if (config.interval_ns <= 0) {
+        Napi::RangeError::New(env, "intervalMs is required on a bus without a nominal bitrate")
+            .ThrowAsJavaScriptException();
+        return;
+    }
+    config.padding = static_cast<uint8_t>(padding);
+    config.window_us = static_cast<int64_t>(windowMs) * 1000;
+    config.listen_us = static_cast<int64_t>(listenMs) * 1000;
+    bus_ref_ = Napi::Persistent(info[0].As<Napi::Object>());
+    scanner_ = std::make_unique<IdScanner>(bus_, std::move(config));
+}
+
+DiagnosticScanner::~DiagnosticScanner() {
+    Shutdown();
+}
+
+// Starts a scan; the promise resolves with the confirmed pairs once every candidate has been
+// checked, or after stop() with those confirmed so far.
+Napi::Value DiagnosticScanner::Scan(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (deferred_) {
+        Napi::Error::New(env, "Scan already running").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    deferred_ = std::make_unique<Napi::Promise::Deferred>(Napi::Promise::Deferred::New(env));
+    Napi::Value promise = deferred_->Promise();
+    // Each scan owns its TSFN: Start() may still be joining the previous scan's thread, which
+    // releases its own.
+    Napi::ThreadSafeFunction tsfn = Napi::ThreadSafeFunction::New(
+        env, Napi::Function::New(env, [](const Napi::CallbackInfo&) {}), "DiagnosticScanner", 0, 1);
+    Ref();
+    scanner_->Start([this, tsfn]() mutable {
+        tsfn.NonBlockingCall([this](Napi::Env env, Napi::Function) { Finish(env); });
+        tsfn.Release();
+    });
+    return promise;
+}
+
+Napi::Value DiagnosticScanner::Stop(const Napi::CallbackInfo& info) {
+    scanner_->Stop();
+    return info.Env().Undefined();
+}
+
+Napi::Value DiagnosticScanner::Stats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    static const char* const kPhases[] = {"idle", "listen", "sweep", "verify"};
+    IdScanner::Stats counts = scanner_->GetStats();
+    Napi::Object stats = Napi::Object::New(env);
+    stats.Set("phase", Napi::String::New(env, kPhases[static_cast<int>(counts.phase)]));
+    stats.Set("probes", Napi::Number::New(env, static_cast<double>(counts.probes)));
+    stats.Set("responses", Napi::Number::New(env, static_cast<double>(counts.responses)));
+    stats.Set("candidates", Napi::Number::New(env, static_cast<double>(counts.candidates)));
+    stats.Set("found", Napi::Number::New(env, static_cast<double>(counts.found)));
+    stats.Set("unconfirmed", Napi::Number::New(env, static_cast<double>(counts.unconfirmed)));
+    stats.Set("sendErrors", Napi::Number::New(env, static_cast<double>(counts.send_errors)));
+    return stats;
+}
+
+// Resolves the scan promise on the JS thread.
+void DiagnosticScanner::Finish(Napi::Env env) {
+    IdScanner::Stats counts = scanner_->GetStats();
+    std::vector<IdScanner::Pair> pairs = scanner_->Pairs();
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("probes", Napi::Number::New(env, static_cast<double>(counts.probes)));
+    result.Set("responses", Napi::Number::New(env, static_cast<double>(counts.responses)));
+    result.Set("unconfirmed", Napi::Number::New(env, static_cast<double>(counts.unconfirmed)));
+    result.Set("sendErrors", Napi::Number::New(env, static_cast<double>(counts.send_errors)));
+    result.Set("elapsedMs", Napi::Number::New(env, static_cast<double>(counts.elapsed_us) / 1000.0));
+    Napi::Array list = Napi::Array::New(env, pairs.size());
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        Napi::Object pair = Napi::Object::New(env);
+        pair.Set("txId", Napi::Number::New(env, pairs[i].tx_id));
+        pair.Set("rxId", Napi::Number::New(env, pairs[i].rx_id));
+        pair.Set("extended", Napi::Boolean::New(env, pairs[i].extended));
+        pair.Set("rxExtended", Napi::Boolean::New(env, pairs[i].rx_extended));
+        pair.Set("response", Napi::Buffer<uint8_t>::Copy(env, pairs[i].data, pairs[i].length));
+        list.Set(static_cast<uint32_t>(i), pair);
+    }
+    result.Set("pairs", list);
+    deferred_->Resolve(result);
+    deferred_.reset();
+    Unref();
+}
+
+void DiagnosticScanner::Shutdown() {
+    if (scanner_) {
+        scanner_->Shutdown();
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef ACE_CAN_DIAGNOSTIC_SCANNER_H
+#define ACE_CAN_DIAGNOSTIC_SCANNER_H
+
+#include <napi.h>
+#include <memory>
+
+#include "id_scanner.h"
+
+class CANBus;
+
+// JS surface of an IdScanner on one CANBus: validates the options, turns busLoad into a probe
+// interval from the bus bitrate and resolves scan() with the confirmed pairs.
+class DiagnosticScanner : public Napi::ObjectWrap<DiagnosticScanner> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    DiagnosticScanner(const Napi::CallbackInfo& info);
+    ~DiagnosticScanner();
+
+    Napi::Value Scan(const Napi::CallbackInfo& info);
+    Napi::Value Stop(const Napi::CallbackInfo& info);
+    Napi::Value Stats(const Napi::CallbackInfo& info);
+
+private:
+    void Finish(Napi::Env env);
+    void Shutdown();
+
+    CANBus* bus_ = nullptr;
+    Napi::ObjectReference bus_ref_;
+    std::unique_ptr<IdScanner> scanner_;
+
+    std::unique_ptr<Napi::Promise::Deferred> deferred_;
+};
+
+#endif // ACE_CAN_DIAGNOSTIC_SCANNER_H
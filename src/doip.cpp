@@ -0,0 +1,50 @@
+#include "doip.h"
+
+namespace {
+
+// ISO 13400-2:2010, 2012 and 2019; 0xFF is only valid for vehicle identification over UDP.
+bool SupportedVersion(uint8_t version) {
+    return version >= 0x01 && version <= 0x03;
+}
+
+} // namespace
+
+std::vector<uint8_t> MakeDoipMessage(uint8_t version, uint16_t type, size_t payloadSize) {
+    std::vector<uint8_t> message(kDoipHeaderSize + payloadSize);
+    message[0] = version;
+    message[1] = static_cast<uint8_t>(~version);
+    WriteDoipU16(&message[2], type);
+    for (int i = 0; i < 4; ++i) {
+        message[4 + i] = static_cast<uint8_t>(payloadSize >> (24 - 8 * i));
+    }
+    return message;
+}
+
+int DoipReader::Next(DoipMessage& message, uint8_t& nackCode) {
+    size_t available = buffer_.size() - offset_;
+    if (available >= kDoipHeaderSize) {
+        const uint8_t* header = buffer_.data() + offset_;
+        if (header[1] != static_cast<uint8_t>(~header[0]) || !SupportedVersion(header[0])) {
+            nackCode = kDoipIncorrectPattern;
+            return -1;
+        }
+        uint32_t size = (static_cast<uint32_t>(header[4]) << 24) | (static_cast<uint32_t>(header[5]) << 16) |
+                        (static_cast<uint32_t>(header[6]) << 8) | header[7];
+        if (size > max_payload_) {
+            nackCode = kDoipMessageTooLarge;
+            return -1;
+        }
+        if (available >= kDoipHeaderSize + size) {
+            message.version = header[0];
+            message.type = ReadDoipU16(header + 2);
+            message.payload.assign(header + kDoipHeaderSize, header + kDoipHeaderSize + size);
+            offset_ += kDoipHeaderSize + size;
+            return 1;
+        }
+    }
+    if (offset_ > 0 && offset_ * 2 >= buffer_.size()) {
+        buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(offset_));
+        offset_ = 0;
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+#ifndef ACE_CAN_DOIP_H
+#define ACE_CAN_DOIP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ISO 13400-2 (DoIP) framing. Every message starts with the generic header, big-endian:
+//   0 u8 protocol version   1 u8 inverse version   2 u16 payload type   4 u32 payload length
+constexpr size_t kDoipHeaderSize = 8;
+
+constexpr uint16_t kDoipGenericNack = 0x0000;
+constexpr uint16_t kDoipRoutingActivationRequest = 0x0005;
+constexpr uint16_t kDoipRoutingActivationResponse = 0x0006;
+constexpr uint16_t kDoipAliveCheckRequest = 0x0007;
+constexpr uint16_t kDoipAliveCheckResponse = 0x0008;
+constexpr uint16_t kDoipEntityStatusRequest = 0x4001;
+constexpr uint16_t kDoipEntityStatusResponse = 0x4002;
+constexpr uint16_t kDoipPowerModeRequest = 0x4003;
+constexpr uint16_t kDoipPowerModeResponse = 0x4004;
+constexpr uint16_t kDoipDiagnosticMessage = 0x8001;
+constexpr uint16_t kDoipDiagnosticAck = 0x8002;
+constexpr uint16_t kDoipDiagnosticNack = 0x8003;
+
+// Generic header negative acknowledge codes.
+constexpr uint8_t kDoipIncorrectPattern = 0x00;
+constexpr uint8_t kDoipUnknownPayloadType = 0x01;
+constexpr uint8_t kDoipMessageTooLarge = 0x02;
+constexpr uint8_t kDoipInvalidPayloadLength = 0x04;
+
+struct DoipMessage {
+    uint8_t version = 0;
+    uint16_t type = 0;
+    std::vector<uint8_t> payload;
+};
+
+// One message with room for `payloadSize` bytes after the header, which is filled in.
+std::vector<uint8_t> MakeDoipMessage(uint8_t version, uint16_t type, size_t payloadSize);
+
+inline uint16_t ReadDoipU16(const uint8_t* data) {
+    return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+inline void WriteDoipU16(uint8_t* out, uint16_t value) {
+    out[0] = static_cast<uint8_t>(value >> 8);
+    out[1] = static_cast<uint8_t>(value);
+}
+
+// Splits a tester's TCP byte stream into messages.
+class DoipReader {
+public:
+    explicit DoipReader(size_t maxPayload) : max_payload_(maxPayload) {}
+
+    void Append(const uint8_t* data, size_t size) { buffer_.insert(buffer_.end(), data, data + size); }
+    // 1 with a message, 0 when more bytes are needed, -1 on a header error; `nackCode` then holds the
+    // generic negative acknowledge to send before closing the connection.
+    int Next(DoipMessage& message, uint8_t& nackCode);
+
+private:
+    size_t max_payload_;
+    std::vector<uint8_t> buffer_;
+    size_t offset_ = 0;
+};
+
+#endif // ACE_CAN_DOIP_H
@@ -0,0 +1,604 @@
+#include "doip_gateway.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "ace_can.h"
+#include "napi_options.h"
+#include "timed_tx.h"
+
+namespace {
+
+// Routing activation response codes.
+constexpr uint8_t kActivationUnknownSource = 0x00;
+constexpr uint8_t kActivationSourceMismatch = 0x02; // the socket is registered to another address
+constexpr uint8_t kActivationSourceInUse = 0x03; // the address is active on another socket
+constexpr uint8_t kActivationUnsupportedType = 0x06;
+constexpr uint8_t kActivationSuccess = 0x10;
+
+// Diagnostic message negative acknowledge codes.
+constexpr uint8_t kDiagnosticInvalidSource = 0x02;
+constexpr uint8_t kDiagnosticUnknownTarget = 0x03;
+constexpr uint8_t kDiagnosticTooLarge = 0x04;
+constexpr uint8_t kDiagnosticOutOfMemory = 0x05;
+constexpr uint8_t kDiagnosticTransportError = 0x08;
+
+constexpr uint8_t kNegativeResponse = 0x7F;
+constexpr uint8_t kResponsePending = 0x78;
+constexpr uint8_t kPositiveOffset = 0x40;
+
+// Diagnostic message, acknowledge or negative acknowledge: source and target address, then data.
+std::vector<uint8_t> DiagnosticMessage(uint8_t version, uint16_t type, uint16_t source, uint16_t target,
+                                       const uint8_t* data, size_t size) {
+    std::vector<uint8_t> message = MakeDoipMessage(version, type, 4 + size);
+    WriteDoipU16(&message[kDoipHeaderSize], source);
+    WriteDoipU16(&message[kDoipHeaderSize + 2], target);
+    if (size > 0) {
+        std::memcpy(&message[kDoipHeaderSize + 4], data, size);
+    }
+    return message;
+}
+
+std::vector<uint8_t> GenericNack(uint8_t version, uint8_t code) {
+    std::vector<uint8_t> message = MakeDoipMessage(version, kDoipGenericNack, 1);
+    message[kDoipHeaderSize] = code;
+    return message;
+}
+
+} // namespace
+
+Napi::Object DoipGateway::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "DoipGateway", {
+        InstanceMethod("port", &DoipGateway::Port),
+        InstanceMethod("stats", &DoipGateway::Stats),
+        InstanceMethod("close", &DoipGateway::Close),
+    });
+    exports.Set("DoipGateway", func);
+    return exports;
+}
+
+// new DoipGateway(routes, { port = 13400, host = '0.0.0.0', logicalAddress = 0x1000, maxTesters = 8, testers,
+//                          blockSize, stMin, padding, timeoutMs, p2Ms, p2StarMs }?)
+// Each route is { address, bus, txId, rxId } plus optional ISO-TP and UDS timing overrides.
+DoipGateway::DoipGateway(const Napi::CallbackInfo& info) : Napi::ObjectWrap<DoipGateway>(info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected (routes, options?)").ThrowAsJavaScriptException();
+        return;
+    }
+    std::string host = "0.0.0.0";
+    uint32_t port = 13400;
+    uint32_t logicalAddress = logical_address_;
+    IsoTpConfig config;
+    UdsTiming timing;
+    if (info.Length() > 1 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (!ReadIsoTpOptions(env, options, config)) {
+            return;
+        }
+        if (!GetOptionalString(options, "host", host) || !GetOptionalUint32(options, "port", port) ||
+            !GetOptionalUint32(options, "logicalAddress", logicalAddress) ||
+            !GetOptionalUint32(options, "maxTesters", max_testers_) || !ReadUdsTiming(options, timing)) {
+            Napi::TypeError::New(env, "Invalid DoIP gateway option type").ThrowAsJavaScriptException();
+            return;
+        }
+        if (options.Has("testers") && !options.Get("testers").IsUndefined()) {
+            Napi::Value testers = options.Get("testers");
+            if (!testers.IsArray()) {
+                Napi::TypeError::New(env, "testers must be an array of logical addresses").ThrowAsJavaScriptException();
+                return;
+            }
+            Napi::Array list = testers.As<Napi::Array>();
+            for (uint32_t i = 0; i < list.Length(); ++i) {
+                Napi::Value entry = list.Get(i);
+                if (!entry.IsNumber() || entry.As<Napi::Number>().Uint32Value() > 0xFFFF) {
+                    Napi::TypeError::New(env, "testers must be an array of logical addresses").ThrowAsJavaScriptException();
+                    return;
+                }
+                allowed_testers_.insert(static_cast<uint16_t>(entry.As<Napi::Number>().Uint32Value()));
+            }
+        }
+    }
+    if (port > 65535 || logicalAddress > 0xFFFF || max_testers_ == 0) {
+        Napi::RangeError::New(env, "port must be 0-65535, logicalAddress 16-bit and maxTesters positive")
+            .ThrowAsJavaScriptException();
+        return;
+    }
+    logical_address_ = static_cast<uint16_t>(logicalAddress);
+
+    std::unordered_map<CANBus*, SessionScheduler*> schedulers;
+    std::unordered_set<std::string> endpoints;
+    Napi::Array list = info[0].As<Napi::Array>();
+    routes_.resize(list.Length());
+    for (uint32_t i = 0; i < list.Length(); ++i) {
+        Napi::Value entry = list.Get(i);
+        if (!entry.IsObject()) {
+            Napi::TypeError::New(env, "Each route must be an object").ThrowAsJavaScriptException();
+            return;
+        }
+        Napi::Object options = entry.As<Napi::Object>();
+        CANBus* bus = CANBus::FromValue(env, options.Get("bus"));
+        if (bus == nullptr || !options.Get("address").IsNumber() || !options.Get("txId").IsNumber() ||
+            !options.Get("rxId").IsNumber()) {
+            Napi::TypeError::New(env, "Each route needs a numeric address, a CANBus bus and numeric txId and rxId")
+                .ThrowAsJavaScriptException();
+            return;
+        }
+        Route& route = routes_[i];
+        uint32_t address = options.Get("address").As<Napi::Number>().Uint32Value();
+        route.tx_id = options.Get("txId").As<Napi::Number>().Uint32Value();
+        route.rx_id = options.Get("rxId").As<Napi::Number>().Uint32Value();
+        route.config = config;
+        route.timing = timing;
+        if (!ReadIsoTpOptions(env, options, route.config)) {
+            return;
+        }
+        if (!ReadUdsTiming(options, route.timing)) {
+            Napi::TypeError::New(env, "p2Ms, p2StarMs must be positive numbers").ThrowAsJavaScriptException();
+            return;
+        }
+        if (address > 0xFFFF) {
+            Napi::RangeError::New(env, "Route address must be 16-bit").ThrowAsJavaScriptException();
+            return;
+        }
+        route.address = static_cast<uint16_t>(address);
+        if (!by_address_.emplace(route.address, &route).second) {
+            Napi::RangeError::New(env, "Two routes share address " + std::to_string(address)).ThrowAsJavaScriptException();
+            return;
+        }
+        // Responses are routed by CAN ID per bus, so two ECUs answering on one ID would mix.
+        if (!endpoints.insert(std::to_string(reinterpret_cast<uintptr_t>(bus)) + ":" + std::to_string(route.rx_id))
+                 .second) {
+            Napi::RangeError::New(env, "Two routes on one bus share rxId " + std::to_string(route.rx_id))
+                .ThrowAsJavaScriptException();
+            return;
+        }
+        SessionScheduler*& scheduler = schedulers[bus];
+        if (scheduler == nullptr) {
+            schedulers_.push_back(std::make_unique<SessionScheduler>(bus));
+            bus_refs_.push_back(Napi::Persistent(options.Get("bus").As<Napi::Object>()));
+            scheduler = schedulers_.back().get();
+        }
+        route.scheduler = scheduler;
+    }
+
+    TunnelAddress bind;
+    std::string error = TunnelSocket::Resolve(host, static_cast<uint16_t>(port), bind);
+    if (error.empty()) {
+        error = listener_.Listen(bind);
+    }
+    if (error.empty()) {
+        error = TunnelSocket::Resolve("127.0.0.1", 0, waker_address_);
+    }
+    if (error.empty()) {
+        error = waker_.OpenUdp(waker_address_);
+    }
+    if (error.empty()) {
+        error = TunnelSocket::Resolve("127.0.0.1", waker_.LocalPort(), waker_address_);
+    }
+    if (!error.empty()) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return;
+    }
+
+    for (std::unique_ptr<SessionScheduler>& scheduler : schedulers_) {
+        scheduler->Start();
+    }
+    running_ = true;
+    thread_ = std::thread([this]() { Loop(); });
+}
+
+DoipGateway::~DoipGateway() {
+    Shutdown();
+}
+
+void DoipGateway::Shutdown() {
+    if (!running_) {
+        return;
+    }
+    running_ = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Wake();
+    }
+    thread_.join();
+    // Nothing spawns sessions any more; stopping the schedulers ends the ones in flight.
+    for (std::unique_ptr<SessionScheduler>& scheduler : schedulers_) {
+        scheduler->Stop();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    testers_.clear();
+    listener_.Close();
+    waker_.Close();
+}
+
+Napi::Value DoipGateway::Port(const Napi::CallbackInfo& info) {
+    return Napi::Number::New(info.Env(), listener_.Valid() ? listener_.LocalPort() : 0);
+}
+
+Napi::Value DoipGateway::Stats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object result = Napi::Object::New(env);
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t testers = 0;
+    size_t active = 0;
+    for (const std::unique_ptr<Tester>& tester : testers_) {
+        if (!tester->drop) {
+            testers++;
+            active += tester->active ? 1 : 0;
+        }
+    }
+    size_t queued = 0;
+    for (const Route& route : routes_) {
+        queued += route.queue.size();
+    }
+    result.Set("testers", Napi::Number::New(env, static_cast<double>(testers)));
+    result.Set("activeTesters", Napi::Number::New(env, static_cast<double>(active)));
+    result.Set("activations", Napi::Number::New(env, static_cast<double>(activations_)));
+    result.Set("requests", Napi::Number::New(env, static_cast<double>(requests_)));
+    result.Set("queued", Napi::Number::New(env, static_cast<double>(queued)));
+    result.Set("responses", Napi::Number::New(env, static_cast<double>(responses_)));
+    result.Set("unanswered", Napi::Number::New(env, static_cast<double>(unanswered_)));
+    result.Set("nacks", Napi::Number::New(env, static_cast<double>(nacks_)));
+    result.Set("transportErrors", Napi::Number::New(env, static_cast<double>(transport_errors_)));
+    result.Set("rejected", Napi::Number::New(env, static_cast<double>(rejected_)));
+    return result;
+}
+
+// Disconnects every tester and stops listening; the buses stay open.
+Napi::Value DoipGateway::Close(const Napi::CallbackInfo& info) {
+    Shutdown();
+    for (Napi::ObjectReference& ref : bus_refs_) {
+        ref.Reset();
+    }
+    return info.Env().Undefined();
+}
+
+// One session per busy route, on its bus's scheduler: forwards queued requests until none are left.
+SessionTask DoipGateway::Serve(Route* route) {
+    while (true) {
+        Request request;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (route->queue.empty()) {
+                route->busy = false;
+                break;
+            }
+            request = std::move(route->queue.front());
+            route->queue.pop_front();
+        }
+        bool answered = co_await Forward(*route, std::move(request));
+        if (!answered) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            unanswered_++;
+        }
+    }
+}
+
+// Sends one request to the ECU, acknowledges it to the tester once it is on the bus and relays
+// every response until the final one. Waits P2 for a response and P2* after each response-pending
+// answer. False if no final response arrived.
+Async<bool> DoipGateway::Forward(Route& route, Request request) {
+    SessionScheduler& scheduler = *route.scheduler;
+    uint8_t service = request.data[0];
+    bool suppressed = UdsSuppressesPositiveResponse(request.data);
+    std::string error = co_await IsoTpSend(scheduler, route.config, route.tx_id, route.rx_id, std::move(request.data));
+    uint8_t code = error.empty() ? 0 : kDiagnosticTransportError;
+    Reply(request.tester, DiagnosticMessage(request.version, error.empty() ? kDoipDiagnosticAck : kDoipDiagnosticNack,
+                                            route.address, request.source, &code, 1));
+    if (!error.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        transport_errors_++;
+        nacks_++;
+        co_return false;
+    }
+    if (suppressed) {
+        co_return true;
+    }
+
+    int64_t deadlineUs = HostMicros() + route.timing.p2_us;
+    while (true) {
+        int64_t remainingUs = deadlineUs - HostMicros();
+        if (remainingUs <= 0) {
+            co_return false;
+        }
+        IsoTpResult received = co_await IsoTpReceive(scheduler, route.config, route.rx_id, route.tx_id, remainingUs);
+        if (!received.error.empty()) {
+            co_return false;
+        }
+        const std::vector<uint8_t>& data = received.data;
+        Reply(request.tester, DiagnosticMessage(request.version, kDoipDiagnosticMessage, route.address, request.source,
+                                                data.data(), data.size()));
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            responses_++;
+        }
+        bool negative = data.size() >= 3 && data[0] == kNegativeResponse && data[1] == service;
+        if (negative && data[2] == kResponsePending) {
+            deadlineUs = HostMicros() + route.timing.p2_star_us;
+            continue;
+        }
+        if (negative || data[0] == static_cast<uint8_t>(service + kPositiveOffset)) {
+            co_return true;
+        }
+        // Something else from the ECU (e.g. a late answer to an earlier request); relayed, keep waiting.
+    }
+}
+
+// Called from scheduler threads. Messages for a tester that has disconnected since are dropped.
+void DoipGateway::Reply(uint64_t testerId, std::vector<uint8_t> message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(testers_.begin(), testers_.end(),
+                           [testerId](const std::unique_ptr<Tester>& tester) { return tester->id == testerId; });
+    if (it == testers_.end() || (*it)->drop) {
+        return;
+    }
+    if (Queue(**it, std::move(message))) {
+        Wake();
+    }
+}
+
+// Queues a message and, if the tester was idle, writes what the socket takes right away. Returns
+// whether the server thread needs to look at the tester. mutex_ held.
+bool DoipGateway::Queue(Tester& tester, std::vector<uint8_t> message) {
+    bool idle = tester.out.empty();
+    tester.queued_bytes += message.size();
+    tester.out.push_back(std::move(message));
+    if (idle && !Flush(tester)) {
+        tester.drop = true;
+        return true;
+    }
+    if (tester.queued_bytes > kMaxQueuedBytes) {
+        tester.drop = true;
+        return true;
+    }
+    return idle && !tester.out.empty();
+}
+
+// Writes queued messages until the socket is full; false on a socket error. mutex_ held.
+bool DoipGateway::Flush(Tester& tester) {
+    while (!tester.out.empty()) {
+        std::vector<uint8_t>& front = tester.out.front();
+        int sent = tester.socket->Send(front.data() + tester.out_offset, front.size() - tester.out_offset);
+        if (sent < 0) {
+            return false;
+        }
+        if (sent == 0) {
+            break;
+        }
+        tester.out_offset += static_cast<size_t>(sent);
+        tester.queued_bytes -= static_cast<size_t>(sent);
+        if (tester.out_offset == front.size()) {
+            tester.out.pop_front();
+            tester.out_offset = 0;
+        }
+    }
+    return true;
+}
+
+void DoipGateway::Wake() {
+    if (!wake_pending_) {
+        wake_pending_ = true;
+        uint8_t byte = 0;
+        waker_.SendTo(&byte, 1, waker_address_);
+    }
+}
+
+void DoipGateway::Loop() {
+    std::vector<Tester*> polled;
+    std::vector<TunnelSocket::PollItem> items;
+    uint8_t scratch[16];
+    while (running_) {
+        items.assign(2, TunnelSocket::PollItem());
+        items[0].socket = &waker_;
+        items[1].socket = &listener_;
+        polled.clear();
+        {
+            // Only this thread adds or removes testers, so the pointers stay valid through the poll.
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const std::unique_ptr<Tester>& tester : testers_) {
+                polled.push_back(tester.get());
+                TunnelSocket::PollItem item;
+                item.socket = tester->socket.get();
+                item.want_write = !tester->out.empty();
+                items.push_back(item);
+            }
+        }
+        bool ready = TunnelSocket::Poll(items, 200);
+        int64_t nowUs = HostMicros();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (ready && items[0].readable) {
+            TunnelAddress from;
+            while (waker_.ReceiveFrom(scratch, sizeof(scratch), from, 0) > 0) {
+            }
+            wake_pending_ = false;
+        }
+        if (ready && items[1].readable) {
+            auto tester = std::make_unique<Tester>();
+            tester->socket = std::make_unique<TunnelSocket>();
+            if (listener_.Accept(*tester->socket)) {
+                if (testers_.size() >= max_testers_) {
+                    rejected_++;
+                } else {
+                    tester->socket->SetNonBlocking();
+                    tester->id = next_tester_++;
+                    tester->connected_us = nowUs;
+                    tester->last_us = nowUs;
+                    testers_.push_back(std::move(tester));
+                }
+            }
+        }
+        for (size_t i = 0; i < polled.size(); ++i) {
+            Tester& tester = *polled[i];
+            if (ready && !tester.drop && items[i + 2].readable) {
+                Read(tester, nowUs);
+            }
+            if (ready && !tester.drop && items[i + 2].writable && !Flush(tester)) {
+                tester.drop = true;
+            }
+            // A socket must activate routing soon after connecting, and an active one is closed
+            // after a long silence.
+            if (tester.active ? nowUs - tester.last_us > kGeneralInactivityUs
+                              : nowUs - tester.connected_us > kInitialInactivityUs) {
+                tester.drop = true;
+            }
+        }
+        testers_.erase(std::remove_if(testers_.begin(), testers_.end(),
+                                      [](const std::unique_ptr<Tester>& tester) { return tester->drop; }),
+                       testers_.end());
+    }
+}
+
+// Reads and handles whatever the tester sent. mutex_ held; the socket is non-blocking.
+void DoipGateway::Read(Tester& tester, int64_t nowUs) {
+    uint8_t buffer[4096];
+    int received = tester.socket->Receive(buffer, sizeof(buffer), -1);
+    if (received < 0) {
+        tester.drop = true;
+        return;
+    }
+    tester.reader.Append(buffer, static_cast<size_t>(received));
+    DoipMessage message;
+    uint8_t nackCode = 0;
+    int status = 0;
+    while (!tester.drop && (status = tester.reader.Next(message, nackCode)) == 1) {
+        tester.version = message.version;
+        tester.last_us = nowUs;
+        HandleMessage(tester, message);
+    }
+    if (status < 0) {
+        // The stream cannot be resynchronized after a bad header.
+        Queue(tester, GenericNack(tester.version, nackCode));
+        tester.drop = true;
+    }
+}
+
+void DoipGateway::HandleMessage(Tester& tester, DoipMessage& message) {
+    switch (message.type) {
+        case kDoipRoutingActivationRequest:
+            ActivateRouting(tester, message);
+            return;
+        case kDoipDiagnosticMessage:
+            HandleDiagnostic(tester, message);
+            return;
+        case kDoipAliveCheckRequest: {
+            std::vector<uint8_t> reply = MakeDoipMessage(tester.version, kDoipAliveCheckResponse, 2);
+            WriteDoipU16(&reply[kDoipHeaderSize], logical_address_);
+            Queue(tester, std::move(reply));
+            return;
+        }
+        case kDoipAliveCheckResponse:
+            return; // receiving it already counts as activity
+        case kDoipEntityStatusRequest: {
+            // Node type gateway, socket limit, open sockets, largest request accepted.
+            std::vector<uint8_t> reply = MakeDoipMessage(tester.version, kDoipEntityStatusResponse, 7);
+            reply[kDoipHeaderSize] = 0x00;
+            reply[kDoipHeaderSize + 1] = static_cast<uint8_t>(std::min<uint32_t>(max_testers_, 0xFF));
+            reply[kDoipHeaderSize + 2] = static_cast<uint8_t>(std::min<size_t>(testers_.size(), 0xFF));
+            uint32_t maxData = static_cast<uint32_t>(kDoipHeaderSize + 4 + kMaxDiagnostic);
+            for (int i = 0; i < 4; ++i) {
+                reply[kDoipHeaderSize + 3 + i] = static_cast<uint8_t>(maxData >> (24 - 8 * i));
+            }
+            Queue(tester, std::move(reply));
+            return;
+        }
+        case kDoipPowerModeRequest: {
+            std::vector<uint8_t> reply = MakeDoipMessage(tester.version, kDoipPowerModeResponse, 1);
+            reply[kDoipHeaderSize] = 0x01; // ready
+            Queue(tester, std::move(reply));
+            return;
+        }
+        default:
+            Queue(tester, GenericNack(tester.version, kDoipUnknownPayloadType));
+            return;
+    }
+}
+
+// Registers the tester's logical address on its socket. Any refusal closes the socket.
+void DoipGateway::ActivateRouting(Tester& tester, const DoipMessage& message) {
+    if (message.payload.size() != 7 && message.payload.size() != 11) {
+        Queue(tester, GenericNack(tester.version, kDoipInvalidPayloadLength));
+        tester.drop = true;
+        return;
+    }
+    uint16_t source = ReadDoipU16(message.payload.data());
+    uint8_t type = message.payload[2];
+    bool allowed = allowed_testers_.empty() ? source >= 0x0E00 && source <= 0x0FFF : allowed_testers_.count(source) != 0;
+    uint8_t code = kActivationSuccess;
+    if (!allowed) {
+        code = kActivationUnknownSource;
+    } else if (type != 0x00 && type != 0x01) {
+        code = kActivationUnsupportedType; // default and WWH-OBD only; no central security
+    } else if (tester.active && tester.source != source) {
+        code = kActivationSourceMismatch;
+    } else {
+        for (const std::unique_ptr<Tester>& other : testers_) {
+            if (other.get() != &tester && other->active && !other->drop && other->source == source) {
+                // Probe the holder; if its connection is dead the send fails and frees the
+                // address for the tester's next attempt.
+                code = kActivationSourceInUse;
+                Queue(*other, MakeDoipMessage(other->version, kDoipAliveCheckRequest, 0));
+                break;
+            }
+        }
+    }
+
+    std::vector<uint8_t> reply = MakeDoipMessage(tester.version, kDoipRoutingActivationResponse, 9);
+    WriteDoipU16(&reply[kDoipHeaderSize], source);
+    WriteDoipU16(&reply[kDoipHeaderSize + 2], logical_address_);
+    reply[kDoipHeaderSize + 4] = code;
+    Queue(tester, std::move(reply));
+    if (code != kActivationSuccess) {
+        tester.drop = true;
+        return;
+    }
+    if (!tester.active) {
+        activations_++;
+    }
+    tester.active = true;
+    tester.source = source;
+}
+
+// Validates a diagnostic message and queues it on its route; problems are answered with a
+// negative acknowledge right away.
+void DoipGateway::HandleDiagnostic(Tester& tester, DoipMessage& message) {
+    if (message.payload.size() < 5) {
+        Queue(tester, GenericNack(tester.version, kDoipInvalidPayloadLength));
+        tester.drop = true;
+        return;
+    }
+    uint16_t source = ReadDoipU16(message.payload.data());
+    uint16_t target = ReadDoipU16(message.payload.data() + 2);
+    uint8_t code = 0;
+    auto route = by_address_.find(target);
+    if (!tester.active || source != tester.source) {
+        code = kDiagnosticInvalidSource;
+    } else if (route == by_address_.end()) {
+        code = kDiagnosticUnknownTarget;
+    } else if (message.payload.size() - 4 > kMaxDiagnostic) {
+        code = kDiagnosticTooLarge;
+    } else if (route->second->queue.size() >= kMaxQueuedRequests) {
+        code = kDiagnosticOutOfMemory;
+    }
+    if (code != 0) {
+        nacks_++;
+        Queue(tester, DiagnosticMessage(tester.version, kDoipDiagnosticNack, target, source, &code, 1));
+        tester.drop = tester.drop || code == kDiagnosticInvalidSource;
+        return;
+    }
+
+    Route& destination = *route->second;
+    Request request;
+    request.tester = tester.id;
+    request.source = source;
+    request.version = tester.version;
+    request.data.assign(message.payload.begin() + 4, message.payload.end());
+    destination.queue.push_back(std::move(request));
+    requests_++;
+    if (!destination.busy) {
+        destination.busy = true;
+        Route* slot = &destination;
+        destination.scheduler->Spawn([this, slot]() { return Serve(slot); });
+    }
+}
@@ -0,0 +1,120 @@
+#ifndef ACE_CAN_DOIP_GATEWAY_H
+#define ACE_CAN_DOIP_GATEWAY_H
+
+#include <napi.h>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "doip.h"
+#include "isotp.h"
+#include "session_scheduler.h"
+#include "tunnel.h"
+#include "uds.h"
+
+class CANBus;
+
+// DoIP (ISO 13400-2) gateway in front of CAN ECUs. Testers connect over TCP, activate routing
+// with their logical address and send diagnostic messages to an ECU's logical address; each route
+// maps one address to an ISO-TP request/response ID pair on a CANBus. A server thread parses the
+// DoIP stream and queues requests per route; a SessionScheduler per bus sends them over ISO-TP and
+// forwards every response (response-pending ones included) to the tester that asked. Requests to
+// one ECU are handled one at a time; ECUs and buses proceed in parallel.
+class DoipGateway : public Napi::ObjectWrap<DoipGateway> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    DoipGateway(const Napi::CallbackInfo& info);
+    ~DoipGateway();
+
+    Napi::Value Port(const Napi::CallbackInfo& info);
+    Napi::Value Stats(const Napi::CallbackInfo& info);
+    Napi::Value Close(const Napi::CallbackInfo& info);
+
+private:
+    struct Request {
+        uint64_t tester = 0; // Tester::id
+        uint16_t source = 0; // tester's logical address
+        uint8_t version = 0;
+        std::vector<uint8_t> data;
+    };
+
+    struct Route {
+        uint16_t address = 0;
+        SessionScheduler* scheduler = nullptr;
+        uint32_t tx_id = 0;
+        uint32_t rx_id = 0;
+        IsoTpConfig config;
+        UdsTiming timing;
+        std::deque<Request> queue; // guarded by mutex_
+        bool busy = false; // a session is draining the queue; guarded by mutex_
+    };
+
+    struct Tester {
+        uint64_t id = 0;
+        std::unique_ptr<TunnelSocket> socket;
+        DoipReader reader{kMaxPayload};
+        uint16_t source = 0;
+        bool active = false; // routing activated
+        bool drop = false; // closed by the server thread on its next pass
+        uint8_t version = 2; // of the last message received, used for replies
+        int64_t connected_us = 0;
+        int64_t last_us = 0; // last message received
+        std::deque<std::vector<uint8_t>> out;
+        size_t out_offset = 0; // into out.front()
+        size_t queued_bytes = 0;
+    };
+
+    static constexpr size_t kMaxDiagnostic = 4095; // largest ISO-TP message
+    static constexpr size_t kMaxPayload = 0xFFFF; // larger diagnostic messages are refused with a NACK
+    static constexpr size_t kMaxQueuedRequests = 32; // per route
+    static constexpr size_t kMaxQueuedBytes = 1 << 20; // per tester
+    static constexpr int64_t kInitialInactivityUs = 2000000; // T_TCP_Initial_Inactivity
+    static constexpr int64_t kGeneralInactivityUs = 300000000; // T_TCP_General_Inactivity
+
+    SessionTask Serve(Route* route);
+    Async<bool> Forward(Route& route, Request request);
+    void Reply(uint64_t testerId, std::vector<uint8_t> message);
+    void Loop();
+    void Read(Tester& tester, int64_t nowUs);
+    void HandleMessage(Tester& tester, DoipMessage& message);
+    void ActivateRouting(Tester& tester, const DoipMessage& message);
+    void HandleDiagnostic(Tester& tester, DoipMessage& message);
+    bool Queue(Tester& tester, std::vector<uint8_t> message);
+    bool Flush(Tester& tester);
+    void Wake();
+    void Shutdown();
+
+    uint16_t logical_address_ = 0x1000;
+    uint32_t max_testers_ = 8;
+    std::unordered_set<uint16_t> allowed_testers_; // empty = any address in 0x0E00-0x0FFF
+    std::vector<Route> routes_; // fixed after construction
+    std::unordered_map<uint16_t, Route*> by_address_;
+    std::vector<std::unique_ptr<SessionScheduler>> schedulers_; // one per bus
+    std::vector<Napi::ObjectReference> bus_refs_;
+
+    TunnelSocket listener_;
+    TunnelSocket waker_; // loopback UDP; a datagram to itself interrupts the server's poll
+    TunnelAddress waker_address_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    std::mutex mutex_; // guards testers, route queues and the counters below
+    std::vector<std::unique_ptr<Tester>> testers_;
+    uint64_t next_tester_ = 1;
+    bool wake_pending_ = false;
+    uint64_t activations_ = 0;
+    uint64_t requests_ = 0;
+    uint64_t responses_ = 0;
+    uint64_t unanswered_ = 0;
+    uint64_t nacks_ = 0;
+    uint64_t transport_errors_ = 0;
+    uint64_t rejected_ = 0;
+};
+
+#endif // ACE_CAN_DOIP_GATEWAY_H
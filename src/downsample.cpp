@@ -0,0 +1,66 @@
+#include "downsample.h"
+
+#include <algorithm>
+#include <cmath>
+
+void PickLttb(const double* t, const double* v, size_t n, size_t points, std::vector<uint32_t>& picked) {
+    double every = static_cast<double>(n - 2) / static_cast<double>(points - 2);
+    size_t a = 0;
+    picked.push_back(0);
+    for (size_t i = 0; i < points - 2; ++i) {
+        size_t nextStart = static_cast<size_t>(std::floor((i + 1) * every)) + 1;
+        size_t nextEnd = std::min(static_cast<size_t>(std::floor((i + 2) * every)) + 1, n);
+        double avgT = 0;
+        double avgV = 0;
+        for (size_t j = nextStart; j < nextEnd; ++j) {
+            avgT += t[j];
+            avgV += v[j];
+        }
+        size_t nextCount = nextEnd > nextStart ? nextEnd - nextStart : 1;
+        avgT /= static_cast<double>(nextCount);
+        avgV /= static_cast<double>(nextCount);
+
+        size_t start = static_cast<size_t>(std::floor(i * every)) + 1;
+        size_t end = std::min(static_cast<size_t>(std::floor((i + 1) * every)) + 1, n - 1);
+        size_t best = start;
+        double bestArea = -1;
+        for (size_t j = start; j < end; ++j) {
+            double area = std::fabs((t[a] - avgT) * (v[j] - v[a]) - (t[a] - t[j]) * (avgV - v[a]));
+            if (area > bestArea) {
+                bestArea = area;
+                best = j;
+            }
+        }
+        picked.push_back(static_cast<uint32_t>(best));
+        a = best;
+    }
+    picked.push_back(static_cast<uint32_t>(n - 1));
+}
+
+void PickMinMax(const double* t, const double* v, size_t n, size_t points, std::vector<uint32_t>& picked) {
+    size_t buckets = points / 2;
+    double width = (t[n - 1] - t[0]) / static_cast<double>(buckets);
+    size_t bucket = 0;
+    size_t low = 0;
+    size_t high = 0;
+    auto flush = [&]() {
+        picked.push_back(static_cast<uint32_t>(std::min(low, high)));
+        if (low != high) {
+            picked.push_back(static_cast<uint32_t>(std::max(low, high)));
+        }
+    };
+    for (size_t i = 1; i < n; ++i) {
+        size_t b = width > 0 ? std::min(buckets - 1, static_cast<size_t>((t[i] - t[0]) / width)) : 0;
+        if (b != bucket) {
+            flush();
+            bucket = b;
+            low = i;
+            high = i;
+        } else if (v[i] < v[low]) {
+            low = i;
+        } else if (v[i] > v[high]) {
+            high = i;
+        }
+    }
+    flush();
+}
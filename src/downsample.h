@@ -0,0 +1,21 @@
+#ifndef ACE_CAN_DOWNSAMPLE_H
+#define ACE_CAN_DOWNSAMPLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Point-budget downsampling of a time series for plotting. Both take `n` samples in time order
+// (timestamps `t`, values `v`) with 3 <= points < n, and append the indices of the samples to keep
+// to `picked`, ascending, at most `points` of them.
+
+// Largest-triangle-three-buckets: keeps the first and last sample and, from each of `points - 2`
+// equal-count buckets in between, the sample forming the largest triangle with the sample kept
+// before it and the average of the next bucket.
+void PickLttb(const double* t, const double* v, size_t n, size_t points, std::vector<uint32_t>& picked);
+
+// Splits the time span into points / 2 equal buckets and keeps the minimum and maximum of each, in
+// time order, so spikes survive any zoom level.
+void PickMinMax(const double* t, const double* v, size_t n, size_t points, std::vector<uint32_t>& picked);
+
+#endif // ACE_CAN_DOWNSAMPLE_H
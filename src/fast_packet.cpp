@@ -0,0 +1,174 @@
+#include "fast_packet.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace {
+
+// Fast-packet PGNs of the NMEA 2000 standard, plus the proprietary fast-packet range.
+constexpr std::pair<uint32_t, uint32_t> kFastPacketPgns[] = {
+    {126208, 126208}, {126464, 126464}, {126720, 126720}, {126983, 126988}, {126996, 126996},
+    {126998, 126998}, {127233, 127233}, {127237, 127237}, {127489, 127491}, {127494, 127498},
+    {127503, 127504}, {127506, 127507}, {127509, 127514}, {128275, 128275}, {128520, 128520},
+    {128538, 128538}, {129029, 129029}, {129038, 129041}, {129044, 129045}, {129284, 129285},
+    {129301, 129302}, {129538, 129538}, {129540, 129545}, {129547, 129547}, {129549, 129551},
+    {129556, 129556}, {129792, 129813}, {130052, 130054}, {130060, 130061}, {130064, 130074},
+    {130320, 130324}, {130330, 130330}, {130560, 130560}, {130567, 130567}, {130569, 130571},
+    {130573, 130581}, {130583, 130584}, {130586, 130586}, {130816, 131071},
+};
+
+constexpr uint32_t kFrameZeroBytes = 6;
+constexpr uint32_t kFrameBytes = 7;
+
+// Frames needed to carry `length` bytes (frame 0 included).
+uint32_t FramesFor(uint32_t length) {
+    return length <= kFrameZeroBytes ? 1 : 1 + (length - kFrameZeroBytes + kFrameBytes - 1) / kFrameBytes;
+}
+
+} // namespace
+
+FastPacketAssembler::FastPacketAssembler(int64_t timeoutUs)
+    : timeout_us_(timeoutUs), fast_packet_(std::begin(kFastPacketPgns), std::end(kFastPacketPgns)) {}
+
+void FastPacketAssembler::AddFastPacketPgns(const std::vector<uint32_t>& pgns) {
+    for (uint32_t pgn : pgns) {
+        fast_packet_.emplace_back(pgn, pgn);
+    }
+    // Keep the ranges sorted and disjoint so IsFastPacket only has to look at one.
+    std::sort(fast_packet_.begin(), fast_packet_.end());
+    std::vector<std::pair<uint32_t, uint32_t>> merged;
+    for (const auto& range : fast_packet_) {
+        if (!merged.empty() && range.first <= merged.back().second + 1) {
+            merged.back().second = std::max(merged.back().second, range.second);
+        } else {
+            merged.push_back(range);
+        }
+    }
+    fast_packet_ = std::move(merged);
+}
+
+bool FastPacketAssembler::IsFastPacket(uint32_t pgn) const {
+    auto it = std::upper_bound(
+        fast_packet_.begin(), fast_packet_.end(), pgn,
+        [](uint32_t value, const std::pair<uint32_t, uint32_t>& range) { return value < range.first; });
+    return it != fast_packet_.begin() && pgn <= std::prev(it)->second;
+}
+
+void FastPacketAssembler::Expire(int64_t nowUs) {
+    for (auto it = transfers_.begin(); it != transfers_.end();) {
+        if (nowUs - it->second.started_us > timeout_us_) {
+            stats_.timeouts++;
+            it = transfers_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    next_expiry_us_ = nowUs + timeout_us_ / 4;
+}
+
+bool FastPacketAssembler::Push(const CanFrame& frame, int64_t nowUs, Nmea2000Pgn& out) {
+    if ((frame.flags & (kFrameFlagExtended | kFrameFlagRemote | kFrameFlagError)) != kFrameFlagExtended) {
+        return false;
+    }
+    stats_.frames++;
+    if (nowUs >= next_expiry_us_ && !transfers_.empty()) {
+        Expire(nowUs);
+    }
+
+    uint32_t id = frame.id;
+    uint32_t pduFormat = (id >> 16) & 0xFF;
+    uint32_t pgn = (id >> 8) & 0x3FFFF;
+    uint8_t destination = 0xFF;
+    if (pduFormat < 240) { // PDU1: the PDU specific byte is the destination address
+        destination = static_cast<uint8_t>(pgn & 0xFF);
+        pgn &= 0x3FF00;
+    }
+    uint8_t source = static_cast<uint8_t>(id & 0xFF);
+    uint8_t priority = static_cast<uint8_t>((id >> 26) & 0x7);
+
+    if (!IsFastPacket(pgn)) {
+        out.timestamp = frame.timestamp;
+        out.pgn = pgn;
+        out.source = source;
+        out.destination = destination;
+        out.priority = priority;
+        out.length = std::min<uint8_t>(frame.length, 8);
+        std::memcpy(out.data, frame.data, out.length);
+        stats_.pgns++;
+        return true;
+    }
+
+    if (frame.length < 2) {
+        stats_.errors++;
+        return false;
+    }
+    uint32_t index = frame.data[0] & 0x1F;
+    uint32_t sequence = frame.data[0] >> 5;
+    uint32_t key = pgn << 11 | static_cast<uint32_t>(source) << 3 | sequence;
+
+    auto found = transfers_.find(key);
+    if (found != transfers_.end() && (found->second.received & (1u << index)) != 0) {
+        // A frame we already have: the sender has wrapped its sequence counter onto a transfer we
+        // never completed. Start over with this frame.
+        stats_.errors++;
+        transfers_.erase(found);
+        found = transfers_.end();
+    }
+    if (found == transfers_.end()) {
+        if (transfers_.size() >= kMaxInFlight) {
+            Expire(nowUs);
+            if (transfers_.size() >= kMaxInFlight) {
+                stats_.errors++;
+                return false;
+            }
+        }
+        found = transfers_.emplace(key, Transfer()).first;
+        found->second.started_us = nowUs;
+    }
+    Transfer& transfer = found->second;
+
+    if (index == 0) {
+        uint32_t length = frame.data[1];
+        uint32_t frames = FramesFor(length);
+        if (length > Nmea2000Pgn::kMaxLength || (frames < 32 && (transfer.received >> frames) != 0)) {
+            stats_.errors++;
+            transfers_.erase(found);
+            return false;
+        }
+        transfer.length = static_cast<int16_t>(length);
+        uint32_t count = std::min<uint32_t>({kFrameZeroBytes, frame.length - 2u, length});
+        std::memcpy(transfer.pgn.data, frame.data + 2, count);
+    } else {
+        if (transfer.length >= 0 && index >= FramesFor(static_cast<uint32_t>(transfer.length))) {
+            stats_.errors++;
+            transfers_.erase(found);
+            return false;
+        }
+        uint32_t offset = kFrameZeroBytes + (index - 1) * kFrameBytes;
+        uint32_t room = static_cast<uint32_t>(Nmea2000Pgn::kMaxLength) - offset;
+        uint32_t count = std::min<uint32_t>({kFrameBytes, frame.length - 1u, room});
+        std::memcpy(transfer.pgn.data + offset, frame.data + 1, count);
+    }
+    transfer.received |= 1u << index;
+
+    if (transfer.length < 0) {
+        return false;
+    }
+    uint32_t frames = FramesFor(static_cast<uint32_t>(transfer.length));
+    uint32_t all = frames >= 32 ? UINT32_MAX : (1u << frames) - 1;
+    if (transfer.received != all) {
+        return false;
+    }
+    out = transfer.pgn;
+    out.timestamp = frame.timestamp;
+    out.pgn = pgn;
+    out.source = source;
+    out.destination = destination;
+    out.priority = priority;
+    out.length = static_cast<uint8_t>(transfer.length);
+    transfers_.erase(found);
+    stats_.pgns++;
+    stats_.fast_packets++;
+    return true;
+}
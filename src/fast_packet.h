@@ -0,0 +1,72 @@
+#ifndef ACE_CAN_FAST_PACKET_H
+#define ACE_CAN_FAST_PACKET_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "can_frame.h"
+
+// A complete NMEA 2000 parameter group, single-frame or reassembled from a fast packet.
+struct Nmea2000Pgn {
+    static constexpr size_t kMaxLength = 223; // 6 bytes in frame 0 + 31 frames of 7
+
+    uint64_t timestamp = 0; // of the frame that completed it
+    uint32_t pgn = 0;
+    uint8_t source = 0;
+    uint8_t destination = 0xFF; // 0xFF = global (always for PDU2 PGNs)
+    uint8_t priority = 0;
+    uint8_t length = 0;
+    uint8_t data[kMaxLength] = {};
+};
+
+// Reassembles NMEA 2000 fast packets. Frames of one transfer are collected per (source, PGN,
+// sequence counter), so transfers from many sources, and consecutive transfers of the same PGN,
+// can interleave freely; frames within a transfer may arrive in any order, including frame 0. A
+// transfer still incomplete `timeoutUs` after its first frame is discarded. Which PGNs are fast
+// packets cannot be told from the frame, so that comes from a list (IsFastPacket). Not thread-safe;
+// meant to be driven by a single receive thread.
+class FastPacketAssembler {
+public:
+    struct Stats {
+        uint64_t frames = 0; // extended data frames seen
+        uint64_t pgns = 0; // complete PGNs produced
+        uint64_t fast_packets = 0; // of which reassembled from fast packets
+        uint64_t timeouts = 0; // transfers discarded incomplete
+        uint64_t errors = 0; // transfers restarted or discarded on inconsistent frames
+    };
+
+    explicit FastPacketAssembler(int64_t timeoutUs = 750000);
+
+    // Adds PGNs to the built-in list of fast-packet PGNs.
+    void AddFastPacketPgns(const std::vector<uint32_t>& pgns);
+    bool IsFastPacket(uint32_t pgn) const;
+
+    // Feeds one received frame; `nowUs` is a monotonic clock used for timeouts. Returns true and
+    // fills `out` when the frame completes a PGN.
+    bool Push(const CanFrame& frame, int64_t nowUs, Nmea2000Pgn& out);
+
+    size_t InFlight() const { return transfers_.size(); }
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    static constexpr size_t kMaxInFlight = 1024;
+
+    struct Transfer {
+        int64_t started_us = 0;
+        uint32_t received = 0; // bit n = frame n
+        int16_t length = -1; // from frame 0
+        Nmea2000Pgn pgn;
+    };
+
+    void Expire(int64_t nowUs);
+
+    int64_t timeout_us_;
+    int64_t next_expiry_us_ = 0;
+    std::vector<std::pair<uint32_t, uint32_t>> fast_packet_; // sorted, inclusive ranges
+    std::unordered_map<uint32_t, Transfer> transfers_; // pgn << 11 | source << 3 | sequence
+    Stats stats_;
+};
+
+#endif // ACE_CAN_FAST_PACKET_H
@@ -0,0 +1,692 @@
+#include "filter_program.h"
+
+#include <cctype>
+#include <cstring>
+#include <memory>
+
+// Grammar, loosest binding first:
+//
+//   expr    := and ('||' and)*
+//   and     := compare ('&&' compare)*
+//   compare := bitor [('==' | '!=' | '<' | '<=' | '>' | '>=') bitor | 'in' ranges]
+//   ranges  := range | '[' range (',' range)* ']'       range := bitor ['..' bitor]  (inclusive)
+//   bitor   := bitxor ('|' bitxor)*
+//   bitxor  := bitand ('^' bitand)*
+//   bitand  := shift ('&' shift)*
+//   shift   := sum (('<<' | '>>') sum)*
+//   sum     := unary (('+' | '-') unary)*
+//   unary   := ('!' | '~' | '-') unary | primary
+//   primary := number | 'true' | 'false' | field | 'data' '[' const ']' | load '(' const ')' | '(' expr ')'
+//
+//   field   := id | dlc | len | flags | channel | ext | fd | brs | esi | rtr | err | tx | timestamp
+//   load    := le16 | be16 | le32 | be32   (multi-byte payload reads at a byte offset)
+//
+// Range bounds, byte indexes and load offsets must be constant.
+
+namespace {
+
+bool IsIdentifierChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) != 0 || c == '_';
+}
+
+} // namespace
+
+class FilterCompiler {
+public:
+    using Op = FilterProgram::Op;
+    using Field = FilterProgram::Field;
+
+    FilterCompiler(const std::string& source, FilterProgram& program) : source_(source), program_(program) {}
+
+    std::string Run() {
+        if (!Tokenize()) {
+            return error_;
+        }
+        if (tokens_.size() == 1) {
+            return "Empty filter expression";
+        }
+        std::unique_ptr<Node> root = ParseOr();
+        if (root && Peek().kind != Token::Kind::End) {
+            Fail("unexpected '" + Peek().text + "'", Peek().column);
+        }
+        if (!error_.empty()) {
+            return error_;
+        }
+        size_t depth = 0;
+        Emit(*root, depth);
+        if (program_.code_.empty() || program_.code_.back().op != Op::Bool) {
+            Add(Op::Bool);
+        }
+        return error_;
+    }
+
+private:
+    struct Token {
+        enum class Kind { End, Number, Name, Symbol };
+        Kind kind = Kind::End;
+        std::string text;
+        uint64_t number = 0;
+        size_t column = 0;
+    };
+
+    struct FieldName {
+        const char* name;
+        uint8_t field;
+    };
+
+    enum class Kind { Const, Field, Byte, Load, Unary, Binary, And, Or, In };
+
+    struct Node {
+        Kind kind = Kind::Const;
+        Op op = Op::Push;
+        uint64_t value = 0;
+        uint64_t value2 = 0;
+        size_t column = 0;
+        std::unique_ptr<Node> left;
+        std::unique_ptr<Node> right;
+        std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    };
+
+    static constexpr FieldName kFields[] = {
+        {"id", static_cast<uint8_t>(Field::Id)},
+        {"dlc", static_cast<uint8_t>(Field::Dlc)},
+        {"len", static_cast<uint8_t>(Field::Length)},
+        {"length", static_cast<uint8_t>(Field::Length)},
+        {"flags", static_cast<uint8_t>(Field::Flags)},
+        {"channel", static_cast<uint8_t>(Field::Channel)},
+        {"ext", static_cast<uint8_t>(Field::Extended)},
+        {"extended", static_cast<uint8_t>(Field::Extended)},
+        {"fd", static_cast<uint8_t>(Field::Fd)},
+        {"brs", static_cast<uint8_t>(Field::Brs)},
+        {"esi", static_cast<uint8_t>(Field::Esi)},
+        {"rtr", static_cast<uint8_t>(Field::Remote)},
+        {"remote", static_cast<uint8_t>(Field::Remote)},
+        {"err", static_cast<uint8_t>(Field::Error)},
+        {"error", static_cast<uint8_t>(Field::Error)},
+        {"tx", static_cast<uint8_t>(Field::Tx)},
+        {"timestamp", static_cast<uint8_t>(Field::Timestamp)},
+    };
+
+    bool Tokenize() {
+        static const char* const kSymbols[] = {"&&", "||", "==", "!=", "<=", ">=", "<<", ">>", "..", "<", ">", "&",
+                                               "|",  "^",  "~",  "!",  "+",  "-",  "(",  ")",  "[",  "]", ","};
+        size_t i = 0;
+        while (i < source_.size()) {
+            char c = source_[i];
+            if (std::isspace(static_cast<unsigned char>(c)) != 0) {
+                ++i;
+                continue;
+            }
+            Token token;
+            token.column = i + 1;
+            if (std::isdigit(static_cast<unsigned char>(c)) != 0) {
+                int base = 10;
+                size_t start = i;
+                if (c == '0' && i + 1 < source_.size() && (source_[i + 1] == 'x' || source_[i + 1] == 'X')) {
+                    base = 16;
+                    i += 2;
+                } else if (c == '0' && i + 1 < source_.size() && (source_[i + 1] == 'b' || source_[i + 1] == 'B')) {
+                    base = 2;
+                    i += 2;
+                }
+                size_t digits = i;
+                uint64_t value = 0;
+                while (i < source_.size() && IsIdentifierChar(source_[i])) {
+                    char d = static_cast<char>(std::tolower(static_cast<unsigned char>(source_[i])));
+                    int digit = std::isdigit(static_cast<unsigned char>(d)) != 0 ? d - '0' : (d >= 'a' && d <= 'f') ? d - 'a' + 10 : 99;
+                    if (digit >= base || value > (~uint64_t{0} - static_cast<uint64_t>(digit)) / static_cast<uint64_t>(base)) {
+                        return Fail("invalid number", token.column);
+                    }
+                    value = value * static_cast<uint64_t>(base) + static_cast<uint64_t>(digit);
+                    ++i;
+                }
+                if (i == digits) {
+                    return Fail("invalid number", token.column);
+                }
+                token.kind = Token::Kind::Number;
+                token.number = value;
+                token.text = source_.substr(start, i - start);
+            } else if (IsIdentifierChar(c)) {
+                size_t start = i;
+                while (i < source_.size() && IsIdentifierChar(source_[i])) {
+                    ++i;
+                }
+                token.kind = Token::Kind::Name;
+                token.text = source_.substr(start, i - start);
+            } else {
+                for (const char* symbol : kSymbols) {
+                    size_t length = std::strlen(symbol);
+                    if (source_.compare(i, length, symbol) == 0) {
+                        token.kind = Token::Kind::Symbol;
+                        token.text = symbol;
+                        i += length;
+                        break;
+                    }
+                }
+                if (token.kind != Token::Kind::Symbol) {
+                    return Fail(std::string("unexpected character '") + c + "'", token.column);
+                }
+            }
+            tokens_.push_back(std::move(token));
+        }
+        Token end;
+        end.column = source_.size() + 1;
+        end.text = "end of expression";
+        tokens_.push_back(std::move(end));
+        return true;
+    }
+
+    bool Fail(const std::string& message, size_t column) {
+        if (error_.empty()) {
+            error_ = "Filter expression: " + message + " at column " + std::to_string(column);
+        }
+        return false;
+    }
+
+    const Token& Peek() const { return tokens_[pos_]; }
+
+    bool Accept(const char* symbol) {
+        if (Peek().kind == Token::Kind::Symbol && Peek().text == symbol) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    bool Expect(const char* symbol) {
+        if (Accept(symbol)) {
+            return true;
+        }
+        return Fail(std::string("expected '") + symbol + "' before '" + Peek().text + "'", Peek().column);
+    }
+
+    static std::unique_ptr<Node> Constant(uint64_t value, size_t column) {
+        auto node = std::make_unique<Node>();
+        node->kind = Kind::Const;
+        node->value = value;
+        node->column = column;
+        return node;
+    }
+
+    static uint64_t Apply(Op op, uint64_t lhs, uint64_t rhs) {
+        switch (op) {
+            case Op::Add: return lhs + rhs;
+            case Op::Subtract: return lhs - rhs;
+            case Op::BitAnd: return lhs & rhs;
+            case Op::BitOr: return lhs | rhs;
+            case Op::BitXor: return lhs ^ rhs;
+            case Op::ShiftLeft: return rhs >= 64 ? 0 : lhs << rhs;
+            case Op::ShiftRight: return rhs >= 64 ? 0 : lhs >> rhs;
+            case Op::Equal: return lhs == rhs;
+            case Op::NotEqual: return lhs != rhs;
+            case Op::Less: return lhs < rhs;
+            case Op::LessEqual: return lhs <= rhs;
+            case Op::Greater: return lhs > rhs;
+            case Op::GreaterEqual: return lhs >= rhs;
+            default: return 0;
+        }
+    }
+
+    // Builds a binary node, folding it when both sides are constant.
+    static std::unique_ptr<Node> Binary(Op op, std::unique_ptr<Node> left, std::unique_ptr<Node> right) {
+        if (left->kind == Kind::Const && right->kind == Kind::Const) {
+            return Constant(Apply(op, left->value, right->value), left->column);
+        }
+        auto node = std::make_unique<Node>();
+        node->kind = Kind::Binary;
+        node->op = op;
+        node->column = left->column;
+        node->left = std::move(left);
+        node->right = std::move(right);
+        return node;
+    }
+
+    std::unique_ptr<Node> ParseOr() {
+        std::unique_ptr<Node> left = ParseAnd();
+        while (left && Accept("||")) {
+            std::unique_ptr<Node> right = ParseAnd();
+            if (!right) {
+                return nullptr;
+            }
+            if (left->kind == Kind::Const) {
+                left = left->value != 0 ? Constant(1, left->column) : Truth(std::move(right));
+                continue;
+            }
+            auto node = std::make_unique<Node>();
+            node->kind = Kind::Or;
+            node->column = left->column;
+            node->left = std::move(left);
+            node->right = std::move(right);
+            left = std::move(node);
+        }
+        return left;
+    }
+
+    std::unique_ptr<Node> ParseAnd() {
+        std::unique_ptr<Node> left = ParseCompare();
+        while (left && Accept("&&")) {
+            std::unique_ptr<Node> right = ParseCompare();
+            if (!right) {
+                return nullptr;
+            }
+            if (left->kind == Kind::Const) {
+                left = left->value == 0 ? Constant(0, left->column) : Truth(std::move(right));
+                continue;
+            }
+            auto node = std::make_unique<Node>();
+            node->kind = Kind::And;
+            node->column = left->column;
+            node->left = std::move(left);
+            node->right = std::move(right);
+            left = std::move(node);
+        }
+        return left;
+    }
+
+    // `node` as 0 or 1.
+    static std::unique_ptr<Node> Truth(std::unique_ptr<Node> node) {
+        if (node->kind == Kind::Const) {
+            return Constant(node->value != 0, node->column);
+        }
+        auto wrapped = std::make_unique<Node>();
+        wrapped->kind = Kind::Unary;
+        wrapped->op = Op::Bool;
+        wrapped->column = node->column;
+        wrapped->left = std::move(node);
+        return wrapped;
+    }
+
+    std::unique_ptr<Node> ParseCompare() {
+        std::unique_ptr<Node> left = ParseBitOr();
+        if (!left) {
+            return nullptr;
+        }
+        static const std::pair<const char*, Op> kComparisons[] = {
+            {"==", Op::Equal}, {"!=", Op::NotEqual}, {"<=", Op::LessEqual},
+            {">=", Op::GreaterEqual}, {"<", Op::Less}, {">", Op::Greater},
+        };
+        for (const auto& [symbol, op] : kComparisons) {
+            if (Accept(symbol)) {
+                std::unique_ptr<Node> right = ParseBitOr();
+                return right ? Binary(op, std::move(left), std::move(right)) : nullptr;
+            }
+        }
+        if (Peek().kind == Token::Kind::Name && Peek().text == "in") {
+            ++pos_;
+            return ParseIn(std::move(left));
+        }
+        return left;
+    }
+
+    std::unique_ptr<Node> ParseIn(std::unique_ptr<Node> left) {
+        auto node = std::make_unique<Node>();
+        node->kind = Kind::In;
+        node->column = left->column;
+        bool list = Accept("[");
+        do {
+            size_t column = Peek().column;
+            std::unique_ptr<Node> low = ParseBitOr();
+            if (!low) {
+                return nullptr;
+            }
+            std::unique_ptr<Node> high;
+            if (Accept("..")) {
+                high = ParseBitOr();
+                if (!high) {
+                    return nullptr;
+                }
+            }
+            if (low->kind != Kind::Const || (high && high->kind != Kind::Const)) {
+                Fail("range bounds must be constant", column);
+                return nullptr;
+            }
+            node->ranges.emplace_back(low->value, high ? high->value : low->value);
+        } while (list && Accept(","));
+        if (list && !Expect("]")) {
+            return nullptr;
+        }
+        if (left->kind == Kind::Const) {
+            for (const auto& [low, high] : node->ranges) {
+                if (left->value >= low && left->value <= high) {
+                    return Constant(1, left->column);
+                }
+            }
+            return Constant(0, left->column);
+        }
+        node->left = std::move(left);
+        return node;
+    }
+
+    std::unique_ptr<Node> ParseBinaryLevel(std::unique_ptr<Node> (FilterCompiler::*next)(),
+                                           std::initializer_list<std::pair<const char*, Op>> operators) {
+        std::unique_ptr<Node> left = (this->*next)();
+        while (left) {
+            bool matched = false;
+            for (const auto& [symbol, op] : operators) {
+                if (Accept(symbol)) {
+                    std::unique_ptr<Node> right = (this->*next)();
+                    if (!right) {
+                        return nullptr;
+                    }
+                    left = Binary(op, std::move(left), std::move(right));
+                    matched = true;
+                    break;
+                }
+            }
+            if (!matched) {
+                break;
+            }
+        }
+        return left;
+    }
+
+    std::unique_ptr<Node> ParseBitOr() { return ParseBinaryLevel(&FilterCompiler::ParseBitXor, {{"|", Op::BitOr}}); }
+    std::unique_ptr<Node> ParseBitXor() { return ParseBinaryLevel(&FilterCompiler::ParseBitAnd, {{"^", Op::BitXor}}); }
+    std::unique_ptr<Node> ParseBitAnd() { return ParseBinaryLevel(&FilterCompiler::ParseShift, {{"&", Op::BitAnd}}); }
+    std::unique_ptr<Node> ParseShift() {
+        return ParseBinaryLevel(&FilterCompiler::ParseSum, {{"<<", Op::ShiftLeft}, {">>", Op::ShiftRight}});
+    }
+    std::unique_ptr<Node> ParseSum() {
+        return ParseBinaryLevel(&FilterCompiler::ParseUnary, {{"+", Op::Add}, {"-", Op::Subtract}});
+    }
+
+    std::unique_ptr<Node> ParseUnary() {
+        // Bounds the parser's recursion; the emitted code has its own, tighter stack limit.
+        if (++nesting_ > kMaxNesting) {
+            Fail("expression nested too deeply", Peek().column);
+            return nullptr;
+        }
+        std::unique_ptr<Node> node = ParseUnaryOperand();
+        --nesting_;
+        return node;
+    }
+
+    std::unique_ptr<Node> ParseUnaryOperand() {
+        static const std::pair<const char*, Op> kUnary[] = {{"!", Op::Not}, {"~", Op::BitNot}, {"-", Op::Negate}};
+        for (const auto& [symbol, op] : kUnary) {
+            size_t column = Peek().column;
+            if (Accept(symbol)) {
+                std::unique_ptr<Node> operand = ParseUnary();
+                if (!operand) {
+                    return nullptr;
+                }
+                if (operand->kind == Kind::Const) {
+                    uint64_t v = operand->value;
+                    return Constant(op == Op::Not ? v == 0 : op == Op::BitNot ? ~v : uint64_t{0} - v, column);
+                }
+                auto node = std::make_unique<Node>();
+                node->kind = Kind::Unary;
+                node->op = op;
+                node->column = column;
+                node->left = std::move(operand);
+                return node;
+            }
+        }
+        return ParsePrimary();
+    }
+
+    // A constant byte offset inside brackets or parentheses.
+    bool ParseOffset(const char* open, const char* close, uint64_t& offset) {
+        if (!Expect(open)) {
+            return false;
+        }
+        size_t column = Peek().column;
+        std::unique_ptr<Node> index = ParseOr();
+        if (!index || !Expect(close)) {
+            return false;
+        }
+        if (index->kind != Kind::Const || index->value >= 64) {
+            return Fail("byte offset must be a constant from 0 to 63", column);
+        }
+        offset = index->value;
+        return true;
+    }
+
+    std::unique_ptr<Node> ParsePrimary() {
+        const Token& token = Peek();
+        size_t column = token.column;
+        if (token.kind == Token::Kind::Number) {
+            ++pos_;
+            return Constant(token.number, column);
+        }
+        if (Accept("(")) {
+            std::unique_ptr<Node> inner = ParseOr();
+            return inner && Expect(")") ? std::move(inner) : nullptr;
+        }
+        if (token.kind != Token::Kind::Name) {
+            Fail("unexpected '" + token.text + "'", column);
+            return nullptr;
+        }
+        std::string name = token.text;
+        ++pos_;
+        if (name == "true" || name == "false") {
+            return Constant(name == "true", column);
+        }
+        for (const FieldName& field : kFields) {
+            if (name == field.name) {
+                auto node = std::make_unique<Node>();
+                node->kind = Kind::Field;
+                node->value = field.field;
+                node->column = column;
+                return node;
+            }
+        }
+        auto node = std::make_unique<Node>();
+        node->column = column;
+        if (name == "data") {
+            node->kind = Kind::Byte;
+            return ParseOffset("[", "]", node->value) ? std::move(node) : nullptr;
+        }
+        if (name == "le16" || name == "be16" || name == "le32" || name == "be32") {
+            node->kind = Kind::Load;
+            node->value2 = (name[2] == '1' ? 2 : 4) | (name[0] == 'b' ? 0x100 : 0);
+            return ParseOffset("(", ")", node->value) ? std::move(node) : nullptr;
+        }
+        Fail("unknown name '" + name + "'", column);
+        return nullptr;
+    }
+
+    FilterProgram::Instruction& Add(Op op) {
+        program_.code_.emplace_back();
+        program_.code_.back().op = op;
+        return program_.code_.back();
+    }
+
+    void Push(size_t& depth, size_t column) {
+        if (++depth > FilterProgram::kMaxStack) {
+            Fail("expression nested too deeply", column);
+        }
+    }
+
+    // Appends code leaving the node's value on the stack; `depth` tracks the stack height.
+    void Emit(const Node& node, size_t& depth) {
+        switch (node.kind) {
+            case Kind::Const:
+                Add(Op::Push).value = node.value;
+                Push(depth, node.column);
+                break;
+            case Kind::Field:
+                Add(Op::Field).a = static_cast<uint16_t>(node.value);
+                Push(depth, node.column);
+                break;
+            case Kind::Byte:
+                Add(Op::Byte).a = static_cast<uint16_t>(node.value);
+                Push(depth, node.column);
+                break;
+            case Kind::Load: {
+                FilterProgram::Instruction& load = Add(Op::Load);
+                load.a = static_cast<uint16_t>(node.value);
+                load.value = node.value2 & 0xFF;
+                load.value2 = (node.value2 >> 8) & 1;
+                Push(depth, node.column);
+                break;
+            }
+            case Kind::Unary:
+                Emit(*node.left, depth);
+                Add(node.op);
+                break;
+            case Kind::Binary:
+                Emit(*node.left, depth);
+                if (node.right->kind == Kind::Const) {
+                    FilterProgram::Instruction& op = Add(node.op);
+                    op.immediate = true;
+                    op.value = node.right->value;
+                } else {
+                    Emit(*node.right, depth);
+                    Add(node.op);
+                    --depth;
+                }
+                break;
+            case Kind::And:
+            case Kind::Or: {
+                Emit(*node.left, depth);
+                size_t jump = program_.code_.size();
+                Add(node.kind == Kind::And ? Op::AndJump : Op::OrJump);
+                --depth;
+                Emit(*node.right, depth);
+                Add(Op::Bool);
+                program_.code_[jump].target = static_cast<uint32_t>(program_.code_.size());
+                break;
+            }
+            case Kind::In: {
+                Emit(*node.left, depth);
+                if (node.ranges.size() == 1) {
+                    FilterProgram::Instruction& range = Add(Op::InRange);
+                    range.value = node.ranges[0].first;
+                    range.value2 = node.ranges[0].second;
+                } else {
+                    FilterProgram::Instruction& set = Add(Op::InSet);
+                    set.a = static_cast<uint16_t>(program_.ranges_.size());
+                    set.target = static_cast<uint32_t>(node.ranges.size());
+                    program_.ranges_.insert(program_.ranges_.end(), node.ranges.begin(), node.ranges.end());
+                }
+                break;
+            }
+        }
+    }
+
+    const std::string& source_;
+    FilterProgram& program_;
+    static constexpr size_t kMaxNesting = 64;
+
+    std::vector<Token> tokens_;
+    size_t pos_ = 0;
+    size_t nesting_ = 0;
+    std::string error_;
+};
+
+std::string FilterProgram::Compile(const std::string& source, FilterProgram& out) {
+    FilterProgram program;
+    program.source_ = source;
+    std::string error = FilterCompiler(source, program).Run();
+    if (error.empty()) {
+        if (program.ranges_.size() > 0xFFFF) {
+            return "Filter expression: too many ranges";
+        }
+        out = std::move(program);
+    }
+    return error;
+}
+
+bool FilterProgram::Matches(const CanFrame& frame) const {
+    uint64_t stack[kMaxStack];
+    size_t sp = 0;
+    const Instruction* code = code_.data();
+    size_t count = code_.size();
+    for (size_t pc = 0; pc < count;) {
+        const Instruction& in = code[pc++];
+        switch (in.op) {
+            case Op::Push:
+                stack[sp++] = in.value;
+                break;
+            case Op::Field: {
+                uint64_t value = 0;
+                switch (static_cast<Field>(in.a)) {
+                    case Field::Id: value = frame.id; break;
+                    case Field::Dlc: value = CanFdLengthToDlc(frame.length); break;
+                    case Field::Length: value = frame.length; break;
+                    case Field::Flags: value = frame.flags; break;
+                    case Field::Channel: value = frame.channel; break;
+                    case Field::Extended: value = (frame.flags & kFrameFlagExtended) != 0; break;
+                    case Field::Fd: value = (frame.flags & kFrameFlagFd) != 0; break;
+                    case Field::Brs: value = (frame.flags & kFrameFlagBrs) != 0; break;
+                    case Field::Esi: value = (frame.flags & kFrameFlagEsi) != 0; break;
+                    case Field::Remote: value = (frame.flags & kFrameFlagRemote) != 0; break;
+                    case Field::Error: value = (frame.flags & kFrameFlagError) != 0; break;
+                    case Field::Tx: value = (frame.flags & kFrameFlagTx) != 0; break;
+                    case Field::Timestamp: value = frame.timestamp; break;
+                }
+                stack[sp++] = value;
+                break;
+            }
+            case Op::Byte:
+                stack[sp++] = in.a < frame.length ? frame.data[in.a] : 0;
+                break;
+            case Op::Load: {
+                uint64_t value = 0;
+                if (in.a + in.value <= frame.length) {
+                    for (uint64_t i = 0; i < in.value; ++i) {
+                        uint64_t byte = frame.data[in.a + i];
+                        value |= in.value2 != 0 ? byte << (8 * (in.value - 1 - i)) : byte << (8 * i);
+                    }
+                }
+                stack[sp++] = value;
+                break;
+            }
+            case Op::Not: stack[sp - 1] = stack[sp - 1] == 0; break;
+            case Op::BitNot: stack[sp - 1] = ~stack[sp - 1]; break;
+            case Op::Negate: stack[sp - 1] = uint64_t{0} - stack[sp - 1]; break;
+            case Op::Bool: stack[sp - 1] = stack[sp - 1] != 0; break;
+            case Op::InRange:
+                stack[sp - 1] = stack[sp - 1] >= in.value && stack[sp - 1] <= in.value2;
+                break;
+            case Op::InSet: {
+                uint64_t value = stack[sp - 1];
+                uint64_t found = 0;
+                for (uint32_t i = 0; i < in.target && found == 0; ++i) {
+                    const auto& [low, high] = ranges_[in.a + i];
+                    found = value >= low && value <= high;
+                }
+                stack[sp - 1] = found;
+                break;
+            }
+            case Op::AndJump:
+                if (stack[sp - 1] == 0) {
+                    pc = in.target;
+                } else {
+                    --sp;
+                }
+                break;
+            case Op::OrJump:
+                if (stack[sp - 1] != 0) {
+                    stack[sp - 1] = 1;
+                    pc = in.target;
+                } else {
+                    --sp;
+                }
+                break;
+            default: {
+                uint64_t rhs = in.immediate ? in.value : stack[--sp];
+                uint64_t& lhs = stack[sp - 1];
+                switch (in.op) {
+                    case Op::Add: lhs += rhs; break;
+                    case Op::Subtract: lhs -= rhs; break;
+                    case Op::BitAnd: lhs &= rhs; break;
+                    case Op::BitOr: lhs |= rhs; break;
+                    case Op::BitXor: lhs ^= rhs; break;
+                    case Op::ShiftLeft: lhs = rhs >= 64 ? 0 : lhs << rhs; break;
+                    case Op::ShiftRight: lhs = rhs >= 64 ? 0 : lhs >> rhs; break;
+                    case Op::Equal: lhs = lhs == rhs; break;
+                    case Op::NotEqual: lhs = lhs != rhs; break;
+                    case Op::Less: lhs = lhs < rhs; break;
+                    case Op::LessEqual: lhs = lhs <= rhs; break;
+                    case Op::Greater: lhs = lhs > rhs; break;
+                    case Op::GreaterEqual: lhs = lhs >= rhs; break;
+                    default: break;
+                }
+                break;
+            }
+        }
+    }
+    return sp > 0 && stack[sp - 1] != 0;
+}
@@ -0,0 +1,77 @@
+#ifndef ACE_CAN_FILTER_PROGRAM_H
+#define ACE_CAN_FILTER_PROGRAM_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "can_frame.h"
+
+// Frame filter expression compiled to a compact stack bytecode, e.g.
+//
+//   id in 0x100..0x1FF && data[2] & 0x08 && dlc == 8
+//
+// Values are unsigned 64-bit integers and anything non-zero is true. Bitwise operators bind tighter
+// than comparisons, which bind tighter than && and || (see filter_program.cpp for the grammar).
+// Constant subexpressions are folded and constant right operands become instruction immediates,
+// so a typical rule runs as a handful of instructions per frame.
+class FilterProgram {
+public:
+    // Returns why `source` does not compile ("... at column N"), or an empty string on success.
+    static std::string Compile(const std::string& source, FilterProgram& out);
+
+    bool Matches(const CanFrame& frame) const;
+    const std::string& Source() const { return source_; }
+    size_t Size() const { return code_.size(); }
+
+private:
+    friend class FilterCompiler;
+
+    static constexpr size_t kMaxStack = 16;
+
+    enum class Field : uint8_t { Id, Dlc, Length, Flags, Channel, Extended, Fd, Brs, Esi, Remote, Error, Tx, Timestamp };
+
+    enum class Op : uint8_t {
+        Push,
+        Field,   // a = Field
+        Byte,    // data[a], 0 past the payload
+        Load,    // a = offset, value = width in bytes, value2 = 1 for big endian; 0 past the payload
+        Not,
+        BitNot,
+        Negate,
+        Bool,
+        Add,
+        Subtract,
+        BitAnd,
+        BitOr,
+        BitXor,
+        ShiftLeft,
+        ShiftRight,
+        Equal,
+        NotEqual,
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual,
+        InRange, // value..value2
+        InSet,   // ranges_[a .. a + target)
+        AndJump, // top == 0: keep it and jump to target; otherwise pop
+        OrJump,  // top != 0: make it 1 and jump to target; otherwise pop
+    };
+
+    struct Instruction {
+        Op op = Op::Push;
+        bool immediate = false; // binary op takes its right operand from value
+        uint16_t a = 0;
+        uint32_t target = 0;
+        uint64_t value = 0;
+        uint64_t value2 = 0;
+    };
+
+    std::string source_;
+    std::vector<Instruction> code_;
+    std::vector<std::pair<uint64_t, uint64_t>> ranges_;
+};
+
+#endif // ACE_CAN_FILTER_PROGRAM_H
@@ -0,0 +1,119 @@
+#include "flash_session.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+constexpr uint8_t kRequestDownload = 0x34;
+constexpr uint8_t kTransferData = 0x36;
+constexpr uint8_t kRequestTransferExit = 0x37;
+constexpr uint8_t kPositiveOffset = 0x40;
+
+// Why a request got no usable answer, or an empty string if it got a positive response.
+std::string Failure(const UdsResponse& response, uint8_t service) {
+    if (!response.error.empty()) {
+        return response.error;
+    }
+    char text[64];
+    if (response.nrc != 0) {
+        std::snprintf(text, sizeof(text), "service 0x%02X rejected with NRC 0x%02X", service, response.nrc);
+        return text;
+    }
+    if (response.data.empty() || response.data[0] != static_cast<uint8_t>(service + kPositiveOffset)) {
+        std::snprintf(text, sizeof(text), "unexpected response to service 0x%02X", service);
+        return text;
+    }
+    return std::string();
+}
+
+void PutBigEndian32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+} // namespace
+
+Async<std::string> FlashDownload(const IsoTpConfig& config, const UdsTiming& timing, size_t maxBlock,
+                                 FlashTarget& target, std::function<void(size_t)> onBlock) {
+    SessionScheduler& scheduler = *target.scheduler;
+    for (const std::vector<uint8_t>& request : target.prepare) {
+        target.step = "prepare";
+        UdsResponse response = co_await UdsRequest(scheduler, config, timing, target.tx_id, target.rx_id, request);
+        std::string error = response.nrc != 0 || !response.error.empty() ? Failure(response, request[0]) : "";
+        if (!error.empty()) {
+            co_return error;
+        }
+    }
+
+    // RequestDownload with 4-byte address and size; the answer caps the TransferData length.
+    target.step = "requestDownload";
+    std::vector<uint8_t> request;
+    request.push_back(kRequestDownload);
+    request.push_back(target.data_format);
+    request.push_back(0x44); // addressAndLengthFormatIdentifier: 4-byte size, 4-byte address
+    PutBigEndian32(request, target.address);
+    PutBigEndian32(request, static_cast<uint32_t>(target.length));
+    UdsResponse response = co_await UdsRequest(scheduler, config, timing, target.tx_id, target.rx_id, request);
+    std::string error = Failure(response, kRequestDownload);
+    if (!error.empty()) {
+        co_return error;
+    }
+    size_t lengthBytes = response.data.size() >= 2 ? response.data[1] >> 4 : 0;
+    if (lengthBytes == 0 || lengthBytes > 8 || response.data.size() < 2 + lengthBytes) {
+        co_return std::string("RequestDownload response without maxNumberOfBlockLength");
+    }
+    uint64_t ecuBlock = 0;
+    for (size_t i = 0; i < lengthBytes; ++i) {
+        ecuBlock = (ecuBlock << 8) | response.data[2 + i];
+    }
+    ecuBlock = std::min<uint64_t>(ecuBlock, maxBlock);
+    if (ecuBlock < 3) {
+        co_return std::string("ECU maxNumberOfBlockLength too small");
+    }
+    size_t chunk = static_cast<size_t>(ecuBlock) - 2; // SID and block sequence counter
+
+    target.step = "transferData";
+    const uint8_t* data = target.image->Data() + target.offset;
+    uint8_t sequence = 1;
+    while (target.sent < target.length) {
+        size_t size = std::min<size_t>(chunk, target.length - target.sent);
+        request.clear();
+        request.push_back(kTransferData);
+        request.push_back(sequence);
+        request.insert(request.end(), data + target.sent, data + target.sent + size);
+        response = co_await UdsRequest(scheduler, config, timing, target.tx_id, target.rx_id, request);
+        error = Failure(response, kTransferData);
+        if (!error.empty()) {
+            co_return error;
+        }
+        if (response.data.size() < 2 || response.data[1] != sequence) {
+            co_return std::string("TransferData answered with the wrong block sequence counter");
+        }
+        sequence++; // wraps from 0xFF to 0x00
+        target.sent += size;
+        if (onBlock) {
+            onBlock(size);
+        }
+    }
+
+    target.step = "requestTransferExit";
+    response = co_await UdsRequest(scheduler, config, timing, target.tx_id, target.rx_id,
+                                 std::vector<uint8_t>(1, kRequestTransferExit));
+    error = Failure(response, kRequestTransferExit);
+    if (!error.empty()) {
+        co_return error;
+    }
+
+    for (const std::vector<uint8_t>& finish : target.finish) {
+        target.step = "finish";
+        response = co_await UdsRequest(scheduler, config, timing, target.tx_id, target.rx_id, finish);
+        error = response.nrc != 0 || !response.error.empty() ? Failure(response, finish[0]) : "";
+        if (!error.empty()) {
+            co_return error;
+        }
+    }
+    target.step.clear();
+    co_return std::string();
+}
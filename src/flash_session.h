@@ -0,0 +1,41 @@
+#ifndef ACE_CAN_FLASH_SESSION_H
+#define ACE_CAN_FLASH_SESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+#include "uds_session.h"
+
+// One ECU to flash and, once its download has run, how it went.
+struct FlashTarget {
+    std::string name;
+    SessionScheduler* scheduler = nullptr;
+    uint32_t tx_id = 0;
+    uint32_t rx_id = 0;
+    std::shared_ptr<MappedFile> image;
+    uint32_t address = 0;
+    size_t offset = 0;
+    size_t length = 0;
+    uint8_t data_format = 0; // RequestDownload dataFormatIdentifier (compression / encryption)
+    std::vector<std::vector<uint8_t>> prepare; // e.g. programming session, before the download
+    std::vector<std::vector<uint8_t>> finish; // e.g. check routine, reset, after it
+    std::string error; // empty on success
+    std::string step; // where it failed
+    uint64_t sent = 0;
+    int64_t elapsed_us = 0;
+};
+
+// The UDS download sequence for one target on its scheduler: the prepare requests, then
+// RequestDownload, TransferData blocks of at most `maxBlock` bytes (or less if the ECU asks) and
+// RequestTransferExit, then the finish requests. `onBlock` gets the payload size of each
+// acknowledged block. Returns why the download failed, with target.step naming where, or an empty
+// string.
+Async<std::string> FlashDownload(const IsoTpConfig& config, const UdsTiming& timing, size_t maxBlock,
+                                 FlashTarget& target, std::function<void(size_t)> onBlock);
+
+#endif // ACE_CAN_FLASH_SESSION_H
@@ -0,0 +1,350 @@
+#include "flasher.h"
+
+#include <unordered_set>
+
+#include "ace_can.h"
+#include "napi_options.h"
+#include "timed_tx.h"
+
+Napi::Object Flasher::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "Flasher", {
+        InstanceMethod("flash", &Flasher::Flash),
+        InstanceMethod("on", &Flasher::On),
+        InstanceMethod("stats", &Flasher::Stats),
+        InstanceMethod("close", &Flasher::Close),
+    });
+    exports.Set("Flasher", func);
+    return exports;
+}
+
+// new Flasher({ blockSize, stMin, padding, timeoutMs, p2Ms, p2StarMs, maxBlockLength, progressIntervalMs }?)
+Flasher::Flasher(const Napi::CallbackInfo& info) : Napi::ObjectWrap<Flasher>(info) {
+    Napi::Env env = info.Env();
+    if (info.Length() > 0 && info[0].IsObject()) {
+        Napi::Object options = info[0].As<Napi::Object>();
+        if (!ReadIsoTpOptions(env, options, config_)) {
+            return;
+        }
+        uint32_t maxBlock = static_cast<uint32_t>(max_block_);
+        uint32_t intervalMs = static_cast<uint32_t>(progress_interval_us_ / 1000);
+        if (!ReadUdsTiming(options, timing_) || !GetOptionalUint32(options, "maxBlockLength", maxBlock) ||
+            !GetOptionalUint32(options, "progressIntervalMs", intervalMs)) {
+            Napi::TypeError::New(env, "Invalid flasher option type").ThrowAsJavaScriptException();
+            return;
+        }
+        if (maxBlock < 3 || maxBlock > kMaxTransfer) {
+            Napi::RangeError::New(env, "maxBlockLength must be 3 to 4095").ThrowAsJavaScriptException();
+            return;
+        }
+        max_block_ = maxBlock;
+        progress_interval_us_ = static_cast<int64_t>(intervalMs) * 1000;
+    }
+    // Only holds the event loop open while flash() calls are pending.
+    tsfn_ = Napi::ThreadSafeFunction::New(env, Napi::Function::New(env, [](const Napi::CallbackInfo&) {}), "Flasher",
+                                          0, 1);
+    tsfn_.Unref(env);
+}
+
+Flasher::~Flasher() {
+    Shutdown();
+}
+
+// flash([{ bus, txId, rxId, image, address, offset, length, dataFormat, prepare, finish, name }])
+// resolves with one result per target once every target has finished or failed.
+Napi::Value Flasher::Flash(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (closed_) {
+        Napi::Error::New(env, "Flasher closed").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected an array of targets").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto job = std::make_shared<Job>();
+    std::unordered_map<CANBus*, SessionScheduler*> schedulers;
+    std::unordered_map<std::string, std::shared_ptr<MappedFile>> images;
+    std::unordered_set<std::string> endpoints;
+    std::unordered_set<std::string> busy; // endpoints of the jobs still running
+    for (const auto& entry : jobs_) {
+        busy.insert(entry.second->endpoints.begin(), entry.second->endpoints.end());
+    }
+    Napi::Array list = info[0].As<Napi::Array>();
+    for (uint32_t i = 0; i < list.Length(); ++i) {
+        Napi::Value entry = list.Get(i);
+        if (!entry.IsObject()) {
+            Napi::TypeError::New(env, "Each target must be an object").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Object options = entry.As<Napi::Object>();
+        CANBus* bus = CANBus::FromValue(env, options.Get("bus"));
+        if (bus == nullptr || !options.Get("txId").IsNumber() || !options.Get("rxId").IsNumber() ||
+            !options.Get("image").IsString()) {
+            Napi::TypeError::New(env, "Each target needs a CANBus bus, numeric txId and rxId and an image path")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        FlashTarget target;
+        target.tx_id = options.Get("txId").As<Napi::Number>().Uint32Value();
+        target.rx_id = options.Get("rxId").As<Napi::Number>().Uint32Value();
+        uint32_t address = 0;
+        uint32_t offset = 0;
+        uint32_t length = 0;
+        uint32_t dataFormat = 0;
+        bool hasLength = options.Has("length") && !options.Get("length").IsUndefined();
+        if (!GetOptionalString(options, "name", target.name) || !GetOptionalUint32(options, "address", address) ||
+            !GetOptionalUint32(options, "offset", offset) || !GetOptionalUint32(options, "length", length) ||
+            !GetOptionalUint32(options, "dataFormat", dataFormat) || dataFormat > 0xFF ||
+            (options.Has("prepare") && !options.Get("prepare").IsUndefined() &&
+             !ReadUdsRequests(options.Get("prepare"), target.prepare)) ||
+            (options.Has("finish") && !options.Get("finish").IsUndefined() &&
+             !ReadUdsRequests(options.Get("finish"), target.finish))) {
+            Napi::TypeError::New(env, "Invalid flash target option").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        std::string path = options.Get("image").As<Napi::String>().Utf8Value();
+        std::shared_ptr<MappedFile>& image = images[path];
+        if (!image) {
+            image = std::make_shared<MappedFile>();
+            std::string error = image->Open(path);
+            if (!error.empty()) {
+                Napi::Error::New(env, error).ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+        }
+        if (offset > image->Size()) {
+            Napi::RangeError::New(env, "offset is past the end of " + path).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        size_t available = image->Size() - offset;
+        target.length = hasLength ? length : available;
+        if (target.length == 0 || target.length > available) {
+            Napi::RangeError::New(env, "Nothing to flash, or length runs past the end of " + path)
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        target.image = image;
+        target.address = address;
+        target.offset = offset;
+        target.data_format = static_cast<uint8_t>(dataFormat);
+
+        // Responses are routed by CAN ID per bus, so two targets answering on one ID would mix, in
+        // this job or in another one still running on the bus.
+        std::string endpoint = std::to_string(reinterpret_cast<uintptr_t>(bus)) + ":" + std::to_string(target.rx_id);
+        if (!endpoints.insert(endpoint).second) {
+            Napi::RangeError::New(env, "Two targets on one bus share rxId " + std::to_string(target.rx_id))
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        if (busy.count(endpoint) != 0) {
+            Napi::RangeError::New(env, "rxId " + std::to_string(target.rx_id) + " is in use on this bus by another flash()")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        job->endpoints.push_back(std::move(endpoint));
+        SessionScheduler*& scheduler = schedulers[bus];
+        if (scheduler == nullptr) {
+            job->schedulers.push_back(std::make_unique<SessionScheduler>(bus));
+            job->bus_refs.push_back(Napi::Persistent(options.Get("bus").As<Napi::Object>()));
+            scheduler = job->schedulers.back().get();
+        }
+        target.scheduler = scheduler;
+        job->total_bytes += target.length;
+        job->targets.push_back(std::move(target));
+    }
+
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    if (job->targets.empty()) {
+        deferred.Resolve(Napi::Array::New(env));
+        return deferred.Promise();
+    }
+    job->id = next_id_++;
+    job->remaining = job->targets.size();
+    jobs_.emplace(job->id, job);
+    pending_.emplace(job->id, deferred);
+    if (pending_.size() == 1) {
+        tsfn_.Ref(env);
+        Ref();
+    }
+    for (std::unique_ptr<SessionScheduler>& scheduler : job->schedulers) {
+        scheduler->Start();
+    }
+    for (FlashTarget& target : job->targets) {
+        FlashTarget* slot = &target;
+        target.scheduler->Spawn([this, job, slot]() { return Run(job, *slot); });
+    }
+    return deferred.Promise();
+}
+
+SessionTask Flasher::Run(std::shared_ptr<Job> job, FlashTarget& target) {
+    int64_t startUs = HostMicros();
+    target.error = co_await FlashDownload(config_, timing_, max_block_, target, [this, &job = *job](size_t size) {
+        job.sent_bytes += size;
+        Progress(job, false);
+    });
+    target.elapsed_us = HostMicros() - startUs;
+    if (!target.error.empty()) {
+        job->failed++;
+    }
+    Progress(*job, true);
+    if (--job->remaining == 0) {
+        Complete(std::move(job));
+    }
+}
+
+// Called from scheduler threads. Reports at most once per progressIntervalMs across all of the
+// job's buses, plus whenever a target finishes.
+void Flasher::Progress(Job& job, bool force) {
+    int64_t nowUs = HostMicros();
+    int64_t last = job.last_progress_us.load(std::memory_order_relaxed);
+    if (!force && (nowUs - last < progress_interval_us_ ||
+                   !job.last_progress_us.compare_exchange_strong(last, nowUs, std::memory_order_relaxed))) {
+        return;
+    }
+    if (force) {
+        job.last_progress_us.store(nowUs, std::memory_order_relaxed);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!tsfn_progress_) {
+        return;
+    }
+    double bytes = static_cast<double>(job.sent_bytes.load());
+    double totalBytes = static_cast<double>(job.total_bytes);
+    double targets = static_cast<double>(job.targets.size());
+    double done = targets - static_cast<double>(job.remaining.load()) + (force ? 1 : 0);
+    double failed = static_cast<double>(job.failed.load());
+    tsfn_progress_.NonBlockingCall([bytes, totalBytes, targets, done, failed](Napi::Env env, Napi::Function callback) {
+        Napi::Object progress = Napi::Object::New(env);
+        progress.Set("bytes", Napi::Number::New(env, bytes));
+        progress.Set("totalBytes", Napi::Number::New(env, totalBytes));
+        progress.Set("targets", Napi::Number::New(env, targets));
+        progress.Set("done", Napi::Number::New(env, done));
+        progress.Set("failed", Napi::Number::New(env, failed));
+        callback.Call({progress});
+    });
+}
+
+// Runs on the scheduler thread of the last target to finish. The schedulers are stopped and the
+// job released on the JS thread; after close() the thread-safe function drops the callback.
+void Flasher::Complete(std::shared_ptr<Job> job) {
+    tsfn_.NonBlockingCall([this, job](Napi::Env env, Napi::Function) {
+        StopJob(*job);
+        jobs_.erase(job->id);
+        auto it = pending_.find(job->id);
+        if (it == pending_.end()) {
+            return;
+        }
+        Napi::Promise::Deferred deferred = it->second;
+        pending_.erase(it);
+        Napi::Array results = Napi::Array::New(env, job->targets.size());
+        for (size_t i = 0; i < job->targets.size(); ++i) {
+            const FlashTarget& target = job->targets[i];
+            Napi::Object result = Napi::Object::New(env);
+            if (!target.name.empty()) {
+                result.Set("name", Napi::String::New(env, target.name));
+            }
+            result.Set("txId", Napi::Number::New(env, target.tx_id));
+            result.Set("rxId", Napi::Number::New(env, target.rx_id));
+            result.Set("ok", Napi::Boolean::New(env, target.error.empty()));
+            if (!target.error.empty()) {
+                result.Set("error", Napi::String::New(env, target.error));
+                result.Set("step", Napi::String::New(env, target.step));
+                failed_++;
+            } else {
+                flashed_++;
+            }
+            result.Set("bytes", Napi::Number::New(env, static_cast<double>(target.sent)));
+            result.Set("elapsedMs", Napi::Number::New(env, static_cast<double>(target.elapsed_us) / 1000.0));
+            results.Set(static_cast<uint32_t>(i), result);
+        }
+        deferred.Resolve(results);
+        if (pending_.empty()) {
+            tsfn_.Unref(env);
+            Unref();
+        }
+    });
+}
+
+void Flasher::StopJob(Job& job) {
+    for (std::unique_ptr<SessionScheduler>& scheduler : job.schedulers) {
+        scheduler->Stop();
+    }
+    for (Napi::ObjectReference& ref : job.bus_refs) {
+        ref.Reset();
+    }
+}
+
+// on('progress', ({ bytes, totalBytes, targets, done, failed }) => ...)
+Napi::Value Flasher::On(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Expected (event, callback)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (closed_) {
+        Napi::Error::New(env, "Flasher closed").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::string event = info[0].As<Napi::String>();
+    if (event != "progress") {
+        Napi::Error::New(env, "Only 'progress' events supported").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (tsfn_progress_) {
+        Napi::Error::New(env, "Already listening for progress").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    tsfn_progress_ = Napi::ThreadSafeFunction::New(env, info[1].As<Napi::Function>(), "FlasherOnProgress", 0, 1);
+    // Pending flash() calls keep the loop alive, not the listener.
+    tsfn_progress_.Unref(env);
+    return env.Undefined();
+}
+
+Napi::Value Flasher::Stats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object stats = Napi::Object::New(env);
+    stats.Set("pending", Napi::Number::New(env, static_cast<double>(pending_.size())));
+    stats.Set("flashed", Napi::Number::New(env, static_cast<double>(flashed_)));
+    stats.Set("failed", Napi::Number::New(env, static_cast<double>(failed_)));
+    return stats;
+}
+
+Napi::Value Flasher::Close(const Napi::CallbackInfo& info) {
+    Shutdown();
+    return info.Env().Undefined();
+}
+
+// Aborts every download in progress: the ECUs are left mid-transfer, as after a power cut.
+void Flasher::Shutdown() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+    for (auto& entry : jobs_) {
+        StopJob(*entry.second);
+    }
+    jobs_.clear();
+    if (tsfn_) {
+        tsfn_.Abort();
+        tsfn_ = nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (tsfn_progress_) {
+            tsfn_progress_.Release();
+            tsfn_progress_ = nullptr;
+        }
+    }
+    if (pending_.empty()) {
+        return;
+    }
+    Napi::Env env = Env();
+    for (auto& entry : pending_) {
+        entry.second.Reject(Napi::Error::New(env, "Flasher closed").Value());
+    }
+    pending_.clear();
+    Unref();
+}
@@ -0,0 +1,77 @@
+#ifndef ACE_CAN_FLASHER_H
+#define ACE_CAN_FLASHER_H
+
+#include <napi.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "flash_session.h"
+#include "isotp.h"
+#include "uds.h"
+
+class CANBus;
+
+// Flashes ECUs over UDS (RequestDownload / TransferData / RequestTransferExit) on several buses at
+// once. Every bus in a flash() call gets its own SessionScheduler thread, so channels proceed in
+// parallel without a JS round trip per block; ECUs on the same bus share that bus's thread. Images
+// are memory-mapped once per path and read in place by every target that uses them.
+class Flasher : public Napi::ObjectWrap<Flasher> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    Flasher(const Napi::CallbackInfo& info);
+    ~Flasher();
+
+    Napi::Value Flash(const Napi::CallbackInfo& info);
+    Napi::Value On(const Napi::CallbackInfo& info);
+    Napi::Value Stats(const Napi::CallbackInfo& info);
+    Napi::Value Close(const Napi::CallbackInfo& info);
+
+private:
+    static constexpr size_t kMaxTransfer = 4095; // largest ISO-TP message, so TransferData blocks fit one
+
+    // One flash() call. Targets are written by their scheduler threads until the job completes;
+    // the job itself is only created and released on the JS thread (jobs_), so a scheduler is
+    // never destroyed from its own thread.
+    struct Job {
+        uint64_t id = 0;
+        std::vector<FlashTarget> targets;
+        std::vector<std::unique_ptr<SessionScheduler>> schedulers; // one per bus
+        std::vector<Napi::ObjectReference> bus_refs;
+        std::vector<std::string> endpoints; // "bus:rxId" of each target
+        uint64_t total_bytes = 0;
+        std::atomic<uint64_t> sent_bytes{0};
+        std::atomic<size_t> remaining{0};
+        std::atomic<size_t> failed{0};
+        std::atomic<int64_t> last_progress_us{0};
+    };
+
+    SessionTask Run(std::shared_ptr<Job> job, FlashTarget& target);
+    void Progress(Job& job, bool force);
+    void Complete(std::shared_ptr<Job> job);
+    void StopJob(Job& job);
+    void Shutdown();
+
+    IsoTpConfig config_;
+    UdsTiming timing_;
+    size_t max_block_ = kMaxTransfer;
+    int64_t progress_interval_us_ = 250000;
+    Napi::ThreadSafeFunction tsfn_;
+    bool closed_ = false;
+
+    std::mutex mutex_; // guards tsfn_progress_
+    Napi::ThreadSafeFunction tsfn_progress_;
+
+    // JS thread only.
+    uint64_t next_id_ = 1;
+    std::unordered_map<uint64_t, std::shared_ptr<Job>> jobs_;
+    std::unordered_map<uint64_t, Napi::Promise::Deferred> pending_;
+    uint64_t flashed_ = 0;
+    uint64_t failed_ = 0;
+};
+
+#endif // ACE_CAN_FLASHER_H
@@ -0,0 +1,116 @@
+#include "frame_dedup.h"
+
+#include <cstring>
+
+namespace {
+
+bool SameFrame(const CanFrame& a, const CanFrame& b) {
+    return a.id == b.id && a.length == b.length &&
+           (a.flags & (kFrameFlagExtended | kFrameFlagRemote | kFrameFlagFd)) ==
+               (b.flags & (kFrameFlagExtended | kFrameFlagRemote | kFrameFlagFd)) &&
+           std::memcmp(a.data, b.data, a.length) == 0;
+}
+
+int64_t Distance(int64_t a, int64_t b) {
+    return a > b ? a - b : b - a;
+}
+
+} // namespace
+
+FrameDeduplicator::FrameDeduplicator(int64_t windowUs, int64_t failoverUs)
+    : window_us_(windowUs), failover_us_(failoverUs), ring_(kRingSize), transmits_(kTransmitRingSize) {}
+
+void FrameDeduplicator::RecordTransmit(uint8_t source, const CanFrame& frame, int64_t atUs) {
+    uint64_t sequence = next_transmit_++;
+    Entry& entry = transmits_[sequence % kTransmitRingSize];
+    entry.sequence = sequence;
+    entry.at_us = atUs;
+    entry.source = source;
+    entry.matched = false;
+    entry.frame = frame;
+}
+
+FrameDeduplicator::Verdict FrameDeduplicator::Accept(uint8_t source, const CanFrame& frame, int64_t atUs) {
+    if (MatchDuplicate(source, frame, atUs)) {
+        duplicates_++;
+        return Verdict::Duplicate;
+    }
+    if (MatchTransmit(source, frame, atUs)) {
+        own_transmits_++;
+        return Verdict::OwnTransmit;
+    }
+
+    uint64_t sequence = next_sequence_++;
+    Entry& entry = ring_[sequence % kRingSize];
+    entry.sequence = sequence;
+    entry.at_us = atUs;
+    entry.source = source;
+    entry.matched = false;
+    entry.frame = frame;
+    delivered_++;
+    if (source != active_) {
+        unmatched_.push_back(sequence);
+    }
+    return Verdict::Deliver;
+}
+
+// Looks for the same frame from the other adapter within the window; marks it matched if found.
+bool FrameDeduplicator::MatchDuplicate(uint8_t source, const CanFrame& frame, int64_t atUs) {
+    // Entries are in arrival order, which can differ slightly from timestamp order between two
+    // adapters, so the scan runs a little past the window before giving up.
+    for (uint64_t back = 1; back <= kRingSize && back < next_sequence_; ++back) {
+        Entry& entry = ring_[(next_sequence_ - back) % kRingSize];
+        if (atUs - entry.at_us > 4 * window_us_) {
+            break;
+        }
+        if (entry.source == source || entry.matched) {
+            continue;
+        }
+        if (Distance(atUs, entry.at_us) <= window_us_ && SameFrame(entry.frame, frame)) {
+            entry.matched = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Looks for a recorded send on the other adapter. A send can sit in the TX shaper queue before it
+// reaches the wire, so it is looked for up to the failover timeout, oldest first.
+bool FrameDeduplicator::MatchTransmit(uint8_t source, const CanFrame& frame, int64_t atUs) {
+    uint64_t oldest = next_transmit_ > kTransmitRingSize ? next_transmit_ - kTransmitRingSize : 1;
+    for (uint64_t sequence = oldest; sequence < next_transmit_; ++sequence) {
+        Entry& entry = transmits_[sequence % kTransmitRingSize];
+        if (entry.source == source || entry.matched || Distance(atUs, entry.at_us) > failover_us_) {
+            continue;
+        }
+        if (SameFrame(entry.frame, frame)) {
+            entry.matched = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FrameDeduplicator::ActiveMissing(int64_t nowUs) {
+    while (!unmatched_.empty()) {
+        const Entry& entry = ring_[unmatched_.front() % kRingSize];
+        if (entry.sequence != unmatched_.front()) {
+            return true;
+        }
+        if (!entry.matched) {
+            return nowUs - entry.at_us > failover_us_;
+        }
+        unmatched_.pop_front();
+    }
+    return false;
+}
+
+bool FrameDeduplicator::SwitchTo(uint8_t source) {
+    if (active_ == source) {
+        return false;
+    }
+    active_ = source;
+    failovers_++;
+    unmatched_.clear();
+    return true;
+}
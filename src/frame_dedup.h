@@ -0,0 +1,72 @@
+#ifndef ACE_CAN_FRAME_DEDUP_H
+#define ACE_CAN_FRAME_DEDUP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "can_frame.h"
+
+// The de-duplication and failover bookkeeping of a RedundantBus, for two adapters (sources 0 and
+// 1) on the same physical bus. Frames are the same frame when their id, flags and payload match
+// within the dedup window. Not thread-safe; the owner serialises calls.
+//
+// Neither adapter receives what it transmits itself, so a frame the pair sends is seen only by
+// the other adapter. Sends are recorded with RecordTransmit() beforehand, and that copy is then
+// recognised as our own instead of being delivered, or counted as a frame the primary missed.
+class FrameDeduplicator {
+public:
+    enum class Verdict {
+        Deliver,
+        Duplicate, // the other adapter's copy was already delivered
+        OwnTransmit, // sent by the pair itself
+    };
+
+    FrameDeduplicator(int64_t windowUs, int64_t failoverUs);
+
+    void RecordTransmit(uint8_t source, const CanFrame& frame, int64_t atUs);
+    Verdict Accept(uint8_t source, const CanFrame& frame, int64_t atUs);
+    // True when a frame only the inactive adapter delivered has gone unmatched by the active one for
+    // longer than the failover timeout, at nowUs. Frames that dropped out of the ring unmatched count
+    // as missing too.
+    bool ActiveMissing(int64_t nowUs);
+    // Returns false if `source` is already active.
+    bool SwitchTo(uint8_t source);
+
+    uint8_t active() const { return active_; }
+    uint64_t delivered() const { return delivered_; }
+    uint64_t duplicates() const { return duplicates_; }
+    uint64_t own_transmits() const { return own_transmits_; }
+    uint64_t failovers() const { return failovers_; }
+
+private:
+    static constexpr size_t kRingSize = 1024;
+    static constexpr size_t kTransmitRingSize = 256;
+
+    struct Entry {
+        uint64_t sequence = 0; // 0 = empty slot
+        int64_t at_us = 0;
+        uint8_t source = 0;
+        bool matched = false;
+        CanFrame frame = {};
+    };
+
+    bool MatchDuplicate(uint8_t source, const CanFrame& frame, int64_t atUs);
+    bool MatchTransmit(uint8_t source, const CanFrame& frame, int64_t atUs);
+
+    int64_t window_us_;
+    int64_t failover_us_;
+    std::vector<Entry> ring_;
+    uint64_t next_sequence_ = 1;
+    std::deque<uint64_t> unmatched_; // deliveries only the inactive adapter made, oldest first
+    std::vector<Entry> transmits_; // recorded sends; matched = seen by the other adapter
+    uint64_t next_transmit_ = 1;
+    uint8_t active_ = 0;
+    uint64_t delivered_ = 0;
+    uint64_t duplicates_ = 0;
+    uint64_t own_transmits_ = 0;
+    uint64_t failovers_ = 0;
+};
+
+#endif // ACE_CAN_FRAME_DEDUP_H
@@ -0,0 +1,21 @@
+#ifndef ACE_CAN_FRAME_STAGE_H
+#define ACE_CAN_FRAME_STAGE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "can_frame.h"
+
+// Native processing step of a CANBus receive stream. Unlike a FrameTap, a stage works on whole
+// batches of the frames that passed the filters, right before they are handed to JS, and may
+// change them: rewrite or drop frames, append derived ones and annotate them. `annotations` holds
+// one entry per frame (0 = none) and must be kept in step with `frames`. Stages run on the receive
+// thread (the JS thread in poll receive mode), must not block and must not call back into the CANBus.
+class FrameStage {
+public:
+    virtual ~FrameStage() = default;
+
+    virtual void Process(std::vector<CanFrame>& frames, std::vector<uint32_t>& annotations) = 0;
+};
+
+#endif // ACE_CAN_FRAME_STAGE_H
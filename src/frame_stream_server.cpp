@@ -0,0 +1,448 @@
+#include "frame_stream_server.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "ace_can.h"
+#include "napi_options.h"
+
+namespace {
+
+constexpr size_t kMessageHeaderSize = 4;
+constexpr size_t kFrameHeaderSize = 16;
+
+void PutU16(uint8_t* out, uint16_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void PutU32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+bool ParseId(const std::string& text, uint32_t& out) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    unsigned long value = std::strtoul(text.c_str(), &end, 0);
+    if (*end != '\0' || value > 0x1FFFFFFF) {
+        return false;
+    }
+    out = static_cast<uint32_t>(value);
+    return true;
+}
+
+} // namespace
+
+Napi::Object FrameStreamServer::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "FrameStreamServer", {
+        InstanceMethod("port", &FrameStreamServer::Port),
+        InstanceMethod("stats", &FrameStreamServer::Stats),
+        InstanceMethod("close", &FrameStreamServer::Close),
+    });
+    exports.Set("FrameStreamServer", func);
+    return exports;
+}
+
+// new FrameStreamServer(bus, { port = 0, host = '127.0.0.1', maxQueuedBytes = 1 MiB, maxClients = 64 }?)
+FrameStreamServer::FrameStreamServer(const Napi::CallbackInfo& info) : Napi::ObjectWrap<FrameStreamServer>(info) {
+    Napi::Env env = info.Env();
+    bus_ = info.Length() > 0 ? CANBus::FromValue(env, info[0]) : nullptr;
+    if (bus_ == nullptr) {
+        Napi::TypeError::New(env, "bus must be a CANBus instance").ThrowAsJavaScriptException();
+        return;
+    }
+    std::string host = "127.0.0.1";
+    uint32_t port = 0;
+    uint32_t maxQueued = static_cast<uint32_t>(max_queued_);
+    if (info.Length() > 1 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (!GetOptionalString(options, "host", host) || !GetOptionalUint32(options, "port", port) ||
+            !GetOptionalUint32(options, "maxQueuedBytes", maxQueued) ||
+            !GetOptionalUint32(options, "maxClients", max_clients_)) {
+            Napi::TypeError::New(env, "Invalid stream server option type").ThrowAsJavaScriptException();
+            return;
+        }
+    }
+    if (port > 65535) {
+        Napi::RangeError::New(env, "port must be 0-65535").ThrowAsJavaScriptException();
+        return;
+    }
+    if (maxQueued < 4096 || max_clients_ == 0) {
+        Napi::RangeError::New(env, "maxQueuedBytes must be at least 4096 and maxClients positive").ThrowAsJavaScriptException();
+        return;
+    }
+    max_queued_ = maxQueued;
+
+    TunnelAddress bind;
+    std::string error = TunnelSocket::Resolve(host, static_cast<uint16_t>(port), bind);
+    if (error.empty()) {
+        error = listener_.Listen(bind);
+    }
+    if (error.empty()) {
+        error = TunnelSocket::Resolve("127.0.0.1", 0, waker_address_);
+    }
+    if (error.empty()) {
+        error = waker_.OpenUdp(waker_address_);
+    }
+    if (error.empty()) {
+        error = TunnelSocket::Resolve("127.0.0.1", waker_.LocalPort(), waker_address_);
+    }
+    if (!error.empty()) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return;
+    }
+
+    bus_ref_ = Napi::Persistent(info[0].As<Napi::Object>());
+    running_ = true;
+    thread_ = std::thread([this]() { Loop(); });
+    stage_ = std::make_shared<Stage>(this);
+    bus_->AddStage(stage_);
+}
+
+FrameStreamServer::~FrameStreamServer() {
+    Shutdown();
+}
+
+void FrameStreamServer::Shutdown() {
+    if (!running_) {
+        return;
+    }
+    // RemoveStage waits for a batch in progress, so nothing is published after this.
+    bus_->RemoveStage(stage_.get());
+    running_ = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Wake();
+    }
+    thread_.join();
+    std::lock_guard<std::mutex> lock(mutex_);
+    clients_.clear();
+    listener_.Close();
+    waker_.Close();
+}
+
+Napi::Value FrameStreamServer::Port(const Napi::CallbackInfo& info) {
+    return Napi::Number::New(info.Env(), listener_.Valid() ? listener_.LocalPort() : 0);
+}
+
+Napi::Value FrameStreamServer::Stats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object result = Napi::Object::New(env);
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t clients = 0;
+    size_t queued = 0;
+    for (const std::shared_ptr<Client>& client : clients_) {
+        if (client->open && !client->drop) {
+            clients++;
+            queued += client->queued_bytes;
+        }
+    }
+    result.Set("clients", Napi::Number::New(env, static_cast<double>(clients)));
+    result.Set("batches", Napi::Number::New(env, static_cast<double>(batches_)));
+    result.Set("frames", Napi::Number::New(env, static_cast<double>(frames_)));
+    result.Set("messages", Napi::Number::New(env, static_cast<double>(messages_)));
+    result.Set("bytes", Napi::Number::New(env, static_cast<double>(bytes_)));
+    result.Set("queuedBytes", Napi::Number::New(env, static_cast<double>(queued)));
+    result.Set("droppedClients", Napi::Number::New(env, static_cast<double>(dropped_clients_)));
+    result.Set("rejected", Napi::Number::New(env, static_cast<double>(rejected_)));
+    return result;
+}
+
+// Disconnects every client and stops listening; the CANBus stays open.
+Napi::Value FrameStreamServer::Close(const Napi::CallbackInfo& info) {
+    Shutdown();
+    bus_ref_.Reset();
+    return info.Env().Undefined();
+}
+
+// Runs on the receive thread, once per batch.
+void FrameStreamServer::Publish(const std::vector<CanFrame>& frames) {
+    if (frames.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    batches_++;
+    frames_ += frames.size();
+    // One message per distinct subscription, shared by every client that has it.
+    std::vector<std::pair<const std::vector<IdRange>*, std::shared_ptr<const std::vector<uint8_t>>>> built;
+    bool wake = false;
+    for (const std::shared_ptr<Client>& client : clients_) {
+        if (!client->open || client->drop) {
+            continue;
+        }
+        auto match = std::find_if(built.begin(), built.end(), [&client](const auto& entry) {
+            return *entry.first == client->subscription;
+        });
+        if (match == built.end()) {
+            built.emplace_back(&client->subscription, Serialize(frames, client->subscription));
+            match = built.end() - 1;
+        }
+        if (match->second) {
+            wake = Enqueue(*client, match->second) || wake;
+        }
+    }
+    if (wake) {
+        Wake();
+    }
+}
+
+// The batch as one binary WebSocket frame, or nullptr when no frame is subscribed.
+std::shared_ptr<const std::vector<uint8_t>> FrameStreamServer::Serialize(const std::vector<CanFrame>& frames,
+                                                                         const std::vector<IdRange>& subscription) {
+    auto subscribed = [&subscription](uint32_t id) {
+        if (subscription.empty()) {
+            return true;
+        }
+        auto next = std::upper_bound(subscription.begin(), subscription.end(), id,
+                                     [](uint32_t value, const IdRange& range) { return value < range.from; });
+        return next != subscription.begin() && (next - 1)->to >= id;
+    };
+    uint32_t count = 0;
+    size_t payload = kMessageHeaderSize;
+    for (const CanFrame& frame : frames) {
+        if (subscribed(frame.id)) {
+            count++;
+            payload += kFrameHeaderSize + frame.length;
+        }
+    }
+    if (count == 0) {
+        return nullptr;
+    }
+    auto message = std::make_shared<std::vector<uint8_t>>(kWebSocketMaxHeader + payload);
+    size_t header = WriteWebSocketHeader(message->data(), kWebSocketBinary, payload);
+    message->resize(header + payload);
+    uint8_t* out = message->data() + header;
+    PutU32(out, count);
+    out += kMessageHeaderSize;
+    for (const CanFrame& frame : frames) {
+        if (!subscribed(frame.id)) {
+            continue;
+        }
+        double timestamp = static_cast<double>(frame.timestamp);
+        std::memcpy(out, &timestamp, sizeof(timestamp)); // IEEE 754, little-endian on every supported target
+        PutU32(out + 8, frame.id);
+        out[12] = frame.flags;
+        out[13] = frame.length;
+        PutU16(out + 14, frame.channel);
+        std::memcpy(out + kFrameHeaderSize, frame.data, frame.length);
+        out += kFrameHeaderSize + frame.length;
+    }
+    return message;
+}
+
+// Queues a message and, if the client was idle, writes what the socket takes right away. Returns
+// whether the server thread needs to look at the client. mutex_ held.
+bool FrameStreamServer::Enqueue(Client& client, std::shared_ptr<const std::vector<uint8_t>> message) {
+    bool idle = client.out.empty();
+    client.queued_bytes += message->size();
+    client.out.push_back({std::move(message), 0});
+    if (idle && !Flush(client)) {
+        client.drop = true;
+        return true;
+    }
+    if (client.queued_bytes > max_queued_) {
+        client.drop = true;
+        dropped_clients_++;
+        return true;
+    }
+    return idle && !client.out.empty();
+}
+
+// Writes queued messages until the socket is full; false on a socket error. mutex_ held.
+bool FrameStreamServer::Flush(Client& client) {
+    while (!client.out.empty()) {
+        Pending& pending = client.out.front();
+        size_t remaining = pending.data->size() - pending.offset;
+        int sent = client.socket->Send(pending.data->data() + pending.offset, remaining);
+        if (sent < 0) {
+            return false;
+        }
+        if (sent == 0) {
+            break;
+        }
+        pending.offset += static_cast<size_t>(sent);
+        client.queued_bytes -= static_cast<size_t>(sent);
+        bytes_ += static_cast<size_t>(sent);
+        if (pending.offset == pending.data->size()) {
+            client.out.pop_front();
+            messages_++;
+        }
+    }
+    return true;
+}
+
+void FrameStreamServer::Wake() {
+    if (!wake_pending_) {
+        wake_pending_ = true;
+        uint8_t byte = 0;
+        waker_.SendTo(&byte, 1, waker_address_);
+    }
+}
+
+void FrameStreamServer::Loop() {
+    std::vector<std::shared_ptr<Client>> polled;
+    std::vector<TunnelSocket::PollItem> items;
+    uint8_t scratch[16];
+    while (running_) {
+        items.assign(2, TunnelSocket::PollItem());
+        items[0].socket = &waker_;
+        items[1].socket = &listener_;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            polled = clients_;
+            for (const std::shared_ptr<Client>& client : polled) {
+                TunnelSocket::PollItem item;
+                item.socket = client->socket.get();
+                item.want_write = !client->out.empty();
+                items.push_back(item);
+            }
+        }
+        if (!TunnelSocket::Poll(items, 200)) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (items[0].readable) {
+            TunnelAddress from;
+            while (waker_.ReceiveFrom(scratch, sizeof(scratch), from, 0) > 0) {
+            }
+            wake_pending_ = false;
+        }
+        if (items[1].readable) {
+            auto client = std::make_shared<Client>();
+            client->socket = std::make_unique<TunnelSocket>();
+            if (listener_.Accept(*client->socket)) {
+                if (clients_.size() >= max_clients_) {
+                    rejected_++;
+                } else {
+                    client->socket->SetNonBlocking();
+                    clients_.push_back(client);
+                }
+            }
+        }
+        for (size_t i = 0; i < polled.size(); ++i) {
+            Client& client = *polled[i];
+            if (!client.drop && items[i + 2].readable) {
+                Read(client);
+            }
+            if (!client.drop && items[i + 2].writable && !Flush(client)) {
+                client.drop = true;
+            }
+        }
+        clients_.erase(std::remove_if(clients_.begin(), clients_.end(),
+                                      [](const std::shared_ptr<Client>& client) { return client->drop; }),
+                       clients_.end());
+    }
+}
+
+// Reads the handshake or client frames. mutex_ held; the socket is non-blocking.
+void FrameStreamServer::Read(Client& client) {
+    uint8_t buffer[4096];
+    int received = client.socket->Receive(buffer, sizeof(buffer), -1);
+    if (received < 0) {
+        client.drop = true;
+        return;
+    }
+    if (client.open) {
+        client.reader.Append(buffer, static_cast<size_t>(received));
+        WebSocketReader::Message message;
+        int status = 0;
+        while (!client.drop && (status = client.reader.Next(message)) == 1) {
+            HandleMessage(client, message);
+        }
+        if (status < 0) {
+            client.drop = true;
+        }
+        return;
+    }
+
+    client.request.append(reinterpret_cast<const char*>(buffer), static_cast<size_t>(received));
+    size_t end = client.request.find("\r\n\r\n");
+    if (end == std::string::npos) {
+        client.drop = client.request.size() > kMaxRequest;
+        return;
+    }
+    std::string response;
+    std::string error = WebSocketHandshake(client.request.substr(0, end + 2), response);
+    if (!error.empty()) {
+        static const char kRefused[] = "HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n";
+        client.socket->Send(reinterpret_cast<const uint8_t*>(kRefused), sizeof(kRefused) - 1);
+        client.drop = true;
+        return;
+    }
+    client.open = true;
+    client.request.clear();
+    client.queued_bytes += response.size();
+    client.out.push_back({std::make_shared<const std::vector<uint8_t>>(response.begin(), response.end()), 0});
+    if (!Flush(client)) {
+        client.drop = true;
+    }
+}
+
+void FrameStreamServer::HandleMessage(Client& client, const WebSocketReader::Message& message) {
+    if (message.opcode == kWebSocketPing || message.opcode == kWebSocketClose) {
+        // A pong echoes the ping; a close is answered with a close and the connection ends.
+        uint8_t opcode = message.opcode == kWebSocketPing ? kWebSocketPong : kWebSocketClose;
+        auto reply = std::make_shared<std::vector<uint8_t>>(kWebSocketMaxHeader + message.payload.size());
+        size_t header = WriteWebSocketHeader(reply->data(), opcode, message.payload.size());
+        std::copy(message.payload.begin(), message.payload.end(), reply->begin() + static_cast<std::ptrdiff_t>(header));
+        reply->resize(header + message.payload.size());
+        client.queued_bytes += reply->size();
+        client.out.push_back({std::move(reply), 0});
+        if (!Flush(client) || opcode == kWebSocketClose) {
+            client.drop = true;
+        }
+        return;
+    }
+    if (message.opcode != kWebSocketText) {
+        return;
+    }
+    std::string text(message.payload.begin(), message.payload.end());
+    static const std::string kSubscribe = "subscribe ";
+    if (text.compare(0, kSubscribe.size(), kSubscribe) != 0) {
+        return;
+    }
+    // "subscribe *" or a list of IDs and ID ranges ("0x100-0x1FF,0x7E8"); an invalid list changes nothing.
+    std::vector<IdRange> ranges;
+    bool all = false;
+    size_t start = kSubscribe.size();
+    while (start <= text.size()) {
+        size_t comma = text.find(',', start);
+        std::string token = text.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        token.erase(std::remove(token.begin(), token.end(), ' '), token.end());
+        start = comma == std::string::npos ? text.size() + 1 : comma + 1;
+        if (token.empty()) {
+            continue;
+        }
+        if (token == "*") {
+            all = true;
+            continue;
+        }
+        IdRange range;
+        size_t dash = token.find('-');
+        if (!ParseId(token.substr(0, dash), range.from) ||
+            !ParseId(dash == std::string::npos ? token : token.substr(dash + 1), range.to) || range.to < range.from) {
+            return;
+        }
+        ranges.push_back(range);
+    }
+    if (all) {
+        ranges.clear();
+    } else if (ranges.empty()) {
+        return;
+    }
+    std::sort(ranges.begin(), ranges.end(), [](const IdRange& a, const IdRange& b) { return a.from < b.from; });
+    std::vector<IdRange> merged;
+    for (const IdRange& range : ranges) {
+        if (!merged.empty() && range.from <= merged.back().to + 1) {
+            merged.back().to = std::max(merged.back().to, range.to);
+        } else {
+            merged.push_back(range);
+        }
+    }
+    client.subscription.swap(merged);
+}
@@ -0,0 +1,110 @@
+#ifndef ACE_CAN_FRAME_STREAM_SERVER_H
+#define ACE_CAN_FRAME_STREAM_SERVER_H
+
+#include <napi.h>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_stage.h"
+#include "tunnel.h"
+#include "websocket.h"
+
+class CANBus;
+
+// Streams a CANBus's receive batches to WebSocket clients as binary messages. A FrameStage
+// serializes each batch once per distinct subscription and writes the shared message straight to
+// every client socket without blocking; whatever does not fit stays queued for the server thread,
+// which also accepts clients, answers the handshake and reads subscriptions. A client whose queue
+// grows past maxQueuedBytes is disconnected rather than allowed to hold the others back.
+//
+// Message (little-endian): 0 u32 frame count, then per frame
+//   0 f64 timestamp (microseconds)   8 u32 id   12 u8 flags   13 u8 length   14 u16 channel   16 data
+//
+// Clients choose frames with a text message: "subscribe 0x100-0x1FF,0x7E8" or "subscribe *" (the
+// default).
+class FrameStreamServer : public Napi::ObjectWrap<FrameStreamServer> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    FrameStreamServer(const Napi::CallbackInfo& info);
+    ~FrameStreamServer();
+
+    Napi::Value Port(const Napi::CallbackInfo& info);
+    Napi::Value Stats(const Napi::CallbackInfo& info);
+    Napi::Value Close(const Napi::CallbackInfo& info);
+
+private:
+    struct IdRange {
+        uint32_t from = 0;
+        uint32_t to = 0;
+        bool operator==(const IdRange& other) const { return from == other.from && to == other.to; }
+    };
+
+    struct Pending {
+        std::shared_ptr<const std::vector<uint8_t>> data;
+        size_t offset = 0;
+    };
+
+    struct Client {
+        std::unique_ptr<TunnelSocket> socket;
+        bool open = false; // handshake done
+        bool drop = false; // closed by the server thread on its next pass
+        std::string request;
+        WebSocketReader reader{kMaxClientMessage};
+        std::vector<IdRange> subscription; // sorted and merged; empty = every frame
+        std::deque<Pending> out;
+        size_t queued_bytes = 0;
+    };
+
+    class Stage : public FrameStage {
+    public:
+        explicit Stage(FrameStreamServer* owner) : owner_(owner) {}
+        void Process(std::vector<CanFrame>& frames, std::vector<uint32_t>&) override { owner_->Publish(frames); }
+
+    private:
+        FrameStreamServer* owner_;
+    };
+
+    static constexpr size_t kMaxClientMessage = 4096;
+    static constexpr size_t kMaxRequest = 8192;
+
+    void Publish(const std::vector<CanFrame>& frames);
+    static std::shared_ptr<const std::vector<uint8_t>> Serialize(const std::vector<CanFrame>& frames,
+                                                                 const std::vector<IdRange>& subscription);
+    bool Enqueue(Client& client, std::shared_ptr<const std::vector<uint8_t>> message);
+    bool Flush(Client& client);
+    void Loop();
+    void Read(Client& client);
+    void HandleMessage(Client& client, const WebSocketReader::Message& message);
+    void Wake();
+    void Shutdown();
+
+    CANBus* bus_ = nullptr;
+    Napi::ObjectReference bus_ref_;
+    size_t max_queued_ = 1 << 20;
+    uint32_t max_clients_ = 64;
+
+    std::shared_ptr<Stage> stage_;
+    TunnelSocket listener_;
+    TunnelSocket waker_; // loopback UDP; a datagram to itself interrupts the server's poll
+    TunnelAddress waker_address_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    std::mutex mutex_; // guards everything below and client state
+    std::vector<std::shared_ptr<Client>> clients_;
+    bool wake_pending_ = false;
+    uint64_t batches_ = 0;
+    uint64_t frames_ = 0;
+    uint64_t messages_ = 0;
+    uint64_t bytes_ = 0;
+    uint64_t dropped_clients_ = 0;
+    uint64_t rejected_ = 0;
+};
+
+#endif // ACE_CAN_FRAME_STREAM_SERVER_H
@@ -0,0 +1,26 @@
+#ifndef ACE_CAN_FRAME_TAP_H
+#define ACE_CAN_FRAME_TAP_H
+
+#include <cstdint>
+
+#include "can_frame.h"
+
+// Native observer of a CANBus receive stream. Taps run on the receive thread for every frame (the
+// JS thread in poll receive mode), before the frame is queued for JS, so they see it without any
+// thread hop. They must not block
+// and must not call back into the CANBus that invokes them.
+class FrameTap {
+public:
+    virtual ~FrameTap() = default;
+
+    // hostUs is the host monotonic time (HostMicros) at which the frame was read from the driver.
+    virtual void OnFrame(const CanFrame& frame, int64_t hostUs) = 0;
+
+    // Frames that passed the filters and stages, at hostUs: handed to the JS thread queue (receive
+    // thread), and about to reach the bus's 'message' listener (JS thread). Only frames that have a
+    // listener get this far; poll receive mode has no queue and only delivers.
+    virtual void OnQueued(const CanFrame&, int64_t) {}
+    virtual void OnDelivered(const CanFrame&, int64_t) {}
+};
+
+#endif // ACE_CAN_FRAME_TAP_H
@@ -0,0 +1,297 @@
+#include "id_scanner.h"
+
+#include <algorithm>
+
+#include "timed_tx.h"
+
+namespace {
+
+uint64_t FrameKey(uint32_t id, bool extended) {
+    return (extended ? (uint64_t{1} << 32) : 0) | id;
+}
+
+uint32_t KeyId(uint64_t key) {
+    return static_cast<uint32_t>(key);
+}
+
+bool KeyExtended(uint64_t key) {
+    return (key >> 32) != 0;
+}
+
+} // namespace
+
+IdScanner::IdScanner(SessionBus* bus, Config config)
+    : bus_(bus), config_(std::move(config)), tap_(std::make_shared<Tap>(this)) {}
+
+IdScanner::~IdScanner() {
+    Shutdown();
+}
+
+uint64_t IdScanner::ProbeCount(const std::vector<Range>& ranges) {
+    uint64_t probes = 0;
+    for (const Range& range : ranges) {
+        probes += (range.to - range.from) / range.step + 1;
+    }
+    return probes;
+}
+
+void IdScanner::Start(std::function<void()> finished) {
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        background_.clear();
+        in_flight_.clear();
+        candidates_.clear();
+        waiters_.clear();
+        found_.clear();
+        sent_ = 0;
+        responses_ = 0;
+        send_errors_ = 0;
+        unconfirmed_ = 0;
+        start_us_ = HostMicros();
+        end_us_ = 0;
+        phase_ = Phase::kListen;
+        running_ = true;
+    }
+    bus_->AddTap(tap_);
+    thread_ = std::thread([this, finished = std::move(finished)]() mutable { ScanLoop(std::move(finished)); });
+}
+
+void IdScanner::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+}
+
+void IdScanner::Shutdown() {
+    Stop();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    bus_->RemoveTap(tap_.get());
+}
+
+IdScanner::Stats IdScanner::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.phase = phase_;
+    stats.probes = sent_;
+    stats.responses = responses_;
+    stats.candidates = candidates_.size();
+    stats.found = found_.size();
+    stats.unconfirmed = unconfirmed_;
+    stats.send_errors = send_errors_;
+    stats.elapsed_us = start_us_ == 0 ? 0 : (end_us_ != 0 ? end_us_ : HostMicros()) - start_us_;
+    return stats;
+}
+
+std::vector<IdScanner::Pair> IdScanner::Pairs() const {
+    std::vector<Found> found;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        found = found_;
+    }
+    std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) {
+        return a.tx_key != b.tx_key ? a.tx_key < b.tx_key : a.rx_key < b.rx_key;
+    });
+    std::vector<Pair> pairs(found.size());
+    for (size_t i = 0; i < found.size(); ++i) {
+        pairs[i].tx_id = KeyId(found[i].tx_key);
+        pairs[i].rx_id = KeyId(found[i].rx_key);
+        pairs[i].extended = KeyExtended(found[i].tx_key);
+        pairs[i].rx_extended = KeyExtended(found[i].rx_key);
+        pairs[i].length = found[i].length;
+        std::copy(found[i].data, found[i].data + found[i].length, pairs[i].data);
+    }
+    return pairs;
+}
+
+void IdScanner::ScanLoop(std::function<void()> finished) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // IDs already on the bus are periodic traffic, not answers to our probes.
+    cv_.wait_for(lock, std::chrono::microseconds(config_.listen_us), [this]() { return !running_; });
+
+    phase_ = Phase::kSweep;
+    auto due = std::chrono::steady_clock::now();
+    for (const Range& range : config_.ranges) {
+        for (uint64_t id = range.from; id <= range.to && running_; id += range.step) {
+            uint64_t key = FrameKey(static_cast<uint32_t>(id), range.extended);
+            if (background_.count(key) == 0) {
+                SendProbe(lock, key, due);
+            }
+        }
+    }
+    cv_.wait_for(lock, std::chrono::microseconds(config_.window_us), [this]() { return !running_; });
+
+    phase_ = Phase::kVerify;
+    in_flight_.clear();
+    Verify(lock, due);
+    phase_ = Phase::kIdle;
+    running_ = false;
+    end_us_ = HostMicros();
+    lock.unlock();
+
+    bus_->RemoveTap(tap_.get());
+    if (finished) {
+        finished();
+    }
+}
+
+// Waits for the probe's slot in the probe interval, then sends it with the lock released.
+// Sweep probes are recorded in flight first so that an immediate answer can be attributed.
+bool IdScanner::SendProbe(std::unique_lock<std::mutex>& lock, uint64_t key,
+                          std::chrono::steady_clock::time_point& due) {
+    cv_.wait_until(lock, due, [this]() { return !running_; });
+    if (!running_) {
+        return false;
+    }
+    // Counted from the actual send when it is late, so a delayed probe is never followed by a burst.
+    due = std::max(due, std::chrono::steady_clock::now()) + std::chrono::nanoseconds(config_.interval_ns);
+    const std::vector<uint8_t>& probe = config_.probe;
+    CanFrame frame = {};
+    frame.id = KeyId(key);
+    frame.flags = KeyExtended(key) ? kFrameFlagExtended : 0;
+    frame.length = 8;
+    frame.data[0] = static_cast<uint8_t>(probe.size()); // ISO-TP single frame
+    std::copy(probe.begin(), probe.end(), frame.data + 1);
+    std::fill(frame.data + 1 + probe.size(), frame.data + 8, config_.padding);
+    if (phase_ == Phase::kSweep) {
+        int64_t nowUs = HostMicros();
+        while (!in_flight_.empty() && in_flight_.front().sent_us < nowUs - config_.window_us) {
+            in_flight_.pop_front();
+        }
+        in_flight_.push_back({key, nowUs});
+    }
+    lock.unlock();
+    std::string error = bus_->Transmit(frame);
+    lock.lock();
+    sent_++;
+    if (!error.empty()) {
+        send_errors_++;
+    }
+    return true;
+}
+
+// Confirms every response ID heard during the sweep. Each has at most one probe in flight, so
+// the response that arrives on it within the window belongs to that probe; different response
+// IDs are confirmed in parallel.
+void IdScanner::Verify(std::unique_lock<std::mutex>& lock, std::chrono::steady_clock::time_point& due) {
+    std::vector<Verification> verifications;
+    for (auto& entry : candidates_) {
+        Verification verification;
+        verification.rx_key = entry.first;
+        verification.candidates = entry.second;
+        verifications.push_back(std::move(verification));
+    }
+    std::sort(verifications.begin(), verifications.end(),
+              [](const Verification& a, const Verification& b) { return a.rx_key < b.rx_key; });
+
+    size_t remaining = verifications.size();
+    while (running_ && remaining > 0) {
+        int64_t nextDeadlineUs = 0;
+        for (Verification& verification : verifications) {
+            if (verification.done) {
+                continue;
+            }
+            if (verification.deadline_us != 0) {
+                auto waiter = waiters_.find(verification.rx_key);
+                if (waiter == waiters_.end()) {
+                    verification.done = true; // confirmed by OnFrame
+                    remaining--;
+                    continue;
+                }
+                if (HostMicros() < verification.deadline_us) {
+                    nextDeadlineUs = nextDeadlineUs == 0 ? verification.deadline_us
+                                                         : std::min(nextDeadlineUs, verification.deadline_us);
+                    continue;
+                }
+                waiters_.erase(waiter);
+                verification.deadline_us = 0;
+            }
+            if (verification.next == verification.candidates.size()) {
+                verification.done = true;
+                remaining--;
+                unconfirmed_++;
+                continue;
+            }
+            uint64_t txKey = verification.candidates[verification.next++];
+            waiters_[verification.rx_key] = txKey;
+            if (!SendProbe(lock, txKey, due)) {
+                break;
+            }
+            verification.deadline_us = HostMicros() + config_.window_us;
+            nextDeadlineUs = nextDeadlineUs == 0 ? verification.deadline_us
+                                                 : std::min(nextDeadlineUs, verification.deadline_us);
+        }
+        if (remaining > 0 && nextDeadlineUs != 0) {
+            int64_t waitUs = std::max<int64_t>(nextDeadlineUs - HostMicros(), 0);
+            cv_.wait_for(lock, std::chrono::microseconds(waitUs), [this]() { return !running_; });
+        }
+    }
+    waiters_.clear();
+}
+
+// ISO-TP single frame or first frame answering the probe's service, positively or negatively.
+bool IdScanner::IsResponse(const CanFrame& frame) const {
+    if (frame.length < 2) {
+        return false;
+    }
+    uint8_t service = config_.probe[0];
+    uint8_t type = frame.data[0] >> 4;
+    if (type == 0) {
+        uint8_t size = frame.data[0] & 0x0F;
+        if (size == 0 || size + 1u > frame.length) {
+            return false;
+        }
+        return frame.data[1] == static_cast<uint8_t>(service + 0x40) ||
+               (size >= 3 && frame.data[1] == 0x7F && frame.data[2] == service);
+    }
+    return type == 1 && frame.length == 8 && frame.data[2] == static_cast<uint8_t>(service + 0x40);
+}
+
+// Runs on the receive thread.
+void IdScanner::OnFrame(const CanFrame& frame, int64_t hostUs) {
+    uint64_t key = FrameKey(frame.id, (frame.flags & kFrameFlagExtended) != 0);
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (phase_ == Phase::kListen) {
+            background_.insert(key);
+            return;
+        }
+        if (!running_ || !IsResponse(frame) || background_.count(key) != 0) {
+            return;
+        }
+        responses_++;
+        if (phase_ == Phase::kSweep) {
+            std::vector<uint64_t>& list = candidates_[key];
+            for (auto it = in_flight_.rbegin(); it != in_flight_.rend() && list.size() < kMaxCandidates; ++it) {
+                if (it->sent_us > hostUs || it->sent_us < hostUs - config_.window_us) {
+                    continue;
+                }
+                if (std::find(list.begin(), list.end(), it->key) == list.end()) {
+                    list.push_back(it->key);
+                }
+            }
+        } else if (phase_ == Phase::kVerify) {
+            auto waiter = waiters_.find(key);
+            if (waiter != waiters_.end()) {
+                Found pair;
+                pair.tx_key = waiter->second;
+                pair.rx_key = key;
+                pair.length = std::min<uint8_t>(frame.length, 8);
+                std::copy(frame.data, frame.data + pair.length, pair.data);
+                found_.push_back(pair);
+                waiters_.erase(waiter);
+                notify = true;
+            }
+        }
+    }
+    if (notify) {
+        cv_.notify_all();
+    }
+}
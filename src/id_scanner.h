@@ -0,0 +1,147 @@
+#ifndef ACE_CAN_ID_SCANNER_H
+#define ACE_CAN_ID_SCANNER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "session_bus.h"
+
+// Finds the diagnostic request/response ID pairs on an unknown bus. A single-frame UDS probe
+// (TesterPresent by default) is sent on every request ID in the configured ranges, one per probe
+// interval, without waiting for answers. The receive tap attributes each response to the probes
+// sent within the response window before it. Every response ID found this way is then confirmed by
+// re-probing its candidate request IDs, newest first, with one probe in flight per response ID,
+// tracked in a waiter table keyed by that ID.
+class IdScanner {
+public:
+    struct Range {
+        uint32_t from = 0;
+        uint32_t to = 0x7FF;
+        uint32_t step = 1;
+        bool extended = false;
+    };
+
+    struct Config {
+        std::vector<Range> ranges;
+        std::vector<uint8_t> probe = {0x3E, 0x00};
+        uint8_t padding = 0xCC;
+        int64_t window_us = 50000;
+        int64_t listen_us = 200000;
+        int64_t interval_ns = 0; // between probes
+    };
+
+    // A confirmed pair, with the response that confirmed it.
+    struct Pair {
+        uint32_t tx_id = 0;
+        uint32_t rx_id = 0;
+        bool extended = false;
+        bool rx_extended = false;
+        uint8_t length = 0;
+        uint8_t data[8] = {};
+    };
+
+    enum class Phase { kIdle, kListen, kSweep, kVerify };
+
+    struct Stats {
+        Phase phase = Phase::kIdle;
+        uint64_t probes = 0;
+        uint64_t responses = 0;
+        uint64_t candidates = 0; // response IDs heard during the sweep
+        uint64_t found = 0;
+        uint64_t unconfirmed = 0;
+        uint64_t send_errors = 0;
+        int64_t elapsed_us = 0;
+    };
+
+    static constexpr uint64_t kMaxProbes = uint64_t{1} << 20;
+    static constexpr size_t kMaxCandidates = 64; // request IDs remembered per response ID
+
+    IdScanner(SessionBus* bus, Config config);
+    ~IdScanner();
+    IdScanner(const IdScanner&) = delete;
+    IdScanner& operator=(const IdScanner&) = delete;
+
+    // Number of probes a sweep of `ranges` sends at most.
+    static uint64_t ProbeCount(const std::vector<Range>& ranges);
+
+    // Attaches to the bus and starts a scan on a thread of its own, after the previous one has
+    // ended. `finished` runs on that thread once the scan has detached. Call from the JS thread.
+    void Start(std::function<void()> finished);
+    // Ends the scan early, keeping the pairs confirmed so far. Thread-safe.
+    void Stop();
+    // Stops the scan and waits for its thread. Call from the JS thread.
+    void Shutdown();
+
+    Stats GetStats() const;
+    // The confirmed pairs, sorted by request ID and then response ID.
+    std::vector<Pair> Pairs() const;
+
+private:
+    struct Probe {
+        uint64_t key; // extended flag in bit 32
+        int64_t sent_us;
+    };
+
+    // Confirmation of one response ID: its candidate request IDs, newest first.
+    struct Verification {
+        uint64_t rx_key = 0;
+        std::vector<uint64_t> candidates;
+        size_t next = 0;
+        int64_t deadline_us = 0; // of the probe in flight, 0 when none
+        bool done = false;
+    };
+
+    struct Found {
+        uint64_t tx_key = 0;
+        uint64_t rx_key = 0;
+        uint8_t length = 0;
+        uint8_t data[8] = {};
+    };
+
+    class Tap : public FrameTap {
+    public:
+        explicit Tap(IdScanner* scanner) : scanner_(scanner) {}
+        void OnFrame(const CanFrame& frame, int64_t hostUs) override { scanner_->OnFrame(frame, hostUs); }
+
+    private:
+        IdScanner* scanner_;
+    };
+
+    void OnFrame(const CanFrame& frame, int64_t hostUs);
+    bool IsResponse(const CanFrame& frame) const;
+    void ScanLoop(std::function<void()> finished);
+    bool SendProbe(std::unique_lock<std::mutex>& lock, uint64_t key, std::chrono::steady_clock::time_point& due);
+    void Verify(std::unique_lock<std::mutex>& lock, std::chrono::steady_clock::time_point& due);
+
+    SessionBus* bus_;
+    Config config_;
+    std::shared_ptr<Tap> tap_;
+    std::thread thread_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_ = false;
+    Phase phase_ = Phase::kIdle;
+    std::unordered_set<uint64_t> background_; // IDs heard before the sweep; never responses
+    std::deque<Probe> in_flight_; // sweep probes still inside the response window
+    std::unordered_map<uint64_t, std::vector<uint64_t>> candidates_; // response ID -> request IDs
+    std::unordered_map<uint64_t, uint64_t> waiters_; // response ID -> request ID being confirmed
+    std::vector<Found> found_;
+    uint64_t sent_ = 0;
+    uint64_t responses_ = 0;
+    uint64_t send_errors_ = 0;
+    uint64_t unconfirmed_ = 0;
+    int64_t start_us_ = 0;
+    int64_t end_us_ = 0; // 0 while running
+};
+
+#endif // ACE_CAN_ID_SCANNER_H
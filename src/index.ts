@@ -2,11 +2,64 @@ import path from 'path';
 
 const loadNativeBinding: (dir?: string) => NativeModule = require('node-gyp-build');
 
-export type Bustype = 'busmust' | 'pcan';
+export type Bustype = 'busmust' | 'pcan' | 'udp' | 'tcp';
 
 export interface CANMessage {
   id: number;
   data: Buffer;
+  /** Receive timestamp in microseconds (device clock). Set on received messages only. */
+  timestamp?: number;
+  /** Set by a receive plugin that annotated the frame (non-zero values only). */
+  annotation?: number;
+}
+
+/** Size in bytes of one record in a frame batch buffer. */
+export const FRAME_RECORD_SIZE = 80;
+
+export const FrameFlags = {
+  EXTENDED: 0x01,
+  REMOTE: 0x02,
+  FD: 0x04,
+  BRS: 0x08,
+  ESI: 0x10,
+  TX: 0x20,
+  ERROR: 0x40,
+} as const;
+
+export interface CANFrame {
+  id: number;
+  data: Buffer;
+  timestamp: number;
+  flags: number;
+  channel: number;
+}
+
+export type LogFormat = 'asc' | 'log' | 'pcap' | 'trc';
+
+export interface LoggingTrigger {
+  id: number;
+  mask?: number;
+  extended?: boolean;
+  channels?: number;
+}
+
+export interface LoggingOptions {
+  mode?: 'disabled' | 'always' | 'triggered';
+  /** PCAN buses only write 'trc'. */
+  format?: 'bbd' | 'pcap' | 'log' | 'asc' | 'blf' | 'trc';
+  direction?: 'none' | 'rx' | 'tx' | 'all';
+  pathMode?: 'fixed' | 'index' | 'time';
+  path?: string;
+  channels?: number;
+  maxFiles?: number;
+  maxBytesPerFile?: number;
+  maxSecondsPerFile?: number;
+  createNewFileOnStart?: boolean;
+  overwriteOldFileOnFull?: boolean;
+  startTrigger?: LoggingTrigger;
+  stopTrigger?: LoggingTrigger;
+  /** Save the configuration to the device so logging continues without a host. */
+  persist?: boolean;
 }
 
 export interface CANError {
@@ -14,16 +67,804 @@ export interface CANError {
   message: string;
 }
 
+export interface WatcherOptions {
+  /** How often the device is probed, in milliseconds. Defaults to 100. */
+  intervalMs?: number;
+  /** Re-open the channel on the same physical device when it comes back. Defaults to true. */
+  autoReattach?: boolean;
+}
+
+export interface TxClassLimit {
+  /** Ids match when (id & mask) === (classId & mask). */
+  id: number;
+  mask?: number;
+  bitsPerSecond: number;
+  burstBits?: number;
+}
+
+export interface TxShapingOptions {
+  /** Bus-wide budget as a fraction of the bitrate, e.g. 0.6 for 60 % bus load. */
+  busLoad?: number;
+  /** Bus-wide budget in bits per second (the lower of the two wins when both are given). */
+  bitsPerSecond?: number;
+  /** Bucket depth in bits; defaults to 10 ms of budget. */
+  burstBits?: number;
+  classes?: TxClassLimit[];
+}
+
+export type ClockDomain = 'device' | 'host';
+
+export interface ReceiveFilter {
+  id: number;
+  /** Bits of id that must match. Defaults to 0x1FFFFFFF (exact match). */
+  mask?: number;
+  /** Restrict to standard (false) or extended (true) frames; either when omitted. */
+  extended?: boolean;
+}
+
+/** 'thread' (default) receives on a native thread; 'poll' reads on the JS thread from the event loop. */
+export type ReceiveMode = 'thread' | 'poll';
+
+export interface SendAtOptions {
+  /** Clock the timestamp refers to; 'device' (default) is the clock of received message timestamps. */
+  clock?: ClockDomain;
+}
+
+export interface TimedSendResult {
+  /** Requested transmit time, in microseconds on the requested clock. */
+  scheduled: number;
+  /** Time the frame was handed to the adapter, on the same clock. */
+  achieved: number;
+  lateUs: number;
+}
+
+export interface LatencyProbeOptions {
+  /** Id of the request frames; bytes 0-3 of the payload carry a little-endian sequence number. */
+  requestId: number;
+  /** Id of the frames answering a request (defaults to requestId); the sequence must be echoed. */
+  responseId?: number;
+  rateHz?: number;
+  count?: number;
+  /** How long to wait for outstanding responses after the last request. */
+  timeoutMs?: number;
+  payloadLength?: number;
+}
+
+export interface LatencyStats {
+  count: number;
+  min: number;
+  mean: number;
+  p50: number;
+  p90: number;
+  p99: number;
+  p999: number;
+  max: number;
+}
+
+export interface LatencyReport {
+  sent: number;
+  received: number;
+  lost: number;
+  errors: number;
+  lastError?: string;
+  /** All values in microseconds. tx and driver need the receiving device clock (see sendAt). */
+  components: {
+    tx: LatencyStats;
+    driver: LatencyStats;
+    addon: LatencyStats;
+    js: LatencyStats;
+    total: LatencyStats;
+  };
+}
+
+export interface RedundantBusOptions {
+  /** Frames with the same id and payload this close together are one frame. Defaults to 2000. */
+  dedupWindowUs?: number;
+  /** Fail over once a frame seen only by the inactive adapter stays unmatched this long. Defaults to 10. */
+  failoverMs?: number;
+}
+
+export interface FailoverEvent {
+  active: 'primary' | 'secondary';
+  reason: string;
+}
+
+export interface RedundantBusStats {
+  delivered: number;
+  duplicates: number;
+  /** Frames the pair sent itself, as received by the other adapter; not delivered. */
+  ownTransmits: number;
+  failovers: number;
+  dropped: number;
+  active: 'primary' | 'secondary';
+}
+
+export interface IsoTpOptions {
+  /** Block size announced when receiving; 0 (default) = no further flow control. */
+  blockSize?: number;
+  /** STmin announced when receiving, in the raw ISO-TP encoding. Defaults to 0. */
+  stMin?: number;
+  /** Byte used to pad frames to 8 bytes. Defaults to 0xCC. */
+  padding?: number;
+  /** N_Bs / N_Cr timeout and default response timeout. Defaults to 1000. */
+  timeoutMs?: number;
+}
+
+export interface IsoTpRequestOptions {
+  /** Time to wait for the first frame of the response. */
+  timeoutMs?: number;
+}
+
+export interface IsoTpStats {
+  /** Sessions running on the native scheduler. */
+  active: number;
+  pending: number;
+  completed: number;
+  failed: number;
+}
+
+export interface UdsTimingOptions {
+  /** Time from request to response. Defaults to 50. */
+  p2Ms?: number;
+  /** Time allowed after each "response pending" (NRC 0x78). Defaults to 5000. */
+  p2StarMs?: number;
+}
+
+export interface DiagnosticRunnerOptions extends IsoTpOptions, UdsTimingOptions {
+  /** ECUs served at once; 0 (default) = all of them. */
+  concurrency?: number;
+}
+
+export interface DiagnosticEcu extends UdsTimingOptions {
+  name?: string;
+  txId: number;
+  rxId: number;
+  /** Requests for this ECU instead of the ones passed to run(). */
+  requests?: Buffer[];
+}
+
+export interface DiagnosticRunOptions {
+  /** Skip an ECU's remaining requests after a transport error or timeout. Defaults to true. */
+  stopOnError?: boolean;
+  concurrency?: number;
+}
+
+export interface DiagnosticResponse {
+  /** The response, negative responses included; absent on error or for suppressed responses. */
+  data?: Buffer;
+  /** Negative response code. */
+  nrc?: number;
+  /** Transport error or timeout. */
+  error?: string;
+  /** "Response pending" answers received before the final response. */
+  pending?: number;
+  elapsedMs: number;
+}
+
+export interface DiagnosticEcuResult {
+  name?: string;
+  txId: number;
+  rxId: number;
+  /** Every request got a response, positive or negative. */
+  ok: boolean;
+  /** One per request sent, in order. */
+  responses: DiagnosticResponse[];
+  elapsedMs: number;
+}
+
+export interface DiagnosticRunnerStats {
+  /** Sessions running on the native scheduler. */
+  active: number;
+  pending: number;
+  runs: number;
+  requests: number;
+  negative: number;
+  errors: number;
+}
+
+export interface FlasherOptions extends IsoTpOptions, UdsTimingOptions {
+  /** Upper bound on TransferData request length, SID and counter included (3 to 4095). Defaults to 4095. */
+  maxBlockLength?: number;
+  /** Minimum time between 'progress' events. Defaults to 250. */
+  progressIntervalMs?: number;
+}
+
+export interface FlashTarget {
+  name?: string;
+  bus: CANBus;
+  txId: number;
+  rxId: number;
+  /** Path of the image file; each path is memory-mapped once per flash() call. */
+  image: string;
+  /** memoryAddress sent in RequestDownload. Defaults to 0. */
+  address?: number;
+  /** First byte of the image to send. Defaults to 0. */
+  offset?: number;
+  /** Bytes to send. Defaults to the rest of the image. */
+  length?: number;
+  /** RequestDownload dataFormatIdentifier. Defaults to 0 (uncompressed, unencrypted). */
+  dataFormat?: number;
+  /** UDS requests sent before the download, e.g. session control and security access. */
+  prepare?: Buffer[];
+  /** UDS requests sent after RequestTransferExit, e.g. a check routine and ECU reset. */
+  finish?: Buffer[];
+}
+
+export interface FlashProgress {
+  bytes: number;
+  totalBytes: number;
+  targets: number;
+  /** Targets finished, failed ones included. */
+  done: number;
+  failed: number;
+}
+
+export interface FlashResult {
+  name?: string;
+  txId: number;
+  rxId: number;
+  ok: boolean;
+  error?: string;
+  /** 'prepare' | 'requestDownload' | 'transferData' | 'requestTransferExit' | 'finish' */
+  step?: string;
+  /** Image bytes acknowledged by the ECU. */
+  bytes: number;
+  elapsedMs: number;
+}
+
+export interface FlasherStats {
+  pending: number;
+  flashed: number;
+  failed: number;
+}
+
+export interface ScanRange {
+  from: number;
+  to: number;
+  /** Probe every step-th ID, e.g. 0x100 to vary the target byte of 0x18DAxxF1. Defaults to 1. */
+  step?: number;
+  /** Defaults to true when `to` exceeds 0x7FF. */
+  extended?: boolean;
+}
+
+export interface DiagnosticScannerOptions {
+  /** Request IDs to probe. Defaults to every 11-bit ID. */
+  ranges?: ScanRange[];
+  /** UDS request sent as an ISO-TP single frame, 1 to 7 bytes. Defaults to TesterPresent (3E 00). */
+  probe?: Buffer;
+  padding?: number;
+  /** Share of the bitrate used by probes, in (0, 1]. Defaults to 0.3. */
+  busLoad?: number;
+  /** Fixed time between probes, overriding busLoad. Required on buses without a bitrate, such as tunnels. */
+  intervalMs?: number;
+  /** Time after a probe in which a response is attributed to it. Defaults to 50. */
+  responseWindowMs?: number;
+  /** Time spent recording existing traffic before probing; those IDs are never taken as responses. Defaults to 200. */
+  listenMs?: number;
+}
+
+export interface DiagnosticIdPair {
+  txId: number;
+  rxId: number;
+  extended: boolean;
+  rxExtended: boolean;
+  /** The frame that confirmed the pair. */
+  response: Buffer;
+}
+
+export interface DiagnosticScanResult {
+  pairs: DiagnosticIdPair[];
+  probes: number;
+  responses: number;
+  /** Response IDs heard during the sweep that no single probe reproduced. */
+  unconfirmed: number;
+  sendErrors: number;
+  elapsedMs: number;
+}
+
+export interface DiagnosticScannerStats {
+  phase: 'idle' | 'listen' | 'sweep' | 'verify';
+  probes: number;
+  responses: number;
+  candidates: number;
+  found: number;
+  unconfirmed: number;
+  sendErrors: number;
+}
+
+/** Receiving end of a tunnel (bustype 'udp' / 'tcp'); the CANBus channel is the tunnel channel, 0-255. */
+export interface TunnelBusOptions {
+  port: number;
+  /** Local address to listen on. Defaults to '0.0.0.0'. */
+  host?: string;
+}
+
+export interface TunnelStats {
+  packets: number;
+  frames: number;
+  /** Packets missing from the sender's sequence; one that arrives late no longer counts. */
+  lost: number;
+  /** Packets that arrived after a newer one and were discarded. */
+  late: number;
+  /** Frames discarded because the bus was not reading them. */
+  dropped: number;
+  /** Frames sent back to the tunnel peer. */
+  sent: number;
+  /** Whether a peer has sent on this channel and, over TCP, is still connected. */
+  connected: boolean;
+}
+
+export interface CanTunnelOptions {
+  host: string;
+  port: number;
+  /** Defaults to 'udp'. */
+  protocol?: 'udp' | 'tcp';
+  /** Tunnel channel, 0-255; one remote CANBus per channel. Defaults to 0. */
+  channel?: number;
+  /** Longest a frame waits for others to share its packet, in microseconds. 0 sends every frame at once. Defaults to 1000. */
+  batchUs?: number;
+  /** Packet size limit, 128-65507. Defaults to 1400 to stay under a typical MTU. */
+  maxPacketBytes?: number;
+}
+
+export interface CanTunnelStats {
+  framesSent: number;
+  packetsSent: number;
+  bytesSent: number;
+  /** Frames in packets that could not be sent (queue full or TCP down). */
+  dropped: number;
+  sendErrors: number;
+  packetsReceived: number;
+  framesReceived: number;
+  /** Packets missing from the peer's sequence. */
+  lost: number;
+  late: number;
+  /** Frames from the peer that the bus failed to transmit. */
+  transmitErrors: number;
+  connected: boolean;
+}
+
+export interface FrameStreamServerOptions {
+  /** 0 picks a free port; see port(). Defaults to 0. */
+  port?: number;
+  /** Defaults to '127.0.0.1'. */
+  host?: string;
+  /** A client with more unsent bytes than this is disconnected. Defaults to 1 MiB. */
+  maxQueuedBytes?: number;
+  /** Further connections are closed right away. Defaults to 64. */
+  maxClients?: number;
+}
+
+export interface FrameStreamServerStats {
+  clients: number;
+  batches: number;
+  frames: number;
+  /** WebSocket messages fully written, over all clients. */
+  messages: number;
+  bytes: number;
+  queuedBytes: number;
+  /** Clients disconnected for falling behind. */
+  droppedClients: number;
+  /** Connections refused because maxClients were connected. */
+  rejected: number;
+}
+
+export interface DoipRoute extends IsoTpOptions, UdsTimingOptions {
+  /** DoIP logical address testers send to. */
+  address: number;
+  bus: CANBus;
+  txId: number;
+  rxId: number;
+}
+
+export interface DoipGatewayOptions extends IsoTpOptions, UdsTimingOptions {
+  /** 0 picks a free port; see port(). Defaults to 13400. */
+  port?: number;
+  /** Defaults to '0.0.0.0'. */
+  host?: string;
+  /** The gateway's own logical address. Defaults to 0x1000. */
+  logicalAddress?: number;
+  /** Further connections are closed right away. Defaults to 8. */
+  maxTesters?: number;
+  /** Tester addresses allowed to activate routing. Defaults to any in 0x0E00-0x0FFF. */
+  testers?: number[];
+}
+
+export interface DoipGatewayStats {
+  /** Connected sockets. */
+  testers: number;
+  /** Sockets with routing activated. */
+  activeTesters: number;
+  activations: number;
+  /** Diagnostic messages accepted for routing. */
+  requests: number;
+  /** Requests waiting behind another request to the same ECU. */
+  queued: number;
+  /** ECU responses relayed, response-pending ones included. */
+  responses: number;
+  /** Requests that got no final response, transport errors included. */
+  unanswered: number;
+  /** Diagnostic messages refused with a negative acknowledge. */
+  nacks: number;
+  transportErrors: number;
+  /** Connections refused because maxTesters were connected. */
+  rejected: number;
+}
+
+export interface SignalHistoryOptions {
+  /** "Message.Signal" names to record (default: every signal of the decoder). */
+  signals?: string[];
+  /** History kept per signal (default 600000, ten minutes). */
+  durationMs?: number;
+  /** Upper bound on the samples kept per signal (default 1048576). */
+  maxSamples?: number;
+}
+
+export interface SignalHistoryQuery {
+  /** Timestamps in microseconds, as on received frames. Defaults to the last durationMs. */
+  from?: number;
+  /** Defaults to the latest sample. */
+  to?: number;
+  /** Upper bound on the returned samples (default 1000, at least 3). */
+  points?: number;
+  /** 'lttb' (default) keeps the visual shape; 'minmax' keeps each time bucket's extremes. */
+  method?: 'lttb' | 'minmax';
+}
+
+export interface SignalSeries {
+  timestamps: Float64Array;
+  values: Float64Array;
+}
+
+export interface SignalHistoryStats {
+  signals: number;
+  /** Samples held, over all signals. */
+  samples: number;
+  /** Samples recorded since creation. */
+  appended: number;
+  /** Memory held by sample blocks. */
+  bytes: number;
+}
+
+/** Wire format of BatchEncoder output. */
+export type PackFormat = 'msgpack' | 'cbor';
+
+export type DatabaseFormat = 'dbc' | 'arxml';
+
+export interface SignalDefinition {
+  name: string;
+  /** DBC bit numbering whatever the source: the LSB for 'little', the MSB for 'big' (Motorola). */
+  startBit: number;
+  length: number;
+  byteOrder: 'little' | 'big';
+  signed: boolean;
+  /** Set for IEEE 754 signals. */
+  float?: 32 | 64;
+  multiplexor?: boolean;
+  /** Multiplexor value this signal is present under. */
+  multiplexValue?: number;
+  factor: number;
+  offset: number;
+  min: number;
+  max: number;
+  unit: string;
+}
+
+/** AUTOSAR E2E protection; offsets are in bits. */
+export interface E2EProtection {
+  profile: string;
+  dataId: number;
+  dataLength: number;
+  crcOffset: number;
+  counterOffset: number;
+}
+
+/** AUTOSAR SecOC: the authentic PDU (payloadLength bytes) is followed by the freshness value and MAC. */
+export interface SecOcProps {
+  dataId: number;
+  payloadLength: number;
+  freshnessBits: number;
+  macBits: number;
+  algorithm: string;
+}
+
+export interface MessageDefinition {
+  name: string;
+  id: number;
+  extended: boolean;
+  fd: boolean;
+  length: number;
+  signals: SignalDefinition[];
+  e2e?: E2EProtection;
+  secOc?: SecOcProps;
+}
+
+export interface SignalDatabaseOptions {
+  /**
+   * Compiled cache file. Loaded (memory-mapped) instead of parsing the source when it was built from
+   * a source file with the same content hash; written after parsing otherwise.
+   */
+  cache?: string;
+}
+
+export interface DecodedMessage {
+  name: string;
+  /** Physical values by signal name. */
+  signals: Record<string, number>;
+}
+
+export interface SignalDecoderStats {
+  /** 'tables' for a SignalDatabase source, 'plugin' for a compiled decoder. */
+  backend: 'tables' | 'plugin';
+  /** Received frames decoded on the receive thread. */
+  decoded: number;
+  /** Received frames whose ID is not in the database. */
+  unknown: number;
+}
+
+export interface DecoderMeasurement {
+  frames: number;
+  signals: number;
+  nsPerFrame: number;
+}
+
+export interface ReceivePluginResult {
+  /** Plugin-defined result type. */
+  tag: number;
+  data: Buffer;
+}
+
+export interface ReceivePluginStats {
+  name: string;
+  batches: number;
+  framesIn: number;
+  framesOut: number;
+  results: number;
+  /** Results emitted while no 'result' listener was registered. */
+  droppedResults: number;
+}
+
+export interface Nmea2000ReceiverOptions {
+  /** Discard a fast packet still incomplete this long after its first frame (default 750). */
+  timeoutMs?: number;
+  /** Fast-packet PGNs in addition to the standard ones, e.g. proprietary single-address PGNs. */
+  fastPacketPgns?: number[];
+  /** Deliver only these PGNs (default: all). */
+  pgns?: number[];
+}
+
+export interface Nmea2000Pgn {
+  pgn: number;
+  source: number;
+  /** 255 for broadcast, and always for PDU2 PGNs. */
+  destination: number;
+  priority: number;
+  /** Timestamp of the frame that completed the PGN. */
+  timestamp: number;
+  data: Buffer;
+}
+
+export interface Nmea2000ReceiverStats {
+  /** Extended data frames seen. */
+  frames: number;
+  /** Complete PGNs, single-frame and fast packet. */
+  pgns: number;
+  fastPackets: number;
+  /** Fast packets discarded incomplete after timeoutMs. */
+  timeouts: number;
+  /** Fast packets restarted or discarded because of inconsistent frames. */
+  errors: number;
+  inFlight: number;
+  /** PGNs dropped because JS fell behind. */
+  dropped: number;
+}
+
+export interface DeviceEvent {
+  /** Busmust serial number, or "type:deviceId:controller" for PCAN. */
+  serial: string;
+  /** Time between the detach and the channel being usable again (attach only). */
+  recoveryMs?: number;
+}
+
 export type MessageListener = (message: CANMessage) => void;
 export type ErrorListener = (error: CANError) => void;
 export type CloseListener = () => void;
+export type DeviceListener = (event: DeviceEvent) => void;
+export type FailoverListener = (event: FailoverEvent) => void;
 
 interface NativeModule {
   CANBus: NativeCANBusConstructor;
+  LogReader: NativeLogReaderConstructor;
+  LatencyProbe: NativeLatencyProbeConstructor;
+  RedundantBus: NativeRedundantBusConstructor;
+  IsoTp: NativeIsoTpConstructor;
+  SignalDatabase: NativeSignalDatabaseConstructor;
+  SignalDecoder: NativeSignalDecoderConstructor;
+  ReceivePlugin: NativeReceivePluginConstructor;
+  Nmea2000Receiver: NativeNmea2000ReceiverConstructor;
+  DiagnosticRunner: NativeDiagnosticRunnerConstructor;
+  Flasher: NativeFlasherConstructor;
+  DiagnosticScanner: NativeDiagnosticScannerConstructor;
+  CanTunnel: NativeCanTunnelConstructor;
+  FrameStreamServer: NativeFrameStreamServerConstructor;
+  DoipGateway: NativeDoipGatewayConstructor;
+  BatchEncoder: NativeBatchEncoderConstructor;
+  SignalHistory: NativeSignalHistoryConstructor;
+}
+
+interface NativeDoipGatewayConstructor {
+  new(routes: Array<Omit<DoipRoute, 'bus'> & { bus: NativeCANBusInstance }>, options?: DoipGatewayOptions): NativeDoipGatewayInstance;
+}
+
+interface NativeDoipGatewayInstance {
+  port(): number;
+  stats(): DoipGatewayStats;
+  close(): void;
+}
+
+interface NativeFrameStreamServerConstructor {
+  new(bus: NativeCANBusInstance, options?: FrameStreamServerOptions): NativeFrameStreamServerInstance;
+}
+
+interface NativeFrameStreamServerInstance {
+  port(): number;
+  stats(): FrameStreamServerStats;
+  close(): void;
+}
+
+interface NativeCanTunnelConstructor {
+  new(bus: NativeCANBusInstance, options: CanTunnelOptions): NativeCanTunnelInstance;
+}
+
+interface NativeCanTunnelInstance {
+  stats(): CanTunnelStats;
+  close(): void;
+}
+
+interface NativeDiagnosticScannerConstructor {
+  new(bus: NativeCANBusInstance, options?: DiagnosticScannerOptions): NativeDiagnosticScannerInstance;
+}
+
+interface NativeDiagnosticScannerInstance {
+  scan(): Promise<DiagnosticScanResult>;
+  stop(): void;
+  stats(): DiagnosticScannerStats;
+}
+
+interface NativeFlasherConstructor {
+  new(options?: FlasherOptions): NativeFlasherInstance;
+}
+
+type NativeFlashTarget = Omit<FlashTarget, 'bus'> & { bus: NativeCANBusInstance };
+
+interface NativeFlasherInstance {
+  flash(targets: NativeFlashTarget[]): Promise<FlashResult[]>;
+  on(event: 'progress', listener: (progress: FlashProgress) => void): void;
+  stats(): FlasherStats;
+  close(): void;
+}
+
+interface NativeDiagnosticRunnerConstructor {
+  new(bus: NativeCANBusInstance, options?: DiagnosticRunnerOptions): NativeDiagnosticRunnerInstance;
+}
+
+interface NativeDiagnosticRunnerInstance {
+  run(ecus: DiagnosticEcu[], requests?: Buffer[], options?: DiagnosticRunOptions): Promise<DiagnosticEcuResult[]>;
+  stats(): DiagnosticRunnerStats;
+  close(): void;
+}
+
+interface NativeNmea2000ReceiverConstructor {
+  new(bus: NativeCANBusInstance, options?: Nmea2000ReceiverOptions): NativeNmea2000ReceiverInstance;
+}
+
+interface NativeNmea2000ReceiverInstance {
+  on(event: 'pgn', listener: (pgn: Nmea2000Pgn) => void): void;
+  stats(): Nmea2000ReceiverStats;
+  close(): void;
+}
+
+interface NativeReceivePluginConstructor {
+  new(bus: NativeCANBusInstance, path: string, config?: string): NativeReceivePluginInstance;
+}
+
+interface NativeReceivePluginInstance {
+  on(event: 'result', listener: (result: ReceivePluginResult) => void): void;
+  stats(): ReceivePluginStats;
+  close(): void;
+}
+
+interface NativeSignalDatabaseConstructor {
+  new(path: string, format?: DatabaseFormat, options?: SignalDatabaseOptions): NativeSignalDatabaseInstance;
+}
+
+interface NativeSignalDatabaseInstance {
+  messages(): MessageDefinition[];
+  decode(message: CANMessage | CANFrame): DecodedMessage | null;
+  fromCache(): boolean;
+  generateDecoder(): string;
+}
+
+interface NativeSignalDecoderConstructor {
+  new(source: NativeSignalDatabaseInstance | string, bus?: NativeCANBusInstance): NativeSignalDecoderInstance;
+}
+
+interface NativeSignalDecoderInstance {
+  latest(): Record<string, number>;
+  decode(message: CANMessage | CANFrame): DecodedMessage | null;
+  encode(message: string, values: Record<string, number>): CANMessage;
+  measure(batch: Buffer, rounds?: number): DecoderMeasurement;
+  stats(): SignalDecoderStats;
+  close(): void;
+}
+
+interface NativeBatchEncoderConstructor {
+  new(format?: PackFormat, decoder?: NativeSignalDecoderInstance): NativeBatchEncoderInstance;
+}
+
+interface NativeBatchEncoderInstance {
+  encodeFrames(batch: ArrayBuffer | ArrayBufferView, count?: number): Buffer;
+  encodeSignals(batch: ArrayBuffer | ArrayBufferView, count?: number): Buffer;
+}
+
+interface NativeSignalHistoryConstructor {
+  new(decoder: NativeSignalDecoderInstance, options?: SignalHistoryOptions): NativeSignalHistoryInstance;
+}
+
+interface NativeSignalHistoryInstance {
+  query(signal: string, options?: SignalHistoryQuery): SignalSeries;
+  signals(): string[];
+  stats(): SignalHistoryStats;
+  clear(): void;
+  close(): void;
+}
+
+interface NativeIsoTpConstructor {
+  new(bus: NativeCANBusInstance, options?: IsoTpOptions): NativeIsoTpInstance;
+}
+
+interface NativeIsoTpInstance {
+  send(txId: number, rxId: number, data: Buffer): Promise<void>;
+  request(txId: number, rxId: number, data: Buffer, options?: IsoTpRequestOptions): Promise<Buffer>;
+  stats(): IsoTpStats;
+  close(): void;
+}
+
+interface NativeRedundantBusConstructor {
+  new(primary: NativeCANBusInstance, secondary: NativeCANBusInstance, options?: RedundantBusOptions): NativeRedundantBusInstance;
+}
+
+interface NativeRedundantBusInstance {
+  on(event: 'message', listener: MessageListener): void;
+  on(event: 'failover', listener: FailoverListener): void;
+  active(): number;
+  failover(reason?: string): number;
+  recordTransmit(message: CANMessage, source: number): void;
+  stats(): RedundantBusStats;
+  close(): void;
+}
+
+interface NativeLatencyProbeConstructor {
+  new(txBus: NativeCANBusInstance, rxBus: NativeCANBusInstance, options: LatencyProbeOptions): NativeLatencyProbeInstance;
+}
+
+interface NativeLatencyProbeInstance {
+  run(): Promise<LatencyReport>;
+  stop(): void;
+  results(): LatencyReport;
+}
+
+interface NativeLogReaderConstructor {
+  new(path: string, format?: LogFormat): NativeLogReaderInstance;
+}
+
+interface NativeLogReaderInstance {
+  read(maxFrames?: number): Buffer | null;
+  close(): void;
 }
 
 interface NativeCANBusConstructor {
-  new(channel: number, bustype: Bustype, bitrate: number): NativeCANBusInstance;
+  new(channel: number, bustype: Bustype, bitrate: number, options?: TunnelBusOptions): NativeCANBusInstance;
   isAvailable(bustype: Bustype): boolean;
 }
 
@@ -32,7 +873,19 @@ interface NativeCANBusInstance {
   on(event: 'message', listener: MessageListener): void;
   on(event: 'error', listener: ErrorListener): void;
   on(event: 'close', listener: CloseListener): void;
+  on(event: 'attach' | 'detach', listener: DeviceListener): void;
   close(): void;
+  setLogging(options: LoggingOptions): void;
+  getLogging(): LoggingOptions;
+  startWatcher(options?: WatcherOptions): void;
+  stopWatcher(): void;
+  setTxShaping(options: TxShapingOptions | null): void;
+  sendAt(message: CANMessage, timestamp: number, options?: SendAtOptions): Promise<TimedSendResult>;
+  now(clock?: ClockDomain): number;
+  readInto(buffer: ArrayBuffer | ArrayBufferView, maxFrames?: number, timeoutMs?: number): number;
+  setReceiveMode(mode: ReceiveMode): void;
+  setFilters(filters: ReceiveFilter[] | string | null): void;
+  tunnelStats(): TunnelStats;
 }
 
 let nativeBinding: NativeModule | null = null;
@@ -47,7 +900,25 @@ try {
 }
 
 
-const { CANBus: NativeCANBus } = nativeBinding ?? {
+const {
+  CANBus: NativeCANBus,
+  LogReader: NativeLogReader,
+  LatencyProbe: NativeLatencyProbe,
+  RedundantBus: NativeRedundantBus,
+  IsoTp: NativeIsoTp,
+  SignalDatabase: NativeSignalDatabase,
+  SignalDecoder: NativeSignalDecoder,
+  ReceivePlugin: NativeReceivePlugin,
+  Nmea2000Receiver: NativeNmea2000Receiver,
+  DiagnosticRunner: NativeDiagnosticRunner,
+  Flasher: NativeFlasher,
+  DiagnosticScanner: NativeDiagnosticScanner,
+  CanTunnel: NativeCanTunnel,
+  FrameStreamServer: NativeFrameStreamServer,
+  DoipGateway: NativeDoipGateway,
+  BatchEncoder: NativeBatchEncoder,
+  SignalHistory: NativeSignalHistory,
+} = nativeBinding ?? {
   CANBus: class {
     constructor() {
       console.log('Warning: ace-can native module is not available on macOS. This is a stub implementation.');
@@ -58,14 +929,132 @@ const { CANBus: NativeCANBus } = nativeBinding ?? {
     send() { }
     on() { return this; }
     close() { }
+    setLogging() { }
+    getLogging() { return {}; }
+    startWatcher() { }
+    stopWatcher() { }
+    setTxShaping() { }
+    sendAt() { return Promise.reject(new Error('ace-can native module is not available')); }
+    now() { return 0; }
+    readInto() { return 0; }
+    setReceiveMode() {}
+    setFilters() {}
+    tunnelStats(): TunnelStats { return { packets: 0, frames: 0, lost: 0, late: 0, dropped: 0, sent: 0, connected: false }; }
+  },
+  LogReader: class {
+    read() { return null; }
+    close() { }
+  },
+  LatencyProbe: class {
+    run() { return Promise.reject(new Error('ace-can native module is not available')); }
+    stop() { }
+    results() { return {}; }
+  },
+  RedundantBus: class {
+    on() { return this; }
+    active() { return 0; }
+    failover() { return 0; }
+    recordTransmit() { }
+    stats() { return {}; }
+    close() { }
+  },
+  IsoTp: class {
+    send() { return Promise.reject(new Error('ace-can native module is not available')); }
+    request() { return Promise.reject(new Error('ace-can native module is not available')); }
+    stats() { return {}; }
+    close() { }
+  },
+  SignalDatabase: class {
+    messages() { return []; }
+    decode() { return null; }
+    fromCache() { return false; }
+    generateDecoder() { return ''; }
+  },
+  SignalDecoder: class {
+    latest() { return {}; }
+    decode() { return null; }
+    encode(): CANMessage { throw new Error('ace-can native module is not available'); }
+    measure() { return { frames: 0, signals: 0, nsPerFrame: 0 }; }
+    stats() { return { backend: 'tables' as const, decoded: 0, unknown: 0 }; }
+    close() { }
+  },
+  ReceivePlugin: class {
+    on() { }
+    stats(): ReceivePluginStats { return { name: '', batches: 0, framesIn: 0, framesOut: 0, results: 0, droppedResults: 0 }; }
+    close() { }
+  },
+  Nmea2000Receiver: class {
+    on() { }
+    stats(): Nmea2000ReceiverStats { return { frames: 0, pgns: 0, fastPackets: 0, timeouts: 0, errors: 0, inFlight: 0, dropped: 0 }; }
+    close() { }
+  },
+  DiagnosticRunner: class {
+    run(): Promise<DiagnosticEcuResult[]> { return Promise.reject(new Error('ace-can native module is not available')); }
+    stats(): DiagnosticRunnerStats { return { active: 0, pending: 0, runs: 0, requests: 0, negative: 0, errors: 0 }; }
+    close() { }
+  },
+  Flasher: class {
+    flash(): Promise<FlashResult[]> { return Promise.reject(new Error('ace-can native module is not available')); }
+    on() { }
+    stats(): FlasherStats { return { pending: 0, flashed: 0, failed: 0 }; }
+    close() { }
+  },
+  DiagnosticScanner: class {
+    scan(): Promise<DiagnosticScanResult> { return Promise.reject(new Error('ace-can native module is not available')); }
+    stop() { }
+    stats(): DiagnosticScannerStats { return { phase: 'idle', probes: 0, responses: 0, candidates: 0, found: 0, unconfirmed: 0, sendErrors: 0 }; }
+  },
+  CanTunnel: class {
+    stats(): CanTunnelStats {
+      return {
+        framesSent: 0, packetsSent: 0, bytesSent: 0, dropped: 0, sendErrors: 0, packetsReceived: 0, framesReceived: 0,
+        lost: 0, late: 0, transmitErrors: 0, connected: false,
+      };
+    }
+    close() { }
+  },
+  FrameStreamServer: class {
+    port() { return 0; }
+    stats(): FrameStreamServerStats {
+      return { clients: 0, batches: 0, frames: 0, messages: 0, bytes: 0, queuedBytes: 0, droppedClients: 0, rejected: 0 };
+    }
+    close() { }
+  },
+  DoipGateway: class {
+    port() { return 0; }
+    stats(): DoipGatewayStats {
+      return {
+        testers: 0, activeTesters: 0, activations: 0, requests: 0, queued: 0, responses: 0, unanswered: 0, nacks: 0,
+        transportErrors: 0, rejected: 0,
+      };
+    }
+    close() { }
+  },
+  BatchEncoder: class {
+    encodeFrames(): Buffer { throw new Error('ace-can native module is not available'); }
+    encodeSignals(): Buffer { throw new Error('ace-can native module is not available'); }
+  },
+  SignalHistory: class {
+    query(): SignalSeries { return { timestamps: new Float64Array(0), values: new Float64Array(0) }; }
+    signals(): string[] { return []; }
+    stats(): SignalHistoryStats { return { signals: 0, samples: 0, appended: 0, bytes: 0 }; }
+    clear() { }
+    close() { }
   },
 };
 
 export class CANBus {
-  private readonly native: NativeCANBusInstance;
+  /** @internal */
+  readonly native: NativeCANBusInstance;
 
-  constructor(channel: number, bustype: Bustype, bitrate: number) {
-    this.native = new NativeCANBus(channel, bustype, bitrate);
+  /**
+   * Bustypes 'udp' and 'tcp' are the receiving end of a CanTunnel: `options.port` is the local port
+   * and `channel` the tunnel channel. Frames keep the sender's timestamps; bitrate is informational.
+   */
+  constructor(channel: number, bustype: Bustype, bitrate: number, options?: TunnelBusOptions) {
+    this.native = options === undefined
+      ? new NativeCANBus(channel, bustype, bitrate)
+      : new NativeCANBus(channel, bustype, bitrate, options);
   }
 
   send(message: CANMessage): void {
@@ -75,7 +1064,11 @@ export class CANBus {
   on(event: 'message', listener: MessageListener): this;
   on(event: 'error', listener: ErrorListener): this;
   on(event: 'close', listener: CloseListener): this;
-  on(event: 'message' | 'error' | 'close', listener: MessageListener | ErrorListener | CloseListener): this {
+  on(event: 'attach' | 'detach', listener: DeviceListener): this;
+  on(
+    event: 'message' | 'error' | 'close' | 'attach' | 'detach',
+    listener: MessageListener | ErrorListener | CloseListener | DeviceListener,
+  ): this {
     (this.native as unknown as { on(event: string, listener: (...args: unknown[]) => void): void }).on(
       event,
       listener as unknown as (...args: unknown[]) => void,
@@ -87,6 +1080,86 @@ export class CANBus {
     this.native.close();
   }
 
+  /** Configures on-device logging (busmust) or driver-level trace files (pcan). */
+  setLogging(options: LoggingOptions): void {
+    this.native.setLogging(options);
+  }
+
+  getLogging(): LoggingOptions {
+    return this.native.getLogging();
+  }
+
+  /**
+   * Watches for the adapter disappearing and coming back ('detach'/'attach' events). While detached,
+   * send() throws; once the same device re-enumerates the channel is re-opened and logging restored.
+   */
+  startWatcher(options?: WatcherOptions): void {
+    this.native.startWatcher(options);
+  }
+
+  stopWatcher(): void {
+    this.native.stopWatcher();
+  }
+
+  /**
+   * Limits transmit traffic with token buckets counted in worst-case wire bits. While shaping is on,
+   * send() queues frames for a native writer thread and throws only when the queue is full. Native
+   * senders on this bus (IsoTp, DiagnosticRunner, Flasher, DiagnosticScanner, DoipGateway, CanTunnel)
+   * are shaped too; LatencyProbe and sendAt() are not, except that the hardware interframe gap set on
+   * capable PCAN adapters (at most 1023 µs) spaces their frames as well.
+   */
+  setTxShaping(options: TxShapingOptions | null): void {
+    this.native.setTxShaping(options);
+  }
+
+  /**
+   * Transmits a frame at an absolute time (microseconds). A native thread sleeps until just before
+   * the deadline and spins the rest of the way; the promise reports the achieved time.
+   */
+  sendAt(message: CANMessage, timestamp: number, options?: SendAtOptions): Promise<TimedSendResult> {
+    return this.native.sendAt(message, timestamp, options);
+  }
+
+  /** Current time in microseconds on the given clock (host monotonic by default). */
+  now(clock?: ClockDomain): number {
+    return this.native.now(clock);
+  }
+
+  /**
+   * Pull-mode receive: drains the driver queue into `buffer` as frame records (FRAME_RECORD_SIZE bytes
+   * each, see decodeFrameBatch) on the calling thread and returns the record count. Waits up to
+   * timeoutMs for the first frame. Cannot be combined with 'message' listeners. The buffer must be
+   * 8-byte aligned.
+   */
+  readInto(buffer: ArrayBuffer | ArrayBufferView, maxFrames?: number, timeoutMs?: number): number {
+    return this.native.readInto(buffer, maxFrames, timeoutMs);
+  }
+
+  /**
+   * Selects how 'message' listeners and native taps are fed; call before on('message'). 'poll'
+   * watches the PCAN receive event fd from the Node event loop (Linux only) and avoids the receive
+   * thread and its cross-thread hop per wake-up.
+   */
+  setReceiveMode(mode: ReceiveMode): void {
+    this.native.setReceiveMode(mode);
+  }
+
+  /**
+   * Replaces the acceptance filters for 'message' listeners and readInto(); a frame passes if any
+   * filter matches, or if it satisfies a filter expression such as
+   * `'id in 0x100..0x1FF && data[2] & 0x08 && dlc == 8'`, which is compiled natively and throws on
+   * a syntax error. null passes everything. Safe to call at any time: the receive path picks up the
+   * new filters with its next batch, without pausing or dropping frames.
+   */
+  setFilters(filters: ReceiveFilter[] | string | null): void {
+    this.native.setFilters(filters);
+  }
+
+  /** Packet and loss counters of a 'udp' / 'tcp' bus; throws on other bustypes. */
+  tunnelStats(): TunnelStats {
+    return this.native.tunnelStats();
+  }
+
   static isAvailable(bustype: Bustype): boolean {
     return NativeCANBus.isAvailable(bustype);
   }
@@ -95,3 +1168,580 @@ export class CANBus {
 export function isAvailable(bustype: Bustype): boolean {
   return CANBus.isAvailable(bustype);
 }
+
+/**
+ * Measures request/response round trips between two buses (or one bus and an echoing ECU), split into
+ * transmit, driver, addon and JS components.
+ */
+export class LatencyProbe {
+  private readonly native: NativeLatencyProbeInstance;
+
+  constructor(txBus: CANBus, rxBus: CANBus, options: LatencyProbeOptions) {
+    this.native = new NativeLatencyProbe(txBus.native, rxBus.native, options);
+  }
+
+  /** Sends the configured requests and resolves with the latency report. */
+  run(): Promise<LatencyReport> {
+    return this.native.run();
+  }
+
+  stop(): void {
+    this.native.stop();
+  }
+
+  /** Report so far; safe to call while a run is in progress. */
+  results(): LatencyReport {
+    return this.native.results();
+  }
+}
+
+/**
+ * Two adapters on the same bus used as one: transmits on the active adapter (the primary until a
+ * failover) and receives from both, with duplicates removed natively before they reach JS.
+ */
+export class RedundantBus {
+  readonly primary: CANBus;
+  readonly secondary: CANBus;
+  private readonly native: NativeRedundantBusInstance;
+
+  constructor(primary: CANBus, secondary: CANBus, options?: RedundantBusOptions) {
+    this.primary = primary;
+    this.secondary = secondary;
+    this.native = new NativeRedundantBus(primary.native, secondary.native, options);
+  }
+
+  /** Sends on the active adapter; a transmit error on the primary fails over and retries once. */
+  send(message: CANMessage): void {
+    if (this.native.active() === 0) {
+      try {
+        this.native.recordTransmit(message, 0);
+        this.primary.send(message);
+        return;
+      } catch (err) {
+        this.native.failover(`primary transmit failed: ${(err as Error).message}`);
+      }
+    }
+    this.native.recordTransmit(message, 1);
+    this.secondary.send(message);
+  }
+
+  on(event: 'message', listener: MessageListener): this;
+  on(event: 'failover', listener: FailoverListener): this;
+  on(event: 'message' | 'failover', listener: MessageListener | FailoverListener): this {
+    (this.native as unknown as { on(event: string, listener: (...args: unknown[]) => void): void }).on(
+      event,
+      listener as unknown as (...args: unknown[]) => void,
+    );
+    return this;
+  }
+
+  active(): 'primary' | 'secondary' {
+    return this.native.active() === 0 ? 'primary' : 'secondary';
+  }
+
+  stats(): RedundantBusStats {
+    return this.native.stats();
+  }
+
+  /** Stops de-duplication; the two CANBus instances stay open. */
+  close(): void {
+    this.native.close();
+  }
+}
+
+/**
+ * ISO-TP (ISO 15765-2) transfers over classic CAN with normal addressing. Every send() or request()
+ * runs as a coroutine on one native scheduler thread per IsoTp, driven by the receive thread and a
+ * timer wheel, so hundreds of concurrent sessions (one per ECU) need no threads of their own.
+ */
+export class IsoTp {
+  readonly bus: CANBus;
+  private readonly native: NativeIsoTpInstance;
+
+  constructor(bus: CANBus, options?: IsoTpOptions) {
+    this.bus = bus;
+    this.native = new NativeIsoTp(bus.native, options);
+  }
+
+  /** Sends one message; resolves once the last frame is written. */
+  send(txId: number, rxId: number, data: Buffer): Promise<void> {
+    return this.native.send(txId, rxId, data);
+  }
+
+  /** Sends one message and resolves with the reassembled response from rxId. */
+  request(txId: number, rxId: number, data: Buffer, options?: IsoTpRequestOptions): Promise<Buffer> {
+    return this.native.request(txId, rxId, data, options);
+  }
+
+  stats(): IsoTpStats {
+    return this.native.stats();
+  }
+
+  /** Rejects pending transfers; the CANBus stays open. */
+  close(): void {
+    this.native.close();
+  }
+}
+
+/**
+ * Runs UDS request sequences against many ECUs on one bus concurrently, e.g. reading DTCs and
+ * identifiers at end of line. Every ECU is a session on one native scheduler thread; ISO-TP flow
+ * control is multiplexed by CAN ID and P2/P2* timing is kept per ECU, so a run takes about as long
+ * as its slowest ECU rather than the sum of all round trips.
+ */
+export class DiagnosticRunner {
+  readonly bus: CANBus;
+  private readonly native: NativeDiagnosticRunnerInstance;
+
+  constructor(bus: CANBus, options?: DiagnosticRunnerOptions) {
+    this.bus = bus;
+    this.native = new NativeDiagnosticRunner(bus.native, options);
+  }
+
+  /**
+   * Sends each ECU its requests in order and resolves with one result per ECU, in the order given.
+   * ECUs must answer on distinct rxIds.
+   */
+  run(ecus: DiagnosticEcu[], requests?: Buffer[], options?: DiagnosticRunOptions): Promise<DiagnosticEcuResult[]> {
+    return this.native.run(ecus, requests, options);
+  }
+
+  stats(): DiagnosticRunnerStats {
+    return this.native.stats();
+  }
+
+  /** Rejects pending runs; the CANBus stays open. */
+  close(): void {
+    this.native.close();
+  }
+}
+
+/**
+ * Flashes ECUs over UDS on several buses in parallel. Each bus in a flash() call gets its own
+ * native scheduler thread running the RequestDownload / TransferData / RequestTransferExit sequence
+ * for every ECU on it, reading the memory-mapped image in place, so no block crosses into JS.
+ */
+export class Flasher {
+  private readonly native: NativeFlasherInstance;
+
+  constructor(options?: FlasherOptions) {
+    this.native = new NativeFlasher(options);
+  }
+
+  /**
+   * Downloads every target's image and resolves with one result per target, in the order given,
+   * once all have finished. A failed target does not stop the others. Targets on one bus must
+   * answer on distinct rxIds.
+   */
+  flash(targets: FlashTarget[]): Promise<FlashResult[]> {
+    return this.native.flash(targets.map((target) => ({ ...target, bus: target.bus.native })));
+  }
+
+  on(event: 'progress', listener: (progress: FlashProgress) => void): this {
+    this.native.on(event, listener);
+    return this;
+  }
+
+  stats(): FlasherStats {
+    return this.native.stats();
+  }
+
+  /** Aborts downloads in progress and rejects pending flash() calls; the buses stay open. */
+  close(): void {
+    this.native.close();
+  }
+}
+
+/**
+ * Finds the diagnostic request/response ID pairs on an unknown bus. Probes go out natively at a set
+ * share of the bitrate without waiting for answers; responses are attributed on the receive
+ * thread and each candidate pair is confirmed with a single re-probe, so a full 11-bit sweep takes
+ * seconds rather than one timeout per ID.
+ */
+export class DiagnosticScanner {
+  readonly bus: CANBus;
+  private readonly native: NativeDiagnosticScannerInstance;
+
+  constructor(bus: CANBus, options?: DiagnosticScannerOptions) {
+    this.bus = bus;
+    this.native = new NativeDiagnosticScanner(bus.native, options);
+  }
+
+  /** Sweeps the configured ranges and resolves with the confirmed pairs, sorted by txId. */
+  scan(): Promise<DiagnosticScanResult> {
+    return this.native.scan();
+  }
+
+  /** Ends the scan early; scan() resolves with the pairs confirmed so far. */
+  stop(): void {
+    this.native.stop();
+  }
+
+  /** Progress; safe to call while a scan is in progress. */
+  stats(): DiagnosticScannerStats {
+    return this.native.stats();
+  }
+}
+
+/**
+ * Forwards everything a CANBus receives to a remote CANBus of bustype 'udp' / 'tcp', many frames
+ * per packet with their timestamps and a sequence number for loss accounting. Batching, packing and
+ * the socket run on native threads; frames the remote side sends back are transmitted on this bus.
+ */
+export class CanTunnel {
+  readonly bus: CANBus;
+  private readonly native: NativeCanTunnelInstance;
+
+  constructor(bus: CANBus, options: CanTunnelOptions) {
+    this.bus = bus;
+    this.native = new NativeCanTunnel(bus.native, options);
+  }
+
+  stats(): CanTunnelStats {
+    return this.native.stats();
+  }
+
+  /** Stops forwarding; the CANBus stays open. */
+  close(): void {
+    this.native.close();
+  }
+}
+
+/**
+ * Streams a bus's receive batches to WebSocket clients (e.g. browser dashboards) as binary
+ * messages, see decodeStreamMessage. Each batch is serialized once per distinct subscription on the
+ * receive thread and written to every client natively; clients that fall behind are disconnected.
+ * Clients pick frames with a text message, "subscribe 0x100-0x1FF,0x7E8" or "subscribe *".
+ */
+export class FrameStreamServer {
+  readonly bus: CANBus;
+  private readonly native: NativeFrameStreamServerInstance;
+
+  constructor(bus: CANBus, options?: FrameStreamServerOptions) {
+    this.bus = bus;
+    this.native = new NativeFrameStreamServer(bus.native, options);
+  }
+
+  /** The listening port, useful with port 0. */
+  port(): number {
+    return this.native.port();
+  }
+
+  stats(): FrameStreamServerStats {
+    return this.native.stats();
+  }
+
+  /** Disconnects every client and stops listening; the CANBus stays open. */
+  close(): void {
+    this.native.close();
+  }
+}
+
+/**
+ * DoIP (ISO 13400-2) gateway for CAN ECUs: testers connect over TCP, activate routing and send
+ * diagnostic messages to a route's logical address, which are forwarded over ISO-TP on its bus.
+ * Parsing, acknowledgement and ISO-TP run on native threads; every ECU response, response-pending
+ * ones included, is relayed to the tester that asked. Requests to one ECU are served in order,
+ * different ECUs in parallel.
+ */
+export class DoipGateway {
+  private readonly native: NativeDoipGatewayInstance;
+
+  constructor(routes: DoipRoute[], options?: DoipGatewayOptions) {
+    this.native = new NativeDoipGateway(routes.map((route) => ({ ...route, bus: route.bus.native })), options);
+  }
+
+  /** The listening port, useful with port 0. */
+  port(): number {
+    return this.native.port();
+  }
+
+  stats(): DoipGatewayStats {
+    return this.native.stats();
+  }
+
+  /** Disconnects every tester and stops listening; the buses stay open. */
+  close(): void {
+    this.native.close();
+  }
+}
+
+/**
+ * Message and signal definitions from a .dbc file or an AUTOSAR .arxml communication matrix. ARXML
+ * files are streamed through a native pull parser into the same tables as DBC, so large matrices
+ * import in seconds with memory proportional to the frames and signals they define.
+ */
+export class SignalDatabase {
+  /** @internal */
+  readonly native: NativeSignalDatabaseInstance;
+
+  /** Loads the file synchronously; the format defaults to the file extension. */
+  constructor(path: string, format?: DatabaseFormat, options?: SignalDatabaseOptions) {
+    if (options) {
+      this.native = new NativeSignalDatabase(path, format, options);
+    } else {
+      this.native = format ? new NativeSignalDatabase(path, format) : new NativeSignalDatabase(path);
+    }
+  }
+
+  messages(): MessageDefinition[] {
+    return this.native.messages();
+  }
+
+  /** Physical signal values of a received message, or null if its ID is not in the database. */
+  decode(message: CANMessage | CANFrame): DecodedMessage | null {
+    return this.native.decode(message);
+  }
+
+  /** True if the tables came from the compiled cache rather than the source file. */
+  fromCache(): boolean {
+    return this.native.fromCache();
+  }
+
+  /**
+   * C++ source of a decoder plugin for this database (see src/ace_can_decoder.h): one decode and
+   * encode function per message with bit positions and scaling compiled in, behind a switch on the
+   * frame ID. Build it as a shared library and pass its path to SignalDecoder.
+   */
+  generateDecoder(): string {
+    return this.native.generateDecoder();
+  }
+}
+
+/**
+ * Decodes every frame received on a bus on the native receive thread, before the JS hop, and keeps
+ * the latest value of each signal. The source is a SignalDatabase (generic table-driven decoding)
+ * or the path of a decoder plugin built from SignalDatabase.generateDecoder().
+ */
+export class SignalDecoder {
+  readonly bus?: CANBus;
+  /** @internal */
+  readonly native: NativeSignalDecoderInstance;
+
+  /** Without a bus, only decode(), encode() and measure() are useful. */
+  constructor(source: SignalDatabase | string, bus?: CANBus) {
+    this.bus = bus;
+    const nativeSource = typeof source === 'string' ? source : source.native;
+    this.native = bus ? new NativeSignalDecoder(nativeSource, bus.native) : new NativeSignalDecoder(nativeSource);
+  }
+
+  /** Latest physical values by "Message.Signal", for signals received so far. */
+  latest(): Record<string, number> {
+    return this.native.latest();
+  }
+
+  decode(message: CANMessage | CANFrame): DecodedMessage | null {
+    return this.native.decode(message);
+  }
+
+  /** Builds the payload of a message from physical values; signals left out are zero. */
+  encode(message: string, values: Record<string, number>): CANMessage {
+    return this.native.encode(message, values);
+  }
+
+  /** Decodes a frame batch `rounds` times on the calling thread and reports the cost per frame. */
+  measure(batch: Buffer, rounds?: number): DecoderMeasurement {
+    return this.native.measure(batch, rounds);
+  }
+
+  stats(): SignalDecoderStats {
+    return this.native.stats();
+  }
+
+  /** Stops decoding received frames; the CANBus stays open. */
+  close(): void {
+    this.native.close();
+  }
+}
+
+/**
+ * Serializes frame batches (see FRAME_RECORD_SIZE) to MessagePack or CBOR in one native call, for
+ * forwarding without building objects or JSON. Keys, message names and signal names are encoded
+ * once when the encoder is created; integral values are written as integers, others as float64.
+ */
+export class BatchEncoder {
+  readonly decoder?: SignalDecoder;
+  private readonly native: NativeBatchEncoderInstance;
+
+  /** Defaults to 'msgpack'. The decoder is only needed for encodeSignals(). */
+  constructor(format: PackFormat = 'msgpack', decoder?: SignalDecoder) {
+    this.decoder = decoder;
+    this.native = decoder ? new NativeBatchEncoder(format, decoder.native) : new NativeBatchEncoder(format);
+  }
+
+  /** An array of `{ timestamp, id, flags, channel, data }` maps, data as a byte string. */
+  encodeFrames(batch: ArrayBuffer | ArrayBufferView, count?: number): Buffer {
+    return this.native.encodeFrames(batch, count);
+  }
+
+  /**
+   * An array of `{ timestamp, id, name, signals: { [signal]: value } }` maps, one per frame the
+   * decoder's database defines; other frames, remote and error frames are left out.
+   */
+  encodeSignals(batch: ArrayBuffer | ArrayBufferView, count?: number): Buffer {
+    return this.native.encodeSignals(batch, count);
+  }
+}
+
+/**
+ * Records the recent values of a SignalDecoder's signals in native ring buffers, on the receive
+ * thread, and returns time ranges downsampled for plotting as Float64Arrays. Samples take 12 bytes
+ * each and old ones are recycled, so history of many signals costs no JS allocations or GC.
+ */
+export class SignalHistory {
+  readonly decoder: SignalDecoder;
+  private readonly native: NativeSignalHistoryInstance;
+
+  /** Only values decoded from the decoder's bus are recorded. */
+  constructor(decoder: SignalDecoder, options?: SignalHistoryOptions) {
+    this.decoder = decoder;
+    this.native = new NativeSignalHistory(decoder.native, options);
+  }
+
+  /** Samples of one "Message.Signal" in a time range, downsampled to at most `points`. */
+  query(signal: string, options?: SignalHistoryQuery): SignalSeries {
+    return this.native.query(signal, options);
+  }
+
+  /** Names of the recorded signals. */
+  signals(): string[] {
+    return this.native.signals();
+  }
+
+  stats(): SignalHistoryStats {
+    return this.native.stats();
+  }
+
+  /** Drops the recorded samples; recording continues. */
+  clear(): void {
+    this.native.clear();
+  }
+
+  /** Stops recording; the history stays queryable and the decoder keeps running. */
+  close(): void {
+    this.native.close();
+  }
+}
+
+/**
+ * Runs a native receive-stage plugin (C ABI in src/ace_can_stage.h) on a bus. The plugin gets each
+ * batch of received frames that passed the filters on the receive thread, before they reach JS,
+ * and may drop, rewrite, annotate (message.annotation) or add frames and emit results.
+ */
+export class ReceivePlugin {
+  readonly bus: CANBus;
+  private readonly native: NativeReceivePluginInstance;
+
+  /** `config` is passed verbatim to the plugin's create(). */
+  constructor(bus: CANBus, path: string, config?: string) {
+    this.bus = bus;
+    this.native = config === undefined ? new NativeReceivePlugin(bus.native, path) : new NativeReceivePlugin(bus.native, path, config);
+  }
+
+  on(event: 'result', listener: (result: ReceivePluginResult) => void): this {
+    this.native.on(event, listener);
+    return this;
+  }
+
+  stats(): ReceivePluginStats {
+    return this.native.stats();
+  }
+
+  /** Removes the plugin from the receive path and destroys its instance; the CANBus stays open. */
+  close(): void {
+    this.native.close();
+  }
+}
+
+/**
+ * NMEA 2000 receiver on a bus. Fast packets are reassembled natively on the receive thread, keyed by
+ * source, PGN and sequence counter, so interleaved and out-of-order frames are handled before JS;
+ * 'pgn' listeners only see complete PGNs. Sees every received frame, regardless of setFilters().
+ */
+export class Nmea2000Receiver {
+  readonly bus: CANBus;
+  private readonly native: NativeNmea2000ReceiverInstance;
+
+  constructor(bus: CANBus, options?: Nmea2000ReceiverOptions) {
+    this.bus = bus;
+    this.native = new NativeNmea2000Receiver(bus.native, options);
+  }
+
+  on(event: 'pgn', listener: (pgn: Nmea2000Pgn) => void): this {
+    this.native.on(event, listener);
+    return this;
+  }
+
+  stats(): Nmea2000ReceiverStats {
+    return this.native.stats();
+  }
+
+  /** Stops reassembling; the CANBus stays open. */
+  close(): void {
+    this.native.close();
+  }
+}
+
+/** Decodes a frame batch buffer (see FRAME_RECORD_SIZE) into frame objects. */
+export function decodeFrameBatch(batch: Buffer): CANFrame[] {
+  const frames: CANFrame[] = [];
+  for (let offset = 0; offset + FRAME_RECORD_SIZE <= batch.length; offset += FRAME_RECORD_SIZE) {
+    const length = batch.readUInt8(offset + 13);
+    frames.push({
+      timestamp: Number(batch.readBigUInt64LE(offset)),
+      id: batch.readUInt32LE(offset + 8),
+      flags: batch.readUInt8(offset + 12),
+      channel: batch.readUInt16LE(offset + 14),
+      data: Buffer.from(batch.subarray(offset + 16, offset + 16 + length)),
+    });
+  }
+  return frames;
+}
+
+/**
+ * Decodes a FrameStreamServer message: u32 frame count, then per frame f64 timestamp, u32 id,
+ * u8 flags, u8 length, u16 channel and the data, all little-endian.
+ */
+export function decodeStreamMessage(message: ArrayBuffer | Uint8Array): CANFrame[] {
+  const bytes = message instanceof Uint8Array ? message : new Uint8Array(message);
+  const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+  const frames: CANFrame[] = [];
+  const count = view.getUint32(0, true);
+  let offset = 4;
+  for (let i = 0; i < count && offset + 16 <= bytes.byteLength; ++i) {
+    const length = view.getUint8(offset + 13);
+    frames.push({
+      timestamp: view.getFloat64(offset, true),
+      id: view.getUint32(offset + 8, true),
+      flags: view.getUint8(offset + 12),
+      channel: view.getUint16(offset + 14, true),
+      data: Buffer.from(bytes.subarray(offset + 16, offset + 16 + length)),
+    });
+    offset += 16 + length;
+  }
+  return frames;
+}
+
+/** Streams frames out of .asc, candump .log, PCAN .trc and SocketCAN .pcap files as frame batches. */
+export class LogReader {
+  private readonly native: NativeLogReaderInstance;
+
+  constructor(path: string, format?: LogFormat) {
+    this.native = format ? new NativeLogReader(path, format) : new NativeLogReader(path);
+  }
+
+  /** Returns the next batch of up to maxFrames records, or null at end of file. */
+  read(maxFrames?: number): Buffer | null {
+    return this.native.read(maxFrames);
+  }
+
+  close(): void {
+    this.native.close();
+  }
+
+  *[Symbol.iterator](): IterableIterator<Buffer> {
+    for (let batch = this.read(); batch !== null; batch = this.read()) {
+      yield batch;
+    }
+  }
+}
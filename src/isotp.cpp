@@ -0,0 +1,194 @@
+#include "isotp.h"
+
+#include "ace_can.h"
+#include "napi_options.h"
+
+bool ReadIsoTpOptions(Napi::Env env, const Napi::Object& options, IsoTpConfig& config) {
+    uint32_t blockSize = config.block_size;
+    uint32_t stMin = config.st_min;
+    uint32_t padding = config.padding;
+    uint32_t timeoutMs = static_cast<uint32_t>(config.timeout_us / 1000);
+    if (!GetOptionalUint32(options, "blockSize", blockSize) || !GetOptionalUint32(options, "stMin", stMin) ||
+        !GetOptionalUint32(options, "padding", padding) || !GetOptionalUint32(options, "timeoutMs", timeoutMs)) {
+        Napi::TypeError::New(env, "Invalid ISO-TP option type").ThrowAsJavaScriptException();
+        return false;
+    }
+    if (blockSize > 0xFF || stMin > 0xFF || padding > 0xFF) {
+        Napi::RangeError::New(env, "blockSize, stMin and padding must fit in a byte").ThrowAsJavaScriptException();
+        return false;
+    }
+    if (timeoutMs == 0) {
+        Napi::RangeError::New(env, "timeoutMs must be positive").ThrowAsJavaScriptException();
+        return false;
+    }
+    config.block_size = static_cast<uint8_t>(blockSize);
+    config.st_min = static_cast<uint8_t>(stMin);
+    config.padding = static_cast<uint8_t>(padding);
+    config.timeout_us = static_cast<int64_t>(timeoutMs) * 1000;
+    return true;
+}
+
+Napi::Object IsoTp::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "IsoTp", {
+        InstanceMethod("send", &IsoTp::Send),
+        InstanceMethod("request", &IsoTp::Request),
+        InstanceMethod("stats", &IsoTp::Stats),
+        InstanceMethod("close", &IsoTp::Close),
+    });
+    exports.Set("IsoTp", func);
+    return exports;
+}
+
+IsoTp::IsoTp(const Napi::CallbackInfo& info) : Napi::ObjectWrap<IsoTp>(info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1) {
+        Napi::TypeError::New(env, "Expected bus").ThrowAsJavaScriptException();
+        return;
+    }
+    bus_ = CANBus::FromValue(env, info[0]);
+    if (bus_ == nullptr) {
+        Napi::TypeError::New(env, "bus must be a CANBus instance").ThrowAsJavaScriptException();
+        return;
+    }
+
+    if (info.Length() > 1 && info[1].IsObject() && !ReadIsoTpOptions(env, info[1].As<Napi::Object>(), config_)) {
+        return;
+    }
+
+    bus_ref_ = Napi::Persistent(info[0].As<Napi::Object>());
+    // Only holds the event loop open while transfers are pending.
+    tsfn_ = Napi::ThreadSafeFunction::New(env, Napi::Function::New(env, [](const Napi::CallbackInfo&) {}), "IsoTp", 0, 1);
+    tsfn_.Unref(env);
+    scheduler_ = std::make_unique<SessionScheduler>(bus_);
+    scheduler_->Start();
+}
+
+IsoTp::~IsoTp() {
+    Shutdown();
+}
+
+// send(txId, rxId, data) resolves once the last frame is written.
+Napi::Value IsoTp::Send(const Napi::CallbackInfo& info) {
+    return Start(info, false);
+}
+
+// request(txId, rxId, data, { timeoutMs }) sends, then resolves with the reassembled response.
+Napi::Value IsoTp::Request(const Napi::CallbackInfo& info) {
+    return Start(info, true);
+}
+
+Napi::Value IsoTp::Start(const Napi::CallbackInfo& info, bool expectResponse) {
+    Napi::Env env = info.Env();
+    if (closed_ || !scheduler_) {
+        Napi::Error::New(env, "IsoTp closed").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (info.Length() < 3 || !info[0].IsNumber() || !info[1].IsNumber() || !info[2].IsBuffer()) {
+        Napi::TypeError::New(env, "Expected (txId, rxId, data)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    uint32_t txId = info[0].As<Napi::Number>().Uint32Value();
+    uint32_t rxId = info[1].As<Napi::Number>().Uint32Value();
+    Napi::Buffer<uint8_t> data = info[2].As<Napi::Buffer<uint8_t>>();
+    if (data.Length() == 0 || data.Length() > kMaxPayload) {
+        Napi::RangeError::New(env, "ISO-TP payload must be 1 to 4095 bytes").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    uint32_t timeoutMs = static_cast<uint32_t>(config_.timeout_us / 1000);
+    if (info.Length() > 3 && info[3].IsObject() && !GetOptionalUint32(info[3].As<Napi::Object>(), "timeoutMs", timeoutMs)) {
+        Napi::TypeError::New(env, "timeoutMs must be a number").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    uint64_t id = next_id_++;
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    pending_.emplace(id, deferred);
+    if (pending_.size() == 1) {
+        tsfn_.Ref(env);
+        Ref();
+    }
+    std::vector<uint8_t> payload(data.Data(), data.Data() + data.Length());
+    int64_t responseTimeoutUs = static_cast<int64_t>(timeoutMs) * 1000;
+    scheduler_->Spawn([this, id, txId, rxId, payload, expectResponse, responseTimeoutUs]() {
+        return Run(id, txId, rxId, payload, expectResponse, responseTimeoutUs);
+    });
+    return deferred.Promise();
+}
+
+SessionTask IsoTp::Run(uint64_t id, uint32_t txId, uint32_t rxId, std::vector<uint8_t> payload, bool expectResponse,
+                       int64_t responseTimeoutUs) {
+    IsoTpResult result;
+    result.error = co_await IsoTpSend(*scheduler_, config_, txId, rxId, std::move(payload));
+    if (result.error.empty() && expectResponse) {
+        result = co_await IsoTpReceive(*scheduler_, config_, rxId, txId, responseTimeoutUs);
+    }
+    Complete(id, std::move(result));
+}
+
+// Runs on the scheduler thread. Every pending transfer keeps this object referenced, so the
+// callback never outlives it; after close() the thread-safe function is aborted and drops it.
+void IsoTp::Complete(uint64_t id, IsoTpResult result) {
+    tsfn_.NonBlockingCall([this, id, result](Napi::Env env, Napi::Function) {
+        auto it = pending_.find(id);
+        if (it == pending_.end()) {
+            return;
+        }
+        Napi::Promise::Deferred deferred = it->second;
+        pending_.erase(it);
+        if (result.error.empty()) {
+            completed_++;
+            Napi::Value value = env.Undefined();
+            if (!result.data.empty()) {
+                value = Napi::Buffer<uint8_t>::Copy(env, result.data.data(), result.data.size());
+            }
+            deferred.Resolve(value);
+        } else {
+            failed_++;
+            deferred.Reject(Napi::Error::New(env, result.error).Value());
+        }
+        if (pending_.empty()) {
+            tsfn_.Unref(env);
+            Unref();
+        }
+    });
+}
+
+Napi::Value IsoTp::Stats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object stats = Napi::Object::New(env);
+    stats.Set("active", Napi::Number::New(env, static_cast<double>(scheduler_ ? scheduler_->ActiveSessions() : 0)));
+    stats.Set("pending", Napi::Number::New(env, static_cast<double>(pending_.size())));
+    stats.Set("completed", Napi::Number::New(env, static_cast<double>(completed_)));
+    stats.Set("failed", Napi::Number::New(env, static_cast<double>(failed_)));
+    return stats;
+}
+
+Napi::Value IsoTp::Close(const Napi::CallbackInfo& info) {
+    Shutdown();
+    bus_ref_.Reset();
+    return info.Env().Undefined();
+}
+
+void IsoTp::Shutdown() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+    if (scheduler_) {
+        scheduler_->Stop();
+    }
+    if (tsfn_) {
+        tsfn_.Abort();
+        tsfn_ = nullptr;
+    }
+    if (pending_.empty()) {
+        return;
+    }
+    Napi::Env env = Env();
+    for (auto& entry : pending_) {
+        failed_++;
+        entry.second.Reject(Napi::Error::New(env, "IsoTp closed").Value());
+    }
+    pending_.clear();
+    Unref();
+}
@@ -0,0 +1,55 @@
+#ifndef ACE_CAN_ISOTP_H
+#define ACE_CAN_ISOTP_H
+
+#include <napi.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "isotp_session.h"
+#include "session_scheduler.h"
+
+class CANBus;
+
+// Reads { blockSize, stMin, padding, timeoutMs } into `config`; throws and returns false if invalid.
+bool ReadIsoTpOptions(Napi::Env env, const Napi::Object& options, IsoTpConfig& config);
+
+// JS front end: every send()/request() is one session on a shared scheduler, so hundreds of
+// concurrent transfers (one per ECU) cost no threads of their own.
+class IsoTp : public Napi::ObjectWrap<IsoTp> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    IsoTp(const Napi::CallbackInfo& info);
+    ~IsoTp();
+
+    Napi::Value Send(const Napi::CallbackInfo& info);
+    Napi::Value Request(const Napi::CallbackInfo& info);
+    Napi::Value Stats(const Napi::CallbackInfo& info);
+    Napi::Value Close(const Napi::CallbackInfo& info);
+
+private:
+    static constexpr size_t kMaxPayload = 4095;
+
+    Napi::Value Start(const Napi::CallbackInfo& info, bool expectResponse);
+    SessionTask Run(uint64_t id, uint32_t txId, uint32_t rxId, std::vector<uint8_t> payload, bool expectResponse,
+                    int64_t responseTimeoutUs);
+    void Complete(uint64_t id, IsoTpResult result);
+    void Shutdown();
+
+    CANBus* bus_ = nullptr;
+    Napi::ObjectReference bus_ref_;
+    IsoTpConfig config_;
+    std::unique_ptr<SessionScheduler> scheduler_;
+    Napi::ThreadSafeFunction tsfn_;
+    bool closed_ = false;
+
+    // JS thread only.
+    uint64_t next_id_ = 1;
+    std::unordered_map<uint64_t, Napi::Promise::Deferred> pending_;
+    uint64_t completed_ = 0;
+    uint64_t failed_ = 0;
+};
+
+#endif // ACE_CAN_ISOTP_H
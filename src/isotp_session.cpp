@@ -0,0 +1,164 @@
+#include "isotp_session.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr int kMaxFlowControlWaits = 10;
+
+CanFrame MakeFrame(uint32_t id, uint8_t padding) {
+    CanFrame frame = {};
+    frame.id = id;
+    frame.flags = (id > 0x7FF) ? kFrameFlagExtended : 0;
+    frame.length = 8;
+    std::memset(frame.data, padding, 8);
+    return frame;
+}
+
+// STmin as sent in flow control: 0-127 ms, or 100-900 us for 0xF1-0xF9. Reserved values mean 127 ms.
+int64_t StMinToMicros(uint8_t stMin) {
+    if (stMin <= 0x7F) {
+        return static_cast<int64_t>(stMin) * 1000;
+    }
+    if (stMin >= 0xF1 && stMin <= 0xF9) {
+        return static_cast<int64_t>(stMin - 0xF0) * 100;
+    }
+    return 127000;
+}
+
+} // namespace
+
+Async<std::string> IsoTpSend(SessionScheduler& scheduler, const IsoTpConfig& config, uint32_t txId, uint32_t rxId,
+                             std::vector<uint8_t> payload) {
+    size_t size = payload.size();
+    CanFrame frame = MakeFrame(txId, config.padding);
+    if (size <= 7) {
+        frame.data[0] = static_cast<uint8_t>(size);
+        std::memcpy(frame.data + 1, payload.data(), size);
+        co_return scheduler.Transmit(frame);
+    }
+
+    frame.data[0] = static_cast<uint8_t>(0x10 | (size >> 8));
+    frame.data[1] = static_cast<uint8_t>(size);
+    std::memcpy(frame.data + 2, payload.data(), 6);
+    std::string error = scheduler.Transmit(frame);
+    if (!error.empty()) {
+        co_return error;
+    }
+
+    size_t offset = 6;
+    uint8_t sequence = 1;
+    while (offset < size) {
+        uint8_t blockSize = 0;
+        int64_t stMinUs = 0;
+        int waits = 0;
+        while (true) {
+            std::optional<CanFrame> flow = co_await scheduler.NextFrame(rxId, rxId > 0x7FF, config.timeout_us);
+            if (!flow) {
+                co_return "ISO-TP flow control timeout";
+            }
+            if (flow->length < 3 || (flow->data[0] & 0xF0) != 0x30) {
+                continue;
+            }
+            uint8_t status = flow->data[0] & 0x0F;
+            if (status == 0) {
+                blockSize = flow->data[1];
+                stMinUs = StMinToMicros(flow->data[2]);
+                break;
+            } else if (status == 1) {
+                if (++waits > kMaxFlowControlWaits) {
+                    co_return "ISO-TP receiver kept asking to wait";
+                }
+                continue;
+            }
+            co_return status == 2 ? "ISO-TP receiver overflow" : "ISO-TP invalid flow status";
+        }
+
+        for (uint32_t inBlock = 0; offset < size && (blockSize == 0 || inBlock < blockSize); ++inBlock) {
+            if (inBlock > 0) {
+                co_await scheduler.Sleep(stMinUs);
+            }
+            size_t chunk = std::min<size_t>(7, size - offset);
+            frame = MakeFrame(txId, config.padding);
+            frame.data[0] = static_cast<uint8_t>(0x20 | (sequence++ & 0x0F));
+            std::memcpy(frame.data + 1, payload.data() + offset, chunk);
+            offset += chunk;
+            error = scheduler.Transmit(frame);
+            if (!error.empty()) {
+                co_return error;
+            }
+        }
+    }
+    co_return std::string();
+}
+
+Async<IsoTpResult> IsoTpReceive(SessionScheduler& scheduler, const IsoTpConfig& config, uint32_t rxId, uint32_t txId,
+                                int64_t timeoutUs) {
+    IsoTpResult result;
+    bool rxExtended = rxId > 0x7FF;
+    size_t size = 0;
+    while (true) {
+        std::optional<CanFrame> first = co_await scheduler.NextFrame(rxId, rxExtended, timeoutUs);
+        if (!first) {
+            result.error = "ISO-TP response timeout";
+            co_return result;
+        }
+        if (first->length == 0) {
+            continue;
+        }
+        uint8_t type = first->data[0] >> 4;
+        if (type == 0) {
+            size = first->data[0] & 0x0F;
+            if (size == 0 || size >= first->length) {
+                result.error = "ISO-TP invalid single frame";
+                co_return result;
+            }
+            result.data.assign(first->data + 1, first->data + 1 + size);
+            co_return result;
+        } else if (type == 1 && first->length == 8) {
+            size = (static_cast<size_t>(first->data[0] & 0x0F) << 8) | first->data[1];
+            if (size < 8) {
+                result.error = "ISO-TP invalid first frame";
+                co_return result;
+            }
+            result.data.reserve(size);
+            result.data.assign(first->data + 2, first->data + 8);
+            break;
+        }
+        // Flow control or a stray consecutive frame does not start a message.
+    }
+
+    CanFrame flow = MakeFrame(txId, config.padding);
+    flow.data[0] = 0x30;
+    flow.data[1] = config.block_size;
+    flow.data[2] = config.st_min;
+    result.error = scheduler.Transmit(flow);
+    uint8_t expected = 1;
+    uint32_t inBlock = 0;
+    while (result.error.empty() && result.data.size() < size) {
+        std::optional<CanFrame> next = co_await scheduler.NextFrame(rxId, rxExtended, config.timeout_us);
+        if (!next) {
+            result.error = "ISO-TP consecutive frame timeout";
+            break;
+        }
+        if (next->length < 2 || (next->data[0] >> 4) != 2) {
+            continue;
+        }
+        if ((next->data[0] & 0x0F) != (expected & 0x0F)) {
+            result.error = "ISO-TP sequence error";
+            break;
+        }
+        expected++;
+        size_t chunk = std::min<size_t>({7, size - result.data.size(), static_cast<size_t>(next->length - 1)});
+        result.data.insert(result.data.end(), next->data + 1, next->data + 1 + chunk);
+        if (config.block_size != 0 && ++inBlock == config.block_size && result.data.size() < size) {
+            inBlock = 0;
+            result.error = scheduler.Transmit(flow);
+        }
+    }
+    if (!result.error.empty()) {
+        result.data.clear();
+    }
+    co_return result;
+}
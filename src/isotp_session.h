@@ -0,0 +1,30 @@
+#ifndef ACE_CAN_ISOTP_SESSION_H
+#define ACE_CAN_ISOTP_SESSION_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "session_scheduler.h"
+
+// ISO 15765-2 parameters for classic CAN frames with normal addressing.
+struct IsoTpConfig {
+    uint8_t block_size = 0; // BS we announce when receiving; 0 = no further flow control
+    uint8_t st_min = 0; // STmin we announce when receiving (raw ISO-TP encoding)
+    uint8_t padding = 0xCC;
+    int64_t timeout_us = 1000000; // N_Bs / N_Cr
+};
+
+struct IsoTpResult {
+    std::string error; // empty on success
+    std::vector<uint8_t> data;
+};
+
+// Segmented transfers as scheduler coroutines. Send waits for flow control and paces consecutive
+// frames by the receiver's STmin; Receive reassembles one message, sending flow control itself.
+Async<std::string> IsoTpSend(SessionScheduler& scheduler, const IsoTpConfig& config, uint32_t txId, uint32_t rxId,
+                             std::vector<uint8_t> payload);
+Async<IsoTpResult> IsoTpReceive(SessionScheduler& scheduler, const IsoTpConfig& config, uint32_t rxId, uint32_t txId,
+                                int64_t timeoutUs);
+
+#endif // ACE_CAN_ISOTP_SESSION_H
@@ -0,0 +1,74 @@
+#ifndef ACE_CAN_JS_MAILBOX_H
+#define ACE_CAN_JS_MAILBOX_H
+
+#include <napi.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Values produced on a native thread and waiting for one JS callback. Values posted while a
+// delivery is already scheduled ride along with it, so a burst costs one thread hop; past
+// `capacity` waiting values, new ones are counted as dropped. The queue is shared with the
+// scheduled callbacks so they stay valid even if the owner is collected first.
+template <typename T>
+class JsMailbox {
+public:
+    explicit JsMailbox(size_t capacity) : state_(std::make_shared<State>()) { state_->capacity = capacity; }
+
+    // Queues `value` for `tsfn`, whose callback receives toJs(env, value) for each queued value in
+    // order. Does nothing while `tsfn` is unset.
+    template <typename ToJs>
+    void Post(Napi::ThreadSafeFunction& tsfn, const T& value, ToJs toJs) {
+        if (!tsfn) {
+            return;
+        }
+        std::shared_ptr<State> state = state_;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->values.size() >= state->capacity) {
+                state->dropped++;
+                return;
+            }
+            state->values.push_back(value);
+            if (state->scheduled) {
+                return;
+            }
+            state->scheduled = true;
+        }
+        tsfn.NonBlockingCall([state, toJs = std::move(toJs)](Napi::Env env, Napi::Function jsCallback) {
+            std::vector<T> values;
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                values.swap(state->values);
+                state->scheduled = false;
+            }
+            for (const T& queued : values) {
+                jsCallback.Call({toJs(env, queued)});
+                if (env.IsExceptionPending()) {
+                    break;
+                }
+            }
+        });
+    }
+
+    uint64_t Dropped() const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->dropped;
+    }
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::vector<T> values;
+        size_t capacity = 0;
+        bool scheduled = false;
+        uint64_t dropped = 0;
+    };
+
+    std::shared_ptr<State> state_;
+};
+
+#endif // ACE_CAN_JS_MAILBOX_H
@@ -0,0 +1,74 @@
+#ifndef ACE_CAN_LATENCY_HISTOGRAM_H
+#define ACE_CAN_LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Log-linear latency histogram: exact below 16 us, then 16 buckets per power of two
+// (at most 6.25 % relative error). Fixed size, so recording never allocates.
+class LatencyHistogram {
+public:
+    void Record(int64_t us) {
+        uint64_t value = us > 0 ? static_cast<uint64_t>(us) : 0;
+        counts_[std::min(BucketOf(value), kBuckets - 1)]++;
+        min_ = count_ == 0 ? value : std::min(min_, value);
+        max_ = std::max(max_, value);
+        sum_ += static_cast<double>(value);
+        count_++;
+    }
+
+    // The bucket midpoint holding the given rank, clamped to the recorded range.
+    uint64_t Percentile(double fraction) const {
+        if (count_ == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(count_ - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t bucket = 0; bucket < kBuckets; ++bucket) {
+            seen += counts_[bucket];
+            if (seen >= rank) {
+                return std::min(std::max(BucketMidpoint(bucket), min_), max_);
+            }
+        }
+        return max_;
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t min() const { return min_; }
+    uint64_t max() const { return max_; }
+    double mean() const { return count_ > 0 ? sum_ / static_cast<double>(count_) : 0; }
+
+private:
+    static constexpr size_t kBuckets = 16 * 40;
+
+    static size_t BucketOf(uint64_t value) {
+        if (value < 16) {
+            return static_cast<size_t>(value);
+        }
+        int msb = 63;
+        while ((value >> msb) == 0) {
+            --msb;
+        }
+        int shift = msb - 4;
+        return static_cast<size_t>(shift + 1) * 16 + static_cast<size_t>((value >> shift) & 15);
+    }
+
+    static uint64_t BucketMidpoint(size_t bucket) {
+        if (bucket < 16) {
+            return bucket;
+        }
+        size_t shift = bucket / 16 - 1;
+        uint64_t lower = static_cast<uint64_t>(16 + bucket % 16) << shift;
+        return lower + ((uint64_t{1} << shift) >> 1);
+    }
+
+    std::array<uint64_t, kBuckets> counts_{};
+    uint64_t count_ = 0;
+    uint64_t min_ = 0;
+    uint64_t max_ = 0;
+    double sum_ = 0;
+};
+
+#endif // ACE_CAN_LATENCY_HISTOGRAM_H
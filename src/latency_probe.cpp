@@ -0,0 +1,338 @@
+#include "latency_probe.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "ace_can.h"
+#include "napi_options.h"
+#include "timed_tx.h"
+
+namespace {
+
+constexpr uint32_t kMaxRateHz = 10000;
+
+Napi::Object HistogramToJs(Napi::Env env, const LatencyHistogram& histogram) {
+    Napi::Object stats = Napi::Object::New(env);
+    stats.Set("count", Napi::Number::New(env, static_cast<double>(histogram.count())));
+    stats.Set("min", Napi::Number::New(env, static_cast<double>(histogram.min())));
+    stats.Set("mean", Napi::Number::New(env, histogram.mean()));
+    stats.Set("p50", Napi::Number::New(env, static_cast<double>(histogram.Percentile(0.50))));
+    stats.Set("p90", Napi::Number::New(env, static_cast<double>(histogram.Percentile(0.90))));
+    stats.Set("p99", Napi::Number::New(env, static_cast<double>(histogram.Percentile(0.99))));
+    stats.Set("p999", Napi::Number::New(env, static_cast<double>(histogram.Percentile(0.999))));
+    stats.Set("max", Napi::Number::New(env, static_cast<double>(histogram.max())));
+    return stats;
+}
+
+} // namespace
+
+Napi::Object LatencyProbe::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "LatencyProbe", {
+        InstanceMethod("run", &LatencyProbe::Run),
+        InstanceMethod("stop", &LatencyProbe::Stop),
+        InstanceMethod("results", &LatencyProbe::Results),
+    });
+    exports.Set("LatencyProbe", func);
+    return exports;
+}
+
+LatencyProbe::LatencyProbe(const Napi::CallbackInfo& info) : Napi::ObjectWrap<LatencyProbe>(info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 3 || !info[2].IsObject()) {
+        Napi::TypeError::New(env, "Expected txBus, rxBus, options").ThrowAsJavaScriptException();
+        return;
+    }
+    tx_bus_ = CANBus::FromValue(env, info[0]);
+    rx_bus_ = CANBus::FromValue(env, info[1]);
+    if (tx_bus_ == nullptr || rx_bus_ == nullptr) {
+        Napi::TypeError::New(env, "txBus and rxBus must be CANBus instances").ThrowAsJavaScriptException();
+        return;
+    }
+
+    Napi::Object options = info[2].As<Napi::Object>();
+    if (!options.Has("requestId") || !options.Get("requestId").IsNumber()) {
+        Napi::TypeError::New(env, "requestId must be a number").ThrowAsJavaScriptException();
+        return;
+    }
+    request_id_ = options.Get("requestId").As<Napi::Number>().Uint32Value();
+    response_id_ = request_id_;
+    uint32_t payloadLength = payload_length_;
+    if (!GetOptionalUint32(options, "responseId", response_id_) || !GetOptionalUint32(options, "rateHz", rate_hz_) ||
+        !GetOptionalUint32(options, "count", count_) || !GetOptionalUint32(options, "timeoutMs", timeout_ms_) ||
+        !GetOptionalUint32(options, "payloadLength", payloadLength)) {
+        Napi::TypeError::New(env, "Invalid latency probe option type").ThrowAsJavaScriptException();
+        return;
+    }
+    if (rate_hz_ == 0 || rate_hz_ > kMaxRateHz) {
+        Napi::RangeError::New(env, "rateHz must be between 1 and 10000").ThrowAsJavaScriptException();
+        return;
+    }
+    if (payloadLength < 4 || payloadLength > 64) {
+        Napi::RangeError::New(env, "payloadLength must be between 4 and 64").ThrowAsJavaScriptException();
+        return;
+    }
+    payload_length_ = static_cast<uint8_t>(payloadLength);
+
+    tx_ref_ = Napi::Persistent(info[0].As<Napi::Object>());
+    rx_ref_ = Napi::Persistent(info[1].As<Napi::Object>());
+    tap_ = std::make_shared<Tap>(this);
+}
+
+LatencyProbe::~LatencyProbe() {
+    Shutdown();
+}
+
+// Starts a measurement run; the promise resolves with the results once every request has been
+// answered or timed out, or after stop().
+Napi::Value LatencyProbe::Run(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (deferred_) {
+        Napi::Error::New(env, "Latency probe already running").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (send_thread_.joinable()) {
+        send_thread_.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_sent_us_.fill(0);
+        inflight_used_.fill(false);
+        undelivered_.clear();
+        sent_ = 0;
+        send_errors_ = 0;
+        last_error_.clear();
+        running_ = true;
+    }
+    received_ = 0;
+    tx_ = LatencyHistogram();
+    driver_ = LatencyHistogram();
+    addon_ = LatencyHistogram();
+    js_ = LatencyHistogram();
+    total_ = LatencyHistogram();
+
+    deferred_ = std::make_unique<Napi::Promise::Deferred>(Napi::Promise::Deferred::New(env));
+    Napi::Value promise = deferred_->Promise();
+    tsfn_ = Napi::ThreadSafeFunction::New(env, Napi::Function::New(env, [](const Napi::CallbackInfo&) {}),
+                                          "LatencyProbe", 0, 1);
+    Ref();
+    rx_bus_->AddTap(tap_);
+    send_thread_ = std::thread([this]() { SendLoop(); });
+    return promise;
+}
+
+Napi::Value LatencyProbe::Stop(const Napi::CallbackInfo& info) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    return info.Env().Undefined();
+}
+
+Napi::Value LatencyProbe::Results(const Napi::CallbackInfo& info) {
+    return BuildResults(info.Env());
+}
+
+void LatencyProbe::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (send_thread_.joinable()) {
+        send_thread_.join();
+    }
+    if (rx_bus_ != nullptr && tap_) {
+        rx_bus_->RemoveTap(tap_.get());
+        tap_->Detach();
+    }
+}
+
+void LatencyProbe::SendLoop() {
+    const auto period = std::chrono::nanoseconds(1000000000LL / rate_hz_);
+    const auto start = std::chrono::steady_clock::now();
+    CanFrame frame = {};
+    frame.id = request_id_;
+    frame.flags = (request_id_ > 0x7FF) ? kFrameFlagExtended : 0;
+    frame.length = payload_length_;
+
+    for (uint32_t sequence = 0; sequence < count_; ++sequence) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait_until(lock, start + period * sequence, [this]() { return !running_; });
+            if (!running_) {
+                break;
+            }
+        }
+        frame.data[0] = static_cast<uint8_t>(sequence);
+        frame.data[1] = static_cast<uint8_t>(sequence >> 8);
+        frame.data[2] = static_cast<uint8_t>(sequence >> 16);
+        frame.data[3] = static_cast<uint8_t>(sequence >> 24);
+
+        size_t slot = sequence % kPendingWindow;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_sequence_[slot] = sequence;
+            pending_sent_us_[slot] = HostMicros();
+        }
+        std::string error = tx_bus_->TransmitRaw(frame);
+        std::lock_guard<std::mutex> lock(mutex_);
+        sent_++;
+        if (!error.empty()) {
+            pending_sent_us_[slot] = 0;
+            send_errors_++;
+            last_error_ = error;
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms_), [this]() { return !running_; });
+        running_ = false;
+    }
+    rx_bus_->RemoveTap(tap_.get());
+
+    // Responses still on their way to rx_bus_'s listener after the timeout count as undelivered.
+    tsfn_.NonBlockingCall([this](Napi::Env env, Napi::Function) {
+        RecordUndelivered();
+        deferred_->Resolve(BuildResults(env));
+        deferred_.reset();
+        Unref();
+    });
+    tsfn_.Release();
+}
+
+// The sequence number a response frame carries in its first four bytes.
+bool LatencyProbe::ResponseSequence(const CanFrame& frame, uint32_t& sequence) const {
+    if (frame.id != response_id_ || frame.length < 4) {
+        return false;
+    }
+    sequence = static_cast<uint32_t>(frame.data[0]) | (static_cast<uint32_t>(frame.data[1]) << 8) |
+               (static_cast<uint32_t>(frame.data[2]) << 16) | (static_cast<uint32_t>(frame.data[3]) << 24);
+    return true;
+}
+
+// Runs on the receive thread of rx_bus_, for every frame.
+void LatencyProbe::OnFrame(const CanFrame& frame, int64_t hostUs) {
+    uint32_t sequence;
+    if (!ResponseSequence(frame, sequence)) {
+        return;
+    }
+    size_t slot = sequence % kPendingWindow;
+    Sample sample = {};
+    sample.sequence = sequence;
+    sample.read_us = hostUs;
+    sample.queued_us = -1;
+    if (!rx_bus_->DeviceToHost(frame.timestamp, sample.wire_us)) {
+        sample.wire_us = -1;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_sent_us_[slot] == 0 || pending_sequence_[slot] != sequence) {
+        return;
+    }
+    sample.sent_us = pending_sent_us_[slot];
+    pending_sent_us_[slot] = 0;
+    if (inflight_used_[slot]) {
+        undelivered_.push_back(inflight_[slot]);
+    }
+    inflight_[slot] = sample;
+    inflight_used_[slot] = true;
+}
+
+// Runs on the receive thread of rx_bus_, for frames that passed its filters and stages.
+void LatencyProbe::OnQueued(const CanFrame& frame, int64_t hostUs) {
+    uint32_t sequence;
+    if (!ResponseSequence(frame, sequence)) {
+        return;
+    }
+    size_t slot = sequence % kPendingWindow;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (inflight_used_[slot] && inflight_[slot].sequence == sequence && inflight_[slot].queued_us < 0) {
+        inflight_[slot].queued_us = hostUs;
+    }
+}
+
+// Runs on the JS thread, just before rx_bus_'s 'message' listener sees the frame.
+void LatencyProbe::OnDelivered(const CanFrame& frame, int64_t hostUs) {
+    uint32_t sequence;
+    if (!ResponseSequence(frame, sequence)) {
+        return;
+    }
+    size_t slot = sequence % kPendingWindow;
+    Sample sample;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!inflight_used_[slot] || inflight_[slot].sequence != sequence) {
+            return;
+        }
+        sample = inflight_[slot];
+        inflight_used_[slot] = false;
+    }
+    if (sample.queued_us < 0) {
+        sample.queued_us = hostUs; // poll receive mode reads on the JS thread and has no queue
+    }
+    Record(sample, hostUs);
+}
+
+void LatencyProbe::Record(const Sample& sample, int64_t jsUs) {
+    received_++;
+    if (sample.wire_us >= 0) {
+        tx_.Record(sample.wire_us - sample.sent_us);
+        driver_.Record(sample.read_us - sample.wire_us);
+    }
+    addon_.Record(sample.queued_us - sample.read_us);
+    js_.Record(jsUs - sample.queued_us);
+    total_.Record(jsUs - sample.sent_us);
+}
+
+// Responses that were read but never reached JS (filtered out, or no 'message' listener) count as
+// received with their tx and driver components only.
+void LatencyProbe::RecordUndelivered() {
+    std::vector<Sample> samples;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        samples.swap(undelivered_);
+        for (size_t slot = 0; slot < kPendingWindow; ++slot) {
+            if (inflight_used_[slot]) {
+                samples.push_back(inflight_[slot]);
+                inflight_used_[slot] = false;
+            }
+        }
+    }
+    for (const Sample& sample : samples) {
+        received_++;
+        if (sample.wire_us >= 0) {
+            tx_.Record(sample.wire_us - sample.sent_us);
+            driver_.Record(sample.read_us - sample.wire_us);
+        }
+    }
+}
+
+Napi::Object LatencyProbe::BuildResults(Napi::Env env) const {
+    uint32_t sent = 0;
+    uint32_t errors = 0;
+    std::string lastError;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sent = sent_;
+        errors = send_errors_;
+        lastError = last_error_;
+    }
+    Napi::Object results = Napi::Object::New(env);
+    results.Set("sent", Napi::Number::New(env, sent));
+    results.Set("received", Napi::Number::New(env, received_));
+    results.Set("lost", Napi::Number::New(env, sent >= errors + received_ ? sent - errors - received_ : 0));
+    results.Set("errors", Napi::Number::New(env, errors));
+    if (!lastError.empty()) {
+        results.Set("lastError", Napi::String::New(env, lastError));
+    }
+    Napi::Object components = Napi::Object::New(env);
+    components.Set("tx", HistogramToJs(env, tx_));
+    components.Set("driver", HistogramToJs(env, driver_));
+    components.Set("addon", HistogramToJs(env, addon_));
+    components.Set("js", HistogramToJs(env, js_));
+    components.Set("total", HistogramToJs(env, total_));
+    results.Set("components", components);
+    return results;
+}
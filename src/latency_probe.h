@@ -0,0 +1,113 @@
+#ifndef ACE_CAN_LATENCY_PROBE_H
+#define ACE_CAN_LATENCY_PROBE_H
+
+#include <napi.h>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_tap.h"
+#include "latency_histogram.h"
+
+class CANBus;
+
+// Sends sequence-numbered request frames on one bus and times the matching frames arriving on
+// another (or the same bus, from an echoing ECU). Each round trip is split into components:
+//   tx     send call -> frame on the bus (receiving device timestamp mapped to host time)
+//   driver frame on the bus -> read from the driver by the receive thread
+//   addon  read -> filtered, staged and handed to the JS thread queue
+//   js     queued -> about to reach rx_bus_'s 'message' listener on the JS thread
+// The last two need a 'message' listener on rx_bus_; without one (or for frames it filters out)
+// only tx and driver are recorded.
+class LatencyProbe : public Napi::ObjectWrap<LatencyProbe> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    LatencyProbe(const Napi::CallbackInfo& info);
+    ~LatencyProbe();
+
+    Napi::Value Run(const Napi::CallbackInfo& info);
+    Napi::Value Stop(const Napi::CallbackInfo& info);
+    Napi::Value Results(const Napi::CallbackInfo& info);
+
+private:
+    struct Sample {
+        uint32_t sequence;
+        int64_t sent_us;
+        int64_t wire_us; // receiving device timestamp on the host clock, or -1 if unknown
+        int64_t read_us;
+        int64_t queued_us; // -1 until queued for JS
+    };
+
+    class Tap : public FrameTap {
+    public:
+        explicit Tap(LatencyProbe* probe) : probe_(probe) {}
+        void OnFrame(const CanFrame& frame, int64_t hostUs) override { probe_->OnFrame(frame, hostUs); }
+        void OnQueued(const CanFrame& frame, int64_t hostUs) override { probe_->OnQueued(frame, hostUs); }
+        void OnDelivered(const CanFrame& frame, int64_t hostUs) override {
+            if (probe_ != nullptr) {
+                probe_->OnDelivered(frame, hostUs);
+            }
+        }
+        // Deliveries already queued on the JS thread outlive the probe.
+        void Detach() { probe_ = nullptr; }
+
+    private:
+        LatencyProbe* probe_;
+    };
+
+    static constexpr size_t kPendingWindow = 4096;
+
+    bool ResponseSequence(const CanFrame& frame, uint32_t& sequence) const;
+    void OnFrame(const CanFrame& frame, int64_t hostUs);
+    void OnQueued(const CanFrame& frame, int64_t hostUs);
+    void OnDelivered(const CanFrame& frame, int64_t hostUs);
+    void SendLoop();
+    void Shutdown();
+    void Record(const Sample& sample, int64_t jsUs);
+    void RecordUndelivered();
+    Napi::Object BuildResults(Napi::Env env) const;
+
+    CANBus* tx_bus_ = nullptr;
+    CANBus* rx_bus_ = nullptr;
+    Napi::ObjectReference tx_ref_;
+    Napi::ObjectReference rx_ref_;
+    uint32_t request_id_ = 0;
+    uint32_t response_id_ = 0;
+    uint32_t rate_hz_ = 100;
+    uint32_t count_ = 1000;
+    uint32_t timeout_ms_ = 1000;
+    uint8_t payload_length_ = 8;
+
+    std::shared_ptr<Tap> tap_;
+    std::thread send_thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_ = false;
+    std::array<int64_t, kPendingWindow> pending_sent_us_{}; // by sequence % window, 0 = free
+    std::array<uint32_t, kPendingWindow> pending_sequence_{};
+    std::array<Sample, kPendingWindow> inflight_{}; // read, not yet delivered; by sequence % window
+    std::array<bool, kPendingWindow> inflight_used_{};
+    std::vector<Sample> undelivered_; // pushed out of inflight_ by a newer response
+    uint32_t sent_ = 0;
+    uint32_t send_errors_ = 0;
+    std::string last_error_;
+
+    Napi::ThreadSafeFunction tsfn_;
+    std::unique_ptr<Napi::Promise::Deferred> deferred_;
+
+    // Only touched on the JS thread.
+    uint32_t received_ = 0;
+    LatencyHistogram tx_;
+    LatencyHistogram driver_;
+    LatencyHistogram addon_;
+    LatencyHistogram js_;
+    LatencyHistogram total_;
+};
+
+#endif // ACE_CAN_LATENCY_PROBE_H
@@ -0,0 +1,772 @@
+#include "log_file.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+constexpr size_t kReadBufferSize = 1 << 16;
+constexpr uint32_t kPcapMagicMicros = 0xA1B2C3D4u;
+constexpr uint32_t kPcapMagicNanos = 0xA1B23C4Du;
+constexpr uint32_t kPcapLinkTypeSocketCan = 227;
+constexpr uint32_t kPcapMaxRecord = 1 << 18;
+constexpr uint32_t kSocketCanEffFlag = 0x80000000u;
+constexpr uint32_t kSocketCanRtrFlag = 0x40000000u;
+constexpr uint32_t kSocketCanErrFlag = 0x20000000u;
+constexpr double kTrcUnixEpochDays = 25569.0; // 1970-01-01 as an OLE automation date
+
+uint32_t ByteSwap32(uint32_t v) {
+    return ((v & 0x000000FFu) << 24) | ((v & 0x0000FF00u) << 8) | ((v & 0x00FF0000u) >> 8) | ((v & 0xFF000000u) >> 24);
+}
+
+char* NextToken(char*& cursor) {
+    while (*cursor == ' ' || *cursor == '\t') {
+        ++cursor;
+    }
+    if (*cursor == '\0') {
+        return nullptr;
+    }
+    char* start = cursor;
+    while (*cursor != '\0' && *cursor != ' ' && *cursor != '\t') {
+        ++cursor;
+    }
+    if (*cursor != '\0') {
+        *cursor++ = '\0';
+    }
+    return start;
+}
+
+int HexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool ParseUnsigned(const char* text, int base, uint32_t& out) {
+    if (text == nullptr || *text == '\0') {
+        return false;
+    }
+    char* end = nullptr;
+    unsigned long value = std::strtoul(text, &end, base);
+    if (end == text || *end != '\0') {
+        return false;
+    }
+    out = static_cast<uint32_t>(value);
+    return true;
+}
+
+std::string Lowercase(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+} // namespace
+
+bool LogFile::ParseFormat(const std::string& name, Format& out) {
+    std::string lowered = Lowercase(name);
+    if (lowered == "asc") {
+        out = Format::Asc;
+    } else if (lowered == "log" || lowered == "candump") {
+        out = Format::Candump;
+    } else if (lowered == "pcap") {
+        out = Format::Pcap;
+    } else if (lowered == "trc") {
+        out = Format::Trc;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// An explicit format name must be known; without one the file extension decides, and files with
+// an unknown extension are recognized by their first bytes.
+bool LogFile::Open(const std::string& path, const std::string& format, std::string& error) {
+    Close();
+    std::string formatName = format;
+    if (formatName.empty()) {
+        size_t dot = path.find_last_of('.');
+        if (dot != std::string::npos) {
+            formatName = path.substr(dot + 1);
+        }
+    }
+    bool sniff = !ParseFormat(formatName, format_);
+    if (sniff && !format.empty()) {
+        error = "Unsupported log format: " + formatName;
+        return false;
+    }
+    if (!OpenFile(path, error)) {
+        return false;
+    }
+
+    if (sniff) {
+        uint32_t magic = 0;
+        if (buffer_len_ >= sizeof(magic)) {
+            std::memcpy(&magic, buffer_.data(), sizeof(magic));
+        }
+        if (magic == kPcapMagicMicros || magic == kPcapMagicNanos ||
+            ByteSwap32(magic) == kPcapMagicMicros || ByteSwap32(magic) == kPcapMagicNanos) {
+            format_ = Format::Pcap;
+        } else if (buffer_len_ > 0 && buffer_[0] == '(') {
+            format_ = Format::Candump;
+        } else if (buffer_len_ > 0 && buffer_[0] == ';') {
+            format_ = Format::Trc;
+        } else {
+            format_ = Format::Asc;
+        }
+    }
+
+    if (format_ == Format::Pcap && !ReadPcapHeader(error)) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+LogFile::~LogFile() {
+    Close();
+}
+
+bool LogFile::OpenFile(const std::string& path, std::string& error) {
+    file_ = std::fopen(path.c_str(), "rb");
+    if (file_ == nullptr) {
+        error = "Failed to open log file: " + path;
+        return false;
+    }
+    buffer_.assign(kReadBufferSize, '\0');
+    buffer_pos_ = 0;
+    buffer_len_ = 0;
+    eof_ = false;
+    asc_hex_ = true;
+    trc_version_ = 10;
+    trc_columns_.clear();
+    trc_start_us_ = 0;
+    Fill();
+    return true;
+}
+
+void LogFile::Close() {
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    eof_ = true;
+    buffer_pos_ = 0;
+    buffer_len_ = 0;
+}
+
+bool LogFile::Fill() {
+    if (eof_ || file_ == nullptr) {
+        return false;
+    }
+    if (buffer_pos_ > 0) {
+        std::memmove(buffer_.data(), buffer_.data() + buffer_pos_, buffer_len_ - buffer_pos_);
+        buffer_len_ -= buffer_pos_;
+        buffer_pos_ = 0;
+    }
+    if (buffer_len_ + 1 >= buffer_.size()) {
+        buffer_.resize(buffer_.size() * 2);
+    }
+    size_t n = std::fread(buffer_.data() + buffer_len_, 1, buffer_.size() - buffer_len_ - 1, file_);
+    if (n == 0) {
+        eof_ = true;
+        return false;
+    }
+    buffer_len_ += n;
+    return true;
+}
+
+bool LogFile::NextLine(char*& line) {
+    for (;;) {
+        char* start = buffer_.data() + buffer_pos_;
+        size_t avail = buffer_len_ - buffer_pos_;
+        char* newline = static_cast<char*>(std::memchr(start, '\n', avail));
+        if (newline) {
+            *newline = '\0';
+            if (newline > start && newline[-1] == '\r') {
+                newline[-1] = '\0';
+            }
+            line = start;
+            buffer_pos_ += static_cast<size_t>(newline - start) + 1;
+            return true;
+        }
+        if (!Fill()) {
+            if (buffer_pos_ < buffer_len_) {
+                buffer_[buffer_len_] = '\0';
+                line = buffer_.data() + buffer_pos_;
+                buffer_pos_ = buffer_len_;
+                return true;
+            }
+            return false;
+        }
+    }
+}
+
+bool LogFile::ReadExact(void* out, size_t nbytes) {
+    while (buffer_len_ - buffer_pos_ < nbytes) {
+        if (!Fill()) {
+            return false;
+        }
+    }
+    std::memcpy(out, buffer_.data() + buffer_pos_, nbytes);
+    buffer_pos_ += nbytes;
+    return true;
+}
+
+size_t LogFile::ReadFrames(CanFrame* out, size_t max) {
+    size_t count = 0;
+    if (file_ == nullptr) {
+        return 0;
+    }
+    if (format_ == Format::Pcap) {
+        while (count < max) {
+            bool skipped = false;
+            if (!ReadPcapRecord(out[count], skipped)) {
+                break;
+            }
+            if (!skipped) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    char* line = nullptr;
+    while (count < max && NextLine(line)) {
+        bool parsed = false;
+        switch (format_) {
+            case Format::Asc: parsed = ParseAscLine(line, out[count]); break;
+            case Format::Candump: parsed = ParseCandumpLine(line, out[count]); break;
+            case Format::Trc: parsed = ParseTrcLine(line, out[count]); break;
+            case Format::Pcap: break;
+        }
+        if (parsed) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+// Vector ASCII logs:
+//   <time> <ch> <id>[x] <Rx|Tx> <d|r> <dlc> <data...>
+//   <time> <ch> ErrorFrame
+//   <time> CANFD <ch> <Rx|Tx> <id>[x] [name] <brs> <esi> <dlc> <len> <data...>
+bool LogFile::ParseAscLine(char* line, CanFrame& frame) {
+    char* cursor = line;
+    char* first = NextToken(cursor);
+    if (first == nullptr) {
+        return false;
+    }
+    if (!std::isdigit(static_cast<unsigned char>(first[0]))) {
+        if (std::strcmp(first, "base") == 0) {
+            char* base = NextToken(cursor);
+            if (base) {
+                asc_hex_ = std::strcmp(base, "dec") != 0;
+            }
+        }
+        return false;
+    }
+
+    char* end = nullptr;
+    double seconds = std::strtod(first, &end);
+    if (end == first) {
+        return false;
+    }
+    std::memset(&frame, 0, sizeof(frame));
+    frame.timestamp = static_cast<uint64_t>(seconds * 1e6 + 0.5);
+
+    char* token = NextToken(cursor);
+    if (token == nullptr) {
+        return false;
+    }
+    bool fd = std::strcmp(token, "CANFD") == 0;
+    if (fd) {
+        token = NextToken(cursor);
+    }
+    uint32_t channel = 0;
+    if (!ParseUnsigned(token, 10, channel)) {
+        return false;
+    }
+    frame.channel = static_cast<uint16_t>(channel > 0 ? channel - 1 : 0);
+
+    char* idToken = nullptr;
+    char* direction = nullptr;
+    if (fd) {
+        direction = NextToken(cursor);
+        idToken = NextToken(cursor);
+    } else {
+        idToken = NextToken(cursor);
+        if (idToken && std::strcmp(idToken, "ErrorFrame") == 0) {
+            frame.flags = kFrameFlagError;
+            return true;
+        }
+        direction = NextToken(cursor);
+    }
+    if (idToken == nullptr || direction == nullptr) {
+        return false;
+    }
+    if (std::strcmp(direction, "Tx") == 0) {
+        frame.flags |= kFrameFlagTx;
+    } else if (std::strcmp(direction, "Rx") != 0) {
+        return false;
+    }
+
+    size_t idLength = std::strlen(idToken);
+    if (idLength > 0 && (idToken[idLength - 1] == 'x' || idToken[idLength - 1] == 'X')) {
+        idToken[idLength - 1] = '\0';
+        frame.flags |= kFrameFlagExtended;
+    }
+    if (!ParseUnsigned(idToken, asc_hex_ ? 16 : 10, frame.id)) {
+        return false;
+    }
+
+    uint32_t length = 0;
+    if (fd) {
+        char* brs = NextToken(cursor);
+        if (brs && std::strcmp(brs, "0") != 0 && std::strcmp(brs, "1") != 0) {
+            brs = NextToken(cursor); // symbolic message name
+        }
+        char* esi = NextToken(cursor);
+        char* dlc = NextToken(cursor);
+        char* len = NextToken(cursor);
+        uint32_t dlcValue = 0;
+        if (brs == nullptr || esi == nullptr || !ParseUnsigned(dlc, 16, dlcValue) || !ParseUnsigned(len, 10, length)) {
+            return false;
+        }
+        frame.flags |= kFrameFlagFd;
+        if (brs[0] == '1') frame.flags |= kFrameFlagBrs;
+        if (esi[0] == '1') frame.flags |= kFrameFlagEsi;
+        length = std::min<uint32_t>(length, 64);
+    } else {
+        char* kind = NextToken(cursor);
+        char* dlc = NextToken(cursor);
+        if (kind == nullptr || !ParseUnsigned(dlc, 16, length)) {
+            return false;
+        }
+        length = std::min<uint32_t>(length, 8);
+        if (kind[0] == 'r') {
+            frame.flags |= kFrameFlagRemote;
+            frame.length = static_cast<uint8_t>(length);
+            return true;
+        }
+    }
+
+    for (uint32_t i = 0; i < length; ++i) {
+        uint32_t value = 0;
+        if (!ParseUnsigned(NextToken(cursor), asc_hex_ ? 16 : 10, value)) {
+            return false;
+        }
+        frame.data[i] = static_cast<uint8_t>(value);
+    }
+    frame.length = static_cast<uint8_t>(length);
+    return true;
+}
+
+// candump -l logs:
+//   (<sec>.<usec>) <iface> <id>#<data> [T|R]
+//   (<sec>.<usec>) <iface> <id>##<flags><data>
+//   (<sec>.<usec>) <iface> <id>#R[<dlc>]
+bool LogFile::ParseCandumpLine(char* line, CanFrame& frame) {
+    char* cursor = line;
+    char* stamp = NextToken(cursor);
+    char* iface = NextToken(cursor);
+    char* body = NextToken(cursor);
+    if (stamp == nullptr || iface == nullptr || body == nullptr || stamp[0] != '(') {
+        return false;
+    }
+
+    std::memset(&frame, 0, sizeof(frame));
+    char* end = nullptr;
+    double seconds = std::strtod(stamp + 1, &end);
+    if (end == stamp + 1) {
+        return false;
+    }
+    frame.timestamp = static_cast<uint64_t>(seconds * 1e6 + 0.5);
+
+    size_t ifaceLength = std::strlen(iface);
+    size_t digits = ifaceLength;
+    while (digits > 0 && std::isdigit(static_cast<unsigned char>(iface[digits - 1]))) {
+        --digits;
+    }
+    if (digits < ifaceLength) {
+        frame.channel = static_cast<uint16_t>(std::strtoul(iface + digits, nullptr, 10));
+    }
+
+    char* hash = std::strchr(body, '#');
+    if (hash == nullptr) {
+        return false;
+    }
+    *hash = '\0';
+    size_t idLength = std::strlen(body);
+    if (!ParseUnsigned(body, 16, frame.id)) {
+        return false;
+    }
+    if (idLength > 3) {
+        if (frame.id & kSocketCanErrFlag) {
+            frame.flags |= kFrameFlagError;
+        }
+        frame.id &= 0x1FFFFFFFu;
+        frame.flags |= kFrameFlagExtended;
+    }
+
+    char* data = hash + 1;
+    size_t maxLength = 8;
+    if (*data == '#') {
+        int flags = HexDigit(data[1]);
+        if (flags < 0) {
+            return false;
+        }
+        frame.flags |= kFrameFlagFd;
+        if (flags & 0x01) frame.flags |= kFrameFlagBrs;
+        if (flags & 0x02) frame.flags |= kFrameFlagEsi;
+        data += 2;
+        maxLength = 64;
+    } else if (*data == 'R' || *data == 'r') {
+        frame.flags |= kFrameFlagRemote;
+        int dlc = HexDigit(data[1]);
+        frame.length = static_cast<uint8_t>(dlc > 0 ? std::min(dlc, 8) : 0);
+        data = nullptr;
+    }
+
+    if (data) {
+        size_t length = 0;
+        while (data[0] != '\0' && length < maxLength) {
+            if (data[0] == '.') {
+                ++data;
+                continue;
+            }
+            int hi = HexDigit(data[0]);
+            int lo = HexDigit(data[1]);
+            if (hi < 0 || lo < 0) {
+                return false;
+            }
+            frame.data[length++] = static_cast<uint8_t>((hi << 4) | lo);
+            data += 2;
+        }
+        frame.length = static_cast<uint8_t>(length);
+    }
+
+    char* direction = NextToken(cursor);
+    if (direction && direction[0] == 'T') {
+        frame.flags |= kFrameFlagTx;
+    }
+    return true;
+}
+
+// PCAN trace header lines of interest:
+//   ;$FILEVERSION=2.1
+//   ;$STARTTIME=43882.6543  (days since 1899-12-30)
+//   ;$COLUMNS=N,O,T,B,I,d,R,L,D
+void LogFile::ParseTrcHeader(const char* line) {
+    const char* key = std::strchr(line, '$');
+    if (key == nullptr) {
+        return;
+    }
+    if (std::strncmp(key, "$FILEVERSION=", 13) == 0) {
+        int major = 0;
+        int minor = 0;
+        if (std::sscanf(key + 13, "%d.%d", &major, &minor) >= 1) {
+            trc_version_ = major * 10 + minor;
+        }
+    } else if (std::strncmp(key, "$STARTTIME=", 11) == 0) {
+        double days = std::strtod(key + 11, nullptr);
+        if (days > kTrcUnixEpochDays) {
+            trc_start_us_ = static_cast<uint64_t>((days - kTrcUnixEpochDays) * 86400.0 * 1e6 + 0.5);
+        }
+    } else if (std::strncmp(key, "$COLUMNS=", 9) == 0) {
+        trc_columns_.clear();
+        for (const char* c = key + 9; *c != '\0'; ++c) {
+            if (std::isalpha(static_cast<unsigned char>(*c))) {
+                trc_columns_.push_back(*c);
+            }
+        }
+    }
+}
+
+bool LogFile::ParseTrcLine(char* line, CanFrame& frame) {
+    char* cursor = line;
+    while (*cursor == ' ' || *cursor == '\t') {
+        ++cursor;
+    }
+    if (*cursor == ';') {
+        ParseTrcHeader(cursor);
+        return false;
+    }
+    if (*cursor == '\0') {
+        return false;
+    }
+    std::memset(&frame, 0, sizeof(frame));
+    if (trc_version_ < 20) {
+        return ParseTrcV1Line(cursor, frame);
+    }
+
+    // Version 2.x: one token per $COLUMNS entry, data bytes last.
+    const std::string columns = trc_columns_.empty() ? std::string("NOTIdLD") : trc_columns_;
+    uint32_t dlc = 0;
+    uint32_t length = 0;
+    bool haveLength = false;
+    bool fd = false;
+    for (char column : columns) {
+        if (column == 'D') {
+            break;
+        }
+        char* token = NextToken(cursor);
+        if (token == nullptr) {
+            return false;
+        }
+        switch (column) {
+            case 'O': {
+                char* end = nullptr;
+                double millis = std::strtod(token, &end);
+                if (end == token) {
+                    return false;
+                }
+                frame.timestamp = trc_start_us_ + static_cast<uint64_t>(millis * 1000.0 + 0.5);
+                break;
+            }
+            case 'T':
+                if (std::strcmp(token, "DT") == 0) {
+                } else if (std::strcmp(token, "FD") == 0) {
+                    fd = true;
+                } else if (std::strcmp(token, "FB") == 0) {
+                    fd = true;
+                    frame.flags |= kFrameFlagBrs;
+                } else if (std::strcmp(token, "FE") == 0) {
+                    fd = true;
+                    frame.flags |= kFrameFlagEsi;
+                } else if (std::strcmp(token, "BI") == 0) {
+                    fd = true;
+                    frame.flags |= kFrameFlagBrs | kFrameFlagEsi;
+                } else if (std::strcmp(token, "RR") == 0) {
+                    frame.flags |= kFrameFlagRemote;
+                } else if (std::strcmp(token, "ER") == 0) {
+                    frame.flags |= kFrameFlagError;
+                } else {
+                    return false; // status, error counter and event records
+                }
+                break;
+            case 'B': {
+                uint32_t bus = 0;
+                if (ParseUnsigned(token, 10, bus) && bus > 0) {
+                    frame.channel = static_cast<uint16_t>(bus - 1);
+                }
+                break;
+            }
+            case 'I':
+                if (frame.flags & kFrameFlagError) {
+                    break;
+                }
+                if (!ParseUnsigned(token, 16, frame.id)) {
+                    return false;
+                }
+                if (std::strlen(token) > 4) {
+                    frame.flags |= kFrameFlagExtended;
+                }
+                break;
+            case 'd':
+                if (std::strcmp(token, "Tx") == 0) {
+                    frame.flags |= kFrameFlagTx;
+                }
+                break;
+            case 'L':
+                if (!ParseUnsigned(token, 16, dlc)) {
+                    return false;
+                }
+                break;
+            case 'l':
+                if (!ParseUnsigned(token, 10, length)) {
+                    return false;
+                }
+                haveLength = true;
+                break;
+            default:
+                break; // N (number), R (reserved)
+        }
+    }
+    if (fd) {
+        frame.flags |= kFrameFlagFd;
+    }
+    if (!haveLength) {
+        length = fd ? CanFdDlcToLength(static_cast<uint8_t>(dlc)) : std::min<uint32_t>(dlc, 8);
+    }
+    length = std::min<uint32_t>(length, fd ? 64 : 8);
+    if (frame.flags & (kFrameFlagRemote | kFrameFlagError)) {
+        frame.length = static_cast<uint8_t>(length);
+        return true;
+    }
+    for (uint32_t i = 0; i < length; ++i) {
+        uint32_t value = 0;
+        if (!ParseUnsigned(NextToken(cursor), 16, value)) {
+            return false;
+        }
+        frame.data[i] = static_cast<uint8_t>(value);
+    }
+    frame.length = static_cast<uint8_t>(length);
+    return true;
+}
+
+// Version 1.x records:
+//   1.0  <n>) <ms> <id> <dlc> <data...>
+//   1.1  <n>) <ms> <Rx|Tx|Error> <id> <dlc> <data...|RTR>
+//   1.2  <n>) <ms> <bus> <Rx|Tx|Error> <id> <dlc> <data...|RTR>
+//   1.3  <n>) <ms> <bus> <Rx|Tx|Error> <id> - <dlc> <data...|RTR>
+bool LogFile::ParseTrcV1Line(char* cursor, CanFrame& frame) {
+    char* number = NextToken(cursor);
+    char* offset = NextToken(cursor);
+    if (number == nullptr || offset == nullptr || number[std::strlen(number) - 1] != ')') {
+        return false;
+    }
+    char* end = nullptr;
+    double millis = std::strtod(offset, &end);
+    if (end == offset) {
+        return false;
+    }
+    frame.timestamp = trc_start_us_ + static_cast<uint64_t>(millis * 1000.0 + 0.5);
+
+    if (trc_version_ >= 12) {
+        uint32_t bus = 0;
+        if (!ParseUnsigned(NextToken(cursor), 10, bus)) {
+            return false;
+        }
+        frame.channel = static_cast<uint16_t>(bus > 0 ? bus - 1 : 0);
+    }
+    if (trc_version_ >= 11) {
+        char* type = NextToken(cursor);
+        if (type == nullptr) {
+            return false;
+        }
+        if (std::strcmp(type, "Tx") == 0) {
+            frame.flags |= kFrameFlagTx;
+        } else if (std::strcmp(type, "Error") == 0) {
+            frame.flags |= kFrameFlagError;
+        } else if (std::strcmp(type, "Rx") != 0) {
+            return false;
+        }
+    }
+
+    char* id = NextToken(cursor);
+    if (!ParseUnsigned(id, 16, frame.id)) {
+        return false;
+    }
+    if (std::strlen(id) > 4) {
+        frame.flags |= kFrameFlagExtended;
+    }
+    if (trc_version_ >= 13) {
+        NextToken(cursor); // reserved column
+    }
+    uint32_t length = 0;
+    if (!ParseUnsigned(NextToken(cursor), 10, length)) {
+        return false;
+    }
+    length = std::min<uint32_t>(length, 8);
+    frame.length = static_cast<uint8_t>(length);
+
+    for (uint32_t i = 0; i < length; ++i) {
+        char* token = NextToken(cursor);
+        if (token && std::strcmp(token, "RTR") == 0) {
+            frame.flags |= kFrameFlagRemote;
+            return true;
+        }
+        uint32_t value = 0;
+        if (!ParseUnsigned(token, 16, value)) {
+            return false;
+        }
+        frame.data[i] = static_cast<uint8_t>(value);
+    }
+    return true;
+}
+
+bool LogFile::ReadPcapHeader(std::string& error) {
+    uint8_t header[24];
+    if (!ReadExact(header, sizeof(header))) {
+        error = "Truncated pcap header";
+        return false;
+    }
+    uint32_t magic = 0;
+    std::memcpy(&magic, header, sizeof(magic));
+    if (magic == kPcapMagicMicros || magic == kPcapMagicNanos) {
+        pcap_swapped_ = false;
+    } else if (ByteSwap32(magic) == kPcapMagicMicros || ByteSwap32(magic) == kPcapMagicNanos) {
+        pcap_swapped_ = true;
+        magic = ByteSwap32(magic);
+    } else {
+        error = "Not a pcap file";
+        return false;
+    }
+    pcap_nanos_ = magic == kPcapMagicNanos;
+
+    uint32_t linkType = 0;
+    std::memcpy(&linkType, header + 20, sizeof(linkType));
+    if (pcap_swapped_) {
+        linkType = ByteSwap32(linkType);
+    }
+    if ((linkType & 0x0FFFFFFFu) != kPcapLinkTypeSocketCan) {
+        error = "Unsupported pcap link type " + std::to_string(linkType);
+        return false;
+    }
+    return true;
+}
+
+bool LogFile::ReadPcapRecord(CanFrame& frame, bool& skipped) {
+    uint32_t header[4];
+    if (!ReadExact(header, sizeof(header))) {
+        return false;
+    }
+    if (pcap_swapped_) {
+        for (uint32_t& value : header) {
+            value = ByteSwap32(value);
+        }
+    }
+    uint32_t captured = header[2];
+    if (captured > kPcapMaxRecord) {
+        return false;
+    }
+    uint8_t record[72] = {0};
+    size_t keep = std::min<size_t>(captured, sizeof(record));
+    if (!ReadExact(record, keep)) {
+        return false;
+    }
+    for (size_t remaining = captured - keep; remaining > 0;) {
+        uint8_t discard[256];
+        size_t chunk = std::min(remaining, sizeof(discard));
+        if (!ReadExact(discard, chunk)) {
+            return false;
+        }
+        remaining -= chunk;
+    }
+    if (keep < 8) {
+        skipped = true;
+        return true;
+    }
+
+    std::memset(&frame, 0, sizeof(frame));
+    uint64_t fraction = pcap_nanos_ ? header[1] / 1000u : header[1];
+    frame.timestamp = static_cast<uint64_t>(header[0]) * 1000000u + fraction;
+
+    uint32_t canId = (static_cast<uint32_t>(record[0]) << 24) | (static_cast<uint32_t>(record[1]) << 16) |
+                     (static_cast<uint32_t>(record[2]) << 8) | record[3];
+    if (canId & kSocketCanEffFlag) {
+        frame.flags |= kFrameFlagExtended;
+        frame.id = canId & 0x1FFFFFFFu;
+    } else {
+        frame.id = canId & 0x7FFu;
+    }
+    if (canId & kSocketCanRtrFlag) frame.flags |= kFrameFlagRemote;
+    if (canId & kSocketCanErrFlag) frame.flags |= kFrameFlagError;
+
+    bool fd = captured > 16 || (record[5] & 0x04) != 0;
+    size_t length = std::min<size_t>(record[4], fd ? 64 : 8);
+    if (fd) {
+        frame.flags |= kFrameFlagFd;
+        if (record[5] & 0x01) frame.flags |= kFrameFlagBrs;
+        if (record[5] & 0x02) frame.flags |= kFrameFlagEsi;
+    }
+    length = std::min(length, keep - 8);
+    std::memcpy(frame.data, record + 8, length);
+    frame.length = static_cast<uint8_t>(length);
+    skipped = false;
+    return true;
+}
@@ -0,0 +1,63 @@
+#ifndef ACE_CAN_LOG_FILE_H
+#define ACE_CAN_LOG_FILE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "can_frame.h"
+
+// Streaming parser for log files written by the devices or by other tools: Vector .asc, candump
+// .log, SocketCAN .pcap and PCAN .trc (1.0-2.1). Reads a buffer at a time and fills caller-owned
+// frame records, so files of any size import in bounded memory. Lines or records that are not
+// frames (headers, comments, status events) are skipped.
+class LogFile {
+public:
+    enum class Format { Asc, Candump, Pcap, Trc };
+
+    LogFile() = default;
+    ~LogFile();
+    LogFile(const LogFile&) = delete;
+    LogFile& operator=(const LogFile&) = delete;
+
+    static bool ParseFormat(const std::string& name, Format& out);
+
+    // `format` is a format name ("asc", "log", "candump", "pcap", "trc") or empty.
+    bool Open(const std::string& path, const std::string& format, std::string& error);
+    void Close();
+    // Up to `max` frames; 0 at the end of the file.
+    size_t ReadFrames(CanFrame* out, size_t max);
+
+    Format format() const { return format_; }
+
+private:
+    bool OpenFile(const std::string& path, std::string& error);
+    bool Fill();
+    bool NextLine(char*& line);
+    bool ReadExact(void* out, size_t nbytes);
+
+    bool ParseAscLine(char* line, CanFrame& frame);
+    bool ParseCandumpLine(char* line, CanFrame& frame);
+    void ParseTrcHeader(const char* line);
+    bool ParseTrcLine(char* line, CanFrame& frame);
+    bool ParseTrcV1Line(char* cursor, CanFrame& frame);
+    bool ReadPcapHeader(std::string& error);
+    bool ReadPcapRecord(CanFrame& frame, bool& skipped);
+
+    std::FILE* file_ = nullptr;
+    Format format_ = Format::Asc;
+    std::vector<char> buffer_;
+    size_t buffer_pos_ = 0;
+    size_t buffer_len_ = 0;
+    bool eof_ = false;
+
+    bool asc_hex_ = true;
+    bool pcap_swapped_ = false;
+    bool pcap_nanos_ = false;
+    int trc_version_ = 10; // major * 10 + minor; 1.0 files have no $FILEVERSION line
+    std::string trc_columns_;
+    uint64_t trc_start_us_ = 0;
+};
+
+#endif // ACE_CAN_LOG_FILE_H
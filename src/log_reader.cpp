@@ -0,0 +1,64 @@
+#include "log_reader.h"
+
+#include <algorithm>
+#include <string>
+
+namespace {
+
+constexpr size_t kDefaultBatchFrames = 4096;
+constexpr size_t kMaxBatchFrames = 65536;
+
+} // namespace
+
+Napi::Object LogReader::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "LogReader", {
+        InstanceMethod("read", &LogReader::Read),
+        InstanceMethod("close", &LogReader::Close)
+    });
+    exports.Set("LogReader", func);
+    return exports;
+}
+
+LogReader::LogReader(const Napi::CallbackInfo& info) : Napi::ObjectWrap<LogReader>(info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected log file path").ThrowAsJavaScriptException();
+        return;
+    }
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    std::string format;
+    if (info.Length() >= 2 && info[1].IsString()) {
+        format = info[1].As<Napi::String>().Utf8Value();
+    }
+    std::string error;
+    if (!file_.Open(path, format, error)) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+    }
+}
+
+Napi::Value LogReader::Read(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    size_t maxFrames = kDefaultBatchFrames;
+    if (info.Length() >= 1 && info[0].IsNumber()) {
+        int64_t requested = info[0].As<Napi::Number>().Int64Value();
+        if (requested < 1) {
+            Napi::RangeError::New(env, "maxFrames must be >= 1").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        maxFrames = std::min<size_t>(static_cast<size_t>(requested), kMaxBatchFrames);
+    }
+
+    if (scratch_.size() < maxFrames) {
+        scratch_.resize(maxFrames);
+    }
+    size_t count = file_.ReadFrames(scratch_.data(), maxFrames);
+    if (count == 0) {
+        return env.Null();
+    }
+    return Napi::Buffer<uint8_t>::Copy(env, reinterpret_cast<const uint8_t*>(scratch_.data()), count * kFrameRecordSize);
+}
+
+Napi::Value LogReader::Close(const Napi::CallbackInfo& info) {
+    file_.Close();
+    return info.Env().Undefined();
+}
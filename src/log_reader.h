@@ -0,0 +1,25 @@
+#ifndef ACE_CAN_LOG_READER_H
+#define ACE_CAN_LOG_READER_H
+
+#include <napi.h>
+#include <vector>
+
+#include "can_frame.h"
+#include "log_file.h"
+
+// Streams frames out of log files written by the devices (or by other tools)
+// and hands them to JS as frame batches, a bounded number of records at a time.
+class LogReader : public Napi::ObjectWrap<LogReader> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    LogReader(const Napi::CallbackInfo& info);
+
+    Napi::Value Read(const Napi::CallbackInfo& info);
+    Napi::Value Close(const Napi::CallbackInfo& info);
+
+private:
+    LogFile file_;
+    std::vector<CanFrame> scratch_;
+};
+
+#endif // ACE_CAN_LOG_READER_H
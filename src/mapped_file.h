@@ -0,0 +1,31 @@
+#ifndef ACE_CAN_MAPPED_FILE_H
+#define ACE_CAN_MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// A file mapped read-only into memory (mmap / MapViewOfFile), unmapped on destruction. Pages are
+// shared by every reader in the process and with the OS page cache, so one image read by many
+// sessions at once is neither copied nor loaded more than once.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns why the file could not be mapped, or an empty string on success.
+    std::string Open(const std::string& path);
+    const uint8_t* Data() const { return data_; }
+    size_t Size() const { return size_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* mapping_ = nullptr;
+#endif
+};
+
+#endif // ACE_CAN_MAPPED_FILE_H
@@ -0,0 +1,57 @@
+#ifndef ACE_CAN_NAPI_OPTIONS_H
+#define ACE_CAN_NAPI_OPTIONS_H
+
+#include <napi.h>
+#include <cstdint>
+#include <string>
+
+// Option readers leave `out` untouched when the key is absent and return false on a type mismatch.
+inline bool GetOptionalUint32(const Napi::Object& options, const char* key, uint32_t& out) {
+    if (!options.Has(key) || options.Get(key).IsUndefined()) {
+        return true;
+    }
+    Napi::Value value = options.Get(key);
+    if (!value.IsNumber()) {
+        return false;
+    }
+    out = value.As<Napi::Number>().Uint32Value();
+    return true;
+}
+
+inline bool GetOptionalDouble(const Napi::Object& options, const char* key, double& out) {
+    if (!options.Has(key) || options.Get(key).IsUndefined()) {
+        return true;
+    }
+    Napi::Value value = options.Get(key);
+    if (!value.IsNumber()) {
+        return false;
+    }
+    out = value.As<Napi::Number>().DoubleValue();
+    return true;
+}
+
+inline bool GetOptionalBool(const Napi::Object& options, const char* key, bool& out) {
+    if (!options.Has(key) || options.Get(key).IsUndefined()) {
+        return true;
+    }
+    Napi::Value value = options.Get(key);
+    if (!value.IsBoolean()) {
+        return false;
+    }
+    out = value.As<Napi::Boolean>().Value();
+    return true;
+}
+
+inline bool GetOptionalString(const Napi::Object& options, const char* key, std::string& out) {
+    if (!options.Has(key) || options.Get(key).IsUndefined()) {
+        return true;
+    }
+    Napi::Value value = options.Get(key);
+    if (!value.IsString()) {
+        return false;
+    }
+    out = value.As<Napi::String>().Utf8Value();
+    return true;
+}
+
+#endif // ACE_CAN_NAPI_OPTIONS_H
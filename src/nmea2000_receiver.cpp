@@ -0,0 +1,168 @@
+#include "nmea2000_receiver.h"
+
+#include <algorithm>
+
+#include "ace_can.h"
+#include "napi_options.h"
+
+namespace {
+
+// Reads an optional array of PGNs; false on a type mismatch.
+bool GetOptionalPgnList(const Napi::Object& options, const char* key, std::vector<uint32_t>& out) {
+    if (!options.Has(key) || options.Get(key).IsUndefined()) {
+        return true;
+    }
+    Napi::Value value = options.Get(key);
+    if (!value.IsArray()) {
+        return false;
+    }
+    Napi::Array list = value.As<Napi::Array>();
+    for (uint32_t i = 0; i < list.Length(); ++i) {
+        Napi::Value entry = list.Get(i);
+        if (!entry.IsNumber()) {
+            return false;
+        }
+        out.push_back(entry.As<Napi::Number>().Uint32Value());
+    }
+    return true;
+}
+
+} // namespace
+
+Napi::Object Nmea2000Receiver::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "Nmea2000Receiver", {
+        InstanceMethod("on", &Nmea2000Receiver::On),
+        InstanceMethod("stats", &Nmea2000Receiver::Stats),
+        InstanceMethod("close", &Nmea2000Receiver::Close),
+    });
+    exports.Set("Nmea2000Receiver", func);
+    return exports;
+}
+
+// new Nmea2000Receiver(bus, { timeoutMs = 750, fastPacketPgns, pgns }?)
+Nmea2000Receiver::Nmea2000Receiver(const Napi::CallbackInfo& info) : Napi::ObjectWrap<Nmea2000Receiver>(info) {
+    Napi::Env env = info.Env();
+    bus_ = info.Length() > 0 ? CANBus::FromValue(env, info[0]) : nullptr;
+    if (bus_ == nullptr) {
+        Napi::TypeError::New(env, "bus must be a CANBus instance").ThrowAsJavaScriptException();
+        return;
+    }
+    uint32_t timeoutMs = 750;
+    std::vector<uint32_t> fastPacketPgns;
+    if (info.Length() > 1 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (!GetOptionalUint32(options, "timeoutMs", timeoutMs) ||
+            !GetOptionalPgnList(options, "fastPacketPgns", fastPacketPgns) ||
+            !GetOptionalPgnList(options, "pgns", pgns_)) {
+            Napi::TypeError::New(env, "Invalid NMEA 2000 receiver option type").ThrowAsJavaScriptException();
+            return;
+        }
+    }
+    if (timeoutMs == 0) {
+        Napi::RangeError::New(env, "timeoutMs must be positive").ThrowAsJavaScriptException();
+        return;
+    }
+    assembler_ = std::make_unique<FastPacketAssembler>(static_cast<int64_t>(timeoutMs) * 1000);
+    if (!fastPacketPgns.empty()) {
+        assembler_->AddFastPacketPgns(fastPacketPgns);
+    }
+    std::sort(pgns_.begin(), pgns_.end());
+
+    bus_ref_ = Napi::Persistent(info[0].As<Napi::Object>());
+    tap_ = std::make_shared<Tap>(this);
+    bus_->AddTap(tap_);
+}
+
+Nmea2000Receiver::~Nmea2000Receiver() {
+    Shutdown();
+}
+
+void Nmea2000Receiver::Shutdown() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+    // RemoveTap waits for a tap call in progress, so no OnFrame runs after this.
+    if (bus_ != nullptr && tap_) {
+        bus_->RemoveTap(tap_.get());
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (tsfn_pgn_) {
+        tsfn_pgn_.Release();
+        tsfn_pgn_ = nullptr;
+    }
+}
+
+Napi::Value Nmea2000Receiver::On(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Expected (event, callback)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (closed_) {
+        Napi::Error::New(env, "Nmea2000Receiver closed").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::string event = info[0].As<Napi::String>();
+    if (event != "pgn") {
+        Napi::Error::New(env, "Only 'pgn' events supported").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (tsfn_pgn_) {
+        Napi::Error::New(env, "Already listening for PGNs").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    tsfn_pgn_ = Napi::ThreadSafeFunction::New(env, info[1].As<Napi::Function>(), "Nmea2000ReceiverOnPgn", 0, 1);
+    return env.Undefined();
+}
+
+Napi::Value Nmea2000Receiver::Stats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object result = Napi::Object::New(env);
+    uint64_t dropped = mailbox_.Dropped();
+    std::lock_guard<std::mutex> lock(mutex_);
+    const FastPacketAssembler::Stats& stats = assembler_->GetStats();
+    result.Set("frames", Napi::Number::New(env, static_cast<double>(stats.frames)));
+    result.Set("pgns", Napi::Number::New(env, static_cast<double>(stats.pgns)));
+    result.Set("fastPackets", Napi::Number::New(env, static_cast<double>(stats.fast_packets)));
+    result.Set("timeouts", Napi::Number::New(env, static_cast<double>(stats.timeouts)));
+    result.Set("errors", Napi::Number::New(env, static_cast<double>(stats.errors)));
+    result.Set("inFlight", Napi::Number::New(env, static_cast<double>(assembler_->InFlight())));
+    result.Set("dropped", Napi::Number::New(env, static_cast<double>(dropped)));
+    return result;
+}
+
+// Stops reassembling; the CANBus stays open.
+Napi::Value Nmea2000Receiver::Close(const Napi::CallbackInfo& info) {
+    Shutdown();
+    bus_ref_.Reset();
+    return info.Env().Undefined();
+}
+
+// Runs on the receive thread.
+void Nmea2000Receiver::OnFrame(const CanFrame& frame, int64_t hostUs) {
+    Nmea2000Pgn pgn;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!assembler_->Push(frame, hostUs, pgn)) {
+        return;
+    }
+    if (!pgns_.empty() && !std::binary_search(pgns_.begin(), pgns_.end(), pgn.pgn)) {
+        return;
+    }
+    Deliver(pgn);
+}
+
+// Queues a PGN for the JS thread; PGNs completed while a delivery is scheduled ride along with it.
+void Nmea2000Receiver::Deliver(const Nmea2000Pgn& pgn) {
+    mailbox_.Post(tsfn_pgn_, pgn, [](Napi::Env env, const Nmea2000Pgn& queued) {
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("pgn", Napi::Number::New(env, queued.pgn));
+        obj.Set("source", Napi::Number::New(env, queued.source));
+        obj.Set("destination", Napi::Number::New(env, queued.destination));
+        obj.Set("priority", Napi::Number::New(env, queued.priority));
+        obj.Set("timestamp", Napi::Number::New(env, static_cast<double>(queued.timestamp)));
+        obj.Set("data", Napi::Buffer<uint8_t>::Copy(env, queued.data, queued.length));
+        return obj;
+    });
+}
@@ -0,0 +1,58 @@
+#ifndef ACE_CAN_NMEA2000_RECEIVER_H
+#define ACE_CAN_NMEA2000_RECEIVER_H
+
+#include <napi.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "fast_packet.h"
+#include "frame_tap.h"
+#include "js_mailbox.h"
+
+class CANBus;
+
+// NMEA 2000 on a CANBus. A tap reassembles fast packets on the receive thread (FastPacketAssembler)
+// and only complete PGNs are queued for JS, so a 32-frame transfer costs one JS callback instead of
+// 32 'message' events plus reassembly in JS.
+class Nmea2000Receiver : public Napi::ObjectWrap<Nmea2000Receiver> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    Nmea2000Receiver(const Napi::CallbackInfo& info);
+    ~Nmea2000Receiver();
+
+    Napi::Value On(const Napi::CallbackInfo& info);
+    Napi::Value Stats(const Napi::CallbackInfo& info);
+    Napi::Value Close(const Napi::CallbackInfo& info);
+
+private:
+    static constexpr size_t kMaxPending = 4096;
+
+    class Tap : public FrameTap {
+    public:
+        explicit Tap(Nmea2000Receiver* owner) : owner_(owner) {}
+        void OnFrame(const CanFrame& frame, int64_t hostUs) override { owner_->OnFrame(frame, hostUs); }
+
+    private:
+        Nmea2000Receiver* owner_;
+    };
+
+    void OnFrame(const CanFrame& frame, int64_t hostUs);
+    void Deliver(const Nmea2000Pgn& pgn);
+    void Shutdown();
+
+    std::unique_ptr<FastPacketAssembler> assembler_;
+    std::vector<uint32_t> pgns_; // sorted; empty = deliver every PGN
+    bool closed_ = false;
+
+    CANBus* bus_ = nullptr;
+    Napi::ObjectReference bus_ref_;
+    std::shared_ptr<Tap> tap_;
+
+    std::mutex mutex_; // guards assembler_ and tsfn_pgn_
+    JsMailbox<Nmea2000Pgn> mailbox_{kMaxPending};
+    Napi::ThreadSafeFunction tsfn_pgn_;
+};
+
+#endif // ACE_CAN_NMEA2000_RECEIVER_H
@@ -0,0 +1,72 @@
+#ifndef ACE_CAN_RCU_H
+#define ACE_CAN_RCU_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Read-copy-update cell. Readers pin the current immutable snapshot with two atomic increments
+// and never wait; writers copy, modify and publish a new snapshot, then wait until every reader
+// that could still see the old one has left before freeing it. Read sections must therefore be
+// short and must never wait on a writer's thread.
+template <typename T>
+class RcuPtr {
+public:
+    RcuPtr() : value_(new T()) {}
+    ~RcuPtr() { delete value_.load(); }
+    RcuPtr(const RcuPtr&) = delete;
+    RcuPtr& operator=(const RcuPtr&) = delete;
+
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const RcuPtr& cell) : cell_(cell) {
+            // Register under the current epoch's parity; retry if a writer flipped it meanwhile,
+            // since that writer may not be waiting for this parity any more.
+            while (true) {
+                uint64_t epoch = cell_.epoch_.load();
+                parity_ = static_cast<size_t>(epoch & 1);
+                cell_.readers_[parity_].fetch_add(1);
+                if (cell_.epoch_.load() == epoch) {
+                    break;
+                }
+                cell_.readers_[parity_].fetch_sub(1);
+            }
+            value_ = cell_.value_.load();
+        }
+        ~ReadGuard() { cell_.readers_[parity_].fetch_sub(1); }
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+        const T& operator*() const { return *value_; }
+        const T* operator->() const { return value_; }
+
+    private:
+        const RcuPtr& cell_;
+        size_t parity_ = 0;
+        const T* value_ = nullptr;
+    };
+
+    // Applies `mutate` to a copy of the current snapshot and publishes it. Returns once no reader
+    // can still observe the previous snapshot.
+    template <typename Mutate>
+    void Update(Mutate&& mutate) {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        std::unique_ptr<T> next(new T(*value_.load()));
+        mutate(*next);
+        std::unique_ptr<T> previous(value_.exchange(next.release()));
+        uint64_t epoch = epoch_.fetch_add(1);
+        while (readers_[epoch & 1].load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    std::atomic<T*> value_;
+    mutable std::atomic<uint64_t> epoch_{0};
+    mutable std::atomic<uint32_t> readers_[2] = {{0}, {0}};
+    std::mutex writer_mutex_;
+};
+
+#endif // ACE_CAN_RCU_H
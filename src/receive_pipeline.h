@@ -0,0 +1,46 @@
+#ifndef ACE_CAN_RECEIVE_PIPELINE_H
+#define ACE_CAN_RECEIVE_PIPELINE_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "can_frame.h"
+#include "filter_program.h"
+#include "frame_stage.h"
+#include "frame_tap.h"
+
+// Software acceptance filter: (frame.id & mask) == (id & mask).
+struct IdFilter {
+    uint32_t id = 0;
+    uint32_t mask = 0x1FFFFFFF;
+    int8_t extended = -1; // -1 = either, 0 = standard only, 1 = extended only
+};
+
+// Everything the receive path consults per frame. Published as an immutable snapshot (see
+// RcuPtr) so it can change while frames flow without the reader ever taking a lock.
+struct ReceivePipeline {
+    std::vector<IdFilter> filters; // frames handed to JS; empty = all
+    std::shared_ptr<const FilterProgram> expression; // setFilters('...'); null = none
+    std::vector<std::shared_ptr<FrameTap>> taps; // see every frame, filtered or not
+    std::vector<std::shared_ptr<FrameStage>> stages; // run in order on each batch that passed the filters
+
+    bool Accepts(const CanFrame& frame) const {
+        if (expression && !expression->Matches(frame)) {
+            return false;
+        }
+        if (filters.empty()) {
+            return true;
+        }
+        bool extended = (frame.flags & kFrameFlagExtended) != 0;
+        for (const IdFilter& filter : filters) {
+            if ((frame.id & filter.mask) == (filter.id & filter.mask) &&
+                (filter.extended < 0 || (filter.extended != 0) == extended)) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+#endif // ACE_CAN_RECEIVE_PIPELINE_H
@@ -0,0 +1,143 @@
+#include "receive_plugin.h"
+
+#include "ace_can.h"
+
+Napi::Object ReceivePlugin::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "ReceivePlugin", {
+        InstanceMethod("on", &ReceivePlugin::On),
+        InstanceMethod("stats", &ReceivePlugin::Stats),
+        InstanceMethod("close", &ReceivePlugin::Close),
+    });
+    exports.Set("ReceivePlugin", func);
+    return exports;
+}
+
+// new ReceivePlugin(bus, path, config?)
+ReceivePlugin::ReceivePlugin(const Napi::CallbackInfo& info) : Napi::ObjectWrap<ReceivePlugin>(info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected bus, plugin path").ThrowAsJavaScriptException();
+        return;
+    }
+    bus_ = CANBus::FromValue(env, info[0]);
+    if (bus_ == nullptr) {
+        Napi::TypeError::New(env, "bus must be a CANBus instance").ThrowAsJavaScriptException();
+        return;
+    }
+    std::string config;
+    if (info.Length() > 2 && !info[2].IsUndefined()) {
+        if (!info[2].IsString()) {
+            Napi::TypeError::New(env, "config must be a string").ThrowAsJavaScriptException();
+            return;
+        }
+        config = info[2].As<Napi::String>().Utf8Value();
+    }
+
+    std::string error = plugin_.Load(info[1].As<Napi::String>().Utf8Value(), config);
+    if (!error.empty()) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return;
+    }
+    bus_ref_ = Napi::Persistent(info[0].As<Napi::Object>());
+    stage_ = std::make_shared<Stage>(this);
+    bus_->AddStage(stage_);
+}
+
+ReceivePlugin::~ReceivePlugin() {
+    Shutdown();
+}
+
+void ReceivePlugin::Process(std::vector<CanFrame>& frames, std::vector<uint32_t>& annotations) {
+    size_t count = frames.size();
+    plugin_.Process(frames, annotations, pending_);
+    size_t out = frames.size();
+    batches_.fetch_add(1, std::memory_order_relaxed);
+    frames_in_.fetch_add(count, std::memory_order_relaxed);
+    frames_out_.fetch_add(out, std::memory_order_relaxed);
+
+    if (pending_.empty()) {
+        return;
+    }
+    size_t emitted = pending_.size();
+    results_.fetch_add(emitted, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!tsfn_result_) {
+        dropped_results_.fetch_add(emitted, std::memory_order_relaxed);
+        pending_.clear();
+        return;
+    }
+    auto callback = [results = std::move(pending_)](Napi::Env env, Napi::Function jsCallback) {
+        for (const StagePlugin::Result& result : results) {
+            Napi::Object obj = Napi::Object::New(env);
+            obj.Set("tag", Napi::Number::New(env, result.tag));
+            obj.Set("data", Napi::Buffer<uint8_t>::Copy(env, result.data.data(), result.data.size()));
+            jsCallback.Call({obj});
+            if (env.IsExceptionPending()) {
+                break;
+            }
+        }
+    };
+    pending_.clear();
+    if (tsfn_result_.NonBlockingCall(callback) != napi_ok) {
+        dropped_results_.fetch_add(emitted, std::memory_order_relaxed);
+    }
+}
+
+void ReceivePlugin::Shutdown() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+    // RemoveStage waits for a batch in progress, so the plugin is idle from here on.
+    if (bus_ != nullptr && stage_) {
+        bus_->RemoveStage(stage_.get());
+    }
+    plugin_.Destroy();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (tsfn_result_) {
+        tsfn_result_.Release();
+        tsfn_result_ = nullptr;
+    }
+}
+
+Napi::Value ReceivePlugin::On(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Expected (event, callback)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (closed_) {
+        Napi::Error::New(env, "ReceivePlugin closed").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::string event = info[0].As<Napi::String>();
+    if (event != "result") {
+        Napi::Error::New(env, "Only 'result' events supported").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (tsfn_result_) {
+        Napi::Error::New(env, "Already listening for results").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    tsfn_result_ = Napi::ThreadSafeFunction::New(env, info[1].As<Napi::Function>(), "ReceivePluginOnResult", 0, 1);
+    return env.Undefined();
+}
+
+Napi::Value ReceivePlugin::Stats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("name", plugin_.Name());
+    result.Set("batches", Napi::Number::New(env, static_cast<double>(batches_.load())));
+    result.Set("framesIn", Napi::Number::New(env, static_cast<double>(frames_in_.load())));
+    result.Set("framesOut", Napi::Number::New(env, static_cast<double>(frames_out_.load())));
+    result.Set("results", Napi::Number::New(env, static_cast<double>(results_.load())));
+    result.Set("droppedResults", Napi::Number::New(env, static_cast<double>(dropped_results_.load())));
+    return result;
+}
+
+// Removes the stage from the bus and destroys the plugin instance; the CANBus stays open.
+Napi::Value ReceivePlugin::Close(const Napi::CallbackInfo& info) {
+    Shutdown();
+    return info.Env().Undefined();
+}
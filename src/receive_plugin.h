@@ -0,0 +1,62 @@
+#ifndef ACE_CAN_RECEIVE_PLUGIN_H
+#define ACE_CAN_RECEIVE_PLUGIN_H
+
+#include <napi.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "frame_stage.h"
+#include "stage_plugin.h"
+
+class CANBus;
+
+// A receive-stage plugin (ace_can_stage.h) loaded from a shared library and run as a FrameStage on
+// one CANBus. Results the plugin emits while processing a batch reach the JS 'result' listener in
+// a single call once the batch is done.
+class ReceivePlugin : public Napi::ObjectWrap<ReceivePlugin> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    ReceivePlugin(const Napi::CallbackInfo& info);
+    ~ReceivePlugin();
+
+    Napi::Value On(const Napi::CallbackInfo& info);
+    Napi::Value Stats(const Napi::CallbackInfo& info);
+    Napi::Value Close(const Napi::CallbackInfo& info);
+
+private:
+    class Stage : public FrameStage {
+    public:
+        explicit Stage(ReceivePlugin* owner) : owner_(owner) {}
+        void Process(std::vector<CanFrame>& frames, std::vector<uint32_t>& annotations) override {
+            owner_->Process(frames, annotations);
+        }
+
+    private:
+        ReceivePlugin* owner_;
+    };
+
+    void Process(std::vector<CanFrame>& frames, std::vector<uint32_t>& annotations);
+    void Shutdown();
+
+    StagePlugin plugin_;
+
+    CANBus* bus_ = nullptr;
+    Napi::ObjectReference bus_ref_;
+    std::shared_ptr<Stage> stage_;
+    bool closed_ = false;
+
+    std::vector<StagePlugin::Result> pending_; // emitted during process()
+    std::mutex mutex_; // guards tsfn_result_
+    Napi::ThreadSafeFunction tsfn_result_;
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<uint64_t> frames_in_{0};
+    std::atomic<uint64_t> frames_out_{0};
+    std::atomic<uint64_t> results_{0};
+    std::atomic<uint64_t> dropped_results_{0};
+};
+
+#endif // ACE_CAN_RECEIVE_PLUGIN_H
@@ -0,0 +1,77 @@
+#include "receive_poller.h"
+
+#include <uv.h>
+
+namespace {
+
+void ClosePoll(uv_poll_t*& poll) {
+    if (poll != nullptr) {
+        uv_close(reinterpret_cast<uv_handle_t*>(poll), [](uv_handle_t* handle) { delete reinterpret_cast<uv_poll_t*>(handle); });
+        poll = nullptr;
+    }
+}
+
+} // namespace
+
+bool ReceivePoller::Start(uv_loop_t* loop) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (rearm_ != nullptr) {
+            return false;
+        }
+        uv_async_t* rearm = new uv_async_t;
+        uv_async_init(loop, rearm, [](uv_async_t* handle) { static_cast<ReceivePoller*>(handle->data)->Watch(); });
+        rearm->data = this;
+        rearm_ = rearm;
+    }
+    Watch();
+    return true;
+}
+
+void ReceivePoller::Stop() {
+    uv_async_t* rearm;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rearm = rearm_;
+        rearm_ = nullptr;
+    }
+    if (rearm == nullptr) {
+        return;
+    }
+    ClosePoll(poll_);
+    uv_close(reinterpret_cast<uv_handle_t*>(rearm), [](uv_handle_t* handle) { delete reinterpret_cast<uv_async_t*>(handle); });
+}
+
+void ReceivePoller::Rearm() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (rearm_ != nullptr) {
+        uv_async_send(rearm_);
+    }
+}
+
+bool ReceivePoller::Running() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rearm_ != nullptr;
+}
+
+// Always starts over: a re-opened device can reuse the old fd number, and libuv would not
+// re-register it with the kernel.
+void ReceivePoller::Watch() {
+    ClosePoll(poll_);
+    int fd = hooks_.fd();
+    if (fd < 0) {
+        return;
+    }
+    uv_poll_t* poll = new uv_poll_t;
+    int result = uv_poll_init(rearm_->loop, poll, fd);
+    if (result != 0) {
+        delete poll;
+        hooks_.readable(result);
+        return;
+    }
+    poll->data = this;
+    uv_poll_start(poll, UV_READABLE, [](uv_poll_t* handle, int status, int) {
+        static_cast<ReceivePoller*>(handle->data)->hooks_.readable(status);
+    });
+    poll_ = poll;
+}
@@ -0,0 +1,44 @@
+#ifndef ACE_CAN_RECEIVE_POLLER_H
+#define ACE_CAN_RECEIVE_POLLER_H
+
+#include <functional>
+#include <mutex>
+
+struct uv_loop_s;
+struct uv_async_s;
+struct uv_poll_s;
+
+// Watches a receive fd from a libuv event loop, so frames can be read on the loop thread without a
+// receive thread. The fd may change on another thread (a device re-opened by the watcher): Rearm()
+// is safe from any thread and has the loop thread rebuild the watch from the hooks. The owner
+// supplies the fd and the read as hooks, which run on the loop thread.
+class ReceivePoller {
+public:
+    struct Hooks {
+        std::function<int()> fd; // the fd to watch, or -1 while there is none
+        // The fd is readable; a negative status is a libuv error, from polling or from watching the fd.
+        std::function<void(int status)> readable;
+    };
+
+    explicit ReceivePoller(Hooks hooks) : hooks_(std::move(hooks)) {}
+    ReceivePoller(const ReceivePoller&) = delete;
+    ReceivePoller& operator=(const ReceivePoller&) = delete;
+
+    // Starts watching on `loop`, from its thread. Returns false if already running.
+    bool Start(uv_loop_s* loop);
+    // Releases the handles, from the loop thread; must be called before the poller is destroyed.
+    void Stop();
+    // Has the loop thread watch the fd the hooks name now; safe from any thread.
+    void Rearm();
+    bool Running() const;
+
+private:
+    void Watch();
+
+    Hooks hooks_;
+    mutable std::mutex mutex_; // Guards rearm_ against Stop() while another thread signals it
+    uv_async_s* rearm_ = nullptr; // Non-null while running
+    uv_poll_s* poll_ = nullptr; // Watches the fd while there is one
+};
+
+#endif // ACE_CAN_RECEIVE_POLLER_H
@@ -0,0 +1,249 @@
+#include "redundant_bus.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "ace_can.h"
+#include "napi_options.h"
+#include "timed_tx.h"
+
+namespace {
+
+const char* kSourceNames[2] = {"primary", "secondary"};
+constexpr uint32_t kDefaultDedupWindowUs = 2000;
+constexpr uint32_t kDefaultFailoverMs = 10;
+constexpr int64_t kMinLivenessIntervalUs = 1000;
+
+} // namespace
+
+Napi::Object RedundantBus::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "RedundantBus", {
+        InstanceMethod("on", &RedundantBus::On),
+        InstanceMethod("active", &RedundantBus::Active),
+        InstanceMethod("failover", &RedundantBus::Failover),
+        InstanceMethod("recordTransmit", &RedundantBus::RecordTransmit),
+        InstanceMethod("stats", &RedundantBus::Stats),
+        InstanceMethod("close", &RedundantBus::Close),
+    });
+    exports.Set("RedundantBus", func);
+    return exports;
+}
+
+RedundantBus::RedundantBus(const Napi::CallbackInfo& info) : Napi::ObjectWrap<RedundantBus>(info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2) {
+        Napi::TypeError::New(env, "Expected primary, secondary").ThrowAsJavaScriptException();
+        return;
+    }
+    buses_[0] = CANBus::FromValue(env, info[0]);
+    buses_[1] = CANBus::FromValue(env, info[1]);
+    if (buses_[0] == nullptr || buses_[1] == nullptr || buses_[0] == buses_[1]) {
+        Napi::TypeError::New(env, "primary and secondary must be two different CANBus instances").ThrowAsJavaScriptException();
+        return;
+    }
+
+    uint32_t windowUs = kDefaultDedupWindowUs;
+    uint32_t failoverMs = kDefaultFailoverMs;
+    if (info.Length() > 2 && info[2].IsObject()) {
+        Napi::Object options = info[2].As<Napi::Object>();
+        if (!GetOptionalUint32(options, "dedupWindowUs", windowUs) || !GetOptionalUint32(options, "failoverMs", failoverMs)) {
+            Napi::TypeError::New(env, "Invalid redundant bus option type").ThrowAsJavaScriptException();
+            return;
+        }
+    }
+    if (windowUs == 0 || failoverMs == 0 || static_cast<int64_t>(failoverMs) * 1000 <= windowUs) {
+        Napi::RangeError::New(env, "failoverMs must be longer than dedupWindowUs").ThrowAsJavaScriptException();
+        return;
+    }
+    dedup_ = std::make_unique<FrameDeduplicator>(windowUs, static_cast<int64_t>(failoverMs) * 1000);
+    // A quarter of the timeout, so a silent active adapter is noticed within 1.25 x failoverMs.
+    liveness_interval_us_ = std::max<int64_t>(static_cast<int64_t>(failoverMs) * 250, kMinLivenessIntervalUs);
+
+    refs_[0] = Napi::Persistent(info[0].As<Napi::Object>());
+    refs_[1] = Napi::Persistent(info[1].As<Napi::Object>());
+    for (uint8_t source = 0; source < 2; ++source) {
+        taps_[source] = std::make_shared<Tap>(this, source);
+        buses_[source]->AddTap(taps_[source]);
+    }
+    liveness_running_ = true;
+    liveness_thread_ = std::thread([this]() { LivenessLoop(); });
+}
+
+RedundantBus::~RedundantBus() {
+    Shutdown();
+}
+
+void RedundantBus::Shutdown() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        liveness_running_ = false;
+    }
+    liveness_cv_.notify_all();
+    if (liveness_thread_.joinable()) {
+        liveness_thread_.join();
+    }
+    // RemoveTap waits for a tap call in progress, so no OnFrame runs after this.
+    for (uint8_t source = 0; source < 2; ++source) {
+        if (buses_[source] != nullptr && taps_[source]) {
+            buses_[source]->RemoveTap(taps_[source].get());
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (tsfn_message_) {
+        tsfn_message_.Release();
+        tsfn_message_ = nullptr;
+    }
+    if (tsfn_failover_) {
+        tsfn_failover_.Release();
+        tsfn_failover_ = nullptr;
+    }
+}
+
+Napi::Value RedundantBus::On(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Expected (event, callback)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (closed_) {
+        Napi::Error::New(env, "RedundantBus closed").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::string event = info[0].As<Napi::String>();
+    Napi::Function cb = info[1].As<Napi::Function>();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (event == "message") {
+        if (tsfn_message_) {
+            Napi::Error::New(env, "Already listening for messages").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        tsfn_message_ = Napi::ThreadSafeFunction::New(env, cb, "RedundantBusOnMessage", 0, 1);
+    } else if (event == "failover") {
+        if (tsfn_failover_) {
+            Napi::Error::New(env, "Already listening for failover").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        tsfn_failover_ = Napi::ThreadSafeFunction::New(env, cb, "RedundantBusOnFailover", 0, 1);
+    } else {
+        Napi::Error::New(env, "Only 'message', 'failover' events supported").ThrowAsJavaScriptException();
+    }
+    return env.Undefined();
+}
+
+// 0 while transmitting on the primary, 1 after failing over to the secondary.
+Napi::Value RedundantBus::Active(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Napi::Number::New(info.Env(), dedup_->active());
+}
+
+// Switches to the other adapter, e.g. after a transmit error on the active one.
+Napi::Value RedundantBus::Failover(const Napi::CallbackInfo& info) {
+    std::string reason = "manual";
+    if (info.Length() > 0 && info[0].IsString()) {
+        reason = info[0].As<Napi::String>().Utf8Value();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    SwitchTo(dedup_->active() == 0 ? 1 : 0, reason);
+    return Napi::Number::New(info.Env(), dedup_->active());
+}
+
+// Called by send() just before a frame goes out on one adapter (0 = primary), so that the copy the
+// other adapter receives is recognised as the pair's own transmission.
+Napi::Value RedundantBus::RecordTransmit(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !info[1].IsNumber() || info[1].As<Napi::Number>().Uint32Value() > 1) {
+        Napi::TypeError::New(env, "Expected (message, 0 | 1)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    uint8_t source = static_cast<uint8_t>(info[1].As<Napi::Number>().Uint32Value());
+    CanFrame frame = {};
+    std::string typeError = JsToFrame(info[0], buses_[source]->MaxDataLength(), frame);
+    if (!typeError.empty()) {
+        Napi::TypeError::New(env, typeError).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    dedup_->RecordTransmit(source, frame, HostMicros());
+    return env.Undefined();
+}
+
+Napi::Value RedundantBus::Stats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object stats = Napi::Object::New(env);
+    uint64_t dropped = mailbox_.Dropped();
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.Set("delivered", Napi::Number::New(env, static_cast<double>(dedup_->delivered())));
+    stats.Set("duplicates", Napi::Number::New(env, static_cast<double>(dedup_->duplicates())));
+    stats.Set("ownTransmits", Napi::Number::New(env, static_cast<double>(dedup_->own_transmits())));
+    stats.Set("failovers", Napi::Number::New(env, static_cast<double>(dedup_->failovers())));
+    stats.Set("dropped", Napi::Number::New(env, static_cast<double>(dropped)));
+    stats.Set("active", Napi::String::New(env, kSourceNames[dedup_->active()]));
+    return stats;
+}
+
+Napi::Value RedundantBus::Close(const Napi::CallbackInfo& info) {
+    Shutdown();
+    refs_[0].Reset();
+    refs_[1].Reset();
+    return info.Env().Undefined();
+}
+
+// Runs on the receive thread of either adapter.
+void RedundantBus::OnFrame(uint8_t source, const CanFrame& frame, int64_t hostUs) {
+    // Device timestamps are far more precise than host read times when the clock mapping is known.
+    int64_t atUs = hostUs;
+    int64_t mapped = 0;
+    if (buses_[source]->DeviceToHost(frame.timestamp, mapped)) {
+        atUs = mapped;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dedup_->Accept(source, frame, atUs) != FrameDeduplicator::Verdict::Deliver) {
+        return;
+    }
+    CheckLiveness(atUs);
+    Deliver(frame);
+}
+
+// Fails over when the active adapter has missed a frame the other one delivered. Called with the
+// lock held.
+void RedundantBus::CheckLiveness(int64_t nowUs) {
+    uint8_t active = dedup_->active();
+    if (dedup_->ActiveMissing(nowUs)) {
+        SwitchTo(active == 0 ? 1 : 0, std::string(kSourceNames[active]) + " stopped delivering");
+    }
+}
+
+// Runs the liveness check between frames, so the switch does not wait for the next one.
+void RedundantBus::LivenessLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (liveness_running_) {
+        liveness_cv_.wait_for(lock, std::chrono::microseconds(liveness_interval_us_),
+                              [this]() { return !liveness_running_; });
+        if (liveness_running_) {
+            CheckLiveness(HostMicros());
+        }
+    }
+}
+
+void RedundantBus::SwitchTo(uint8_t source, const std::string& reason) {
+    if (!dedup_->SwitchTo(source) || !tsfn_failover_) {
+        return;
+    }
+    tsfn_failover_.NonBlockingCall([source, reason](Napi::Env env, Napi::Function jsCallback) {
+        Napi::Object event = Napi::Object::New(env);
+        event.Set("active", Napi::String::New(env, kSourceNames[source]));
+        event.Set("reason", Napi::String::New(env, reason));
+        jsCallback.Call({event});
+    });
+}
+
+// Queues a frame for the JS thread; frames arriving while a delivery is scheduled ride along with it.
+void RedundantBus::Deliver(const CanFrame& frame) {
+    mailbox_.Post(tsfn_message_, frame, FrameToJs);
+}
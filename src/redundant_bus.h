@@ -0,0 +1,75 @@
+#ifndef ACE_CAN_REDUNDANT_BUS_H
+#define ACE_CAN_REDUNDANT_BUS_H
+
+#include <napi.h>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_dedup.h"
+#include "frame_tap.h"
+#include "js_mailbox.h"
+
+class CANBus;
+
+// Two adapters on the same physical bus. Frames from both receive threads are de-duplicated
+// natively by (id, flags, payload) within a time window before anything is queued for JS, and
+// the pair fails over to the other adapter when frames only the inactive one received stay
+// unmatched by the active one for longer than the failover timeout. That is checked as frames
+// arrive and on a timer, so a bus that falls silent fails over too. The bookkeeping lives in
+// FrameDeduplicator.
+class RedundantBus : public Napi::ObjectWrap<RedundantBus> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    RedundantBus(const Napi::CallbackInfo& info);
+    ~RedundantBus();
+
+    Napi::Value On(const Napi::CallbackInfo& info);
+    Napi::Value Active(const Napi::CallbackInfo& info);
+    Napi::Value Failover(const Napi::CallbackInfo& info);
+    Napi::Value RecordTransmit(const Napi::CallbackInfo& info);
+    Napi::Value Stats(const Napi::CallbackInfo& info);
+    Napi::Value Close(const Napi::CallbackInfo& info);
+
+private:
+    static constexpr size_t kMaxPending = 65536;
+
+    class Tap : public FrameTap {
+    public:
+        Tap(RedundantBus* owner, uint8_t source) : owner_(owner), source_(source) {}
+        void OnFrame(const CanFrame& frame, int64_t hostUs) override { owner_->OnFrame(source_, frame, hostUs); }
+
+    private:
+        RedundantBus* owner_;
+        uint8_t source_;
+    };
+
+    void OnFrame(uint8_t source, const CanFrame& frame, int64_t hostUs);
+    void CheckLiveness(int64_t nowUs);
+    void LivenessLoop();
+    void SwitchTo(uint8_t source, const std::string& reason);
+    void Deliver(const CanFrame& frame);
+    void Shutdown();
+
+    CANBus* buses_[2] = {nullptr, nullptr};
+    Napi::ObjectReference refs_[2];
+    std::shared_ptr<Tap> taps_[2];
+    bool closed_ = false;
+
+    std::mutex mutex_; // guards dedup_ and liveness_running_
+    std::unique_ptr<FrameDeduplicator> dedup_;
+    std::thread liveness_thread_;
+    std::condition_variable liveness_cv_;
+    bool liveness_running_ = false;
+    int64_t liveness_interval_us_ = 0;
+
+    JsMailbox<CanFrame> mailbox_{kMaxPending};
+    Napi::ThreadSafeFunction tsfn_message_;
+    Napi::ThreadSafeFunction tsfn_failover_;
+};
+
+#endif // ACE_CAN_REDUNDANT_BUS_H
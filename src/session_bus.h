@@ -0,0 +1,22 @@
+#ifndef ACE_CAN_SESSION_BUS_H
+#define ACE_CAN_SESSION_BUS_H
+
+#include <memory>
+#include <string>
+
+#include "can_frame.h"
+#include "frame_tap.h"
+
+// The part of a bus a SessionScheduler uses: a tap on the receive stream and a transmit path.
+// CANBus implements it; the native tests substitute a loopback.
+class SessionBus {
+public:
+    virtual ~SessionBus() = default;
+
+    virtual void AddTap(std::shared_ptr<FrameTap> tap) = 0;
+    virtual void RemoveTap(const FrameTap* tap) = 0;
+    // Returns an empty string on success.
+    virtual std::string Transmit(const CanFrame& frame) = 0;
+};
+
+#endif // ACE_CAN_SESSION_BUS_H
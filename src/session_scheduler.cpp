@@ -0,0 +1,201 @@
+#include "session_scheduler.h"
+
+#include <chrono>
+
+#include "timed_tx.h"
+
+namespace {
+
+uint64_t ListenKey(uint32_t id, bool extended) {
+    return (extended ? (uint64_t{1} << 32) : 0) | id;
+}
+
+} // namespace
+
+SessionTask::promise_type::~promise_type() {
+    if (scheduler != nullptr) {
+        scheduler->Finished(this);
+    }
+}
+
+SessionScheduler::SessionScheduler(SessionBus* bus) : bus_(bus) {}
+
+SessionScheduler::~SessionScheduler() {
+    Stop();
+}
+
+void SessionScheduler::Start() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_) {
+            return;
+        }
+        running_ = true;
+    }
+    tap_ = std::make_shared<Tap>(this);
+    bus_->AddTap(tap_);
+    thread_ = std::thread([this]() { Loop(); });
+}
+
+void SessionScheduler::Stop() {
+    if (tap_) {
+        bus_->RemoveTap(tap_.get());
+        tap_.reset();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+        inbox_.clear();
+        spawn_queue_.clear();
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    // Unfinished sessions are destroyed where they are suspended. Their waiters are only reachable
+    // through the wheel and the listener lists, which are dropped first.
+    timers_.Clear();
+    listeners_.clear();
+    std::unordered_set<SessionTask::promise_type*> sessions;
+    sessions.swap(sessions_);
+    for (SessionTask::promise_type* promise : sessions) {
+        promise->scheduler = nullptr;
+        std::coroutine_handle<SessionTask::promise_type>::from_promise(*promise).destroy();
+    }
+    active_ = 0;
+}
+
+void SessionScheduler::Spawn(std::function<SessionTask()> factory) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        spawn_queue_.push_back(std::move(factory));
+    }
+    cv_.notify_one();
+}
+
+std::string SessionScheduler::Transmit(const CanFrame& frame) {
+    return bus_->Transmit(frame);
+}
+
+// Runs on the bus's receive thread: only queue the frame.
+void SessionScheduler::Enqueue(const CanFrame& frame) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_ || inbox_.size() >= kMaxInbox) {
+            return;
+        }
+        inbox_.push_back(frame);
+    }
+    cv_.notify_one();
+}
+
+void SessionScheduler::Loop() {
+    std::deque<CanFrame> frames;
+    std::deque<std::function<SessionTask()>> spawns;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            int64_t nowUs = HostMicros();
+            int64_t wakeUs = timers_.NextDueUs(nowUs, nowUs + static_cast<int64_t>(kWheelSlots) * kTickUs);
+            auto ready = [this]() { return !running_ || !inbox_.empty() || !spawn_queue_.empty(); };
+            if (timers_.Empty()) {
+                cv_.wait(lock, ready);
+            } else if (wakeUs > nowUs) {
+                cv_.wait_for(lock, std::chrono::microseconds(wakeUs - nowUs), ready);
+            }
+            if (!running_) {
+                break;
+            }
+            frames.swap(inbox_);
+            spawns.swap(spawn_queue_);
+        }
+
+        for (std::function<SessionTask()>& factory : spawns) {
+            std::coroutine_handle<SessionTask::promise_type> handle = factory().Release();
+            handle.promise().scheduler = this;
+            sessions_.insert(&handle.promise());
+            active_++;
+            handle.resume();
+        }
+        spawns.clear();
+        for (const CanFrame& frame : frames) {
+            Deliver(frame);
+        }
+        frames.clear();
+        timers_.Advance(HostMicros(), [this](TimerNode* node) {
+            Waiter* waiter = static_cast<Waiter*>(node->owner);
+            RemoveListener(*waiter);
+            waiter->handle.resume();
+        });
+    }
+}
+
+// Wakes the oldest session waiting for this ID. Frames nobody waits for are dropped.
+void SessionScheduler::Deliver(const CanFrame& frame) {
+    auto it = listeners_.find(ListenKey(frame.id, (frame.flags & kFrameFlagExtended) != 0));
+    if (it == listeners_.end() || it->second.head == nullptr) {
+        return;
+    }
+    Waiter* waiter = it->second.head;
+    RemoveListener(*waiter);
+    timers_.Cancel(&waiter->timer);
+    waiter->frame = frame;
+    waiter->received = true;
+    waiter->handle.resume();
+}
+
+void SessionScheduler::AddListener(Waiter& waiter, uint32_t id, bool extended, int64_t timeoutUs,
+                                   std::coroutine_handle<> handle) {
+    waiter.handle = handle;
+    waiter.received = false;
+    waiter.key = ListenKey(id, extended);
+    WaiterList& list = listeners_[waiter.key];
+    waiter.prev = list.tail;
+    waiter.next = nullptr;
+    if (list.tail != nullptr) {
+        list.tail->next = &waiter;
+    } else {
+        list.head = &waiter;
+    }
+    list.tail = &waiter;
+    waiter.listening = true;
+    if (timeoutUs > 0) {
+        waiter.timer.owner = &waiter;
+        timers_.Add(&waiter.timer, HostMicros() + timeoutUs);
+    }
+}
+
+void SessionScheduler::AddSleeper(Waiter& waiter, int64_t delayUs, std::coroutine_handle<> handle) {
+    waiter.handle = handle;
+    waiter.timer.owner = &waiter;
+    timers_.Add(&waiter.timer, HostMicros() + delayUs);
+}
+
+void SessionScheduler::RemoveListener(Waiter& waiter) {
+    if (!waiter.listening) {
+        return;
+    }
+    WaiterList& list = listeners_[waiter.key];
+    if (waiter.prev != nullptr) {
+        waiter.prev->next = waiter.next;
+    } else {
+        list.head = waiter.next;
+    }
+    if (waiter.next != nullptr) {
+        waiter.next->prev = waiter.prev;
+    } else {
+        list.tail = waiter.prev;
+    }
+    waiter.prev = nullptr;
+    waiter.next = nullptr;
+    waiter.listening = false;
+}
+
+void SessionScheduler::Finished(SessionTask::promise_type* promise) {
+    sessions_.erase(promise);
+    active_--;
+}
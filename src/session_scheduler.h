@@ -0,0 +1,213 @@
+#ifndef ACE_CAN_SESSION_SCHEDULER_H
+#define ACE_CAN_SESSION_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "can_frame.h"
+#include "frame_tap.h"
+#include "session_bus.h"
+#include "timer_wheel.h"
+
+class SessionScheduler;
+
+// Top-level protocol session. Created suspended; SessionScheduler::Spawn starts it and owns it
+// from then on. The coroutine frame frees itself when the session returns.
+class SessionTask {
+public:
+    struct promise_type {
+        SessionScheduler* scheduler = nullptr;
+
+        SessionTask get_return_object() { return SessionTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+        ~promise_type();
+    };
+
+    SessionTask(SessionTask&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    SessionTask& operator=(SessionTask&&) = delete;
+    ~SessionTask() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    std::coroutine_handle<promise_type> Release() { return std::exchange(handle_, {}); }
+
+private:
+    explicit SessionTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// Child coroutine returning a T, awaited by a session or another Async. Starts when awaited and
+// resumes the awaiting coroutine directly when it returns, so nesting costs no scheduler round trip.
+template <typename T>
+class Async {
+public:
+    struct promise_type {
+        T value{};
+        std::coroutine_handle<> continuation;
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                return handle.promise().continuation;
+            }
+            void await_resume() noexcept {}
+        };
+
+        Async get_return_object() { return Async(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_value(T result) { value = std::move(result); }
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    Async(Async&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Async& operator=(Async&&) = delete;
+    ~Async() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> parent) noexcept {
+        handle_.promise().continuation = parent;
+        return handle_;
+    }
+    T await_resume() { return std::move(handle_.promise().value); }
+
+private:
+    explicit Async(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// Runs protocol sessions (ISO-TP, UDS, ...) as coroutines on a single thread. Sessions await
+// frames by CAN ID and timeouts; frames come from a tap on the bus's receive thread and timeouts
+// from a timer wheel, so thousands of concurrent sessions share one thread and no session ever
+// blocks it. Everything a session does runs on the scheduler thread.
+class SessionScheduler {
+public:
+    // Suspension point for a frame and/or a deadline. Lives in the awaiting coroutine's frame.
+    struct Waiter {
+        TimerNode timer;
+        Waiter* prev = nullptr;
+        Waiter* next = nullptr;
+        uint64_t key = 0;
+        bool listening = false;
+        bool received = false;
+        CanFrame frame = {};
+        std::coroutine_handle<> handle;
+    };
+
+    class FrameAwaiter {
+    public:
+        FrameAwaiter(SessionScheduler* scheduler, uint32_t id, bool extended, int64_t timeoutUs)
+            : scheduler_(scheduler), id_(id), extended_(extended), timeout_us_(timeoutUs) {}
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { scheduler_->AddListener(waiter_, id_, extended_, timeout_us_, handle); }
+        // Empty on timeout.
+        std::optional<CanFrame> await_resume() const {
+            return waiter_.received ? std::optional<CanFrame>(waiter_.frame) : std::nullopt;
+        }
+
+    private:
+        SessionScheduler* scheduler_;
+        uint32_t id_;
+        bool extended_;
+        int64_t timeout_us_;
+        Waiter waiter_;
+    };
+
+    class SleepAwaiter {
+    public:
+        SleepAwaiter(SessionScheduler* scheduler, int64_t delayUs) : scheduler_(scheduler), delay_us_(delayUs) {}
+        bool await_ready() const noexcept { return delay_us_ <= 0; }
+        void await_suspend(std::coroutine_handle<> handle) { scheduler_->AddSleeper(waiter_, delay_us_, handle); }
+        void await_resume() const noexcept {}
+
+    private:
+        SessionScheduler* scheduler_;
+        int64_t delay_us_;
+        Waiter waiter_;
+    };
+
+    explicit SessionScheduler(SessionBus* bus);
+    ~SessionScheduler();
+
+    // Attaches to the bus and starts the thread. Call from the JS thread.
+    void Start();
+    // Detaches, stops the thread and destroys every unfinished session. Call from the JS thread.
+    void Stop();
+
+    // Runs `factory` on the scheduler thread and starts the session it returns. Thread-safe.
+    void Spawn(std::function<SessionTask()> factory);
+    size_t ActiveSessions() const { return active_.load(); }
+
+    // For use inside sessions.
+    FrameAwaiter NextFrame(uint32_t id, bool extended, int64_t timeoutUs) { return FrameAwaiter(this, id, extended, timeoutUs); }
+    SleepAwaiter Sleep(int64_t delayUs) { return SleepAwaiter(this, delayUs); }
+    std::string Transmit(const CanFrame& frame);
+
+private:
+    friend struct SessionTask::promise_type;
+
+    class Tap : public FrameTap {
+    public:
+        explicit Tap(SessionScheduler* scheduler) : scheduler_(scheduler) {}
+        void OnFrame(const CanFrame& frame, int64_t /*hostUs*/) override { scheduler_->Enqueue(frame); }
+
+    private:
+        SessionScheduler* scheduler_;
+    };
+
+    struct WaiterList {
+        Waiter* head = nullptr;
+        Waiter* tail = nullptr;
+    };
+
+    static constexpr int64_t kTickUs = 1000;
+    static constexpr size_t kWheelSlots = 1024;
+    static constexpr size_t kMaxInbox = 65536;
+
+    void Enqueue(const CanFrame& frame);
+    void Loop();
+    void Deliver(const CanFrame& frame);
+    void AddListener(Waiter& waiter, uint32_t id, bool extended, int64_t timeoutUs, std::coroutine_handle<> handle);
+    void AddSleeper(Waiter& waiter, int64_t delayUs, std::coroutine_handle<> handle);
+    void RemoveListener(Waiter& waiter);
+    void Finished(SessionTask::promise_type* promise);
+
+    SessionBus* bus_;
+    std::shared_ptr<Tap> tap_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_ = false;
+    std::deque<CanFrame> inbox_; // guarded by mutex_
+    std::deque<std::function<SessionTask()>> spawn_queue_; // guarded by mutex_
+    std::atomic<size_t> active_{0};
+
+    // Scheduler thread only.
+    TimerWheel timers_{kTickUs, kWheelSlots};
+    std::unordered_map<uint64_t, WaiterList> listeners_;
+    std::unordered_set<SessionTask::promise_type*> sessions_;
+};
+
+#endif // ACE_CAN_SESSION_SCHEDULER_H
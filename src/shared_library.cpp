@@ -0,0 +1,46 @@
+#include "shared_library.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+SharedLibrary::~SharedLibrary() {
+    if (handle_ == nullptr) {
+        return;
+    }
+#ifdef _WIN32
+    FreeLibrary(static_cast<HMODULE>(handle_));
+#else
+    dlclose(handle_);
+#endif
+}
+
+std::string SharedLibrary::Open(const std::string& path) {
+#ifdef _WIN32
+    HMODULE module = LoadLibraryA(path.c_str());
+    if (module == nullptr) {
+        return "Failed to load " + path + " (error " + std::to_string(GetLastError()) + ")";
+    }
+    handle_ = module;
+#else
+    handle_ = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle_ == nullptr) {
+        const char* error = dlerror();
+        return "Failed to load " + path + ": " + (error != nullptr ? error : "unknown error");
+    }
+#endif
+    return std::string();
+}
+
+void* SharedLibrary::Symbol(const char* name) const {
+    if (handle_ == nullptr) {
+        return nullptr;
+    }
+#ifdef _WIN32
+    return reinterpret_cast<void*>(GetProcAddress(static_cast<HMODULE>(handle_), name));
+#else
+    return dlsym(handle_, name);
+#endif
+}
@@ -0,0 +1,23 @@
+#ifndef ACE_CAN_SHARED_LIBRARY_H
+#define ACE_CAN_SHARED_LIBRARY_H
+
+#include <string>
+
+// A plugin library loaded at runtime (dlopen / LoadLibrary), unloaded on destruction.
+class SharedLibrary {
+public:
+    SharedLibrary() = default;
+    ~SharedLibrary();
+    SharedLibrary(const SharedLibrary&) = delete;
+    SharedLibrary& operator=(const SharedLibrary&) = delete;
+
+    // Returns why the library could not be loaded, or an empty string on success.
+    std::string Open(const std::string& path);
+    void* Symbol(const char* name) const;
+    bool IsOpen() const { return handle_ != nullptr; }
+
+private:
+    void* handle_ = nullptr;
+};
+
+#endif // ACE_CAN_SHARED_LIBRARY_H
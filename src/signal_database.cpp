@@ -0,0 +1,217 @@
+#include "signal_database.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include "ace_can.h"
+#include "can_frame.h"
+#include "compiled_db.h"
+#include "decoder_codegen.h"
+#include "napi_options.h"
+
+namespace {
+
+std::string Lowercase(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+Napi::Object SignalToJs(Napi::Env env, const SignalDef& signal) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("name", signal.name);
+    obj.Set("startBit", Napi::Number::New(env, signal.start_bit));
+    obj.Set("length", Napi::Number::New(env, signal.length));
+    obj.Set("byteOrder", signal.little_endian ? "little" : "big");
+    obj.Set("signed", Napi::Boolean::New(env, signal.is_signed));
+    if (signal.value_type != SignalDef::ValueType::Integer) {
+        obj.Set("float", Napi::Number::New(env, signal.value_type == SignalDef::ValueType::Float32 ? 32 : 64));
+    }
+    if (signal.mux == SignalDef::kMultiplexor) {
+        obj.Set("multiplexor", Napi::Boolean::New(env, true));
+    } else if (signal.mux >= 0) {
+        obj.Set("multiplexValue", Napi::Number::New(env, signal.mux));
+    }
+    obj.Set("factor", Napi::Number::New(env, signal.factor));
+    obj.Set("offset", Napi::Number::New(env, signal.offset));
+    obj.Set("min", Napi::Number::New(env, signal.minimum));
+    obj.Set("max", Napi::Number::New(env, signal.maximum));
+    obj.Set("unit", signal.unit);
+    return obj;
+}
+
+Napi::Object MessageToJs(Napi::Env env, const MessageDef& message) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("name", message.name);
+    obj.Set("id", Napi::Number::New(env, message.id));
+    obj.Set("extended", Napi::Boolean::New(env, message.extended));
+    obj.Set("fd", Napi::Boolean::New(env, message.fd));
+    obj.Set("length", Napi::Number::New(env, message.length));
+    Napi::Array signals = Napi::Array::New(env, message.signals.size());
+    for (size_t i = 0; i < message.signals.size(); ++i) {
+        signals.Set(static_cast<uint32_t>(i), SignalToJs(env, message.signals[i]));
+    }
+    obj.Set("signals", signals);
+    if (message.e2e) {
+        Napi::Object e2e = Napi::Object::New(env);
+        e2e.Set("profile", message.e2e->profile);
+        e2e.Set("dataId", Napi::Number::New(env, message.e2e->data_id));
+        e2e.Set("dataLength", Napi::Number::New(env, message.e2e->data_length));
+        e2e.Set("crcOffset", Napi::Number::New(env, message.e2e->crc_offset));
+        e2e.Set("counterOffset", Napi::Number::New(env, message.e2e->counter_offset));
+        obj.Set("e2e", e2e);
+    }
+    if (message.secoc) {
+        Napi::Object secoc = Napi::Object::New(env);
+        secoc.Set("dataId", Napi::Number::New(env, message.secoc->data_id));
+        secoc.Set("payloadLength", Napi::Number::New(env, message.secoc->payload_length));
+        secoc.Set("freshnessBits", Napi::Number::New(env, message.secoc->freshness_tx_bits));
+        secoc.Set("macBits", Napi::Number::New(env, message.secoc->mac_tx_bits));
+        secoc.Set("algorithm", message.secoc->algorithm);
+        obj.Set("secOc", secoc);
+    }
+    return obj;
+}
+
+} // namespace
+
+Napi::Object SignalDatabase::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "SignalDatabase", {
+        InstanceMethod("messages", &SignalDatabase::Messages),
+        InstanceMethod("decode", &SignalDatabase::Decode),
+        InstanceMethod("fromCache", &SignalDatabase::FromCache),
+        InstanceMethod("generateDecoder", &SignalDatabase::GenerateDecoder)
+    });
+    AddonData* data = env.GetInstanceData<AddonData>();
+    if (data != nullptr) {
+        data->signal_database = Napi::Persistent(func);
+    }
+    exports.Set("SignalDatabase", func);
+    return exports;
+}
+
+SignalDatabase* SignalDatabase::FromValue(Napi::Env env, const Napi::Value& value) {
+    AddonData* data = env.GetInstanceData<AddonData>();
+    if (data == nullptr || data->signal_database.IsEmpty() || !value.IsObject() ||
+        !value.As<Napi::Object>().InstanceOf(data->signal_database.Value())) {
+        return nullptr;
+    }
+    return SignalDatabase::Unwrap(value.As<Napi::Object>());
+}
+
+bool SignalDatabase::ParseFormat(const std::string& name, Format& out) {
+    std::string lowered = Lowercase(name);
+    if (lowered == "dbc") {
+        out = Format::Dbc;
+    } else if (lowered == "arxml") {
+        out = Format::Arxml;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+SignalDatabase::SignalDatabase(const Napi::CallbackInfo& info) : Napi::ObjectWrap<SignalDatabase>(info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected database file path").ThrowAsJavaScriptException();
+        return;
+    }
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    path_ = path;
+
+    std::string formatName;
+    std::string cachePath;
+    if (info.Length() >= 3 && info[2].IsObject() &&
+        !GetOptionalString(info[2].As<Napi::Object>(), "cache", cachePath)) {
+        Napi::TypeError::New(env, "options.cache must be a string").ThrowAsJavaScriptException();
+        return;
+    }
+    if (info.Length() >= 2 && info[1].IsString()) {
+        formatName = info[1].As<Napi::String>().Utf8Value();
+    } else {
+        size_t dot = path.find_last_of('.');
+        if (dot != std::string::npos) {
+            formatName = path.substr(dot + 1);
+        }
+    }
+    Format format = Format::Dbc;
+    if (!ParseFormat(formatName, format)) {
+        Napi::Error::New(env, "Unsupported database format: " + formatName).ThrowAsJavaScriptException();
+        return;
+    }
+
+    SourceFingerprint fingerprint;
+    if (!cachePath.empty()) {
+        std::string error = FingerprintFile(path, fingerprint);
+        if (!error.empty()) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return;
+        }
+        if (LoadCompiledTables(cachePath, fingerprint, tables_).empty()) {
+            from_cache_ = true;
+            return;
+        }
+        tables_ = DecodeTables();
+    }
+
+    std::string error = format == Format::Arxml ? LoadArxml(path, tables_) : LoadDbc(path, tables_);
+    if (!error.empty()) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return;
+    }
+    if (!cachePath.empty()) {
+        // Best effort: an unwritable cache only costs the next start a full parse.
+        SaveCompiledTables(cachePath, tables_, fingerprint);
+    }
+}
+
+Napi::Value SignalDatabase::Messages(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Array result = Napi::Array::New(env, tables_.messages.size());
+    for (size_t i = 0; i < tables_.messages.size(); ++i) {
+        result.Set(static_cast<uint32_t>(i), MessageToJs(env, tables_.messages[i]));
+    }
+    return result;
+}
+
+Napi::Value SignalDatabase::FromCache(const Napi::CallbackInfo& info) {
+    return Napi::Boolean::New(info.Env(), from_cache_);
+}
+
+// C++ source of a decoder plugin for these tables (see ace_can_decoder.h).
+Napi::Value SignalDatabase::GenerateDecoder(const Napi::CallbackInfo& info) {
+    size_t slash = path_.find_last_of("/\\");
+    return Napi::String::New(info.Env(), GenerateDecoderSource(tables_, slash == std::string::npos ? path_ : path_.substr(slash + 1)));
+}
+
+// decode({ id, data, flags? }) -> { name, signals: { [name]: value } } or null for unknown IDs.
+Napi::Value SignalDatabase::Decode(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected message object").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Napi::Object msgObj = info[0].As<Napi::Object>();
+    if (!msgObj.Get("id").IsNumber() || !msgObj.Get("data").IsBuffer()) {
+        Napi::TypeError::New(env, "Expected { id: number, data: Buffer }").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    uint32_t id = msgObj.Get("id").As<Napi::Number>().Uint32Value();
+    Napi::Value flags = msgObj.Get("flags");
+    bool extended = flags.IsNumber() ? (flags.As<Napi::Number>().Uint32Value() & kFrameFlagExtended) != 0 : id > 0x7FF;
+
+    const MessageDef* message = tables_.Find(id, extended);
+    if (message == nullptr) {
+        return env.Null();
+    }
+    Napi::Buffer<uint8_t> data = msgObj.Get("data").As<Napi::Buffer<uint8_t>>();
+    Napi::Object signals = Napi::Object::New(env);
+    DecodeMessage(*message, data.Data(), data.Length(), [&](const SignalDef& signal, double value) {
+        signals.Set(signal.name, Napi::Number::New(env, value));
+    });
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("name", message->name);
+    result.Set("signals", signals);
+    return result;
+}
@@ -0,0 +1,36 @@
+#ifndef ACE_CAN_SIGNAL_DATABASE_H
+#define ACE_CAN_SIGNAL_DATABASE_H
+
+#include <napi.h>
+#include <string>
+
+#include "decode_tables.h"
+
+// Decode tables loaded from a DBC or ARXML file, exposed to JS for lookups and decoding. With a
+// cache path, a compiled image of the tables is loaded instead of the source when it was built
+// from identical source content, and (re)written after parsing otherwise.
+class SignalDatabase : public Napi::ObjectWrap<SignalDatabase> {
+public:
+    enum class Format { Dbc, Arxml };
+
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    SignalDatabase(const Napi::CallbackInfo& info);
+
+    Napi::Value Messages(const Napi::CallbackInfo& info);
+    Napi::Value Decode(const Napi::CallbackInfo& info);
+    Napi::Value FromCache(const Napi::CallbackInfo& info);
+    Napi::Value GenerateDecoder(const Napi::CallbackInfo& info);
+
+    // Native access for other addon classes, from the JS thread; nullptr for anything but a SignalDatabase.
+    static SignalDatabase* FromValue(Napi::Env env, const Napi::Value& value);
+
+    static bool ParseFormat(const std::string& name, Format& out);
+    const DecodeTables& Tables() const { return tables_; }
+
+private:
+    std::string path_;
+    DecodeTables tables_;
+    bool from_cache_ = false;
+};
+
+#endif // ACE_CAN_SIGNAL_DATABASE_H
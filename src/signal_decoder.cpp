@@ -0,0 +1,413 @@
+#include "signal_decoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "ace_can.h"
+#include "can_frame.h"
+#include "signal_database.h"
+
+namespace {
+
+uint64_t MessageKey(uint32_t id, bool extended) {
+    return (extended ? (uint64_t{1} << 32) : 0) | id;
+}
+
+struct Collected {
+    std::vector<std::pair<uint32_t, double>> values;
+};
+
+void CollectValue(void* context, uint32_t signal, double value) {
+    static_cast<Collected*>(context)->values.emplace_back(signal, value);
+}
+
+// Keeps the benchmark loop from being optimized away without touching shared state.
+void SumValue(void* context, uint32_t, double value) {
+    *static_cast<double*>(context) += value;
+}
+
+} // namespace
+
+void SignalDecoder::Tap::OnFrame(const CanFrame& frame, int64_t) {
+    if ((frame.flags & (kFrameFlagRemote | kFrameFlagError)) != 0) {
+        return;
+    }
+    bool extended = (frame.flags & kFrameFlagExtended) != 0;
+    RcuPtr<std::vector<std::shared_ptr<SignalListener>>>::ReadGuard listeners(decoder_->listeners_);
+    int32_t count;
+    if (listeners->empty()) {
+        count = decoder_->DecodeFrame(frame.id, extended, frame.data, frame.length, &SignalDecoder::StoreLatest, decoder_);
+    } else {
+        values_.clear();
+        count = decoder_->DecodeFrame(frame.id, extended, frame.data, frame.length, &Tap::StoreAndCollect, this);
+        if (!values_.empty()) {
+            for (const std::shared_ptr<SignalListener>& listener : *listeners) {
+                listener->OnSignals(frame.timestamp, values_.data(), values_.size());
+            }
+        }
+    }
+    (count < 0 ? decoder_->unknown_ : decoder_->decoded_).fetch_add(1, std::memory_order_relaxed);
+}
+
+void SignalDecoder::Tap::StoreAndCollect(void* context, uint32_t signal, double value) {
+    Tap* tap = static_cast<Tap*>(context);
+    if (signal < tap->decoder_->signal_names_.size()) {
+        tap->decoder_->latest_[signal].store(value, std::memory_order_relaxed);
+        tap->values_.emplace_back(signal, value);
+    }
+}
+
+void SignalDecoder::StoreLatest(void* context, uint32_t signal, double value) {
+    SignalDecoder* decoder = static_cast<SignalDecoder*>(context);
+    if (signal < decoder->signal_names_.size()) {
+        decoder->latest_[signal].store(value, std::memory_order_relaxed);
+    }
+}
+
+Napi::Object SignalDecoder::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "SignalDecoder", {
+        InstanceMethod("latest", &SignalDecoder::Latest),
+        InstanceMethod("decode", &SignalDecoder::Decode),
+        InstanceMethod("encode", &SignalDecoder::Encode),
+        InstanceMethod("measure", &SignalDecoder::Measure),
+        InstanceMethod("stats", &SignalDecoder::Stats),
+        InstanceMethod("close", &SignalDecoder::Close)
+    });
+    AddonData* data = env.GetInstanceData<AddonData>();
+    if (data != nullptr) {
+        data->signal_decoder = Napi::Persistent(func);
+    }
+    exports.Set("SignalDecoder", func);
+    return exports;
+}
+
+SignalDecoder* SignalDecoder::FromValue(Napi::Env env, const Napi::Value& value) {
+    AddonData* data = env.GetInstanceData<AddonData>();
+    if (data == nullptr || data->signal_decoder.IsEmpty() || !value.IsObject() ||
+        !value.As<Napi::Object>().InstanceOf(data->signal_decoder.Value())) {
+        return nullptr;
+    }
+    return SignalDecoder::Unwrap(value.As<Napi::Object>());
+}
+
+// new SignalDecoder(source, bus?): source is a SignalDatabase or the path of a compiled decoder
+// plugin. Without a bus the decoder only serves decode()/encode()/measure().
+SignalDecoder::SignalDecoder(const Napi::CallbackInfo& info) : Napi::ObjectWrap<SignalDecoder>(info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1) {
+        Napi::TypeError::New(env, "Expected SignalDatabase or decoder plugin path").ThrowAsJavaScriptException();
+        return;
+    }
+    if (info[0].IsString()) {
+        std::string error = LoadPlugin(info[0].As<Napi::String>().Utf8Value());
+        if (!error.empty()) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return;
+        }
+    } else {
+        SignalDatabase* database = SignalDatabase::FromValue(env, info[0]);
+        if (database == nullptr) {
+            Napi::TypeError::New(env, "source must be a SignalDatabase or a plugin path").ThrowAsJavaScriptException();
+            return;
+        }
+        database_ref_ = Napi::Persistent(info[0].As<Napi::Object>());
+        UseTables(database->Tables());
+    }
+
+    latest_ = std::make_unique<std::atomic<double>[]>(signal_names_.size());
+    for (size_t i = 0; i < signal_names_.size(); ++i) {
+        latest_[i].store(std::numeric_limits<double>::quiet_NaN(), std::memory_order_relaxed);
+    }
+
+    if (info.Length() > 1 && !info[1].IsUndefined() && !info[1].IsNull()) {
+        bus_ = CANBus::FromValue(env, info[1]);
+        if (bus_ == nullptr) {
+            Napi::TypeError::New(env, "bus must be a CANBus instance").ThrowAsJavaScriptException();
+            return;
+        }
+        bus_ref_ = Napi::Persistent(info[1].As<Napi::Object>());
+        tap_ = std::make_shared<Tap>(this);
+        bus_->AddTap(tap_);
+    }
+}
+
+SignalDecoder::~SignalDecoder() {
+    Shutdown();
+}
+
+std::string SignalDecoder::LoadPlugin(const std::string& path) {
+    std::string error = library_.Open(path);
+    if (!error.empty()) {
+        return error;
+    }
+    auto entry = reinterpret_cast<ace_can_decoder_entry>(library_.Symbol(ACE_CAN_DECODER_ENTRY));
+    if (entry == nullptr) {
+        return path + " does not export " ACE_CAN_DECODER_ENTRY;
+    }
+    const ace_can_decoder* plugin = entry();
+    if (plugin == nullptr || plugin->abi_version != ACE_CAN_DECODER_ABI_VERSION || plugin->decode == nullptr ||
+        plugin->encode == nullptr) {
+        return path + " is not a compatible decoder plugin (ABI version " +
+               std::to_string(ACE_CAN_DECODER_ABI_VERSION) + " expected)";
+    }
+    for (uint32_t i = 0; i < plugin->message_count; ++i) {
+        const ace_can_decoder_message& source = plugin->messages[i];
+        if (source.first_signal + static_cast<uint64_t>(source.signal_count) > plugin->signal_count) {
+            return path + ": message " + std::to_string(i) + " refers to signals out of range";
+        }
+        Message message;
+        message.name = source.name != nullptr ? source.name : "";
+        message.id = source.id;
+        message.extended = source.extended != 0;
+        message.fd = source.fd != 0;
+        message.length = source.length;
+        message.first_signal = source.first_signal;
+        message.signal_count = source.signal_count;
+        by_id_.emplace(MessageKey(message.id, message.extended), messages_.size());
+        messages_.push_back(std::move(message));
+    }
+    signal_names_.resize(plugin->signal_count);
+    for (const Message& message : messages_) {
+        for (uint32_t i = 0; i < message.signal_count; ++i) {
+            const char* name = plugin->signal_names[message.first_signal + i];
+            signal_names_[message.first_signal + i] = message.name + "." + (name != nullptr ? name : "");
+        }
+    }
+    plugin_ = plugin;
+    return std::string();
+}
+
+// Numbers signals in message order, as the generated plugins do.
+void SignalDecoder::UseTables(const DecodeTables& tables) {
+    tables_ = &tables;
+    for (const MessageDef& source : tables.messages) {
+        Message message;
+        message.name = source.name;
+        message.id = source.id;
+        message.extended = source.extended;
+        message.fd = source.fd;
+        message.length = source.length;
+        message.first_signal = static_cast<uint32_t>(signal_names_.size());
+        message.signal_count = static_cast<uint32_t>(source.signals.size());
+        table_first_signal_.push_back(message.first_signal);
+        for (const SignalDef& signal : source.signals) {
+            signal_names_.push_back(source.name + "." + signal.name);
+        }
+        by_id_[MessageKey(message.id, message.extended)] = messages_.size();
+        messages_.push_back(std::move(message));
+    }
+}
+
+const SignalDecoder::Message* SignalDecoder::FindMessage(uint32_t id, bool extended) const {
+    auto found = by_id_.find(MessageKey(id, extended));
+    return found != by_id_.end() ? &messages_[found->second] : nullptr;
+}
+
+int32_t SignalDecoder::DecodeFrame(uint32_t id, bool extended, const uint8_t* data, uint32_t length,
+                                   ace_can_signal_sink sink, void* context) const {
+    if (plugin_ != nullptr) {
+        return plugin_->decode(id, extended ? 1 : 0, data, length, sink, context);
+    }
+    const MessageDef* message = tables_->Find(id, extended);
+    if (message == nullptr) {
+        return -1;
+    }
+    uint32_t first = table_first_signal_[static_cast<size_t>(message - tables_->messages.data())];
+    int32_t count = 0;
+    DecodeMessage(*message, data, length, [&](const SignalDef& signal, double value) {
+        sink(context, first + static_cast<uint32_t>(&signal - message->signals.data()), value);
+        ++count;
+    });
+    return count;
+}
+
+void SignalDecoder::AddListener(std::shared_ptr<SignalListener> listener) {
+    listeners_.Update([&listener](std::vector<std::shared_ptr<SignalListener>>& listeners) {
+        listeners.push_back(std::move(listener));
+    });
+}
+
+void SignalDecoder::RemoveListener(const SignalListener* listener) {
+    listeners_.Update([listener](std::vector<std::shared_ptr<SignalListener>>& listeners) {
+        listeners.erase(std::remove_if(listeners.begin(), listeners.end(),
+                                       [listener](const std::shared_ptr<SignalListener>& entry) {
+                                           return entry.get() == listener;
+                                       }),
+                        listeners.end());
+    });
+}
+
+void SignalDecoder::Shutdown() {
+    if (bus_ != nullptr && tap_) {
+        // RemoveTap waits for a tap call in progress, so no OnFrame runs after this.
+        bus_->RemoveTap(tap_.get());
+    }
+    tap_.reset();
+}
+
+// latest() -> { "Message.Signal": value } for every signal decoded so far.
+Napi::Value SignalDecoder::Latest(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object result = Napi::Object::New(env);
+    for (size_t i = 0; i < signal_names_.size(); ++i) {
+        double value = latest_[i].load(std::memory_order_relaxed);
+        if (!std::isnan(value)) {
+            result.Set(signal_names_[i], Napi::Number::New(env, value));
+        }
+    }
+    return result;
+}
+
+// decode({ id, data, flags? }) -> { name, signals } or null, like SignalDatabase.decode().
+Napi::Value SignalDecoder::Decode(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected message object").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Napi::Object msgObj = info[0].As<Napi::Object>();
+    if (!msgObj.Get("id").IsNumber() || !msgObj.Get("data").IsBuffer()) {
+        Napi::TypeError::New(env, "Expected { id: number, data: Buffer }").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    uint32_t id = msgObj.Get("id").As<Napi::Number>().Uint32Value();
+    Napi::Value flags = msgObj.Get("flags");
+    bool extended = flags.IsNumber() ? (flags.As<Napi::Number>().Uint32Value() & kFrameFlagExtended) != 0 : id > 0x7FF;
+    Napi::Buffer<uint8_t> data = msgObj.Get("data").As<Napi::Buffer<uint8_t>>();
+
+    Collected collected;
+    if (DecodeFrame(id, extended, data.Data(), static_cast<uint32_t>(data.Length()), &CollectValue, &collected) < 0) {
+        return env.Null();
+    }
+    const Message* message = FindMessage(id, extended);
+    Napi::Object signals = Napi::Object::New(env);
+    for (const auto& [signal, value] : collected.values) {
+        if (message != nullptr && signal >= message->first_signal && signal < message->first_signal + message->signal_count) {
+            signals.Set(signal_names_[signal].substr(message->name.size() + 1), Napi::Number::New(env, value));
+        }
+    }
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("name", message != nullptr ? message->name : std::string());
+    result.Set("signals", signals);
+    return result;
+}
+
+// encode(messageName, { [signal]: value }) -> { id, data }; signals left out are zero.
+Napi::Value SignalDecoder::Encode(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsObject()) {
+        Napi::TypeError::New(env, "Expected message name and signal values").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    size_t index = 0;
+    while (index < messages_.size() && messages_[index].name != name) {
+        ++index;
+    }
+    if (index == messages_.size()) {
+        Napi::RangeError::New(env, "Unknown message: " + name).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    const Message& message = messages_[index];
+
+    std::vector<double> values(message.signal_count, std::numeric_limits<double>::quiet_NaN());
+    Napi::Object input = info[1].As<Napi::Object>();
+    Napi::Array keys = input.GetPropertyNames();
+    for (uint32_t k = 0; k < keys.Length(); ++k) {
+        std::string key = keys.Get(k).As<Napi::String>().Utf8Value();
+        Napi::Value value = input.Get(key);
+        if (!value.IsNumber()) {
+            Napi::TypeError::New(env, "Signal value must be a number: " + key).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        uint32_t i = 0;
+        while (i < message.signal_count && signal_names_[message.first_signal + i].compare(name.size() + 1, std::string::npos, key) != 0) {
+            ++i;
+        }
+        if (i == message.signal_count) {
+            Napi::RangeError::New(env, "Unknown signal " + key + " in " + name).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        values[i] = value.As<Napi::Number>().DoubleValue();
+    }
+
+    uint8_t data[64] = {};
+    int32_t length = 0;
+    if (plugin_ != nullptr) {
+        length = plugin_->encode(static_cast<uint32_t>(index), values.data(), data, sizeof(data));
+    } else {
+        const MessageDef& definition = tables_->messages[index];
+        length = std::min<int32_t>(definition.length, sizeof(data));
+        for (uint32_t i = 0; i < message.signal_count; ++i) {
+            if (!std::isnan(values[i])) {
+                const SignalDef& signal = definition.signals[i];
+                InsertRaw(signal, RawValue(signal, values[i]), data, static_cast<size_t>(length));
+            }
+        }
+    }
+    if (length < 0) {
+        Napi::Error::New(env, "Decoder plugin failed to encode " + name).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("id", Napi::Number::New(env, message.id));
+    result.Set("data", Napi::Buffer<uint8_t>::Copy(env, data, static_cast<size_t>(length)));
+    return result;
+}
+
+// measure(batch, rounds = 1) -> { frames, signals, nsPerFrame }: decodes a frame batch `rounds`
+// times on the calling thread through the same path as the receive-thread tap.
+Napi::Value SignalDecoder::Measure(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsBuffer()) {
+        Napi::TypeError::New(env, "Expected frame batch Buffer").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    uint32_t rounds = 1;
+    if (info.Length() > 1 && info[1].IsNumber()) {
+        rounds = std::max<uint32_t>(1, info[1].As<Napi::Number>().Uint32Value());
+    }
+    Napi::Buffer<uint8_t> batch = info[0].As<Napi::Buffer<uint8_t>>();
+    std::vector<CanFrame> frames(batch.Length() / kFrameRecordSize);
+    if (!frames.empty()) {
+        std::memcpy(frames.data(), batch.Data(), frames.size() * kFrameRecordSize);
+    }
+
+    double sum = 0.0;
+    uint64_t signals = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < rounds; ++round) {
+        for (const CanFrame& frame : frames) {
+            int32_t count = DecodeFrame(frame.id, (frame.flags & kFrameFlagExtended) != 0, frame.data, frame.length,
+                                        &SumValue, &sum);
+            signals += count > 0 ? static_cast<uint64_t>(count) : 0;
+        }
+    }
+    double elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    uint64_t total = static_cast<uint64_t>(frames.size()) * rounds;
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("frames", Napi::Number::New(env, static_cast<double>(total)));
+    result.Set("signals", Napi::Number::New(env, static_cast<double>(signals)));
+    result.Set("nsPerFrame", Napi::Number::New(env, total > 0 ? elapsedNs / total : 0.0));
+    return result;
+}
+
+Napi::Value SignalDecoder::Stats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("backend", plugin_ != nullptr ? "plugin" : "tables");
+    result.Set("decoded", Napi::Number::New(env, static_cast<double>(decoded_.load(std::memory_order_relaxed))));
+    result.Set("unknown", Napi::Number::New(env, static_cast<double>(unknown_.load(std::memory_order_relaxed))));
+    return result;
+}
+
+// Detaches from the bus; decode()/encode() keep working. The CANBus stays open.
+Napi::Value SignalDecoder::Close(const Napi::CallbackInfo& info) {
+    Shutdown();
+    return info.Env().Undefined();
+}
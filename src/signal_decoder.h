@@ -0,0 +1,102 @@
+#ifndef ACE_CAN_SIGNAL_DECODER_H
+#define ACE_CAN_SIGNAL_DECODER_H
+
+#include <napi.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ace_can_decoder.h"
+#include "decode_tables.h"
+#include "frame_tap.h"
+#include "rcu.h"
+#include "shared_library.h"
+#include "signal_listener.h"
+
+class CANBus;
+
+// Decodes every received frame on the receive thread and keeps the latest physical value of each
+// signal. Decoding runs either through the generic tables of a SignalDatabase or through a compiled
+// decoder plugin (ace_can_decoder.h) generated from one; both number signals the same way.
+class SignalDecoder : public Napi::ObjectWrap<SignalDecoder> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    SignalDecoder(const Napi::CallbackInfo& info);
+    ~SignalDecoder();
+
+    Napi::Value Latest(const Napi::CallbackInfo& info);
+    Napi::Value Decode(const Napi::CallbackInfo& info);
+    Napi::Value Encode(const Napi::CallbackInfo& info);
+    Napi::Value Measure(const Napi::CallbackInfo& info);
+    Napi::Value Stats(const Napi::CallbackInfo& info);
+    Napi::Value Close(const Napi::CallbackInfo& info);
+
+    struct Message {
+        std::string name;
+        uint32_t id = 0;
+        bool extended = false;
+        bool fd = false;
+        uint16_t length = 0;
+        uint32_t first_signal = 0;
+        uint32_t signal_count = 0;
+    };
+
+    // Native access for other addon classes, from the JS thread; nullptr for anything but a SignalDecoder.
+    static SignalDecoder* FromValue(Napi::Env env, const Napi::Value& value);
+
+    const std::vector<Message>& Messages() const { return messages_; }
+    // "Message.Signal", indexed like the signals passed to decode sinks.
+    const std::vector<std::string>& SignalNames() const { return signal_names_; }
+    const Message* FindMessage(uint32_t id, bool extended) const;
+    // Same contract as ace_can_decoder::decode, whichever backend is in use. Safe on any thread.
+    int32_t DecodeFrame(uint32_t id, bool extended, const uint8_t* data, uint32_t length, ace_can_signal_sink sink,
+                        void* context) const;
+    // Values decoded from the bus from now on are also passed to `listener`.
+    void AddListener(std::shared_ptr<SignalListener> listener);
+    // Returns once the receive path can no longer call the listener.
+    void RemoveListener(const SignalListener* listener);
+
+private:
+    class Tap : public FrameTap {
+    public:
+        explicit Tap(SignalDecoder* decoder) : decoder_(decoder) {}
+        void OnFrame(const CanFrame& frame, int64_t hostUs) override;
+
+    private:
+        static void StoreAndCollect(void* context, uint32_t signal, double value);
+
+        SignalDecoder* decoder_;
+        std::vector<std::pair<uint32_t, double>> values_; // scratch for listeners
+    };
+
+    static void StoreLatest(void* context, uint32_t signal, double value);
+
+    std::string LoadPlugin(const std::string& path);
+    void UseTables(const DecodeTables& tables);
+    void Shutdown();
+
+    // Backends: generic tables (owned by the referenced SignalDatabase) or a plugin.
+    const DecodeTables* tables_ = nullptr;
+    std::vector<uint32_t> table_first_signal_; // by tables_ message index
+    Napi::ObjectReference database_ref_;
+    SharedLibrary library_;
+    const ace_can_decoder* plugin_ = nullptr;
+
+    std::vector<Message> messages_;
+    std::unordered_map<uint64_t, size_t> by_id_; // (extended << 32 | id) -> messages_
+    std::vector<std::string> signal_names_;
+    std::unique_ptr<std::atomic<double>[]> latest_; // NaN until first decoded
+    std::atomic<uint64_t> decoded_{0};
+    std::atomic<uint64_t> unknown_{0};
+    RcuPtr<std::vector<std::shared_ptr<SignalListener>>> listeners_;
+
+    CANBus* bus_ = nullptr;
+    Napi::ObjectReference bus_ref_;
+    std::shared_ptr<Tap> tap_;
+};
+
+#endif // ACE_CAN_SIGNAL_DECODER_H
@@ -0,0 +1,311 @@
+#include "signal_history.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "downsample.h"
+#include "napi_options.h"
+#include "signal_decoder.h"
+
+namespace {
+
+constexpr uint32_t kDefaultPoints = 1000;
+constexpr double kDefaultMaxSamples = 1 << 20;
+
+Napi::Float64Array ToFloat64Array(Napi::Env env, const std::vector<double>& source, const std::vector<uint32_t>* picked) {
+    size_t count = picked != nullptr ? picked->size() : source.size();
+    Napi::Float64Array array = Napi::Float64Array::New(env, count);
+    double* out = array.Data();
+    if (picked == nullptr) {
+        std::memcpy(out, source.data(), count * sizeof(double));
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = source[(*picked)[i]];
+        }
+    }
+    return array;
+}
+
+} // namespace
+
+void SignalHistory::Listener::OnSignals(uint64_t timestamp, const std::pair<uint32_t, double>* values, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t signal = values[i].first;
+        if (signal < history_->series_by_signal_.size() && history_->series_by_signal_[signal] >= 0) {
+            history_->Append(*history_->series_[static_cast<size_t>(history_->series_by_signal_[signal])], timestamp,
+                             values[i].second);
+        }
+    }
+}
+
+Napi::Object SignalHistory::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "SignalHistory", {
+        InstanceMethod("query", &SignalHistory::Query),
+        InstanceMethod("signals", &SignalHistory::Signals),
+        InstanceMethod("stats", &SignalHistory::Stats),
+        InstanceMethod("clear", &SignalHistory::Clear),
+        InstanceMethod("close", &SignalHistory::Close),
+    });
+    exports.Set("SignalHistory", func);
+    return exports;
+}
+
+// new SignalHistory(decoder, { signals, durationMs = 600000, maxSamples = 1048576 }?): records the
+// named "Message.Signal" values (default: every signal) that `decoder` decodes from its bus, keeping
+// durationMs of history and at most about maxSamples samples per signal.
+SignalHistory::SignalHistory(const Napi::CallbackInfo& info) : Napi::ObjectWrap<SignalHistory>(info) {
+    Napi::Env env = info.Env();
+    decoder_ = info.Length() > 0 ? SignalDecoder::FromValue(env, info[0]) : nullptr;
+    if (decoder_ == nullptr) {
+        Napi::TypeError::New(env, "Expected (decoder: SignalDecoder, options?)").ThrowAsJavaScriptException();
+        return;
+    }
+    decoder_ref_ = Napi::Persistent(info[0].As<Napi::Object>());
+
+    const std::vector<std::string>& signalNames = decoder_->SignalNames();
+    double durationMs = static_cast<double>(duration_us_ / 1000);
+    double maxSamples = kDefaultMaxSamples;
+    std::vector<std::string> requested;
+    bool all = true;
+    if (info.Length() > 1 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (!GetOptionalDouble(options, "durationMs", durationMs) ||
+            !GetOptionalDouble(options, "maxSamples", maxSamples)) {
+            Napi::TypeError::New(env, "Invalid signal history option type").ThrowAsJavaScriptException();
+            return;
+        }
+        if (options.Has("signals") && !options.Get("signals").IsUndefined()) {
+            Napi::Value signals = options.Get("signals");
+            if (!signals.IsArray()) {
+                Napi::TypeError::New(env, "signals must be an array of signal names").ThrowAsJavaScriptException();
+                return;
+            }
+            Napi::Array list = signals.As<Napi::Array>();
+            for (uint32_t i = 0; i < list.Length(); ++i) {
+                Napi::Value entry = list.Get(i);
+                if (!entry.IsString()) {
+                    Napi::TypeError::New(env, "signals must be an array of signal names").ThrowAsJavaScriptException();
+                    return;
+                }
+                requested.push_back(entry.As<Napi::String>().Utf8Value());
+            }
+            all = false;
+        }
+    }
+    if (!(durationMs > 0) || !(maxSamples >= 1)) {
+        Napi::RangeError::New(env, "durationMs and maxSamples must be positive").ThrowAsJavaScriptException();
+        return;
+    }
+    duration_us_ = static_cast<uint64_t>(std::min(durationMs * 1000, 1e18));
+    // One block more than needed, since the oldest one is partly outside the window.
+    max_blocks_ = static_cast<size_t>(std::ceil(std::min(maxSamples, 1e12) / kBlockSamples)) + 1;
+
+    series_by_signal_.assign(signalNames.size(), -1);
+    if (all) {
+        requested = signalNames;
+    }
+    std::unordered_map<std::string, uint32_t> signalIndex;
+    for (uint32_t i = 0; i < signalNames.size(); ++i) {
+        signalIndex.emplace(signalNames[i], i);
+    }
+    for (const std::string& name : requested) {
+        auto found = signalIndex.find(name);
+        if (found == signalIndex.end()) {
+            Napi::RangeError::New(env, "Unknown signal " + name).ThrowAsJavaScriptException();
+            return;
+        }
+        if (series_by_signal_[found->second] >= 0) {
+            continue;
+        }
+        series_by_signal_[found->second] = static_cast<int32_t>(series_.size());
+        by_name_.emplace(name, series_.size());
+        names_.push_back(name);
+        series_.push_back(std::make_unique<Series>());
+    }
+
+    listener_ = std::make_shared<Listener>(this);
+    decoder_->AddListener(listener_);
+}
+
+SignalHistory::~SignalHistory() {
+    Shutdown();
+}
+
+void SignalHistory::Append(Series& series, uint64_t timestamp, double value) {
+    std::lock_guard<std::mutex> lock(series.mutex);
+    if (!series.blocks.empty() && timestamp < series.last) {
+        Reset(series); // the device clock restarted
+    }
+    Block* block = series.blocks.empty() ? nullptr : series.blocks.back().get();
+    if (block == nullptr || block->count == kBlockSamples ||
+        timestamp - block->base > std::numeric_limits<uint32_t>::max()) {
+        if (series.spare.empty()) {
+            series.spare.push_back(std::make_unique<Block>());
+            blocks_.fetch_add(1, std::memory_order_relaxed);
+        }
+        series.blocks.push_back(std::move(series.spare.back()));
+        series.spare.pop_back();
+        block = series.blocks.back().get();
+        block->base = timestamp;
+        block->count = 0;
+    }
+    block->offsets[block->count] = static_cast<uint32_t>(timestamp - block->base);
+    block->values[block->count] = value;
+    block->count++;
+    series.samples++;
+    series.last = timestamp;
+    appended_.fetch_add(1, std::memory_order_relaxed);
+
+    // Drop whole blocks that fell out of the window or exceed the sample budget.
+    while (series.blocks.size() > 1 && (series.blocks.size() > max_blocks_ ||
+                                        series.blocks.front()->Last() + duration_us_ < timestamp)) {
+        series.samples -= series.blocks.front()->count;
+        series.spare.push_back(std::move(series.blocks.front()));
+        series.blocks.pop_front();
+    }
+}
+
+// Caller holds series.mutex.
+void SignalHistory::Reset(Series& series) {
+    for (std::unique_ptr<Block>& block : series.blocks) {
+        series.spare.push_back(std::move(block));
+    }
+    series.blocks.clear();
+    series.samples = 0;
+    series.last = 0;
+}
+
+void SignalHistory::Shutdown() {
+    if (decoder_ != nullptr && listener_) {
+        // RemoveListener waits for a listener call in progress, so no OnSignals runs after this.
+        decoder_->RemoveListener(listener_.get());
+    }
+    listener_.reset();
+}
+
+// query(signal, { from, to, points = 1000, method = 'lttb' }?) -> { timestamps, values }
+// Samples with from <= timestamp <= to (default: the last durationMs), downsampled to at most
+// `points` when there are more; method is 'lttb' or 'minmax'.
+Napi::Value SignalHistory::Query(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    auto found = info.Length() > 0 && info[0].IsString() ? by_name_.find(info[0].As<Napi::String>().Utf8Value())
+                                                         : by_name_.end();
+    if (found == by_name_.end()) {
+        Napi::RangeError::New(env, "Expected the name of a recorded signal").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    double from = std::numeric_limits<double>::quiet_NaN();
+    double to = std::numeric_limits<double>::quiet_NaN();
+    uint32_t points = kDefaultPoints;
+    std::string method = "lttb";
+    if (info.Length() > 1 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (!GetOptionalDouble(options, "from", from) || !GetOptionalDouble(options, "to", to) ||
+            !GetOptionalUint32(options, "points", points) || !GetOptionalString(options, "method", method)) {
+            Napi::TypeError::New(env, "Invalid query option type").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+    }
+    if (method != "lttb" && method != "minmax") {
+        Napi::RangeError::New(env, "method must be 'lttb' or 'minmax'").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (points < 3) {
+        Napi::RangeError::New(env, "points must be at least 3").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    // Copy the range out so the receive thread only waits for the copy, not the downsampling.
+    Series& series = *series_[found->second];
+    times_.clear();
+    values_.clear();
+    {
+        std::lock_guard<std::mutex> lock(series.mutex);
+        if (std::isnan(to)) {
+            to = static_cast<double>(series.last);
+        }
+        if (std::isnan(from)) {
+            from = series.last > duration_us_ ? static_cast<double>(series.last - duration_us_) : 0;
+        }
+        auto first = std::lower_bound(series.blocks.begin(), series.blocks.end(), from,
+                                      [](const std::unique_ptr<Block>& block, double time) {
+                                          return static_cast<double>(block->Last()) < time;
+                                      });
+        for (auto it = first; it != series.blocks.end() && static_cast<double>((*it)->base) <= to; ++it) {
+            const Block& block = **it;
+            const uint32_t* begin = block.offsets;
+            const uint32_t* end = block.offsets + block.count;
+            double base = static_cast<double>(block.base);
+            if (from > base) {
+                begin = std::lower_bound(begin, end, from - base,
+                                         [](uint32_t offset, double time) { return offset < time; });
+            }
+            if (to - base < static_cast<double>(block.offsets[block.count - 1])) {
+                end = std::upper_bound(begin, end, to - base,
+                                       [](double time, uint32_t offset) { return time < offset; });
+            }
+            for (const uint32_t* p = begin; p != end; ++p) {
+                times_.push_back(base + *p);
+                values_.push_back(block.values[p - block.offsets]);
+            }
+        }
+    }
+
+    const std::vector<uint32_t>* picked = nullptr;
+    if (times_.size() > points) {
+        picked_.clear();
+        if (method == "lttb") {
+            PickLttb(times_.data(), values_.data(), times_.size(), points, picked_);
+        } else {
+            PickMinMax(times_.data(), values_.data(), times_.size(), points, picked_);
+        }
+        picked = &picked_;
+    }
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("timestamps", ToFloat64Array(env, times_, picked));
+    result.Set("values", ToFloat64Array(env, values_, picked));
+    return result;
+}
+
+// signals() -> recorded "Message.Signal" names
+Napi::Value SignalHistory::Signals(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Array result = Napi::Array::New(env, names_.size());
+    for (uint32_t i = 0; i < names_.size(); ++i) {
+        result.Set(i, names_[i]);
+    }
+    return result;
+}
+
+Napi::Value SignalHistory::Stats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    size_t samples = 0;
+    for (const std::unique_ptr<Series>& series : series_) {
+        std::lock_guard<std::mutex> lock(series->mutex);
+        samples += series->samples;
+    }
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("signals", Napi::Number::New(env, static_cast<double>(series_.size())));
+    result.Set("samples", Napi::Number::New(env, static_cast<double>(samples)));
+    result.Set("appended", Napi::Number::New(env, static_cast<double>(appended_.load(std::memory_order_relaxed))));
+    result.Set("bytes", Napi::Number::New(env, static_cast<double>(blocks_.load(std::memory_order_relaxed) *
+                                                                    sizeof(Block))));
+    return result;
+}
+
+// Drops every recorded sample; recording continues.
+Napi::Value SignalHistory::Clear(const Napi::CallbackInfo& info) {
+    for (const std::unique_ptr<Series>& series : series_) {
+        std::lock_guard<std::mutex> lock(series->mutex);
+        Reset(*series);
+    }
+    return info.Env().Undefined();
+}
+
+// Stops recording; the history stays queryable and the decoder keeps running.
+Napi::Value SignalHistory::Close(const Napi::CallbackInfo& info) {
+    Shutdown();
+    return info.Env().Undefined();
+}
@@ -0,0 +1,90 @@
+#ifndef ACE_CAN_SIGNAL_HISTORY_H
+#define ACE_CAN_SIGNAL_HISTORY_H
+
+#include <napi.h>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "signal_listener.h"
+
+class SignalDecoder;
+
+// Keeps the recent history of decoded signals in native ring buffers, fed on the receive thread by
+// a SignalDecoder, and answers time-range queries downsampled to a point budget (LTTB or min/max
+// per time bucket) as Float64Arrays, for plotting without growing and slicing JS arrays.
+//
+// Each signal stores its samples in fixed-size blocks: a 64-bit base timestamp per block and a
+// 32-bit offset plus the double value per sample, 12 bytes a sample. Blocks older than the window
+// are recycled, so a signal at a steady rate stops allocating once its window is full.
+class SignalHistory : public Napi::ObjectWrap<SignalHistory> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    SignalHistory(const Napi::CallbackInfo& info);
+    ~SignalHistory();
+
+    Napi::Value Query(const Napi::CallbackInfo& info);
+    Napi::Value Signals(const Napi::CallbackInfo& info);
+    Napi::Value Stats(const Napi::CallbackInfo& info);
+    Napi::Value Clear(const Napi::CallbackInfo& info);
+    Napi::Value Close(const Napi::CallbackInfo& info);
+
+private:
+    static constexpr uint32_t kBlockSamples = 1024;
+
+    struct Block {
+        uint64_t base = 0; // timestamp of the first sample
+        uint32_t count = 0;
+        uint32_t offsets[kBlockSamples]; // timestamp - base
+        double values[kBlockSamples];
+
+        uint64_t Last() const { return base + offsets[count - 1]; }
+    };
+
+    struct Series {
+        std::mutex mutex; // receive thread appends, JS thread queries
+        std::deque<std::unique_ptr<Block>> blocks; // oldest first, none empty
+        std::vector<std::unique_ptr<Block>> spare;
+        uint64_t last = 0;
+        size_t samples = 0;
+    };
+
+    class Listener : public SignalListener {
+    public:
+        explicit Listener(SignalHistory* history) : history_(history) {}
+        void OnSignals(uint64_t timestamp, const std::pair<uint32_t, double>* values, size_t count) override;
+
+    private:
+        SignalHistory* history_;
+    };
+
+    void Append(Series& series, uint64_t timestamp, double value);
+    static void Reset(Series& series);
+    void Shutdown();
+
+    uint64_t duration_us_ = 600000000; // 10 minutes
+    size_t max_blocks_ = 0; // per signal, from maxSamples
+    std::vector<std::string> names_; // by series
+    std::unordered_map<std::string, size_t> by_name_;
+    std::vector<int32_t> series_by_signal_; // decoder signal index -> series, -1 if not recorded
+    std::vector<std::unique_ptr<Series>> series_;
+    std::atomic<uint64_t> appended_{0};
+    std::atomic<uint64_t> blocks_{0}; // allocated, spares included
+
+    SignalDecoder* decoder_ = nullptr;
+    Napi::ObjectReference decoder_ref_;
+    std::shared_ptr<Listener> listener_;
+
+    // Query scratch, JS thread only.
+    std::vector<double> times_;
+    std::vector<double> values_;
+    std::vector<uint32_t> picked_;
+};
+
+#endif // ACE_CAN_SIGNAL_HISTORY_H
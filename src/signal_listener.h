@@ -0,0 +1,18 @@
+#ifndef ACE_CAN_SIGNAL_LISTENER_H
+#define ACE_CAN_SIGNAL_LISTENER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Native observer of the values a SignalDecoder decodes from its bus. Listeners run on the receive
+// thread right after each frame is decoded, with the frame timestamp and its (signal index, value)
+// pairs, signal indexes as in SignalDecoder::SignalNames(). They must not block.
+class SignalListener {
+public:
+    virtual ~SignalListener() = default;
+
+    virtual void OnSignals(uint64_t timestamp, const std::pair<uint32_t, double>* values, size_t count) = 0;
+};
+
+#endif // ACE_CAN_SIGNAL_LISTENER_H
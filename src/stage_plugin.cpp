@@ -0,0 +1,92 @@
+#include "stage_plugin.h"
+
+#include <algorithm>
+#include <cstddef>
+
+static_assert(sizeof(ace_can_frame) == sizeof(CanFrame), "ace_can_frame must match CanFrame");
+static_assert(offsetof(ace_can_frame, timestamp) == offsetof(CanFrame, timestamp) &&
+                  offsetof(ace_can_frame, id) == offsetof(CanFrame, id) &&
+                  offsetof(ace_can_frame, flags) == offsetof(CanFrame, flags) &&
+                  offsetof(ace_can_frame, length) == offsetof(CanFrame, length) &&
+                  offsetof(ace_can_frame, channel) == offsetof(CanFrame, channel) &&
+                  offsetof(ace_can_frame, data) == offsetof(CanFrame, data),
+              "ace_can_frame must match CanFrame");
+static_assert(ACE_CAN_FLAG_EXTENDED == kFrameFlagExtended && ACE_CAN_FLAG_REMOTE == kFrameFlagRemote &&
+                  ACE_CAN_FLAG_FD == kFrameFlagFd && ACE_CAN_FLAG_BRS == kFrameFlagBrs &&
+                  ACE_CAN_FLAG_ESI == kFrameFlagEsi && ACE_CAN_FLAG_TX == kFrameFlagTx &&
+                  ACE_CAN_FLAG_ERROR == kFrameFlagError,
+              "ace_can_stage.h flags must match can_frame.h");
+
+StagePlugin::~StagePlugin() {
+    Destroy();
+}
+
+std::string StagePlugin::Load(const std::string& path, const std::string& config) {
+    std::string error = library_.Open(path);
+    if (!error.empty()) {
+        return error;
+    }
+    auto entry = reinterpret_cast<ace_can_stage_entry>(library_.Symbol(ACE_CAN_STAGE_ENTRY));
+    if (entry == nullptr) {
+        return path + " does not export " ACE_CAN_STAGE_ENTRY;
+    }
+    const ace_can_stage* plugin = entry();
+    if (plugin == nullptr || plugin->abi_version != ACE_CAN_STAGE_ABI_VERSION || plugin->create == nullptr ||
+        plugin->process == nullptr || plugin->destroy == nullptr) {
+        return path + " is not a compatible receive stage (ABI version " + std::to_string(ACE_CAN_STAGE_ABI_VERSION) +
+               " expected)";
+    }
+    host_.context = this;
+    host_.emit = &StagePlugin::Emit;
+    char message[256] = {};
+    instance_ = plugin->create(config.c_str(), &host_, message, sizeof(message));
+    if (instance_ == nullptr) {
+        message[sizeof(message) - 1] = '\0';
+        return std::string(plugin->name != nullptr ? plugin->name : path) + ": " +
+               (message[0] != '\0' ? message : "create failed");
+    }
+    plugin_ = plugin;
+    return std::string();
+}
+
+void StagePlugin::Emit(void* context, uint32_t tag, const void* data, uint32_t length) {
+    StagePlugin* owner = static_cast<StagePlugin*>(context);
+    if (owner->results_ == nullptr) {
+        return; // outside process()
+    }
+    Result result;
+    result.tag = tag;
+    if (data != nullptr && length > 0) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        result.data.assign(bytes, bytes + length);
+    }
+    owner->results_->push_back(std::move(result));
+}
+
+void StagePlugin::Process(std::vector<CanFrame>& frames, std::vector<uint32_t>& annotations,
+                          std::vector<Result>& results) {
+    size_t count = frames.size();
+    size_t capacity = count + kDerivedCapacity;
+    frames.resize(capacity);
+    annotations.resize(capacity, 0);
+
+    ace_can_batch batch;
+    batch.frames = reinterpret_cast<ace_can_frame*>(frames.data());
+    batch.annotations = annotations.data();
+    batch.count = static_cast<uint32_t>(count);
+    batch.capacity = static_cast<uint32_t>(capacity);
+    results_ = &results;
+    plugin_->process(instance_, &batch);
+    results_ = nullptr;
+
+    size_t out = std::min<size_t>(batch.count, capacity);
+    frames.resize(out);
+    annotations.resize(out);
+}
+
+void StagePlugin::Destroy() {
+    if (instance_ != nullptr) {
+        plugin_->destroy(instance_);
+        instance_ = nullptr;
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef ACE_CAN_STAGE_PLUGIN_H
+#define ACE_CAN_STAGE_PLUGIN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ace_can_stage.h"
+#include "can_frame.h"
+#include "shared_library.h"
+
+// One instance of a receive-stage plugin (ace_can_stage.h) loaded from a shared library: checks the
+// entry point and ABI version, and runs the plugin over CanFrame batches in place. Results the
+// plugin emits while processing a batch are collected for the caller to deliver.
+class StagePlugin {
+public:
+    struct Result {
+        uint32_t tag = 0;
+        std::vector<uint8_t> data;
+    };
+
+    // Room for derived frames a plugin may append to a batch.
+    static constexpr size_t kDerivedCapacity = 256;
+
+    StagePlugin() = default;
+    ~StagePlugin();
+    StagePlugin(const StagePlugin&) = delete;
+    StagePlugin& operator=(const StagePlugin&) = delete;
+
+    // Loads the library and creates the instance; returns why it could not, or an empty string.
+    std::string Load(const std::string& path, const std::string& config);
+    // Runs process() on the batch, leaving the frames and annotations the plugin kept or added,
+    // and appends the results it emitted to `results`.
+    void Process(std::vector<CanFrame>& frames, std::vector<uint32_t>& annotations, std::vector<Result>& results);
+    // Destroys the instance; the plugin must be idle.
+    void Destroy();
+
+    const char* Name() const { return plugin_ != nullptr && plugin_->name != nullptr ? plugin_->name : ""; }
+
+private:
+    static void Emit(void* context, uint32_t tag, const void* data, uint32_t length);
+
+    SharedLibrary library_;
+    const ace_can_stage* plugin_ = nullptr;
+    void* instance_ = nullptr;
+    ace_can_stage_host host_ = {};
+    std::vector<Result>* results_ = nullptr; // during process()
+};
+
+#endif // ACE_CAN_STAGE_PLUGIN_H
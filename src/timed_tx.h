@@ -0,0 +1,103 @@
+#ifndef ACE_CAN_TIMED_TX_H
+#define ACE_CAN_TIMED_TX_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <thread>
+
+// Host monotonic clock in microseconds; the reference for timed transmission.
+inline int64_t HostMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Busy-waits for the last stretch before a deadline, where sleeping is far too coarse.
+inline void SpinUntil(int64_t hostUs) {
+    while (HostMicros() < hostUs) {
+        std::this_thread::yield();
+    }
+}
+
+// Maps device timestamps onto the host clock. Every received frame yields a sample
+// host_read_time - device_timestamp, which over-estimates the true offset by the delivery
+// latency; the smallest sample of a window is the best estimate. Windows are published
+// whole so the estimate follows clock drift, and lower samples are taken immediately.
+// Sample() is called from one thread; the accessors are safe from any thread.
+class DeviceClock {
+public:
+    static constexpr int64_t kWindowUs = 1000000;
+
+    void Sample(uint64_t deviceUs, int64_t hostUs) {
+        int64_t sample = hostUs - static_cast<int64_t>(deviceUs);
+        if (sample < window_min_) {
+            window_min_ = sample;
+        }
+        if (!known_ || sample < offset_) {
+            offset_ = sample;
+            known_ = true;
+        }
+        if (hostUs - window_start_ >= kWindowUs) {
+            offset_ = window_min_;
+            window_start_ = hostUs;
+            window_min_ = std::numeric_limits<int64_t>::max();
+        }
+    }
+
+    void Reset() {
+        known_ = false;
+        window_start_ = 0;
+        window_min_ = std::numeric_limits<int64_t>::max();
+    }
+
+    bool Known() const { return known_; }
+    int64_t ToHost(int64_t deviceUs) const { return deviceUs + offset_; }
+    int64_t ToDevice(int64_t hostUs) const { return hostUs - offset_; }
+
+private:
+    std::atomic<bool> known_{false};
+    std::atomic<int64_t> offset_{0};
+    int64_t window_start_ = 0;
+    int64_t window_min_ = std::numeric_limits<int64_t>::max();
+};
+
+// Extends a wrapping 32-bit device timestamp to 64 bits. A step of less than half the range in
+// either direction is taken at face value; a larger step back is a wrap, and a larger step
+// forward is a late frame from before the newest wrap. Single-threaded.
+class TimestampUnwrapper {
+public:
+    static constexpr uint64_t kRange = uint64_t{1} << 32;
+
+    uint64_t Extend(uint32_t timestamp) {
+        if (!started_) {
+            started_ = true;
+            last_ = timestamp;
+            return timestamp;
+        }
+        if (static_cast<uint32_t>(timestamp - last_) < 0x80000000u) {
+            if (timestamp < last_) {
+                epoch_ += kRange;
+            }
+            last_ = timestamp;
+            return epoch_ + timestamp;
+        }
+        if (timestamp > last_ && epoch_ >= kRange) {
+            return epoch_ - kRange + timestamp;
+        }
+        return epoch_ + timestamp;
+    }
+
+    void Reset() {
+        started_ = false;
+        epoch_ = 0;
+        last_ = 0;
+    }
+
+private:
+    bool started_ = false;
+    uint64_t epoch_ = 0;
+    uint32_t last_ = 0; // newest timestamp seen
+};
+
+#endif // ACE_CAN_TIMED_TX_H
@@ -0,0 +1,131 @@
+#ifndef ACE_CAN_TIMER_WHEEL_H
+#define ACE_CAN_TIMER_WHEEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Intrusive timer entry; lives inside whatever is waiting on it, so arming and cancelling
+// never allocate.
+struct TimerNode {
+    TimerNode* prev = nullptr;
+    TimerNode* next = nullptr;
+    int64_t due_us = 0;
+    size_t slot = 0;
+    bool armed = false;
+    void* owner = nullptr;
+};
+
+// Hashed timer wheel: slot = due tick modulo the slot count, with entries of later revolutions
+// sharing a slot. Add and Cancel are O(1); Advance only visits the slots of elapsed ticks.
+// Timers fire at their exact due time, the tick only decides which slot holds them.
+// Not thread-safe.
+class TimerWheel {
+public:
+    TimerWheel(int64_t tickUs, size_t slots) : tick_us_(tickUs), slots_(slots, nullptr) {}
+
+    bool Empty() const { return count_ == 0; }
+
+    void Add(TimerNode* node, int64_t dueUs) {
+        Cancel(node);
+        int64_t tick = dueUs / tick_us_;
+        if (tick <= processed_tick_) {
+            tick = processed_tick_ + 1;
+        }
+        node->due_us = dueUs;
+        node->slot = static_cast<size_t>(tick) % slots_.size();
+        node->prev = nullptr;
+        node->next = slots_[node->slot];
+        if (node->next != nullptr) {
+            node->next->prev = node;
+        }
+        slots_[node->slot] = node;
+        node->armed = true;
+        count_++;
+    }
+
+    void Cancel(TimerNode* node) {
+        if (!node->armed) {
+            return;
+        }
+        if (node->prev != nullptr) {
+            node->prev->next = node->next;
+        } else {
+            slots_[node->slot] = node->next;
+        }
+        if (node->next != nullptr) {
+            node->next->prev = node->prev;
+        }
+        node->prev = nullptr;
+        node->next = nullptr;
+        node->armed = false;
+        count_--;
+    }
+
+    // Fires every timer due at or before nowUs. `fire` may add or cancel timers.
+    template <typename Fire>
+    void Advance(int64_t nowUs, Fire&& fire) {
+        int64_t nowTick = nowUs / tick_us_;
+        if (processed_tick_ < 0) {
+            processed_tick_ = nowTick - 1;
+        }
+        int64_t first = processed_tick_ + 1;
+        if (nowTick - first >= static_cast<int64_t>(slots_.size())) {
+            first = nowTick - static_cast<int64_t>(slots_.size()) + 1;
+        }
+        // The current tick stays unprocessed: it can still hold timers due later within it.
+        processed_tick_ = nowTick - 1;
+        for (int64_t tick = first; tick <= nowTick; ++tick) {
+            size_t slot = static_cast<size_t>(tick) % slots_.size();
+            // Rescan from the head after every callback, which may have changed the slot.
+            TimerNode* node = slots_[slot];
+            while (node != nullptr) {
+                if (node->due_us > nowUs) {
+                    node = node->next;
+                    continue;
+                }
+                Cancel(node);
+                fire(node);
+                node = slots_[slot];
+            }
+        }
+    }
+
+    // Earliest due time within the next revolution, or `fallbackUs` if none is found there.
+    int64_t NextDueUs(int64_t nowUs, int64_t fallbackUs) const {
+        if (count_ == 0) {
+            return fallbackUs;
+        }
+        int64_t start = processed_tick_ >= 0 ? processed_tick_ + 1 : nowUs / tick_us_;
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            int64_t tick = start + static_cast<int64_t>(i);
+            int64_t tickEndUs = (tick + 1) * tick_us_;
+            int64_t best = fallbackUs;
+            for (const TimerNode* node = slots_[static_cast<size_t>(tick) % slots_.size()]; node != nullptr;
+                 node = node->next) {
+                if (node->due_us < tickEndUs && node->due_us < best) {
+                    best = node->due_us;
+                }
+            }
+            if (best < fallbackUs) {
+                return best;
+            }
+        }
+        return fallbackUs;
+    }
+
+    // Forgets every timer without touching the nodes, which may already be gone.
+    void Clear() {
+        std::fill(slots_.begin(), slots_.end(), nullptr);
+        count_ = 0;
+    }
+
+private:
+    int64_t tick_us_;
+    std::vector<TimerNode*> slots_;
+    size_t count_ = 0;
+    int64_t processed_tick_ = -1;
+};
+
+#endif // ACE_CAN_TIMER_WHEEL_H
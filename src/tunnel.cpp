@@ -0,0 +1,685 @@
+#include "tunnel.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <utility>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef _WIN32
+using NativeSocket = SOCKET;
+using SocketLength = int;
+const NativeSocket kNoSocket = INVALID_SOCKET;
+
+int PollSockets(WSAPOLLFD* fds, size_t count, int timeoutMs) {
+    return WSAPoll(fds, static_cast<ULONG>(count), timeoutMs);
+}
+using PollEntry = WSAPOLLFD;
+
+bool StartSockets() {
+    static const bool started = []() {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return started;
+}
+
+void CloseNative(NativeSocket socket) {
+    closesocket(socket);
+}
+
+void SetBlocking(NativeSocket socket, bool blocking) {
+    u_long nonBlocking = blocking ? 0 : 1;
+    ioctlsocket(socket, FIONBIO, &nonBlocking);
+}
+
+bool ConnectPending() {
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+}
+
+bool SendWouldBlock() {
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+}
+
+constexpr int kSendFlags = 0;
+#else
+using NativeSocket = int;
+using SocketLength = socklen_t;
+const NativeSocket kNoSocket = -1;
+
+int PollSockets(pollfd* fds, size_t count, int timeoutMs) {
+    return poll(fds, static_cast<nfds_t>(count), timeoutMs);
+}
+using PollEntry = pollfd;
+
+bool StartSockets() {
+    return true;
+}
+
+void CloseNative(NativeSocket socket) {
+    close(socket);
+}
+
+void SetBlocking(NativeSocket socket, bool blocking) {
+    int flags = fcntl(socket, F_GETFL, 0);
+    fcntl(socket, F_SETFL, blocking ? flags & ~O_NONBLOCK : flags | O_NONBLOCK);
+}
+
+bool ConnectPending() {
+    return errno == EINPROGRESS;
+}
+
+bool SendWouldBlock() {
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL; // a closed peer is an error, not SIGPIPE
+#else
+constexpr int kSendFlags = 0;
+#endif
+#endif
+
+NativeSocket ToNative(uintptr_t handle) {
+    return static_cast<NativeSocket>(handle);
+}
+
+uintptr_t FromNative(NativeSocket socket) {
+    return static_cast<uintptr_t>(socket);
+}
+
+void PutU16(uint8_t* out, uint16_t value) {
+    out[0] = static_cast<uint8_t>(value >> 8);
+    out[1] = static_cast<uint8_t>(value);
+}
+
+void PutU32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (24 - 8 * i));
+    }
+}
+
+void PutU64(uint8_t* out, uint64_t value) {
+    PutU32(out, static_cast<uint32_t>(value >> 32));
+    PutU32(out + 4, static_cast<uint32_t>(value));
+}
+
+uint16_t GetU16(const uint8_t* in) {
+    return static_cast<uint16_t>((in[0] << 8) | in[1]);
+}
+
+uint32_t GetU32(const uint8_t* in) {
+    return (static_cast<uint32_t>(in[0]) << 24) | (static_cast<uint32_t>(in[1]) << 16) |
+           (static_cast<uint32_t>(in[2]) << 8) | in[3];
+}
+
+uint64_t GetU64(const uint8_t* in) {
+    return (static_cast<uint64_t>(GetU32(in)) << 32) | GetU32(in + 4);
+}
+
+std::mutex g_links_mutex;
+std::map<std::pair<bool, uint16_t>, std::weak_ptr<TunnelLink>> g_links; // by protocol and port
+
+} // namespace
+
+void TunnelPacketWriter::Begin(uint8_t channel, uint32_t sequence, size_t capacity) {
+    capacity_ = std::clamp<size_t>(capacity, kTunnelHeaderSize + kTunnelFrameHeaderSize + 64, kTunnelMaxPacket);
+    buffer_.resize(kTunnelHeaderSize);
+    buffer_[0] = kTunnelVersion;
+    buffer_[1] = channel;
+    PutU32(buffer_.data() + 4, sequence);
+    count_ = 0;
+    base_us_ = 0;
+}
+
+bool TunnelPacketWriter::Add(const CanFrame& frame) {
+    size_t length = std::min<size_t>(frame.length, 64);
+    if (buffer_.size() + kTunnelFrameHeaderSize + length > capacity_ || count_ == UINT16_MAX) {
+        return false;
+    }
+    if (count_ == 0) {
+        base_us_ = frame.timestamp;
+    }
+    // Deltas beyond +-35 minutes within one packet only happen with a broken clock; clamp them.
+    int64_t delta = static_cast<int64_t>(frame.timestamp - base_us_);
+    delta = std::clamp<int64_t>(delta, INT32_MIN, INT32_MAX);
+    size_t offset = buffer_.size();
+    buffer_.resize(offset + kTunnelFrameHeaderSize + length);
+    uint8_t* out = buffer_.data() + offset;
+    PutU32(out, static_cast<uint32_t>(static_cast<int32_t>(delta)));
+    PutU32(out + 4, frame.id);
+    out[8] = frame.flags;
+    out[9] = static_cast<uint8_t>(length);
+    std::memcpy(out + kTunnelFrameHeaderSize, frame.data, length);
+    count_++;
+    return true;
+}
+
+const std::vector<uint8_t>& TunnelPacketWriter::Finish() {
+    PutU16(buffer_.data() + 2, count_);
+    PutU64(buffer_.data() + 8, base_us_);
+    return buffer_;
+}
+
+std::string DecodeTunnelPacket(const uint8_t* data, size_t size, TunnelPacketInfo& info, std::vector<CanFrame>& out) {
+    if (size < kTunnelHeaderSize) {
+        return "Tunnel packet shorter than its header";
+    }
+    if (data[0] != kTunnelVersion) {
+        return "Unsupported tunnel packet version " + std::to_string(data[0]);
+    }
+    info.channel = data[1];
+    info.count = GetU16(data + 2);
+    info.sequence = GetU32(data + 4);
+    uint64_t base = GetU64(data + 8);
+    size_t start = out.size();
+    size_t offset = kTunnelHeaderSize;
+    for (uint16_t i = 0; i < info.count; ++i) {
+        if (offset + kTunnelFrameHeaderSize > size || data[offset + 9] > 64 ||
+            offset + kTunnelFrameHeaderSize + data[offset + 9] > size) {
+            out.resize(start);
+            return "Truncated tunnel packet";
+        }
+        const uint8_t* in = data + offset;
+        CanFrame frame = {};
+        frame.timestamp = base + static_cast<int64_t>(static_cast<int32_t>(GetU32(in)));
+        frame.id = GetU32(in + 4);
+        frame.flags = in[8];
+        frame.length = in[9];
+        frame.channel = info.channel;
+        std::memcpy(frame.data, in + kTunnelFrameHeaderSize, frame.length);
+        out.push_back(frame);
+        offset += kTunnelFrameHeaderSize + frame.length;
+    }
+    return std::string();
+}
+
+bool TunnelSequence::Accept(uint32_t sequence) {
+    int32_t gap = static_cast<int32_t>(sequence - expected);
+    if (!started || gap < -kTunnelRestartWindow) {
+        // The first packet, or far behind: the sender restarted and counts from zero again.
+        started = true;
+        expected = sequence + 1;
+        seen = ~uint64_t{0}; // nothing before it was counted as lost
+        return true;
+    }
+    if (gap < 0) {
+        late++;
+        uint32_t age = expected - 1 - sequence;
+        if (age < 64 && (seen & (uint64_t{1} << age)) == 0) {
+            seen |= uint64_t{1} << age; // counted as lost when the gap opened
+            lost--;
+        }
+        return false;
+    }
+    lost += static_cast<uint32_t>(gap);
+    seen = gap < 63 ? (seen << (gap + 1)) | 1 : 1;
+    expected = sequence + 1;
+    return true;
+}
+
+TunnelSocket::~TunnelSocket() {
+    Close();
+}
+
+std::string TunnelSocket::Resolve(const std::string& host, uint16_t port, TunnelAddress& out) {
+    if (!StartSockets()) {
+        return "WSAStartup failed";
+    }
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_flags = AI_NUMERICSERV | (host.empty() ? AI_PASSIVE : 0);
+    addrinfo* result = nullptr;
+    std::string service = std::to_string(port);
+    int status = getaddrinfo(host.empty() ? nullptr : host.c_str(), service.c_str(), &hints, &result);
+    if (status != 0 || result == nullptr) {
+        return "Cannot resolve tunnel host " + host;
+    }
+    size_t length = std::min<size_t>(result->ai_addrlen, sizeof(out.storage));
+    std::memcpy(out.storage, result->ai_addr, length);
+    out.length = static_cast<uint32_t>(length);
+    freeaddrinfo(result);
+    return std::string();
+}
+
+std::string TunnelSocket::OpenUdp(const TunnelAddress& bind) {
+    Close();
+    const sockaddr* address = reinterpret_cast<const sockaddr*>(bind.storage);
+    NativeSocket socket = ::socket(address->sa_family, SOCK_DGRAM, IPPROTO_UDP);
+    if (socket == kNoSocket) {
+        return "Cannot create UDP socket";
+    }
+    // Full-load bursts from several channels arrive faster than one wake-up drains them.
+    int bufferSize = 4 * 1024 * 1024;
+    setsockopt(socket, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&bufferSize), sizeof(bufferSize));
+    if (::bind(socket, address, static_cast<SocketLength>(bind.length)) != 0) {
+        CloseNative(socket);
+        return "Cannot bind UDP tunnel port";
+    }
+    handle_ = FromNative(socket);
+    return std::string();
+}
+
+std::string TunnelSocket::OpenUdpFor(const TunnelAddress& remote) {
+    bool v6 = reinterpret_cast<const sockaddr*>(remote.storage)->sa_family == AF_INET6;
+    TunnelAddress bind;
+    std::string error = Resolve(v6 ? "::" : "0.0.0.0", 0, bind);
+    return error.empty() ? OpenUdp(bind) : error;
+}
+
+std::string TunnelSocket::Listen(const TunnelAddress& bind) {
+    Close();
+    const sockaddr* address = reinterpret_cast<const sockaddr*>(bind.storage);
+    NativeSocket socket = ::socket(address->sa_family, SOCK_STREAM, IPPROTO_TCP);
+    if (socket == kNoSocket) {
+        return "Cannot create TCP socket";
+    }
+    int reuse = 1;
+    setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+    if (::bind(socket, address, static_cast<SocketLength>(bind.length)) != 0 || listen(socket, 8) != 0) {
+        CloseNative(socket);
+        return "Cannot listen on TCP tunnel port";
+    }
+    handle_ = FromNative(socket);
+    return std::string();
+}
+
+std::string TunnelSocket::Connect(const TunnelAddress& remote, int timeoutMs) {
+    Close();
+    const sockaddr* address = reinterpret_cast<const sockaddr*>(remote.storage);
+    NativeSocket socket = ::socket(address->sa_family, SOCK_STREAM, IPPROTO_TCP);
+    if (socket == kNoSocket) {
+        return "Cannot create TCP socket";
+    }
+    // Connect without blocking, so an unreachable peer costs timeoutMs rather than the OS timeout.
+    SetBlocking(socket, false);
+    bool connected = ::connect(socket, address, static_cast<SocketLength>(remote.length)) == 0;
+    if (!connected && ConnectPending()) {
+        PollEntry entry = {};
+        entry.fd = socket;
+        entry.events = POLLOUT;
+        int error = 0;
+        SocketLength length = sizeof(error);
+        connected = PollSockets(&entry, 1, timeoutMs) > 0 &&
+                    getsockopt(socket, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &length) == 0 &&
+                    error == 0;
+    }
+    if (!connected) {
+        CloseNative(socket);
+        return "Cannot connect to tunnel peer";
+    }
+    SetBlocking(socket, true);
+    int noDelay = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+    handle_ = FromNative(socket);
+    return std::string();
+}
+
+bool TunnelSocket::Accept(TunnelSocket& out) {
+    NativeSocket socket = ::accept(ToNative(handle_), nullptr, nullptr);
+    if (socket == kNoSocket) {
+        return false;
+    }
+    int noDelay = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+    out.Close();
+    out.handle_ = FromNative(socket);
+    return true;
+}
+
+void TunnelSocket::Close() {
+    if (Valid()) {
+        CloseNative(ToNative(handle_));
+        handle_ = ~uintptr_t{0};
+    }
+}
+
+bool TunnelSocket::Valid() const {
+    return handle_ != ~uintptr_t{0};
+}
+
+void TunnelSocket::SetNonBlocking() {
+    SetBlocking(ToNative(handle_), false);
+}
+
+uint16_t TunnelSocket::LocalPort() const {
+    sockaddr_storage address = {};
+    SocketLength length = sizeof(address);
+    if (getsockname(ToNative(handle_), reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        return 0;
+    }
+    if (address.ss_family == AF_INET6) {
+        return ntohs(reinterpret_cast<const sockaddr_in6*>(&address)->sin6_port);
+    }
+    return ntohs(reinterpret_cast<const sockaddr_in*>(&address)->sin_port);
+}
+
+bool TunnelSocket::SendTo(const uint8_t* data, size_t size, const TunnelAddress& to) {
+    return sendto(ToNative(handle_), reinterpret_cast<const char*>(data), static_cast<int>(size), 0,
+                  reinterpret_cast<const sockaddr*>(to.storage), static_cast<SocketLength>(to.length)) ==
+           static_cast<int>(size);
+}
+
+bool TunnelSocket::SendAll(const uint8_t* data, size_t size) {
+    while (size > 0) {
+        auto sent = send(ToNative(handle_), reinterpret_cast<const char*>(data), static_cast<int>(size), kSendFlags);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+int TunnelSocket::Send(const uint8_t* data, size_t size) {
+    auto sent = send(ToNative(handle_), reinterpret_cast<const char*>(data), static_cast<int>(size), kSendFlags);
+    if (sent < 0) {
+        return SendWouldBlock() ? 0 : -1;
+    }
+    return static_cast<int>(sent);
+}
+
+bool TunnelSocket::WaitOne(int timeoutMs) {
+    PollEntry entry = {};
+    entry.fd = ToNative(handle_);
+    entry.events = POLLIN;
+    return PollSockets(&entry, 1, timeoutMs) > 0;
+}
+
+int TunnelSocket::ReceiveFrom(uint8_t* buffer, size_t capacity, TunnelAddress& from, int timeoutMs) {
+    if (timeoutMs >= 0 && !WaitOne(timeoutMs)) {
+        return 0;
+    }
+    SocketLength length = sizeof(from.storage);
+    auto received = recvfrom(ToNative(handle_), reinterpret_cast<char*>(buffer), static_cast<int>(capacity), 0,
+                             reinterpret_cast<sockaddr*>(from.storage), &length);
+    from.length = static_cast<uint32_t>(length);
+    return received < 0 ? -1 : static_cast<int>(received);
+}
+
+int TunnelSocket::Receive(uint8_t* buffer, size_t capacity, int timeoutMs) {
+    if (timeoutMs >= 0 && !WaitOne(timeoutMs)) {
+        return 0;
+    }
+    auto received = recv(ToNative(handle_), reinterpret_cast<char*>(buffer), static_cast<int>(capacity), 0);
+    return received <= 0 ? -1 : static_cast<int>(received);
+}
+
+bool TunnelSocket::WaitReadable(const std::vector<TunnelSocket*>& sockets, int timeoutMs, std::vector<uint8_t>& ready) {
+    std::vector<PollEntry> entries(sockets.size());
+    for (size_t i = 0; i < sockets.size(); ++i) {
+        entries[i].fd = ToNative(sockets[i]->handle_);
+        entries[i].events = POLLIN;
+    }
+    ready.assign(sockets.size(), 0);
+    if (PollSockets(entries.data(), entries.size(), timeoutMs) <= 0) {
+        return false;
+    }
+    for (size_t i = 0; i < sockets.size(); ++i) {
+        ready[i] = (entries[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0;
+    }
+    return true;
+}
+
+bool TunnelSocket::Poll(std::vector<PollItem>& items, int timeoutMs) {
+    std::vector<PollEntry> entries(items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        entries[i].fd = ToNative(items[i].socket->handle_);
+        entries[i].events = static_cast<short>(POLLIN | (items[i].want_write ? POLLOUT : 0));
+    }
+    if (PollSockets(entries.data(), entries.size(), timeoutMs) <= 0) {
+        return false;
+    }
+    for (size_t i = 0; i < items.size(); ++i) {
+        items[i].readable = (entries[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0;
+        items[i].writable = (entries[i].revents & POLLOUT) != 0;
+    }
+    return true;
+}
+
+bool TunnelStream::Next(std::vector<uint8_t>& packet) {
+    size_t available = buffer_.size() - offset_;
+    if (available < 2 || available < 2u + GetU16(buffer_.data() + offset_)) {
+        if (offset_ > 0 && offset_ * 2 >= buffer_.size()) {
+            buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(offset_));
+            offset_ = 0;
+        }
+        return false;
+    }
+    size_t size = GetU16(buffer_.data() + offset_);
+    const uint8_t* start = buffer_.data() + offset_ + 2;
+    packet.assign(start, start + size);
+    offset_ += 2 + size;
+    return true;
+}
+
+std::shared_ptr<TunnelLink> TunnelLink::Acquire(bool tcp, const std::string& host, uint16_t port, std::string& error) {
+    std::lock_guard<std::mutex> lock(g_links_mutex);
+    std::shared_ptr<TunnelLink> link = g_links[{tcp, port}].lock();
+    if (link) {
+        if (link->host_ != host) {
+            error = "Tunnel port " + std::to_string(port) + " is already open with other settings";
+            return nullptr;
+        }
+        return link;
+    }
+    link.reset(new TunnelLink(tcp, host, port));
+    error = link->Open();
+    if (!error.empty()) {
+        return nullptr;
+    }
+    g_links[{tcp, port}] = link;
+    return link;
+}
+
+TunnelLink::TunnelLink(bool tcp, std::string host, uint16_t port) : tcp_(tcp), host_(std::move(host)), port_(port) {}
+
+TunnelLink::~TunnelLink() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+std::string TunnelLink::Open() {
+    TunnelAddress bind;
+    std::string error = TunnelSocket::Resolve(host_, port_, bind);
+    if (error.empty()) {
+        error = tcp_ ? socket_.Listen(bind) : socket_.OpenUdp(bind);
+    }
+    if (!error.empty()) {
+        return error;
+    }
+    running_ = true;
+    thread_ = std::thread([this]() { Loop(); });
+    return std::string();
+}
+
+std::string TunnelLink::Attach(uint8_t channel) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (channels_[channel].attached) {
+        return "Tunnel channel " + std::to_string(channel) + " on port " + std::to_string(port_) + " is already open";
+    }
+    channels_[channel] = Channel();
+    channels_[channel].attached = true;
+    return std::string();
+}
+
+void TunnelLink::Detach(uint8_t channel) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        channels_[channel] = Channel();
+    }
+    cv_.notify_all();
+}
+
+bool TunnelLink::Wait(uint8_t channel, int timeoutMs) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                        [this, channel]() { return !channels_[channel].inbox.empty() || !channels_[channel].attached; }) &&
+           !channels_[channel].inbox.empty();
+}
+
+size_t TunnelLink::Read(uint8_t channel, CanFrame* out, size_t max) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::deque<CanFrame>& inbox = channels_[channel].inbox;
+    size_t count = std::min(max, inbox.size());
+    std::copy(inbox.begin(), inbox.begin() + static_cast<std::ptrdiff_t>(count), out);
+    inbox.erase(inbox.begin(), inbox.begin() + static_cast<std::ptrdiff_t>(count));
+    return count;
+}
+
+std::string TunnelLink::Send(uint8_t channel, const CanFrame& frame) {
+    TunnelPacketWriter writer;
+    TunnelAddress peer;
+    std::shared_ptr<TunnelSocket> connection;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Channel& state = channels_[channel];
+        if (!state.stats.connected) {
+            return "No tunnel peer on channel " + std::to_string(channel) + " yet";
+        }
+        writer.Begin(channel, state.tx_sequence++, kTunnelHeaderSize + kTunnelFrameHeaderSize + 64);
+        peer = state.peer;
+        connection = state.connection;
+        state.stats.sent++;
+    }
+    writer.Add(frame);
+    const std::vector<uint8_t>& packet = writer.Finish();
+    std::lock_guard<std::mutex> sendLock(send_mutex_);
+    if (!tcp_) {
+        return socket_.SendTo(packet.data(), packet.size(), peer) ? std::string() : "Tunnel send failed";
+    }
+    // One write, so the length prefix and the packet leave in one segment.
+    uint8_t framed[2 + kTunnelHeaderSize + kTunnelFrameHeaderSize + 64];
+    PutU16(framed, static_cast<uint16_t>(packet.size()));
+    std::memcpy(framed + 2, packet.data(), packet.size());
+    if (!connection || !connection->SendAll(framed, 2 + packet.size())) {
+        return "Tunnel connection lost";
+    }
+    return std::string();
+}
+
+TunnelLink::Stats TunnelLink::GetStats(uint8_t channel) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = channels_[channel].stats;
+    stats.lost = channels_[channel].sequence.lost;
+    stats.late = channels_[channel].sequence.late;
+    return stats;
+}
+
+void TunnelLink::Loop() {
+    std::vector<uint8_t> buffer(kTunnelMaxPacket);
+    std::vector<uint8_t> packet;
+    std::vector<TunnelSocket*> sockets;
+    std::vector<uint8_t> ready;
+    while (running_) {
+        if (!tcp_) {
+            TunnelAddress from;
+            int received = socket_.ReceiveFrom(buffer.data(), buffer.size(), from, 100);
+            // Drain what is queued before polling again.
+            while (received > 0) {
+                Deliver(buffer.data(), static_cast<size_t>(received), &from, nullptr);
+                received = socket_.ReceiveFrom(buffer.data(), buffer.size(), from, 0);
+            }
+            continue;
+        }
+
+        sockets.assign(1, &socket_);
+        for (Connection& connection : connections_) {
+            sockets.push_back(connection.socket.get());
+        }
+        if (!TunnelSocket::WaitReadable(sockets, 100, ready)) {
+            continue;
+        }
+        if (ready[0]) {
+            auto socket = std::make_shared<TunnelSocket>();
+            if (socket_.Accept(*socket)) {
+                connections_.push_back({socket, TunnelStream()});
+            }
+        }
+        for (size_t i = connections_.size(); i-- > 0;) {
+            if (!ready[i + 1]) {
+                continue;
+            }
+            Connection& connection = connections_[i];
+            int received = connection.socket->Receive(buffer.data(), buffer.size(), -1);
+            if (received < 0) {
+                Disconnected(connection.socket);
+                connections_.erase(connections_.begin() + static_cast<std::ptrdiff_t>(i));
+                continue;
+            }
+            connection.stream.Append(buffer.data(), static_cast<size_t>(received));
+            while (connection.stream.Next(packet)) {
+                Deliver(packet.data(), packet.size(), nullptr, connection.socket);
+            }
+        }
+    }
+}
+
+// Channels last heard on a closed connection have no peer until another one sends.
+void TunnelLink::Disconnected(const std::shared_ptr<TunnelSocket>& connection) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Channel& channel : channels_) {
+        if (channel.connection == connection) {
+            channel.connection.reset();
+            channel.stats.connected = false;
+        }
+    }
+}
+
+void TunnelLink::Deliver(const uint8_t* data, size_t size, const TunnelAddress* from,
+                         const std::shared_ptr<TunnelSocket>& connection) {
+    TunnelPacketInfo info;
+    decoded_.clear();
+    if (!DecodeTunnelPacket(data, size, info, decoded_).empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Channel& channel = channels_[info.channel];
+        if (!channel.attached) {
+            return;
+        }
+        // A new peer (a restarted sender, a new connection) starts its own sequence.
+        bool newPeer = from != nullptr ? (from->length != channel.peer.length ||
+                                          std::memcmp(from->storage, channel.peer.storage, from->length) != 0)
+                                       : connection != channel.connection;
+        if (newPeer) {
+            channel.sequence.started = false;
+        }
+        if (!channel.sequence.Accept(info.sequence)) {
+            return;
+        }
+        channel.stats.packets++;
+        channel.stats.frames += decoded_.size();
+        channel.stats.connected = true;
+        if (from != nullptr) {
+            channel.peer = *from;
+        }
+        channel.connection = connection;
+        size_t room = kMaxInbox - std::min(kMaxInbox, channel.inbox.size());
+        size_t accepted = std::min(room, decoded_.size());
+        channel.inbox.insert(channel.inbox.end(), decoded_.begin(), decoded_.begin() + static_cast<std::ptrdiff_t>(accepted));
+        channel.stats.dropped += decoded_.size() - accepted;
+    }
+    cv_.notify_all();
+}
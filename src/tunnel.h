@@ -0,0 +1,208 @@
+#ifndef ACE_CAN_TUNNEL_H
+#define ACE_CAN_TUNNEL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "can_frame.h"
+
+// CAN-over-IP tunnel packets, in the spirit of cannelloni: many frames per packet, each with its
+// timestamp, plus a per-channel sequence number for loss accounting. Over UDP a packet is one
+// datagram; over TCP each packet is preceded by its 16-bit length. All fields are big-endian.
+//
+//   header  0 u8 version (1)   1 u8 channel   2 u16 frame count   4 u32 sequence
+//           8 u64 timestamp of the first frame (microseconds, sender's frame clock)
+//   frame   0 i32 timestamp - header timestamp   4 u32 id   8 u8 flags (CanFrame)   9 u8 length
+//          10 data[length]
+constexpr uint8_t kTunnelVersion = 1;
+constexpr size_t kTunnelHeaderSize = 16;
+constexpr size_t kTunnelFrameHeaderSize = 10;
+constexpr size_t kTunnelMaxPacket = 65507; // largest UDP payload
+constexpr int32_t kTunnelRestartWindow = 1024; // packets further back mean the sender restarted
+
+// Accumulates frames into one packet.
+class TunnelPacketWriter {
+public:
+    void Begin(uint8_t channel, uint32_t sequence, size_t capacity);
+    // False if the frame does not fit in the packet's capacity.
+    bool Add(const CanFrame& frame);
+    size_t Count() const { return count_; }
+    // The finished packet; valid until the next Begin().
+    const std::vector<uint8_t>& Finish();
+
+private:
+    std::vector<uint8_t> buffer_;
+    size_t capacity_ = 0;
+    uint16_t count_ = 0;
+    uint64_t base_us_ = 0;
+};
+
+struct TunnelPacketInfo {
+    uint8_t channel = 0;
+    uint32_t sequence = 0;
+    uint16_t count = 0;
+};
+
+// Decodes a packet into `out` (appended, channel set from the header). Returns why the packet is
+// malformed, or an empty string; nothing is appended for a malformed packet.
+std::string DecodeTunnelPacket(const uint8_t* data, size_t size, TunnelPacketInfo& info, std::vector<CanFrame>& out);
+
+// Per-channel sequence check. Packets older than the last one seen are late and should be dropped;
+// a gap counts the missing packets as lost. A late packet that fills a gap within the last 64
+// sequence numbers is no longer lost, only late. A jump back of more than kTunnelRestartWindow
+// starts over, since a restarted sender counts from zero.
+struct TunnelSequence {
+    bool started = false;
+    uint32_t expected = 0;
+    uint64_t seen = 0; // bit n: expected - 1 - n is not missing
+    uint64_t lost = 0;
+    uint64_t late = 0;
+
+    // False for a late or duplicate packet.
+    bool Accept(uint32_t sequence);
+};
+
+// Opaque socket address (sockaddr_storage).
+struct TunnelAddress {
+    uint8_t storage[128] = {};
+    uint32_t length = 0;
+};
+
+// Minimal socket for the tunnel (and the frame stream server), POSIX or Winsock. Blocking unless
+// SetNonBlocking() was called.
+class TunnelSocket {
+public:
+    struct PollItem {
+        TunnelSocket* socket = nullptr;
+        bool want_write = false;
+        bool readable = false; // also set on hang-up and errors
+        bool writable = false;
+    };
+
+    TunnelSocket() = default;
+    ~TunnelSocket();
+    TunnelSocket(const TunnelSocket&) = delete;
+    TunnelSocket& operator=(const TunnelSocket&) = delete;
+
+    static std::string Resolve(const std::string& host, uint16_t port, TunnelAddress& out);
+
+    std::string OpenUdp(const TunnelAddress& bind);
+    // UDP socket on an ephemeral port, of the same address family as `remote`.
+    std::string OpenUdpFor(const TunnelAddress& remote);
+    std::string Listen(const TunnelAddress& bind);
+    std::string Connect(const TunnelAddress& remote, int timeoutMs);
+    bool Accept(TunnelSocket& out);
+    void Close();
+    bool Valid() const;
+    void SetNonBlocking();
+    // Port the socket is bound to, e.g. after binding port 0.
+    uint16_t LocalPort() const;
+
+    // Whole packet or whole buffer; false on error.
+    bool SendTo(const uint8_t* data, size_t size, const TunnelAddress& to);
+    bool SendAll(const uint8_t* data, size_t size);
+    // Bytes sent, 0 when a non-blocking socket's buffer is full, -1 on error.
+    int Send(const uint8_t* data, size_t size);
+    // Bytes received, 0 when nothing arrived within timeoutMs, -1 on error or a closed connection.
+    int ReceiveFrom(uint8_t* buffer, size_t capacity, TunnelAddress& from, int timeoutMs);
+    int Receive(uint8_t* buffer, size_t capacity, int timeoutMs);
+
+    // Waits until one of `sockets` is readable; sets ready[i] for each. False on timeout.
+    static bool WaitReadable(const std::vector<TunnelSocket*>& sockets, int timeoutMs, std::vector<uint8_t>& ready);
+    // Waits for any item to become readable (or writable, where asked). False on timeout.
+    static bool Poll(std::vector<PollItem>& items, int timeoutMs);
+
+private:
+    bool WaitOne(int timeoutMs);
+    uintptr_t handle_ = ~uintptr_t{0};
+};
+
+// Splits a TCP byte stream into length-prefixed packets.
+class TunnelStream {
+public:
+    void Append(const uint8_t* data, size_t size) { buffer_.insert(buffer_.end(), data, data + size); }
+    // The next complete packet, or false if more bytes are needed.
+    bool Next(std::vector<uint8_t>& packet);
+
+private:
+    std::vector<uint8_t> buffer_;
+    size_t offset_ = 0;
+};
+
+// Receiving end of tunnels on one local port, shared by every CANBus of bustype 'udp' / 'tcp' on
+// it; each bus takes one channel. A receive thread decodes packets into per-channel queues that
+// the bus's receive path drains, and frames a bus sends go back to the peer that last sent on its
+// channel.
+class TunnelLink {
+public:
+    struct Stats {
+        uint64_t packets = 0;
+        uint64_t frames = 0;
+        uint64_t lost = 0;
+        uint64_t late = 0;
+        uint64_t dropped = 0; // queue full
+        uint64_t sent = 0;
+        bool connected = false; // a peer has sent on the channel and, over TCP, is still connected
+    };
+
+    // The link on `port`, opened on first use. The bind host must match other users of the port.
+    static std::shared_ptr<TunnelLink> Acquire(bool tcp, const std::string& host, uint16_t port, std::string& error);
+    ~TunnelLink();
+
+    std::string Attach(uint8_t channel);
+    void Detach(uint8_t channel);
+    // Waits up to timeoutMs for frames on the channel.
+    bool Wait(uint8_t channel, int timeoutMs);
+    // Moves queued frames for the channel into `out`.
+    size_t Read(uint8_t channel, CanFrame* out, size_t max);
+    std::string Send(uint8_t channel, const CanFrame& frame);
+    Stats GetStats(uint8_t channel);
+
+private:
+    struct Channel {
+        bool attached = false;
+        std::deque<CanFrame> inbox;
+        TunnelSequence sequence;
+        Stats stats;
+        TunnelAddress peer; // UDP
+        std::shared_ptr<TunnelSocket> connection; // TCP
+        uint32_t tx_sequence = 0;
+    };
+
+    struct Connection {
+        std::shared_ptr<TunnelSocket> socket;
+        TunnelStream stream;
+    };
+
+    static constexpr size_t kMaxInbox = 65536;
+
+    TunnelLink(bool tcp, std::string host, uint16_t port);
+    std::string Open();
+    void Loop();
+    void Deliver(const uint8_t* data, size_t size, const TunnelAddress* from,
+                 const std::shared_ptr<TunnelSocket>& connection);
+    void Disconnected(const std::shared_ptr<TunnelSocket>& connection);
+
+    bool tcp_;
+    std::string host_;
+    uint16_t port_;
+    TunnelSocket socket_; // UDP socket or TCP listener
+    std::vector<Connection> connections_; // receive thread only
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::mutex send_mutex_; // one writer per socket at a time
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    Channel channels_[256];
+    std::vector<CanFrame> decoded_; // receive thread only
+};
+
+#endif // ACE_CAN_TUNNEL_H
@@ -0,0 +1,127 @@
+#ifndef ACE_CAN_TX_SHAPER_H
+#define ACE_CAN_TX_SHAPER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "can_frame.h"
+
+// Worst-case number of bits a frame occupies on the wire: header, data, CRC, ACK, EOF, the
+// 3-bit interframe space and the maximum number of stuff bits. CAN FD data phases are counted
+// at the nominal bitrate, which over-estimates their cost.
+inline uint32_t FrameBitLength(const CanFrame& frame) {
+    uint32_t dataBits = 8u * frame.length;
+    if ((frame.flags & kFrameFlagExtended) != 0) {
+        return 67 + dataBits + (54 + dataBits - 1) / 4;
+    }
+    return 47 + dataBits + (34 + dataBits - 1) / 4;
+}
+
+constexpr uint32_t kMaxClassicFrameBits = 67 + 64 + (54 + 64 - 1) / 4;
+
+// Spacing that keeps back-to-back worst-case classic frames within `load` of `bitrate`, or 0 when
+// there is no nominal bitrate to budget against (tunnel and other virtual channels).
+inline int64_t FrameIntervalNs(double load, int bitrate) {
+    if (load <= 0 || bitrate <= 0) {
+        return 0;
+    }
+    return static_cast<int64_t>(kMaxClassicFrameBits * 1e9 / (load * bitrate));
+}
+
+// Bucket depth: the requested burst, or 10 ms worth of budget, but never less than one full frame.
+inline double DefaultBurstBits(double rate, uint32_t burstBits) {
+    double burst = burstBits > 0 ? burstBits : rate / 100.0;
+    return std::max<double>(burst, kMaxClassicFrameBits);
+}
+
+// Token bucket counted in bits. Tokens refill continuously at `rate` bits/s up to `capacity`.
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TokenBucket() = default;
+    TokenBucket(double rate, double capacity)
+        : rate_(rate), capacity_(capacity), tokens_(capacity), last_(Clock::now()) {}
+
+    bool Limited() const { return rate_ > 0; }
+
+    // How long until `bits` tokens are available; zero if they are available now.
+    Clock::duration Delay(double bits, Clock::time_point now) {
+        if (!Limited()) {
+            return Clock::duration::zero();
+        }
+        Refill(now);
+        if (tokens_ >= bits) {
+            return Clock::duration::zero();
+        }
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>((bits - tokens_) / rate_));
+    }
+
+    void Consume(double bits) {
+        if (Limited()) {
+            tokens_ -= bits;
+        }
+    }
+
+private:
+    void Refill(Clock::time_point now) {
+        double elapsed = std::chrono::duration<double>(now - last_).count();
+        last_ = now;
+        tokens_ = std::min(capacity_, tokens_ + elapsed * rate_);
+    }
+
+    double rate_ = 0;
+    double capacity_ = 0;
+    double tokens_ = 0;
+    Clock::time_point last_{};
+};
+
+// A bus-wide budget plus optional budgets for classes of ids (id & mask == match & mask).
+// A frame is admitted only when the bus bucket and the first matching class bucket both
+// hold enough tokens, so neither budget is ever overdrawn.
+class TxShaper {
+public:
+    struct IdClass {
+        uint32_t mask = 0;
+        uint32_t match = 0;
+        TokenBucket bucket;
+    };
+
+    TxShaper() = default;
+    TxShaper(TokenBucket bus, std::vector<IdClass> classes) : bus_(bus), classes_(std::move(classes)) {}
+
+    bool Enabled() const { return bus_.Limited() || !classes_.empty(); }
+
+    // Takes the frame's tokens and returns zero, or returns how long to wait before trying again.
+    TokenBucket::Clock::duration Admit(const CanFrame& frame, TokenBucket::Clock::time_point now) {
+        double bits = FrameBitLength(frame);
+        TokenBucket* idBucket = nullptr;
+        for (IdClass& idClass : classes_) {
+            if ((frame.id & idClass.mask) == (idClass.match & idClass.mask)) {
+                idBucket = &idClass.bucket;
+                break;
+            }
+        }
+        auto delay = bus_.Delay(bits, now);
+        if (idBucket != nullptr) {
+            delay = std::max(delay, idBucket->Delay(bits, now));
+        }
+        if (delay > TokenBucket::Clock::duration::zero()) {
+            return delay;
+        }
+        bus_.Consume(bits);
+        if (idBucket != nullptr) {
+            idBucket->Consume(bits);
+        }
+        return delay;
+    }
+
+private:
+    TokenBucket bus_;
+    std::vector<IdClass> classes_;
+};
+
+#endif // ACE_CAN_TX_SHAPER_H
@@ -0,0 +1,40 @@
+#include "uds.h"
+
+#include "napi_options.h"
+
+namespace {
+
+constexpr size_t kMaxRequest = 4095;
+
+} // namespace
+
+bool ReadUdsRequests(const Napi::Value& value, std::vector<std::vector<uint8_t>>& out) {
+    if (!value.IsArray()) {
+        return false;
+    }
+    Napi::Array list = value.As<Napi::Array>();
+    for (uint32_t i = 0; i < list.Length(); ++i) {
+        Napi::Value entry = list.Get(i);
+        if (!entry.IsBuffer()) {
+            return false;
+        }
+        Napi::Buffer<uint8_t> data = entry.As<Napi::Buffer<uint8_t>>();
+        if (data.Length() == 0 || data.Length() > kMaxRequest) {
+            return false;
+        }
+        out.emplace_back(data.Data(), data.Data() + data.Length());
+    }
+    return true;
+}
+
+bool ReadUdsTiming(const Napi::Object& options, UdsTiming& timing) {
+    uint32_t p2Ms = static_cast<uint32_t>(timing.p2_us / 1000);
+    uint32_t p2StarMs = static_cast<uint32_t>(timing.p2_star_us / 1000);
+    if (!GetOptionalUint32(options, "p2Ms", p2Ms) || !GetOptionalUint32(options, "p2StarMs", p2StarMs) || p2Ms == 0 ||
+        p2StarMs == 0) {
+        return false;
+    }
+    timing.p2_us = static_cast<int64_t>(p2Ms) * 1000;
+    timing.p2_star_us = static_cast<int64_t>(p2StarMs) * 1000;
+    return true;
+}
@@ -0,0 +1,16 @@
+#ifndef ACE_CAN_UDS_H
+#define ACE_CAN_UDS_H
+
+#include <napi.h>
+#include <cstdint>
+#include <vector>
+
+#include "isotp.h"
+#include "uds_session.h"
+
+// Reads an array of request Buffers (1 to 4095 bytes each); false if it is not one.
+bool ReadUdsRequests(const Napi::Value& value, std::vector<std::vector<uint8_t>>& out);
+// Reads { p2Ms, p2StarMs } into `timing`; false on a type mismatch or a zero value.
+bool ReadUdsTiming(const Napi::Object& options, UdsTiming& timing);
+
+#endif // ACE_CAN_UDS_H
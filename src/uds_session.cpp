@@ -0,0 +1,74 @@
+#include "uds_session.h"
+
+#include "timed_tx.h"
+
+namespace {
+
+constexpr uint8_t kNegativeResponse = 0x7F;
+constexpr uint8_t kResponsePending = 0x78;
+constexpr uint8_t kPositiveOffset = 0x40;
+
+// Services whose second byte is a sub-function, and so may carry suppressPosRspMsgIndication.
+bool HasSubFunction(uint8_t service) {
+    switch (service) {
+        case 0x10: // DiagnosticSessionControl
+        case 0x11: // ECUReset
+        case 0x27: // SecurityAccess
+        case 0x28: // CommunicationControl
+        case 0x29: // Authentication
+        case 0x31: // RoutineControl
+        case 0x3E: // TesterPresent
+        case 0x85: // ControlDTCSetting
+        case 0x87: // LinkControl
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+bool UdsSuppressesPositiveResponse(const std::vector<uint8_t>& request) {
+    return request.size() >= 2 && HasSubFunction(request[0]) && (request[1] & 0x80) != 0;
+}
+
+Async<UdsResponse> UdsRequest(SessionScheduler& scheduler, const IsoTpConfig& config, const UdsTiming& timing,
+                              uint32_t txId, uint32_t rxId, std::vector<uint8_t> request) {
+    UdsResponse response;
+    uint8_t service = request.empty() ? 0 : request[0];
+    bool suppressed = UdsSuppressesPositiveResponse(request);
+    response.error = co_await IsoTpSend(scheduler, config, txId, rxId, std::move(request));
+    if (!response.error.empty() || suppressed) {
+        co_return response;
+    }
+
+    int64_t deadlineUs = HostMicros() + timing.p2_us;
+    while (true) {
+        int64_t remainingUs = deadlineUs - HostMicros();
+        if (remainingUs <= 0) {
+            response.error = "UDS response timeout";
+            co_return response;
+        }
+        IsoTpResult received = co_await IsoTpReceive(scheduler, config, rxId, txId, remainingUs);
+        if (!received.error.empty()) {
+            response.error = std::move(received.error);
+            co_return response;
+        }
+        const std::vector<uint8_t>& data = received.data;
+        if (data.size() >= 3 && data[0] == kNegativeResponse && data[1] == service) {
+            if (data[2] == kResponsePending) {
+                response.pending++;
+                deadlineUs = HostMicros() + timing.p2_star_us;
+                continue;
+            }
+            response.nrc = data[2];
+            response.data = std::move(received.data);
+            co_return response;
+        }
+        if (!data.empty() && data[0] == static_cast<uint8_t>(service + kPositiveOffset)) {
+            response.data = std::move(received.data);
+            co_return response;
+        }
+        // An answer to some other request (e.g. a late one after a timeout); keep waiting.
+    }
+}
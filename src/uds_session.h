@@ -0,0 +1,34 @@
+#ifndef ACE_CAN_UDS_SESSION_H
+#define ACE_CAN_UDS_SESSION_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "isotp_session.h"
+#include "session_scheduler.h"
+
+// ISO 14229 application timing, per ECU.
+struct UdsTiming {
+    int64_t p2_us = 50000; // request to first response
+    int64_t p2_star_us = 5000000; // after each "response pending" (NRC 0x78)
+};
+
+struct UdsResponse {
+    std::string error; // transport failure or timeout; empty when the ECU answered
+    uint8_t nrc = 0; // negative response code, 0 for a positive response
+    std::vector<uint8_t> data; // the response as received, 0x7F responses included
+    uint32_t pending = 0; // "response pending" answers before the final one
+};
+
+// One UDS request/response exchange as a scheduler coroutine: sends `request` over ISO-TP and
+// waits for the matching response within P2, extending the wait by P2* for each response-pending
+// answer. Responses to other services are skipped. Requests with the suppressPosRspMsgIndication
+// bit set complete once sent.
+Async<UdsResponse> UdsRequest(SessionScheduler& scheduler, const IsoTpConfig& config, const UdsTiming& timing,
+                              uint32_t txId, uint32_t rxId, std::vector<uint8_t> request);
+
+// True if the request sets suppressPosRspMsgIndication, so only a negative response may follow.
+bool UdsSuppressesPositiveResponse(const std::vector<uint8_t>& request);
+
+#endif // ACE_CAN_UDS_SESSION_H
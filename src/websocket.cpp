@@ -0,0 +1,225 @@
+#include "websocket.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+constexpr const char* kWebSocketGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+uint32_t RotateLeft(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+// SHA-1 of a short string; only used for Sec-WebSocket-Accept.
+void Sha1(const std::string& input, uint8_t digest[20]) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    std::vector<uint8_t> data(input.begin(), input.end());
+    uint64_t bits = static_cast<uint64_t>(data.size()) * 8;
+    data.push_back(0x80);
+    while (data.size() % 64 != 56) {
+        data.push_back(0);
+    }
+    for (int i = 7; i >= 0; --i) {
+        data.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+    }
+    for (size_t block = 0; block < data.size(); block += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i) {
+            const uint8_t* p = &data[block + 4 * i];
+            w[i] = (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+                   (static_cast<uint32_t>(p[2]) << 8) | p[3];
+        }
+        for (int i = 16; i < 80; ++i) {
+            w[i] = RotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; ++i) {
+            uint32_t f;
+            uint32_t k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t temp = RotateLeft(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = RotateLeft(b, 30);
+            b = a;
+            a = temp;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+    for (int i = 0; i < 5; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            digest[4 * i + j] = static_cast<uint8_t>(h[i] >> (24 - 8 * j));
+        }
+    }
+}
+
+std::string Base64(const uint8_t* data, size_t size) {
+    static const char* kAlphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    for (size_t i = 0; i < size; i += 3) {
+        uint32_t chunk = static_cast<uint32_t>(data[i]) << 16;
+        if (i + 1 < size) {
+            chunk |= static_cast<uint32_t>(data[i + 1]) << 8;
+        }
+        if (i + 2 < size) {
+            chunk |= data[i + 2];
+        }
+        out.push_back(kAlphabet[(chunk >> 18) & 0x3F]);
+        out.push_back(kAlphabet[(chunk >> 12) & 0x3F]);
+        out.push_back(i + 1 < size ? kAlphabet[(chunk >> 6) & 0x3F] : '=');
+        out.push_back(i + 2 < size ? kAlphabet[chunk & 0x3F] : '=');
+    }
+    return out;
+}
+
+std::string Lower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+std::string Trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t");
+    size_t end = text.find_last_not_of(" \t\r");
+    return begin == std::string::npos ? std::string() : text.substr(begin, end - begin + 1);
+}
+
+} // namespace
+
+std::string WebSocketHandshake(const std::string& request, std::string& response) {
+    if (request.compare(0, 4, "GET ") != 0) {
+        return "Not a GET request";
+    }
+    std::string key;
+    bool upgrade = false;
+    size_t line = request.find("\r\n");
+    while (line != std::string::npos && line + 2 < request.size()) {
+        size_t next = request.find("\r\n", line + 2);
+        std::string header = request.substr(line + 2, next == std::string::npos ? std::string::npos : next - line - 2);
+        size_t colon = header.find(':');
+        if (colon != std::string::npos) {
+            std::string name = Lower(Trim(header.substr(0, colon)));
+            std::string value = Trim(header.substr(colon + 1));
+            if (name == "upgrade") {
+                upgrade = Lower(value) == "websocket";
+            } else if (name == "sec-websocket-key") {
+                key = value;
+            }
+        }
+        line = next;
+    }
+    if (!upgrade || key.empty()) {
+        return "Not a WebSocket upgrade";
+    }
+    uint8_t digest[20];
+    Sha1(key + kWebSocketGuid, digest);
+    response = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+               "Sec-WebSocket-Accept: " + Base64(digest, sizeof(digest)) + "\r\n\r\n";
+    return std::string();
+}
+
+size_t WriteWebSocketHeader(uint8_t* out, uint8_t opcode, uint64_t payloadSize) {
+    out[0] = static_cast<uint8_t>(0x80 | opcode);
+    if (payloadSize < 126) {
+        out[1] = static_cast<uint8_t>(payloadSize);
+        return 2;
+    }
+    if (payloadSize <= 0xFFFF) {
+        out[1] = 126;
+        out[2] = static_cast<uint8_t>(payloadSize >> 8);
+        out[3] = static_cast<uint8_t>(payloadSize);
+        return 4;
+    }
+    out[1] = 127;
+    for (int i = 0; i < 8; ++i) {
+        out[2 + i] = static_cast<uint8_t>(payloadSize >> (56 - 8 * i));
+    }
+    return 10;
+}
+
+int WebSocketReader::Next(Message& message) {
+    for (;;) {
+        if (buffer_.size() < 2) {
+            return 0;
+        }
+        bool fin = (buffer_[0] & 0x80) != 0;
+        uint8_t opcode = buffer_[0] & 0x0F;
+        if ((buffer_[1] & 0x80) == 0) {
+            return -1; // clients must mask
+        }
+        uint64_t size = buffer_[1] & 0x7F;
+        size_t header = 2;
+        if (size == 126) {
+            if (buffer_.size() < 4) {
+                return 0;
+            }
+            size = (static_cast<uint64_t>(buffer_[2]) << 8) | buffer_[3];
+            header = 4;
+        } else if (size == 127) {
+            if (buffer_.size() < 10) {
+                return 0;
+            }
+            size = 0;
+            for (int i = 0; i < 8; ++i) {
+                size = (size << 8) | buffer_[2 + i];
+            }
+            header = 10;
+        }
+        if (size > max_message_ || fragments_.size() + size > max_message_) {
+            return -1;
+        }
+        if (buffer_.size() < header + 4 + size) {
+            return 0;
+        }
+        const uint8_t* mask = &buffer_[header];
+        const uint8_t* payload = mask + 4;
+        std::vector<uint8_t> data(static_cast<size_t>(size));
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = payload[i] ^ mask[i & 3];
+        }
+        buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(header + 4 + size));
+
+        if (opcode >= kWebSocketClose) {
+            // Control frames may arrive between the fragments of a message.
+            if (!fin) {
+                return -1;
+            }
+            message.opcode = opcode;
+            message.payload.swap(data);
+            return 1;
+        }
+        if (opcode != 0) {
+            if (fragment_opcode_ != 0) {
+                return -1;
+            }
+            fragment_opcode_ = opcode;
+        } else if (fragment_opcode_ == 0) {
+            return -1;
+        }
+        fragments_.insert(fragments_.end(), data.begin(), data.end());
+        if (fin) {
+            message.opcode = fragment_opcode_;
+            message.payload.swap(fragments_);
+            fragments_.clear();
+            fragment_opcode_ = 0;
+            return 1;
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef ACE_CAN_WEBSOCKET_H
+#define ACE_CAN_WEBSOCKET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The parts of WebSocket (RFC 6455) a native server needs: the opening handshake, unmasked server
+// frames and a parser for the masked frames clients send.
+constexpr uint8_t kWebSocketText = 0x1;
+constexpr uint8_t kWebSocketBinary = 0x2;
+constexpr uint8_t kWebSocketClose = 0x8;
+constexpr uint8_t kWebSocketPing = 0x9;
+constexpr uint8_t kWebSocketPong = 0xA;
+constexpr size_t kWebSocketMaxHeader = 10; // server frames are never masked
+
+// Checks a complete HTTP request (up to the blank line) for a WebSocket upgrade and builds the
+// 101 response. Returns why the request was refused, or an empty string.
+std::string WebSocketHandshake(const std::string& request, std::string& response);
+
+// Writes the header of one unfragmented server frame; returns its size.
+size_t WriteWebSocketHeader(uint8_t* out, uint8_t opcode, uint64_t payloadSize);
+
+// Splits the client byte stream into messages; fragments are joined and payloads unmasked.
+class WebSocketReader {
+public:
+    struct Message {
+        uint8_t opcode = 0;
+        std::vector<uint8_t> payload;
+    };
+
+    explicit WebSocketReader(size_t maxMessage) : max_message_(maxMessage) {}
+
+    void Append(const uint8_t* data, size_t size) { buffer_.insert(buffer_.end(), data, data + size); }
+    // 1 with a message, 0 when more bytes are needed, -1 on a protocol violation.
+    int Next(Message& message);
+
+private:
+    size_t max_message_;
+    std::vector<uint8_t> buffer_;
+    uint8_t fragment_opcode_ = 0;
+    std::vector<uint8_t> fragments_;
+};
+
+#endif // ACE_CAN_WEBSOCKET_H
@@ -0,0 +1,160 @@
+#ifndef ACE_CAN_WIRE_WRITERS_H
+#define ACE_CAN_WIRE_WRITERS_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// MessagePack and CBOR (RFC 8949) writers with one interface, so encoders can be templated on the
+// format. Each writes at `p`, which must have room for kWireMaxHead bytes plus any payload, and
+// returns the end of what it wrote. Sizes use the shortest form the format allows.
+constexpr size_t kWireMaxHead = 9; // type byte and a 64-bit length or value
+
+inline uint8_t* PutWireBigEndian(uint8_t* p, uint64_t value, int bytes) {
+    for (int i = bytes - 1; i >= 0; --i) {
+        *p++ = static_cast<uint8_t>(value >> (8 * i));
+    }
+    return p;
+}
+
+inline uint64_t WireDoubleBits(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+struct MsgPackWriter {
+    // Fixed, 16-bit or 32-bit form by size; `fixed` is the fix type, `wide` its 16-bit counterpart.
+    static uint8_t* Sized(uint8_t* p, uint8_t fixed, uint32_t fixedLimit, uint8_t wide, uint64_t n) {
+        if (n < fixedLimit) {
+            *p++ = static_cast<uint8_t>(fixed | n);
+        } else if (n <= 0xFFFF) {
+            *p++ = wide;
+            p = PutWireBigEndian(p, n, 2);
+        } else {
+            *p++ = static_cast<uint8_t>(wide + 1);
+            p = PutWireBigEndian(p, n, 4);
+        }
+        return p;
+    }
+    static uint8_t* Array(uint8_t* p, uint64_t n) { return Sized(p, 0x90, 16, 0xDC, n); }
+    static uint8_t* Map(uint8_t* p, uint64_t n) { return Sized(p, 0x80, 16, 0xDE, n); }
+    static uint8_t* Text(uint8_t* p, const std::string& text) {
+        if (text.size() < 32) {
+            *p++ = static_cast<uint8_t>(0xA0 | text.size());
+        } else if (text.size() <= 0xFF) {
+            *p++ = 0xD9;
+            *p++ = static_cast<uint8_t>(text.size());
+        } else {
+            p = Sized(p, 0, 0, 0xDA, text.size());
+        }
+        std::memcpy(p, text.data(), text.size());
+        return p + text.size();
+    }
+    static uint8_t* Bytes(uint8_t* p, const uint8_t* data, size_t size) {
+        *p++ = 0xC4; // bin 8; frame data is at most 64 bytes
+        *p++ = static_cast<uint8_t>(size);
+        std::memcpy(p, data, size);
+        return p + size;
+    }
+    static uint8_t* Uint(uint8_t* p, uint64_t value) {
+        if (value < 0x80) {
+            *p++ = static_cast<uint8_t>(value);
+        } else if (value <= 0xFF) {
+            *p++ = 0xCC;
+            *p++ = static_cast<uint8_t>(value);
+        } else if (value <= 0xFFFF) {
+            *p++ = 0xCD;
+            p = PutWireBigEndian(p, value, 2);
+        } else if (value <= 0xFFFFFFFF) {
+            *p++ = 0xCE;
+            p = PutWireBigEndian(p, value, 4);
+        } else {
+            *p++ = 0xCF;
+            p = PutWireBigEndian(p, value, 8);
+        }
+        return p;
+    }
+    static uint8_t* Int(uint8_t* p, int64_t value) {
+        if (value >= 0) {
+            return Uint(p, static_cast<uint64_t>(value));
+        }
+        if (value >= -32) {
+            *p++ = static_cast<uint8_t>(value);
+        } else if (value >= -128) {
+            *p++ = 0xD0;
+            *p++ = static_cast<uint8_t>(value);
+        } else if (value >= -32768) {
+            *p++ = 0xD1;
+            p = PutWireBigEndian(p, static_cast<uint64_t>(value), 2);
+        } else if (value >= INT32_MIN) {
+            *p++ = 0xD2;
+            p = PutWireBigEndian(p, static_cast<uint64_t>(value), 4);
+        } else {
+            *p++ = 0xD3;
+            p = PutWireBigEndian(p, static_cast<uint64_t>(value), 8);
+        }
+        return p;
+    }
+    static uint8_t* Double(uint8_t* p, double value) {
+        *p++ = 0xCB;
+        return PutWireBigEndian(p, WireDoubleBits(value), 8);
+    }
+};
+
+struct CborWriter {
+    static uint8_t* Head(uint8_t* p, uint8_t major, uint64_t value) {
+        uint8_t type = static_cast<uint8_t>(major << 5);
+        if (value < 24) {
+            *p++ = static_cast<uint8_t>(type | value);
+        } else if (value <= 0xFF) {
+            *p++ = type | 24;
+            *p++ = static_cast<uint8_t>(value);
+        } else if (value <= 0xFFFF) {
+            *p++ = type | 25;
+            p = PutWireBigEndian(p, value, 2);
+        } else if (value <= 0xFFFFFFFF) {
+            *p++ = type | 26;
+            p = PutWireBigEndian(p, value, 4);
+        } else {
+            *p++ = type | 27;
+            p = PutWireBigEndian(p, value, 8);
+        }
+        return p;
+    }
+    static uint8_t* Array(uint8_t* p, uint64_t n) { return Head(p, 4, n); }
+    static uint8_t* Map(uint8_t* p, uint64_t n) { return Head(p, 5, n); }
+    static uint8_t* Text(uint8_t* p, const std::string& text) {
+        p = Head(p, 3, text.size());
+        std::memcpy(p, text.data(), text.size());
+        return p + text.size();
+    }
+    static uint8_t* Bytes(uint8_t* p, const uint8_t* data, size_t size) {
+        p = Head(p, 2, size);
+        std::memcpy(p, data, size);
+        return p + size;
+    }
+    static uint8_t* Uint(uint8_t* p, uint64_t value) { return Head(p, 0, value); }
+    static uint8_t* Int(uint8_t* p, int64_t value) {
+        // Major type 1 encodes -1 - n.
+        return value >= 0 ? Head(p, 0, static_cast<uint64_t>(value)) : Head(p, 1, ~static_cast<uint64_t>(value));
+    }
+    static uint8_t* Double(uint8_t* p, double value) {
+        *p++ = 0xFB;
+        return PutWireBigEndian(p, WireDoubleBits(value), 8);
+    }
+};
+
+// Integers stay integers on the wire (and in JSON terms); anything else, NaN included, is a float64.
+template <typename Writer>
+uint8_t* PutWireNumber(uint8_t* p, double value) {
+    constexpr double kMaxExactInteger = 9007199254740992.0; // 2^53
+    if (value >= -kMaxExactInteger && value <= kMaxExactInteger && value == std::trunc(value)) {
+        return Writer::Int(p, static_cast<int64_t>(value));
+    }
+    return Writer::Double(p, value);
+}
+
+#endif // ACE_CAN_WIRE_WRITERS_H
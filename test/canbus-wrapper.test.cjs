@@ -27,7 +27,34 @@ class FakeNativeCANBus extends EventEmitter {
 FakeNativeCANBus.instances = [];
 FakeNativeCANBus.isAvailable = (bustype) => bustype === 'busmust';
 
-const fakeNativeModule = { CANBus: FakeNativeCANBus };
+class FakeNativeRedundantBus extends EventEmitter {
+  constructor(primary, secondary) {
+    super();
+    this.primary = primary;
+    this.secondary = secondary;
+    this.activeIndex = 0;
+    this.transmits = [];
+  }
+
+  active() {
+    return this.activeIndex;
+  }
+
+  recordTransmit(message, source) {
+    this.transmits.push([message.id, source]);
+  }
+
+  failover(reason) {
+    this.activeIndex = 1 - this.activeIndex;
+    this.reason = reason;
+    return this.activeIndex;
+  }
+}
+
+const fakeNativeModule = {
+  CANBus: FakeNativeCANBus,
+  RedundantBus: FakeNativeRedundantBus,
+};
 
 const nodeGypBuildPath = require.resolve('node-gyp-build');
 require.cache[nodeGypBuildPath] = {
@@ -37,7 +64,7 @@ require.cache[nodeGypBuildPath] = {
   exports: () => fakeNativeModule,
 };
 
-const { CANBus, isAvailable } = require('../dist');
+const { CANBus, RedundantBus, isAvailable, decodeFrameBatch, decodeStreamMessage, FRAME_RECORD_SIZE, FrameFlags } = require('../dist');
 
 test.beforeEach(() => {
   FakeNativeCANBus.instances = [];
@@ -97,3 +124,58 @@ test('close listeners run when native layer emits close', async () => {
   await closePromise;
   bus.close();
 });
+
+test('decodeStreamMessage reads FrameStreamServer messages', () => {
+  const message = Buffer.alloc(4 + 16 + 3);
+  message.writeUInt32LE(1, 0);
+  message.writeDoubleLE(1234567, 4);
+  message.writeUInt32LE(0x18daf110, 12);
+  message.writeUInt8(FrameFlags.EXTENDED, 16);
+  message.writeUInt8(3, 17);
+  message.writeUInt16LE(2, 18);
+  Buffer.from([0x02, 0x7e, 0x00]).copy(message, 20);
+  const [frame] = decodeStreamMessage(new Uint8Array(message));
+  assert.deepEqual(frame, { timestamp: 1234567, id: 0x18daf110, flags: FrameFlags.EXTENDED, channel: 2, data: Buffer.from([0x02, 0x7e, 0x00]) });
+});
+
+test('RedundantBus fails over to the secondary when the primary cannot transmit', () => {
+  const primary = new CANBus(0, 'busmust', 500000);
+  const secondary = new CANBus(1, 'busmust', 500000);
+  const [primaryNative, secondaryNative] = FakeNativeCANBus.instances;
+  const pair = new RedundantBus(primary, secondary);
+
+  pair.send({ id: 0x100, data: Buffer.from([1]) });
+  assert.equal(primaryNative.sentMessages.length, 1);
+
+  primaryNative.send = () => {
+    throw new Error('bus off');
+  };
+  pair.send({ id: 0x101, data: Buffer.from([2]) });
+  assert.equal(secondaryNative.sentMessages.length, 1);
+  assert.equal(pair.active(), 'secondary');
+  assert.match(pair.native.reason, /bus off/);
+  // Every send is recorded for the adapter it goes out on, so the other one's copy is not delivered.
+  assert.deepEqual(pair.native.transmits, [[0x100, 0], [0x101, 0], [0x101, 1]]);
+  primary.close();
+  secondary.close();
+});
+
+test('decodeFrameBatch decodes fixed-size frame records', () => {
+  const batch = Buffer.alloc(FRAME_RECORD_SIZE * 2);
+  batch.writeBigUInt64LE(1234n, 0);
+  batch.writeUInt32LE(0x123, 8);
+  batch.writeUInt8(2, 13);
+  batch.set([0xaa, 0xbb], 16);
+  batch.writeBigUInt64LE(5678n, FRAME_RECORD_SIZE);
+  batch.writeUInt32LE(0x18ff00fa, FRAME_RECORD_SIZE + 8);
+  batch.writeUInt8(FrameFlags.EXTENDED, FRAME_RECORD_SIZE + 12);
+  batch.writeUInt16LE(1, FRAME_RECORD_SIZE + 14);
+
+  const frames = decodeFrameBatch(batch);
+  assert.equal(frames.length, 2);
+  assert.deepEqual(frames[0], { timestamp: 1234, id: 0x123, flags: 0, channel: 0, data: Buffer.from([0xaa, 0xbb]) });
+  assert.equal(frames[1].id, 0x18ff00fa);
+  assert.equal(frames[1].flags, FrameFlags.EXTENDED);
+  assert.equal(frames[1].channel, 1);
+  assert.equal(frames[1].data.length, 0);
+});
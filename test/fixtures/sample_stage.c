@@ -0,0 +1,84 @@
+/*
+ * Receive stage used by test/native/stage_plugin.test.cpp. Config "id=<hex>" selects a frame ID:
+ * error frames are dropped, frames with that ID are annotated with their byte sum and followed by
+ * a derived frame (ID + 1, data reversed), and each one emits a result tagged with the ID. Config
+ * "fail" makes create() fail. Built with -DSTAGE_ABI=<n> or -DSTAGE_NO_ENTRY to test rejection.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ace_can_stage.h"
+
+#ifndef STAGE_ABI
+#define STAGE_ABI ACE_CAN_STAGE_ABI_VERSION
+#endif
+
+typedef struct sample_stage {
+    uint32_t id;
+    const ace_can_stage_host* host;
+} sample_stage;
+
+static void* sample_create(const char* config, const ace_can_stage_host* host, char* error, uint32_t error_size) {
+    unsigned id = 0;
+    if (strcmp(config, "fail") == 0 || sscanf(config, "id=%x", &id) != 1) {
+        snprintf(error, error_size, "bad config '%s'", config);
+        return NULL;
+    }
+    sample_stage* stage = (sample_stage*)malloc(sizeof(sample_stage));
+    stage->id = id;
+    stage->host = host;
+    return stage;
+}
+
+static void sample_process(void* instance, ace_can_batch* batch) {
+    sample_stage* stage = (sample_stage*)instance;
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < batch->count; ++i) {
+        if ((batch->frames[i].flags & ACE_CAN_FLAG_ERROR) == 0) {
+            batch->frames[kept] = batch->frames[i];
+            batch->annotations[kept] = batch->annotations[i];
+            ++kept;
+        }
+    }
+    uint32_t count = kept;
+    for (uint32_t i = 0; i < kept; ++i) {
+        const ace_can_frame* frame = &batch->frames[i];
+        if (frame->id != stage->id) {
+            continue;
+        }
+        uint32_t sum = 0;
+        for (uint8_t j = 0; j < frame->length; ++j) {
+            sum += frame->data[j];
+        }
+        batch->annotations[i] = 0x10000 | sum;
+        stage->host->emit(stage->host->context, frame->id, frame->data, frame->length);
+        if (count < batch->capacity) {
+            ace_can_frame* derived = &batch->frames[count];
+            *derived = *frame;
+            derived->id = frame->id + 1;
+            for (uint8_t j = 0; j < frame->length; ++j) {
+                derived->data[j] = frame->data[frame->length - 1 - j];
+            }
+            batch->annotations[count] = 0;
+            ++count;
+        }
+    }
+    batch->count = count;
+}
+
+static void sample_destroy(void* instance) {
+    free(instance);
+}
+
+static const ace_can_stage kSampleStage = {STAGE_ABI, "sample", sample_create, sample_process, sample_destroy};
+
+#ifndef STAGE_NO_ENTRY
+#ifdef __cplusplus
+extern "C"
+#endif
+ACE_CAN_STAGE_EXPORT const ace_can_stage* ace_can_stage_v1(void) {
+    return &kSampleStage;
+}
+#endif
@@ -0,0 +1,87 @@
+'use strict';
+
+// Builds and runs the native unit tests in test/native: each *.test.cpp is compiled together with the
+// addon sources it exercises (none of which depend on N-API or the adapter SDKs) and must exit 0.
+// Tests that build code of their own (generated decoders, stage plugins) use the same compiler, as ACE_CAN_CXX.
+// Needs a C++20 compiler: $CXX, or c++ when it exists; skipped otherwise.
+
+const test = require('node:test');
+const assert = require('node:assert/strict');
+const { spawnSync } = require('node:child_process');
+const fs = require('node:fs');
+const os = require('node:os');
+const path = require('node:path');
+
+const root = path.resolve(__dirname, '..');
+const cxx = process.env.CXX || 'c++';
+const haveCompiler = spawnSync(cxx, ['--version']).status === 0;
+const buildDir = fs.mkdtempSync(path.join(os.tmpdir(), 'ace-can-native-'));
+
+// Test name -> addon sources linked into it.
+const units = {
+  arxml_import: ['src/arxml_import.cpp', 'src/decode_tables.cpp'],
+  compiled_db: ['src/compiled_db.cpp', 'src/decode_tables.cpp', 'src/mapped_file.cpp'],
+  decoder_codegen: ['src/decoder_codegen.cpp', 'src/decode_tables.cpp', 'src/shared_library.cpp'],
+  device_watcher: ['src/device_watcher.cpp'],
+  doip: ['src/doip.cpp'],
+  downsample: ['src/downsample.cpp'],
+  fast_packet: ['src/fast_packet.cpp'],
+  filter_program: ['src/filter_program.cpp'],
+  flash_session: ['src/session_scheduler.cpp', 'src/isotp_session.cpp', 'src/uds_session.cpp', 'src/flash_session.cpp', 'src/mapped_file.cpp'],
+  frame_dedup: ['src/frame_dedup.cpp'],
+  id_scanner: ['src/id_scanner.cpp'],
+  isotp_session: ['src/session_scheduler.cpp', 'src/isotp_session.cpp'],
+  latency_histogram: [],
+  log_file: ['src/log_file.cpp'],
+  receive_pipeline: ['src/filter_program.cpp'],
+  receive_poller: ['src/receive_poller.cpp'],
+  stage_plugin: ['src/stage_plugin.cpp', 'src/shared_library.cpp'],
+  timed_tx: [],
+  tunnel: ['src/tunnel.cpp'],
+  tx_shaper: [],
+  uds_session: ['src/session_scheduler.cpp', 'src/isotp_session.cpp', 'src/uds_session.cpp'],
+  websocket: ['src/websocket.cpp'],
+  wire_writers: [],
+};
+
+// Units that also link libuv, built against the uv.h that ships with Node. Set ACE_CAN_LIBUV to the
+// library (or linker flags) when -luv does not find it; skipped when it cannot be linked.
+const libuvUnits = new Set(['receive_poller']);
+const nodeInclude = path.join(path.dirname(process.execPath), '..', 'include', 'node');
+const libuvArgs = [`-I${nodeInclude}`, ...(process.env.ACE_CAN_LIBUV || '-luv').split(' ')];
+const haveLibuv = haveCompiler && spawnSync(cxx, [
+  '-x', 'c++', '-', '-x', 'none', ...libuvArgs, '-o', path.join(buildDir, 'libuv-probe'),
+], { input: '#include <uv.h>\nint main() { return uv_version() == 0; }\n' }).status === 0;
+
+function skipReason(name) {
+  if (!haveCompiler) {
+    return `no C++ compiler (${cxx})`;
+  }
+  if (libuvUnits.has(name) && !haveLibuv) {
+    return 'libuv cannot be linked (set ACE_CAN_LIBUV)';
+  }
+  return false;
+}
+
+for (const [name, sources] of Object.entries(units)) {
+  test(`native ${name}`, { skip: skipReason(name) }, () => {
+    const binary = path.join(buildDir, name);
+    const args = [
+      '-std=c++20', '-O1', '-g', '-Wall', '-Wextra', '-pthread',
+      `-I${path.join(root, 'src')}`,
+      `-DACE_CAN_FIXTURES="${path.join(root, 'test', 'fixtures')}"`,
+      `-DACE_CAN_SRC="${path.join(root, 'src')}"`,
+      `-DACE_CAN_CXX="${cxx}"`,
+      path.join(root, 'test', 'native', `${name}.test.cpp`),
+      ...sources.map((source) => path.join(root, source)),
+      ...(libuvUnits.has(name) ? libuvArgs : []),
+      '-o', binary,
+    ];
+    const build = spawnSync(cxx, args, { encoding: 'utf8' });
+    assert.equal(build.status, 0, build.stderr);
+    const run = spawnSync(binary, [], { encoding: 'utf8', cwd: buildDir });
+    assert.equal(run.status, 0, run.stdout + run.stderr);
+  });
+}
+
+test.after(() => fs.rmSync(buildDir, { recursive: true, force: true }));
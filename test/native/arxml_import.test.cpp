@@ -0,0 +1,117 @@
+#include "decode_tables.h"
+
+#include <cstdio>
+#include <string>
+
+#include "check.h"
+
+namespace {
+
+std::string Fixture(const char* name) {
+    return std::string(ACE_CAN_FIXTURES) + "/" + name;
+}
+
+const SignalDef* FindSignal(const MessageDef& message, const std::string& name) {
+    for (const SignalDef& signal : message.signals) {
+        if (signal.name == name) {
+            return &signal;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+TEST("frames resolve through triggerings, PDUs and signals") {
+    DecodeTables tables;
+    CHECK_EQ(LoadArxml(Fixture("sample.arxml"), tables), std::string());
+    CHECK_EQ(tables.messages.size(), size_t{2});
+
+    const MessageDef* engine = tables.Find(0x123, false);
+    CHECK(engine != nullptr);
+    CHECK_EQ(engine->name, std::string("Engine"));
+    CHECK_EQ(engine->length, uint16_t{8});
+    CHECK(!engine->fd);
+    CHECK_EQ(engine->signals.size(), size_t{2});
+
+    const SignalDef* speed = FindSignal(*engine, "EngineSpeed");
+    CHECK(speed != nullptr);
+    CHECK(speed->little_endian);
+    CHECK_EQ(speed->start_bit, uint16_t{0});
+    CHECK_EQ(speed->length, uint16_t{16});
+    CHECK_EQ(speed->factor, 0.25);
+    CHECK_EQ(speed->maximum, 16383.75);
+    // The UNIT's display name wins over its short name.
+    CHECK_EQ(speed->unit, std::string("1/min"));
+}
+
+TEST("big-endian positions become DBC MSB numbering") {
+    DecodeTables tables;
+    CHECK_EQ(LoadArxml(Fixture("sample.arxml"), tables), std::string());
+    const SignalDef* coolant = FindSignal(*tables.Find(0x123, false), "CoolantTemp");
+    CHECK(coolant != nullptr);
+    CHECK(!coolant->little_endian);
+    CHECK_EQ(coolant->start_bit, uint16_t{23}); // LSB at bit 16 -> MSB at bit 23
+    CHECK(coolant->is_signed);
+    // The linear scale of a SCALE_LINEAR_AND_TEXTTABLE method; the text scale is ignored.
+    CHECK_EQ(coolant->offset, -40.0);
+    CHECK_EQ(coolant->minimum, -168.0);
+    CHECK_EQ(coolant->maximum, 86.0);
+    CHECK_EQ(coolant->unit, std::string("\xC2\xB0" "C"));
+
+    uint8_t data[8] = {0x10, 0x27, 0xE2, 0, 0, 0, 0, 0};
+    double speed = 0;
+    double temperature = 0;
+    DecodeMessage(*tables.Find(0x123, false), data, sizeof(data), [&](const SignalDef& signal, double value) {
+        (signal.name == "EngineSpeed" ? speed : temperature) = value;
+    });
+    CHECK_EQ(speed, 2500.0);
+    CHECK_EQ(temperature, -70.0); // 0xE2 = -30
+}
+
+TEST("E2E protection and SecOC settings are attached to their frames") {
+    DecodeTables tables;
+    CHECK_EQ(LoadArxml(Fixture("sample.arxml"), tables), std::string());
+    const MessageDef* engine = tables.Find(0x123, false);
+    CHECK(engine->e2e.has_value());
+    CHECK_EQ(engine->e2e->profile, std::string("PROFILE_05"));
+    CHECK_EQ(engine->e2e->data_id, uint32_t{4660});
+    CHECK_EQ(engine->e2e->crc_offset, uint32_t{48});
+    CHECK_EQ(engine->e2e->counter_offset, uint32_t{56});
+
+    const MessageDef* body = tables.Find(0x18FF00FA, true);
+    CHECK(body != nullptr);
+    CHECK(body->fd);
+    CHECK_EQ(body->length, uint16_t{16});
+    CHECK(!body->e2e.has_value());
+    CHECK(body->secoc.has_value());
+    CHECK_EQ(body->secoc->data_id, uint32_t{77});
+    CHECK_EQ(body->secoc->payload_length, uint32_t{12});
+    CHECK_EQ(body->secoc->mac_tx_bits, uint32_t{24});
+    CHECK_EQ(body->secoc->freshness_tx_bits, uint32_t{8});
+    CHECK_EQ(body->secoc->algorithm, std::string("CMAC/AES-128"));
+
+    // Signals come from the authentic PDU the secured PDU wraps.
+    CHECK_EQ(body->signals.size(), size_t{1});
+    CHECK(body->signals[0].value_type == SignalDef::ValueType::Float32);
+    CHECK_EQ(body->signals[0].start_bit, uint16_t{32});
+}
+
+TEST("malformed and empty files are reported") {
+    DecodeTables tables;
+    std::string missing = LoadArxml(Fixture("missing.arxml"), tables);
+    CHECK(missing.find("Failed to open") != std::string::npos);
+
+    const char* path = "unbalanced.arxml";
+    std::FILE* file = std::fopen(path, "wb");
+    std::fputs("<AUTOSAR><AR-PACKAGES></AUTOSAR>", file);
+    std::fclose(file);
+    CHECK(!LoadArxml(path, tables).empty());
+
+    file = std::fopen(path, "wb");
+    std::fputs("<AUTOSAR><AR-PACKAGES/></AUTOSAR>", file);
+    std::fclose(file);
+    std::string empty = LoadArxml(path, tables);
+    CHECK(empty.find("No CAN frame triggerings") != std::string::npos);
+    CHECK(tables.messages.empty());
+}
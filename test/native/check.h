@@ -0,0 +1,89 @@
+#ifndef ACE_CAN_TEST_CHECK_H
+#define ACE_CAN_TEST_CHECK_H
+
+// Minimal test harness for the native unit tests (see test/native.test.cjs). Each test binary is one
+// *.test.cpp file plus the sources it exercises; TEST cases register themselves and main() runs them.
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <type_traits>
+#include <string>
+#include <vector>
+
+namespace check {
+
+struct Case {
+    const char* name;
+    std::function<void()> run;
+};
+
+inline std::vector<Case>& Cases() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+inline int& Failures() {
+    static int failures = 0;
+    return failures;
+}
+
+struct Register {
+    Register(const char* name, std::function<void()> run) { Cases().push_back({name, std::move(run)}); }
+};
+
+inline void Fail(const char* file, int line, const std::string& message) {
+    std::fprintf(stderr, "%s:%d: %s\n", file, line, message.c_str());
+    Failures()++;
+}
+
+template <typename T>
+std::string Show(const T& value) {
+    if constexpr (std::is_convertible_v<T, std::string>) {
+        return "\"" + std::string(value) + "\"";
+    } else if constexpr (std::is_enum_v<T>) {
+        return std::to_string(static_cast<long long>(value));
+    } else {
+        return std::to_string(value);
+    }
+}
+
+} // namespace check
+
+#define CHECK_CONCAT_(a, b) a##b
+#define CHECK_CONCAT(a, b) CHECK_CONCAT_(a, b)
+#define TEST(name)                                                                                   \
+    static void CHECK_CONCAT(test_, __LINE__)();                                                     \
+    static check::Register CHECK_CONCAT(register_, __LINE__)(name, &CHECK_CONCAT(test_, __LINE__)); \
+    static void CHECK_CONCAT(test_, __LINE__)()
+
+// Failing checks report and return from the test case.
+#define CHECK(condition)                                                \
+    do {                                                                \
+        if (!(condition)) {                                             \
+            check::Fail(__FILE__, __LINE__, "CHECK(" #condition ")");   \
+            return;                                                     \
+        }                                                               \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                                              \
+    do {                                                                                                        \
+        const auto& checkActual_ = (actual);                                                                    \
+        const auto& checkExpected_ = (expected);                                                                \
+        if (!(checkActual_ == checkExpected_)) {                                                                \
+            check::Fail(__FILE__, __LINE__,                                                                     \
+                        #actual " == " + check::Show(checkActual_) + ", expected " + check::Show(checkExpected_)); \
+            return;                                                                                             \
+        }                                                                                                       \
+    } while (0)
+
+int main() {
+    for (const check::Case& c : check::Cases()) {
+        int before = check::Failures();
+        c.run();
+        std::printf("%s %s\n", check::Failures() == before ? "ok" : "FAIL", c.name);
+    }
+    return check::Failures() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#endif // ACE_CAN_TEST_CHECK_H
@@ -0,0 +1,174 @@
+#include "compiled_db.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+void WriteFile(const char* path, const void* data, size_t length) {
+    std::FILE* file = std::fopen(path, "wb");
+    if (length > 0) {
+        std::fwrite(data, 1, length, file);
+    }
+    std::fclose(file);
+}
+
+std::vector<uint8_t> ReadFile(const char* path) {
+    std::vector<uint8_t> bytes;
+    std::FILE* file = std::fopen(path, "rb");
+    for (int c; (c = std::fgetc(file)) != EOF;) {
+        bytes.push_back(static_cast<uint8_t>(c));
+    }
+    std::fclose(file);
+    return bytes;
+}
+
+uint64_t Fingerprint(const char* text) {
+    WriteFile("fingerprint.txt", text, std::strlen(text));
+    SourceFingerprint fingerprint;
+    if (!FingerprintFile("fingerprint.txt", fingerprint).empty() || fingerprint.size != std::strlen(text)) {
+        return 0;
+    }
+    return fingerprint.hash;
+}
+
+DecodeTables SampleTables() {
+    DecodeTables tables;
+    MessageDef engine;
+    engine.name = "Engine";
+    engine.id = 0x123;
+    engine.length = 8;
+    SignalDef speed;
+    speed.name = "EngineSpeed";
+    speed.length = 16;
+    speed.factor = 0.25;
+    speed.maximum = 16383.75;
+    speed.unit = "rpm";
+    engine.signals.push_back(speed);
+    SignalDef mode;
+    mode.name = "Mode";
+    mode.start_bit = 23;
+    mode.length = 4;
+    mode.little_endian = false;
+    mode.is_signed = true;
+    mode.mux = SignalDef::kMultiplexor;
+    engine.signals.push_back(mode);
+    engine.e2e = E2EProtection{"PROFILE_05", 0x1234, 64, 0, 16};
+    tables.Add(std::move(engine));
+
+    MessageDef body;
+    body.name = "Body";
+    body.id = 0x18FF00FA;
+    body.extended = true;
+    body.fd = true;
+    body.length = 24;
+    SignalDef level;
+    level.name = "Level";
+    level.length = 32;
+    level.value_type = SignalDef::ValueType::Float32;
+    level.unit = "rpm"; // shared with EngineSpeed in the string pool
+    body.signals.push_back(level);
+    body.secoc = SecOcProps{7, 16, 8, 24, "CMAC/AES-128"};
+    tables.Add(std::move(body));
+    return tables;
+}
+
+} // namespace
+
+TEST("source fingerprints are XXH64 of the content") {
+    CHECK_EQ(Fingerprint(""), uint64_t{0xEF46DB3751D8E999});
+    CHECK_EQ(Fingerprint("abc"), uint64_t{0x44BC2CF5AD770999});
+    // Longer than one 32-byte stripe.
+    CHECK_EQ(Fingerprint("Nobody inspects the spammish repetition"), uint64_t{0xFBCEA83C8A378BF1});
+
+    SourceFingerprint missing;
+    CHECK(!FingerprintFile("missing.dbc", missing).empty());
+}
+
+TEST("a saved image loads back into the same tables") {
+    SourceFingerprint source{0x0123456789ABCDEF, 4096};
+    DecodeTables saved = SampleTables();
+    CHECK_EQ(SaveCompiledTables("roundtrip.acedb", saved, source), std::string());
+
+    DecodeTables loaded;
+    CHECK_EQ(LoadCompiledTables("roundtrip.acedb", source, loaded), std::string());
+    CHECK_EQ(loaded.messages.size(), size_t{2});
+
+    const MessageDef* engine = loaded.Find(0x123, false);
+    CHECK(engine != nullptr);
+    CHECK_EQ(engine->name, std::string("Engine"));
+    CHECK_EQ(engine->length, uint16_t{8});
+    CHECK_EQ(engine->signals.size(), size_t{2});
+    CHECK_EQ(engine->signals[0].name, std::string("EngineSpeed"));
+    CHECK_EQ(engine->signals[0].factor, 0.25);
+    CHECK_EQ(engine->signals[0].maximum, 16383.75);
+    CHECK_EQ(engine->signals[0].unit, std::string("rpm"));
+    CHECK_EQ(engine->signals[1].start_bit, uint16_t{23});
+    CHECK(!engine->signals[1].little_endian);
+    CHECK(engine->signals[1].is_signed);
+    CHECK_EQ(engine->signals[1].mux, SignalDef::kMultiplexor);
+    CHECK_EQ(engine->signals[1].unit, std::string());
+    CHECK(engine->e2e.has_value());
+    CHECK_EQ(engine->e2e->profile, std::string("PROFILE_05"));
+    CHECK_EQ(engine->e2e->data_id, uint32_t{0x1234});
+    CHECK_EQ(engine->e2e->counter_offset, uint32_t{16});
+    CHECK(!engine->secoc.has_value());
+
+    const MessageDef* body = loaded.Find(0x18FF00FA, true);
+    CHECK(body != nullptr);
+    CHECK(body->fd);
+    CHECK_EQ(body->length, uint16_t{24});
+    CHECK_EQ(body->signals.size(), size_t{1});
+    CHECK_EQ(body->signals[0].value_type, SignalDef::ValueType::Float32);
+    CHECK_EQ(body->signals[0].unit, std::string("rpm"));
+    CHECK(!body->e2e.has_value());
+    CHECK(body->secoc.has_value());
+    CHECK_EQ(body->secoc->payload_length, uint32_t{16});
+    CHECK_EQ(body->secoc->mac_tx_bits, uint32_t{24});
+    CHECK_EQ(body->secoc->algorithm, std::string("CMAC/AES-128"));
+    CHECK(loaded.Find(0x123, true) == nullptr);
+}
+
+TEST("an image built from other source content is out of date") {
+    SourceFingerprint source{42, 100};
+    CHECK_EQ(SaveCompiledTables("stale.acedb", SampleTables(), source), std::string());
+
+    DecodeTables tables;
+    CHECK_EQ(LoadCompiledTables("stale.acedb", SourceFingerprint{43, 100}, tables),
+             std::string("Compiled database is out of date"));
+    CHECK_EQ(LoadCompiledTables("stale.acedb", SourceFingerprint{42, 101}, tables),
+             std::string("Compiled database is out of date"));
+    CHECK(tables.messages.empty());
+}
+
+TEST("damaged images are rejected") {
+    SourceFingerprint source{1, 2};
+    CHECK_EQ(SaveCompiledTables("damaged.acedb", SampleTables(), source), std::string());
+    std::vector<uint8_t> image = ReadFile("damaged.acedb");
+    CHECK(image.size() > 80);
+    DecodeTables tables;
+
+    std::vector<uint8_t> flipped = image;
+    flipped.back() ^= 0x01;
+    WriteFile("flipped.acedb", flipped.data(), flipped.size());
+    CHECK_EQ(LoadCompiledTables("flipped.acedb", source, tables), std::string("Compiled database is corrupt"));
+
+    WriteFile("short.acedb", image.data(), image.size() - 8);
+    CHECK_EQ(LoadCompiledTables("short.acedb", source, tables), std::string("Compiled database is truncated"));
+    WriteFile("header.acedb", image.data(), 40);
+    CHECK_EQ(LoadCompiledTables("header.acedb", source, tables), std::string("Compiled database is truncated"));
+
+    std::vector<uint8_t> foreign = image;
+    foreign[0] = 'X';
+    WriteFile("foreign.acedb", foreign.data(), foreign.size());
+    CHECK_EQ(LoadCompiledTables("foreign.acedb", source, tables), std::string("Unsupported compiled database format"));
+
+    WriteFile("empty.acedb", image.data(), 0);
+    CHECK_EQ(LoadCompiledTables("empty.acedb", source, tables), std::string("Compiled database is truncated"));
+    CHECK_EQ(LoadCompiledTables("missing.acedb", source, tables).rfind("Failed to open missing.acedb", 0), size_t{0});
+    CHECK(tables.messages.empty());
+}
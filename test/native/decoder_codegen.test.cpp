@@ -0,0 +1,179 @@
+#include "decoder_codegen.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ace_can_decoder.h"
+#include "check.h"
+#include "shared_library.h"
+
+namespace {
+
+using Values = std::vector<std::pair<uint32_t, double>>;
+
+std::string Fixture(const char* name) {
+    return std::string(ACE_CAN_FIXTURES) + "/" + name;
+}
+
+// Generates the plugin source for the sample database and builds it with the compiler that built
+// this test, as SignalDatabase.generateDecoder() users would.
+const ace_can_decoder* BuildPlugin(const DecodeTables& tables, SharedLibrary& library) {
+    std::FILE* file = std::fopen("decoder.cpp", "wb");
+    std::string source = GenerateDecoderSource(tables, "sample.dbc");
+    std::fwrite(source.data(), 1, source.size(), file);
+    std::fclose(file);
+    std::string command = std::string(ACE_CAN_CXX) + " -std=c++17 -O2 -Wall -Werror -shared -fPIC -I \"" + ACE_CAN_SRC +
+                          "\" -o ./decoder.so decoder.cpp";
+    if (std::system(command.c_str()) != 0 || !library.Open("./decoder.so").empty()) {
+        return nullptr;
+    }
+    auto entry = reinterpret_cast<ace_can_decoder_entry>(library.Symbol(ACE_CAN_DECODER_ENTRY));
+    return entry != nullptr ? entry() : nullptr;
+}
+
+struct Plugin {
+    DecodeTables tables;
+    SharedLibrary library;
+    const ace_can_decoder* decoder = nullptr;
+
+    Plugin() {
+        if (LoadDbc(Fixture("sample.dbc"), tables).empty()) {
+            decoder = BuildPlugin(tables, library);
+        }
+    }
+};
+
+Plugin& SharedPlugin() {
+    static Plugin plugin;
+    return plugin;
+}
+
+void Collect(void* context, uint32_t signal, double value) {
+    static_cast<Values*>(context)->emplace_back(signal, value);
+}
+
+uint32_t FirstSignal(const DecodeTables& tables, const MessageDef& message) {
+    uint32_t first = 0;
+    for (const MessageDef& other : tables.messages) {
+        if (&other == &message) {
+            break;
+        }
+        first += static_cast<uint32_t>(other.signals.size());
+    }
+    return first;
+}
+
+Values Runtime(const DecodeTables& tables, const MessageDef& message, const uint8_t* data, size_t length) {
+    Values values;
+    const SignalDef* signals = message.signals.data();
+    uint32_t first = FirstSignal(tables, message);
+    DecodeMessage(message, data, length, [&](const SignalDef& signal, double value) {
+        values.emplace_back(first + static_cast<uint32_t>(&signal - signals), value);
+    });
+    return values;
+}
+
+bool Same(const Values& a, const Values& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        bool bothNan = std::isnan(a[i].second) && std::isnan(b[i].second);
+        if (a[i].first != b[i].first || (!bothNan && a[i].second != b[i].second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TEST("the generated plugin describes the database") {
+    Plugin& plugin = SharedPlugin();
+    CHECK(plugin.decoder != nullptr);
+    const ace_can_decoder& decoder = *plugin.decoder;
+    CHECK_EQ(decoder.abi_version, uint32_t{ACE_CAN_DECODER_ABI_VERSION});
+    CHECK_EQ(decoder.message_count, uint32_t{3});
+    CHECK_EQ(decoder.signal_count, uint32_t{13});
+    CHECK_EQ(std::string(decoder.messages[1].name), std::string("Status"));
+    CHECK_EQ(decoder.messages[1].first_signal, uint32_t{4});
+    CHECK_EQ(decoder.messages[1].signal_count, uint32_t{5});
+    CHECK_EQ(decoder.messages[2].id, uint32_t{0x18FF00FA});
+    CHECK_EQ(decoder.messages[2].extended, uint8_t{1});
+    CHECK_EQ(decoder.messages[2].fd, uint8_t{1});
+    CHECK_EQ(decoder.messages[2].length, uint16_t{24});
+    CHECK_EQ(std::string(decoder.signal_names[12]), std::string("Window"));
+
+    uint8_t data[8] = {};
+    Values values;
+    CHECK_EQ(decoder.decode(0x124, 0, data, 8, Collect, &values), -1);
+    CHECK_EQ(decoder.decode(0x123, 1, data, 8, Collect, &values), -1);
+    CHECK(values.empty());
+}
+
+TEST("generated decoding matches the runtime decoder") {
+    Plugin& plugin = SharedPlugin();
+    CHECK(plugin.decoder != nullptr);
+    std::mt19937 random(114);
+    for (const MessageDef& message : plugin.tables.messages) {
+        // Every payload length up to the message's, so partly present signals are covered too.
+        for (size_t length = 0; length <= message.length; ++length) {
+            for (int round = 0; round < 64; ++round) {
+                uint8_t data[64];
+                for (uint8_t& byte : data) {
+                    byte = static_cast<uint8_t>(random());
+                }
+                Values generated;
+                int32_t count = plugin.decoder->decode(message.id, message.extended ? 1 : 0, data,
+                                                       static_cast<uint32_t>(length), Collect, &generated);
+                CHECK_EQ(count, static_cast<int32_t>(generated.size()));
+                Values runtime = Runtime(plugin.tables, message, data, length);
+                if (!Same(generated, runtime)) {
+                    check::Fail(__FILE__, __LINE__, message.name + " differs at length " + std::to_string(length));
+                    return;
+                }
+            }
+        }
+    }
+}
+
+TEST("generated encoding matches the runtime encoder") {
+    Plugin& plugin = SharedPlugin();
+    CHECK(plugin.decoder != nullptr);
+    const MessageDef& engine = plugin.tables.messages[0];
+    const double values[] = {2500.0, -12.0, 55.5, -100.5};
+    uint8_t generated[8] = {};
+    CHECK_EQ(plugin.decoder->encode(0, values, generated, sizeof(generated)), int32_t{8});
+    uint8_t runtime[8] = {};
+    for (size_t i = 0; i < engine.signals.size(); ++i) {
+        InsertRaw(engine.signals[i], RawValue(engine.signals[i], values[i]), runtime, sizeof(runtime));
+    }
+    CHECK(std::memcmp(generated, runtime, sizeof(runtime)) == 0);
+
+    Values decoded;
+    CHECK_EQ(plugin.decoder->decode(0x123, 0, generated, 8, Collect, &decoded), int32_t{4});
+    for (size_t i = 0; i < 4; ++i) {
+        CHECK_EQ(decoded[i].second, values[i]);
+    }
+
+    // NaN leaves a signal's bits zero; floats round-trip through their IEEE bits.
+    const double body[] = {1.5, -2.25e100, NAN, 42.0};
+    uint8_t payload[24];
+    std::memset(payload, 0xFF, sizeof(payload));
+    CHECK_EQ(plugin.decoder->encode(2, body, payload, sizeof(payload)), int32_t{24});
+    decoded.clear();
+    CHECK_EQ(plugin.decoder->decode(0x18FF00FA, 1, payload, 24, Collect, &decoded), int32_t{4});
+    CHECK_EQ(decoded[0].second, 1.5);
+    CHECK_EQ(decoded[1].second, -2.25e100);
+    CHECK_EQ(decoded[2].second, 0.0);
+    CHECK(std::fabs(decoded[3].second - 42.0) < 1e-9);
+
+    CHECK_EQ(plugin.decoder->encode(2, body, payload, 8), int32_t{-1});
+    CHECK_EQ(plugin.decoder->encode(3, body, payload, sizeof(payload)), int32_t{-1});
+}
@@ -0,0 +1,152 @@
+#include "device_watcher.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+// A device that can be unplugged and plugged back in, recording what the watcher did to it.
+class Device {
+public:
+    DeviceWatcher::Hooks Hooks() {
+        DeviceWatcher::Hooks hooks;
+        hooks.probe = [this]() {
+            probes_++;
+            return present_.load();
+        };
+        hooks.detach = [this]() { Record("detach"); };
+        hooks.reattach = [this](int64_t downMs) {
+            attempts_++;
+            if (!present_) {
+                return false;
+            }
+            if (failures_ > 0) {
+                failures_--;
+                return false;
+            }
+            down_ms_ = downMs;
+            Record("attach");
+            return true;
+        };
+        return hooks;
+    }
+
+    void Unplug() { present_ = false; }
+    void Plug(int failures = 0) {
+        failures_ = failures;
+        present_ = true;
+    }
+
+    // Waits up to a second for `count` events.
+    std::vector<std::string> Events(size_t count) {
+        for (int i = 0; i < 200; ++i) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (events_.size() >= count) {
+                    return events_;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        return events_;
+    }
+
+    int probes() const { return probes_; }
+    int attempts() const { return attempts_; }
+    int64_t down_ms() const { return down_ms_; }
+
+private:
+    void Record(const char* event) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        events_.push_back(event);
+    }
+
+    std::atomic<bool> present_{true};
+    std::atomic<int> failures_{0}; // reopen attempts that fail after the device is back
+    std::atomic<int> probes_{0};
+    std::atomic<int> attempts_{0};
+    std::atomic<int64_t> down_ms_{-1};
+    std::mutex mutex_;
+    std::vector<std::string> events_;
+};
+
+void Sleep(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+} // namespace
+
+TEST("an unplugged device is detached and reattached when it returns") {
+    Device device;
+    DeviceWatcher watcher(device.Hooks());
+    CHECK(watcher.Start(5, true, true));
+    Sleep(30);
+    CHECK(device.Events(0).empty());
+    CHECK(device.probes() >= 2);
+
+    device.Unplug();
+    CHECK(device.Events(1) == std::vector<std::string>({"detach"}));
+    Sleep(40);
+    device.Plug(2); // enumerated again, but the first two opens fail
+    CHECK(device.Events(2) == std::vector<std::string>({"detach", "attach"}));
+    CHECK(device.down_ms() >= 40);
+    CHECK(device.down_ms() < 1000);
+    CHECK(device.attempts() >= 3);
+
+    // Probing resumes once reattached, until the watch ends.
+    int probes = device.probes();
+    Sleep(30);
+    CHECK(device.probes() > probes);
+    watcher.Stop();
+    probes = device.probes();
+    Sleep(20);
+    CHECK_EQ(device.probes(), probes);
+}
+
+TEST("without auto-reattach a detached device stays detached") {
+    Device device;
+    DeviceWatcher watcher(device.Hooks());
+    CHECK(watcher.Start(5, false, true));
+    device.Unplug();
+    CHECK(device.Events(1) == std::vector<std::string>({"detach"}));
+    device.Plug();
+    Sleep(40);
+    CHECK_EQ(device.attempts(), 0);
+    CHECK_EQ(device.Events(1).size(), size_t{1});
+}
+
+TEST("a watch started on a detached device reopens it without probing") {
+    Device device;
+    device.Unplug();
+    DeviceWatcher watcher(device.Hooks());
+    CHECK(watcher.Start(5, true, false));
+    Sleep(30);
+    CHECK(device.attempts() >= 2);
+    CHECK_EQ(device.probes(), 0);
+    device.Plug();
+    CHECK(device.Events(1) == std::vector<std::string>({"attach"}));
+    CHECK(device.down_ms() >= 30); // counted from the start of the watch
+}
+
+TEST("stop interrupts a long interval and a second start is refused") {
+    Device device;
+    DeviceWatcher watcher(device.Hooks());
+    CHECK(watcher.Start(60000, true, true));
+    CHECK(!watcher.Start(5, true, true));
+    auto begin = std::chrono::steady_clock::now();
+    watcher.Stop();
+    CHECK(std::chrono::steady_clock::now() - begin < std::chrono::milliseconds(500));
+    CHECK_EQ(device.probes(), 0);
+
+    // Restartable, with new settings.
+    CHECK(watcher.Start(5, true, true));
+    Sleep(30);
+    CHECK(device.probes() > 0);
+}
@@ -0,0 +1,119 @@
+#include "doip.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+std::vector<uint8_t> Message(uint8_t version, uint16_t type, const std::vector<uint8_t>& payload) {
+    std::vector<uint8_t> message = MakeDoipMessage(version, type, payload.size());
+    std::copy(payload.begin(), payload.end(), message.begin() + kDoipHeaderSize);
+    return message;
+}
+
+void Append(DoipReader& reader, const std::vector<uint8_t>& bytes) {
+    reader.Append(bytes.data(), bytes.size());
+}
+
+} // namespace
+
+TEST("messages carry the generic header") {
+    std::vector<uint8_t> message = MakeDoipMessage(0x02, kDoipDiagnosticMessage, 0x10203);
+    CHECK_EQ(message.size(), kDoipHeaderSize + 0x10203);
+    CHECK(std::vector<uint8_t>(message.begin(), message.begin() + kDoipHeaderSize) ==
+          std::vector<uint8_t>({0x02, 0xFD, 0x80, 0x01, 0x00, 0x01, 0x02, 0x03}));
+
+    uint8_t address[2];
+    WriteDoipU16(address, 0x0E80);
+    CHECK_EQ(address[0], uint8_t{0x0E});
+    CHECK_EQ(ReadDoipU16(address), uint16_t{0x0E80});
+}
+
+TEST("the reader splits a stream arriving in pieces") {
+    std::vector<uint8_t> stream = Message(0x02, kDoipRoutingActivationRequest, {0x0E, 0x80, 0x00, 0, 0, 0, 0});
+    std::vector<uint8_t> alive = Message(0x03, kDoipAliveCheckRequest, {});
+    std::vector<uint8_t> diagnostic = Message(0x02, kDoipDiagnosticMessage, {0x0E, 0x80, 0x00, 0x10, 0x22, 0xF1, 0x90});
+    stream.insert(stream.end(), alive.begin(), alive.end());
+    stream.insert(stream.end(), diagnostic.begin(), diagnostic.end());
+
+    DoipReader reader(64);
+    std::vector<DoipMessage> messages;
+    DoipMessage message;
+    uint8_t nack = 0xFF;
+    for (size_t i = 0; i < stream.size(); i += 3) {
+        reader.Append(&stream[i], std::min<size_t>(3, stream.size() - i));
+        int result;
+        while ((result = reader.Next(message, nack)) == 1) {
+            messages.push_back(message);
+        }
+        CHECK_EQ(result, 0);
+    }
+    CHECK_EQ(nack, uint8_t{0xFF});
+    CHECK_EQ(messages.size(), size_t{3});
+    CHECK_EQ(messages[0].type, kDoipRoutingActivationRequest);
+    CHECK_EQ(messages[0].payload.size(), size_t{7});
+    CHECK_EQ(messages[1].version, uint8_t{0x03});
+    CHECK_EQ(messages[1].type, kDoipAliveCheckRequest);
+    CHECK(messages[1].payload.empty());
+    CHECK_EQ(messages[2].type, kDoipDiagnosticMessage);
+    CHECK(messages[2].payload == std::vector<uint8_t>({0x0E, 0x80, 0x00, 0x10, 0x22, 0xF1, 0x90}));
+}
+
+TEST("the reader keeps up with a long stream of messages") {
+    DoipReader reader(16);
+    DoipMessage message;
+    uint8_t nack = 0;
+    for (int i = 0; i < 1000; ++i) {
+        std::vector<uint8_t> request = Message(0x02, kDoipDiagnosticMessage, {0x0E, 0x80, 0x00, 0x10, 0x3E, static_cast<uint8_t>(i)});
+        // Half a message at a time, so the buffer always holds a partial one when it is compacted.
+        reader.Append(request.data(), 7);
+        CHECK_EQ(reader.Next(message, nack), 0);
+        reader.Append(request.data() + 7, request.size() - 7);
+        CHECK_EQ(reader.Next(message, nack), 1);
+        CHECK_EQ(message.payload.back(), static_cast<uint8_t>(i));
+    }
+    CHECK_EQ(reader.Next(message, nack), 0);
+}
+
+TEST("header errors name the negative acknowledge to send") {
+    struct Case {
+        const char* name;
+        std::vector<uint8_t> bytes;
+        uint8_t nack;
+    };
+    std::vector<uint8_t> inverse = Message(0x02, kDoipAliveCheckResponse, {0x0E, 0x80});
+    inverse[1] = 0xFE;
+    std::vector<Case> cases = {
+        {"inverse version mismatch", inverse, kDoipIncorrectPattern},
+        {"unsupported version", Message(0x04, kDoipAliveCheckResponse, {0x0E, 0x80}), kDoipIncorrectPattern},
+        {"vehicle identification version over TCP", Message(0xFF, kDoipAliveCheckResponse, {0x0E, 0x80}),
+         kDoipIncorrectPattern},
+        // Refused from the header alone, before the payload arrives.
+        {"payload over the limit", MakeDoipMessage(0x02, kDoipDiagnosticMessage, 65), kDoipMessageTooLarge},
+        {"largest encodable length", {0x02, 0xFD, 0x80, 0x01, 0xFF, 0xFF, 0xFF, 0xFF}, kDoipMessageTooLarge},
+    };
+    for (const Case& c : cases) {
+        DoipReader reader(64);
+        std::vector<uint8_t> header(c.bytes.begin(), c.bytes.begin() + kDoipHeaderSize);
+        Append(reader, header);
+        DoipMessage message;
+        uint8_t nack = 0xFF;
+        if (reader.Next(message, nack) != -1 || nack != c.nack) {
+            check::Fail(__FILE__, __LINE__, std::string(c.name) + " was not refused with NACK " + check::Show(c.nack));
+        }
+    }
+
+    // A good message ahead of the bad header is still delivered.
+    DoipReader reader(64);
+    Append(reader, Message(0x02, kDoipAliveCheckResponse, {0x0E, 0x80}));
+    Append(reader, inverse);
+    DoipMessage message;
+    uint8_t nack = 0xFF;
+    CHECK_EQ(reader.Next(message, nack), 1);
+    CHECK_EQ(message.type, kDoipAliveCheckResponse);
+    CHECK_EQ(reader.Next(message, nack), -1);
+    CHECK_EQ(nack, kDoipIncorrectPattern);
+}
@@ -0,0 +1,110 @@
+#include "downsample.h"
+
+#include <cmath>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+struct Series {
+    std::vector<double> t;
+    std::vector<double> v;
+};
+
+// `n` samples 1 ms apart of a slow sine.
+Series Sine(size_t n) {
+    Series series;
+    for (size_t i = 0; i < n; ++i) {
+        series.t.push_back(1e6 + 1000.0 * static_cast<double>(i));
+        series.v.push_back(std::sin(static_cast<double>(i) / 50.0));
+    }
+    return series;
+}
+
+void CheckAscending(const std::vector<uint32_t>& picked, size_t n) {
+    for (size_t i = 0; i < picked.size(); ++i) {
+        if (picked[i] >= n || (i > 0 && picked[i] <= picked[i - 1])) {
+            check::Fail(__FILE__, __LINE__, "picked indices are not ascending at " + check::Show(i));
+            return;
+        }
+    }
+}
+
+bool Contains(const std::vector<uint32_t>& picked, uint32_t index) {
+    for (uint32_t i : picked) {
+        if (i == index) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+TEST("LTTB keeps the budget, both ends and the spikes") {
+    Series series = Sine(10000);
+    series.v[4321] = 50; // a spike far above the signal
+    series.v[7777] = -50;
+    std::vector<uint32_t> picked;
+    PickLttb(series.t.data(), series.v.data(), series.t.size(), 500, picked);
+    CHECK_EQ(picked.size(), size_t{500});
+    CheckAscending(picked, series.t.size());
+    CHECK_EQ(picked.front(), uint32_t{0});
+    CHECK_EQ(picked.back(), uint32_t{9999});
+    CHECK(Contains(picked, 4321));
+    CHECK(Contains(picked, 7777));
+}
+
+TEST("LTTB picks one sample per bucket at the smallest budget") {
+    std::vector<double> t = {0, 1, 2, 3};
+    std::vector<double> v = {0, 5, 1, 0};
+    std::vector<uint32_t> picked;
+    PickLttb(t.data(), v.data(), t.size(), 3, picked);
+    CHECK(picked == std::vector<uint32_t>({0, 1, 3}));
+
+    Series series = Sine(1001);
+    picked.clear();
+    PickLttb(series.t.data(), series.v.data(), series.t.size(), 1000, picked);
+    CHECK_EQ(picked.size(), size_t{1000});
+    CheckAscending(picked, series.t.size());
+}
+
+TEST("min/max keeps each bucket's extremes in time order") {
+    // Four 10 ms buckets; the maximum comes before the minimum in the second one.
+    std::vector<double> t;
+    std::vector<double> v;
+    for (int i = 0; i < 40; ++i) {
+        t.push_back(1000.0 * i);
+        v.push_back(0);
+    }
+    v[3] = -1;
+    v[7] = 2;
+    v[12] = 9;
+    v[18] = -9;
+    v[25] = 4;
+    std::vector<uint32_t> picked;
+    PickMinMax(t.data(), v.data(), t.size(), 8, picked);
+    CheckAscending(picked, t.size());
+    CHECK(picked == std::vector<uint32_t>({3, 7, 12, 18, 20, 25, 30}));
+}
+
+TEST("min/max stays within the budget and keeps spikes") {
+    Series series = Sine(100000);
+    series.v[54321] = 1000;
+    series.v[54322] = -1000;
+    std::vector<uint32_t> picked;
+    PickMinMax(series.t.data(), series.v.data(), series.t.size(), 501, picked);
+    CHECK(picked.size() <= size_t{501});
+    CHECK(picked.size() >= size_t{400});
+    CheckAscending(picked, series.t.size());
+    CHECK(Contains(picked, 54321));
+    CHECK(Contains(picked, 54322));
+
+    // Samples sharing one timestamp form a single bucket.
+    std::vector<double> t(10, 5.0);
+    std::vector<double> v = {3, 1, 4, 1, 5, 9, 2, 6, 5, 3};
+    picked.clear();
+    PickMinMax(t.data(), v.data(), t.size(), 4, picked);
+    CHECK(picked == std::vector<uint32_t>({1, 5}));
+}
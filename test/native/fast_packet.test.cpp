@@ -0,0 +1,222 @@
+#include "fast_packet.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+uint32_t Id(uint32_t pgn, uint8_t source, uint8_t priority = 3) {
+    return static_cast<uint32_t>(priority) << 26 | pgn << 8 | source;
+}
+
+CanFrame Frame(uint32_t id, const std::vector<uint8_t>& data, uint64_t timestamp = 0) {
+    CanFrame frame = {};
+    frame.timestamp = timestamp;
+    frame.id = id;
+    frame.flags = kFrameFlagExtended;
+    frame.length = static_cast<uint8_t>(data.size());
+    std::memcpy(frame.data, data.data(), data.size());
+    return frame;
+}
+
+// Splits `payload` into the frames of one fast-packet transfer, padded with 0xFF.
+std::vector<CanFrame> FastPacket(uint32_t id, uint8_t sequence, const std::vector<uint8_t>& payload) {
+    std::vector<CanFrame> frames;
+    size_t offset = 0;
+    for (uint8_t index = 0; index == 0 || offset < payload.size(); ++index) {
+        std::vector<uint8_t> data(8, 0xFF);
+        data[0] = static_cast<uint8_t>(sequence << 5 | index);
+        size_t at = 1;
+        if (index == 0) {
+            data[1] = static_cast<uint8_t>(payload.size());
+            at = 2;
+        }
+        for (; at < 8 && offset < payload.size(); ++at) {
+            data[at] = payload[offset++];
+        }
+        frames.push_back(Frame(id, data, 1000 + index));
+    }
+    return frames;
+}
+
+std::vector<uint8_t> Payload(size_t length, uint8_t seed) {
+    std::vector<uint8_t> payload(length);
+    for (size_t i = 0; i < length; ++i) {
+        payload[i] = static_cast<uint8_t>(seed + i);
+    }
+    return payload;
+}
+
+bool Same(const Nmea2000Pgn& pgn, const std::vector<uint8_t>& payload) {
+    return pgn.length == payload.size() && std::equal(payload.begin(), payload.end(), pgn.data);
+}
+
+} // namespace
+
+TEST("single-frame PGNs pass straight through") {
+    FastPacketAssembler assembler;
+    Nmea2000Pgn pgn;
+    // PDU2 (PF >= 240): the PS byte is part of the PGN, the destination is global.
+    CHECK(assembler.Push(Frame(Id(127250, 0x23, 2), {1, 2, 3, 4, 5, 6, 7, 8}, 77), 0, pgn));
+    CHECK_EQ(pgn.pgn, uint32_t{127250});
+    CHECK_EQ(pgn.source, uint8_t{0x23});
+    CHECK_EQ(pgn.destination, uint8_t{0xFF});
+    CHECK_EQ(pgn.priority, uint8_t{2});
+    CHECK_EQ(pgn.timestamp, uint64_t{77});
+    CHECK(Same(pgn, {1, 2, 3, 4, 5, 6, 7, 8}));
+
+    // PDU1 (PF < 240): the PS byte is the destination address.
+    CHECK(assembler.Push(Frame(Id(59904 | 0x42, 0x01, 6), {0x00, 0xEE, 0x00}), 0, pgn));
+    CHECK_EQ(pgn.pgn, uint32_t{59904});
+    CHECK_EQ(pgn.destination, uint8_t{0x42});
+    CHECK_EQ(pgn.priority, uint8_t{6});
+    CHECK_EQ(pgn.length, uint8_t{3});
+
+    // Standard and remote frames are not NMEA 2000.
+    CanFrame standard = Frame(0x123, {1});
+    standard.flags = 0;
+    CHECK(!assembler.Push(standard, 0, pgn));
+    CanFrame remote = Frame(Id(127250, 1), {});
+    remote.flags |= kFrameFlagRemote;
+    CHECK(!assembler.Push(remote, 0, pgn));
+    CHECK_EQ(assembler.GetStats().frames, uint64_t{2});
+    CHECK_EQ(assembler.GetStats().pgns, uint64_t{2});
+    CHECK_EQ(assembler.GetStats().fast_packets, uint64_t{0});
+}
+
+TEST("fast packets reassemble in order and out of order") {
+    FastPacketAssembler assembler;
+    std::vector<uint8_t> payload = Payload(43, 0x10); // GNSS position, 7 frames
+    std::vector<CanFrame> frames = FastPacket(Id(129029, 0x05), 2, payload);
+    CHECK_EQ(frames.size(), size_t{7});
+
+    Nmea2000Pgn pgn;
+    for (size_t i = 0; i + 1 < frames.size(); ++i) {
+        CHECK(!assembler.Push(frames[i], 0, pgn));
+    }
+    CHECK_EQ(assembler.InFlight(), size_t{1});
+    CHECK(assembler.Push(frames.back(), 0, pgn));
+    CHECK_EQ(pgn.pgn, uint32_t{129029});
+    CHECK_EQ(pgn.source, uint8_t{0x05});
+    CHECK_EQ(pgn.timestamp, frames.back().timestamp);
+    CHECK(Same(pgn, payload));
+    CHECK_EQ(assembler.InFlight(), size_t{0});
+
+    // Frame 0, which carries the length, arriving last.
+    std::reverse(frames.begin(), frames.end());
+    for (size_t i = 0; i + 1 < frames.size(); ++i) {
+        CHECK(!assembler.Push(frames[i], 0, pgn));
+    }
+    CHECK(assembler.Push(frames.back(), 0, pgn));
+    CHECK(Same(pgn, payload));
+    CHECK_EQ(assembler.GetStats().fast_packets, uint64_t{2});
+}
+
+TEST("transfers from several sources and sequences interleave") {
+    FastPacketAssembler assembler;
+    std::vector<uint8_t> a = Payload(20, 0x00);
+    std::vector<uint8_t> b = Payload(27, 0x80);
+    std::vector<uint8_t> c = Payload(9, 0x40);
+    std::vector<CanFrame> fa = FastPacket(Id(129029, 0x10), 1, a);
+    std::vector<CanFrame> fb = FastPacket(Id(129029, 0x11), 1, b);
+    std::vector<CanFrame> fc = FastPacket(Id(129029, 0x10), 2, c); // same source, next sequence
+
+    std::vector<Nmea2000Pgn> done;
+    for (size_t i = 0; i < 4; ++i) {
+        for (const std::vector<CanFrame>* frames : {&fa, &fb, &fc}) {
+            Nmea2000Pgn pgn;
+            if (i < frames->size() && assembler.Push((*frames)[i], 0, pgn)) {
+                done.push_back(pgn);
+            }
+        }
+    }
+    CHECK_EQ(done.size(), size_t{3});
+    CHECK(Same(done[0], c)); // 2 frames
+    CHECK(Same(done[1], a)); // 3 frames
+    CHECK(Same(done[2], b)); // 4 frames
+    CHECK_EQ(done[2].source, uint8_t{0x11});
+}
+
+TEST("incomplete transfers time out") {
+    FastPacketAssembler assembler(1000);
+    std::vector<CanFrame> frames = FastPacket(Id(129029, 0x05), 0, Payload(20, 0));
+    Nmea2000Pgn pgn;
+    CHECK(!assembler.Push(frames[0], 0, pgn));
+    CHECK(!assembler.Push(frames[1], 500, pgn));
+    // Any frame past the timeout sweeps the stale transfer; its last frame then starts a new one.
+    CHECK(!assembler.Push(frames[2], 5000, pgn));
+    CHECK_EQ(assembler.GetStats().timeouts, uint64_t{1});
+    CHECK_EQ(assembler.InFlight(), size_t{1});
+    CHECK_EQ(assembler.GetStats().pgns, uint64_t{0});
+}
+
+TEST("a repeated frame restarts the transfer") {
+    FastPacketAssembler assembler;
+    std::vector<CanFrame> stale = FastPacket(Id(129029, 0x05), 3, Payload(20, 0));
+    std::vector<uint8_t> payload = Payload(20, 0x50);
+    std::vector<CanFrame> fresh = FastPacket(Id(129029, 0x05), 3, payload);
+    Nmea2000Pgn pgn;
+    CHECK(!assembler.Push(stale[0], 0, pgn));
+    CHECK(!assembler.Push(stale[1], 0, pgn));
+    // The sender wrapped its sequence counter: frame 0 again belongs to a new transfer.
+    for (size_t i = 0; i + 1 < fresh.size(); ++i) {
+        CHECK(!assembler.Push(fresh[i], 0, pgn));
+    }
+    CHECK(assembler.Push(fresh.back(), 0, pgn));
+    CHECK(Same(pgn, payload));
+    CHECK_EQ(assembler.GetStats().errors, uint64_t{1});
+}
+
+TEST("inconsistent frames are rejected") {
+    FastPacketAssembler assembler;
+    Nmea2000Pgn pgn;
+    // Declared length beyond 223 bytes.
+    CHECK(!assembler.Push(Frame(Id(129029, 1), {0x00, 224, 0, 0, 0, 0, 0, 0}), 0, pgn));
+    // A frame index past the declared length.
+    CHECK(!assembler.Push(Frame(Id(129029, 2), {0x20, 8, 0, 0, 0, 0, 0, 0}), 0, pgn));
+    CHECK(!assembler.Push(Frame(Id(129029, 2), {0x25, 0, 0, 0, 0, 0, 0, 0}), 0, pgn));
+    // Too short to carry the frame counter.
+    CHECK(!assembler.Push(Frame(Id(129029, 3), {0x00}), 0, pgn));
+    CHECK_EQ(assembler.GetStats().errors, uint64_t{3});
+    CHECK_EQ(assembler.InFlight(), size_t{0});
+}
+
+TEST("the longest transfer fills all 32 frames") {
+    FastPacketAssembler assembler;
+    std::vector<uint8_t> payload = Payload(Nmea2000Pgn::kMaxLength, 1);
+    std::vector<CanFrame> frames = FastPacket(Id(126996, 9), 5, payload);
+    CHECK_EQ(frames.size(), size_t{32});
+    Nmea2000Pgn pgn;
+    for (size_t i = 0; i + 1 < frames.size(); ++i) {
+        CHECK(!assembler.Push(frames[i], 0, pgn));
+    }
+    CHECK(assembler.Push(frames.back(), 0, pgn));
+    CHECK(Same(pgn, payload));
+}
+
+TEST("the fast-packet list can be extended") {
+    FastPacketAssembler assembler;
+    CHECK(assembler.IsFastPacket(129029));
+    CHECK(assembler.IsFastPacket(130816));
+    CHECK(assembler.IsFastPacket(131071));
+    CHECK(!assembler.IsFastPacket(127250));
+    CHECK(!assembler.IsFastPacket(65280));
+
+    assembler.AddFastPacketPgns({65280, 65281, 127250});
+    CHECK(assembler.IsFastPacket(65280));
+    CHECK(assembler.IsFastPacket(65281));
+    CHECK(!assembler.IsFastPacket(65282));
+    CHECK(assembler.IsFastPacket(127250));
+    CHECK(assembler.IsFastPacket(129029));
+
+    std::vector<uint8_t> payload = Payload(12, 0x33);
+    std::vector<CanFrame> frames = FastPacket(Id(65280, 0x40), 0, payload);
+    Nmea2000Pgn pgn;
+    CHECK(!assembler.Push(frames[0], 0, pgn));
+    CHECK(assembler.Push(frames[1], 0, pgn));
+    CHECK_EQ(pgn.pgn, uint32_t{65280});
+    CHECK(Same(pgn, payload));
+}
@@ -0,0 +1,172 @@
+#include "filter_program.h"
+
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+CanFrame Frame(uint32_t id, std::vector<uint8_t> data, uint8_t flags = 0) {
+    CanFrame frame = {};
+    frame.id = id;
+    frame.flags = flags;
+    frame.length = static_cast<uint8_t>(data.size());
+    std::memcpy(frame.data, data.data(), data.size());
+    return frame;
+}
+
+bool Matches(const std::string& source, const CanFrame& frame) {
+    FilterProgram program;
+    if (!FilterProgram::Compile(source, program).empty()) {
+        return false;
+    }
+    return program.Matches(frame);
+}
+
+std::string CompileError(const std::string& source) {
+    FilterProgram program;
+    return FilterProgram::Compile(source, program);
+}
+
+} // namespace
+
+TEST("the documented rule selects on id range, payload bit and dlc") {
+    FilterProgram program;
+    CHECK_EQ(FilterProgram::Compile("id in 0x100..0x1FF && data[2] & 0x08 && dlc == 8", program), std::string());
+    CHECK_EQ(program.Source(), std::string("id in 0x100..0x1FF && data[2] & 0x08 && dlc == 8"));
+    CHECK(program.Matches(Frame(0x100, {0, 0, 0x08, 0, 0, 0, 0, 0})));
+    CHECK(program.Matches(Frame(0x1FF, {0, 0, 0xFF, 0, 0, 0, 0, 0})));
+    CHECK(!program.Matches(Frame(0x200, {0, 0, 0x08, 0, 0, 0, 0, 0})));
+    CHECK(!program.Matches(Frame(0x0FF, {0, 0, 0x08, 0, 0, 0, 0, 0})));
+    CHECK(!program.Matches(Frame(0x150, {0, 0, 0x07, 0, 0, 0, 0, 0})));
+    CHECK(!program.Matches(Frame(0x150, {0, 0, 0x08, 0, 0, 0, 0})));
+    // Reads past the payload are 0.
+    CHECK(!program.Matches(Frame(0x150, {0, 0})));
+}
+
+TEST("fields, loads and sets evaluate against the frame") {
+    CanFrame fd = Frame(0x18FF00FA, std::vector<uint8_t>(12, 0), kFrameFlagExtended | kFrameFlagFd | kFrameFlagBrs);
+    fd.data[0] = 0x34;
+    fd.data[1] = 0x12;
+    fd.data[4] = 0xDE;
+    fd.data[5] = 0xAD;
+    fd.data[6] = 0xBE;
+    fd.data[7] = 0xEF;
+    fd.data[11] = 0xAA;
+    fd.channel = 3;
+    fd.timestamp = 5000000;
+    CHECK(Matches("ext && fd && brs && !esi && !rtr && !err && !tx", fd));
+    CHECK(Matches("dlc == 9 && len == 12 && length == 12", fd));
+    CHECK(Matches("channel == 3 && timestamp >= 5000000", fd));
+    CHECK(Matches("flags == 0x0D", fd));
+    CHECK(Matches("le16(0) == 0x1234 && be16(0) == 0x3412", fd));
+    CHECK(Matches("be32(4) == 0xDEADBEEF && le32(4) == 0xEFBEADDE", fd));
+    CHECK(Matches("data[11] == 0xAA && be16(11) == 0", fd)); // a load past the payload reads 0
+    CHECK(Matches("id in [0x100, 0x18FF0000..0x18FFFFFF, 0x7FF]", fd));
+    CHECK(!Matches("id in [0x100, 0x200..0x2FF]", fd));
+    CHECK(Matches("id >> 8 & 0xFF == 0", fd)); // & binds tighter than ==
+    CHECK(Matches("(id >> 16 & 0xFF) == 0xFF && (id & 0xFF) == 0xFA", fd));
+
+    CanFrame remote = Frame(0x7DF, {}, kFrameFlagRemote);
+    CHECK(Matches("remote && id == 0x7DF && len == 0 && !ext", remote));
+    CHECK(Matches("data[0] == 0 && le32(0) == 0", remote));
+}
+
+TEST("arithmetic, precedence and literals") {
+    CanFrame frame = Frame(0x123, {0x80, 0x01});
+    CHECK(Matches("data[0] + data[1] == 0x81", frame));
+    CHECK(Matches("data[0] - data[1] == 127", frame));
+    CHECK(Matches("data[1] - data[0] == -127", frame)); // 64-bit wrap-around
+    CHECK(Matches("(data[0] | data[1]) == 0x81 && (data[0] ^ 0xFF) == 0x7F", frame));
+    CHECK(Matches("~data[0] & 0xFF == 0x7F", frame));
+    CHECK(Matches("data[0] >> 7 == 1 && data[1] << 4 == 0x10", frame));
+    CHECK(Matches("id == 291 && id == 0b100100011 && id == 0X123", frame));
+    CHECK(Matches("false || id != 0x124 && true", frame));
+    CHECK(!Matches("false && id == 0x123 || false", frame));
+    CHECK(Matches("!(id < 0x100) && id <= 0x123 && id > 0x122", frame));
+    CHECK(Matches("data[1]", frame)); // non-zero is true
+    CHECK(!Matches("data[5]", frame));
+}
+
+TEST("constant subexpressions are folded") {
+    FilterProgram folded;
+    CHECK_EQ(FilterProgram::Compile("id == (0x100 | 0x23) + (1 << 4) - 16", folded), std::string());
+    FilterProgram plain;
+    CHECK_EQ(FilterProgram::Compile("id == 0x123", plain), std::string());
+    CHECK_EQ(folded.Size(), plain.Size());
+    CHECK(folded.Matches(Frame(0x123, {})));
+
+    FilterProgram constant;
+    CHECK_EQ(FilterProgram::Compile("!(1 - 1)", constant), std::string());
+    CHECK(constant.Matches(Frame(0, {})));
+}
+
+TEST("compiled programs agree with the equivalent C++ predicate") {
+    struct Rule {
+        const char* source;
+        std::function<bool(const CanFrame&)> expected;
+    };
+    const std::vector<Rule> rules = {
+        {"id in 0x100..0x1FF && data[2] & 0x08 && dlc == 8",
+         [](const CanFrame& f) { return f.id >= 0x100 && f.id <= 0x1FF && f.length > 2 && (f.data[2] & 0x08) && f.length == 8; }},
+        {"data[0] == 0x10 || data[1] > 0xF0 && !ext",
+         [](const CanFrame& f) {
+             auto byte = [&](int i) { return i < f.length ? f.data[i] : 0; };
+             return byte(0) == 0x10 || (byte(1) > 0xF0 && !(f.flags & kFrameFlagExtended));
+         }},
+        {"(le16(2) ^ be16(4)) & 0x8001 != 0 && id & 1",
+         [](const CanFrame& f) {
+             uint64_t le = f.length >= 4 ? f.data[2] | f.data[3] << 8 : 0;
+             uint64_t be = f.length >= 6 ? f.data[4] << 8 | f.data[5] : 0;
+             return ((le ^ be) & 0x8001) != 0 && (f.id & 1) != 0;
+         }},
+        {"id in [1..3, 0x10, 0x20..0x2F] || len >= 7 && data[6] == data[0]",
+         [](const CanFrame& f) {
+             bool in = (f.id >= 1 && f.id <= 3) || f.id == 0x10 || (f.id >= 0x20 && f.id <= 0x2F);
+             return in || (f.length >= 7 && f.data[6] == f.data[0]);
+         }},
+    };
+    std::mt19937 random(116);
+    for (const Rule& rule : rules) {
+        FilterProgram program;
+        CHECK_EQ(FilterProgram::Compile(rule.source, program), std::string());
+        for (int i = 0; i < 5000; ++i) {
+            CanFrame frame = {};
+            frame.id = random() % 0x300;
+            frame.flags = (random() % 4 == 0) ? kFrameFlagExtended : 0;
+            frame.length = static_cast<uint8_t>(random() % 9);
+            for (uint8_t j = 0; j < frame.length; ++j) {
+                frame.data[j] = static_cast<uint8_t>(random() % 4 == 0 ? 0x10 : random());
+            }
+            if (program.Matches(frame) != rule.expected(frame)) {
+                check::Fail(__FILE__, __LINE__, std::string(rule.source) + " differs for id " + std::to_string(frame.id));
+                return;
+            }
+        }
+    }
+}
+
+TEST("errors name the problem and its column") {
+    CHECK_EQ(CompileError(""), std::string("Empty filter expression"));
+    CHECK_EQ(CompileError("id == "), std::string("Filter expression: unexpected 'end of expression' at column 7"));
+    CHECK_EQ(CompileError("id == 0x1G"), std::string("Filter expression: invalid number at column 7"));
+    CHECK_EQ(CompileError("id = 5"), std::string("Filter expression: unexpected character '=' at column 4"));
+    CHECK_EQ(CompileError("speed > 3"), std::string("Filter expression: unknown name 'speed' at column 1"));
+    CHECK_EQ(CompileError("data[id] == 1"), std::string("Filter expression: byte offset must be a constant from 0 to 63 at column 6"));
+    CHECK_EQ(CompileError("data[64]"), std::string("Filter expression: byte offset must be a constant from 0 to 63 at column 6"));
+    CHECK_EQ(CompileError("id in 1..len"), std::string("Filter expression: range bounds must be constant at column 7"));
+    CHECK_EQ(CompileError("(id == 1"), std::string("Filter expression: expected ')' before 'end of expression' at column 9"));
+    CHECK_EQ(CompileError("id == 1 2"), std::string("Filter expression: unexpected '2' at column 9"));
+    CHECK_EQ(CompileError("99999999999999999999"), std::string("Filter expression: invalid number at column 1"));
+
+    std::string deep;
+    for (int i = 0; i < 20; ++i) {
+        deep += "data[" + std::to_string(i) + "] + (";
+    }
+    deep += "id" + std::string(20, ')');
+    CHECK(CompileError(deep).find("nested too deeply") != std::string::npos);
+}
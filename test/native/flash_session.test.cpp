@@ -0,0 +1,320 @@
+#include "flash_session.h"
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "loopback_bus.h"
+
+namespace {
+
+constexpr uint32_t kTesterId = 0x7E0;
+constexpr uint32_t kEcuId = 0x7E8;
+
+// A flash bootloader behind one ISO-TP address pair on a LoopbackBus: reassembles requests, answers
+// them with single frames and keeps what TransferData wrote. Runs on the scheduler thread.
+class Bootloader {
+public:
+    Bootloader(LoopbackBus& bus, uint32_t requestId, uint32_t responseId)
+        : bus_(bus), request_id_(requestId), response_id_(responseId) {}
+
+    void OnFrame(const CanFrame& frame) {
+        if (frame.id != request_id_) {
+            return;
+        }
+        uint8_t type = frame.data[0] >> 4;
+        if (type == 0) {
+            Handle(std::vector<uint8_t>(frame.data + 1, frame.data + 1 + (frame.data[0] & 0x0F)));
+        } else if (type == 1) {
+            expected_ = static_cast<size_t>(frame.data[0] & 0x0F) << 8 | frame.data[1];
+            segmented_.assign(frame.data + 2, frame.data + 8);
+            bus_.Inject(Frame(response_id_, {0x30, 0x00, 0x00}));
+        } else if (type == 2) {
+            segmented_.insert(segmented_.end(), frame.data + 1, frame.data + 8);
+            if (segmented_.size() >= expected_) {
+                segmented_.resize(expected_);
+                Handle(segmented_);
+            }
+        }
+    }
+
+    // Answers `request` itself when it returns true; an empty response stays silent.
+    std::function<bool(const std::vector<uint8_t>& request, std::vector<uint8_t>& response)> fault;
+    uint16_t max_block = 0x0102; // maxNumberOfBlockLength announced in the RequestDownload answer
+
+    std::vector<uint8_t> services; // the SID of every complete request, in order
+    uint32_t address = 0;
+    uint32_t length = 0;
+    std::vector<uint8_t> memory;
+
+private:
+    void Handle(const std::vector<uint8_t>& request) {
+        services.push_back(request[0]);
+        std::vector<uint8_t> response;
+        if (!fault || !fault(request, response)) {
+            response = Answer(request);
+        }
+        if (!response.empty()) {
+            response.insert(response.begin(), static_cast<uint8_t>(response.size()));
+            bus_.Inject(Frame(response_id_, response));
+        }
+    }
+
+    std::vector<uint8_t> Answer(const std::vector<uint8_t>& request) {
+        switch (request[0]) {
+            case 0x34:
+                address = Read32(request, 3);
+                length = Read32(request, 7);
+                sequence_ = 1;
+                return {0x74, 0x20, static_cast<uint8_t>(max_block >> 8), static_cast<uint8_t>(max_block)};
+            case 0x36:
+                if (request[1] != sequence_) {
+                    return {0x7F, 0x36, 0x73}; // wrongBlockSequenceCounter
+                }
+                sequence_++;
+                memory.insert(memory.end(), request.begin() + 2, request.end());
+                return {0x76, request[1]};
+            default:
+                return {static_cast<uint8_t>(request[0] + 0x40), request.size() > 1 ? request[1] : uint8_t{0}};
+        }
+    }
+
+    static uint32_t Read32(const std::vector<uint8_t>& bytes, size_t at) {
+        return static_cast<uint32_t>(bytes[at]) << 24 | bytes[at + 1] << 16 | bytes[at + 2] << 8 | bytes[at + 3];
+    }
+
+    LoopbackBus& bus_;
+    uint32_t request_id_;
+    uint32_t response_id_;
+    std::vector<uint8_t> segmented_;
+    size_t expected_ = 0;
+    uint8_t sequence_ = 1;
+};
+
+// Writes a counting pattern to `path` and maps it.
+std::shared_ptr<MappedFile> Image(const char* path, size_t size) {
+    std::vector<uint8_t> bytes(size);
+    for (size_t i = 0; i < size; ++i) {
+        bytes[i] = static_cast<uint8_t>(i * 7 + i / 251);
+    }
+    std::FILE* file = std::fopen(path, "wb");
+    std::fwrite(bytes.data(), 1, bytes.size(), file);
+    std::fclose(file);
+    auto image = std::make_shared<MappedFile>();
+    return image->Open(path).empty() ? image : nullptr;
+}
+
+FlashTarget Target(SessionScheduler& scheduler, std::shared_ptr<MappedFile> image, uint32_t txId = kTesterId,
+                   uint32_t rxId = kEcuId) {
+    FlashTarget target;
+    target.scheduler = &scheduler;
+    target.tx_id = txId;
+    target.rx_id = rxId;
+    target.address = 0x00080000;
+    target.length = image->Size();
+    target.image = std::move(image);
+    return target;
+}
+
+std::vector<uint8_t> Slice(const FlashTarget& target) {
+    const uint8_t* data = target.image->Data() + target.offset;
+    return std::vector<uint8_t>(data, data + target.length);
+}
+
+SessionTask FlashSession(UdsTiming timing, size_t maxBlock, FlashTarget* target, std::vector<size_t>* blocks,
+                         std::promise<std::string>* done) {
+    done->set_value(co_await FlashDownload(IsoTpConfig(), timing, maxBlock, *target,
+                                           [blocks](size_t size) { blocks->push_back(size); }));
+}
+
+std::future<std::string> Spawn(FlashTarget& target, size_t maxBlock, std::vector<size_t>& blocks,
+                               std::promise<std::string>& done, UdsTiming timing = UdsTiming()) {
+    FlashTarget* slot = &target;
+    std::vector<size_t>* sizes = &blocks;
+    std::promise<std::string>* result = &done;
+    target.scheduler->Spawn([timing, maxBlock, slot, sizes, result]() {
+        return FlashSession(timing, maxBlock, slot, sizes, result);
+    });
+    return done.get_future();
+}
+
+std::string Flash(FlashTarget& target, size_t maxBlock, std::vector<size_t>& blocks,
+                  UdsTiming timing = UdsTiming()) {
+    std::promise<std::string> done;
+    std::future<std::string> result = Spawn(target, maxBlock, blocks, done, timing);
+    if (result.wait_for(std::chrono::seconds(10)) != std::future_status::ready) {
+        return "test: no result";
+    }
+    return result.get();
+}
+
+} // namespace
+
+TEST("an image is prepared, downloaded in ECU-sized blocks and finished") {
+    LoopbackBus bus;
+    Bootloader ecu(bus, kTesterId, kEcuId);
+    bus.respond = [&](const CanFrame& frame) { ecu.OnFrame(frame); };
+    SessionScheduler scheduler(&bus);
+    scheduler.Start();
+
+    FlashTarget target = Target(scheduler, Image("app.bin", 2000));
+    target.offset = 100;
+    target.length = 1500;
+    target.prepare = {{0x10, 0x02}};
+    target.finish = {{0x31, 0x01, 0xFF, 0x00}, {0x11, 0x01}};
+    std::vector<size_t> blocks;
+    std::string error = Flash(target, 4095, blocks);
+    scheduler.Stop();
+
+    CHECK_EQ(error, std::string());
+    CHECK_EQ(target.step, std::string());
+    CHECK_EQ(target.sent, uint64_t{1500});
+    CHECK_EQ(ecu.address, uint32_t{0x00080000});
+    CHECK_EQ(ecu.length, uint32_t{1500});
+    CHECK(ecu.memory == Slice(target));
+    // 0x102 bytes per block less SID and counter.
+    CHECK(blocks == std::vector<size_t>({256, 256, 256, 256, 256, 220}));
+    CHECK(ecu.services == std::vector<uint8_t>({0x10, 0x34, 0x36, 0x36, 0x36, 0x36, 0x36, 0x36, 0x37, 0x31, 0x11}));
+}
+
+TEST("the caller's block limit caps the ECU's and the counter wraps") {
+    LoopbackBus bus;
+    Bootloader ecu(bus, kTesterId, kEcuId);
+    ecu.max_block = 0x0FFF;
+    bus.respond = [&](const CanFrame& frame) { ecu.OnFrame(frame); };
+    SessionScheduler scheduler(&bus);
+    scheduler.Start();
+
+    FlashTarget target = Target(scheduler, Image("wrap.bin", 5 * 300));
+    std::vector<size_t> blocks;
+    std::string error = Flash(target, 7, blocks); // one single frame per TransferData
+    scheduler.Stop();
+
+    CHECK_EQ(error, std::string());
+    CHECK_EQ(blocks.size(), size_t{300}); // block 256 goes out with counter 0x00
+    CHECK_EQ(blocks.back(), size_t{5});
+    CHECK(ecu.memory == Slice(target));
+}
+
+TEST("failures name the step and the reason") {
+    struct Case {
+        const char* name;
+        std::function<bool(const std::vector<uint8_t>&, std::vector<uint8_t>&)> fault;
+        uint16_t max_block;
+        const char* error;
+        const char* step;
+    };
+    const std::vector<Case> cases = {
+        {"prepare rejected",
+         [](const std::vector<uint8_t>& request, std::vector<uint8_t>& response) {
+             response = {0x7F, request[0], 0x22};
+             return request[0] == 0x10;
+         },
+         0x0102, "service 0x10 rejected with NRC 0x22", "prepare"},
+        {"download without block length",
+         [](const std::vector<uint8_t>& request, std::vector<uint8_t>& response) {
+             response = {0x74, 0x00};
+             return request[0] == 0x34;
+         },
+         0x0102, "RequestDownload response without maxNumberOfBlockLength", "requestDownload"},
+        {"block length too small", nullptr, 0x0002, "ECU maxNumberOfBlockLength too small", "requestDownload"},
+        {"wrong counter echoed",
+         [](const std::vector<uint8_t>& request, std::vector<uint8_t>& response) {
+             response = {0x76, static_cast<uint8_t>(request[1] + 1)};
+             return request[0] == 0x36;
+         },
+         0x0102, "TransferData answered with the wrong block sequence counter", "transferData"},
+        {"exit rejected",
+         [](const std::vector<uint8_t>& request, std::vector<uint8_t>& response) {
+             response = {0x7F, 0x37, 0x24};
+             return request[0] == 0x37;
+         },
+         0x0102, "service 0x37 rejected with NRC 0x24", "requestTransferExit"},
+        {"finish not answered",
+         [](const std::vector<uint8_t>& request, std::vector<uint8_t>& response) {
+             response.clear();
+             return request[0] == 0x11;
+         },
+         0x0102, "ISO-TP response timeout", "finish"},
+    };
+    std::shared_ptr<MappedFile> image = Image("fail.bin", 600);
+    for (const Case& c : cases) {
+        LoopbackBus bus;
+        Bootloader ecu(bus, kTesterId, kEcuId);
+        ecu.fault = c.fault;
+        ecu.max_block = c.max_block;
+        bus.respond = [&](const CanFrame& frame) { ecu.OnFrame(frame); };
+        SessionScheduler scheduler(&bus);
+        scheduler.Start();
+        FlashTarget target = Target(scheduler, image);
+        target.prepare = {{0x10, 0x02}};
+        target.finish = {{0x11, 0x01}};
+        UdsTiming timing;
+        timing.p2_us = 20000;
+        std::vector<size_t> blocks;
+        std::string error = Flash(target, 4095, blocks, timing);
+        scheduler.Stop();
+        if (error != c.error || target.step != c.step) {
+            check::Fail(__FILE__, __LINE__, std::string(c.name) + ": " + error + " at " + target.step);
+        }
+    }
+}
+
+TEST("targets on one bus and on several buses download side by side") {
+    std::shared_ptr<MappedFile> image = Image("fleet.bin", 3000);
+    LoopbackBus first;
+    LoopbackBus second;
+    std::vector<std::unique_ptr<Bootloader>> ecus;
+    ecus.push_back(std::make_unique<Bootloader>(first, 0x7E0, 0x7E8));
+    ecus.push_back(std::make_unique<Bootloader>(first, 0x7E1, 0x7E9));
+    ecus.push_back(std::make_unique<Bootloader>(second, 0x7E0, 0x7E8));
+    first.respond = [&](const CanFrame& frame) {
+        ecus[0]->OnFrame(frame);
+        ecus[1]->OnFrame(frame);
+    };
+    second.respond = [&](const CanFrame& frame) { ecus[2]->OnFrame(frame); };
+    SessionScheduler one(&first);
+    SessionScheduler two(&second);
+    one.Start();
+    two.Start();
+
+    std::vector<FlashTarget> targets = {Target(one, image, 0x7E0, 0x7E8), Target(one, image, 0x7E1, 0x7E9),
+                                        Target(two, image, 0x7E0, 0x7E8)};
+    targets[1].offset = 1000;
+    targets[1].length = 2000;
+    std::vector<std::vector<size_t>> blocks(targets.size());
+    std::vector<std::promise<std::string>> done(targets.size());
+    std::vector<std::future<std::string>> results;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        results.push_back(Spawn(targets[i], 4095, blocks[i], done[i]));
+    }
+    bool all = true;
+    for (std::future<std::string>& result : results) {
+        all = all && result.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+    }
+    one.Stop();
+    two.Stop();
+    CHECK(all);
+    for (size_t i = 0; i < targets.size(); ++i) {
+        CHECK_EQ(results[i].get(), std::string());
+        CHECK(ecus[i]->memory == Slice(targets[i]));
+    }
+
+    // The two ECUs on the first bus were served by one thread, block for block in turn.
+    std::vector<LoopbackBus::Sent> sent = first.sent();
+    size_t lastOfFirst = 0;
+    size_t firstOfSecond = sent.size();
+    for (size_t i = 0; i < sent.size(); ++i) {
+        if (sent[i].frame.id == 0x7E0) {
+            lastOfFirst = i;
+        } else if (firstOfSecond == sent.size()) {
+            firstOfSecond = i;
+        }
+    }
+    CHECK(firstOfSecond < lastOfFirst);
+}
@@ -0,0 +1,125 @@
+#include "frame_dedup.h"
+
+#include "check.h"
+
+namespace {
+
+using Verdict = FrameDeduplicator::Verdict;
+
+constexpr int64_t kWindowUs = 2000;
+constexpr int64_t kFailoverUs = 10000;
+
+CanFrame Frame(uint32_t id, uint8_t payload) {
+    CanFrame frame{};
+    frame.id = id;
+    frame.length = 1;
+    frame.data[0] = payload;
+    return frame;
+}
+
+} // namespace
+
+TEST("frames seen by both adapters are delivered once") {
+    FrameDeduplicator dedup(kWindowUs, kFailoverUs);
+    CHECK(dedup.Accept(0, Frame(0x100, 1), 1000) == Verdict::Deliver);
+    CHECK(dedup.Accept(1, Frame(0x100, 1), 1300) == Verdict::Duplicate);
+    // The secondary may be first.
+    CHECK(dedup.Accept(1, Frame(0x101, 2), 2000) == Verdict::Deliver);
+    CHECK(dedup.Accept(0, Frame(0x101, 2), 2100) == Verdict::Duplicate);
+    CHECK_EQ(dedup.delivered(), uint64_t{2});
+    CHECK_EQ(dedup.duplicates(), uint64_t{2});
+    CHECK(!dedup.ActiveMissing(50000));
+}
+
+TEST("repeats outside the window are separate frames") {
+    FrameDeduplicator dedup(kWindowUs, kFailoverUs);
+    CHECK(dedup.Accept(0, Frame(0x100, 1), 1000) == Verdict::Deliver);
+    CHECK(dedup.Accept(1, Frame(0x100, 1), 1000 + kWindowUs + 1) == Verdict::Deliver);
+    // Same adapter, same frame: a genuine repeat.
+    CHECK(dedup.Accept(0, Frame(0x102, 1), 10000) == Verdict::Deliver);
+    CHECK(dedup.Accept(0, Frame(0x102, 1), 10100) == Verdict::Deliver);
+}
+
+TEST("frames only the secondary sees trigger failover after the timeout") {
+    FrameDeduplicator dedup(kWindowUs, kFailoverUs);
+    CHECK(dedup.Accept(1, Frame(0x200, 1), 1000) == Verdict::Deliver);
+    CHECK(!dedup.ActiveMissing(1000 + kFailoverUs));
+    CHECK(dedup.ActiveMissing(1000 + kFailoverUs + 1));
+    CHECK(dedup.SwitchTo(1));
+    CHECK(!dedup.SwitchTo(1));
+    CHECK_EQ(dedup.active(), uint8_t{1});
+    CHECK_EQ(dedup.failovers(), uint64_t{1});
+    CHECK(!dedup.ActiveMissing(100000));
+}
+
+TEST("the check needs no further frames, so a silent bus fails over too") {
+    FrameDeduplicator dedup(kWindowUs, kFailoverUs);
+    CHECK(dedup.Accept(0, Frame(0x200, 1), 1000) == Verdict::Deliver);
+    CHECK(dedup.Accept(1, Frame(0x200, 1), 1100) == Verdict::Duplicate);
+    // The primary drops off; the last frame on the bus reaches only the secondary.
+    CHECK(dedup.Accept(1, Frame(0x201, 2), 2000) == Verdict::Deliver);
+    CHECK(!dedup.ActiveMissing(2000 + kFailoverUs / 2));
+    CHECK(dedup.ActiveMissing(2000 + kFailoverUs + 1));
+}
+
+TEST("after a failover the primary is watched the same way") {
+    FrameDeduplicator dedup(kWindowUs, kFailoverUs);
+    // Frames the primary delivered while it was active are not held against the secondary.
+    CHECK(dedup.Accept(0, Frame(0x200, 1), 1000) == Verdict::Deliver);
+    CHECK(dedup.SwitchTo(1));
+    CHECK(!dedup.ActiveMissing(1000 + 2 * kFailoverUs));
+
+    // Frames both adapters see keep the pair on the secondary.
+    CHECK(dedup.Accept(1, Frame(0x201, 2), 30000) == Verdict::Deliver);
+    CHECK(dedup.Accept(0, Frame(0x201, 2), 30100) == Verdict::Duplicate);
+    CHECK(!dedup.ActiveMissing(30000 + 2 * kFailoverUs));
+
+    // Then the secondary drops off and only the primary delivers.
+    CHECK(dedup.Accept(0, Frame(0x202, 3), 60000) == Verdict::Deliver);
+    CHECK(!dedup.ActiveMissing(60000 + kFailoverUs));
+    CHECK(dedup.ActiveMissing(60000 + kFailoverUs + 1));
+    CHECK(dedup.SwitchTo(0));
+    CHECK_EQ(dedup.failovers(), uint64_t{2});
+    CHECK(!dedup.ActiveMissing(200000));
+}
+
+TEST("transmitting while both adapters are healthy does not fail over") {
+    FrameDeduplicator dedup(kWindowUs, kFailoverUs);
+    int64_t now = 1000;
+    for (uint8_t i = 0; i < 100; ++i) {
+        // Sent on the primary: only the secondary receives it, some time after the send call.
+        dedup.RecordTransmit(0, Frame(0x300, i), now);
+        CHECK(dedup.Accept(1, Frame(0x300, i), now + 400) == Verdict::OwnTransmit);
+        // Other nodes' traffic keeps arriving on both adapters.
+        CHECK(dedup.Accept(0, Frame(0x400, i), now + 500) == Verdict::Deliver);
+        CHECK(dedup.Accept(1, Frame(0x400, i), now + 520) == Verdict::Duplicate);
+        now += 5000;
+        CHECK(!dedup.ActiveMissing(now));
+    }
+    CHECK_EQ(dedup.own_transmits(), uint64_t{100});
+    CHECK_EQ(dedup.delivered(), uint64_t{100});
+    CHECK_EQ(dedup.failovers(), uint64_t{0});
+}
+
+TEST("own transmissions are matched once and only from the other adapter") {
+    FrameDeduplicator dedup(kWindowUs, kFailoverUs);
+    dedup.RecordTransmit(0, Frame(0x300, 1), 1000);
+    // A queued send can reach the wire well after the dedup window.
+    CHECK(dedup.Accept(1, Frame(0x300, 1), 1000 + 3 * kWindowUs) == Verdict::OwnTransmit);
+    // A later identical frame from another node is delivered.
+    CHECK(dedup.Accept(1, Frame(0x300, 1), 20000) == Verdict::Deliver);
+
+    // After failover sends go out on the secondary and the primary sees them.
+    dedup.SwitchTo(1);
+    dedup.RecordTransmit(1, Frame(0x301, 2), 30000);
+    CHECK(dedup.Accept(1, Frame(0x301, 2), 30100) == Verdict::Deliver);
+    CHECK(dedup.Accept(0, Frame(0x301, 2), 30200) == Verdict::Duplicate);
+    dedup.RecordTransmit(1, Frame(0x302, 3), 40000);
+    CHECK(dedup.Accept(0, Frame(0x302, 3), 40100) == Verdict::OwnTransmit);
+}
+
+TEST("unmatched recorded sends expire after the failover timeout") {
+    FrameDeduplicator dedup(kWindowUs, kFailoverUs);
+    dedup.RecordTransmit(0, Frame(0x300, 1), 1000);
+    CHECK(dedup.Accept(1, Frame(0x300, 1), 1000 + kFailoverUs + 1) == Verdict::Deliver);
+}
@@ -0,0 +1,200 @@
+#include "id_scanner.h"
+
+#include <chrono>
+#include <future>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "loopback_bus.h"
+
+namespace {
+
+// An ECU, keyed by its request ID, answering probes with `response` on `rx_id`.
+struct Ecu {
+    uint32_t rx_id;
+    bool rx_extended;
+    std::vector<uint8_t> response;
+    int answers = -1; // how many probes it answers; -1 for all
+};
+
+CanFrame Response(const Ecu& ecu) {
+    CanFrame frame = Frame(ecu.rx_id, ecu.response);
+    frame.flags = ecu.rx_extended ? kFrameFlagExtended : 0;
+    return frame;
+}
+
+// Answers probes from the scanner thread, as ECUs on the loopback bus would.
+void Answer(LoopbackBus& bus, std::map<uint32_t, Ecu>& ecus) {
+    bus.respond = [&bus, &ecus](const CanFrame& frame) {
+        auto ecu = ecus.find(frame.id);
+        if (ecu != ecus.end() && ecu->second.answers != 0) {
+            ecu->second.answers--;
+            bus.Inject(Response(ecu->second));
+        }
+    };
+}
+
+// Starts `scanner` and waits for its `finished` callback.
+class Run {
+public:
+    explicit Run(IdScanner& scanner) : result_(done_.get_future()) {
+        scanner.Start([this]() { done_.set_value(); });
+    }
+    bool Wait(std::chrono::milliseconds limit = std::chrono::milliseconds(10000)) {
+        return result_.wait_for(limit) == std::future_status::ready;
+    }
+
+private:
+    std::promise<void> done_;
+    std::future<void> result_;
+};
+
+IdScanner::Config Config(std::vector<IdScanner::Range> ranges, int64_t intervalNs = 20000) {
+    IdScanner::Config config;
+    config.ranges = std::move(ranges);
+    config.window_us = 20000;
+    config.listen_us = 30000;
+    config.interval_ns = intervalNs;
+    return config;
+}
+
+IdScanner::Range Range(uint32_t from, uint32_t to, uint32_t step = 1, bool extended = false) {
+    IdScanner::Range range;
+    range.from = from;
+    range.to = to;
+    range.step = step;
+    range.extended = extended;
+    return range;
+}
+
+} // namespace
+
+TEST("responders across both ID spaces are found and confirmed") {
+    LoopbackBus bus;
+    std::map<uint32_t, Ecu> ecus = {
+        {0x7E0, {0x7E8, false, {0x02, 0x7E, 0x00}}},
+        {0x710, {0x718, false, {0x03, 0x7F, 0x3E, 0x11}}}, // serviceNotSupported still answers
+        {0x18DA10F1, {0x18DAF110, true, {0x02, 0x7E, 0x00}}},
+    };
+    Answer(bus, ecus);
+    IdScanner scanner(&bus, Config({Range(0, 0x7FF), Range(0x18DA00F1, 0x18DAFFF1, 0x100, true)}));
+    Run run(scanner);
+    CHECK(run.Wait());
+
+    std::vector<IdScanner::Pair> pairs = scanner.Pairs();
+    CHECK_EQ(pairs.size(), size_t{3});
+    CHECK_EQ(pairs[0].tx_id, uint32_t{0x710});
+    CHECK_EQ(pairs[0].rx_id, uint32_t{0x718});
+    CHECK_EQ(pairs[0].length, uint8_t{8});
+    CHECK_EQ(pairs[0].data[1], uint8_t{0x7F});
+    CHECK_EQ(pairs[1].tx_id, uint32_t{0x7E0});
+    CHECK_EQ(pairs[1].rx_id, uint32_t{0x7E8});
+    CHECK(!pairs[1].extended);
+    CHECK_EQ(pairs[2].tx_id, uint32_t{0x18DA10F1});
+    CHECK_EQ(pairs[2].rx_id, uint32_t{0x18DAF110});
+    CHECK(pairs[2].extended && pairs[2].rx_extended);
+
+    IdScanner::Stats stats = scanner.GetStats();
+    CHECK(stats.phase == IdScanner::Phase::kIdle);
+    CHECK_EQ(stats.candidates, uint64_t{3});
+    CHECK_EQ(stats.found, uint64_t{3});
+    CHECK_EQ(stats.unconfirmed, uint64_t{0});
+    // The sweep, plus at most one confirmation probe per remembered candidate.
+    CHECK(stats.probes >= 0x800 + 0x100);
+    CHECK(stats.probes <= 0x800 + 0x100 + 3 * IdScanner::kMaxCandidates);
+    CHECK(stats.elapsed_us > 0);
+}
+
+TEST("traffic heard while listening is neither probed nor taken as a response") {
+    LoopbackBus bus;
+    std::map<uint32_t, Ecu> ecus = {
+        {0x7E0, {0x7E8, false, {0x02, 0x7E, 0x00}}},
+        {0x7E1, {0x7E9, false, {0x02, 0x7E, 0x00}}},
+    };
+    Answer(bus, ecus);
+    IdScanner scanner(&bus, Config({Range(0x700, 0x7FF)}));
+    Run run(scanner);
+    bus.Inject(Frame(0x7E9, {0x02, 0x7E, 0x00})); // a periodic frame that happens to look like an answer
+    CHECK(run.Wait());
+
+    std::vector<IdScanner::Pair> pairs = scanner.Pairs();
+    CHECK_EQ(pairs.size(), size_t{1});
+    CHECK_EQ(pairs[0].rx_id, uint32_t{0x7E8});
+    for (const LoopbackBus::Sent& sent : bus.sent()) {
+        if (sent.frame.id == 0x7E9) {
+            check::Fail(__FILE__, __LINE__, "probed an ID heard while listening");
+        }
+    }
+}
+
+TEST("a responder that goes quiet stays unconfirmed") {
+    LoopbackBus bus;
+    std::map<uint32_t, Ecu> ecus = {
+        {0x650, {0x6D0, false, {0x02, 0x7E, 0x00}, 1}},
+        {0x7E0, {0x7E8, false, {0x02, 0x7E, 0x00}}},
+    };
+    Answer(bus, ecus);
+    IdScanner::Config config = Config({Range(0x600, 0x7FF)});
+    config.window_us = 5000; // every remembered candidate is re-probed before giving up
+    IdScanner scanner(&bus, config);
+    Run run(scanner);
+    CHECK(run.Wait());
+
+    std::vector<IdScanner::Pair> pairs = scanner.Pairs();
+    CHECK_EQ(pairs.size(), size_t{1});
+    CHECK_EQ(pairs[0].tx_id, uint32_t{0x7E0});
+    CHECK_EQ(scanner.GetStats().unconfirmed, uint64_t{1});
+}
+
+TEST("the probe and its answers follow the configured service") {
+    LoopbackBus bus;
+    // ReadDataByIdentifier answered with an ISO-TP first frame, and by a TesterPresent-only ECU.
+    std::map<uint32_t, Ecu> ecus = {
+        {0x7E0, {0x7E8, false, {0x10, 0x14, 0x62, 0xF1, 0x90, 'W', 'V', 'W'}}},
+        {0x7E1, {0x7E9, false, {0x02, 0x7E, 0x00}}},
+    };
+    Answer(bus, ecus);
+    IdScanner::Config config = Config({Range(0x7E0, 0x7E7)});
+    config.probe = {0x22, 0xF1, 0x90};
+    config.padding = 0x55;
+    IdScanner scanner(&bus, config);
+    Run run(scanner);
+    CHECK(run.Wait());
+
+    std::vector<IdScanner::Pair> pairs = scanner.Pairs();
+    CHECK_EQ(pairs.size(), size_t{1});
+    CHECK_EQ(pairs[0].rx_id, uint32_t{0x7E8});
+    std::vector<LoopbackBus::Sent> sent = bus.sent();
+    CHECK(!sent.empty());
+    const CanFrame& probe = sent.front().frame;
+    CHECK_EQ(probe.length, uint8_t{8});
+    CHECK(std::vector<uint8_t>(probe.data, probe.data + 8) ==
+          std::vector<uint8_t>({0x03, 0x22, 0xF1, 0x90, 0x55, 0x55, 0x55, 0x55}));
+}
+
+TEST("probes are paced by the interval and stop() ends the scan early") {
+    LoopbackBus bus;
+    IdScanner paced(&bus, Config({Range(0, 49)}, 1000000));
+    Run run(paced);
+    CHECK(run.Wait());
+    std::vector<LoopbackBus::Sent> sent = bus.sent();
+    CHECK_EQ(sent.size(), size_t{50});
+    CHECK(sent.back().at_us - sent.front().at_us >= 49 * 1000 - 100);
+
+    LoopbackBus slow;
+    IdScanner stopped(&slow, Config({Range(0, 0x7FF)}, 1000000)); // about 2 s of probes
+    Run early(stopped);
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    stopped.Stop();
+    CHECK(early.Wait(std::chrono::milliseconds(500)));
+    CHECK(stopped.GetStats().probes < 0x800 / 2);
+}
+
+TEST("probe counts cover every range step") {
+    CHECK_EQ(IdScanner::ProbeCount({Range(0, 0x7FF)}), uint64_t{0x800});
+    CHECK_EQ(IdScanner::ProbeCount({Range(0x18DA00F1, 0x18DAFFF1, 0x100, true)}), uint64_t{0x100});
+    CHECK_EQ(IdScanner::ProbeCount({Range(0, 10, 3), Range(5, 5)}), uint64_t{5});
+    CHECK_EQ(IdScanner::ProbeCount({Range(0, 0x1FFFFFFF, 1, true)}), uint64_t{0x20000000});
+}
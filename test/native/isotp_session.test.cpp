@@ -0,0 +1,169 @@
+#include "isotp_session.h"
+
+#include <chrono>
+#include <future>
+#include <vector>
+
+#include "check.h"
+#include "loopback_bus.h"
+
+namespace {
+
+constexpr uint32_t kTesterId = 0x7E0;
+constexpr uint32_t kEcuId = 0x7E8;
+
+std::vector<uint8_t> Payload(size_t size) {
+    std::vector<uint8_t> payload(size);
+    for (size_t i = 0; i < size; ++i) {
+        payload[i] = static_cast<uint8_t>(i);
+    }
+    return payload;
+}
+
+SessionTask SendSession(SessionScheduler& scheduler, IsoTpConfig config, std::vector<uint8_t> payload,
+                        std::promise<std::string>* done) {
+    done->set_value(co_await IsoTpSend(scheduler, config, kTesterId, kEcuId, std::move(payload)));
+}
+
+SessionTask ReceiveSession(SessionScheduler& scheduler, IsoTpConfig config, int64_t timeoutUs,
+                           std::promise<IsoTpResult>* done) {
+    done->set_value(co_await IsoTpReceive(scheduler, config, kEcuId, kTesterId, timeoutUs));
+}
+
+template <typename T>
+bool Ready(std::future<T>& future) {
+    return future.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+}
+
+} // namespace
+
+TEST("single frames go out in one frame with padding") {
+    LoopbackBus bus;
+    SessionScheduler scheduler(&bus);
+    scheduler.Start();
+    std::promise<std::string> done;
+    std::future<std::string> result = done.get_future();
+    IsoTpConfig config;
+    scheduler.Spawn([&]() { return SendSession(scheduler, config, {0x22, 0xF1, 0x90}, &done); });
+    CHECK(Ready(result));
+    CHECK_EQ(result.get(), std::string());
+    std::vector<LoopbackBus::Sent> sent = bus.sent();
+    CHECK_EQ(sent.size(), size_t{1});
+    CHECK_EQ(sent[0].frame.id, kTesterId);
+    CHECK_EQ(sent[0].frame.data[0], uint8_t{0x03});
+    CHECK_EQ(sent[0].frame.data[3], uint8_t{0x90});
+    CHECK_EQ(sent[0].frame.data[4], config.padding);
+    scheduler.Stop();
+}
+
+TEST("consecutive frames are paced by the receiver's STmin and block size") {
+    LoopbackBus bus;
+    SessionScheduler scheduler(&bus);
+    // The ECU allows blocks of 3 frames, 5 ms apart.
+    bus.respond = [&](const CanFrame& frame) {
+        uint8_t type = frame.data[0] >> 4;
+        size_t consecutive = bus.sent().size() - 1;
+        if (type == 1 || (type == 2 && consecutive % 3 == 0)) {
+            bus.Inject(Frame(kEcuId, {0x30, 3, 5}));
+        }
+    };
+    scheduler.Start();
+    std::promise<std::string> done;
+    std::future<std::string> result = done.get_future();
+    scheduler.Spawn([&]() { return SendSession(scheduler, IsoTpConfig(), Payload(6 + 7 * 7), &done); });
+    CHECK(Ready(result));
+    CHECK_EQ(result.get(), std::string());
+    std::vector<LoopbackBus::Sent> sent = bus.sent();
+    CHECK_EQ(sent.size(), size_t{8});
+    CHECK_EQ(sent[0].frame.data[0], uint8_t{0x10});
+    CHECK_EQ(sent[0].frame.data[1], uint8_t{55});
+    for (size_t i = 1; i < sent.size(); ++i) {
+        CHECK_EQ(sent[i].frame.data[0], static_cast<uint8_t>(0x20 | (i & 0x0F)));
+        CHECK_EQ(sent[i].frame.data[1], static_cast<uint8_t>(6 + 7 * (i - 1)));
+        // Within a block the sender waits STmin; a new block starts on flow control.
+        if ((i - 1) % 3 != 0) {
+            CHECK(sent[i].at_us - sent[i - 1].at_us >= 5000);
+        }
+    }
+    scheduler.Stop();
+}
+
+TEST("a missing flow control times out after N_Bs") {
+    LoopbackBus bus;
+    SessionScheduler scheduler(&bus);
+    scheduler.Start();
+    IsoTpConfig config;
+    config.timeout_us = 30000;
+    std::promise<std::string> done;
+    std::future<std::string> result = done.get_future();
+    int64_t started = HostMicros();
+    scheduler.Spawn([&]() { return SendSession(scheduler, config, Payload(20), &done); });
+    CHECK(Ready(result));
+    CHECK_EQ(result.get(), std::string("ISO-TP flow control timeout"));
+    CHECK(HostMicros() - started >= config.timeout_us);
+    scheduler.Stop();
+}
+
+TEST("receive reassembles a message and announces its own flow control") {
+    LoopbackBus bus;
+    SessionScheduler scheduler(&bus);
+    IsoTpConfig config;
+    config.block_size = 2;
+    config.st_min = 0xF5;
+    // The ECU answers each flow control with the next block.
+    uint8_t sequence = 1;
+    size_t offset = 6;
+    std::vector<uint8_t> message = Payload(25);
+    bus.respond = [&](const CanFrame& frame) {
+        if (frame.data[0] != 0x30) {
+            return;
+        }
+        for (int i = 0; i < 2 && offset < message.size(); ++i, offset += 7) {
+            std::vector<uint8_t> bytes = {static_cast<uint8_t>(0x20 | (sequence++ & 0x0F))};
+            bytes.insert(bytes.end(), message.begin() + offset, message.begin() + std::min(offset + 7, message.size()));
+            bus.Inject(Frame(kEcuId, bytes));
+        }
+    };
+    scheduler.Start();
+    std::promise<IsoTpResult> done;
+    std::future<IsoTpResult> result = done.get_future();
+    scheduler.Spawn([&]() { return ReceiveSession(scheduler, config, 1000000, &done); });
+    // Spawn is asynchronous; the first frame may only arrive once the session listens.
+    while (scheduler.ActiveSessions() == 0) {
+        std::this_thread::yield();
+    }
+    bus.Inject(Frame(kEcuId, {0x10, 25, 0, 1, 2, 3, 4, 5}));
+    CHECK(Ready(result));
+    IsoTpResult received = result.get();
+    CHECK_EQ(received.error, std::string());
+    CHECK(received.data == message);
+    std::vector<LoopbackBus::Sent> sent = bus.sent();
+    CHECK_EQ(sent.size(), size_t{2}); // 3 consecutive frames in blocks of 2
+    CHECK_EQ(sent[0].frame.id, kTesterId);
+    CHECK_EQ(sent[0].frame.data[1], uint8_t{2});
+    CHECK_EQ(sent[0].frame.data[2], uint8_t{0xF5});
+    scheduler.Stop();
+}
+
+TEST("receive rejects consecutive frames out of sequence") {
+    LoopbackBus bus;
+    SessionScheduler scheduler(&bus);
+    bus.respond = [&](const CanFrame& frame) {
+        if (frame.data[0] == 0x30) {
+            bus.Inject(Frame(kEcuId, {0x22, 6, 7, 8, 9, 10, 11, 12}));
+        }
+    };
+    scheduler.Start();
+    std::promise<IsoTpResult> done;
+    std::future<IsoTpResult> result = done.get_future();
+    scheduler.Spawn([&]() { return ReceiveSession(scheduler, IsoTpConfig(), 1000000, &done); });
+    while (scheduler.ActiveSessions() == 0) {
+        std::this_thread::yield();
+    }
+    bus.Inject(Frame(kEcuId, {0x10, 20, 0, 1, 2, 3, 4, 5}));
+    CHECK(Ready(result));
+    IsoTpResult received = result.get();
+    CHECK_EQ(received.error, std::string("ISO-TP sequence error"));
+    CHECK(received.data.empty());
+    scheduler.Stop();
+}
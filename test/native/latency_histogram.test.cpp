@@ -0,0 +1,58 @@
+#include "latency_histogram.h"
+
+#include "check.h"
+
+TEST("empty histogram reports zeros") {
+    LatencyHistogram histogram;
+    CHECK_EQ(histogram.count(), uint64_t{0});
+    CHECK_EQ(histogram.Percentile(0.5), uint64_t{0});
+    CHECK_EQ(histogram.mean(), 0.0);
+}
+
+TEST("values below 16 us are exact") {
+    LatencyHistogram histogram;
+    for (int64_t us = 1; us <= 10; ++us) {
+        histogram.Record(us);
+    }
+    CHECK_EQ(histogram.count(), uint64_t{10});
+    CHECK_EQ(histogram.min(), uint64_t{1});
+    CHECK_EQ(histogram.max(), uint64_t{10});
+    CHECK_EQ(histogram.mean(), 5.5);
+    CHECK_EQ(histogram.Percentile(0.0), uint64_t{1});
+    CHECK_EQ(histogram.Percentile(0.5), uint64_t{5});
+    CHECK_EQ(histogram.Percentile(0.9), uint64_t{9});
+    CHECK_EQ(histogram.Percentile(1.0), uint64_t{10});
+}
+
+TEST("negative latencies count as zero") {
+    LatencyHistogram histogram;
+    histogram.Record(-25);
+    CHECK_EQ(histogram.min(), uint64_t{0});
+    CHECK_EQ(histogram.Percentile(0.5), uint64_t{0});
+}
+
+TEST("large values land within 6.25 percent") {
+    for (int64_t us : {int64_t{17}, int64_t{100}, int64_t{1000}, int64_t{12345}, int64_t{999999}, int64_t{1} << 40}) {
+        LatencyHistogram histogram;
+        histogram.Record(1); // keeps the percentile from being clamped to the sample itself
+        histogram.Record(us);
+        histogram.Record(us);
+        uint64_t p50 = histogram.Percentile(0.5);
+        double error = (static_cast<double>(p50) - static_cast<double>(us)) / static_cast<double>(us);
+        CHECK(error >= -0.0625 && error <= 0.0625);
+    }
+}
+
+TEST("percentiles follow the distribution's tail") {
+    LatencyHistogram histogram;
+    for (int i = 0; i < 990; ++i) {
+        histogram.Record(100);
+    }
+    for (int i = 0; i < 10; ++i) {
+        histogram.Record(50000);
+    }
+    CHECK(histogram.Percentile(0.5) >= 96 && histogram.Percentile(0.5) <= 104);
+    CHECK(histogram.Percentile(0.99) <= 104);
+    CHECK(histogram.Percentile(0.999) >= 47000);
+    CHECK_EQ(histogram.Percentile(1.0), uint64_t{50000});
+}
@@ -0,0 +1,218 @@
+#include "log_file.h"
+
+#include <cstring>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+std::string Fixture(const char* name) {
+    return std::string(ACE_CAN_FIXTURES) + "/" + name;
+}
+
+std::vector<CanFrame> ReadAll(const std::string& path, const std::string& format = "") {
+    LogFile file;
+    std::string error;
+    std::vector<CanFrame> frames;
+    if (!file.Open(path, format, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return frames;
+    }
+    CanFrame batch[2];
+    for (size_t n; (n = file.ReadFrames(batch, 2)) > 0;) {
+        frames.insert(frames.end(), batch, batch + n);
+    }
+    return frames;
+}
+
+void PutLe32(std::FILE* file, uint32_t value, bool swapped) {
+    uint8_t bytes[4];
+    for (int i = 0; i < 4; ++i) {
+        bytes[swapped ? 3 - i : i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+    std::fwrite(bytes, 1, 4, file);
+}
+
+// SocketCAN pcap in the writer's byte order; `swapped` writes a big-endian file.
+void WritePcap(const char* path, bool swapped, bool nanos) {
+    std::FILE* file = std::fopen(path, "wb");
+    PutLe32(file, nanos ? 0xA1B23C4Du : 0xA1B2C3D4u, swapped);
+    PutLe32(file, 0x00040002u, swapped); // version 2.4
+    PutLe32(file, 0, swapped);
+    PutLe32(file, 0, swapped);
+    PutLe32(file, 65535, swapped);
+    PutLe32(file, 227, swapped); // LINKTYPE_CAN_SOCKETCAN
+    // Classic frame, extended ID, 3 bytes.
+    uint8_t classic[16] = {0x80 | 0x12, 0x34, 0x56, 0x78, 3, 0, 0, 0, 0xAA, 0xBB, 0xCC};
+    PutLe32(file, 1700000000, swapped);
+    PutLe32(file, nanos ? 5000u : 5u, swapped);
+    PutLe32(file, sizeof(classic), swapped);
+    PutLe32(file, sizeof(classic), swapped);
+    std::fwrite(classic, 1, sizeof(classic), file);
+    // CAN FD frame with BRS, 12 bytes.
+    uint8_t fd[72] = {0, 0, 0x01, 0x23, 12, 0x05};
+    for (int i = 0; i < 12; ++i) {
+        fd[8 + i] = static_cast<uint8_t>(i);
+    }
+    PutLe32(file, 1700000001, swapped);
+    PutLe32(file, 0, swapped);
+    PutLe32(file, sizeof(fd), swapped);
+    PutLe32(file, sizeof(fd), swapped);
+    std::fwrite(fd, 1, sizeof(fd), file);
+    // Truncated record, skipped.
+    PutLe32(file, 1700000002, swapped);
+    PutLe32(file, 0, swapped);
+    PutLe32(file, 4, swapped);
+    PutLe32(file, 16, swapped);
+    std::fwrite(fd, 1, 4, file);
+    std::fclose(file);
+}
+
+} // namespace
+
+TEST("asc classic, extended, remote, error and CAN FD records") {
+    std::vector<CanFrame> frames = ReadAll(Fixture("sample.asc"));
+    CHECK_EQ(frames.size(), 5u);
+
+    CHECK_EQ(frames[0].timestamp, 10000u);
+    CHECK_EQ(frames[0].id, 0x123u);
+    CHECK_EQ(frames[0].channel, 0);
+    CHECK_EQ(frames[0].length, 8);
+    CHECK_EQ(frames[0].data[7], 0x88);
+
+    CHECK_EQ(frames[1].timestamp, 20500u);
+    CHECK_EQ(frames[1].id, 0x1ABCDEF0u);
+    CHECK_EQ(frames[1].channel, 1);
+    CHECK_EQ(frames[1].flags, kFrameFlagExtended | kFrameFlagTx);
+    CHECK_EQ(frames[1].length, 3);
+
+    CHECK_EQ(frames[2].flags, kFrameFlagRemote);
+    CHECK_EQ(frames[2].length, 4);
+    CHECK_EQ(frames[3].flags, kFrameFlagError);
+
+    CHECK_EQ(frames[4].id, 0x100u);
+    CHECK_EQ(frames[4].flags, kFrameFlagFd | kFrameFlagBrs);
+    CHECK_EQ(frames[4].length, 12);
+    CHECK_EQ(frames[4].data[11], 0x0B);
+}
+
+TEST("asc base dec switches ID and data radix") {
+    std::vector<CanFrame> frames = ReadAll(Fixture("decimal.asc"));
+    CHECK_EQ(frames.size(), 1u);
+    CHECK_EQ(frames[0].id, 291u);
+    CHECK_EQ(frames[0].data[1], 255);
+}
+
+TEST("candump lines, FD flags, remote frames and error IDs") {
+    std::vector<CanFrame> frames = ReadAll(Fixture("sample.log"));
+    CHECK_EQ(frames.size(), 5u);
+
+    CHECK_EQ(frames[0].timestamp, 1700000000000100u);
+    CHECK_EQ(frames[0].id, 0x123u);
+    CHECK_EQ(frames[0].length, 4);
+    CHECK_EQ(frames[0].data[0], 0xDE);
+
+    CHECK_EQ(frames[1].channel, 1);
+    CHECK_EQ(frames[1].flags, kFrameFlagExtended | kFrameFlagTx);
+
+    CHECK_EQ(frames[2].channel, 3);
+    CHECK_EQ(frames[2].flags, kFrameFlagRemote);
+    CHECK_EQ(frames[2].length, 4);
+
+    CHECK_EQ(frames[3].flags, kFrameFlagFd | kFrameFlagBrs | kFrameFlagEsi);
+    CHECK_EQ(frames[3].length, 10);
+    CHECK_EQ(frames[3].data[9], 0x10);
+
+    CHECK((frames[4].flags & kFrameFlagError) != 0);
+    CHECK_EQ(frames[4].id, 0x80u);
+}
+
+TEST("pcap in either byte order and timestamp resolution") {
+    const bool variants[][2] = {{false, false}, {true, false}, {false, true}, {true, true}};
+    for (const auto& variant : variants) {
+        WritePcap("capture.pcap", variant[0], variant[1]);
+        std::vector<CanFrame> frames = ReadAll("capture.pcap");
+        CHECK_EQ(frames.size(), 2u);
+        CHECK_EQ(frames[0].timestamp, 1700000000000005u);
+        CHECK_EQ(frames[0].id, 0x12345678u);
+        CHECK_EQ(frames[0].flags, kFrameFlagExtended);
+        CHECK_EQ(frames[0].length, 3);
+        CHECK_EQ(frames[0].data[2], 0xCC);
+        CHECK_EQ(frames[1].id, 0x123u);
+        CHECK_EQ(frames[1].flags, kFrameFlagFd | kFrameFlagBrs);
+        CHECK_EQ(frames[1].length, 12);
+        CHECK_EQ(frames[1].data[11], 11);
+    }
+}
+
+TEST("format from name, extension or content") {
+    LogFile file;
+    std::string error;
+    CHECK(!file.Open(Fixture("sample.asc"), "blf", error));
+    CHECK_EQ(error, std::string("Unsupported log format: blf"));
+    CHECK(!file.Open(Fixture("missing.asc"), "", error));
+
+    WritePcap("capture.bin", false, false);
+    CHECK(file.Open("capture.bin", "", error));
+    CHECK(file.format() == LogFile::Format::Pcap);
+    CHECK(file.Open(Fixture("sample.log"), "", error));
+    CHECK(file.format() == LogFile::Format::Candump);
+    CHECK(file.Open(Fixture("sample.log"), "candump", error));
+    CHECK(file.format() == LogFile::Format::Candump);
+}
+
+TEST("trc 1.0 without a FILEVERSION line") {
+    std::vector<CanFrame> frames = ReadAll(Fixture("v10.trc"));
+    CHECK_EQ(frames.size(), 2u);
+    CHECK_EQ(frames[0].timestamp, 1841000u);
+    CHECK_EQ(frames[0].id, 0x001u);
+    CHECK_EQ(frames[0].flags, 0);
+    CHECK_EQ(frames[0].length, 8);
+    CHECK_EQ(frames[0].data[7], 0x07);
+    CHECK_EQ(frames[1].id, 0x18FF0001u);
+    CHECK_EQ(frames[1].flags, kFrameFlagExtended);
+    CHECK_EQ(frames[1].data[1], 0xBB);
+}
+
+constexpr uint64_t kTrcStartUs = 1582286400000000u; // $STARTTIME=43882.5
+
+TEST("trc 1.1 directions, remote frames and skipped status records") {
+    std::vector<CanFrame> frames = ReadAll(Fixture("v11.trc"));
+    CHECK_EQ(frames.size(), 3u);
+    CHECK_EQ(frames[0].timestamp, kTrcStartUs + 1841200);
+    CHECK_EQ(frames[0].id, 0x300u);
+    CHECK_EQ(frames[0].length, 8);
+    CHECK_EQ(frames[1].flags, kFrameFlagExtended | kFrameFlagTx);
+    CHECK_EQ(frames[1].length, 2);
+    CHECK_EQ(frames[2].id, 0x301u);
+    CHECK_EQ(frames[2].flags, kFrameFlagRemote);
+    CHECK_EQ(frames[2].length, 4);
+}
+
+TEST("trc 1.3 bus column and reserved column") {
+    std::vector<CanFrame> frames = ReadAll(Fixture("v13.trc"));
+    CHECK_EQ(frames.size(), 3u);
+    CHECK_EQ(frames[0].timestamp, kTrcStartUs + 1300);
+    CHECK_EQ(frames[0].channel, 0);
+    CHECK_EQ(frames[0].data[7], 0x07);
+    CHECK_EQ(frames[1].channel, 1);
+    CHECK_EQ(frames[1].flags, kFrameFlagExtended | kFrameFlagTx);
+    CHECK_EQ(frames[1].data[0], 0xAA);
+    CHECK_EQ(frames[2].flags, kFrameFlagError);
+    CHECK_EQ(frames[2].length, 5);
+}
+
+TEST("trc 2.1 columns, CAN FD lengths and skipped status records") {
+    std::vector<CanFrame> frames = ReadAll(Fixture("v21.trc"));
+    CHECK_EQ(frames.size(), 3u);
+    CHECK_EQ(frames[0].timestamp, kTrcStartUs + 1300);
+    CHECK_EQ(frames[0].id, 0x300u);
+    CHECK_EQ(frames[0].length, 8);
+    CHECK_EQ(frames[1].channel, 1);
+    CHECK_EQ(frames[1].flags, kFrameFlagExtended | kFrameFlagTx | kFrameFlagFd | kFrameFlagBrs);
+    CHECK_EQ(frames[1].length, 12);
+    CHECK_EQ(frames[1].data[11], 0x0B);
+    CHECK_EQ(frames[2].flags, kFrameFlagRemote);
+    CHECK_EQ(frames[2].length, 4);
+}
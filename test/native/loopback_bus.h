@@ -0,0 +1,62 @@
+#ifndef ACE_CAN_TEST_LOOPBACK_BUS_H
+#define ACE_CAN_TEST_LOOPBACK_BUS_H
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "can_frame.h"
+#include "session_bus.h"
+#include "timed_tx.h"
+
+// Stands in for a CANBus: records what sessions transmit (with the host time), optionally answers
+// it, and injects received frames through the scheduler's tap as the receive thread would.
+class LoopbackBus : public SessionBus {
+public:
+    struct Sent {
+        int64_t at_us;
+        CanFrame frame;
+    };
+
+    void AddTap(std::shared_ptr<FrameTap> tap) override { tap_ = std::move(tap); }
+    void RemoveTap(const FrameTap*) override { tap_.reset(); }
+    std::string Transmit(const CanFrame& frame) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            sent_.push_back({HostMicros(), frame});
+        }
+        if (respond) {
+            respond(frame);
+        }
+        return std::string();
+    }
+
+    void Inject(const CanFrame& frame) { tap_->OnFrame(frame, HostMicros()); }
+    std::vector<Sent> sent() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return sent_;
+    }
+
+    std::function<void(const CanFrame&)> respond; // runs on the scheduler thread
+
+private:
+    std::shared_ptr<FrameTap> tap_;
+    std::mutex mutex_;
+    std::vector<Sent> sent_;
+};
+
+// A classic 8-byte frame, padded with 0xAA.
+inline CanFrame Frame(uint32_t id, std::vector<uint8_t> bytes) {
+    CanFrame frame{};
+    frame.id = id;
+    frame.length = 8;
+    for (size_t i = 0; i < 8; ++i) {
+        frame.data[i] = i < bytes.size() ? bytes[i] : 0xAA;
+    }
+    return frame;
+}
+
+#endif // ACE_CAN_TEST_LOOPBACK_BUS_H
@@ -0,0 +1,113 @@
+#include "rcu.h"
+#include "receive_pipeline.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+CanFrame Frame(uint32_t id, bool extended = false) {
+    CanFrame frame{};
+    frame.id = id;
+    frame.flags = extended ? kFrameFlagExtended : 0;
+    return frame;
+}
+
+IdFilter Filter(uint32_t id, uint32_t mask, int8_t extended = -1) {
+    IdFilter filter;
+    filter.id = id;
+    filter.mask = mask;
+    filter.extended = extended;
+    return filter;
+}
+
+} // namespace
+
+TEST("an empty pipeline accepts everything") {
+    ReceivePipeline pipeline;
+    CHECK(pipeline.Accepts(Frame(0x123)));
+    CHECK(pipeline.Accepts(Frame(0x18FF00FA, true)));
+}
+
+TEST("id filters match under their mask and frame format") {
+    ReceivePipeline pipeline;
+    pipeline.filters = {Filter(0x700, 0x700), Filter(0x18FF00FA, 0x1FFFFFFF, 1)};
+    CHECK(pipeline.Accepts(Frame(0x7E8)));
+    CHECK(!pipeline.Accepts(Frame(0x6E8)));
+    CHECK(pipeline.Accepts(Frame(0x18FF00FA, true)));
+    CHECK(!pipeline.Accepts(Frame(0x18FF00FB, true)));
+
+    pipeline.filters = {Filter(0x100, 0x7FF, 0)};
+    CHECK(pipeline.Accepts(Frame(0x100)));
+    CHECK(!pipeline.Accepts(Frame(0x100, true)));
+}
+
+TEST("a filter expression applies on top of the id filters") {
+    ReceivePipeline pipeline;
+    auto program = std::make_shared<FilterProgram>();
+    CHECK_EQ(FilterProgram::Compile("id < 0x200", *program), std::string());
+    pipeline.expression = program;
+    CHECK(pipeline.Accepts(Frame(0x100)));
+    CHECK(!pipeline.Accepts(Frame(0x300)));
+    pipeline.filters = {Filter(0x180, 0x7FF)};
+    CHECK(!pipeline.Accepts(Frame(0x100)));
+    CHECK(pipeline.Accepts(Frame(0x180)));
+}
+
+TEST("rcu readers see whole snapshots while a writer replaces them") {
+    RcuPtr<std::vector<int>> cell;
+    std::atomic<bool> stop{false};
+    std::atomic<int> torn{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&]() {
+            while (!stop) {
+                RcuPtr<std::vector<int>>::ReadGuard guard(cell);
+                // Every published snapshot holds `size` copies of its size.
+                for (int value : *guard) {
+                    if (value != static_cast<int>(guard->size())) {
+                        torn++;
+                    }
+                }
+            }
+        });
+    }
+    for (int size = 1; size <= 200; ++size) {
+        cell.Update([size](std::vector<int>& values) { values.assign(size, size); });
+    }
+    stop = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    CHECK_EQ(torn.load(), 0);
+    RcuPtr<std::vector<int>>::ReadGuard guard(cell);
+    CHECK_EQ(guard->size(), size_t{200});
+}
+
+TEST("rcu update waits for readers of the old snapshot") {
+    RcuPtr<int> cell;
+    std::atomic<bool> updated{false};
+    bool updatedWhileReading = false;
+    int seenWhileReading = -1;
+    std::thread writer;
+    {
+        RcuPtr<int>::ReadGuard guard(cell);
+        writer = std::thread([&]() {
+            cell.Update([](int& value) { value = 1; });
+            updated = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        updatedWhileReading = updated;
+        seenWhileReading = *guard;
+    }
+    writer.join();
+    CHECK(!updatedWhileReading);
+    CHECK_EQ(seenWhileReading, 0);
+    CHECK(updated);
+    RcuPtr<int>::ReadGuard guard(cell);
+    CHECK_EQ(*guard, 1);
+}
@@ -0,0 +1,173 @@
+#include "receive_poller.h"
+
+#include <uv.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+// A receive fd (the read end of a pipe) and what the poller read from it, one byte per wake-up.
+class Source {
+public:
+    Source() { Open(); }
+    ~Source() { Close(); }
+
+    ReceivePoller::Hooks Hooks() {
+        ReceivePoller::Hooks hooks;
+        hooks.fd = [this]() { return attached_ ? fds_[0] : -1; };
+        hooks.readable = [this](int status) {
+            if (status < 0) {
+                errors_.push_back(status);
+                return;
+            }
+            uint8_t byte;
+            if (read(fds_[0], &byte, 1) == 1) {
+                bytes_.push_back(byte);
+            }
+        };
+        return hooks;
+    }
+
+    void Write(uint8_t byte) {
+        if (write(fds_[1], &byte, 1) != 1) {
+            check::Fail(__FILE__, __LINE__, "write to the pipe failed");
+        }
+    }
+
+    // Replaces the pipe with a new one whose read end has the same fd number, like a re-opened device.
+    void Reopen() {
+        int oldRead = fds_[0];
+        Close();
+        Open();
+        if (fds_[0] != oldRead) {
+            dup2(fds_[0], oldRead);
+            close(fds_[0]);
+            fds_[0] = oldRead;
+        }
+    }
+
+    std::atomic<bool> attached_{true};
+    std::vector<uint8_t> bytes_;
+    std::vector<int> errors_;
+    int fds_[2] = {-1, -1};
+
+private:
+    void Open() {
+        if (pipe(fds_) != 0) {
+            check::Fail(__FILE__, __LINE__, "pipe failed");
+        }
+    }
+    void Close() {
+        close(fds_[0]);
+        close(fds_[1]);
+    }
+};
+
+// Runs the loop without blocking until `done` holds, for up to a second.
+bool RunUntil(uv_loop_t* loop, const std::function<bool()>& done) {
+    for (int i = 0; i < 1000; ++i) {
+        uv_run(loop, UV_RUN_NOWAIT);
+        if (done()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+// Lets pending close callbacks run, then checks every handle was released.
+void CloseLoop(uv_loop_t* loop) {
+    uv_run(loop, UV_RUN_DEFAULT);
+    CHECK_EQ(uv_loop_close(loop), 0);
+}
+
+} // namespace
+
+TEST("each wake-up reads once and the fd is polled until it is drained") {
+    uv_loop_t loop;
+    uv_loop_init(&loop);
+    Source source;
+    ReceivePoller poller(source.Hooks());
+    CHECK(poller.Start(&loop));
+    CHECK(poller.Running());
+    CHECK(!poller.Start(&loop));
+
+    source.Write(1);
+    source.Write(2);
+    source.Write(3);
+    CHECK(RunUntil(&loop, [&]() { return source.bytes_.size() == 3; }));
+    CHECK(source.bytes_ == std::vector<uint8_t>({1, 2, 3}));
+    CHECK(source.errors_.empty());
+
+    poller.Stop();
+    CHECK(!poller.Running());
+    source.Write(4);
+    uv_run(&loop, UV_RUN_NOWAIT);
+    CHECK_EQ(source.bytes_.size(), size_t{3});
+    CloseLoop(&loop);
+}
+
+TEST("a rearm from another thread follows a detach and a re-opened fd with the same number") {
+    uv_loop_t loop;
+    uv_loop_init(&loop);
+    Source source;
+    ReceivePoller poller(source.Hooks());
+    CHECK(poller.Start(&loop));
+
+    source.attached_ = false;
+    std::thread([&]() { poller.Rearm(); }).join();
+    uv_run(&loop, UV_RUN_NOWAIT);
+    source.Write(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    uv_run(&loop, UV_RUN_NOWAIT); // nothing is watched while detached
+    CHECK(source.bytes_.empty());
+
+    // Closing the old pipe drops it from the kernel's poll set; only a fresh watch sees the new one.
+    source.Reopen();
+    source.attached_ = true;
+    std::thread([&]() { poller.Rearm(); }).join();
+    source.Write(2);
+    CHECK(RunUntil(&loop, [&]() { return !source.bytes_.empty(); }));
+    CHECK(source.bytes_ == std::vector<uint8_t>({2}));
+
+    poller.Stop();
+    poller.Rearm(); // a late rearm from the watcher is ignored
+    CloseLoop(&loop);
+}
+
+TEST("an fd that cannot be watched is reported through the read hook") {
+    uv_loop_t loop;
+    uv_loop_init(&loop);
+    int fd = open("/dev/null", O_RDONLY); // epoll refuses files that are always readable
+    std::vector<int> statuses;
+    ReceivePoller poller({[fd]() { return fd; }, [&](int status) { statuses.push_back(status); }});
+    CHECK(poller.Start(&loop));
+    CHECK_EQ(statuses.size(), size_t{1});
+    CHECK(statuses[0] < 0);
+    poller.Stop();
+    close(fd);
+    CloseLoop(&loop);
+}
+
+TEST("a stopped poller starts again") {
+    uv_loop_t loop;
+    uv_loop_init(&loop);
+    Source source;
+    ReceivePoller poller(source.Hooks());
+    CHECK(poller.Start(&loop));
+    poller.Stop();
+    CHECK(poller.Start(&loop));
+    source.Write(7);
+    CHECK(RunUntil(&loop, [&]() { return !source.bytes_.empty(); }));
+    poller.Stop();
+    CloseLoop(&loop);
+}
@@ -0,0 +1,98 @@
+#include "stage_plugin.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+// Builds test/fixtures/sample_stage.c into `output` with the compiler that built this test.
+bool BuildStage(const char* output, const char* defines = "") {
+    std::string command = std::string(ACE_CAN_CXX) + " -x c++ -O1 -shared -fPIC " + defines + " -I \"" + ACE_CAN_SRC +
+                          "\" -o " + output + " \"" + ACE_CAN_FIXTURES + "/sample_stage.c\"";
+    return std::system(command.c_str()) == 0;
+}
+
+CanFrame Frame(uint32_t id, std::vector<uint8_t> data, uint8_t flags = 0) {
+    CanFrame frame = {};
+    frame.id = id;
+    frame.flags = flags;
+    frame.length = static_cast<uint8_t>(data.size());
+    std::memcpy(frame.data, data.data(), data.size());
+    return frame;
+}
+
+} // namespace
+
+TEST("a stage drops, annotates, derives frames and emits results") {
+    CHECK(BuildStage("./stage.so"));
+    StagePlugin plugin;
+    CHECK_EQ(plugin.Load("./stage.so", "id=200"), std::string());
+    CHECK_EQ(std::string(plugin.Name()), std::string("sample"));
+
+    std::vector<CanFrame> frames = {Frame(0x100, {1}), Frame(0x200, {1, 2, 3}), Frame(0x7FF, {}, kFrameFlagError),
+                                    Frame(0x300, {9, 9})};
+    std::vector<uint32_t> annotations = {0, 0, 0, 7};
+    std::vector<StagePlugin::Result> results;
+    plugin.Process(frames, annotations, results);
+
+    CHECK_EQ(frames.size(), size_t{4});
+    CHECK_EQ(annotations.size(), size_t{4});
+    CHECK_EQ(frames[0].id, uint32_t{0x100});
+    CHECK_EQ(frames[1].id, uint32_t{0x200});
+    CHECK_EQ(annotations[1], uint32_t{0x10006});
+    CHECK_EQ(frames[2].id, uint32_t{0x300});
+    CHECK_EQ(annotations[2], uint32_t{7}); // moved along with its frame
+    CHECK_EQ(frames[3].id, uint32_t{0x201});
+    CHECK_EQ(annotations[3], uint32_t{0});
+    CHECK_EQ(frames[3].length, uint8_t{3});
+    CHECK_EQ(frames[3].data[0], uint8_t{3});
+    CHECK_EQ(frames[3].data[2], uint8_t{1});
+
+    CHECK_EQ(results.size(), size_t{1});
+    CHECK_EQ(results[0].tag, uint32_t{0x200});
+    CHECK(results[0].data == std::vector<uint8_t>({1, 2, 3}));
+}
+
+TEST("derived frames are bounded by the batch capacity") {
+    StagePlugin plugin;
+    CHECK_EQ(plugin.Load("./stage.so", "id=5"), std::string());
+    size_t count = StagePlugin::kDerivedCapacity + 10;
+    std::vector<CanFrame> frames(count, Frame(5, {1}));
+    std::vector<uint32_t> annotations(count, 0);
+    std::vector<StagePlugin::Result> results;
+    plugin.Process(frames, annotations, results);
+
+    CHECK_EQ(frames.size(), count + StagePlugin::kDerivedCapacity);
+    CHECK_EQ(annotations.size(), frames.size());
+    CHECK_EQ(frames.back().id, uint32_t{6});
+    CHECK_EQ(results.size(), count);
+
+    // Results accumulate until the caller takes them; an empty batch stays empty.
+    frames.clear();
+    annotations.clear();
+    plugin.Process(frames, annotations, results);
+    CHECK(frames.empty());
+    CHECK(annotations.empty());
+    CHECK_EQ(results.size(), count);
+}
+
+TEST("incompatible libraries and failed instances are rejected") {
+    StagePlugin failing;
+    CHECK_EQ(failing.Load("./stage.so", "fail"), std::string("sample: bad config 'fail'"));
+
+    CHECK(BuildStage("./stage_abi.so", "-DSTAGE_ABI=99"));
+    StagePlugin newer;
+    std::string error = newer.Load("./stage_abi.so", "id=1");
+    CHECK(error.find("not a compatible receive stage") != std::string::npos);
+
+    CHECK(BuildStage("./stage_none.so", "-DSTAGE_NO_ENTRY"));
+    StagePlugin bare;
+    CHECK_EQ(bare.Load("./stage_none.so", "id=1"), std::string("./stage_none.so does not export ace_can_stage_v1"));
+
+    StagePlugin missing;
+    CHECK(!missing.Load("./no_such_stage.so", "").empty());
+}
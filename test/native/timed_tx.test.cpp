@@ -0,0 +1,66 @@
+#include "timed_tx.h"
+
+#include "check.h"
+
+TEST("device clock is unknown until the first sample") {
+    DeviceClock clock;
+    CHECK(!clock.Known());
+    clock.Sample(1000, 51000);
+    CHECK(clock.Known());
+    CHECK_EQ(clock.ToHost(2000), int64_t{52000});
+    CHECK_EQ(clock.ToDevice(52000), int64_t{2000});
+    clock.Reset();
+    CHECK(!clock.Known());
+}
+
+TEST("lower offsets are taken at once, higher ones only at the next window") {
+    DeviceClock clock;
+    clock.Sample(0, 10000); // offset 10000; the window starts at host 0
+    clock.Sample(1000, 10500); // 9500: a faster delivery lowers the estimate immediately
+    CHECK_EQ(clock.ToHost(0), int64_t{9500});
+    clock.Sample(2000, 13000); // 11000: a slower delivery is ignored
+    CHECK_EQ(clock.ToHost(0), int64_t{9500});
+}
+
+TEST("each window publishes its own minimum, so the estimate follows drift") {
+    DeviceClock clock;
+    clock.Sample(0, DeviceClock::kWindowUs); // closes the first window at offset 1 s
+    CHECK_EQ(clock.ToHost(0), DeviceClock::kWindowUs);
+    // The device clock runs 200 us slow over the next window; its best sample still wins.
+    clock.Sample(500000, DeviceClock::kWindowUs + 500300);
+    clock.Sample(900000, DeviceClock::kWindowUs + 900250);
+    CHECK_EQ(clock.ToHost(0), DeviceClock::kWindowUs);
+    clock.Sample(1000000, 2 * DeviceClock::kWindowUs + 200);
+    CHECK_EQ(clock.ToHost(0), DeviceClock::kWindowUs + 200);
+}
+
+TEST("SpinUntil returns no earlier than the deadline") {
+    int64_t due = HostMicros() + 2000;
+    SpinUntil(due);
+    int64_t now = HostMicros();
+    CHECK(now >= due);
+}
+
+TEST("32-bit device timestamps are extended across wraps") {
+    TimestampUnwrapper clock;
+    CHECK_EQ(clock.Extend(0xFFFFFF00u), uint64_t{0xFFFFFF00u});
+    CHECK_EQ(clock.Extend(0xFFFFFFF0u), uint64_t{0xFFFFFFF0u});
+    CHECK_EQ(clock.Extend(0x10), uint64_t{0x100000010});
+    CHECK_EQ(clock.Extend(0x7FFFFFFFu), uint64_t{0x17FFFFFFF});
+    CHECK_EQ(clock.Extend(0xF0000000u), uint64_t{0x1F0000000});
+    CHECK_EQ(clock.Extend(0x20), uint64_t{0x200000020});
+
+    // A frame read late is placed behind the newest one, before the wrap where it belongs.
+    CHECK_EQ(clock.Extend(0x18), uint64_t{0x200000018});
+    CHECK_EQ(clock.Extend(0xFFFFFFF8u), uint64_t{0x1FFFFFFF8});
+    CHECK_EQ(clock.Extend(0x30), uint64_t{0x200000030});
+
+    clock.Reset();
+    CHECK_EQ(clock.Extend(0x40), uint64_t{0x40});
+}
+
+TEST("a late frame before the first wrap is not placed before zero") {
+    TimestampUnwrapper clock;
+    CHECK_EQ(clock.Extend(0x10), uint64_t{0x10});
+    CHECK_EQ(clock.Extend(0xFFFFFFF0u), uint64_t{0xFFFFFFF0u});
+}
@@ -0,0 +1,305 @@
+#include "tunnel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+CanFrame Frame(uint32_t id, std::vector<uint8_t> data, uint64_t timestamp, uint8_t flags = 0) {
+    CanFrame frame = {};
+    frame.timestamp = timestamp;
+    frame.id = id;
+    frame.flags = flags;
+    frame.length = static_cast<uint8_t>(data.size());
+    std::memcpy(frame.data, data.data(), data.size());
+    return frame;
+}
+
+std::vector<uint8_t> Packet(uint8_t channel, uint32_t sequence, const std::vector<CanFrame>& frames) {
+    TunnelPacketWriter writer;
+    writer.Begin(channel, sequence, kTunnelMaxPacket);
+    for (const CanFrame& frame : frames) {
+        writer.Add(frame);
+    }
+    return writer.Finish();
+}
+
+// A port the loopback interface has free right now.
+uint16_t FreePort(bool tcp) {
+    TunnelAddress any;
+    TunnelSocket::Resolve("127.0.0.1", 0, any);
+    TunnelSocket probe;
+    if (!(tcp ? probe.Listen(any) : probe.OpenUdp(any)).empty()) {
+        return 0;
+    }
+    return probe.LocalPort();
+}
+
+// Reads what the link queued for `channel` within a second, up to `count` frames.
+std::vector<CanFrame> Collect(TunnelLink& link, uint8_t channel, size_t count) {
+    std::vector<CanFrame> frames;
+    CanFrame buffer[64];
+    for (int attempt = 0; attempt < 20 && frames.size() < count; ++attempt) {
+        if (link.Wait(channel, 50)) {
+            size_t read = link.Read(channel, buffer, 64);
+            frames.insert(frames.end(), buffer, buffer + read);
+        }
+    }
+    return frames;
+}
+
+} // namespace
+
+TEST("packets round-trip frames with their timestamps") {
+    std::vector<CanFrame> frames = {
+        Frame(0x123, {1, 2, 3}, 5000000),
+        Frame(0x18FF00FA, {}, 5000250, kFrameFlagExtended | kFrameFlagRemote),
+        Frame(0x7E8, {}, 4999000), // earlier than the first: a negative delta
+        Frame(0x100, std::vector<uint8_t>(64, 0x5A), 5100000, kFrameFlagFd | kFrameFlagBrs),
+    };
+    std::vector<uint8_t> packet = Packet(7, 0xDEADBEEF, frames);
+    CHECK_EQ(packet.size(), kTunnelHeaderSize + 4 * kTunnelFrameHeaderSize + 3 + 64);
+    CHECK_EQ(packet[0], kTunnelVersion);
+
+    TunnelPacketInfo info;
+    std::vector<CanFrame> decoded = {Frame(1, {}, 0)}; // appended to
+    CHECK_EQ(DecodeTunnelPacket(packet.data(), packet.size(), info, decoded), std::string());
+    CHECK_EQ(info.channel, uint8_t{7});
+    CHECK_EQ(info.sequence, uint32_t{0xDEADBEEF});
+    CHECK_EQ(info.count, uint16_t{4});
+    CHECK_EQ(decoded.size(), size_t{5});
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const CanFrame& frame = decoded[i + 1];
+        CHECK_EQ(frame.timestamp, frames[i].timestamp);
+        CHECK_EQ(frame.id, frames[i].id);
+        CHECK_EQ(frame.flags, frames[i].flags);
+        CHECK_EQ(frame.length, frames[i].length);
+        CHECK_EQ(frame.channel, uint8_t{7});
+        CHECK(std::memcmp(frame.data, frames[i].data, frame.length) == 0);
+    }
+}
+
+TEST("the writer stops at the packet capacity") {
+    TunnelPacketWriter writer;
+    size_t capacity = kTunnelHeaderSize + 3 * (kTunnelFrameHeaderSize + 64);
+    writer.Begin(0, 1, capacity);
+    CanFrame fd = Frame(0x200, std::vector<uint8_t>(64, 1), 0, kFrameFlagFd);
+    CHECK(writer.Add(fd));
+    CHECK(writer.Add(fd));
+    CHECK(writer.Add(fd));
+    CHECK(!writer.Add(Frame(0x201, {}, 0)));
+    CHECK_EQ(writer.Count(), size_t{3});
+    CHECK_EQ(writer.Finish().size(), capacity);
+
+    // Begin() starts a fresh packet in the same buffer.
+    writer.Begin(1, 2, 0); // raised to the room for one full frame
+    CHECK(writer.Add(fd));
+    CHECK(!writer.Add(Frame(0x201, {}, 0)));
+    CHECK_EQ(writer.Finish().size(), kTunnelHeaderSize + kTunnelFrameHeaderSize + 64);
+}
+
+TEST("malformed packets decode to nothing") {
+    std::vector<uint8_t> packet = Packet(0, 0, {Frame(0x1, {1, 2}, 0), Frame(0x2, {3, 4, 5, 6}, 0)});
+    TunnelPacketInfo info;
+    std::vector<CanFrame> out;
+    CHECK_EQ(DecodeTunnelPacket(packet.data(), kTunnelHeaderSize - 1, info, out),
+             std::string("Tunnel packet shorter than its header"));
+    CHECK_EQ(DecodeTunnelPacket(packet.data(), packet.size() - 1, info, out), std::string("Truncated tunnel packet"));
+    CHECK(out.empty());
+
+    std::vector<uint8_t> oversized = packet;
+    oversized[kTunnelHeaderSize + 9] = 65;
+    CHECK_EQ(DecodeTunnelPacket(oversized.data(), oversized.size(), info, out), std::string("Truncated tunnel packet"));
+
+    std::vector<uint8_t> future = packet;
+    future[0] = 2;
+    CHECK_EQ(DecodeTunnelPacket(future.data(), future.size(), info, out),
+             std::string("Unsupported tunnel packet version 2"));
+    CHECK(out.empty());
+}
+
+TEST("sequence gaps count as lost and stragglers as late") {
+    TunnelSequence sequence;
+    CHECK(sequence.Accept(100)); // the first packet sets the baseline
+    CHECK(!sequence.Accept(99)); // before the baseline: late, never lost
+    CHECK_EQ(sequence.lost, uint64_t{0});
+    CHECK(sequence.Accept(101));
+    CHECK(sequence.Accept(105));
+    CHECK_EQ(sequence.lost, uint64_t{3});
+    CHECK(!sequence.Accept(103)); // arrived after 105, so it was not lost after all
+    CHECK_EQ(sequence.lost, uint64_t{2});
+    CHECK(!sequence.Accept(105)); // duplicates are late but fill nothing
+    CHECK(!sequence.Accept(103));
+    CHECK_EQ(sequence.late, uint64_t{4});
+    CHECK_EQ(sequence.lost, uint64_t{2});
+
+    // Only the last 64 sequence numbers are remembered; older stragglers stay lost.
+    CHECK(sequence.Accept(300));
+    CHECK_EQ(sequence.lost, uint64_t{196});
+    CHECK(!sequence.Accept(299));
+    CHECK(!sequence.Accept(200));
+    CHECK_EQ(sequence.lost, uint64_t{195});
+    CHECK(sequence.Accept(302));
+    CHECK(!sequence.Accept(301));
+    CHECK(!sequence.Accept(298));
+    CHECK_EQ(sequence.lost, uint64_t{194});
+
+    // The counter wraps without a gap.
+    TunnelSequence wrapping;
+    CHECK(wrapping.Accept(0xFFFFFFFE));
+    CHECK(wrapping.Accept(0xFFFFFFFF));
+    CHECK(wrapping.Accept(0));
+    CHECK(wrapping.Accept(2));
+    CHECK_EQ(wrapping.lost, uint64_t{1});
+    CHECK_EQ(wrapping.late, uint64_t{0});
+
+    // Far behind means the sender restarted; neither late nor lost.
+    TunnelSequence restarted;
+    CHECK(restarted.Accept(50000));
+    CHECK(restarted.Accept(0));
+    CHECK(restarted.Accept(1));
+    CHECK_EQ(restarted.lost, uint64_t{0});
+    CHECK_EQ(restarted.late, uint64_t{0});
+    CHECK(!restarted.Accept(static_cast<uint32_t>(2 - kTunnelRestartWindow))); // just inside the window
+    CHECK_EQ(restarted.late, uint64_t{1});
+}
+
+TEST("a TCP byte stream splits into length-prefixed packets") {
+    std::vector<uint8_t> bytes;
+    for (uint16_t size : {3, 0, 300}) {
+        bytes.push_back(static_cast<uint8_t>(size >> 8));
+        bytes.push_back(static_cast<uint8_t>(size));
+        for (uint16_t i = 0; i < size; ++i) {
+            bytes.push_back(static_cast<uint8_t>(size + i));
+        }
+    }
+    // Delivered a few bytes at a time, as segments may arrive.
+    TunnelStream stream;
+    std::vector<std::vector<uint8_t>> packets;
+    std::vector<uint8_t> packet;
+    for (size_t offset = 0; offset < bytes.size(); offset += 7) {
+        stream.Append(bytes.data() + offset, std::min<size_t>(7, bytes.size() - offset));
+        while (stream.Next(packet)) {
+            packets.push_back(packet);
+        }
+    }
+    CHECK_EQ(packets.size(), size_t{3});
+    CHECK(packets[0] == std::vector<uint8_t>({3, 4, 5}));
+    CHECK(packets[1].empty());
+    CHECK_EQ(packets[2].size(), size_t{300});
+    CHECK_EQ(packets[2][299], static_cast<uint8_t>(300 + 299));
+    CHECK(!stream.Next(packet));
+}
+
+TEST("a UDP link queues frames per channel, accounts for loss and answers the peer") {
+    uint16_t port = FreePort(false);
+    std::string error;
+    std::shared_ptr<TunnelLink> link = TunnelLink::Acquire(false, "127.0.0.1", port, error);
+    CHECK_EQ(error, std::string());
+    if (!link) {
+        return;
+    }
+    CHECK(TunnelLink::Acquire(false, "127.0.0.1", port, error) == link); // shared by every bus on the port
+    CHECK(TunnelLink::Acquire(false, "0.0.0.0", port, error) == nullptr);
+    CHECK(!error.empty());
+    CHECK_EQ(link->Attach(3), std::string());
+    CHECK(!link->Attach(3).empty());
+    CHECK(!link->Send(3, Frame(0x10, {}, 0)).empty()); // no peer yet
+
+    TunnelAddress to;
+    CHECK_EQ(TunnelSocket::Resolve("127.0.0.1", port, to), std::string());
+    TunnelSocket peer;
+    CHECK_EQ(peer.OpenUdpFor(to), std::string());
+    for (uint32_t sequence : {10u, 11u, 14u, 12u}) {
+        std::vector<uint8_t> packet = Packet(3, sequence, {Frame(0x100 + sequence, {1}, sequence)});
+        CHECK(peer.SendTo(packet.data(), packet.size(), to));
+    }
+    std::vector<uint8_t> other = Packet(4, 0, {Frame(0x400, {}, 0)}); // nobody attached
+    CHECK(peer.SendTo(other.data(), other.size(), to));
+
+    std::vector<CanFrame> frames = Collect(*link, 3, 3);
+    CHECK_EQ(frames.size(), size_t{3});
+    if (frames.size() == 3) {
+        CHECK_EQ(frames[2].id, uint32_t{0x10E});
+        CHECK_EQ(frames[2].channel, uint8_t{3});
+    }
+    CHECK(!link->Wait(3, 50)); // the late packet was dropped
+    TunnelLink::Stats stats = link->GetStats(3);
+    CHECK(stats.connected);
+    CHECK_EQ(stats.packets, uint64_t{3});
+    CHECK_EQ(stats.frames, uint64_t{3});
+    CHECK_EQ(stats.lost, uint64_t{1}); // 13; 12 came late
+    CHECK_EQ(stats.late, uint64_t{1});
+
+    // Frames sent on the channel go back to the peer that last sent on it.
+    CHECK_EQ(link->Send(3, Frame(0x7E0, {2, 0x3E, 0}, 0)), std::string());
+    uint8_t buffer[256];
+    TunnelAddress from;
+    int received = peer.ReceiveFrom(buffer, sizeof(buffer), from, 1000);
+    CHECK(received > 0);
+    TunnelPacketInfo info;
+    std::vector<CanFrame> reply;
+    CHECK_EQ(DecodeTunnelPacket(buffer, static_cast<size_t>(received > 0 ? received : 0), info, reply), std::string());
+    CHECK_EQ(info.channel, uint8_t{3});
+    CHECK_EQ(info.sequence, uint32_t{0});
+    CHECK(reply.size() == 1 && reply[0].id == 0x7E0);
+    CHECK_EQ(link->GetStats(3).sent, uint64_t{1});
+    link->Detach(3);
+}
+
+TEST("a TCP link reassembles packets from the stream") {
+    uint16_t port = FreePort(true);
+    std::string error;
+    std::shared_ptr<TunnelLink> link = TunnelLink::Acquire(true, "127.0.0.1", port, error);
+    CHECK_EQ(error, std::string());
+    if (!link) {
+        return;
+    }
+    CHECK_EQ(link->Attach(0), std::string());
+    TunnelAddress to;
+    CHECK_EQ(TunnelSocket::Resolve("127.0.0.1", port, to), std::string());
+    TunnelSocket peer;
+    CHECK_EQ(peer.Connect(to, 1000), std::string());
+
+    std::vector<uint8_t> bytes;
+    for (uint32_t sequence = 0; sequence < 3; ++sequence) {
+        std::vector<uint8_t> packet = Packet(0, sequence, {Frame(sequence, {1, 2}, 0), Frame(sequence + 8, {}, 0)});
+        bytes.push_back(static_cast<uint8_t>(packet.size() >> 8));
+        bytes.push_back(static_cast<uint8_t>(packet.size()));
+        bytes.insert(bytes.end(), packet.begin(), packet.end());
+    }
+    // Split mid-header so the receiver sees partial packets.
+    CHECK(peer.SendAll(bytes.data(), 5));
+    CHECK(peer.SendAll(bytes.data() + 5, bytes.size() - 5));
+
+    std::vector<CanFrame> frames = Collect(*link, 0, 6);
+    CHECK_EQ(frames.size(), size_t{6});
+    CHECK_EQ(link->GetStats(0).packets, uint64_t{3});
+    CHECK_EQ(link->GetStats(0).lost, uint64_t{0});
+
+    CHECK_EQ(link->Send(0, Frame(0x55, {9}, 0)), std::string());
+    uint8_t buffer[256];
+    int received = peer.Receive(buffer, sizeof(buffer), 1000);
+    CHECK(received >= 2);
+    TunnelStream stream;
+    stream.Append(buffer, static_cast<size_t>(received > 0 ? received : 0));
+    std::vector<uint8_t> packet;
+    CHECK(stream.Next(packet));
+    TunnelPacketInfo info;
+    std::vector<CanFrame> reply;
+    CHECK_EQ(DecodeTunnelPacket(packet.data(), packet.size(), info, reply), std::string());
+    CHECK(reply.size() == 1 && reply[0].id == 0x55);
+
+    // Once the peer hangs up there is nobody to answer until it reconnects.
+    peer.Close();
+    for (int attempt = 0; attempt < 20 && link->GetStats(0).connected; ++attempt) {
+        link->Wait(0, 50);
+    }
+    CHECK(!link->GetStats(0).connected);
+    CHECK_EQ(link->Send(0, Frame(0x55, {9}, 0)), std::string("No tunnel peer on channel 0 yet"));
+    link->Detach(0);
+}
@@ -0,0 +1,88 @@
+#include "tx_shaper.h"
+
+#include <chrono>
+
+#include "check.h"
+
+namespace {
+
+using Clock = TokenBucket::Clock;
+using std::chrono::microseconds;
+
+CanFrame Frame(uint32_t id, uint8_t length, uint8_t flags = 0) {
+    CanFrame frame{};
+    frame.id = id;
+    frame.length = length;
+    frame.flags = flags;
+    return frame;
+}
+
+// Within a microsecond of `expectedUs`; delays come from floating-point token counts.
+bool Near(Clock::duration duration, int64_t expectedUs) {
+    int64_t us = std::chrono::duration_cast<microseconds>(duration).count();
+    return us >= expectedUs - 1 && us <= expectedUs + 1;
+}
+
+} // namespace
+
+TEST("worst-case frame lengths include stuff bits") {
+    CHECK_EQ(FrameBitLength(Frame(0x100, 0)), 47u + 33u / 4);
+    CHECK_EQ(FrameBitLength(Frame(0x100, 8)), 47u + 64 + 97u / 4);
+    CHECK_EQ(FrameBitLength(Frame(0x100, 8, kFrameFlagExtended)), kMaxClassicFrameBits);
+    CHECK_EQ(DefaultBurstBits(100000, 0), 1000.0);
+    CHECK_EQ(DefaultBurstBits(1000, 0), static_cast<double>(kMaxClassicFrameBits));
+    CHECK_EQ(DefaultBurstBits(100000, 5000), 5000.0);
+}
+
+TEST("frame intervals budget worst-case frames and need a bitrate") {
+    // 160 bits at 30 % of 500 kbit/s: one frame every 1.0667 ms.
+    CHECK_EQ(FrameIntervalNs(0.3, 500000), int64_t{1066666});
+    CHECK_EQ(FrameIntervalNs(1.0, 1000000), int64_t{kMaxClassicFrameBits} * 1000);
+    // Tunnel channels report no bitrate; there is nothing to divide.
+    CHECK_EQ(FrameIntervalNs(0.3, 0), int64_t{0});
+    CHECK_EQ(FrameIntervalNs(0.3, -1), int64_t{0});
+    CHECK_EQ(FrameIntervalNs(0, 500000), int64_t{0});
+}
+
+TEST("token bucket spends its burst and then paces at the rate") {
+    TokenBucket bucket(10000, 400); // 10 kbit/s, 400 bits deep
+    Clock::time_point now = Clock::now();
+    CHECK(bucket.Delay(300, now) == Clock::duration::zero());
+    bucket.Consume(300);
+    // 100 bits left; 300 more take 20 ms to refill.
+    CHECK(Near(bucket.Delay(300, now), 20000));
+    CHECK(Near(bucket.Delay(300, now + std::chrono::milliseconds(15)), 5000));
+    CHECK(bucket.Delay(300, now + std::chrono::milliseconds(20)) == Clock::duration::zero());
+    // Refill stops at the capacity however long the bucket idles.
+    bucket.Consume(300);
+    CHECK(Near(bucket.Delay(401, now + std::chrono::seconds(10)), 100));
+}
+
+TEST("unlimited bucket never delays") {
+    TokenBucket bucket;
+    CHECK(!bucket.Limited());
+    bucket.Consume(1e9);
+    CHECK(bucket.Delay(1e9, Clock::now()) == Clock::duration::zero());
+    CHECK(!TxShaper().Enabled());
+}
+
+TEST("shaper admits a frame only when the bus and its ID class both have tokens") {
+    CanFrame diagnostic = Frame(0x7E0, 8);
+    CanFrame other = Frame(0x100, 8);
+    double bits = FrameBitLength(diagnostic);
+    std::vector<TxShaper::IdClass> classes(1);
+    classes[0].mask = 0x700;
+    classes[0].match = 0x700;
+    classes[0].bucket = TokenBucket(bits * 10, bits); // one frame deep
+    TxShaper shaper(TokenBucket(bits * 1000, bits * 3), std::move(classes));
+    CHECK(shaper.Enabled());
+
+    Clock::time_point now = Clock::now();
+    CHECK(shaper.Admit(diagnostic, now) == Clock::duration::zero());
+    // The class bucket is empty: 100 ms at ten frames per second.
+    CHECK(Near(shaper.Admit(diagnostic, now), 100000));
+    // A refused frame takes no tokens, so other IDs still get the remaining bus budget.
+    CHECK(shaper.Admit(other, now) == Clock::duration::zero());
+    CHECK(shaper.Admit(other, now) == Clock::duration::zero());
+    CHECK(shaper.Admit(other, now) > Clock::duration::zero());
+}
@@ -0,0 +1,235 @@
+#include "uds_session.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "loopback_bus.h"
+
+namespace {
+
+constexpr uint32_t kTesterId = 0x7E0;
+constexpr uint32_t kEcuId = 0x7E8;
+
+// Injects frames after a delay from a thread of its own, as a slow ECU would answer.
+class DelayedReplies {
+public:
+    explicit DelayedReplies(LoopbackBus& bus) : bus_(bus), thread_([this](std::stop_token stop) { Run(stop); }) {}
+
+    void Add(int64_t delayUs, const CanFrame& frame) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            due_.emplace(HostMicros() + delayUs, frame);
+        }
+        cv_.notify_one();
+    }
+
+private:
+    void Run(std::stop_token stop) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop.stop_requested()) {
+            if (due_.empty()) {
+                cv_.wait(lock, stop, [this]() { return !due_.empty(); });
+                continue;
+            }
+            auto next = due_.begin();
+            if (next->first > HostMicros()) {
+                cv_.wait_for(lock, stop, std::chrono::microseconds(next->first - HostMicros()), []() { return false; });
+                continue;
+            }
+            CanFrame frame = next->second;
+            due_.erase(next);
+            bus_.Inject(frame);
+        }
+    }
+
+    LoopbackBus& bus_;
+    std::mutex mutex_;
+    std::condition_variable_any cv_;
+    std::multimap<int64_t, CanFrame> due_;
+    std::jthread thread_; // last: joined before the queue goes away
+};
+
+// A single-frame ISO-TP message.
+CanFrame Single(uint32_t id, std::vector<uint8_t> payload) {
+    payload.insert(payload.begin(), static_cast<uint8_t>(payload.size()));
+    return Frame(id, payload);
+}
+
+SessionTask RequestSession(SessionScheduler& scheduler, UdsTiming timing, uint32_t txId, uint32_t rxId,
+                           std::vector<uint8_t> request, std::promise<UdsResponse>* done) {
+    done->set_value(co_await UdsRequest(scheduler, IsoTpConfig(), timing, txId, rxId, std::move(request)));
+}
+
+UdsResponse Request(SessionScheduler& scheduler, const UdsTiming& timing, std::vector<uint8_t> request) {
+    std::promise<UdsResponse> done;
+    std::future<UdsResponse> result = done.get_future();
+    scheduler.Spawn([&]() { return RequestSession(scheduler, timing, kTesterId, kEcuId, request, &done); });
+    if (result.wait_for(std::chrono::seconds(5)) != std::future_status::ready) {
+        UdsResponse stuck;
+        stuck.error = "test: no result";
+        return stuck;
+    }
+    return result.get();
+}
+
+UdsTiming Timing(int64_t p2Ms, int64_t p2StarMs) {
+    UdsTiming timing;
+    timing.p2_us = p2Ms * 1000;
+    timing.p2_star_us = p2StarMs * 1000;
+    return timing;
+}
+
+} // namespace
+
+TEST("a positive response completes the request") {
+    LoopbackBus bus;
+    SessionScheduler scheduler(&bus);
+    bus.respond = [&](const CanFrame&) { bus.Inject(Single(kEcuId, {0x62, 0xF1, 0x90, 'V', 'I', 'N'})); };
+    scheduler.Start();
+    UdsResponse response = Request(scheduler, UdsTiming(), {0x22, 0xF1, 0x90});
+    scheduler.Stop();
+    CHECK_EQ(response.error, std::string());
+    CHECK_EQ(response.nrc, uint8_t{0});
+    CHECK_EQ(response.pending, uint32_t{0});
+    CHECK(response.data == std::vector<uint8_t>({0x62, 0xF1, 0x90, 'V', 'I', 'N'}));
+    CHECK_EQ(bus.sent().size(), size_t{1});
+}
+
+TEST("a negative response carries its code") {
+    LoopbackBus bus;
+    SessionScheduler scheduler(&bus);
+    bus.respond = [&](const CanFrame&) { bus.Inject(Single(kEcuId, {0x7F, 0x22, 0x31})); };
+    scheduler.Start();
+    UdsResponse response = Request(scheduler, UdsTiming(), {0x22, 0xF1, 0x90});
+    scheduler.Stop();
+    CHECK_EQ(response.error, std::string());
+    CHECK_EQ(response.nrc, uint8_t{0x31});
+    CHECK(response.data == std::vector<uint8_t>({0x7F, 0x22, 0x31}));
+}
+
+TEST("answers to other services are skipped") {
+    LoopbackBus bus;
+    SessionScheduler scheduler(&bus);
+    bus.respond = [&](const CanFrame&) {
+        bus.Inject(Single(kEcuId, {0x50, 0x03, 0x00, 0x32, 0x01, 0xF4})); // late session control answer
+        bus.Inject(Single(kEcuId, {0x7F, 0x10, 0x22})); // and its negative sibling
+        bus.Inject(Single(kEcuId, {0x59, 0x02, 0xFF}));
+    };
+    scheduler.Start();
+    UdsResponse response = Request(scheduler, UdsTiming(), {0x19, 0x02, 0xFF});
+    scheduler.Stop();
+    CHECK_EQ(response.error, std::string());
+    CHECK(response.data == std::vector<uint8_t>({0x59, 0x02, 0xFF}));
+}
+
+TEST("no answer times out after P2") {
+    LoopbackBus bus;
+    SessionScheduler scheduler(&bus);
+    scheduler.Start();
+    int64_t started = HostMicros();
+    UdsResponse response = Request(scheduler, Timing(30, 1000), {0x22, 0xF1, 0x90});
+    int64_t elapsedUs = HostMicros() - started;
+    scheduler.Stop();
+    CHECK_EQ(response.error, std::string("ISO-TP response timeout"));
+    CHECK(elapsedUs >= 30000);
+    CHECK(elapsedUs < 1000000);
+}
+
+TEST("response pending extends the wait by P2*") {
+    LoopbackBus bus;
+    SessionScheduler scheduler(&bus);
+    DelayedReplies replies(bus);
+    // Pending at once, then twice more 60 ms apart, then the answer: well past P2, within P2* each.
+    bus.respond = [&](const CanFrame&) {
+        bus.Inject(Single(kEcuId, {0x7F, 0x31, 0x78}));
+        replies.Add(60000, Single(kEcuId, {0x7F, 0x31, 0x78}));
+        replies.Add(120000, Single(kEcuId, {0x7F, 0x31, 0x78}));
+        replies.Add(180000, Single(kEcuId, {0x71, 0x01, 0xFF, 0x00}));
+    };
+    scheduler.Start();
+    int64_t started = HostMicros();
+    UdsResponse response = Request(scheduler, Timing(20, 100), {0x31, 0x01, 0xFF, 0x00});
+    int64_t elapsedUs = HostMicros() - started;
+    scheduler.Stop();
+    CHECK_EQ(response.error, std::string());
+    CHECK_EQ(response.pending, uint32_t{3});
+    CHECK(response.data == std::vector<uint8_t>({0x71, 0x01, 0xFF, 0x00}));
+    CHECK(elapsedUs >= 180000);
+}
+
+TEST("response pending still times out after P2*") {
+    LoopbackBus bus;
+    SessionScheduler scheduler(&bus);
+    bus.respond = [&](const CanFrame&) { bus.Inject(Single(kEcuId, {0x7F, 0x2E, 0x78})); };
+    scheduler.Start();
+    int64_t started = HostMicros();
+    UdsResponse response = Request(scheduler, Timing(10, 50), {0x2E, 0xF1, 0x90, 0x00});
+    int64_t elapsedUs = HostMicros() - started;
+    scheduler.Stop();
+    CHECK_EQ(response.error, std::string("ISO-TP response timeout"));
+    CHECK_EQ(response.pending, uint32_t{1});
+    CHECK(elapsedUs >= 50000);
+}
+
+TEST("suppressed positive responses complete once sent") {
+    CHECK(UdsSuppressesPositiveResponse({0x3E, 0x80}));
+    CHECK(UdsSuppressesPositiveResponse({0x10, 0x83}));
+    CHECK(!UdsSuppressesPositiveResponse({0x3E, 0x00}));
+    CHECK(!UdsSuppressesPositiveResponse({0x22, 0xF1, 0x90})); // no sub-function
+    CHECK(!UdsSuppressesPositiveResponse({0x3E}));
+
+    LoopbackBus bus;
+    SessionScheduler scheduler(&bus);
+    scheduler.Start();
+    int64_t started = HostMicros();
+    UdsResponse response = Request(scheduler, Timing(500, 1000), {0x3E, 0x80});
+    int64_t elapsedUs = HostMicros() - started;
+    scheduler.Stop();
+    CHECK_EQ(response.error, std::string());
+    CHECK(response.data.empty());
+    CHECK(elapsedUs < 500000);
+    CHECK_EQ(bus.sent().size(), size_t{1});
+}
+
+TEST("requests to many ECUs overlap instead of queueing") {
+    constexpr int kEcus = 40;
+    constexpr int64_t kAnswerUs = 50000;
+    LoopbackBus bus;
+    SessionScheduler scheduler(&bus);
+    DelayedReplies replies(bus);
+    // ECU n listens on 0x600 + n and answers on 0x680 + n after kAnswerUs.
+    bus.respond = [&](const CanFrame& frame) {
+        replies.Add(kAnswerUs, Single(frame.id + 0x80, {0x62, 0xF1, 0x90, static_cast<uint8_t>(frame.id)}));
+    };
+    scheduler.Start();
+    std::vector<std::promise<UdsResponse>> done(kEcus);
+    std::vector<std::future<UdsResponse>> results;
+    int64_t started = HostMicros();
+    for (int i = 0; i < kEcus; ++i) {
+        results.push_back(done[i].get_future());
+        uint32_t txId = 0x600 + i;
+        scheduler.Spawn([&scheduler, &done, i, txId]() {
+            return RequestSession(scheduler, Timing(1000, 5000), txId, txId + 0x80, {0x22, 0xF1, 0x90}, &done[i]);
+        });
+    }
+    bool all = true;
+    for (std::future<UdsResponse>& result : results) {
+        all = all && result.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+    }
+    int64_t elapsedUs = HostMicros() - started;
+    scheduler.Stop();
+    CHECK(all);
+    for (int i = 0; i < kEcus; ++i) {
+        UdsResponse response = results[i].get();
+        CHECK_EQ(response.error, std::string());
+        CHECK_EQ(response.data[3], static_cast<uint8_t>(0x600 + i));
+    }
+    // Sequentially this would take kEcus * kAnswerUs = 2 s.
+    CHECK(elapsedUs < 10 * kAnswerUs);
+}
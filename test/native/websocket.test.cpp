@@ -0,0 +1,165 @@
+#include "websocket.h"
+
+#include <string>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+// A client frame: masked, as RFC 6455 requires of clients.
+std::vector<uint8_t> ClientFrame(uint8_t opcode, const std::vector<uint8_t>& payload, bool fin = true) {
+    const uint8_t mask[4] = {0x37, 0xFA, 0x21, 0x3D};
+    std::vector<uint8_t> frame = {static_cast<uint8_t>((fin ? 0x80 : 0) | opcode)};
+    if (payload.size() < 126) {
+        frame.push_back(static_cast<uint8_t>(0x80 | payload.size()));
+    } else if (payload.size() <= 0xFFFF) {
+        frame.push_back(0x80 | 126);
+        frame.push_back(static_cast<uint8_t>(payload.size() >> 8));
+        frame.push_back(static_cast<uint8_t>(payload.size()));
+    } else {
+        frame.push_back(0x80 | 127);
+        for (int i = 0; i < 8; ++i) {
+            frame.push_back(static_cast<uint8_t>(static_cast<uint64_t>(payload.size()) >> (56 - 8 * i)));
+        }
+    }
+    frame.insert(frame.end(), mask, mask + 4);
+    for (size_t i = 0; i < payload.size(); ++i) {
+        frame.push_back(payload[i] ^ mask[i & 3]);
+    }
+    return frame;
+}
+
+std::vector<uint8_t> Bytes(const std::string& text) {
+    return std::vector<uint8_t>(text.begin(), text.end());
+}
+
+void Append(WebSocketReader& reader, const std::vector<uint8_t>& bytes) {
+    reader.Append(bytes.data(), bytes.size());
+}
+
+} // namespace
+
+TEST("the handshake answers the RFC 6455 sample key") {
+    std::string response;
+    std::string error = WebSocketHandshake("GET /frames HTTP/1.1\r\n"
+                                           "Host: localhost\r\n"
+                                           "upgrade:  WebSocket \r\n"
+                                           "Connection: Upgrade\r\n"
+                                           "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                                           "Sec-WebSocket-Version: 13\r\n\r\n",
+                                           response);
+    CHECK_EQ(error, std::string());
+    CHECK_EQ(response, std::string("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                                   "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n\r\n"));
+}
+
+TEST("requests that are not upgrades are refused") {
+    std::string response;
+    CHECK_EQ(WebSocketHandshake("POST / HTTP/1.1\r\nUpgrade: websocket\r\nSec-WebSocket-Key: x\r\n\r\n", response),
+             std::string("Not a GET request"));
+    CHECK_EQ(WebSocketHandshake("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n", response),
+             std::string("Not a WebSocket upgrade"));
+    CHECK_EQ(WebSocketHandshake("GET / HTTP/1.1\r\nUpgrade: websocket\r\n\r\n", response),
+             std::string("Not a WebSocket upgrade"));
+    CHECK_EQ(WebSocketHandshake("GET / HTTP/1.1\r\nUpgrade: h2c\r\nSec-WebSocket-Key: x\r\n\r\n", response),
+             std::string("Not a WebSocket upgrade"));
+    CHECK(response.empty());
+}
+
+TEST("server headers use the shortest length encoding") {
+    uint8_t header[kWebSocketMaxHeader];
+    CHECK_EQ(WriteWebSocketHeader(header, kWebSocketBinary, 125), size_t{2});
+    CHECK_EQ(header[0], uint8_t{0x82});
+    CHECK_EQ(header[1], uint8_t{125});
+
+    CHECK_EQ(WriteWebSocketHeader(header, kWebSocketText, 126), size_t{4});
+    CHECK_EQ(header[0], uint8_t{0x81});
+    CHECK_EQ(header[1], uint8_t{126});
+    CHECK_EQ(header[2], uint8_t{0x00});
+    CHECK_EQ(header[3], uint8_t{126});
+
+    CHECK_EQ(WriteWebSocketHeader(header, kWebSocketBinary, 0xFFFF), size_t{4});
+    CHECK_EQ(header[2], uint8_t{0xFF});
+    CHECK_EQ(header[3], uint8_t{0xFF});
+
+    CHECK_EQ(WriteWebSocketHeader(header, kWebSocketBinary, 0x10000), size_t{10});
+    CHECK_EQ(header[1], uint8_t{127});
+    CHECK(std::vector<uint8_t>(header + 2, header + 10) == std::vector<uint8_t>({0, 0, 0, 0, 0, 1, 0, 0}));
+}
+
+TEST("the reader unmasks messages split across reads") {
+    WebSocketReader reader(1 << 20);
+    std::vector<uint8_t> stream = ClientFrame(kWebSocketText, Bytes("subscribe 0x7E8"));
+    std::vector<uint8_t> large(300, 0x5A);
+    std::vector<uint8_t> second = ClientFrame(kWebSocketBinary, large);
+    stream.insert(stream.end(), second.begin(), second.end());
+
+    WebSocketReader::Message message;
+    size_t fed = 0;
+    std::vector<WebSocketReader::Message> messages;
+    while (fed < stream.size()) {
+        reader.Append(&stream[fed], 1); // byte by byte: every partial header and payload
+        fed++;
+        int result;
+        while ((result = reader.Next(message)) == 1) {
+            messages.push_back(message);
+        }
+        CHECK_EQ(result, 0);
+    }
+    CHECK_EQ(messages.size(), size_t{2});
+    CHECK_EQ(messages[0].opcode, kWebSocketText);
+    CHECK(messages[0].payload == Bytes("subscribe 0x7E8"));
+    CHECK_EQ(messages[1].opcode, kWebSocketBinary);
+    CHECK(messages[1].payload == large);
+}
+
+TEST("fragments are joined around interleaved control frames") {
+    WebSocketReader reader(64);
+    Append(reader, ClientFrame(kWebSocketText, Bytes("subscribe "), false));
+    Append(reader, ClientFrame(kWebSocketPing, Bytes("hi")));
+    Append(reader, ClientFrame(0, Bytes("0x100-"), false));
+    Append(reader, ClientFrame(0, Bytes("0x1FF")));
+
+    WebSocketReader::Message message;
+    CHECK_EQ(reader.Next(message), 1);
+    CHECK_EQ(message.opcode, kWebSocketPing);
+    CHECK(message.payload == Bytes("hi"));
+    CHECK_EQ(reader.Next(message), 1);
+    CHECK_EQ(message.opcode, kWebSocketText);
+    CHECK(message.payload == Bytes("subscribe 0x100-0x1FF"));
+    CHECK_EQ(reader.Next(message), 0);
+}
+
+TEST("protocol violations are reported") {
+    WebSocketReader::Message message;
+    struct Case {
+        const char* name;
+        std::vector<std::vector<uint8_t>> frames;
+    };
+    std::vector<uint8_t> unmasked = {0x81, 0x02, 'h', 'i'};
+    std::vector<Case> cases = {
+        {"unmasked", {unmasked}},
+        {"fragmented control frame", {ClientFrame(kWebSocketPing, {}, false)}},
+        {"continuation without a start", {ClientFrame(0, Bytes("x"))}},
+        {"new message inside a fragmented one", {ClientFrame(kWebSocketText, Bytes("a"), false),
+                                                 ClientFrame(kWebSocketText, Bytes("b"))}},
+        {"message over the limit", {ClientFrame(kWebSocketBinary, std::vector<uint8_t>(65))}},
+        {"fragments over the limit", {ClientFrame(kWebSocketBinary, std::vector<uint8_t>(40), false),
+                                      ClientFrame(0, std::vector<uint8_t>(40))}},
+    };
+    for (const Case& c : cases) {
+        WebSocketReader reader(64);
+        for (const std::vector<uint8_t>& frame : c.frames) {
+            Append(reader, frame);
+        }
+        if (reader.Next(message) != -1) {
+            check::Fail(__FILE__, __LINE__, std::string(c.name) + " was accepted");
+        }
+    }
+
+    // An oversized length is refused from the header alone, before its payload arrives.
+    WebSocketReader reader(64);
+    Append(reader, {0x82, 0x80 | 127, 0, 0, 0, 1, 0, 0, 0, 0});
+    CHECK_EQ(reader.Next(message), -1);
+}
@@ -0,0 +1,135 @@
+#include "wire_writers.h"
+
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+std::string Hex(const std::vector<uint8_t>& bytes) {
+    static const char* kDigits = "0123456789abcdef";
+    std::string out;
+    for (uint8_t byte : bytes) {
+        out.push_back(kDigits[byte >> 4]);
+        out.push_back(kDigits[byte & 0x0F]);
+    }
+    return out;
+}
+
+// What `write` puts into a buffer with room for `payload` bytes after the head.
+std::string Written(const std::function<uint8_t*(uint8_t*)>& write, size_t payload = 0) {
+    std::vector<uint8_t> buffer(kWireMaxHead + payload);
+    buffer.resize(static_cast<size_t>(write(buffer.data()) - buffer.data()));
+    return Hex(buffer);
+}
+
+} // namespace
+
+TEST("CBOR integers match RFC 8949 appendix A") {
+    struct Case {
+        int64_t value;
+        const char* hex;
+    };
+    std::vector<Case> cases = {
+        {0, "00"},
+        {23, "17"},
+        {24, "1818"},
+        {100, "1864"},
+        {1000, "1903e8"},
+        {1000000, "1a000f4240"},
+        {1000000000000, "1b000000e8d4a51000"},
+        {-1, "20"},
+        {-10, "29"},
+        {-100, "3863"},
+        {-1000, "3903e7"},
+        {std::numeric_limits<int64_t>::min(), "3b7fffffffffffffff"},
+    };
+    for (const Case& c : cases) {
+        CHECK_EQ(Written([&](uint8_t* p) { return CborWriter::Int(p, c.value); }), std::string(c.hex));
+    }
+    CHECK_EQ(Written([](uint8_t* p) { return CborWriter::Uint(p, 18446744073709551615u); }),
+             std::string("1bffffffffffffffff"));
+}
+
+TEST("CBOR strings, byte strings and containers carry their length") {
+    CHECK_EQ(Written([](uint8_t* p) { return CborWriter::Text(p, ""); }), std::string("60"));
+    CHECK_EQ(Written([](uint8_t* p) { return CborWriter::Text(p, "IETF"); }, 4), std::string("6449455446"));
+    CHECK_EQ(Written([](uint8_t* p) { return CborWriter::Text(p, std::string(24, 'a')); }, 24).substr(0, 4),
+             std::string("7818"));
+    const uint8_t bytes[] = {1, 2, 3, 4};
+    CHECK_EQ(Written([&](uint8_t* p) { return CborWriter::Bytes(p, bytes, 4); }, 4), std::string("4401020304"));
+    CHECK_EQ(Written([](uint8_t* p) { return CborWriter::Array(p, 3); }), std::string("83"));
+    CHECK_EQ(Written([](uint8_t* p) { return CborWriter::Array(p, 25); }), std::string("9819"));
+    CHECK_EQ(Written([](uint8_t* p) { return CborWriter::Map(p, 0); }), std::string("a0"));
+    CHECK_EQ(Written([](uint8_t* p) { return CborWriter::Map(p, 70000); }), std::string("ba00011170"));
+    CHECK_EQ(Written([](uint8_t* p) { return CborWriter::Double(p, 1.1); }), std::string("fb3ff199999999999a"));
+}
+
+TEST("MessagePack integers use the shortest form") {
+    struct Case {
+        int64_t value;
+        const char* hex;
+    };
+    std::vector<Case> cases = {
+        {0, "00"},
+        {127, "7f"},
+        {128, "cc80"},
+        {255, "ccff"},
+        {256, "cd0100"},
+        {65536, "ce00010000"},
+        {4294967296, "cf0000000100000000"},
+        {-1, "ff"},
+        {-32, "e0"},
+        {-33, "d0df"},
+        {-128, "d080"},
+        {-129, "d1ff7f"},
+        {-32768, "d18000"},
+        {-32769, "d2ffff7fff"},
+        {-2147483648LL, "d280000000"},
+        {-2147483649LL, "d3ffffffff7fffffff"},
+    };
+    for (const Case& c : cases) {
+        CHECK_EQ(Written([&](uint8_t* p) { return MsgPackWriter::Int(p, c.value); }), std::string(c.hex));
+    }
+}
+
+TEST("MessagePack strings and containers switch form at the spec limits") {
+    auto text = [](size_t size) {
+        return Written([size](uint8_t* p) { return MsgPackWriter::Text(p, std::string(size, 'x')); }, size);
+    };
+    CHECK_EQ(text(0), std::string("a0"));
+    CHECK_EQ(text(31).substr(0, 2), std::string("bf"));
+    CHECK_EQ(text(32).substr(0, 4), std::string("d920"));
+    CHECK_EQ(text(255).substr(0, 4), std::string("d9ff"));
+    CHECK_EQ(text(256).substr(0, 6), std::string("da0100"));
+    CHECK_EQ(text(65536).substr(0, 10), std::string("db00010000"));
+    CHECK_EQ(text(65536).size(), size_t{2 * (5 + 65536)});
+
+    CHECK_EQ(Written([](uint8_t* p) { return MsgPackWriter::Array(p, 15); }), std::string("9f"));
+    CHECK_EQ(Written([](uint8_t* p) { return MsgPackWriter::Array(p, 16); }), std::string("dc0010"));
+    CHECK_EQ(Written([](uint8_t* p) { return MsgPackWriter::Array(p, 65536); }), std::string("dd00010000"));
+    CHECK_EQ(Written([](uint8_t* p) { return MsgPackWriter::Map(p, 5); }), std::string("85"));
+    CHECK_EQ(Written([](uint8_t* p) { return MsgPackWriter::Map(p, 16); }), std::string("de0010"));
+    const uint8_t data[] = {0x02, 0x7E, 0x00};
+    CHECK_EQ(Written([&](uint8_t* p) { return MsgPackWriter::Bytes(p, data, 3); }, 3), std::string("c403027e00"));
+    CHECK_EQ(Written([](uint8_t* p) { return MsgPackWriter::Double(p, 1.1); }), std::string("cb3ff199999999999a"));
+}
+
+TEST("numbers are integers exactly when they are integral and exact") {
+    auto msgpack = [](double value) {
+        return Written([value](uint8_t* p) { return PutWireNumber<MsgPackWriter>(p, value); });
+    };
+    auto cbor = [](double value) { return Written([value](uint8_t* p) { return PutWireNumber<CborWriter>(p, value); }); };
+    CHECK_EQ(msgpack(3.0), std::string("03"));
+    CHECK_EQ(cbor(-250.0), std::string("38f9"));
+    CHECK_EQ(msgpack(-0.0), std::string("00"));
+    CHECK_EQ(cbor(9007199254740992.0), std::string("1b0020000000000000"));
+    CHECK_EQ(cbor(-9007199254740992.0), std::string("3b001fffffffffffff"));
+    CHECK_EQ(cbor(9007199254740994.0), std::string("fb4340000000000001"));
+    CHECK_EQ(msgpack(2.5), std::string("cb4004000000000000"));
+    CHECK_EQ(cbor(std::numeric_limits<double>::quiet_NaN()).substr(0, 2), std::string("fb"));
+    CHECK_EQ(cbor(std::numeric_limits<double>::infinity()), std::string("fb7ff0000000000000"));
+}